@@ -31,9 +31,15 @@
  *    xpc_errprint()] with a "log" macro of similar name [e.g.
  *    log_errprint()].
  *
+ *    Finally, it provides the xpc::errorlog_t<> template, a front end that
+ *    removes the calls below a compile-time level entirely, for verbose
+ *    instrumentation that must cost nothing in release builds.
+ *
  *//*-------------------------------------------------------------------------*/
 
+#include <cstddef>                     /* std::nullptr_t                      */
 #include <string>                      /* class std::string                   */
+#include <type_traits>                 /* std::is_arithmetic<> and others     */
 #include <xpc/errorlogging.h>          /* C::errorlogging functions           */
 #include <xpc/syncher.h>               /* xpc_syncher_t structure             */
 XPC_REVISION_DECL(errorlog)            /* extern void show_errorlog_info()    */
@@ -133,9 +139,52 @@ XPC_REVISION_DECL(errorlog)            /* extern void show_errorlog_info()    */
 
 #endif   // XPC_NO_ERRORLOG
 
+/******************************************************************************
+ * logt_errprintf family of macros
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides macros for the printf()-style functions of the
+ *    xpc::errorlog_t<> template, which is described below.
+ *
+ *    These macros add two things that a plain function call cannot
+ *    provide:
+ *
+ *       -# The format string and the arguments are checked by the compiler
+ *          (GNU C++ -Wformat), by passing them to
+ *          xpc::errorlog_format_check() in code that is never executed.
+ *       -# The arguments are not evaluated at all if the message is not to
+ *          be shown.  If the level is compiled out, the whole statement
+ *          is removed.
+ *
+ *    The first parameter is the xpc::errorlog_t<> object, and the rest are
+ *    the format and its arguments.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define logt_printf_helper(log, show, func, ...)                             \
+   do                                                                        \
+   {                                                                         \
+      if (false)                                                             \
+         xpc::errorlog_format_check(__VA_ARGS__);                            \
+                                                                             \
+      if ((log).show())                                                      \
+         (log).func(__VA_ARGS__);                                            \
+   } while (0)
+
+#define logt_errprintf(log, ...)   \
+   logt_printf_helper(log, showerrors, errprintf, __VA_ARGS__)
+#define logt_warnprintf(log, ...)  \
+   logt_printf_helper(log, showwarnings, warnprintf, __VA_ARGS__)
+#define logt_infoprintf(log, ...)  \
+   logt_printf_helper(log, showinfo, infoprintf, __VA_ARGS__)
+#define logt_dbginfoprintf(log, ...) \
+   logt_printf_helper(log, showdebug, dbginfoprintf, __VA_ARGS__)
+
 namespace xpc
 {
 
+class logstream;
+
 /******************************************************************************
  * class errorlog
  *------------------------------------------------------------------------*//**
@@ -160,7 +209,7 @@ private:                               /* static members    */
 
    /**
     *    Provides a critical section for synchronizing output for all instances
-    *    or xpc::errorlog.
+    *    or xpc::errorlog that call synchshared(true).
     *
     *    These functions manage the process-global critical sections used for
     *    speeding up the creation of the threads in an application.
@@ -192,6 +241,12 @@ private:                               /* static members    */
 
    static bool gm_critex_atexit_set;
 
+   /**
+    *    The logstream class hands its finished lines to msgtag().
+    */
+
+   friend class logstream;
+
 private:                               /* non-static members   */
 
    /**
@@ -200,8 +255,9 @@ private:                               /* non-static members   */
     *    It is controlled by the --synch and --no-synch options from the
     *    command-line.
     *
-    *    If set to 'true', the gm_critex structrue is set up and used to help
-    *    keep the text output from different threads from being intermingled.
+    *    If set to 'true', m_critex (or gm_critex, see m_critex_shared) is
+    *    used to help keep the text output from different threads from being
+    *    intermingled.
     *    But please note that it can affect the detectability of threading
     *    problems.
     *
@@ -211,6 +267,31 @@ private:                               /* non-static members   */
 
    bool m_critex_usage;
 
+   /**
+    *    Provides this object's own critical section for --synch.
+    *
+    *    Each object locks only its own sink, so that objects logging to
+    *    different files do not contend for one lock.  It is mutable because
+    *    the logging functions are const.
+    */
+
+   mutable xpc_syncher_t m_critex;
+
+   /**
+    *    Indicates that m_critex was created, and must be destroyed.
+    */
+
+   bool m_critex_inited;
+
+   /**
+    *    If 'true', the process-global gm_critex is used instead of
+    *    m_critex.  This is the old behavior, needed only if several objects
+    *    write to the same stream, and must not intermix their lines.  See
+    *    synchshared().
+    */
+
+   bool m_critex_shared;
+
    /**
     *    This variable maintains the current error level value.  By
     *    default, the value is XPC_ERROR_LEVEL_ERRORS.
@@ -222,10 +303,11 @@ private:                               /* non-static members   */
     *    This variable maintains the pointer to the current log file.
     *
     *    By default, this variable is set to stderr when the object is
-    *    constructed.
+    *    constructed.  It is mutable because the log file can be rotated in
+    *    the middle of a (const) logging call.
     */
 
-   FILE * m_log_file;
+   mutable FILE * m_log_file;
 
    /**
     *    Provides a flag to enable the inclusion of microsecond-level time
@@ -257,12 +339,55 @@ private:                               /* non-static members   */
 
    bool m_use_color;
 
+   /**
+    *    The name of the log file, if it was opened by open_logfile() or
+    *    append_logfile().  Only a named log file can be rotated.
+    */
+
+   std::string m_log_name;
+
+   /**
+    *    The log-rotation settings.  See rotation().  A zero size or age
+    *    disables the rotation by size or age.
+    */
+
+   size_t m_rotate_max_bytes;
+   long m_rotate_max_age;
+   int m_rotate_keep;
+
+   /**
+    *    The number of bytes in the log file, and the time it was opened.
+    *    These are updated by the (const) logging functions.
+    */
+
+   mutable size_t m_log_bytes;
+   mutable time_t m_log_opened;
+
+   /**
+    *    Set while one thread rotates the log file, so that the other
+    *    threads do not also try to rotate it.
+    */
+
+   mutable int m_log_rotating;
+
 public:
 
    errorlog ();
    errorlog (int argc, char * argv []);
+   ~errorlog ();
 
    bool synchusage (bool flag);
+   bool synchshared (bool flag);
+
+   /**
+    *    Tells if the process-global critex is used, instead of this object's
+    *    own critex.  See synchshared(bool).
+    */
+
+   bool synchshared () const
+   {
+      return m_critex_shared;
+   }
 
    /**
     *
@@ -288,8 +413,29 @@ public:
 
    bool logfile (FILE * logfilehandle);
    bool open_logfile (const std::string & logfilename);
+   bool open_logfile
+   (
+      const std::string & logfilename,
+      size_t maxbytes,
+      long maxage = 0,
+      int keep = XPC_LOG_KEEP_DEFAULT
+   );
    bool append_logfile (const std::string & logfilename);
+   bool append_logfile
+   (
+      const std::string & logfilename,
+      size_t maxbytes,
+      long maxage = 0,
+      int keep = XPC_LOG_KEEP_DEFAULT
+   );
    bool close_logfile ();
+   bool rotation
+   (
+      size_t maxbytes,
+      long maxage = 0,
+      int keep = XPC_LOG_KEEP_DEFAULT
+   );
+   bool rotate_logfile ();
 
    /**
     *    Provides the handle to the error-log file.
@@ -568,12 +714,26 @@ public:
    bool syslogging () const;
 
 #ifdef XPC_NO_ERRORLOG
+   void errprint (const char * ) const
+   {
+      /* do nothing */
+   }
    void errprint (const std::string & ) const
    {
       /* do nothing */
    }
 #else    //  XPC_NO_ERRORLOG
-   void errprint (const std::string & errmsg) const;
+   void errprint (const char * errmsg) const;
+
+   /**
+    *    Logs an error message held in a std::string.  The const char *
+    *    overload avoids building a std::string for a literal.
+    */
+
+   void errprint (const std::string & errmsg) const
+   {
+      errprint(errmsg.c_str());
+   }
 #endif   //  XPC_NO_ERRORLOG
 
    void errprintf (const std::string & fmt, ...) const;
@@ -582,7 +742,17 @@ public:
       const std::string & errmsg,
       const std::string & label
    ) const;
-   void warnprint (const std::string & warnmsg) const;
+   void warnprint (const char * warnmsg) const;
+
+   /**
+    *    Logs a warning message held in a std::string.
+    */
+
+   void warnprint (const std::string & warnmsg) const
+   {
+      warnprint(warnmsg.c_str());
+   }
+
    void warnprintf (const std::string & fmt, ...) const;
    void warnprintex
    (
@@ -590,7 +760,17 @@ public:
       const std::string & label
    ) const;
 
-   void infoprint (const std::string & infomsg) const;
+   void infoprint (const char * infomsg) const;
+
+   /**
+    *    Logs an informational message held in a std::string.
+    */
+
+   void infoprint (const std::string & infomsg) const
+   {
+      infoprint(infomsg.c_str());
+   }
+
    void infoprintf (const std::string & fmt, ...) const;
    void infoprintml (const std::string & fmt, ...) const;
    void infoprintex
@@ -650,6 +830,15 @@ public:
 
    void flush_error_log () const;
 
+   /*
+    * Stream-style logging; see class logstream.
+    */
+
+   logstream error () const;
+   logstream warn () const;
+   logstream info () const;
+   logstream debug () const;
+
    /**
     *    Provides a way to disable any kind of logging with no
     *    overhead.
@@ -678,11 +867,15 @@ private:
       const std::string & logfilename,
       bool truncateit
    );
+   void log_opened (FILE * logfilehandle, const std::string & logfilename);
+   bool log_rotate () const;
+   void log_written (int count) const;
+   bool rotation_option (const std::string & option, const char * value);
    void msgtag
    (
       xpc_errlevel_t errlev,
-      const std::string & tag,
-      const std::string & errmsg
+      const char * tag,
+      const char * errmsg
    ) const;
    void va_tag
    (
@@ -731,13 +924,136 @@ private:
 
 private:
 
+   /*
+    * Not copyable, because each object owns a critex.
+    */
+
+   errorlog (const errorlog &);
+   errorlog & operator = (const errorlog &);
+
    static xpc_syncher_t * synch_critex ();
    static void synch_critex_destroy ();
-   static bool synch_lock ();
-   static void synch_unlock ();
+   bool synch_lock () const;
+   void synch_unlock () const;
 
 };             /* class errorlog    */
 
+/******************************************************************************
+ * XPC_LOGSTREAM_SIZE
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the size of the per-thread buffers in which xpc::logstream
+ *    builds its lines, and the number of such buffers, which is how deeply
+ *    the building of lines can nest (e.g. an operator << that itself logs
+ *    a line).  Longer lines are truncated.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_LOGSTREAM_SIZE       512
+#define XPC_LOGSTREAM_DEPTH      4
+
+/******************************************************************************
+ * class logstream
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a stream-style front end to an xpc::errorlog object.
+ *
+ *    The object is created by errorlog::error(), warn(), info(), or
+ *    debug(), which check the error level first.  If the level is not
+ *    shown, the object is inactive, and the << operators do nothing at
+ *    all.  Otherwise, the values are written into a fixed buffer private
+ *    to the calling thread, and the finished line is handed to the
+ *    errorlog when the object is destroyed, at the end of the statement.
+ *    No std::string or std::ostringstream is created, and nothing is
+ *    allocated.
+ *
+\verbatim
+      xpc::mainlog().info() << "read " << count << " bytes from " << name;
+\endverbatim
+ *
+ *    Note that the operands are still evaluated when the level is not
+ *    shown.  An operand that is expensive to compute can be guarded by
+ *    testing active().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+class logstream
+{
+
+private:
+
+   /**
+    *    The object that writes the line, or null if the line is inactive.
+    */
+
+   const errorlog * m_log;
+
+   /**
+    *    The error level and tag of the line.
+    */
+
+   xpc_errlevel_t m_level;
+   const char * m_tag;
+
+   /**
+    *    The per-thread buffer in which the line is built, and the length of
+    *    the text in it.
+    */
+
+   char * m_text;
+   size_t m_length;
+
+   /**
+    *    The index of the per-thread buffer, which is freed when the line is
+    *    logged, or -1 if the line has none.
+    */
+
+   int m_slot;
+
+public:
+
+   logstream
+   (
+      const errorlog * log,
+      xpc_errlevel_t level,
+      const char * tag
+   );
+   logstream (logstream && source);
+   ~logstream ();
+
+   /**
+    *    Tells if the line will be logged.
+    */
+
+   bool active () const
+   {
+      return m_log != nullptr;
+   }
+
+   logstream & append (const char * text, size_t length);
+
+   logstream & operator << (const char * text);
+   logstream & operator << (const std::string & text);
+   logstream & operator << (char c);
+   logstream & operator << (bool flag);
+   logstream & operator << (int value);
+   logstream & operator << (unsigned value);
+   logstream & operator << (long value);
+   logstream & operator << (unsigned long value);
+   logstream & operator << (long long value);
+   logstream & operator << (unsigned long long value);
+   logstream & operator << (double value);
+   logstream & operator << (const void * pointer);
+
+private:
+
+   logstream (const logstream &);
+   logstream & operator = (const logstream &);
+
+   logstream & format (const char * fmt, ...);
+
+};             /* class logstream   */
+
 /******************************************************************************
  * errorlog()
  *------------------------------------------------------------------------*//**
@@ -749,6 +1065,433 @@ private:
 
 extern errorlog & mainlog ();
 
+/******************************************************************************
+ * errorlog_format_check()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a function that does nothing, but that GNU C++ checks like
+ *    printf().  It is called only in dead code by the logt_errprintf()
+ *    family of macros, so that the format string of each message is
+ *    checked at compile time.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+inline void errorlog_format_check (const char * fmt, ...)
+   xpc_printf_format(1, 2);
+
+inline void
+errorlog_format_check (const char * , ...)
+{
+   // do nothing
+}
+
+/******************************************************************************
+ * errorlog_printf_args
+ *------------------------------------------------------------------------*//**
+ *
+ *    A compile-time check that every argument of a printf()-style call can
+ *    be passed through "...".  Only numbers, enumerations, and pointers are
+ *    allowed; in particular, a std::string must be passed as c_str().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+template <typename... Args>
+struct errorlog_printf_args
+{
+   static const bool value = true;
+};
+
+template <typename T, typename... Rest>
+struct errorlog_printf_args<T, Rest...>
+{
+   static const bool value =
+   (
+      std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+      std::is_pointer<T>::value || std::is_same<T, std::nullptr_t>::value
+   ) && errorlog_printf_args<Rest...>::value;
+};
+
+/******************************************************************************
+ * errorlog_sink
+ *------------------------------------------------------------------------*//**
+ *
+ *    Forwards the calls of xpc::errorlog_t<> to an xpc::errorlog object, if
+ *    the level of the call is compiled in (Compiled == true).
+ *
+ *    The errorlog_sink<false> specialization does nothing, and never
+ *    refers to the xpc::errorlog functions, so that a compiled-out call
+ *    leaves no code and no link dependency behind, even without
+ *    optimization.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+template <bool Compiled>
+struct errorlog_sink
+{
+   template <typename... Args>
+   static void errprintf (const errorlog & log, const char * fmt, Args... args)
+   {
+      if (log.showerrors())
+         log.errprintf(fmt, args...);
+   }
+
+   template <typename... Args>
+   static void warnprintf (const errorlog & log, const char * fmt, Args... args)
+   {
+      if (log.showwarnings())
+         log.warnprintf(fmt, args...);
+   }
+
+   template <typename... Args>
+   static void infoprintf (const errorlog & log, const char * fmt, Args... args)
+   {
+      if (log.showinfo())
+         log.infoprintf(fmt, args...);
+   }
+
+   template <typename... Args>
+   static void dbginfoprintf
+   (
+      const errorlog & log, const char * fmt, Args... args
+   )
+   {
+      if (log.showdebug())
+         log.dbginfoprintf(fmt, args...);
+   }
+
+   template <typename S>
+   static void errprint (const errorlog & log, const S & msg)
+   {
+      if (log.showerrors())
+         log.errprint(msg);
+   }
+
+   template <typename S>
+   static void warnprint (const errorlog & log, const S & msg)
+   {
+      if (log.showwarnings())
+         log.warnprint(msg);
+   }
+
+   template <typename S>
+   static void infoprint (const errorlog & log, const S & msg)
+   {
+      if (log.showinfo())
+         log.infoprint(msg);
+   }
+
+   template <typename S>
+   static void dbginfoprint (const errorlog & log, const S & msg)
+   {
+      if (log.showdebug())
+         log.dbginfoprint(msg);
+   }
+
+   template <typename S, typename L>
+   static void errprintex (const errorlog & log, const S & msg, const L & label)
+   {
+      if (log.showerrors())
+         log.errprintex(msg, label);
+   }
+
+   template <typename S, typename L>
+   static void warnprintex (const errorlog & log, const S & msg, const L & label)
+   {
+      if (log.showwarnings())
+         log.warnprintex(msg, label);
+   }
+
+   template <typename S, typename L>
+   static void infoprintex (const errorlog & log, const S & msg, const L & label)
+   {
+      if (log.showinfo())
+         log.infoprintex(msg, label);
+   }
+};
+
+template <>
+struct errorlog_sink<false>
+{
+   template <typename... Args> static void errprintf (Args &&...) { }
+   template <typename... Args> static void warnprintf (Args &&...) { }
+   template <typename... Args> static void infoprintf (Args &&...) { }
+   template <typename... Args> static void dbginfoprintf (Args &&...) { }
+   template <typename... Args> static void errprint (Args &&...) { }
+   template <typename... Args> static void warnprint (Args &&...) { }
+   template <typename... Args> static void infoprint (Args &&...) { }
+   template <typename... Args> static void dbginfoprint (Args &&...) { }
+   template <typename... Args> static void errprintex (Args &&...) { }
+   template <typename... Args> static void warnprintex (Args &&...) { }
+   template <typename... Args> static void infoprintex (Args &&...) { }
+};
+
+/******************************************************************************
+ * XPC_COMPILED_ERRLEVEL
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the default compile-time level for xpc::compiled_errorlog.
+ *
+ *    A release build can add, for example,
+ *    "-DXPC_COMPILED_ERRLEVEL=XPC_ERROR_LEVEL_WARNINGS" to CXXFLAGS, to
+ *    remove all of the info and debug calls made through that type.  By
+ *    default, nothing is removed (except the debug calls, when DEBUG is not
+ *    defined).
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_COMPILED_ERRLEVEL
+#ifdef XPC_NO_ERRORLOG
+#define XPC_COMPILED_ERRLEVEL    XPC_ERROR_LEVEL_NONE
+#else
+#define XPC_COMPILED_ERRLEVEL    XPC_ERROR_LEVEL_ALL
+#endif
+#endif
+
+/******************************************************************************
+ * class errorlog_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a front end to an xpc::errorlog object, in which the calls
+ *    below a compile-time minimum level are removed entirely.
+ *
+ *    The MinLevel parameter is the least severe level that is compiled in.
+ *    For example, errorlog_t<XPC_ERROR_LEVEL_WARNINGS> keeps the error and
+ *    warning calls, which are still subject to the run-time error-level of
+ *    the xpc::errorlog object, but compiles the info and debug calls to
+ *    nothing.  The debug calls are also removed if DEBUG is not defined.
+ *
+ *    The object is just a reference to the xpc::errorlog that does the
+ *    work, xpc::mainlog() by default, so it is cheap to create as needed.
+ *
+ *    The printf()-style functions reject arguments that cannot be passed
+ *    through "..." at compile time.  To also have the format string checked,
+ *    and to avoid evaluating the arguments of a message that is not
+ *    shown, use the logt_errprintf() family of macros.
+ *
+\verbatim
+      xpc::errorlog_t<XPC_ERROR_LEVEL_WARNINGS> log;
+      log.infoprint("gone in release builds");
+      logt_warnprintf(log, "%d packets dropped", count);
+\endverbatim
+ *
+ *//*-------------------------------------------------------------------------*/
+
+template <xpc_errlevel_t MinLevel>
+class errorlog_t
+{
+
+private:
+
+   /**
+    *    The xpc::errorlog object that does the actual work.
+    */
+
+   const errorlog & m_log;
+
+public:
+
+   /**
+    *    Creates a front end for the given xpc::errorlog object.
+    *
+    * \param log
+    *    The object to which the calls that are compiled in are forwarded.
+    *    By default, it is xpc::mainlog().
+    */
+
+   explicit errorlog_t (const errorlog & log = mainlog ())
+    :
+      m_log    (log)
+   {
+      // no other code
+   }
+
+   /**
+    *    Tells if calls at the given level are compiled in.
+    *
+    * \param level
+    *    The level of the message.
+    *
+    * \return
+    *    Returns 'true' if \a level is not more verbose than MinLevel.
+    */
+
+   static constexpr bool compiled (xpc_errlevel_t level)
+   {
+      return level != XPC_ERROR_LEVEL_NONE && level <= MinLevel;
+   }
+
+   /**
+    *    Tells if the debug calls are compiled in.  They require both DEBUG
+    *    and a MinLevel of XPC_ERROR_LEVEL_INFO or above.
+    */
+
+   static constexpr bool compiled_debug ()
+   {
+#if defined DEBUG && ! defined XPC_NO_ERRORLOG
+      return compiled(XPC_ERROR_LEVEL_INFO);
+#else
+      return false;
+#endif
+   }
+
+   /**
+    *    Provides the underlying xpc::errorlog object, for the functions
+    *    that this template does not wrap.
+    */
+
+   const errorlog & log () const
+   {
+      return m_log;
+   }
+
+   /**
+    *    These functions are the compile-time equivalents of the
+    *    xpc::errorlog show functions.  If the level is compiled out, they
+    *    are constant false, otherwise they check the run-time level.
+    */
+
+   bool showerrors () const
+   {
+      return compiled(XPC_ERROR_LEVEL_ERRORS) && m_log.showerrors();
+   }
+
+   bool showwarnings () const
+   {
+      return compiled(XPC_ERROR_LEVEL_WARNINGS) && m_log.showwarnings();
+   }
+
+   bool showinfo () const
+   {
+      return compiled(XPC_ERROR_LEVEL_INFO) && m_log.showinfo();
+   }
+
+   bool showdebug () const
+   {
+      return compiled_debug() && m_log.showdebug();
+   }
+
+   /*
+    * The message functions.  The string parameters are templates, so
+    * that a string literal is not converted to std::string unless the
+    * message is actually shown.
+    */
+
+   template <typename S>
+   void errprint (const S & msg) const
+   {
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_ERRORS)>::errprint(m_log, msg);
+   }
+
+   template <typename S>
+   void warnprint (const S & msg) const
+   {
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_WARNINGS)>::warnprint(m_log, msg);
+   }
+
+   template <typename S>
+   void infoprint (const S & msg) const
+   {
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_INFO)>::infoprint(m_log, msg);
+   }
+
+   template <typename S>
+   void dbginfoprint (const S & msg) const
+   {
+      errorlog_sink<compiled_debug()>::dbginfoprint(m_log, msg);
+   }
+
+   template <typename S, typename L>
+   void errprintex (const S & msg, const L & label) const
+   {
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_ERRORS)>::errprintex
+      (
+         m_log, msg, label
+      );
+   }
+
+   template <typename S, typename L>
+   void warnprintex (const S & msg, const L & label) const
+   {
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_WARNINGS)>::warnprintex
+      (
+         m_log, msg, label
+      );
+   }
+
+   template <typename S, typename L>
+   void infoprintex (const S & msg, const L & label) const
+   {
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_INFO)>::infoprintex
+      (
+         m_log, msg, label
+      );
+   }
+
+   template <typename... Args>
+   void errprintf (const char * fmt, Args... args) const
+   {
+      static_assert
+      (
+         errorlog_printf_args<Args...>::value,
+         "errprintf() arguments must be numbers or pointers"
+      );
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_ERRORS)>::errprintf
+      (
+         m_log, fmt, args...
+      );
+   }
+
+   template <typename... Args>
+   void warnprintf (const char * fmt, Args... args) const
+   {
+      static_assert
+      (
+         errorlog_printf_args<Args...>::value,
+         "warnprintf() arguments must be numbers or pointers"
+      );
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_WARNINGS)>::warnprintf
+      (
+         m_log, fmt, args...
+      );
+   }
+
+   template <typename... Args>
+   void infoprintf (const char * fmt, Args... args) const
+   {
+      static_assert
+      (
+         errorlog_printf_args<Args...>::value,
+         "infoprintf() arguments must be numbers or pointers"
+      );
+      errorlog_sink<compiled(XPC_ERROR_LEVEL_INFO)>::infoprintf
+      (
+         m_log, fmt, args...
+      );
+   }
+
+   template <typename... Args>
+   void dbginfoprintf (const char * fmt, Args... args) const
+   {
+      static_assert
+      (
+         errorlog_printf_args<Args...>::value,
+         "dbginfoprintf() arguments must be numbers or pointers"
+      );
+      errorlog_sink<compiled_debug()>::dbginfoprintf(m_log, fmt, args...);
+   }
+
+};             /* class errorlog_t  */
+
+/******************************************************************************
+ * compiled_errorlog
+ *------------------------------------------------------------------------*//**
+ *
+ *    The errorlog_t<> that uses the build-wide XPC_COMPILED_ERRLEVEL.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef errorlog_t<XPC_COMPILED_ERRLEVEL> compiled_errorlog;
+
 #endif         /* XPC_ERRORLOG_HPP  */
 
 }              /* namespace xpc     */
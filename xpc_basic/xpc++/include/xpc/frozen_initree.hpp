@@ -0,0 +1,294 @@
+#ifndef XPC_FROZEN_INITREE_HPP
+#define XPC_FROZEN_INITREE_HPP
+
+/******************************************************************************
+ * frozen_initree.hpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          frozen_initree.hpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2014-04-24
+ * \updates       2014-04-24
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a read-only copy of an xpc::initree that is laid out for
+ *    fast lookups, for code that looks settings up on every request.
+ *
+ *    An initree is a std::map of std::maps, so each lookup is two tree
+ *    walks with string compares at every node.  A frozen_initree is built
+ *    once, after the initree is read, and after that:
+ *
+ *       -  All of the section names, options, and values are interned,
+ *          null-terminated, in one character pool.
+ *       -  The sections and options are in two arrays, sorted as in the
+ *          initree, with the options of a section next to each other.
+ *       -  Two open-addressed hash tables, at most half full, map a
+ *          section name, and a section number plus an option name, to
+ *          their array entries.  Each slot keeps the full hash, so the
+ *          strings are compared only on a real match.
+ *
+ *    A lookup hashes the name once and usually reads one slot, and it
+ *    allocates nothing; the names can be passed as string literals,
+ *    std::strings, or xpc::strslices:
+ *
+\verbatim
+         xpc::frozen_initree config(tree);
+         xpc::strslice port = config.section("Server").value("port");
+\endverbatim
+ *
+ *    The strslices returned point into the pool, and stay valid as long as
+ *    the frozen_initree does.  Their data() are null-terminated.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/integers.h>              /* uint32_t                            */
+#include <xpc/initree.hpp>             /* xpc::initree                        */
+#include <xpc/strslice.hpp>            /* xpc::strslice                       */
+#include <string>                      /* std::string                         */
+#include <vector>                      /* std::vector                         */
+XPC_REVISION_DECL(frozen_initree)      /* show_frozen_initree_info()          */
+
+namespace xpc
+{
+
+/******************************************************************************
+ * class frozen_initree
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the frozen copy of an initree.  It can be copied and
+ *    assigned, but not changed except by freezing another initree into it.
+ *
+ *----------------------------------------------------------------------------*/
+
+class frozen_initree
+{
+
+public:
+
+   /**
+    *    Marks a missing section or option.
+    */
+
+   static const uint32_t npos = 0xFFFFFFFFu;
+
+   /**
+    *    Provides a handle to one section, for looking up its options.  It
+    *    is a pointer and an index, so it is cheap to copy, and a handle to
+    *    a missing section is valid() == false and has no options.  It must
+    *    not outlive its frozen_initree.
+    */
+
+   class section_view
+   {
+
+   private:
+
+      const frozen_initree * m_tree;
+      uint32_t m_index;
+
+   public:
+
+      section_view (const frozen_initree * tree, uint32_t index)
+       :
+         m_tree   (tree),
+         m_index  (index)
+      {
+         // no other code needed
+      }
+
+      bool valid () const
+      {
+         return m_index != npos;
+      }
+
+      strslice name () const
+      {
+         return m_tree->section_name(m_index);
+      }
+
+      size_t size () const
+      {
+         return m_tree->section_size(m_index);
+      }
+
+      bool contains (const strslice & option) const
+      {
+         return m_tree->find_option(m_index, option) != npos;
+      }
+
+      strslice value (const strslice & option) const
+      {
+         return m_tree->option_value(m_tree->find_option(m_index, option));
+      }
+
+   };          // class section_view
+
+private:
+
+   /**
+    *    A section: its name in the pool, and its run of options.
+    */
+
+   struct section_entry
+   {
+      uint32_t m_name;                 /**< Offset of the name in m_pool.     */
+      uint32_t m_name_length;          /**< Length of the name.               */
+      uint32_t m_first;                /**< Index of its first option.        */
+      uint32_t m_count;                /**< Number of its options.            */
+   };
+
+   /**
+    *    An option: its name and value in the pool.
+    */
+
+   struct option_entry
+   {
+      uint32_t m_name;                 /**< Offset of the name in m_pool.     */
+      uint32_t m_name_length;          /**< Length of the name.               */
+      uint32_t m_value;                /**< Offset of the value in m_pool.    */
+      uint32_t m_value_length;         /**< Length of the value.              */
+   };
+
+   /**
+    *    A hash-table slot.  An empty slot has an m_index of npos.
+    */
+
+   struct slot
+   {
+      uint32_t m_hash;                 /**< The full hash of the key.         */
+      uint32_t m_index;                /**< The entry the key belongs to.     */
+   };
+
+   /**
+    *    Holds every name and value, each followed by a null.
+    */
+
+   std::string m_pool;
+
+   /**
+    *    The sections, in initree order.
+    */
+
+   std::vector<section_entry> m_sections;
+
+   /**
+    *    The options, grouped by section, in initree order.
+    */
+
+   std::vector<option_entry> m_options;
+
+   /**
+    *    The hash table of section names.  Its size is a power of 2.
+    */
+
+   std::vector<slot> m_section_slots;
+
+   /**
+    *    The hash table of (section number, option name) keys.  Its size is
+    *    a power of 2.
+    */
+
+   std::vector<slot> m_option_slots;
+
+public:
+
+   frozen_initree ();
+   explicit frozen_initree (const initree & source);
+
+   void freeze (const initree & source);
+
+   /**
+    * \return
+    *    Returns a handle to the named section, which is not valid() if
+    *    there is no such section.  The unnamed section is named "".
+    */
+
+   section_view section (const strslice & sectionname) const
+   {
+      return section_view(this, find_section(sectionname));
+   }
+
+   /**
+    * \return
+    *    Returns the value of an option of a section, or an empty slice if
+    *    there is no such option.  Use contains() to tell a missing option
+    *    from an empty value.
+    */
+
+   strslice value
+   (
+      const strslice & sectionname,
+      const strslice & option
+   ) const
+   {
+      return option_value(find_option(find_section(sectionname), option));
+   }
+
+   /**
+    * \return
+    *    Returns true if the section has the option.
+    */
+
+   bool contains
+   (
+      const strslice & sectionname,
+      const strslice & option
+   ) const
+   {
+      return find_option(find_section(sectionname), option) != npos;
+   }
+
+   /**
+    * \accessor m_sections.size()
+    */
+
+   size_t size () const
+   {
+      return m_sections.size();
+   }
+
+   /**
+    * \accessor m_options.size()
+    */
+
+   size_t option_count () const
+   {
+      return m_options.size();
+   }
+
+   uint32_t find_section (const strslice & sectionname) const;
+   uint32_t find_option (uint32_t sectionindex, const strslice & option) const;
+   strslice section_name (uint32_t sectionindex) const;
+   size_t section_size (uint32_t sectionindex) const;
+   strslice option_value (uint32_t optionindex) const;
+
+private:
+
+   uint32_t intern (const std::string & s);
+
+   /**
+    * \return
+    *    Returns a slice of the pool.
+    */
+
+   strslice pooled (uint32_t offset, uint32_t length) const
+   {
+      return strslice(m_pool.data() + offset, length);
+   }
+
+};                // class frozen_initree
+
+}                 // namespace xpc
+
+#endif            // XPC_FROZEN_INITREE_HPP
+
+/******************************************************************************
+ * frozen_initree.hpp
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *----------------------------------------------------------------------------*/
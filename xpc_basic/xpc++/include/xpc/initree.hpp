@@ -9,16 +9,20 @@
  * \library       xpc
  * \author        Chris Ahlstrom
  * \date          2014-04-20
- * \updates       2014-04-21
+ * \updates       2014-04-23
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
  *    Provides a way to create an options tree using a DOS/Windows INI-style
  *    configuration file.
  *
+ *    The file can be read line by line through a stream, or memory-mapped
+ *    and parsed in one pass over the mapping; see initree::readfile().
+ *
  *----------------------------------------------------------------------------*/
 
 #include <xpc/stringmap.hpp>        /* xpc::stringmap<> template class        */
+#include <xpc/strslice.hpp>         /* xpc::strslice class                    */
 XPC_REVISION_DECL(initree)          /* show_initree_info()                    */
 
 namespace xpc
@@ -80,6 +84,26 @@ public:
 
    typedef std::pair<std::string, Section> pair;
 
+   /**
+    *    Selects how readfile() gets at the file.
+    *
+    * \var INITREE_STREAM
+    *    The default, reads the file a line at a time with std::getline().
+    *
+    * \var INITREE_MAPPED
+    *    Maps the file into memory and parses it in a single scan, cutting
+    *    the sections, options, and values out of the mapping as slices.
+    *    Only the options and values that go into the tree get copied.
+    *    This is much faster for large files.  If the file cannot be
+    *    mapped, it is read as a stream.
+    */
+
+   enum readmode
+   {
+      INITREE_STREAM,
+      INITREE_MAPPED
+   };
+
 private:
 
    /**
@@ -137,7 +161,11 @@ public:
       // That is it for now!
    }
 
-   bool readfile (const std::string & filespec);      // TODO
+   bool readfile
+   (
+      const std::string & filespec,
+      readmode mode = INITREE_STREAM
+   );
 
    /**
     * @getter m_name
@@ -357,6 +385,9 @@ protected:
        return c == '#' || c == ';' || c == '!' || c == '\'' || c == '"';
    }
 
+   bool read_stream (const std::string & filespec);
+   bool read_mapped (const std::string & filespec);
+   bool parse (const char * text, size_t length);
    std::string process_section_name
    (
       const std::string & s,
@@ -0,0 +1,573 @@
+#if ! defined XPC_QUEUES_HPP
+#define XPC_QUEUES_HPP
+
+/******************************************************************************
+ * queues.hpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          queues.hpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \updates       2013-08-15 to 2013-08-15
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides xpc::spsc_queue<T> and xpc::mpmc_queue<T>, bounded lock-free
+ *    queues of values.
+ *
+ *    These are the same algorithms as the C xpc_spsc_queue_t and
+ *    xpc_mpmc_queue_t (see the queues.c module), but they hold values of
+ *    any default-constructible, assignable type instead of pointers, and
+ *    use std::atomic.  The blocking functions sleep on the C
+ *    xpc_eventcount_t.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <atomic>                      /* std::atomic                         */
+#include <cstddef>                     /* std::size_t                         */
+#include <vector>                      /* std::vector                         */
+#include <xpc/queues.h>                /* C::xpc_eventcount_t                 */
+
+namespace xpc
+{
+
+/******************************************************************************
+ * queue_round_up()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Rounds a queue capacity up to a power of 2, of at least 2.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+inline std::size_t
+queue_round_up (std::size_t capacity)
+{
+   std::size_t result = 2;
+   while (result != 0 && result < capacity)
+      result <<= 1;
+
+   return result;
+}
+
+/******************************************************************************
+ * queue_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Retries a push or pop until it succeeds or the queue is closed,
+ *    sleeping on the event-count in between.  Once the queue is closed,
+ *    one last try is made, so that a closed queue can still be drained.
+ *
+ * \return
+ *    Returns 'true' if the operation succeeded.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+template <typename ATTEMPT>
+bool
+queue_wait
+(
+   ATTEMPT attempt,
+   xpc_eventcount_t & ec,
+   const std::atomic<bool> & closed
+)
+{
+   bool result = attempt();
+   while (! result)
+   {
+      if (closed.load())
+      {
+         result = attempt();
+         break;
+      }
+      else
+      {
+         int key = xpc_eventcount_prepare(&ec);
+         result = attempt();
+         if (result || closed.load())
+            xpc_eventcount_cancel(&ec);
+         else
+            xpc_eventcount_wait(&ec, key);
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * spsc_queue
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a bounded single-producer/single-consumer ring.  Only one
+ *    thread may push, and only one thread may pop.
+ *
+ *    The head and tail indices are on separate cache lines, and each side
+ *    keeps a cached copy of the other side's index, reading the real one
+ *    only when the ring looks full (or empty).
+ *
+ *//*-------------------------------------------------------------------------*/
+
+template <typename T>
+class spsc_queue
+{
+
+private:
+
+   /**
+    *    The next slot to pop, and the consumer's copy of m_Tail.
+    */
+
+   alignas(XPC_CACHE_LINE_SIZE) std::atomic<std::size_t> m_Head;
+   std::size_t m_Tail_Cache;
+
+   /**
+    *    The next slot to push, and the producer's copy of m_Head.
+    */
+
+   alignas(XPC_CACHE_LINE_SIZE) std::atomic<std::size_t> m_Tail;
+   std::size_t m_Head_Cache;
+
+   /**
+    *    The ring, and its size less 1.
+    */
+
+   alignas(XPC_CACHE_LINE_SIZE) std::vector<T> m_Slots;
+   std::size_t m_Mask;
+
+   /**
+    *    Set by close().
+    */
+
+   std::atomic<bool> m_Closed;
+
+   /**
+    *    Wake a consumer waiting for an item, and a producer waiting for
+    *    room.
+    */
+
+   xpc_eventcount_t m_Not_Empty;
+   xpc_eventcount_t m_Not_Full;
+
+public:
+
+   /**
+    *    Creates an empty queue.
+    *
+    * \param capacity
+    *    The number of items it can hold, rounded up to a power of 2.
+    */
+
+   explicit spsc_queue (std::size_t capacity)
+    :
+      m_Head         (0),
+      m_Tail_Cache   (0),
+      m_Tail         (0),
+      m_Head_Cache   (0),
+      m_Slots        (queue_round_up(capacity)),
+      m_Mask         (m_Slots.size() - 1),
+      m_Closed       (false),
+      m_Not_Empty    (),
+      m_Not_Full     ()
+   {
+      xpc_eventcount_init(&m_Not_Empty);
+      xpc_eventcount_init(&m_Not_Full);
+   }
+
+   /**
+    *    Adds an item, without blocking.
+    *
+    * \return
+    *    Returns 'true' if the item was added, 'false' if the queue is full.
+    */
+
+   bool push (const T & item)
+   {
+      return push_batch(&item, 1) == 1;
+   }
+
+   /**
+    *    Removes the oldest item, without blocking.
+    *
+    * \return
+    *    Returns 'true' if an item was removed, 'false' if the queue is
+    *    empty.
+    */
+
+   bool pop (T & item)
+   {
+      return pop_batch(&item, 1) == 1;
+   }
+
+   /**
+    *    Adds as many of the items as there is room for, without blocking.
+    *
+    * \return
+    *    Returns the number of items added, from the front of the array.
+    */
+
+   std::size_t push_batch (const T * items, std::size_t count)
+   {
+      std::size_t tail = m_Tail.load(std::memory_order_relaxed);
+      std::size_t room = m_Mask + 1 - (tail - m_Head_Cache);
+      if (room < count)
+      {
+         m_Head_Cache = m_Head.load(std::memory_order_acquire);
+         room = m_Mask + 1 - (tail - m_Head_Cache);
+      }
+      if (count > room)
+         count = room;
+
+      for (std::size_t i = 0; i < count; ++i)
+         m_Slots[(tail + i) & m_Mask] = items[i];
+
+      if (count > 0)
+      {
+         m_Tail.store(tail + count, std::memory_order_release);
+         xpc_eventcount_notify(&m_Not_Empty);
+      }
+      return count;
+   }
+
+   /**
+    *    Removes up to \a count of the oldest items, without blocking.
+    *
+    * \return
+    *    Returns the number of items removed.
+    */
+
+   std::size_t pop_batch (T * items, std::size_t count)
+   {
+      std::size_t head = m_Head.load(std::memory_order_relaxed);
+      std::size_t available = m_Tail_Cache - head;
+      if (available < count)
+      {
+         m_Tail_Cache = m_Tail.load(std::memory_order_acquire);
+         available = m_Tail_Cache - head;
+      }
+      if (count > available)
+         count = available;
+
+      for (std::size_t i = 0; i < count; ++i)
+         items[i] = m_Slots[(head + i) & m_Mask];
+
+      if (count > 0)
+      {
+         m_Head.store(head + count, std::memory_order_release);
+         xpc_eventcount_notify(&m_Not_Full);
+      }
+      return count;
+   }
+
+   /**
+    *    Adds an item, waiting for room if the queue is full.
+    *
+    * \return
+    *    Returns 'false' if the queue was closed first.
+    */
+
+   bool push_wait (const T & item)
+   {
+      return ! m_Closed.load() && queue_wait
+      (
+         [this, &item] () { return push(item); }, m_Not_Full, m_Closed
+      );
+   }
+
+   /**
+    *    Removes the oldest item, waiting for one if the queue is empty.
+    *
+    * \return
+    *    Returns 'false' if the queue is closed and empty.
+    */
+
+   bool pop_wait (T & item)
+   {
+      return queue_wait
+      (
+         [this, &item] () { return pop(item); }, m_Not_Empty, m_Closed
+      );
+   }
+
+   /**
+    *    Closes the queue and wakes all waiters.  After this, push_wait()
+    *    fails, and pop_wait() fails once the queue is empty.
+    */
+
+   void close ()
+   {
+      m_Closed.store(true);
+      xpc_eventcount_notify(&m_Not_Empty);
+      xpc_eventcount_notify(&m_Not_Full);
+   }
+
+   bool closed () const
+   {
+      return m_Closed.load();
+   }
+
+   std::size_t capacity () const
+   {
+      return m_Mask + 1;
+   }
+
+   /**
+    * \return
+    *    Returns the number of items queued; an estimate if the other side
+    *    is busy.
+    */
+
+   std::size_t size () const
+   {
+      std::size_t head = m_Head.load(std::memory_order_acquire);
+      return m_Tail.load(std::memory_order_acquire) - head;
+   }
+
+private:
+
+   spsc_queue (const spsc_queue &);                /* not copyable         */
+   spsc_queue & operator = (const spsc_queue &);   /* not assignable       */
+
+};             /* class spsc_queue */
+
+/******************************************************************************
+ * mpmc_queue
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a bounded multi-producer/multi-consumer queue (Dmitry
+ *    Vyukov's algorithm).  Each cell has a sequence number that equals the
+ *    push position when the cell is free, and the pop position plus 1
+ *    when it is full.  A push or pop claims its position with one CAS.
+ *
+ *    The batch functions claim their cells one at a time, so items from
+ *    other threads may be interleaved with a batch; they save only the
+ *    wakeup checks.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+template <typename T>
+class mpmc_queue
+{
+
+private:
+
+   /**
+    *    One slot of the queue.
+    */
+
+   struct cell
+   {
+      std::atomic<std::size_t> m_Sequence;
+      T m_Data;
+   };
+
+   /**
+    *    The next positions to push and to pop.
+    */
+
+   alignas(XPC_CACHE_LINE_SIZE) std::atomic<std::size_t> m_Enqueue;
+   alignas(XPC_CACHE_LINE_SIZE) std::atomic<std::size_t> m_Dequeue;
+
+   /**
+    *    The cells, and their number less 1.
+    */
+
+   alignas(XPC_CACHE_LINE_SIZE) std::vector<cell> m_Cells;
+   std::size_t m_Mask;
+
+   /**
+    *    Set by close().
+    */
+
+   std::atomic<bool> m_Closed;
+
+   /**
+    *    Wake consumers waiting for an item, and producers waiting for room.
+    */
+
+   xpc_eventcount_t m_Not_Empty;
+   xpc_eventcount_t m_Not_Full;
+
+public:
+
+   /**
+    *    Creates an empty queue.
+    *
+    * \param capacity
+    *    The number of items it can hold, rounded up to a power of 2.
+    */
+
+   explicit mpmc_queue (std::size_t capacity)
+    :
+      m_Enqueue      (0),
+      m_Dequeue      (0),
+      m_Cells        (queue_round_up(capacity)),
+      m_Mask         (m_Cells.size() - 1),
+      m_Closed       (false),
+      m_Not_Empty    (),
+      m_Not_Full     ()
+   {
+      for (std::size_t c = 0; c <= m_Mask; ++c)
+         m_Cells[c].m_Sequence.store(c, std::memory_order_relaxed);
+
+      xpc_eventcount_init(&m_Not_Empty);
+      xpc_eventcount_init(&m_Not_Full);
+   }
+
+   bool push (const T & item)
+   {
+      bool result = claim_push(item);
+      if (result)
+         xpc_eventcount_notify(&m_Not_Empty);
+
+      return result;
+   }
+
+   bool pop (T & item)
+   {
+      bool result = claim_pop(item);
+      if (result)
+         xpc_eventcount_notify(&m_Not_Full);
+
+      return result;
+   }
+
+   std::size_t push_batch (const T * items, std::size_t count)
+   {
+      std::size_t result = 0;
+      while (result < count && claim_push(items[result]))
+         ++result;
+
+      if (result > 0)
+         xpc_eventcount_notify(&m_Not_Empty);
+
+      return result;
+   }
+
+   std::size_t pop_batch (T * items, std::size_t count)
+   {
+      std::size_t result = 0;
+      while (result < count && claim_pop(items[result]))
+         ++result;
+
+      if (result > 0)
+         xpc_eventcount_notify(&m_Not_Full);
+
+      return result;
+   }
+
+   bool push_wait (const T & item)
+   {
+      return ! m_Closed.load() && queue_wait
+      (
+         [this, &item] () { return push(item); }, m_Not_Full, m_Closed
+      );
+   }
+
+   bool pop_wait (T & item)
+   {
+      return queue_wait
+      (
+         [this, &item] () { return pop(item); }, m_Not_Empty, m_Closed
+      );
+   }
+
+   void close ()
+   {
+      m_Closed.store(true);
+      xpc_eventcount_notify(&m_Not_Empty);
+      xpc_eventcount_notify(&m_Not_Full);
+   }
+
+   bool closed () const
+   {
+      return m_Closed.load();
+   }
+
+   std::size_t capacity () const
+   {
+      return m_Mask + 1;
+   }
+
+   std::size_t size () const
+   {
+      std::size_t dequeue = m_Dequeue.load(std::memory_order_acquire);
+      std::size_t enqueue = m_Enqueue.load(std::memory_order_acquire);
+      return enqueue > dequeue ? enqueue - dequeue : 0 ;
+   }
+
+private:
+
+   /**
+    *    Claims the next push position and fills its cell.  A cell sequence
+    *    behind the position means the queue is full; one ahead means
+    *    another producer took the position, so it is reloaded.
+    */
+
+   bool claim_push (const T & item)
+   {
+      cell * c = nullptr;
+      std::size_t pos = m_Enqueue.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         c = &m_Cells[pos & m_Mask];
+         std::size_t seq = c->m_Sequence.load(std::memory_order_acquire);
+         std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+         if (diff == 0)
+         {
+            if (m_Enqueue.compare_exchange_weak(pos, pos + 1))
+               break;
+         }
+         else if (diff < 0)
+            return false;
+         else
+            pos = m_Enqueue.load(std::memory_order_relaxed);
+      }
+      c->m_Data = item;
+      c->m_Sequence.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+
+   /**
+    *    Claims the next pop position and empties its cell, then frees the
+    *    cell for the next lap.
+    */
+
+   bool claim_pop (T & item)
+   {
+      cell * c = nullptr;
+      std::size_t pos = m_Dequeue.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         c = &m_Cells[pos & m_Mask];
+         std::size_t seq = c->m_Sequence.load(std::memory_order_acquire);
+         std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+         if (diff == 0)
+         {
+            if (m_Dequeue.compare_exchange_weak(pos, pos + 1))
+               break;
+         }
+         else if (diff < 0)
+            return false;
+         else
+            pos = m_Dequeue.load(std::memory_order_relaxed);
+      }
+      item = c->m_Data;
+      c->m_Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+      return true;
+   }
+
+   mpmc_queue (const mpmc_queue &);                /* not copyable         */
+   mpmc_queue & operator = (const mpmc_queue &);   /* not assignable       */
+
+};             /* class mpmc_queue */
+
+}              /* namespace xpc     */
+
+#endif         /* XPC_QUEUES_HPP */
+
+/******************************************************************************
+ * queues.hpp
+ *----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *//*-------------------------------------------------------------------------*/
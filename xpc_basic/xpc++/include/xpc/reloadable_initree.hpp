@@ -0,0 +1,342 @@
+#ifndef XPC_RELOADABLE_INITREE_HPP
+#define XPC_RELOADABLE_INITREE_HPP
+
+/******************************************************************************
+ * reloadable_initree.hpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          reloadable_initree.hpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2014-04-26
+ * \updates       2014-04-26
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a configuration that can be re-read while the application
+ *    runs, without stopping or slowing down the threads that read it.
+ *
+ *    The configuration is published as an immutable config_snapshot, an
+ *    initree plus its frozen_initree copy.  A reload builds a whole new
+ *    snapshot off to the side, then swaps one atomic pointer, so a reader
+ *    sees either the old configuration or the new one, never a mix.
+ *
+ *    A reader pins the current snapshot with a reader object:
+ *
+\verbatim
+         xpc::reloadable_initree config("service.ini");
+         (void) config.watch();              // reload when the file changes
+         ...
+         {
+            xpc::reloadable_initree::reader r(config);
+            xpc::strslice port = r->lookup().value("Server", "port");
+            ...
+         }
+\endverbatim
+ *
+ *    Reading takes no lock.  Pinning increments, and unpinning decrements,
+ *    one of a set of per-thread-striped counters, in the manner of
+ *    read-copy-update:  after the swap, the reloading thread waits for a
+ *    grace period, in which every reader that might still hold the old
+ *    snapshot unpins it, and only then deletes the old snapshot.  So a
+ *    reader should be short-lived; one held for a long time delays the
+ *    reload (but not other readers).  A thread must never call reload()
+ *    while it holds a reader of the same object:  the grace period would
+ *    wait for that reader forever.
+ *
+ *    watch() starts a thread that waits on inotify for the file to be
+ *    rewritten or replaced, and reloads it.  The directory is watched,
+ *    not the file, so that editors and deployment tools that write a new
+ *    file and rename it over the old one are noticed.  A file that does
+ *    not parse is logged and ignored; the previous snapshot stays.
+ *
+ * \linux
+ *    inotify is Linux-only.  Elsewhere, watch() fails, and reload() has to
+ *    be called by the application (on SIGHUP, say).
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/atomix.h>                /* XPC_CACHE_LINE_SIZE                 */
+#include <xpc/frozen_initree.hpp>      /* xpc::frozen_initree                 */
+#include <xpc/initree.hpp>             /* xpc::initree                        */
+#include <atomic>                      /* std::atomic<>                       */
+#include <mutex>                       /* std::mutex                          */
+#include <string>                      /* std::string                         */
+#include <thread>                      /* std::thread                         */
+XPC_REVISION_DECL(reloadable_initree)  /* show_reloadable_initree_info()      */
+
+namespace xpc
+{
+
+/******************************************************************************
+ * class config_snapshot
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides one version of the configuration.  Readers only ever see it
+ *    through a const reference.
+ *
+ *----------------------------------------------------------------------------*/
+
+class config_snapshot
+{
+
+private:
+
+   /**
+    *    The configuration as read.
+    */
+
+   initree m_tree;
+
+   /**
+    *    The frozen copy of m_tree, for fast lookups.
+    */
+
+   frozen_initree m_lookup;
+
+   /**
+    *    1 for the first successful load, 2 for the next one, and so on.  0
+    *    for the empty snapshot that exists before any load.
+    */
+
+   unsigned long m_generation;
+
+public:
+
+   config_snapshot ();
+   bool load
+   (
+      const std::string & filespec,
+      unsigned long generation
+   );
+
+   /**
+    * \getter m_tree
+    */
+
+   const initree & tree () const
+   {
+      return m_tree;
+   }
+
+   /**
+    * \getter m_lookup
+    */
+
+   const frozen_initree & lookup () const
+   {
+      return m_lookup;
+   }
+
+   /**
+    * \getter m_generation
+    */
+
+   unsigned long generation () const
+   {
+      return m_generation;
+   }
+
+};                // class config_snapshot
+
+/******************************************************************************
+ * class reloadable_initree
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the holder of the current snapshot.  It is not copyable.
+ *
+ *----------------------------------------------------------------------------*/
+
+class reloadable_initree
+{
+
+public:
+
+   /**
+    *    The number of reader counters per phase.  Threads are spread over
+    *    them, so that readers on different CPUs do not write the same
+    *    cache line.
+    */
+
+   static const int READER_STRIPES = 16;
+
+   /**
+    *    Pins the current snapshot for as long as it exists.  It must be
+    *    destroyed on the thread that created it, and is not copyable.
+    *
+    * \warning
+    *    Do not call reload() on the holder while this thread has a
+    *    reader of it alive.  reload() waits until every reader of the old
+    *    snapshot is gone, including the caller's own, and so deadlocks.
+    */
+
+   class reader
+   {
+
+   private:
+
+      const reloadable_initree & m_holder;
+      unsigned m_phase;
+      int m_stripe;
+      const config_snapshot * m_snapshot;
+
+   public:
+
+      explicit reader (const reloadable_initree & holder)
+       :
+         m_holder    (holder),
+         m_phase     (holder.m_phase.load() & 1),
+         m_stripe    (reader_stripe()),
+         m_snapshot  (nullptr)
+      {
+         m_holder.m_readers[m_phase][m_stripe].m_count.fetch_add(1);
+         m_snapshot = m_holder.m_current.load();
+      }
+
+      ~reader ()
+      {
+         m_holder.m_readers[m_phase][m_stripe].m_count.fetch_sub(1);
+      }
+
+      const config_snapshot & operator * () const
+      {
+         return *m_snapshot;
+      }
+
+      const config_snapshot * operator -> () const
+      {
+         return m_snapshot;
+      }
+
+   private:
+
+      reader (const reader &);                  /* not copyable         */
+      reader & operator = (const reader &);     /* not assignable       */
+
+   };          // class reader
+
+private:
+
+   /**
+    *    A reader counter, alone on its cache line.
+    */
+
+   struct reader_count
+   {
+      std::atomic<long> m_count;
+      char m_pad[XPC_CACHE_LINE_SIZE - sizeof(std::atomic<long>)];
+   };
+
+   /**
+    *    The file to read.
+    */
+
+   std::string m_filespec;
+
+   /**
+    *    The snapshot new readers get.  It is never null.
+    */
+
+   std::atomic<config_snapshot *> m_current;
+
+   /**
+    *    The phase new readers count themselves in; only its low bit is
+    *    used.  Flipped twice by each grace period.
+    */
+
+   std::atomic<unsigned> m_phase;
+
+   /**
+    *    The reader counters, by phase and stripe.
+    */
+
+   mutable reader_count m_readers[2][READER_STRIPES];
+
+   /**
+    *    Serializes reload() calls, which can come from the watcher thread
+    *    and the application at once.  Readers never take it.
+    */
+
+   std::mutex m_reload_lock;
+
+   /**
+    *    The generation of the last successful load.
+    */
+
+   std::atomic<unsigned long> m_generation;
+
+   /**
+    *    The inotify thread, if watch() started it.
+    */
+
+   std::thread m_watcher;
+
+   /**
+    *    The pipe that stop() writes to, to wake the watcher; -1 if not
+    *    watching.
+    */
+
+   int m_wake_pipe[2];
+
+public:
+
+   explicit reloadable_initree (const std::string & filespec);
+   ~reloadable_initree ();
+
+   bool reload ();
+   bool watch ();
+   void stop ();
+
+   /**
+    * \getter m_filespec
+    */
+
+   const std::string & filespec () const
+   {
+      return m_filespec;
+   }
+
+   /**
+    * \return
+    *    Returns the generation of the current snapshot, 0 if the file has
+    *    never been loaded.
+    */
+
+   unsigned long generation () const
+   {
+      return m_generation.load();
+   }
+
+   /**
+    * \return
+    *    Returns true if the watcher thread is running.
+    */
+
+   bool watching () const
+   {
+      return m_wake_pipe[1] >= 0;
+   }
+
+private:
+
+   static int reader_stripe ();
+   void synchronize ();
+   void watch_loop (int inotifyfd);
+
+   reloadable_initree (const reloadable_initree &);
+   reloadable_initree & operator = (const reloadable_initree &);
+
+};                // class reloadable_initree
+
+}                 // namespace xpc
+
+#endif            // XPC_RELOADABLE_INITREE_HPP
+
+/******************************************************************************
+ * reloadable_initree.hpp
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *----------------------------------------------------------------------------*/
@@ -0,0 +1,126 @@
+#if ! defined XPC_SCOPE_TIMER_HPP
+#define XPC_SCOPE_TIMER_HPP
+
+/******************************************************************************
+ * scope_timer.hpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          scope_timer.hpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \updates       2013-08-17 to 2013-08-17
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides xpc::scope_timer, which records the lifetime of a block in a
+ *    profiling zone of the C profiler.c module.
+ *
+ *    The usual way to use it is the XPC_SCOPE_TIMER() macro, which also
+ *    declares the zone:
+ *
+\verbatim
+         void parse ()
+         {
+            XPC_SCOPE_TIMER(parse);
+            ...
+         }
+\endverbatim
+ *
+ *    The time is read from xpc_monotonic_nanoseconds(), not from
+ *    xpc::systemtime, which follows the time-of-day and can jump.  The
+ *    results are read back with xpc_profile_merge() or xpc_profile_dump().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/profiler.h>              /* C::xpc_profile_zone_t, etc.         */
+
+namespace xpc
+{
+
+/******************************************************************************
+ * scope_timer
+ *------------------------------------------------------------------------*//**
+ *
+ *    Records the time from its construction to its destruction in a zone.
+ *    It is not copyable, so each timing is recorded exactly once.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+class scope_timer
+{
+
+private:
+
+   /**
+    *    The zone to record into.  It must be a static object.
+    */
+
+   xpc_profile_zone_t & m_Zone;
+
+   /**
+    *    The monotonic time of the construction, in nanoseconds.
+    */
+
+   uint64_t m_Start;
+
+public:
+
+   explicit scope_timer (xpc_profile_zone_t & zone)
+    :
+      m_Zone   (zone),
+      m_Start  (xpc_monotonic_nanoseconds())
+   {
+      // no other code needed
+   }
+
+   ~scope_timer ()
+   {
+      xpc_profile_record(&m_Zone, elapsed());
+   }
+
+   /**
+    * \return
+    *    Returns the nanoseconds since the timer was constructed.
+    */
+
+   uint64_t elapsed () const
+   {
+      return xpc_monotonic_nanoseconds() - m_Start;
+   }
+
+private:
+
+   scope_timer (const scope_timer &);              /* not copyable         */
+   scope_timer & operator = (const scope_timer &); /* not assignable       */
+
+};             /* class scope_timer */
+
+}              /* namespace xpc     */
+
+/******************************************************************************
+ * XPC_SCOPE_TIMER()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Declares a zone named \a zone and times the rest of the enclosing
+ *    block in it.  Compiled away if XPC_NO_PROFILING is defined.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#if defined XPC_NO_PROFILING
+#define XPC_SCOPE_TIMER(zone)
+#else
+#define XPC_SCOPE_TIMER(zone) \
+   static xpc_profile_zone_t xpc_zone_##zone = { #zone, 0 }; \
+   xpc::scope_timer xpc_scope_##zone(xpc_zone_##zone)
+#endif
+
+#endif         /* XPC_SCOPE_TIMER_HPP */
+
+/******************************************************************************
+ * scope_timer.hpp
+ *----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *//*-------------------------------------------------------------------------*/
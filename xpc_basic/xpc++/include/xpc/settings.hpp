@@ -0,0 +1,373 @@
+#ifndef XPC_SETTINGS_HPP
+#define XPC_SETTINGS_HPP
+
+/******************************************************************************
+ * settings.hpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          settings.hpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2014-04-25
+ * \updates       2014-04-25
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides typed handles to options of an xpc::initree, which are looked
+ *    up and converted once, when the configuration is loaded, instead of on
+ *    every use.
+ *
+ *    The code that needs a setting registers its section, option name,
+ *    type, and default value with an xpc::settings object, and keeps the
+ *    xpc::setting<> handle it gets back.  Reading the handle is a load
+ *    from memory:
+ *
+\verbatim
+         xpc::settings config;
+         xpc::setting<int> port = config.add("Server", "port", 8080);
+         xpc::setting<std::chrono::nanoseconds> timeout =
+            config.add("Server", "timeout", std::chrono::seconds(5));
+
+         xpc::initree tree("service", "service.ini");
+         if (! config.load(tree))
+            ... some values were malformed, and kept their defaults ...
+
+         listen(port.get());
+\endverbatim
+ *
+ *    The types supported are int, double, bool, std::string, and
+ *    std::chrono::nanoseconds; see the parse_setting() functions for the
+ *    formats accepted.
+ *
+ *    Handles stay valid as long as the settings object they came from.
+ *    load() writes the values, so it must not run while other threads are
+ *    reading the handles.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/initree.hpp>             /* xpc::initree                        */
+#include <chrono>                      /* std::chrono::nanoseconds            */
+#include <string>                      /* std::string                         */
+#include <vector>                      /* std::vector                         */
+XPC_REVISION_DECL(settings)            /* show_settings_info()                */
+
+namespace xpc
+{
+
+/******************************************************************************
+ * Global functions in the xpc namespace
+ *-----------------------------------------------------------------------------
+ *
+ *    Each is documented in the cpp file.
+ *
+ *----------------------------------------------------------------------------*/
+
+extern bool parse_setting (const std::string & text, int & value);
+extern bool parse_setting (const std::string & text, double & value);
+extern bool parse_setting (const std::string & text, bool & value);
+extern bool parse_setting (const std::string & text, std::string & value);
+extern bool parse_setting
+(
+   const std::string & text,
+   std::chrono::nanoseconds & value
+);
+
+/******************************************************************************
+ * setting
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a handle to one typed setting.  It is two pointers, so it
+ *    can be copied freely.  A default-constructed handle reads as T() and
+ *    is not found().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+template <typename T>
+class setting
+{
+
+private:
+
+   /**
+    *    The value, kept by the settings object.
+    */
+
+   const T * m_value;
+
+   /**
+    *    Whether the value came from the configuration or is the default.
+    */
+
+   const bool * m_found;
+
+   /**
+    *    The value and flag of a default-constructed handle.
+    */
+
+   static const T sm_unbound_value;
+   static const bool sm_unbound_found;
+
+public:
+
+   setting ()
+    :
+      m_value  (&sm_unbound_value),
+      m_found  (&sm_unbound_found)
+   {
+      // no other code needed
+   }
+
+   setting (const T * value, const bool * found)
+    :
+      m_value  (value),
+      m_found  (found)
+   {
+      // no other code needed
+   }
+
+   /**
+    * \return
+    *    Returns the value as of the last load(), or the default.
+    */
+
+   const T & get () const
+   {
+      return *m_value;
+   }
+
+   operator const T & () const
+   {
+      return *m_value;
+   }
+
+   /**
+    * \return
+    *    Returns true if the last load() found the option and could parse
+    *    it.
+    */
+
+   bool found () const
+   {
+      return *m_found;
+   }
+
+};             // class setting
+
+template <typename T>
+const T setting<T>::sm_unbound_value = T();
+
+template <typename T>
+const bool setting<T>::sm_unbound_found = false;
+
+/******************************************************************************
+ * settings
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the registry of settings, which owns their values.  It is
+ *    not copyable, since the handles point into it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+class settings
+{
+
+private:
+
+   /**
+    *    The part of a registered setting that does not depend on its type.
+    *    Only load() uses the virtual functions.
+    */
+
+   class entry_base
+   {
+
+   public:
+
+      std::string m_section;
+      std::string m_option;
+      bool m_found;
+
+      entry_base (const std::string & sectionname, const std::string & option)
+       :
+         m_section   (sectionname),
+         m_option    (option),
+         m_found     (false)
+      {
+         // no other code needed
+      }
+
+      virtual ~entry_base ()
+      {
+         // no code needed
+      }
+
+      virtual bool parse (const std::string & text) = 0;
+      virtual void reset () = 0;
+
+   };
+
+   /**
+    *    A registered setting of type T.
+    */
+
+   template <typename T>
+   class entry : public entry_base
+   {
+
+   public:
+
+      T m_value;
+      T m_default;
+
+      entry
+      (
+         const std::string & sectionname,
+         const std::string & option,
+         const T & defaultvalue
+      ) :
+         entry_base  (sectionname, option),
+         m_value     (defaultvalue),
+         m_default   (defaultvalue)
+      {
+         // no other code needed
+      }
+
+      virtual bool parse (const std::string & text)
+      {
+         T value;
+         bool result = parse_setting(text, value);
+         if (result)
+            m_value = value;
+
+         return result;
+      }
+
+      virtual void reset ()
+      {
+         m_value = m_default;
+      }
+
+   };
+
+   /**
+    *    The registered settings, in the order added.
+    */
+
+   std::vector<entry_base *> m_entries;
+
+public:
+
+   settings ();
+   ~settings ();
+
+   /**
+    *    Registers a setting.  Until the next load(), its handle reads the
+    *    default value.
+    *
+    * \param sectionname
+    *    The section of the option; "" for the unnamed section.
+    *
+    * \param option
+    *    The option name.
+    *
+    * \param defaultvalue
+    *    The value used when the option is missing or malformed.  Its type
+    *    picks the type of the setting.
+    *
+    * \return
+    *    Returns the handle.
+    */
+
+   template <typename T>
+   setting<T> add
+   (
+      const std::string & sectionname,
+      const std::string & option,
+      const T & defaultvalue
+   )
+   {
+      return make<T>(sectionname, option, defaultvalue);
+   }
+
+   /**
+    *    Registers a string setting.  This overload keeps a string literal
+    *    default from making a setting<const char *>.
+    */
+
+   setting<std::string> add
+   (
+      const std::string & sectionname,
+      const std::string & option,
+      const char * defaultvalue
+   )
+   {
+      return make<std::string>(sectionname, option, defaultvalue);
+   }
+
+   /**
+    *    Registers a duration setting.  Whatever the unit of the default,
+    *    the setting is kept in nanoseconds.
+    */
+
+   template <typename Rep, typename Period>
+   setting<std::chrono::nanoseconds> add
+   (
+      const std::string & sectionname,
+      const std::string & option,
+      const std::chrono::duration<Rep, Period> & defaultvalue
+   )
+   {
+      return make<std::chrono::nanoseconds>
+      (
+         sectionname, option,
+         std::chrono::duration_cast<std::chrono::nanoseconds>(defaultvalue)
+      );
+   }
+
+   bool load (const initree & tree);
+
+   /**
+    * \accessor m_entries.size()
+    */
+
+   size_t size () const
+   {
+      return m_entries.size();
+   }
+
+private:
+
+   /**
+    *    Creates and keeps the entry for add().
+    */
+
+   template <typename T>
+   setting<T> make
+   (
+      const std::string & sectionname,
+      const std::string & option,
+      const T & defaultvalue
+   )
+   {
+      entry<T> * e = new entry<T>(sectionname, option, defaultvalue);
+      m_entries.push_back(e);
+      return setting<T>(&e->m_value, &e->m_found);
+   }
+
+   settings (const settings &);                 /* not copyable            */
+   settings & operator = (const settings &);    /* not assignable          */
+
+};                // class settings
+
+}                 // namespace xpc
+
+#endif            // XPC_SETTINGS_HPP
+
+/******************************************************************************
+ * settings.hpp
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *----------------------------------------------------------------------------*/
@@ -0,0 +1,195 @@
+#if ! defined XPC_STRSLICE_HPP
+#define XPC_STRSLICE_HPP
+
+/******************************************************************************
+ * strslice.hpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          strslice.hpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2014-04-23
+ * \updates       2014-04-23
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides xpc::strslice, a read-only view of a run of characters that
+ *    belong to someone else, such as a line of a memory-mapped file.  It
+ *    is the C++11 stand-in for std::string_view.
+ *
+ *    A slice is a pointer and a length, so it is cheap to pass by value
+ *    and to cut into smaller slices.  It is only valid while the text it
+ *    points into is.  The text is copied only when a std::string is
+ *    wanted, by str().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <cstring>                     /* std::memcmp()                       */
+#include <string>                      /* std::string                         */
+
+namespace xpc
+{
+
+/******************************************************************************
+ * strslice
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a pointer and a length into text owned elsewhere.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+class strslice
+{
+
+private:
+
+   /**
+    *    The first character of the slice.  Not null-terminated.
+    */
+
+   const char * m_data;
+
+   /**
+    *    The number of characters in the slice.
+    */
+
+   size_t m_size;
+
+public:
+
+   strslice ()
+    :
+      m_data   (""),
+      m_size   (0)
+   {
+      // no other code needed
+   }
+
+   strslice (const char * data, size_t size)
+    :
+      m_data   (data),
+      m_size   (size)
+   {
+      // no other code needed
+   }
+
+   strslice (const char * s)
+    :
+      m_data   (s),
+      m_size   (std::strlen(s))
+   {
+      // no other code needed
+   }
+
+   strslice (const std::string & s)
+    :
+      m_data   (s.data()),
+      m_size   (s.size())
+   {
+      // no other code needed
+   }
+
+   const char * data () const
+   {
+      return m_data;
+   }
+
+   size_t size () const
+   {
+      return m_size;
+   }
+
+   bool empty () const
+   {
+      return m_size == 0;
+   }
+
+   const char * begin () const
+   {
+      return m_data;
+   }
+
+   const char * end () const
+   {
+      return m_data + m_size;
+   }
+
+   char operator [] (size_t i) const
+   {
+      return m_data[i];
+   }
+
+   /**
+    * \return
+    *    Returns a copy of the slice.  This is the only place that the
+    *    characters are copied.
+    */
+
+   std::string str () const
+   {
+      return std::string(m_data, m_size);
+   }
+
+   /**
+    * \return
+    *    Returns the part of the slice from \a pos, at most \a count
+    *    characters long.  \a pos must not be past the end.
+    */
+
+   strslice substr (size_t pos, size_t count = std::string::npos) const
+   {
+      size_t rest = m_size - pos;
+      return strslice(m_data + pos, count < rest ? count : rest);
+   }
+
+   /**
+    * \return
+    *    Returns negative, zero, or positive, like std::string::compare().
+    */
+
+   int compare (const strslice & other) const
+   {
+      size_t n = m_size < other.m_size ? m_size : other.m_size;
+      int result = n > 0 ? std::memcmp(m_data, other.m_data, n) : 0;
+      if (result == 0)
+      {
+         if (m_size < other.m_size)
+            result = -1;
+         else if (m_size > other.m_size)
+            result = 1;
+      }
+      return result;
+   }
+
+};             /* class strslice */
+
+inline bool
+operator == (const strslice & a, const strslice & b)
+{
+   return a.size() == b.size() && a.compare(b) == 0;
+}
+
+inline bool
+operator != (const strslice & a, const strslice & b)
+{
+   return ! (a == b);
+}
+
+inline bool
+operator < (const strslice & a, const strslice & b)
+{
+   return a.compare(b) < 0;
+}
+
+}              /* namespace xpc     */
+
+#endif         /* XPC_STRSLICE_HPP */
+
+/******************************************************************************
+ * strslice.hpp
+ *----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *//*-------------------------------------------------------------------------*/
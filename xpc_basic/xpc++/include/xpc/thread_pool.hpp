@@ -0,0 +1,131 @@
+#if !defined XPC_THREAD_POOL_HPP
+#define XPC_THREAD_POOL_HPP
+
+/*******************************************************************************
+ * thread_pool.hpp
+ *-------------------------------------------------------------------------*//**
+ *
+ * \file          thread_pool.hpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \updates       2013-08-13 to 2013-08-13
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    This class wraps the C pthreader_pool_t work-stealing thread pool.
+ *
+ *    Tasks are std::function objects, and async() returns a std::future
+ *    for the result of a callable.  The destructor shuts the pool down
+ *    gracefully, running the tasks already queued.
+ *
+ *    Also see the pthreader_pool.c module.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <functional>                  /* std::function                       */
+#include <future>                      /* std::future, std::packaged_task     */
+#include <memory>                      /* std::shared_ptr                     */
+#include <xpc/macros.h>                /* XPC_REVISION macros                 */
+#include <xpc/pthreader_pool.h>        /* C::pthreader_pool_t                 */
+XPC_REVISION_DECL(thread_pool)         /* void show_thread_pool_info()        */
+
+namespace xpc
+{
+
+/*******************************************************************************
+ * thread_pool
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a fixed set of worker threads with work stealing.
+ *
+ *    A task that waits on a std::future from the same pool blocks its
+ *    worker while it waits.  Work that splits itself up should instead
+ *    submit the pieces and let the caller wait(), or use the C functions
+ *    pthreader_pool_async() and pthreader_future_wait(), which help run
+ *    tasks while waiting.
+ *
+ *-----------------------------------------------------------------------------*/
+
+class thread_pool
+{
+
+public:
+
+   /**
+    *    The type of a task.
+    */
+
+   typedef std::function<void ()> task;
+
+private:
+
+   /**
+    *    The C pool doing the work.
+    */
+
+   pthreader_pool_t m_Pool;
+
+   /**
+    *    Indicates that the pool started and has not been shut down.
+    */
+
+   bool m_Running;
+
+public:
+
+   explicit thread_pool (int workers = 0);
+   ~thread_pool ();
+
+   bool submit (const task & job);
+   void wait ();
+   void shutdown ();
+   int size () const;
+
+   /**
+    *    Queues a callable, and provides a future for its result.  If the
+    *    callable throws, the exception is rethrown by the future's get().
+    *    If the task cannot be queued, get() throws std::future_error
+    *    (broken_promise).
+    *
+    * \param func
+    *    The callable, which takes no parameters.  Use a lambda or
+    *    std::bind() to pass parameters.
+    *
+    * \return
+    *    Returns the future of the result.
+    */
+
+   template <typename F>
+   std::future<typename std::result_of<F ()>::type> async (F func)
+   {
+      typedef typename std::result_of<F ()>::type result_type;
+      std::shared_ptr< std::packaged_task<result_type ()> > job
+      (
+         new std::packaged_task<result_type ()>(func)
+      );
+      std::future<result_type> result = job->get_future();
+      (void) submit([job] () { (*job)(); });
+      return result;
+   }
+
+private:
+
+   thread_pool (const thread_pool &);              /* not copyable         */
+   thread_pool & operator = (const thread_pool &); /* not assignable       */
+
+   static void * run_task (void * job);
+
+};             /* class thread_pool */
+
+}              /* namespace xpc     */
+
+#endif         /* XPC_THREAD_POOL_HPP */
+
+/******************************************************************************
+ * thread_pool.hpp
+ *----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *//*-------------------------------------------------------------------------*/
@@ -27,6 +27,8 @@
 
 #include <xpc/errorlog_macros.h>       /* macros from the XPC library         */
 #include <xpc/errorlogging.h>          /* XPC C versions of error functions   */
+#include <xpc/atomix.h>                /* xpc_atomic_exchange(), etc.         */
+#include <xpc/file_functions.h>        /* xpc_file_rotate(), etc.             */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
 #include <xpc/portable.h>              /* xpc_get_microseconds()              */
 #include <xpc/syncher.h>               /* xpc_syncher_t structure             */
@@ -156,6 +158,9 @@ bool errorlog::gm_critex_atexit_set = false;
 errorlog::errorlog ()
  :
    m_critex_usage    (false),
+   m_critex          (),
+   m_critex_inited   (false),
+   m_critex_shared   (false),
 #ifdef XPC_NO_ERRORLOG
    m_error_level     (XPC_ERROR_LEVEL_NONE),
 #else
@@ -166,12 +171,19 @@ errorlog::errorlog ()
    m_timestamps_base (0),
    m_log_to_syslog   (false),
 #ifdef XPC_USE_COLORS
-   m_use_color       (true)
+   m_use_color       (true),
 #else
-   m_use_color       (false)
+   m_use_color       (false),
 #endif
+   m_log_name        (),
+   m_rotate_max_bytes(0),
+   m_rotate_max_age  (0),
+   m_rotate_keep     (XPC_LOG_KEEP_DEFAULT),
+   m_log_bytes       (0),
+   m_log_opened      (0),
+   m_log_rotating    (0)
 {
-   // Nothing else to do.
+   m_critex_inited = xpc_syncher_create(&m_critex, false);  /* not recursive  */
 }
 
 /******************************************************************************
@@ -192,6 +204,9 @@ errorlog::errorlog ()
 errorlog::errorlog (int argc, char * argv [])
  :
    m_critex_usage    (false),
+   m_critex          (),
+   m_critex_inited   (false),
+   m_critex_shared   (false),
 #ifdef XPC_NO_ERRORLOG
    m_error_level     (XPC_ERROR_LEVEL_NONE),
 #else
@@ -202,14 +217,40 @@ errorlog::errorlog (int argc, char * argv [])
    m_timestamps_base (0),
    m_log_to_syslog   (false),
 #ifdef XPC_USE_COLORS
-   m_use_color       (true)
+   m_use_color       (true),
 #else
-   m_use_color       (false)
+   m_use_color       (false),
 #endif
+   m_log_name        (),
+   m_rotate_max_bytes(0),
+   m_rotate_max_age  (0),
+   m_rotate_keep     (XPC_LOG_KEEP_DEFAULT),
+   m_log_bytes       (0),
+   m_log_opened      (0),
+   m_log_rotating    (0)
 {
+   m_critex_inited = xpc_syncher_create(&m_critex, false);  /* not recursive  */
    (void) parse(argc, argv);
 }
 
+/******************************************************************************
+ * Destructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Destroys this object's critex.  The log file is not closed; that is
+ *    left to close_logfile(), as before.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+errorlog::~errorlog ()
+{
+   if (m_critex_inited)
+   {
+      (void) xpc_syncher_destroy(&m_critex);                // C function
+      m_critex_inited = false;
+   }
+}
+
 /******************************************************************************
  * synch_critex() [static]
  *------------------------------------------------------------------------*//**
@@ -274,17 +315,18 @@ errorlog::synch_critex_destroy ()
 }
 
 /******************************************************************************
- * synch_lock() [static]
+ * synch_lock()
  *------------------------------------------------------------------------*//**
  *
- *    Locks the error log, using the private critex.
+ *    Locks the error log, using this object's critex, or the process-global
+ *    critex if synchshared(true) was called.
  *
  *    This function is used if activated by the "--synch" command-line
  *    option.  Its effect is to make the output much less garbled when
  *    multithreading is in force.
  *
  * \private
- *    A static member function.
+ *    A const member function.
  *
  * \return
  *    Returns 'true' if the x_syncher_t object is available, and the
@@ -298,25 +340,30 @@ errorlog::synch_critex_destroy ()
  *//*-------------------------------------------------------------------------*/
 
 bool
-errorlog::synch_lock ()
+errorlog::synch_lock () const
 {
    bool result = false;
-   if (gm_critex_inited)
-      result = xpc_syncher_enter(synch_critex()) != 0;           // C function
+   if (m_critex_shared)
+   {
+      if (gm_critex_inited)
+         result = xpc_syncher_enter(&gm_critex) != 0;           // C function
+   }
+   else if (m_critex_inited)
+      result = xpc_syncher_enter(&m_critex) != 0;               // C function
 
    return result;
 }
 
 /******************************************************************************
- * synch_unlock() [static]
+ * synch_unlock()
  *------------------------------------------------------------------------*//**
  *
- *    Flushes, and then Unlocks the output log.
+ *    Unlocks the output log, locked by synch_lock().
  *
  *    Used only if the output log synchonization option is in force.
  *
  * \private
- *    A static member function.
+ *    A const member function.
  *
  * \unittests
  *    -  TBD
@@ -324,10 +371,15 @@ errorlog::synch_lock ()
  *//*-------------------------------------------------------------------------*/
 
 void
-errorlog::synch_unlock ()
+errorlog::synch_unlock () const
 {
-   if (gm_critex_inited)
-      (void) xpc_syncher_leave(synch_critex());
+   if (m_critex_shared)
+   {
+      if (gm_critex_inited)
+         (void) xpc_syncher_leave(&gm_critex);
+   }
+   else if (m_critex_inited)
+      (void) xpc_syncher_leave(&m_critex);
 }
 
 /******************************************************************************
@@ -341,7 +393,8 @@ errorlog::synch_unlock ()
  *    in force.
  *
  *    The private variable controlling this usage is m_critex_usage.  The
- *    critex value used is gm_critex.
+ *    critex used is this object's m_critex, or gm_critex if
+ *    synchshared(true) was called.
  *
  *    This function also makes sure that synch_critex_destroy() is
  *    registered as a C atexit() handler.
@@ -371,6 +424,9 @@ errorlog::synchusage (bool flag)
 {
    bool result = true;
    m_critex_usage = flag;
+   if (flag && m_critex_shared)
+      result = not_nullptr(synch_critex());            /* create it now     */
+
    if (flag)
       warnprint(_("output synchronization enabled"));
    else
@@ -393,6 +449,46 @@ errorlog::synchusage (bool flag)
    return result;
 }
 
+/******************************************************************************
+ * synchshared()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Selects the critex used for --synch.
+ *
+ *    By default, each xpc::errorlog object locks its own critex, so that
+ *    objects that write to different files can log in parallel.  Objects
+ *    that write to the same stream (e.g. several objects left on stderr)
+ *    and need their lines kept whole can instead share the process-global
+ *    critex, which is how all objects worked in the past.
+ *
+ * \warning
+ *    Do not call this function while other threads are logging through
+ *    this object.
+ *
+ * \param flag
+ *    If 'true', the process-global critex is used.
+ *
+ * \return
+ *    Returns 'false' if the process-global critex could not be created.
+ *
+ * \unittests
+ *    -  xpcpp_unit_test_05_05()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+errorlog::synchshared (bool flag)
+{
+   bool result = true;
+   if (flag)
+      result = not_nullptr(synch_critex());
+
+   if (result)
+      m_critex_shared = flag;
+
+   return result;
+}
+
 /******************************************************************************
  * usecolor() [POSIX]
  *------------------------------------------------------------------------*//**
@@ -549,6 +645,9 @@ errorlog::logfile (FILE * logfilehandle)
  * \param logfilename
  *    Full path name to log file to be opened.
  *
+ *    The name of the file is saved, so that the file can be rotated (see
+ *    rotation()).
+ *
  * \param truncateit
  *    If true, truncate it, else append to it.
  *
@@ -577,6 +676,7 @@ errorlog::open_logfile_helper
       lf = fopen(logfilename.c_str(), truncateit ? "w+" : "a");
       if (not_NULL(lf))
       {
+         log_opened(lf, logfilename);
          if (truncateit)
             infoprint(_("log-file truncated"));
 
@@ -690,6 +790,84 @@ errorlog::append_logfile (const std::string & logfilename)
    return open_logfile_helper(logfilename, false);    /* append to log file   */
 }
 
+/******************************************************************************
+ * open_logfile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up the rotation of the log file, and then opens it, truncating
+ *    it if it exists.
+ *
+ * \param logfilename
+ *    Full path name to log file to be opened.
+ *
+ * \param maxbytes
+ *    The size, in bytes, at which to rotate the log.  Zero disables the
+ *    size check.
+ *
+ * \param maxage
+ *    The age, in seconds, at which to rotate the log.  Zero disables the
+ *    age check.
+ *
+ * \param keep
+ *    The number of old log files to keep.
+ *
+ * \return
+ *    Returns 'true' if the rotation settings were valid and the file was
+ *    opened.
+ *
+ * \unittests
+ *    -  xpcpp_unit_test_05_04()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+errorlog::open_logfile
+(
+   const std::string & logfilename,
+   size_t maxbytes,
+   long maxage,
+   int keep
+)
+{
+   bool result = rotation(maxbytes, maxage, keep);
+   if (result)
+      result = open_logfile(logfilename);
+
+   return result;
+}
+
+/******************************************************************************
+ * append_logfile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up the rotation of the log file, and then opens it for
+ *    appending.  See the open_logfile() overload with the same parameters.
+ *
+ * \return
+ *    Returns 'true' if the rotation settings were valid and the file was
+ *    opened.
+ *
+ * \unittests
+ *    -  xpcpp_unit_test_05_04()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+errorlog::append_logfile
+(
+   const std::string & logfilename,
+   size_t maxbytes,
+   long maxage,
+   int keep
+)
+{
+   bool result = rotation(maxbytes, maxage, keep);
+   if (result)
+      result = append_logfile(logfilename);
+
+   return result;
+}
+
 /******************************************************************************
  * close_logfile()
  *------------------------------------------------------------------------*//**
@@ -725,6 +903,253 @@ errorlog::close_logfile ()
       (void) usecolor(true);        /* do not use the return value here */
    }
    (void) logfile(stderr);
+   log_opened(NULLptr, std::string());          /* nothing left to rotate  */
+   return result;
+}
+
+/******************************************************************************
+ * rotation()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up the rotation of the log file.
+ *
+ *    This function works like the C function xpc_logrotation_set().  The
+ *    log file, if opened by name, is rotated when it reaches a given size,
+ *    or a given age, or both.  The current file is renamed to "name.1",
+ *    older files are renamed to "name.2", "name.3", and so on, and the
+ *    oldest is deleted.  Then a new file is opened.  If rotation by size
+ *    is enabled, disk space for the whole file is reserved when it is
+ *    opened.
+ *
+ *    The --log-max-bytes, --log-max-age, and --log-keep options make the
+ *    same settings.
+ *
+ * \warning
+ *    A multi-threaded application must also use --synch, so that no thread
+ *    is writing to the old file when it is closed.
+ *
+ * \param maxbytes
+ *    The size, in bytes, at which to rotate the log.  Zero disables the
+ *    size check.
+ *
+ * \param maxage
+ *    The age, in seconds, at which to rotate the log.  Zero disables the
+ *    age check.
+ *
+ * \param keep
+ *    The number of old log files to keep.  If zero, the log file is simply
+ *    started over when it is rotated.
+ *
+ * \return
+ *    Returns 'true' if the parameters were valid.  Otherwise, the settings
+ *    are not changed, and 'false' is returned.
+ *
+ * \unittests
+ *    -  xpcpp_unit_test_05_04()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+errorlog::rotation (size_t maxbytes, long maxage, int keep)
+{
+   bool result = (maxage >= 0) && (keep >= 0) && (keep <= XPC_LOG_KEEP_MAX);
+   if (result)
+   {
+      m_rotate_max_bytes = maxbytes;
+      m_rotate_max_age = maxage;
+      m_rotate_keep = keep;
+      if (! m_log_name.empty() && (maxbytes > 0))
+         (void) xpc_file_preallocate(m_log_file, maxbytes);
+   }
+   else
+      ERRPRINT_FUNC(_("invalid log-rotation setting"));
+
+   return result;
+}
+
+/******************************************************************************
+ * rotate_logfile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Rotates the log file right now, whatever its size or age, using the
+ *    "keep" setting made by rotation().
+ *
+ * \return
+ *    Returns 'true' if the log file was rotated.  Returns 'false' if the
+ *    log is not a named file, or the rotation failed.
+ *
+ * \unittests
+ *    -  xpcpp_unit_test_05_04()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+errorlog::rotate_logfile ()
+{
+   return log_rotate();
+}
+
+/******************************************************************************
+ * log_opened()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Records the name and the current size of a newly-opened log file,
+ *    and the time it was opened.  If rotation by size is enabled, disk
+ *    space for the whole file is reserved.
+ *
+ * \param logfilehandle
+ *    The newly-opened log file.  If null, the name is forgotten, and the
+ *    log will not be rotated.
+ *
+ * \param logfilename
+ *    The name of the log file.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+errorlog::log_opened (FILE * logfilehandle, const std::string & logfilename)
+{
+   m_log_name.clear();
+   m_log_bytes = 0;
+   m_log_opened = time(NULL);
+   if (not_NULL(logfilehandle))
+   {
+      m_log_name = logfilename;
+      if (fseek(logfilehandle, 0, SEEK_END) == 0)
+      {
+         long size = ftell(logfilehandle);
+         if (size > 0)
+            m_log_bytes = size_t(size);
+      }
+      if (m_rotate_max_bytes > 0)
+         (void) xpc_file_preallocate(logfilehandle, m_rotate_max_bytes);
+   }
+}
+
+/******************************************************************************
+ * log_rotate()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Rotates the log file.
+ *
+ *    The backups are renamed, and the log file becomes "name.1", while it
+ *    is still open.  Then a new file of the same name is opened, and the
+ *    --synch lock is taken only long enough to swap the file handles.  If
+ *    the rotation fails, the counters are reset anyway, so that it is not
+ *    retried on every line.
+ *
+ * \return
+ *    Returns 'true' if the log file was rotated.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+errorlog::log_rotate () const
+{
+   bool result = false;
+   if (! m_log_name.empty() && ! xpc_atomic_exchange(&m_log_rotating, 1))
+   {
+      FILE * oldfile = m_log_file;
+      FILE * newfile = NULLptr;
+      fflush(oldfile);
+      if (xpc_file_rotate(m_log_name.c_str(), m_rotate_keep))
+         newfile = fopen(m_log_name.c_str(), "a");
+
+      if (not_NULL(newfile))
+      {
+         if (m_rotate_max_bytes > 0)
+            (void) xpc_file_preallocate(newfile, m_rotate_max_bytes);
+
+         result = ! m_critex_usage || synch_lock();
+         if (result)
+         {
+            m_log_file = newfile;
+            if (m_critex_usage)
+               synch_unlock();
+
+            fclose(oldfile);
+         }
+         else
+            fclose(newfile);
+      }
+      xpc_atomic_store_relaxed(&m_log_bytes, 0);
+      m_log_opened = time(NULL);
+      xpc_atomic_store(&m_log_rotating, 0);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * log_written()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Counts the bytes written to the log file, and rotates the file if it
+ *    has become too big or too old.  If rotation is not enabled, it does
+ *    nothing.
+ *
+ * \param count
+ *    The number of bytes just written, as returned by fprintf().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+errorlog::log_written (int count) const
+{
+   if ((count > 0) && ((m_rotate_max_bytes > 0) || (m_rotate_max_age > 0)))
+   {
+      size_t total = xpc_atomic_add_relaxed(&m_log_bytes, size_t(count));
+      bool due = (m_rotate_max_bytes > 0) &&
+         (total + size_t(count) >= m_rotate_max_bytes);
+
+      if (! due && (m_rotate_max_age > 0))
+         due = (time(NULL) - m_log_opened) >= m_rotate_max_age;
+
+      if (due)
+         (void) log_rotate();
+   }
+}
+
+/******************************************************************************
+ * rotation_option()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Handles the --log-max-bytes, --log-max-age, and --log-keep options.
+ *    The settings not named by the option are left as they are.
+ *
+ * \param option
+ *    The option, including the "--".
+ *
+ * \param value
+ *    The option's value, which must be a non-negative integer.
+ *
+ * \return
+ *    Returns 'true' if the value was valid.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+errorlog::rotation_option (const std::string & option, const char * value)
+{
+   char * endptr;
+   long number = strtol(value, &endptr, 10);
+   bool result = (endptr != value) && (*endptr == 0) && (number >= 0);
+   if (result)
+   {
+      size_t maxbytes = m_rotate_max_bytes;
+      long maxage = m_rotate_max_age;
+      int keep = m_rotate_keep;
+      if (option == CMDSTRING(_LOG_MAX_BYTES))
+         maxbytes = size_t(number);
+      else if (option == CMDSTRING(_LOG_MAX_AGE))
+         maxage = number;
+      else
+         keep = (number > XPC_LOG_KEEP_MAX) ? (-1) : int(number);
+
+      result = rotation(maxbytes, maxage, keep);
+   }
+   else
+      errprintf("%s: %s '%s'", option.c_str(), _("invalid number"), value);
+
    return result;
 }
 
@@ -956,6 +1381,22 @@ errorlog::parse_nohelp (int argc, char * argv [])
                   break;
                }
             }
+            else if
+            (
+               (arg == CMDSTRING(_LOG_MAX_BYTES)) ||
+               (arg == CMDSTRING(_LOG_MAX_AGE)) ||
+               (arg == CMDSTRING(_LOG_KEEP))
+            )
+            {
+               if ((argi+1) < argc)
+                  result = rotation_option(arg, argv[argi+1]);
+               else
+               {
+                  errprintf("%s %s", arg.c_str(), _("requires a number"));
+                  result = false;
+                  break;
+               }
+            }
             else if (arg == CMDSTRING(_SYSLOG))
             {
                infoprint(_("setting system logging"));
@@ -1423,7 +1864,9 @@ errorlog::get_priority (xpc_errlevel_t errlev)
  *    A single-character tag string (e.g. "?").
  *
  * \param errmsg
- *    The error or info message to be logged.
+ *    The error or info message to be logged.  It is a plain C string, so
+ *    that neither the const char * overloads of the print functions nor
+ *    the logstream class need to build a std::string.
  *
  * \todo
  *    Support for Windows Event Log.  For now, only the normal error-log is
@@ -1438,10 +1881,13 @@ void
 errorlog::msgtag
 (
    xpc_errlevel_t errlev,
-   const std::string & tag,
-   const std::string & errmsg
+   const char * tag,
+   const char * errmsg
 ) const
 {
+   if (is_NULL(errmsg))                               /* programmer goofed    */
+      errmsg = _("missing error message");
+
    if (xpc_errlevel() > XPC_ERROR_LEVEL_NONE)
    {
       if (m_log_to_syslog)
@@ -1451,7 +1897,7 @@ errorlog::msgtag
 #ifdef POSIX
          syslog
          (
-            priority, _(ERRL_FMT_BASIC_MESSAGE), tag.c_str(), errmsg.c_str()
+            priority, _(ERRL_FMT_BASIC_MESSAGE), tag, errmsg
          );
 #else
          fprintf
@@ -1468,6 +1914,7 @@ errorlog::msgtag
       {
          if (! m_critex_usage || synch_lock())  /* --synch              */
          {
+            int count;
             if (timestamps())
             {
                time_t seconds;
@@ -1479,21 +1926,24 @@ errorlog::msgtag
                if (m_timestamps_base > 0)
                   seconds -= m_timestamps_base;
 
-               fprintf
+               count = fprintf
                (
-                  logfile(), ERRL_FMT_TIMESTAMP_MESSAGE, tag.c_str(),
-                  (int) seconds, (int) microseconds, errmsg.c_str()
+                  logfile(), ERRL_FMT_TIMESTAMP_MESSAGE, tag,
+                  (int) seconds, (int) microseconds * 1000, errmsg
                );
             }
             else
             {
-               fprintf
+               count = fprintf
                (
-                  logfile(), ERRL_FMT_BASIC_MESSAGE, tag.c_str(), errmsg.c_str()
+                  logfile(), ERRL_FMT_BASIC_MESSAGE, tag, errmsg
                );
             }
             fflush(logfile());
-            synch_unlock();
+            if (m_critex_usage)
+               synch_unlock();
+
+            log_written(count);
          }
       }
    }
@@ -1556,10 +2006,11 @@ errorlog::va_tag
       else
       {
          FILE * fp = logfile();
-         fprintf(fp, "%s ", tag.c_str());
-         vfprintf(fp, fmt.c_str(), val);
-         fprintf(fp, "\n");                  /* consistent w/other calls   */
+         int count = fprintf(fp, "%s ", tag.c_str());
+         count += vfprintf(fp, fmt.c_str(), val);
+         count += fprintf(fp, "\n");         /* consistent w/other calls   */
          fflush(fp);
+         log_written(count);
       }
    }
 }
@@ -1616,7 +2067,7 @@ errorlog::va_msgtag
             n = vsnprintf(p, size, fmt, val);
             if ((n > -1) && (n < size))            /* it worked            */
             {
-               msgtag(errlev, tag, p);
+               msgtag(errlev, tag.c_str(), p);
                free(p);
                break;
             }
@@ -1668,7 +2119,7 @@ errorlog::va_msgtag
 #ifndef XPC_NO_ERRORLOG
 
 void
-errorlog::errprint (const std::string & errmsg) const
+errorlog::errprint (const char * errmsg) const
 {
    if (showerrors())
    {
@@ -1873,7 +2324,7 @@ errorlog::errprintex
 #ifndef XPC_NO_ERRORLOG
 
 void
-errorlog::warnprint (const std::string & warnmsg) const
+errorlog::warnprint (const char * warnmsg) const
 {
    if (showwarnings())
    {
@@ -1995,7 +2446,7 @@ errorlog::warnprintex
 #ifndef XPC_NO_ERRORLOG
 
 void
-errorlog::infoprint (const std::string & infomsg) const
+errorlog::infoprint (const char * infomsg) const
 {
    if (showinfo())
    {
@@ -2344,7 +2795,7 @@ errorlog::dbginfoprint (const std::string & infomsg) const
       (
          XPC_ERROR_LEVEL_INFO,
          usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG,
-         infomsg
+         infomsg.c_str()
       );
    }
 }
@@ -2481,7 +2932,7 @@ errorlog::print (const std::string & infomsg) const
    (
       XPC_ERROR_LEVEL_INFO,
       usecolor() ? COLOR_STR_PRINT : ERRL_STR_PRINT,
-      infomsg
+      infomsg.c_str()
    );
 }
 
@@ -2518,9 +2969,12 @@ errorlog::lkprintf (const std::string & fmt, ...) const
       va_start(val, fmt);
       if (! m_critex_usage || synch_lock())
       {
-         vfprintf(logfile(), fmt.c_str(), val);
+         int count = vfprintf(logfile(), fmt.c_str(), val);
          fflush(logfile());
-         synch_unlock();
+         if (m_critex_usage)
+            synch_unlock();
+
+         log_written(count);
       }
       va_end(val);
    }
@@ -3089,6 +3543,332 @@ errorlog::flush_error_log () const
    fflush(logfile());
 }
 
+/******************************************************************************
+ * error(), warn(), info(), and debug()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Start a stream-style log line.  See the logstream class.
+ *
+\verbatim
+      log.warn() << "retrying " << host << " in " << delay << " ms";
+\endverbatim
+ *
+ *    The error level is checked here, so that the << operators of a line
+ *    that is not shown do nothing.  The debug() line is also inactive if
+ *    the code is not compiled for debugging.
+ *
+ * \return
+ *    Returns the logstream, which logs its line when it is destroyed.
+ *
+ * \unittests
+ *    -  xpcpp_unit_test_05_06()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+logstream
+errorlog::error () const
+{
+   return logstream
+   (
+      showerrors() ? this : nullptr, XPC_ERROR_LEVEL_ERRORS,
+      usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR
+   );
+}
+
+logstream
+errorlog::warn () const
+{
+   return logstream
+   (
+      showwarnings() ? this : nullptr, XPC_ERROR_LEVEL_WARNINGS,
+      usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN
+   );
+}
+
+logstream
+errorlog::info () const
+{
+   return logstream
+   (
+      showinfo() ? this : nullptr, XPC_ERROR_LEVEL_INFO,
+      usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO
+   );
+}
+
+logstream
+errorlog::debug () const
+{
+   return logstream
+   (
+      showdebug() ? this : nullptr, XPC_ERROR_LEVEL_INFO,
+      usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG
+   );
+}
+
+/******************************************************************************
+ * logstream buffers
+ *------------------------------------------------------------------------*//**
+ *
+ *    Each thread has XPC_LOGSTREAM_DEPTH line buffers, so that a line can
+ *    be built while another line of the same thread is still being built.
+ *    A bit of gs_logstream_busy marks each buffer in use.  A line keeps the
+ *    index of its buffer and frees exactly that one, so the lines need not
+ *    be finished in the reverse order of their creation.  A line that
+ *    finds no free buffer is inactive.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc_thread_local char
+gs_logstream_buffers[XPC_LOGSTREAM_DEPTH][XPC_LOGSTREAM_SIZE];
+
+static xpc_thread_local unsigned gs_logstream_busy = 0;
+
+/******************************************************************************
+ * logstream()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates a log line, normally through errorlog::error() and the like.
+ *
+ * \param log
+ *    The object that will write the line.  If null, the line is inactive.
+ *
+ * \param level
+ *    The error level of the line.
+ *
+ * \param tag
+ *    The tag of the line.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+logstream::logstream
+(
+   const errorlog * log,
+   xpc_errlevel_t level,
+   const char * tag
+) :
+   m_log       (log),
+   m_level     (level),
+   m_tag       (tag),
+   m_text      (nullptr),
+   m_length    (0),
+   m_slot      (-1)
+{
+   if (not_NULL(m_log))
+   {
+      for (int slot = 0; slot < XPC_LOGSTREAM_DEPTH; ++slot)
+      {
+         if ((gs_logstream_busy & (1u << slot)) == 0)
+         {
+            gs_logstream_busy |= 1u << slot;
+            m_slot = slot;
+            m_text = gs_logstream_buffers[slot];
+            break;
+         }
+      }
+      if (is_NULL(m_text))
+         m_log = nullptr;                          /* nested too deeply    */
+   }
+}
+
+/******************************************************************************
+ * logstream() [move]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Takes over the line of another logstream, which is left inactive.
+ *    This lets the line be returned by value from errorlog::info() and the
+ *    like.
+ *
+ * \param source
+ *    The logstream whose line is taken.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+logstream::logstream (logstream && source) :
+   m_log       (source.m_log),
+   m_level     (source.m_level),
+   m_tag       (source.m_tag),
+   m_text      (source.m_text),
+   m_length    (source.m_length),
+   m_slot      (source.m_slot)
+{
+   source.m_log = nullptr;
+   source.m_text = nullptr;
+   source.m_slot = -1;
+}
+
+/******************************************************************************
+ * ~logstream()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs the finished line, if active, and frees the buffer of the line.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+logstream::~logstream ()
+{
+   if (not_NULL(m_text))
+   {
+      m_text[m_length] = 0;
+      m_log->msgtag(m_level, m_tag, m_text);
+      gs_logstream_busy &= ~(1u << m_slot);
+   }
+}
+
+/******************************************************************************
+ * append()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds text to the line, as far as it fits.
+ *
+ * \param text
+ *    The text, which need not be null-terminated.
+ *
+ * \param length
+ *    The number of characters to add.
+ *
+ * \return
+ *    Returns a reference to this object, for chaining.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+logstream &
+logstream::append (const char * text, size_t length)
+{
+   if (not_NULL(m_text) && not_NULL(text))
+   {
+      size_t room = XPC_LOGSTREAM_SIZE - 1 - m_length;
+      if (length > room)
+         length = room;
+
+      memcpy(m_text + m_length, text, length);
+      m_length += length;
+   }
+   return *this;
+}
+
+/******************************************************************************
+ * format() [private]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds a printf()-formatted value to the line, as far as it fits.  Used
+ *    by the << operators for numbers.
+ *
+ * \param fmt
+ *    The format of the value.
+ *
+ * \return
+ *    Returns a reference to this object, for chaining.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+logstream &
+logstream::format (const char * fmt, ...)
+{
+   if (not_NULL(m_text))
+   {
+      size_t room = XPC_LOGSTREAM_SIZE - m_length;
+      va_list val;
+      va_start(val, fmt);
+      int count = vsnprintf(m_text + m_length, room, fmt, val);
+      va_end(val);
+      if (count > 0)
+         m_length += (size_t(count) < room) ? size_t(count) : room - 1;
+   }
+   return *this;
+}
+
+/******************************************************************************
+ * operator <<
+ *------------------------------------------------------------------------*//**
+ *
+ *    Add a value to the line.  Each does nothing if the line is inactive.
+ *
+ *    A null C string adds nothing.  A bool adds "true" or "false".  A
+ *    double is written with "%g", and a pointer with "%p".
+ *
+ * \return
+ *    Each returns a reference to this object, for chaining.
+ *
+ * \unittests
+ *    -  xpcpp_unit_test_05_06()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+logstream &
+logstream::operator << (const char * text)
+{
+   if (not_NULL(m_text) && not_NULL(text))
+      (void) append(text, strlen(text));
+
+   return *this;
+}
+
+logstream &
+logstream::operator << (const std::string & text)
+{
+   return append(text.data(), text.size());
+}
+
+logstream &
+logstream::operator << (char c)
+{
+   return append(&c, 1);
+}
+
+logstream &
+logstream::operator << (bool flag)
+{
+   return flag ? append("true", 4) : append("false", 5);
+}
+
+logstream &
+logstream::operator << (int value)
+{
+   return format("%d", value);
+}
+
+logstream &
+logstream::operator << (unsigned value)
+{
+   return format("%u", value);
+}
+
+logstream &
+logstream::operator << (long value)
+{
+   return format("%ld", value);
+}
+
+logstream &
+logstream::operator << (unsigned long value)
+{
+   return format("%lu", value);
+}
+
+logstream &
+logstream::operator << (long long value)
+{
+   return format("%lld", value);
+}
+
+logstream &
+logstream::operator << (unsigned long long value)
+{
+   return format("%llu", value);
+}
+
+logstream &
+logstream::operator << (double value)
+{
+   return format("%g", value);
+}
+
+logstream &
+logstream::operator << (const void * pointer)
+{
+   return format("%p", pointer);
+}
+
 }              // namespace xpc
 
 /******************************************************************************
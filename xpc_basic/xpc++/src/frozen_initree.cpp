@@ -0,0 +1,412 @@
+/******************************************************************************
+ * frozen_initree.cpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          frozen_initree.cpp
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \date          2014-04-24
+ * \updates       2014-04-24
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides the building and the lookups of xpc::frozen_initree.
+ *
+ *    The hash is 32-bit FNV-1a, finished with the MurmurHash3 mixer so
+ *    that the low bits, which pick the slot, depend on every input byte.
+ *    An option is hashed together with its section number, so that one
+ *    table serves every section.  Collisions are resolved by linear
+ *    probing; with the tables at most half full, a lookup reads one or
+ *    two adjacent slots.
+ *
+ *    Offsets and counts are 32-bit, which limits a frozen tree to 4 GB of
+ *    text.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* C::xpc_errprint_func(), etc.        */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/frozen_initree.hpp>      /* xpc::frozen_initree                 */
+XPC_REVISION(frozen_initree)
+
+namespace xpc
+{
+
+/******************************************************************************
+ * frozen_initree::npos
+ *------------------------------------------------------------------------*//**
+ *
+ *    The definition that goes with the in-class initializer.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+const uint32_t frozen_initree::npos;
+
+/******************************************************************************
+ * hash_mix() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the value with its bits avalanched (MurmurHash3 fmix32).
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static inline uint32_t
+hash_mix (uint32_t h)
+{
+   h ^= h >> 16;
+   h *= 0x85EBCA6Bu;
+   h ^= h >> 13;
+   h *= 0xC2B2AE35u;
+   h ^= h >> 16;
+   return h;
+}
+
+/******************************************************************************
+ * hash_text() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the FNV-1a hash of the text, started from the given seed.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static inline uint32_t
+hash_text (const strslice & s, uint32_t seed)
+{
+   uint32_t h = 2166136261u ^ seed;
+   for (const char * p = s.begin(); p != s.end(); ++p)
+   {
+      h ^= static_cast<unsigned char>(*p);
+      h *= 16777619u;
+   }
+   return hash_mix(h);
+}
+
+/******************************************************************************
+ * table_size() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the smallest power of 2 that is at least twice the count.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static size_t
+table_size (size_t count)
+{
+   size_t result = 2;
+   while (result < 2 * count)
+      result *= 2;
+
+   return result;
+}
+
+/******************************************************************************
+ * Default constructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates an empty frozen_initree, which has no sections at all (not
+ *    even the unnamed one).  Use freeze() to fill it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+frozen_initree::frozen_initree ()
+ :
+   m_pool            (),
+   m_sections        (),
+   m_options         (),
+   m_section_slots   (),
+   m_option_slots    ()
+{
+   // no other code needed
+}
+
+/******************************************************************************
+ * Principal constructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates the frozen copy of an initree.
+ *
+ * \param source
+ *    The initree to copy.  It is not needed afterward.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+frozen_initree::frozen_initree (const initree & source)
+ :
+   m_pool            (),
+   m_sections        (),
+   m_options         (),
+   m_section_slots   (),
+   m_option_slots    ()
+{
+   freeze(source);
+}
+
+/******************************************************************************
+ * freeze()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Replaces the contents with a copy of an initree.  This is the only
+ *    function that allocates, and it allocates each array exactly once.
+ *
+ *    Handles taken from the old contents must not be used afterward.
+ *
+ * \param source
+ *    The initree to copy.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+frozen_initree::freeze (const initree & source)
+{
+   size_t poolsize = 0;
+   size_t optioncount = 0;
+   initree::const_iterator si;
+   initree::Section::const_iterator oi;
+   for (si = source.begin(); si != source.end(); ++si)
+   {
+      poolsize += si->first.size() + 1;
+      optioncount += si->second.size();
+      for (oi = si->second.begin(); oi != si->second.end(); ++oi)
+         poolsize += oi->first.size() + oi->second.size() + 2;
+   }
+   m_pool.clear();
+   m_sections.clear();
+   m_options.clear();
+   m_section_slots.clear();
+   m_option_slots.clear();
+   if (poolsize >= size_t(npos) || optioncount >= size_t(npos))
+   {
+      xpc_errprint_func(_("initree too large to freeze"));
+   }
+   else
+   {
+      slot empty = { 0, npos };
+      m_pool.reserve(poolsize);
+      m_sections.reserve(source.size());
+      m_options.reserve(optioncount);
+      m_section_slots.assign(table_size(source.size()), empty);
+      m_option_slots.assign(table_size(optioncount), empty);
+
+      size_t smask = m_section_slots.size() - 1;
+      size_t omask = m_option_slots.size() - 1;
+      for (si = source.begin(); si != source.end(); ++si)
+      {
+         uint32_t sindex = uint32_t(m_sections.size());
+         section_entry se;
+         se.m_name = intern(si->first);
+         se.m_name_length = uint32_t(si->first.size());
+         se.m_first = uint32_t(m_options.size());
+         se.m_count = uint32_t(si->second.size());
+         m_sections.push_back(se);
+
+         uint32_t h = hash_text(si->first, 0);
+         size_t i = h & smask;
+         while (m_section_slots[i].m_index != npos)
+            i = (i + 1) & smask;
+
+         m_section_slots[i].m_hash = h;
+         m_section_slots[i].m_index = sindex;
+         for (oi = si->second.begin(); oi != si->second.end(); ++oi)
+         {
+            option_entry oe;
+            oe.m_name = intern(oi->first);
+            oe.m_name_length = uint32_t(oi->first.size());
+            oe.m_value = intern(oi->second);
+            oe.m_value_length = uint32_t(oi->second.size());
+
+            h = hash_text(oi->first, sindex);
+            i = h & omask;
+            while (m_option_slots[i].m_index != npos)
+               i = (i + 1) & omask;
+
+            m_option_slots[i].m_hash = h;
+            m_option_slots[i].m_index = uint32_t(m_options.size());
+            m_options.push_back(oe);
+         }
+      }
+   }
+}
+
+/******************************************************************************
+ * intern()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Appends a string and its null to the pool.  Equal strings are not
+ *    shared; the option names are mostly distinct anyway, and the values
+ *    would need a second table.
+ *
+ * \return
+ *    Returns the offset of the string in the pool.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint32_t
+frozen_initree::intern (const std::string & s)
+{
+   uint32_t result = uint32_t(m_pool.size());
+   m_pool.append(s.c_str(), s.size() + 1);
+   return result;
+}
+
+/******************************************************************************
+ * find_section()
+ *------------------------------------------------------------------------*//**
+ *
+ * \param sectionname
+ *    The name to look up.
+ *
+ * \return
+ *    Returns the index of the section, or npos if there is no such
+ *    section.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint32_t
+frozen_initree::find_section (const strslice & sectionname) const
+{
+   uint32_t result = npos;
+   if (! m_section_slots.empty())
+   {
+      uint32_t h = hash_text(sectionname, 0);
+      size_t mask = m_section_slots.size() - 1;
+      for (size_t i = h & mask; m_section_slots[i].m_index != npos; )
+      {
+         const slot & s = m_section_slots[i];
+         if (s.m_hash == h)
+         {
+            const section_entry & se = m_sections[s.m_index];
+            if (pooled(se.m_name, se.m_name_length) == sectionname)
+            {
+               result = s.m_index;
+               break;
+            }
+         }
+         i = (i + 1) & mask;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * find_option()
+ *------------------------------------------------------------------------*//**
+ *
+ * \param sectionindex
+ *    The section to look in, as returned by find_section().  If npos, the
+ *    option is not found.
+ *
+ * \param option
+ *    The option name to look up.
+ *
+ * \return
+ *    Returns the index of the option, or npos if the section does not
+ *    have it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint32_t
+frozen_initree::find_option
+(
+   uint32_t sectionindex,
+   const strslice & option
+) const
+{
+   uint32_t result = npos;
+   if (sectionindex < m_sections.size())
+   {
+      const section_entry & se = m_sections[sectionindex];
+      uint32_t h = hash_text(option, sectionindex);
+      size_t mask = m_option_slots.size() - 1;
+      for (size_t i = h & mask; m_option_slots[i].m_index != npos; )
+      {
+         const slot & s = m_option_slots[i];
+         if
+         (
+            s.m_hash == h &&
+            s.m_index - se.m_first < se.m_count    /* in this section?   */
+         )
+         {
+            const option_entry & oe = m_options[s.m_index];
+            if (pooled(oe.m_name, oe.m_name_length) == option)
+            {
+               result = s.m_index;
+               break;
+            }
+         }
+         i = (i + 1) & mask;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * section_name()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the name of a section, or an empty slice for npos.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+strslice
+frozen_initree::section_name (uint32_t sectionindex) const
+{
+   strslice result;
+   if (sectionindex < m_sections.size())
+   {
+      const section_entry & se = m_sections[sectionindex];
+      result = pooled(se.m_name, se.m_name_length);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * section_size()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the number of options in a section, or 0 for npos.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+frozen_initree::section_size (uint32_t sectionindex) const
+{
+   return sectionindex < m_sections.size() ?
+      size_t(m_sections[sectionindex].m_count) : 0 ;
+}
+
+/******************************************************************************
+ * option_value()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the value of an option, or an empty slice for npos.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+strslice
+frozen_initree::option_value (uint32_t optionindex) const
+{
+   strslice result;
+   if (optionindex < m_options.size())
+   {
+      const option_entry & oe = m_options[optionindex];
+      result = pooled(oe.m_value, oe.m_value_length);
+   }
+   return result;
+}
+
+}                 // namespace xpc
+
+/******************************************************************************
+ * frozen_initree.cpp
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *----------------------------------------------------------------------------*/
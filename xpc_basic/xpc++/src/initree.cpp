@@ -6,7 +6,7 @@
  * \library       xpc_suite
  * \author        Chris Ahlstrom
  * \date          2014-04-20
- * \updates       2014-04-22
+ * \updates       2014-04-23
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
@@ -37,12 +37,23 @@
  *       option line.  See the tests/initree.ini file.
  *    -# Comments are not saved anywhere, so when we get around to writing
  *       out an INI file, they will get dropped.
+ *    -# The stream reader drops a last line that has no newline; the
+ *       mapped reader does not.  The mapped reader also takes a line that
+ *       holds only a carriage-return (DOS line-ending) as blank.
  *
  *//*-------------------------------------------------------------------------*/
 
 #include <cctype>                      /* toupper(), isalpha(), etc. macros   */
+#include <cstring>                     /* std::memchr()                       */
 #include <fstream>
 
+#if ! defined _MSC_VER
+#include <fcntl.h>                     /* open() and O_RDONLY                 */
+#include <sys/mman.h>                  /* mmap(), madvise(), and munmap()     */
+#include <sys/stat.h>                  /* fstat()                             */
+#include <unistd.h>                    /* close()                             */
+#endif
+
 #include <xpc/errorlogging.h>          /* error-reporting and XPC macros      */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
 #include <xpc/initree.hpp>             /* the functions in this module        */
@@ -214,6 +225,33 @@ initree::operator = (const initree & source)
  *    Opens a file, and tries to construct an initree object, and a number
  *    of section objects, in it.
  *
+ *    Both modes accept the same syntax (see read_stream()) and build the
+ *    same tree.  The mapped mode is the one to use for large files.
+ *
+ * \param filespec
+ *    Provides the full path to the file to be processed.
+ *
+ * \param mode
+ *    INITREE_STREAM reads the file with read_stream(), and INITREE_MAPPED
+ *    with read_mapped().
+ *
+ * \return
+ *    Returns 'true' if any legal option was found, and 'false' if anything
+ *    bad was found.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+initree::readfile (const std::string & filespec, readmode mode)
+{
+   return mode == INITREE_MAPPED ?
+      read_mapped(filespec) : read_stream(filespec) ;
+}
+
+/******************************************************************************
+ * read_stream()
+ *------------------------------------------------------------------------*//**
+ *
  *    This function reads a file line by line.
  *
  *       -  Blank lines are skipped.
@@ -240,7 +278,7 @@ initree::operator = (const initree & source)
  *//*-------------------------------------------------------------------------*/
 
 bool
-initree::readfile (const std::string & filespec)
+initree::read_stream (const std::string & filespec)
 {
    std::ifstream input(filespec.c_str());
    bool result = input.good();
@@ -307,6 +345,227 @@ initree::readfile (const std::string & filespec)
    return result;
 }
 
+/******************************************************************************
+ * read_mapped()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Maps a file into memory and hands the whole mapping to parse().  The
+ *    mapping is private and read-only, and is dropped before returning,
+ *    since everything kept in the tree has been copied out of it.
+ *
+ *    An empty file, or one that cannot be mapped (a pipe, say), is read
+ *    with read_stream() instead.
+ *
+ * \param filespec
+ *    Provides the full path to the file to be processed.
+ *
+ * \return
+ *    Returns 'true' if any legal option was found, and 'false' if anything
+ *    bad was found.
+ *
+ * \win32
+ *    Not yet supported; the file is always read with read_stream().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+initree::read_mapped (const std::string & filespec)
+{
+   bool result = false;
+   bool mapped = false;
+#if ! defined _MSC_VER
+   int fd = open(filespec.c_str(), O_RDONLY);
+   if (fd >= 0)
+   {
+      struct stat info;
+      if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+      {
+         size_t length = size_t(info.st_size);
+         void * map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (map != MAP_FAILED)
+         {
+            (void) madvise(map, length, MADV_SEQUENTIAL);
+            result = parse(static_cast<const char *>(map), length);
+            mapped = true;
+            (void) munmap(map, length);
+         }
+      }
+      (void) close(fd);
+   }
+#endif
+   if (! mapped)
+      result = read_stream(filespec);
+
+   return result;
+}
+
+/******************************************************************************
+ * parse()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Parses the text of a whole INI file in one pass, for read_mapped().
+ *
+ *    The rules are those of read_stream(), process_section_name(), and
+ *    process_option(), but instead of copying each line and then
+ *    searching it again for each token, a pointer walks the text once.
+ *    The first character of a line decides what the line is; blank and
+ *    comment lines are skipped with memchr(), and an option line is
+ *    scanned once for its "=" and its first and last double-quotes.  The
+ *    section names, options, and values are slices of the text, and the
+ *    only copies made are of the names and values put into the tree.
+ *
+ * \param text
+ *    Provides the text, which need not be null-terminated.
+ *
+ * \param length
+ *    Provides the number of characters in the text.
+ *
+ * \return
+ *    Returns 'true' if the text was all legal, and 'false' at the first
+ *    line that was not.  The lines before that one are still in the tree.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+initree::parse (const char * text, size_t length)
+{
+   bool result = true;
+   const char * p = text;
+   const char * const textend = text + length;
+   iterator current = find(std::string(""));
+   while (result && p < textend)
+   {
+      while (p < textend && (*p == ' ' || *p == '\t'))
+         p++;
+
+      const char * eol = static_cast<const char *>
+      (
+         std::memchr(p, '\n', length - size_t(p - text))
+      );
+      if (is_NULL(eol))
+         eol = textend;
+
+      char c = p < eol ? *p : '\n';
+      if (c == '\n' || c == '\r' || is_comment(c))
+      {
+         // a blank or comment line, skip it
+      }
+      else if (c == '[')
+      {
+         /*
+          * The name starts with a letter after the optional spaces, and
+          * ends before the spaces that precede the ']'.
+          */
+
+         const char * pbegin = p + 1;
+         while (pbegin < eol && (*pbegin == ' ' || *pbegin == '\t'))
+            pbegin++;
+
+         const char * prbracket = NULL;
+         if (pbegin < eol && isalpha(static_cast<unsigned char>(*pbegin)))
+         {
+            const char * q = pbegin + 1;
+            while (q < eol && *q != ']')
+               q++;
+
+            if (q < eol)
+               prbracket = q;
+         }
+         result = not_NULL(prbracket);
+         if (result)
+         {
+            const char * pend = prbracket;
+            while (pend[-1] == ' ' || pend[-1] == '\t')
+               pend--;
+
+            std::string sectionname = strslice(pbegin, pend - pbegin).str();
+            result = make_section(sectionname);
+            if (result)
+               current = find(sectionname);
+         }
+      }
+      else if (isalpha(static_cast<unsigned char>(c)))
+      {
+         const char * q = p;
+         while
+         (
+            q < eol &&
+            (
+               isalnum(static_cast<unsigned char>(*q)) ||
+               *q == '_' || *q == '-'
+            )
+         )
+         {
+            q++;
+         }
+
+         strslice option(p, q - p);
+         strslice value;
+         const char * pequals = NULL;
+         const char * pquote1 = NULL;
+         const char * pquote2 = NULL;
+         for ( ; q < eol; q++)
+         {
+            if (*q == '=')
+            {
+               if (is_NULL(pequals))
+                  pequals = q;
+            }
+            else if (*q == '"')
+            {
+               if (is_NULL(pquote1))
+                  pquote1 = q;
+
+               pquote2 = q;
+            }
+         }
+         if (not_NULL(pequals))
+         {
+            if (not_NULL(pquote1))
+            {
+               result = pquote2 > pquote1;            // need closing quote
+               if (result)
+                  value = strslice(pquote1 + 1, pquote2 - pquote1 - 1);
+            }
+            else
+            {
+               const char * pvalue = pequals + 1;
+               while
+               (
+                  pvalue < eol && isspace(static_cast<unsigned char>(*pvalue))
+               )
+               {
+                  pvalue++;
+               }
+
+               const char * pvend = pvalue;
+               while
+               (
+                  pvend < eol &&
+                  ! isspace(static_cast<unsigned char>(*pvend)) &&
+                  *pvend != '#' && *pvend != ';'
+               )
+               {
+                  pvend++;
+               }
+               value = strslice(pvalue, pvend - pvalue);
+            }
+         }
+         if (result && current != end())
+         {
+            int currsize = current->second.size();
+            int newsize = current->second.insert(option.str(), value.str());
+            result = newsize == (currsize + 1);
+         }
+      }
+      else
+         result = false;
+
+      p = eol + 1;
+   }
+   return result;
+}
+
 /******************************************************************************
  * process_section_name()
  *------------------------------------------------------------------------*//**
@@ -0,0 +1,410 @@
+/******************************************************************************
+ * reloadable_initree.cpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          reloadable_initree.cpp
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \date          2014-04-26
+ * \updates       2014-04-26
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides the reloading, grace periods, and file watching of
+ *    xpc::reloadable_initree.
+ *
+ *    The grace period is the two-phase one of user-space RCU.  A reader
+ *    reads the phase bit, then increments the counter of that phase, then
+ *    loads the snapshot pointer, all sequentially consistent.  So a reader
+ *    that got the old pointer incremented its counter before the writer
+ *    swapped the pointer, and the writer, reading the counters after the
+ *    swap, sees it.  The writer flips the phase, which sends new readers
+ *    to the other counters, and waits for the old phase's counters to
+ *    drain.  A reader that read the phase before the flip but incremented
+ *    after it may be in either set of counters, so the writer flips and
+ *    drains a second time.  After that no reader can hold the old
+ *    snapshot.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* C::xpc_errprint_func(), etc.        */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/reloadable_initree.hpp>  /* xpc::reloadable_initree             */
+XPC_REVISION(reloadable_initree)
+
+#if defined __linux__
+#include <cerrno>                      /* errno and EINTR                     */
+#include <fcntl.h>                     /* O_CLOEXEC                           */
+#include <poll.h>                      /* poll()                              */
+#include <sys/inotify.h>               /* inotify_init1(), etc.               */
+#include <unistd.h>                    /* pipe(), read(), write(), close()    */
+#endif
+
+namespace xpc
+{
+
+/******************************************************************************
+ * reloadable_initree::READER_STRIPES
+ *------------------------------------------------------------------------*//**
+ *
+ *    The definition that goes with the in-class initializer.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+const int reloadable_initree::READER_STRIPES;
+
+/******************************************************************************
+ * config_snapshot default constructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates the empty snapshot, of generation 0.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+config_snapshot::config_snapshot ()
+ :
+   m_tree         (),
+   m_lookup       (),
+   m_generation   (0)
+{
+   m_lookup.freeze(m_tree);
+}
+
+/******************************************************************************
+ * config_snapshot::load()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads a file into a new snapshot, and freezes it.  This is done
+ *    before the snapshot is published; it never changes afterward.
+ *
+ *    The file is read as a stream, not mapped.  It may be rewritten in
+ *    place while being read (it is reloaded when closed after writing),
+ *    and a mapping of a file that gets truncated faults with SIGBUS.  A
+ *    torn read just fails to parse, or is followed by another reload.
+ *
+ * \param filespec
+ *    The file to read.
+ *
+ * \param generation
+ *    The generation number of the new snapshot.
+ *
+ * \return
+ *    Returns true if the whole file parsed.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+config_snapshot::load
+(
+   const std::string & filespec,
+   unsigned long generation
+)
+{
+   bool result = m_tree.readfile(filespec, initree::INITREE_STREAM);
+   if (result)
+   {
+      m_tree.name(filespec);
+      m_lookup.freeze(m_tree);
+      m_generation = generation;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * reloadable_initree principal constructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Loads the file for the first time.  If it cannot be loaded, the
+ *    holder starts with an empty snapshot and generation() is 0; the
+ *    error has been logged.
+ *
+ * \param filespec
+ *    The file to read and, if watch() is called, to watch.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+reloadable_initree::reloadable_initree (const std::string & filespec)
+ :
+   m_filespec     (filespec),
+   m_current      (new config_snapshot),
+   m_phase        (0),
+   m_reload_lock  (),
+   m_generation   (0),
+   m_watcher      ()
+{
+   for (int p = 0; p < 2; ++p)
+   {
+      for (int s = 0; s < READER_STRIPES; ++s)
+         m_readers[p][s].m_count.store(0);
+   }
+   m_wake_pipe[0] = m_wake_pipe[1] = -1;
+   (void) reload();
+}
+
+/******************************************************************************
+ * reloadable_initree destructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Stops the watcher, and deletes the current snapshot.  No reader may
+ *    still exist.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+reloadable_initree::~reloadable_initree ()
+{
+   stop();
+   delete m_current.load();
+}
+
+/******************************************************************************
+ * reloadable_initree::reader_stripe() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Hands out the counter stripes to threads round-robin, the first time
+ *    each thread reads.
+ *
+ * \return
+ *    Returns the stripe of the calling thread.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+reloadable_initree::reader_stripe ()
+{
+   static std::atomic<int> s_next_stripe(0);
+   static xpc_thread_local int ts_stripe = -1;
+   if (ts_stripe < 0)
+      ts_stripe = s_next_stripe.fetch_add(1) % READER_STRIPES;
+
+   return ts_stripe;
+}
+
+/******************************************************************************
+ * reloadable_initree::synchronize()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Waits for a grace period; see the top of this module.  Only reload()
+ *    calls it, with m_reload_lock held.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+reloadable_initree::synchronize ()
+{
+   for (int flip = 0; flip < 2; ++flip)
+   {
+      unsigned oldphase = m_phase.fetch_xor(1) & 1;
+      for (int s = 0; s < READER_STRIPES; ++s)
+      {
+         while (m_readers[oldphase][s].m_count.load() != 0)
+            std::this_thread::yield();
+      }
+   }
+}
+
+/******************************************************************************
+ * reloadable_initree::reload()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads the file into a new snapshot and publishes it, then deletes the
+ *    previous snapshot once no reader holds it.  The readers are never
+ *    blocked; this function may wait for them.
+ *
+ *    If the file cannot be read or does not parse, the current snapshot
+ *    stays, and an error is logged.
+ *
+ * \warning
+ *    The calling thread must not hold a reader of this object.  The grace
+ *    period waits for every reader of the old snapshot, and would wait
+ *    for the caller's own reader forever.
+ *
+ * \return
+ *    Returns true if the new snapshot was published.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+reloadable_initree::reload ()
+{
+   std::lock_guard<std::mutex> guard(m_reload_lock);
+   config_snapshot * fresh = new config_snapshot;
+   bool result = fresh->load(m_filespec, m_generation.load() + 1);
+   if (result)
+   {
+      config_snapshot * old = m_current.exchange(fresh);
+      m_generation.store(fresh->generation());
+      synchronize();
+      delete old;
+   }
+   else
+   {
+      xpc_errprintf
+      (
+         "%s: %s '%s'", __func__, _("cannot load"), m_filespec.c_str()
+      );
+      delete fresh;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * reloadable_initree::watch()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Starts the thread that reloads the file when it changes.  The thread
+ *    reacts to the file being closed after writing, or being renamed
+ *    into its directory, not to each write, so that a file being written
+ *    is not parsed half-done.
+ *
+ * \return
+ *    Returns true if the thread is running.  Returns false, after logging
+ *    the error, if inotify is not available or the directory cannot be
+ *    watched.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+reloadable_initree::watch ()
+{
+   bool result = watching();
+#if defined __linux__
+   if (! result)
+   {
+      std::string::size_type slash = m_filespec.find_last_of('/');
+      std::string directory = slash == std::string::npos ?
+         std::string(".") : m_filespec.substr(0, slash + 1) ;
+
+      int fd = inotify_init1(IN_CLOEXEC);
+      if (fd < 0)
+         xpc_strerrnoprint_func(_("inotify_init1() failed"));
+      else if
+      (
+         inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO)
+            < 0
+      )
+      {
+         xpc_strerrnoprint_func(directory.c_str());
+         (void) close(fd);
+      }
+      else if (pipe2(m_wake_pipe, O_CLOEXEC) != 0)
+      {
+         xpc_strerrnoprint_func(_("pipe2() failed"));
+         m_wake_pipe[0] = m_wake_pipe[1] = -1;
+         (void) close(fd);
+      }
+      else
+      {
+         m_watcher = std::thread(&reloadable_initree::watch_loop, this, fd);
+         result = true;
+      }
+   }
+#else
+   if (! result)
+      xpc_errprint_func(_("file watching is not supported"));
+#endif
+   return result;
+}
+
+/******************************************************************************
+ * reloadable_initree::stop()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Stops the watcher thread, if running, and waits for it, including for
+ *    a reload it may be doing.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+reloadable_initree::stop ()
+{
+#if defined __linux__
+   if (watching())
+   {
+      char wake = 'x';
+      if (write(m_wake_pipe[1], &wake, 1) != 1)
+         xpc_strerrnoprint_func(_("cannot wake the watcher"));
+
+      m_watcher.join();
+      (void) close(m_wake_pipe[0]);
+      (void) close(m_wake_pipe[1]);
+      m_wake_pipe[0] = m_wake_pipe[1] = -1;
+   }
+#endif
+}
+
+/******************************************************************************
+ * reloadable_initree::watch_loop()
+ *------------------------------------------------------------------------*//**
+ *
+ *    The body of the watcher thread.  It waits for inotify events for the
+ *    watched file's name, or for stop() to write to the wake pipe.  All of
+ *    the events that have arrived are read at once, so a burst of them
+ *    causes only one reload.
+ *
+ * \param inotifyfd
+ *    The inotify descriptor, which this function closes.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+reloadable_initree::watch_loop (int inotifyfd)
+{
+#if defined __linux__
+   std::string::size_type slash = m_filespec.find_last_of('/');
+   std::string basename = slash == std::string::npos ?
+      m_filespec : m_filespec.substr(slash + 1) ;
+
+   bool running = true;
+   while (running)
+   {
+      struct pollfd fds[2];
+      fds[0].fd = inotifyfd;
+      fds[0].events = POLLIN;
+      fds[0].revents = 0;
+      fds[1].fd = m_wake_pipe[0];
+      fds[1].events = POLLIN;
+      fds[1].revents = 0;
+      int rc = poll(fds, 2, -1);
+      if (rc < 0)
+      {
+         if (errno != EINTR)
+         {
+            xpc_strerrnoprint_func(_("poll() failed"));
+            running = false;
+         }
+      }
+      else if (fds[1].revents != 0)
+         running = false;
+      else if (fds[0].revents != 0)
+      {
+         alignas(struct inotify_event) char buffer[4096];
+         bool changed = false;
+         ssize_t count = read(inotifyfd, buffer, sizeof buffer);
+         for (ssize_t i = 0; i < count; )
+         {
+            const struct inotify_event * e =
+               reinterpret_cast<const struct inotify_event *>(buffer + i);
+
+            if (e->len > 0 && basename == e->name)
+               changed = true;
+
+            i += ssize_t(sizeof(struct inotify_event) + e->len);
+         }
+         if (changed)
+            (void) reload();
+      }
+   }
+   (void) close(inotifyfd);
+#endif
+}
+
+}                 // namespace xpc
+
+/******************************************************************************
+ * reloadable_initree.cpp
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *----------------------------------------------------------------------------*/
@@ -0,0 +1,322 @@
+/******************************************************************************
+ * settings.cpp
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          settings.cpp
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \date          2014-04-25
+ * \updates       2014-04-25
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides the loading of xpc::settings and the conversions of option
+ *    values to the types of the settings.
+ *
+ *    The conversions are strict:  the whole value must be used, so that
+ *    "80x" is an error instead of 80.  A value that cannot be converted is
+ *    logged, and its setting keeps its default.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <cerrno>                      /* errno and ERANGE                    */
+#include <climits>                     /* INT_MIN and INT_MAX                 */
+#include <cmath>                       /* std::isfinite()                     */
+#include <cstdlib>                     /* std::strtol(), std::strtod()        */
+#include <cstring>                     /* std::strcmp()                       */
+
+#include <xpc/errorlogging.h>          /* C::xpc_errprintf(), etc.            */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/settings.hpp>            /* xpc::settings and xpc::setting<>    */
+XPC_REVISION(settings)
+
+namespace xpc
+{
+
+/******************************************************************************
+ * parse_setting(int)
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts a decimal integer, with an optional sign.
+ *
+ * \param text
+ *    The option value.
+ *
+ * \param [out] value
+ *    Receives the number, if the text is one that fits in an int.
+ *
+ * \return
+ *    Returns true if the text was converted.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+parse_setting (const std::string & text, int & value)
+{
+   const char * begin = text.c_str();
+   char * end = nullptr;
+   errno = 0;
+   long number = std::strtol(begin, &end, 10);
+   bool result = end != begin && *end == 0 && errno != ERANGE &&
+      number >= INT_MIN && number <= INT_MAX;
+
+   if (result)
+      value = int(number);
+
+   return result;
+}
+
+/******************************************************************************
+ * parse_setting(double)
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts a floating-point number, in any form that strtod() takes,
+ *    except "nan" and "inf" (or "infinity"), which are not sensible
+ *    setting values.
+ *
+ * \param text
+ *    The option value.
+ *
+ * \param [out] value
+ *    Receives the number, if the text is one.
+ *
+ * \return
+ *    Returns true if the text was converted.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+parse_setting (const std::string & text, double & value)
+{
+   const char * begin = text.c_str();
+   char * end = nullptr;
+   errno = 0;
+   double number = std::strtod(begin, &end);
+   bool result = end != begin && *end == 0 && errno != ERANGE &&
+      std::isfinite(number);
+
+   if (result)
+      value = number;
+
+   return result;
+}
+
+/******************************************************************************
+ * parse_setting(bool)
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts "true", "yes", "on", or "1" to true, and "false", "no",
+ *    "off", or "0" to false, ignoring case.
+ *
+ *    An option without a value, such as a bare "verbose" line, is not
+ *    taken as true; its empty value is an error.
+ *
+ * \param text
+ *    The option value.
+ *
+ * \param [out] value
+ *    Receives the flag, if the text is one of the words above.
+ *
+ * \return
+ *    Returns true if the text was converted.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+parse_setting (const std::string & text, bool & value)
+{
+   bool result = true;
+   if
+   (
+      iequal(text, "true") || iequal(text, "yes") ||
+      iequal(text, "on") || text == "1"
+   )
+   {
+      value = true;
+   }
+   else if
+   (
+      iequal(text, "false") || iequal(text, "no") ||
+      iequal(text, "off") || text == "0"
+   )
+   {
+      value = false;
+   }
+   else
+      result = false;
+
+   return result;
+}
+
+/******************************************************************************
+ * parse_setting(std::string)
+ *------------------------------------------------------------------------*//**
+ *
+ *    Copies the text, which is always legal.
+ *
+ * \param text
+ *    The option value.
+ *
+ * \param [out] value
+ *    Receives the text.
+ *
+ * \return
+ *    Returns true.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+parse_setting (const std::string & text, std::string & value)
+{
+   value = text;
+   return true;
+}
+
+/******************************************************************************
+ * parse_setting(std::chrono::nanoseconds)
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts a duration, which is a non-negative number, possibly with a
+ *    fraction, followed right away by one of the units "ns", "us", "ms",
+ *    "s", "m", or "h".  A number with no unit is in seconds.  For
+ *    example, "250ms", "1.5s", and "2" are all durations.
+ *
+ * \param text
+ *    The option value.
+ *
+ * \param [out] value
+ *    Receives the duration, if the text is one that fits.
+ *
+ * \return
+ *    Returns true if the text was converted.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+parse_setting (const std::string & text, std::chrono::nanoseconds & value)
+{
+   const char * begin = text.c_str();
+   char * end = nullptr;
+   errno = 0;
+   double number = std::strtod(begin, &end);
+   bool result = end != begin && errno != ERANGE && number >= 0.0;
+   if (result)
+   {
+      double scale = 0.0;
+      if (*end == 0 || std::strcmp(end, "s") == 0)
+         scale = 1e9;
+      else if (std::strcmp(end, "ms") == 0)
+         scale = 1e6;
+      else if (std::strcmp(end, "us") == 0)
+         scale = 1e3;
+      else if (std::strcmp(end, "ns") == 0)
+         scale = 1.0;
+      else if (std::strcmp(end, "m") == 0)
+         scale = 60e9;
+      else if (std::strcmp(end, "h") == 0)
+         scale = 3600e9;
+
+      double ns = number * scale;
+      result = scale > 0.0 && ns < 9.2e18;      /* fits in 63 bits        */
+      if (result)
+         value = std::chrono::nanoseconds((long long) (ns + 0.5));
+   }
+   return result;
+}
+
+/******************************************************************************
+ * Default constructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates an empty registry.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+settings::settings ()
+ :
+   m_entries   ()
+{
+   // no other code needed
+}
+
+/******************************************************************************
+ * Destructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Deletes the settings.  The handles to them must no longer be used.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+settings::~settings ()
+{
+   std::vector<entry_base *>::iterator ei;
+   for (ei = m_entries.begin(); ei != m_entries.end(); ++ei)
+      delete *ei;
+}
+
+/******************************************************************************
+ * load()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Looks up and converts every registered setting.  This is the only
+ *    place the options are searched for and their text converted; after
+ *    it, the handles are read directly.
+ *
+ *    Each setting is first set back to its default, so that an option
+ *    removed from the configuration does not keep an old value.  A value
+ *    that cannot be converted is logged, with its section and option,
+ *    and the setting keeps the default.
+ *
+ * \param tree
+ *    The configuration to load from.
+ *
+ * \return
+ *    Returns 'true' if every setting that was found could be converted.
+ *    Missing options are not errors.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+settings::load (const initree & tree)
+{
+   bool result = true;
+   std::vector<entry_base *>::iterator ei;
+   for (ei = m_entries.begin(); ei != m_entries.end(); ++ei)
+   {
+      entry_base * e = *ei;
+      e->reset();
+      e->m_found = false;
+
+      initree::const_iterator si = tree.find(e->m_section);
+      if (si != tree.end())
+      {
+         initree::Section::const_iterator oi = si->second.find(e->m_option);
+         if (oi != si->second.end())
+         {
+            e->m_found = e->parse(oi->second);
+            if (! e->m_found)
+            {
+               xpc_errprintf
+               (
+                  "[%s] %s: %s '%s'",
+                  e->m_section.c_str(), e->m_option.c_str(),
+                  _("value cannot be converted"), oi->second.c_str()
+               );
+               result = false;
+            }
+         }
+      }
+   }
+   return result;
+}
+
+}                 // namespace xpc
+
+/******************************************************************************
+ * settings.cpp
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *----------------------------------------------------------------------------*/
@@ -0,0 +1,185 @@
+/******************************************************************************
+ * thread_pool.cpp
+ *-----------------------------------------------------------------------------
+ *
+ * \file          thread_pool.cpp
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \updates       2013-08-13 to 2013-08-13
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    This module wraps the C pthreader_pool_t work-stealing thread pool.
+ *
+ *    Each submitted std::function is copied to the heap and handed to the
+ *    C pool along with the run_task() trampoline, which calls and then
+ *    deletes it.
+ *
+ *    Also see the xpc::thread_pool class description and the
+ *    thread_pool.hpp module for more information.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* C::xpc_errprint_func(), etc.        */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/thread_pool.hpp>         /* xpc::thread_pool                    */
+XPC_REVISION(thread_pool)
+
+namespace xpc
+{
+
+/******************************************************************************
+ * Principal constructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Starts the workers.  If they cannot be started, an error is logged,
+ *    size() returns 0, and submit() fails.
+ *
+ * \param workers
+ *    The number of workers.  If 0 (the default) or less, one worker per
+ *    online CPU is started.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+thread_pool::thread_pool (int workers)
+ :
+   m_Pool      (),
+   m_Running   (false)
+{
+   m_Running = pthreader_pool_create(&m_Pool, workers);
+}
+
+/******************************************************************************
+ * Destructor
+ *------------------------------------------------------------------------*//**
+ *
+ *    Shuts the pool down, running the tasks already queued.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+thread_pool::~thread_pool ()
+{
+   shutdown();
+}
+
+/******************************************************************************
+ * thread_pool::run_task() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Runs a submitted task, then deletes it.  Exceptions must not escape
+ *    into the C worker, so any exception is logged and dropped.
+ *
+ * \param job
+ *    The heap copy of the task.
+ *
+ * \return
+ *    Returns a null pointer, which the C pool ignores.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void *
+thread_pool::run_task (void * job)
+{
+   task * t = static_cast<task *>(job);
+   try
+   {
+      (*t)();
+   }
+   catch (...)
+   {
+      xpc_errprint_func(_("task threw an exception"));
+   }
+   delete t;
+   return nullptr;
+}
+
+/******************************************************************************
+ * thread_pool::submit()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Queues a task whose result is not needed.  A task submitted by
+ *    another task of this pool goes onto that worker's own deque.
+ *
+ * \param job
+ *    The task, which is copied.
+ *
+ * \return
+ *    Returns 'true' if the task was queued.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+bool
+thread_pool::submit (const task & job)
+{
+   bool result = false;
+   if (m_Running && job)
+   {
+      task * t = new task(job);
+      result = pthreader_pool_submit(&m_Pool, run_task, t, nullptr);
+      if (! result)
+         delete t;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * thread_pool::wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Waits until every task submitted so far has finished, helping to run
+ *    them.  It must not be called from a task of this pool.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+thread_pool::wait ()
+{
+   if (m_Running)
+      pthreader_pool_wait(&m_Pool);
+}
+
+/******************************************************************************
+ * thread_pool::shutdown()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Stops the pool gracefully:  the tasks already queued are run, and the
+ *    workers are joined.  After that, submit() fails.  Calling it again
+ *    does nothing.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+thread_pool::shutdown ()
+{
+   if (m_Running)
+   {
+      m_Running = false;
+      (void) pthreader_pool_destroy(&m_Pool);
+   }
+}
+
+/******************************************************************************
+ * thread_pool::size()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the number of workers, or 0 if the pool is not running.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+thread_pool::size () const
+{
+   return m_Running ? pthreader_pool_size(&m_Pool) : 0;
+}
+
+}          /* namespace xpc */
+
+/******************************************************************************
+ * thread_pool.cpp
+ *----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=cpp
+ *//*-------------------------------------------------------------------------*/
@@ -27,13 +27,24 @@
 
 #include <stdexcept>                   /* std::logic_error                    */
 #include <iostream>                    /* std::cout and std::cerr             */
+#include <cstdio>                      /* fopen(), fprintf(), remove()        */
+#include <cstring>                     /* strstr()                            */
+#include <vector>                      /* std::vector                         */
+#include <atomic>                      /* std::atomic<int>                    */
+#include <pthread.h>                   /* pthread_create(), pthread_join()    */
 #include <xpc/binstring.hpp>           /* xpc::binstring class                */
 #include <xpc/cut.hpp>                 /* xpc::cut unit-test class            */
 #include <xpc/errorlog.hpp>            /* xpc::errorlog class                 */
+#include <xpc/frozen_initree.hpp>      /* xpc::frozen_initree class           */
 #include <xpc/initree.hpp>             /* xpc::initree class                  */
+#include <xpc/queues.hpp>              /* xpc::spsc_queue, xpc::mpmc_queue    */
+#include <xpc/reloadable_initree.hpp>  /* xpc::reloadable_initree class       */
 #include <xpc/stringmap.hpp>           /* xpc::stringmap class                */
 #include <xpc/rowset.hpp>              /* xpc::rowset class                   */
+#include <xpc/scope_timer.hpp>         /* xpc::scope_timer class              */
+#include <xpc/settings.hpp>            /* xpc::settings class                 */
 #include <xpc/systemtime.hpp>          /* xpc::systemtime class               */
+#include <xpc/thread_pool.hpp>         /* xpc::thread_pool class              */
 
 /******************************************************************************
  * gs_do_leak_check
@@ -545,20 +556,1496 @@ xpcpp_unit_test_05_02 (const xpc::cut_options & options)
    return status;
 }
 
+/******************************************************************************
+ * logfile_size()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the size of a log file, for checking if anything was written to
+ *    it.
+ *
+ * \param filename
+ *    The name of the file.
+ *
+ * \return
+ *    Returns the size of the file, or -1 if it could not be opened.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static long
+logfile_size (const std::string & filename)
+{
+   long result = -1;
+   FILE * fp = fopen(filename.c_str(), "r");
+   if (not_NULL(fp))
+   {
+      if (fseek(fp, 0, SEEK_END) == 0)
+         result = ftell(fp);
+
+      fclose(fp);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_05_03()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::errorlog_t template.
+ *
+ * \group
+ *    5. xpc::errorlog
+ *
+ * \case
+ *    3. Compile-time levels
+ *
+ * \tests
+ *    -  xpc::errorlog_t<>::compiled()
+ *    -  xpc::errorlog_t<>::infoprint()
+ *    -  xpc::errorlog_t<>::warnprintf()
+ *    -  logt_infoprintf()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_05_03 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 5, 3, "xpc::errorlog", _("Compile-time levels")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         typedef xpc::errorlog_t<XPC_ERROR_LEVEL_WARNINGS> warnlog;
+         const std::string filename = "errorlog_t.txt";
+         xpc::errorlog e;
+         (void) e.errlevel(XPC_ERROR_LEVEL_ALL);
+         ok = e.open_logfile(filename);
+         xpc::cut::show(options, _("No values to show in this test"));
+         if (status.next_subtest("xpc::errorlog_t<>::compiled()"))
+         {
+            ok = warnlog::compiled(XPC_ERROR_LEVEL_ERRORS) &&
+               warnlog::compiled(XPC_ERROR_LEVEL_WARNINGS) &&
+               ! warnlog::compiled(XPC_ERROR_LEVEL_INFO) &&
+               ! warnlog::compiled(XPC_ERROR_LEVEL_NONE);
+
+            status.pass(ok);
+         }
+         if (status.next_subtest("compiled-out calls"))
+         {
+            if (ok)
+            {
+               warnlog w(e);
+               int evaluations = 0;
+               w.infoprint("not compiled in");
+               w.infoprintex("not compiled in", "label");
+               w.infoprintf("%s %d", "not compiled in", 1);
+               w.dbginfoprint("not compiled in");
+               logt_infoprintf(w, "%d", ++evaluations);
+               e.flush_error_log();
+               ok = evaluations == 0 && ! w.showinfo();
+               if (ok)
+                  ok = logfile_size(filename) == 0;
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("compiled-in calls"))
+         {
+            if (ok)
+            {
+               warnlog w(e);
+               int evaluations = 0;
+               logt_warnprintf(w, "%d", ++evaluations);
+               e.flush_error_log();
+               ok = evaluations == 1 && w.showwarnings();
+               if (ok)
+                  ok = logfile_size(filename) > 0;
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("run-time level"))
+         {
+            if (ok)
+            {
+               xpc::errorlog_t<XPC_ERROR_LEVEL_ALL> a(e);
+               int evaluations = 0;
+               (void) e.errlevel(XPC_ERROR_LEVEL_ERRORS);
+               logt_infoprintf(a, "%d", ++evaluations);
+               ok = evaluations == 0 && ! a.showinfo() && a.showerrors();
+            }
+            status.pass(ok);
+         }
+         (void) e.close_logfile();
+         (void) remove(filename.c_str());
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_05_04()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the log rotation of xpc::errorlog.
+ *
+ * \group
+ *    5. xpc::errorlog
+ *
+ * \case
+ *    4. Log rotation
+ *
+ * \tests
+ *    -  xpc::errorlog::open_logfile() [rotation overload]
+ *    -  xpc::errorlog::rotation()
+ *    -  xpc::errorlog::rotate_logfile()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_05_04 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 5, 4, "xpc::errorlog", _("Log rotation")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         const std::string filename = "rotlog_cpp.txt";
+         xpc::errorlog e;
+         (void) e.errlevel(XPC_ERROR_LEVEL_ALL);
+         xpc::cut::show(options, _("No values to show in this test"));
+         if (status.next_subtest("rotate by size"))
+         {
+            ok = e.open_logfile(filename, 200, 0, 2);
+            for (int line = 0; ok && line < 40; ++line)
+               e.infoprintf("rotation test line %d", line);
+
+            if (ok)
+            {
+               ok = logfile_size(filename + ".1") > 0 &&
+                  logfile_size(filename + ".2") > 0 &&
+                  logfile_size(filename + ".3") < 0 &&
+                  logfile_size(filename) < 200;
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("rotate on demand"))
+         {
+            if (ok)
+            {
+               e.print("before rotation");
+               ok = e.rotate_logfile();
+               if (ok)
+                  ok = logfile_size(filename) == 0;
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("bad settings"))
+         {
+            if (ok)
+            {
+               ok = ! e.rotation(0, -1) && ! e.rotation(0, 0, -1);
+               if (ok)
+               {
+                  (void) e.close_logfile();
+                  ok = ! e.rotate_logfile();    /* stderr cannot be rotated */
+               }
+            }
+            status.pass(ok);
+         }
+         (void) e.close_logfile();
+         (void) remove(filename.c_str());
+         (void) remove((filename + ".1").c_str());
+         (void) remove((filename + ".2").c_str());
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_05_05()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the per-object locks of xpc::errorlog.  Two objects
+ *    log to two files from two threads each, with --synch in force, and
+ *    every line must arrive whole.
+ *
+ * \group
+ *    5. xpc::errorlog
+ *
+ * \case
+ *    5. Per-object locks
+ *
+ * \tests
+ *    -  xpc::errorlog::synchusage()
+ *    -  xpc::errorlog::synchshared()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static const int s_synch_lines = 200;
+
+static void *
+synch_log_thread (void * log)
+{
+   const xpc::errorlog * e = static_cast<const xpc::errorlog *>(log);
+   for (int line = 0; line < s_synch_lines; ++line)
+      e->infoprintf("synch test line %04d of this thread", line);
+
+   return nullptr;
+}
+
+static bool
+synch_log_check (const std::string & filename, int lines)
+{
+   int count = 0;
+   bool result = true;
+   FILE * fp = fopen(filename.c_str(), "r");
+   if (not_NULL(fp))
+   {
+      char text[128];
+      while (result && not_NULL(fgets(text, sizeof text, fp)))
+      {
+         if (strstr(text, "synch test line") != nullptr)
+         {
+            result = strstr(text, " of this thread\n") != nullptr;
+            ++count;
+         }
+      }
+      fclose(fp);
+   }
+   return result && count == lines;
+}
+
+static bool
+synch_log_run (xpc::errorlog & e1, xpc::errorlog & e2)
+{
+   pthread_t threads[4];
+   bool result = true;
+   for (int t = 0; t < 4; ++t)
+   {
+      void * log = (t % 2) == 0 ? &e1 : &e2;
+      if (pthread_create(&threads[t], NULL, synch_log_thread, log) != 0)
+      {
+         result = false;
+         threads[t] = pthread_self();
+      }
+   }
+   for (int t = 0; t < 4; ++t)
+   {
+      if (! pthread_equal(threads[t], pthread_self()))
+         (void) pthread_join(threads[t], NULL);
+   }
+   return result;
+}
+
+static xpc::cut_status
+xpcpp_unit_test_05_05 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 5, 5, "xpc::errorlog", _("Per-object locks")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         const std::string file1 = "synchlog1_cpp.txt";
+         const std::string file2 = "synchlog2_cpp.txt";
+         xpc::errorlog e1;
+         xpc::errorlog e2;
+         (void) e1.errlevel(XPC_ERROR_LEVEL_INFO);
+         (void) e2.errlevel(XPC_ERROR_LEVEL_INFO);
+         xpc::cut::show(options, _("No values to show in this test"));
+         if (status.next_subtest("own locks"))
+         {
+            ok = ! e1.synchshared() && ! e2.synchshared();
+            if (ok)
+               ok = e1.open_logfile(file1) && e2.open_logfile(file2);
+
+            if (ok)
+               ok = e1.synchusage(true) && e2.synchusage(true);
+
+            if (ok)
+               ok = synch_log_run(e1, e2);
+
+            if (ok)
+            {
+               (void) e1.close_logfile();
+               (void) e2.close_logfile();
+               ok = synch_log_check(file1, 2 * s_synch_lines) &&
+                  synch_log_check(file2, 2 * s_synch_lines);
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("shared lock"))
+         {
+            if (ok)
+               ok = e1.synchshared(true) && e2.synchshared(true);
+
+            if (ok)
+               ok = e1.synchshared() && e2.synchshared();
+
+            if (ok)
+               ok = e1.open_logfile(file1) && e2.open_logfile(file2);
+
+            if (ok)
+               ok = synch_log_run(e1, e2);
+
+            if (ok)
+            {
+               (void) e1.close_logfile();
+               (void) e2.close_logfile();
+               ok = synch_log_check(file1, 2 * s_synch_lines) &&
+                  synch_log_check(file2, 2 * s_synch_lines);
+            }
+            status.pass(ok);
+         }
+         (void) e1.close_logfile();
+         (void) e2.close_logfile();
+         (void) remove(file1.c_str());
+         (void) remove(file2.c_str());
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_05_06()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the stream-style logging of xpc::errorlog, and of
+ *    the const char * overloads of the print functions.
+ *
+ * \group
+ *    5. xpc::errorlog
+ *
+ * \case
+ *    6. Stream-style logging
+ *
+ * \tests
+ *    -  xpc::errorlog::info()
+ *    -  xpc::errorlog::warn()
+ *    -  xpc::errorlog::infoprint()
+ *    -  xpc::logstream
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static int
+stream_log_count (const std::string & filename, const char * text)
+{
+   int result = 0;
+   FILE * fp = fopen(filename.c_str(), "r");
+   if (not_NULL(fp))
+   {
+      char line[XPC_LOGSTREAM_SIZE + 64];
+      while (not_NULL(fgets(line, sizeof line, fp)))
+      {
+         if (strstr(line, text) != nullptr)
+            ++result;
+      }
+      fclose(fp);
+   }
+   return result;
+}
+
+static xpc::cut_status
+xpcpp_unit_test_05_06 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 5, 6, "xpc::errorlog", _("Stream-style logging")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         const std::string file = "streamlog_cpp.txt";
+         xpc::errorlog e;
+         (void) e.errlevel(XPC_ERROR_LEVEL_INFO);
+         xpc::cut::show(options, _("No values to show in this test"));
+         ok = e.open_logfile(file);
+         if (status.next_subtest("shown level"))
+         {
+            if (ok)
+            {
+               e.info() << "stream " << 42 << ' ' << -7L << ' ' << 2.5
+                  << ' ' << true << ' ' << std::string("end");
+
+               ok = e.info().active();
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("hidden level"))
+         {
+            if (ok)
+            {
+               (void) e.errlevel(XPC_ERROR_LEVEL_WARNINGS);
+               e.info() << "stream hidden " << 1;
+               ok = ! e.info().active();
+               (void) e.errlevel(XPC_ERROR_LEVEL_INFO);
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("long line"))
+         {
+            if (ok)
+            {
+               xpc::logstream line = e.warn();
+               for (int i = 0; i < XPC_LOGSTREAM_SIZE; ++i)
+                  line << 'x';
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("const char * overloads"))
+         {
+            if (ok)
+            {
+               e.infoprint("stream literal");
+               e.infoprint(std::string("stream string"));
+               e.warnprint("stream warning");
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("lines finished out of order"))
+         {
+            if (ok)
+            {
+               xpc::logstream * first = new xpc::logstream(e.info());
+               xpc::logstream * second = new xpc::logstream(e.info());
+               *first << "stream first";
+               *second << "stream second";
+               delete first;                       /* frees only its buffer  */
+
+               xpc::logstream * third = new xpc::logstream(e.info());
+               *third << "stream third";
+               delete second;
+               delete third;
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("log contents"))
+         {
+            if (ok)
+            {
+               (void) e.close_logfile();
+               ok = stream_log_count(file, "stream 42 -7 2.5 true end\n") == 1;
+               if (ok)
+                  ok = stream_log_count(file, "stream hidden") == 0;
+
+               if (ok)
+                  ok = stream_log_count(file, "xxxxxxxx") == 1;
+
+               if (ok)
+                  ok = stream_log_count(file, "stream literal\n") == 1 &&
+                     stream_log_count(file, "stream string\n") == 1 &&
+                     stream_log_count(file, "stream warning\n") == 1;
+
+               if (ok)
+                  ok = stream_log_count(file, "stream first\n") == 1 &&
+                     stream_log_count(file, "stream second\n") == 1 &&
+                     stream_log_count(file, "stream third\n") == 1;
+            }
+            status.pass(ok);
+         }
+         (void) e.close_logfile();
+         (void) remove(file.c_str());
+      }
+   }
+   return status;
+}
+
 /******************************************************************************
  * xpcpp_unit_test_06_01()
  *------------------------------------------------------------------------*//**
  *
- *    Provides a test of the xpc::binstring class.
+ *    Provides a test of the xpc::binstring class.
+ *
+ * \group
+ *    6. xpc::binstring
+ *
+ * \case
+ *    1. Default constructor
+ *
+ * \tests
+ *    -  xpc::binstring()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_06_01 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 6, 1, "xpc::binstring", _("Default constructor")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         // xpc::cut::show(options, _("No values to show in this test"));
+
+         if (status.next_subtest("xpc::binstring default"))
+         {
+            xpc::binstring bs;                     /* construct by default    */
+            ok = bs.size() == 0;
+            if (ok)
+               ok = bs.length() == 0;
+
+            if (ok)
+               ok = bs.empty();
+
+            if (ok)
+               ok = std::string(bs) == "";
+
+            if (ok)
+               ok = bs.is_binary();
+
+            status.pass(ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_06_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::binstring class.
+ *
+ * \group
+ *    6. xpc::binstring
+ *
+ * \case
+ *    2. String constructor
+ *
+ * \tests
+ *    -  xpc::binstring(const std::string &))
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_06_02 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 6, 2, "xpc::binstring", _("String constructor")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         // xpc::cut::show(options, _("No values to show in this test"));
+         if (status.next_subtest("xpc::binstring('hello')"))
+         {
+            std::string s("Hello");
+            xpc::binstring bs(s);
+            ok = bs.size() == 5;
+            if (ok)
+               ok = bs.length() == 5;
+
+            if (ok)
+               ok = ! bs.empty();
+
+            if (ok)
+               ok = std::string(bs) == "Hello";
+
+            if (ok)
+               ok = bs.is_binary();
+
+            if (ok)
+            {
+               std::string hexversion = xpc::string_as_hex(std::string(bs));
+               if (options.show_values())
+               {
+                  std::cout << hexversion;
+               }
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("xpc::binstring('Ctrl-A to E')"))
+         {
+            std::string s("\x01\x02\x03\x04\x05");
+            xpc::binstring bs(s);
+            ok = bs.size() == 5;
+            if (ok)
+               ok = bs.length() == 5;
+
+            if (ok)
+               ok = ! bs.empty();
+
+            if (ok)
+               ok = std::string(bs) == "\x01\x02\x03\x04\x05";
+
+            if (ok)
+               ok = bs.is_binary();
+
+            if (ok)
+            {
+               std::string hexversion = xpc::string_as_hex(std::string(bs));
+               if (options.show_values())
+               {
+                  std::cout << hexversion;
+               }
+            }
+            status.pass(ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_07_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::initree class.
+ *
+ * \group
+ *    7. xpc::initree
+ *
+ * \case
+ *    1. Default constructor
+ *
+ * \tests
+ *    -  xpc::initree()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_07_01 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 7, 1, "xpc::initree", _("Default constructor")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         if (status.next_subtest("xpc::initree default"))
+         {
+            /*
+             * The constructors of initree always create an unnamed section,
+             * so there is always at least one section in the initree.
+             */
+
+            xpc::initree it;                     /* construct by default    */
+            ok = it.size() == 1;
+
+            if (ok)
+               ok = ! it.empty();
+
+            status.pass(ok);
+         }
+
+         /* MORE TESTS NEEDED */
+
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_07_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::initree class.
+ *
+ * \group
+ *    7. xpc::initree
+ *
+ * \case
+ *    2. Principal constructor
+ *
+ * \tests
+ *    -  xpc::initree()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_07_02 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 7, 2, "xpc::initree", _("Principle constructor")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         if (status.next_subtest("INI file smoke test"))
+         {
+            xpc::initree it("Smoke", "initree.ini");
+            ok = it.size() > 0;
+            if (ok)
+            {
+               if (options.is_verbose())
+                  xpc::show("Unit Test 07.02", it);
+            }
+
+            status.pass(ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * same_initree()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Compares two initrees section by section and option by option.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static bool
+same_initree (const xpc::initree & a, const xpc::initree & b)
+{
+   bool result = a.size() == b.size();
+   xpc::initree::const_iterator ai = a.begin();
+   xpc::initree::const_iterator bi = b.begin();
+   for ( ; result && ai != a.end(); ++ai, ++bi)
+   {
+      result = ai->first == bi->first &&
+         ai->second.size() == bi->second.size();
+
+      xpc::initree::Section::const_iterator ao = ai->second.begin();
+      xpc::initree::Section::const_iterator bo = bi->second.begin();
+      for ( ; result && ao != ai->second.end(); ++ao, ++bo)
+         result = ao->first == bo->first && ao->second == bo->second;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * initree_value()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the value of an option, or "<none>" if the section is
+ *    missing.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static std::string
+initree_value
+(
+   const xpc::initree & it,
+   const std::string & sectionname,
+   const std::string & option
+)
+{
+   xpc::initree::const_iterator ci = it.find(sectionname);
+   return ci != it.end() ? ci->second.value(option) : std::string("<none>") ;
+}
+
+/******************************************************************************
+ * write_big_ini()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Writes a generated INI file with every kind of line that initree
+ *    accepts, in the proportions of a generated service configuration.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static bool
+write_big_ini (const char * filename, int sections, int options)
+{
+   FILE * fp = fopen(filename, "w");
+   bool result = not_NULL(fp);
+   if (result)
+   {
+      fprintf(fp, "# generated by xpcpp_unit_test\n\nglobal_flag\n");
+      for (int s = 0; s < sections; ++s)
+      {
+         fprintf(fp, "\n[ Service %d ]\n\n", s);
+         for (int o = 0; o < options; ++o)
+         {
+            switch (o % 5)
+            {
+            case 0:
+               fprintf(fp, "; option group %d\n", o / 5);
+               fprintf(fp, "option_%d = %d\n", o, s * options + o);
+               break;
+
+            case 1:
+               fprintf(fp, "option_%d=\"host-%d.example.com:%d\"\n", o, s, o);
+               break;
+
+            case 2:
+               fprintf(fp, "   option_%d = value-%d   # a comment\n", o, o);
+               break;
+
+            case 3:
+               fprintf(fp, "option_%d\n", o);
+               break;
+
+            default:
+               fprintf(fp, "option_%d = \"two ; words\"\t; comment\n", o);
+               break;
+            }
+         }
+      }
+      result = fclose(fp) == 0;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_07_03()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::initree class.
+ *
+ * \group
+ *    7. xpc::initree
+ *
+ * \case
+ *    3. Mapped reading
+ *
+ * \tests
+ *    -  xpc::initree::readfile()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_07_03 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 7, 3, "xpc::initree", _("Mapped reading")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         if (status.next_subtest("Same tree as the stream reader"))
+         {
+            /*
+             * initree.ini ends with a C-style comment block, which both
+             * readers reject after having read the rest of the file.
+             */
+
+            xpc::initree streamed;
+            xpc::initree mapped;
+            bool rs = streamed.readfile("initree.ini");
+            bool rm = mapped.readfile
+            (
+               "initree.ini", xpc::initree::INITREE_MAPPED
+            );
+            ok = ! rs && ! rm && streamed.size() == 3;
+            if (ok)
+               ok = same_initree(streamed, mapped);
+
+            if (ok)
+               ok = initree_value(mapped, "Section 2", "Sec_2_option_6") ==
+                  "two ; words";
+
+            status.pass(ok);
+         }
+         if (status.next_subtest("Last line and bad lines"))
+         {
+            const char * filename = "initree_07_03.ini";
+            FILE * fp = fopen(filename, "w");
+            ok = not_NULL(fp);
+            if (ok)
+            {
+               fprintf(fp, "\r\n[Last]\r\nfirst = 1\r\nsecond = \"2\"");
+               ok = fclose(fp) == 0;
+            }
+            if (ok)
+            {
+               xpc::initree it;
+               ok = it.readfile(filename, xpc::initree::INITREE_MAPPED);
+               if (ok)
+                  ok = initree_value(it, "Last", "first") == "1";
+
+               if (ok)
+                  ok = initree_value(it, "Last", "second") == "2";
+            }
+            if (ok)
+            {
+               fp = fopen(filename, "w");
+               ok = not_NULL(fp);
+               if (ok)
+               {
+                  fprintf(fp, "[Dup]\nopt = \"unterminated\n");
+                  ok = fclose(fp) == 0;
+               }
+               if (ok)
+               {
+                  xpc::initree it;
+                  ok = ! it.readfile(filename, xpc::initree::INITREE_MAPPED);
+               }
+            }
+            if (ok)
+            {
+               xpc::initree it;
+               ok = ! it.readfile("no_such.ini", xpc::initree::INITREE_MAPPED);
+            }
+            (void) remove(filename);
+            status.pass(ok);
+         }
+         if (status.next_subtest("Same tree for a generated file"))
+         {
+            const char * filename = "initree_07_03.ini";
+            ok = write_big_ini(filename, 20, 50);
+            if (ok)
+            {
+               xpc::initree streamed;
+               xpc::initree mapped;
+               ok = streamed.readfile(filename);
+               if (ok)
+                  ok = mapped.readfile(filename, xpc::initree::INITREE_MAPPED);
+
+               if (ok)
+                  ok = mapped.size() == 21 && same_initree(streamed, mapped);
+            }
+            (void) remove(filename);
+            status.pass(ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_07_04()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Compares the time to read a multi-megabyte INI file as a stream and
+ *    through a mapping.  The times are shown with --show-values; the test
+ *    fails only if the two readers disagree.
+ *
+ * \group
+ *    7. xpc::initree
+ *
+ * \case
+ *    4. Reading benchmark
+ *
+ * \tests
+ *    -  xpc::initree::readfile()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_07_04 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 7, 4, "xpc::initree", _("Reading benchmark")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         if (status.next_subtest("Stream versus mapped"))
+         {
+            const char * filename = "initree_07_04.ini";
+            ok = write_big_ini(filename, 200, 500);
+            if (ok)
+            {
+               xpc::initree streamed;
+               xpc::initree mapped;
+               uint64_t t0 = xpc_monotonic_nanoseconds();
+               ok = streamed.readfile(filename);
+
+               uint64_t t1 = xpc_monotonic_nanoseconds();
+               if (ok)
+                  ok = mapped.readfile(filename, xpc::initree::INITREE_MAPPED);
+
+               uint64_t t2 = xpc_monotonic_nanoseconds();
+               if (ok)
+                  ok = same_initree(streamed, mapped);
+
+               if (options.show_values())
+               {
+                  std::cout
+                     << "  100000 options, stream: " << (t1 - t0) / 1000
+                     << " us, mapped: " << (t2 - t1) / 1000 << " us"
+                     << std::endl
+                     ;
+               }
+            }
+            (void) remove(filename);
+            status.pass(ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_07_05()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::frozen_initree class.
+ *
+ * \group
+ *    7. xpc::initree
+ *
+ * \case
+ *    5. Frozen lookups
+ *
+ * \tests
+ *    -  xpc::frozen_initree()
+ *    -  xpc::frozen_initree::freeze()
+ *    -  xpc::frozen_initree::section()
+ *    -  xpc::frozen_initree::value()
+ *    -  xpc::frozen_initree::contains()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_07_05 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 7, 5, "xpc::initree", _("Frozen lookups")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         if (status.next_subtest("Small file"))
+         {
+            xpc::initree it("Frozen", "initree.ini");
+            xpc::frozen_initree frozen(it);
+            ok = frozen.size() == 3;
+            if (ok)
+               ok = frozen.section("").size() == 7;
+
+            if (ok)
+            {
+               xpc::frozen_initree::section_view s2 =
+                  frozen.section("Section 2");
+
+               ok = s2.valid() && s2.name() == "Section 2" && s2.size() == 6;
+               if (ok)
+                  ok = s2.value("Sec_2_option_6") == "two ; words";
+
+               if (ok)
+                  ok = s2.contains("Sec_2_option_1") &&
+                     s2.value("Sec_2_option_1").empty();
+
+               if (ok)
+                  ok = ! s2.contains("Sec_1_option_1");  /* other section */
+            }
+            if (ok)
+               ok = frozen.value("Section 1", "Sec_1_option_4") == "two";
+
+            if (ok)
+               ok = ! frozen.section("Section 3").valid() &&
+                  frozen.section("Section 3").size() == 0 &&
+                  ! frozen.contains("Section 3", "Sec_1_option_4");
+
+            status.pass(ok);
+         }
+         if (status.next_subtest("Every option of a generated file"))
+         {
+            const char * filename = "initree_07_05.ini";
+            xpc::initree it;
+            ok = write_big_ini(filename, 50, 200);
+            if (ok)
+               ok = it.readfile(filename, xpc::initree::INITREE_MAPPED);
+
+            (void) remove(filename);
+            if (ok)
+            {
+               const xpc::initree & tree = it;
+               xpc::frozen_initree frozen;
+               frozen.freeze(tree);
+               ok = frozen.size() == 51 && frozen.option_count() == 50*200 + 1;
+
+               xpc::initree::const_iterator si;
+               xpc::initree::Section::const_iterator oi;
+               for (si = tree.begin(); ok && si != tree.end(); ++si)
+               {
+                  xpc::frozen_initree::section_view sv =
+                     frozen.section(si->first);
+
+                  ok = sv.size() == si->second.size();
+                  oi = si->second.begin();
+                  for ( ; ok && oi != si->second.end(); ++oi)
+                     ok = sv.value(oi->first) == oi->second;
+               }
+               if (ok)
+                  ok = frozen.value("Service 7", "option_200").empty() &&
+                     ! frozen.contains("Service 7", "option_200");
+
+               if (ok)
+               {
+                  /*
+                   * The same lookups in the initree and in the frozen
+                   * copy, shown with --show-values.
+                   */
+
+                  const int count = 200000;
+                  std::vector<std::string> names;
+                  for (int o = 0; o < 200; ++o)
+                     names.push_back("option_" + std::to_string(o));
+
+                  size_t found = 0;
+                  uint64_t t0 = xpc_monotonic_nanoseconds();
+                  for (int i = 0; i < count; ++i)
+                  {
+                     const std::string & name = names[i % 200];
+                     xpc::initree::const_iterator ci = tree.find("Service 17");
+                     found += ci->second.value(name).size();
+                  }
+
+                  uint64_t t1 = xpc_monotonic_nanoseconds();
+                  for (int i = 0; i < count; ++i)
+                  {
+                     const std::string & name = names[i % 200];
+                     found -= frozen.value("Service 17", name).size();
+                  }
+
+                  uint64_t t2 = xpc_monotonic_nanoseconds();
+                  ok = found == 0;
+                  if (options.show_values())
+                  {
+                     std::cout
+                        << "  Lookup, initree: " << (t1 - t0) / count
+                        << " ns, frozen: " << (t2 - t1) / count << " ns"
+                        << std::endl
+                        ;
+                  }
+               }
+            }
+            status.pass(ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_07_06()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::settings class.
+ *
+ * \group
+ *    7. xpc::initree
+ *
+ * \case
+ *    6. Typed settings
+ *
+ * \tests
+ *    -  xpc::settings::add()
+ *    -  xpc::settings::load()
+ *    -  xpc::setting<>::get()
+ *    -  xpc::setting<>::found()
+ *    -  xpc::parse_setting()
+ *
+ * \param options
+ *    Provides the command-line options for the unit-test application.
+ *
+ * \return
+ *    Returns the unit-test status object needed by the protocol.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc::cut_status
+xpcpp_unit_test_07_06 (const xpc::cut_options & options)
+{
+   xpc::cut_status status
+   (
+      options, 7, 6, "xpc::initree", _("Typed settings")
+   );
+   bool ok = status.valid();        /* note that invalidity is /not/ an error */
+   if (ok)
+   {
+      if (! status.can_proceed())                  /* is test allowed to run? */
+      {
+         status.pass();                            /* no, force it to pass    */
+      }
+      else
+      {
+         if (status.next_subtest("Conversions"))
+         {
+            int i = 0;
+            double d = 0.0;
+            bool b = false;
+            std::chrono::nanoseconds ns(0);
+            ok = xpc::parse_setting("-42", i) && i == -42;
+            if (ok)
+               ok = ! xpc::parse_setting("80x", i) &&
+                  ! xpc::parse_setting("", i) &&
+                  ! xpc::parse_setting("99999999999", i) && i == -42;
+
+            if (ok)
+               ok = xpc::parse_setting("0.25", d) && d == 0.25 &&
+                  ! xpc::parse_setting("0.25.1", d);
+
+            if (ok)
+               ok = ! xpc::parse_setting("nan", d) &&
+                  ! xpc::parse_setting("inf", d) &&
+                  ! xpc::parse_setting("-Infinity", d) && d == 0.25;
+
+            if (ok)
+               ok = xpc::parse_setting("Yes", b) && b &&
+                  xpc::parse_setting("off", b) && ! b &&
+                  ! xpc::parse_setting("maybe", b);
+
+            if (ok)
+               ok = xpc::parse_setting("250ms", ns) &&
+                  ns == std::chrono::milliseconds(250);
+
+            if (ok)
+               ok = xpc::parse_setting("1.5", ns) &&
+                  ns == std::chrono::milliseconds(1500);
+
+            if (ok)
+               ok = xpc::parse_setting("2m", ns) &&
+                  ns == std::chrono::seconds(120);
+
+            if (ok)
+               ok = ! xpc::parse_setting("5 s", ns) &&
+                  ! xpc::parse_setting("-1s", ns) &&
+                  ! xpc::parse_setting("3d", ns);
+
+            status.pass(ok);
+         }
+         if (status.next_subtest("Load"))
+         {
+            const char * filename = "initree_07_06.ini";
+            FILE * fp = fopen(filename, "w");
+            ok = not_NULL(fp);
+            if (ok)
+            {
+               fprintf
+               (
+                  fp,
+                  "[Server]\n"
+                  "port = 8080\n"
+                  "ratio = 0.75\n"
+                  "verbose = on\n"
+                  "name = \"web 1\"\n"
+                  "timeout = 250ms\n"
+                  "retries = many\n"
+               );
+               ok = fclose(fp) == 0;
+            }
+
+            xpc::settings config;
+            xpc::setting<int> port = config.add("Server", "port", 80);
+            xpc::setting<double> ratio = config.add("Server", "ratio", 0.5);
+            xpc::setting<bool> verbose = config.add("Server", "verbose", false);
+            xpc::setting<std::string> name = config.add("Server", "name", "?");
+            xpc::setting<std::chrono::nanoseconds> timeout =
+               config.add("Server", "timeout", std::chrono::seconds(1));
+
+            xpc::setting<int> retries = config.add("Server", "retries", 3);
+            xpc::setting<int> missing = config.add("Client", "port", 7);
+            xpc::setting<int> unbound;
+            if (ok)
+               ok = config.size() == 7 && port.get() == 80 && ! port.found();
+
+            if (ok)
+            {
+               xpc::initree tree("Settings", filename);
+               ok = ! config.load(tree);           /* "many" is not an int */
+            }
+            (void) remove(filename);
+            if (ok)
+               ok = port.get() == 8080 && port.found() && ratio == 0.75;
+
+            if (ok)
+               ok = verbose && name.get() == "web 1" &&
+                  timeout.get() == std::chrono::milliseconds(250);
+
+            if (ok)
+               ok = retries == 3 && ! retries.found();
+
+            if (ok)
+               ok = missing == 7 && ! missing.found();
+
+            if (ok)
+               ok = unbound == 0 && ! unbound.found();
+
+            if (ok)
+            {
+               xpc::initree empty;
+               ok = config.load(empty) && port == 80 && ! port.found();
+            }
+            status.pass(ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * write_stamped_ini()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Writes, or replaces by renaming, an INI file whose two "stamp"
+ *    options have the same value, for xpcpp_unit_test_07_07().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static bool
+write_stamped_ini (const char * filename, int stamp, bool replace)
+{
+   std::string tempname = std::string(filename) + ".tmp";
+   FILE * fp = fopen(replace ? tempname.c_str() : filename, "w");
+   bool result = not_NULL(fp);
+   if (result)
+   {
+      fprintf(fp, "stamp = %d\n\n[Server]\nstamp = %d\n", stamp, stamp);
+      result = fclose(fp) == 0;
+   }
+   if (result && replace)
+      result = rename(tempname.c_str(), filename) == 0;
+
+   return result;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_07_07()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::reloadable_initree class.
  *
  * \group
- *    6. xpc::binstring
+ *    7. xpc::initree
  *
  * \case
- *    1. Default constructor
+ *    7. Reloading
  *
  * \tests
- *    -  xpc::binstring()
+ *    -  xpc::reloadable_initree()
+ *    -  xpc::reloadable_initree::reader
+ *    -  xpc::reloadable_initree::reload()
+ *    -  xpc::reloadable_initree::watch()
+ *    -  xpc::reloadable_initree::stop()
  *
  * \param options
  *    Provides the command-line options for the unit-test application.
@@ -569,11 +2056,11 @@ xpcpp_unit_test_05_02 (const xpc::cut_options & options)
  *//*-------------------------------------------------------------------------*/
 
 static xpc::cut_status
-xpcpp_unit_test_06_01 (const xpc::cut_options & options)
+xpcpp_unit_test_07_07 (const xpc::cut_options & options)
 {
    xpc::cut_status status
    (
-      options, 6, 1, "xpc::binstring", _("Default constructor")
+      options, 7, 7, "xpc::initree", _("Reloading")
    );
    bool ok = status.valid();        /* note that invalidity is /not/ an error */
    if (ok)
@@ -584,45 +2071,154 @@ xpcpp_unit_test_06_01 (const xpc::cut_options & options)
       }
       else
       {
-         // xpc::cut::show(options, _("No values to show in this test"));
+         const char * filename = "initree_07_07.ini";
+         ok = write_stamped_ini(filename, 1, false);
 
-         if (status.next_subtest("xpc::binstring default"))
+         xpc::reloadable_initree config(filename);
+         if (status.next_subtest("First load"))
          {
-            xpc::binstring bs;                     /* construct by default    */
-            ok = bs.size() == 0;
             if (ok)
-               ok = bs.length() == 0;
+               ok = config.generation() == 1;
 
             if (ok)
-               ok = bs.empty();
+            {
+               xpc::reloadable_initree::reader r(config);
+               ok = r->generation() == 1 &&
+                  r->lookup().value("Server", "stamp") == "1" &&
+                  r->tree().size() == 2;
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("Reloads under readers"))
+         {
+            /*
+             * The readers check that both stamps of every snapshot they
+             * see match, and that snapshots never go backward.
+             */
+
+            std::atomic<bool> done(false);
+            std::atomic<long> reads(0);
+            std::atomic<long> mismatches(0);
+            std::vector<std::thread> readers;
+            for (int t = 0; t < 3; ++t)
+            {
+               readers.push_back
+               (
+                  std::thread
+                  (
+                     [&config, &done, &reads, &mismatches] ()
+                     {
+                        unsigned long last = 0;
+                        while (! done)
+                        {
+                           xpc::reloadable_initree::reader r(config);
+                           const xpc::frozen_initree & f = r->lookup();
+                           if
+                           (
+                              f.value("", "stamp") !=
+                                 f.value("Server", "stamp") ||
+                              r->generation() < last
+                           )
+                           {
+                              ++mismatches;
+                           }
+                           last = r->generation();
+                           ++reads;
+                        }
+                     }
+                  )
+               );
+            }
+            for (int stamp = 2; ok && stamp <= 30; ++stamp)
+            {
+               ok = write_stamped_ini(filename, stamp, false);
+               if (ok)
+                  ok = config.reload();
+            }
+            done = true;
+            for (size_t t = 0; t < readers.size(); ++t)
+               readers[t].join();
 
             if (ok)
-               ok = std::string(bs) == "";
+               ok = config.generation() == 30 && mismatches == 0 && reads > 0;
 
             if (ok)
-               ok = bs.is_binary();
+            {
+               xpc::reloadable_initree::reader r(config);
+               ok = r->lookup().value("", "stamp") == "30";
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("Bad file keeps the snapshot"))
+         {
+            FILE * fp = fopen(filename, "w");
+            ok = not_NULL(fp);
+            if (ok)
+            {
+               fprintf(fp, "stamp = 31\n1bad\n");
+               ok = fclose(fp) == 0;
+            }
+            if (ok)
+               ok = ! config.reload() && config.generation() == 30;
+
+            if (ok)
+            {
+               xpc::reloadable_initree::reader r(config);
+               ok = r->lookup().value("", "stamp") == "30";
+            }
+            status.pass(ok);
+         }
+         if (status.next_subtest("Watching"))
+         {
+            ok = config.watch() && config.watching();
+            if (ok)
+               ok = write_stamped_ini(filename, 32, true);   /* by rename */
+
+            for (int wait = 0; ok && wait < 200; ++wait)
+            {
+               if (config.generation() > 30)
+                  break;
+
+               xpc_ms_sleep(10);
+            }
+            if (ok)
+               ok = config.generation() == 31;
+
+            if (ok)
+            {
+               xpc::reloadable_initree::reader r(config);
+               ok = r->lookup().value("Server", "stamp") == "32";
+            }
+            config.stop();
+            if (ok)
+               ok = ! config.watching();
 
             status.pass(ok);
          }
+         (void) remove(filename);
       }
    }
    return status;
 }
 
 /******************************************************************************
- * xpcpp_unit_test_06_02()
+ * xpcpp_unit_test_08_01()
  *------------------------------------------------------------------------*//**
  *
- *    Provides a test of the xpc::binstring class.
+ *    Provides a test of the xpc::thread_pool class.
  *
  * \group
- *    6. xpc::binstring
+ *    8. xpc::thread_pool
  *
  * \case
- *    2. String constructor
+ *    1. Tasks, futures, and shutdown
  *
  * \tests
- *    -  xpc::binstring(const std::string &))
+ *    -  xpc::thread_pool()
+ *    -  xpc::thread_pool::submit()
+ *    -  xpc::thread_pool::async()
+ *    -  xpc::thread_pool::wait()
+ *    -  xpc::thread_pool::shutdown()
  *
  * \param options
  *    Provides the command-line options for the unit-test application.
@@ -633,11 +2229,11 @@ xpcpp_unit_test_06_01 (const xpc::cut_options & options)
  *//*-------------------------------------------------------------------------*/
 
 static xpc::cut_status
-xpcpp_unit_test_06_02 (const xpc::cut_options & options)
+xpcpp_unit_test_08_01 (const xpc::cut_options & options)
 {
    xpc::cut_status status
    (
-      options, 6, 2, "xpc::binstring", _("String constructor")
+      options, 8, 1, "xpc::thread_pool", _("Tasks, futures, and shutdown")
    );
    bool ok = status.valid();        /* note that invalidity is /not/ an error */
    if (ok)
@@ -648,59 +2244,63 @@ xpcpp_unit_test_06_02 (const xpc::cut_options & options)
       }
       else
       {
-         // xpc::cut::show(options, _("No values to show in this test"));
-         if (status.next_subtest("xpc::binstring('hello')"))
+         xpc::thread_pool pool(3);
+         std::atomic<int> count(0);
+         if (status.next_subtest("Construction"))
          {
-            std::string s("Hello");
-            xpc::binstring bs(s);
-            ok = bs.size() == 5;
-            if (ok)
-               ok = bs.length() == 5;
-
-            if (ok)
-               ok = ! bs.empty();
-
-            if (ok)
-               ok = std::string(bs) == "Hello";
+            ok = pool.size() == 3;
+            status.pass(ok);
+         }
+         if (status.next_subtest("Submit and wait"))
+         {
+            for (int t = 0; ok && t < 500; ++t)
+               ok = pool.submit([&count] () { ++count; });
 
+            pool.wait();
             if (ok)
-               ok = bs.is_binary();
+               ok = count == 500;
 
-            if (ok)
+            status.pass(ok);
+         }
+         if (status.next_subtest("Futures"))
+         {
+            std::future<int> f = pool.async([] () { return 6 * 7; });
+            std::future<std::string> g = pool.async
+            (
+               [] () { return std::string("pooled"); }
+            );
+            ok = f.get() == 42 && g.get() == "pooled";
+            status.pass(ok);
+         }
+         if (status.next_subtest("Exception in a future"))
+         {
+            std::future<int> f = pool.async
+            (
+               [] () -> int { throw std::logic_error("task failed"); }
+            );
+            try
             {
-               std::string hexversion = xpc::string_as_hex(std::string(bs));
-               if (options.show_values())
-               {
-                  std::cout << hexversion;
-               }
+               (void) f.get();
+               ok = false;
+            }
+            catch (const std::logic_error &)
+            {
+               ok = true;
             }
             status.pass(ok);
          }
-         if (status.next_subtest("xpc::binstring('Ctrl-A to E')"))
+         if (status.next_subtest("Graceful shutdown"))
          {
-            std::string s("\x01\x02\x03\x04\x05");
-            xpc::binstring bs(s);
-            ok = bs.size() == 5;
-            if (ok)
-               ok = bs.length() == 5;
-
-            if (ok)
-               ok = ! bs.empty();
+            for (int t = 0; ok && t < 500; ++t)
+               ok = pool.submit([&count] () { ++count; });
 
+            pool.shutdown();
             if (ok)
-               ok = std::string(bs) == "\x01\x02\x03\x04\x05";
+               ok = count == 1000 && pool.size() == 0;
 
             if (ok)
-               ok = bs.is_binary();
+               ok = ! pool.submit([&count] () { ++count; });
 
-            if (ok)
-            {
-               std::string hexversion = xpc::string_as_hex(std::string(bs));
-               if (options.show_values())
-               {
-                  std::cout << hexversion;
-               }
-            }
             status.pass(ok);
          }
       }
@@ -709,19 +2309,62 @@ xpcpp_unit_test_06_02 (const xpc::cut_options & options)
 }
 
 /******************************************************************************
- * xpcpp_unit_test_07_01()
+ * queue_producer(), queue_consumer()
  *------------------------------------------------------------------------*//**
  *
- *    Provides a test of the xpc::initree class.
+ *    Thread functions for xpcpp_unit_test_09_01().  Each producer pushes
+ *    the integers 1 to 5000 into an xpc::mpmc_queue<long>, and each
+ *    consumer adds up what it pops until the queue is closed.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+struct queue_job
+{
+   xpc::mpmc_queue<long> * m_Queue;
+   long m_Sum;
+};
+
+static void *
+queue_producer (void * data)
+{
+   queue_job * job = static_cast<queue_job *>(data);
+   for (long i = 1; i <= 5000; ++i)
+      (void) job->m_Queue->push_wait(i);
+
+   return data;
+}
+
+static void *
+queue_consumer (void * data)
+{
+   queue_job * job = static_cast<queue_job *>(data);
+   long item;
+   while (job->m_Queue->pop_wait(item))
+      job->m_Sum += item;
+
+   return data;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_09_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::spsc_queue and xpc::mpmc_queue templates.
  *
  * \group
- *    7. xpc::initree
+ *    9. xpc::spsc_queue, xpc::mpmc_queue
  *
  * \case
- *    1. Default constructor
+ *    1. Push, pop, batches, and blocking
  *
  * \tests
- *    -  xpc::initree()
+ *    -  xpc::spsc_queue::push()
+ *    -  xpc::spsc_queue::pop()
+ *    -  xpc::spsc_queue::push_batch()
+ *    -  xpc::spsc_queue::pop_batch()
+ *    -  xpc::mpmc_queue::push_wait()
+ *    -  xpc::mpmc_queue::pop_wait()
+ *    -  xpc::mpmc_queue::close()
  *
  * \param options
  *    Provides the command-line options for the unit-test application.
@@ -732,11 +2375,11 @@ xpcpp_unit_test_06_02 (const xpc::cut_options & options)
  *//*-------------------------------------------------------------------------*/
 
 static xpc::cut_status
-xpcpp_unit_test_07_01 (const xpc::cut_options & options)
+xpcpp_unit_test_09_01 (const xpc::cut_options & options)
 {
    xpc::cut_status status
    (
-      options, 7, 1, "xpc::initree", _("Default constructor")
+      options, 9, 1, "xpc::mpmc_queue", _("Push, pop, batches, and blocking")
    );
    bool ok = status.valid();        /* note that invalidity is /not/ an error */
    if (ok)
@@ -747,43 +2390,116 @@ xpcpp_unit_test_07_01 (const xpc::cut_options & options)
       }
       else
       {
-         if (status.next_subtest("xpc::initree default"))
+         if (status.next_subtest("SPSC of strings"))
          {
-            /*
-             * The constructors of initree always create an unnamed section,
-             * so there is always at least one section in the initree.
-             */
+            xpc::spsc_queue<std::string> q(3);
+            std::string s;
+            ok = q.capacity() == 4;
+            for (int i = 0; ok && i < 4; ++i)
+               ok = q.push(std::string(1, char('a' + i)));
 
-            xpc::initree it;                     /* construct by default    */
-            ok = it.size() == 1;
+            if (ok)
+               ok = ! q.push("e") && q.size() == 4;
 
             if (ok)
-               ok = ! it.empty();
+               ok = q.pop(s) && s == "a";
+
+            if (ok)
+               ok = q.push("e");
+
+            std::string out[8];
+            if (ok)
+               ok = q.pop_batch(out, 8) == 4 && out[0] == "b" && out[3] == "e";
+
+            if (ok)
+               ok = ! q.pop(s) && q.size() == 0;
+
+            status.pass(ok);
+         }
+         if (status.next_subtest("MPMC batches"))
+         {
+            xpc::mpmc_queue<int> q(8);
+            int in[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+            int out[10];
+            ok = q.push_batch(in, 10) == 8 && q.size() == 8;
+            if (ok)
+               ok = q.pop_batch(out, 10) == 8 && out[0] == 0 && out[7] == 7;
+
+            if (ok)
+               ok = q.pop_batch(out, 10) == 0;
 
             status.pass(ok);
          }
+         if (status.next_subtest("MPMC threads"))
+         {
+            xpc::mpmc_queue<long> q(16);
+            queue_job jobs[4];
+            pthread_t threads[4];
+            for (int t = 0; t < 4; ++t)
+            {
+               jobs[t].m_Queue = &q;
+               jobs[t].m_Sum = 0;
+               void * (* func) (void *) =
+                  t < 2 ? queue_consumer : queue_producer ;
 
-         /* MORE TESTS NEEDED */
+               if (pthread_create(&threads[t], NULL, func, &jobs[t]) != 0)
+                  ok = false;
+            }
+            if (ok)
+            {
+               (void) pthread_join(threads[2], NULL);
+               (void) pthread_join(threads[3], NULL);
+               q.close();
+               (void) pthread_join(threads[0], NULL);
+               (void) pthread_join(threads[1], NULL);
+               ok = jobs[0].m_Sum + jobs[1].m_Sum == 2 * (5000L * 5001 / 2);
+            }
+            if (ok)
+               ok = q.closed() && ! q.push_wait(1);
 
+            status.pass(ok);
+         }
       }
    }
    return status;
 }
 
 /******************************************************************************
- * xpcpp_unit_test_07_02()
+ * timed_twice()
  *------------------------------------------------------------------------*//**
  *
- *    Provides a test of the xpc::initree class.
+ *    Times its body with XPC_SCOPE_TIMER(), and throws on request, to show
+ *    that a block left by an exception is still recorded.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static int
+timed_twice (int value, bool fail)
+{
+   XPC_SCOPE_TIMER(timed_twice);
+   if (fail)
+      throw std::logic_error("timed failure");
+
+   return 2 * value;
+}
+
+/******************************************************************************
+ * xpcpp_unit_test_10_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a test of the xpc::scope_timer class.
  *
  * \group
- *    7. xpc::initree
+ *    10. xpc::scope_timer
  *
  * \case
- *    2. Principal constructor
+ *    1. Scoped zones
  *
  * \tests
- *    -  xpc::initree()
+ *    -  xpc::scope_timer()
+ *    -  xpc::scope_timer::elapsed()
+ *    -  xpc::scope_timer::~scope_timer()
+ *    -  XPC_SCOPE_TIMER()
  *
  * \param options
  *    Provides the command-line options for the unit-test application.
@@ -794,34 +2510,50 @@ xpcpp_unit_test_07_01 (const xpc::cut_options & options)
  *//*-------------------------------------------------------------------------*/
 
 static xpc::cut_status
-xpcpp_unit_test_07_02 (const xpc::cut_options & options)
+xpcpp_unit_test_10_01 (const xpc::cut_options & options)
 {
    xpc::cut_status status
    (
-      options, 7, 2, "xpc::initree", _("Principle constructor")
+      options, 10, 1, "xpc::scope_timer", _("Scoped zones")
    );
    bool ok = status.valid();        /* note that invalidity is /not/ an error */
    if (ok)
    {
-      if (! status.can_proceed())                  /* is test allowed to run? */
+      xpc_histogram_t * h = new xpc_histogram_t;
+      if (status.next_subtest("Explicit zone"))
       {
-         status.pass();                            /* no, force it to pass    */
+         static xpc_profile_zone_t zone = { "explicit", 0 };
+         {
+            xpc::scope_timer timer(zone);
+            xpc_ms_sleep(2);
+            ok = timer.elapsed() >= 1900000;
+         }
+         if (ok)
+            ok = xpc_profile_merge("explicit", h) && h->m_Count == 1;
+
+         status.pass(ok);
       }
-      else
+      if (status.next_subtest("Macro and exceptions"))
       {
-         if (status.next_subtest("INI file smoke test"))
+         int total = 0;
+         for (int i = 0; i < 5; ++i)
          {
-            xpc::initree it("Smoke", "initree.ini");
-            ok = it.size() > 0;
-            if (ok)
+            try
             {
-               if (options.is_verbose())
-                  xpc::show("Unit Test 07.02", it);
+               total += timed_twice(i, (i % 2) != 0);
+            }
+            catch (const std::logic_error &)
+            {
+               // expected for odd values
             }
-
-            status.pass(ok);
          }
+         ok = total == 2 * (0 + 2 + 4);
+         if (ok)
+            ok = xpc_profile_merge("timed_twice", h) && h->m_Count == 5;
+
+         status.pass(ok);
       }
+      delete h;
    }
    return status;
 }
@@ -947,6 +2679,10 @@ XPCPP_TEST_NAME "-specific options:\n"
             if (ok)
             {
                (void) testbattery.load(xpcpp_unit_test_05_02);
+               (void) testbattery.load(xpcpp_unit_test_05_03);
+               (void) testbattery.load(xpcpp_unit_test_05_04);
+               (void) testbattery.load(xpcpp_unit_test_05_05);
+               (void) testbattery.load(xpcpp_unit_test_05_06);
             }
          }
          if (ok)
@@ -963,8 +2699,21 @@ XPCPP_TEST_NAME "-specific options:\n"
             if (ok)
             {
                (void) testbattery.load(xpcpp_unit_test_07_02);
+               (void) testbattery.load(xpcpp_unit_test_07_03);
+               (void) testbattery.load(xpcpp_unit_test_07_04);
+               (void) testbattery.load(xpcpp_unit_test_07_05);
+               (void) testbattery.load(xpcpp_unit_test_07_06);
+               (void) testbattery.load(xpcpp_unit_test_07_07);
             }
          }
+         if (ok)
+            ok = testbattery.load(xpcpp_unit_test_08_01);
+
+         if (ok)
+            ok = testbattery.load(xpcpp_unit_test_09_01);
+
+         if (ok)
+            ok = testbattery.load(xpcpp_unit_test_10_01);
       }
       if (ok)
          ok = testbattery.run();
@@ -0,0 +1,222 @@
+#ifndef XPC_ATOMIX_H
+#define XPC_ATOMIX_H
+
+/******************************************************************************
+ * atomix.h
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          atomix.h
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-03
+ * \updates       2013-08-05
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a small set of macros for atomic operations, thread-local
+ *    storage, and cache-line alignment, usable in both C and C++ code.
+ *
+ *    These macros cover only what the XPC library needs for its lock-free
+ *    paths (e.g. the asynchronous error-log ring in errorlogging.c).  They
+ *    are not a replacement for C11 <stdatomic.h> or C++11 <atomic>, which
+ *    the XPC C code cannot yet assume.
+ *
+ *    The memory-ordering suffixes follow the C11 names:
+ *
+ *       -  The plain forms are acquire (loads), release (stores), or
+ *          acquire-release (read-modify-write operations).
+ *       -  The "_relaxed" forms impose no ordering, and are meant for
+ *          statistics and fast-path flag checks.
+ *
+ * \gnu
+ *    GCC 4.7 and above (and clang) provide the __atomic builtins.  Older
+ *    GCC versions fall back to the __sync builtins, which are all full
+ *    barriers, and thus stronger (and slower) than needed.
+ *
+ * \win32
+ *    Visual C uses volatile accesses plus compiler barriers for loads and
+ *    stores (sufficient for x86/x64), and the Interlocked intrinsics for
+ *    the read-modify-write operations.  Only 32-bit and 64-bit operands
+ *    are supported there.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/macros.h>                /* __GNUC__ and other macros           */
+
+/******************************************************************************
+ * XPC_CACHE_LINE_SIZE
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the assumed size of a cache line, for padding data that is
+ *    written by different threads.
+ *
+ * \hardwired
+ *    64 bytes is correct for all current x86, x64, and most ARM processors.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_CACHE_LINE_SIZE      64
+
+/******************************************************************************
+ * xpc_cache_aligned and xpc_thread_local
+ *------------------------------------------------------------------------*//**
+ *
+ *    Declaration modifiers for aligning a variable to a cache line, and
+ *    for giving a static variable one instance per thread.
+ *
+ *    Note that xpc_thread_local can be applied only to static or global
+ *    variables with a constant initializer.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifdef _MSC_VER
+#define xpc_cache_aligned        __declspec(align(64))
+#define xpc_thread_local         __declspec(thread)
+#else
+#define xpc_cache_aligned        __attribute__((aligned(XPC_CACHE_LINE_SIZE)))
+#define xpc_thread_local         __thread
+#endif
+
+/******************************************************************************
+ * xpc_cpu_relax()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tells the processor that the caller is in a spin-wait loop.  On x86
+ *    this is the PAUSE instruction, which saves power and avoids a memory
+ *    order violation penalty upon leaving the loop.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#if defined _MSC_VER
+#include <intrin.h>
+#define xpc_cpu_relax()          _mm_pause()
+#elif defined __i386__ || defined __x86_64__
+#define xpc_cpu_relax()          __asm__ __volatile__ ("pause" ::: "memory")
+#elif defined __aarch64__ || defined __arm__
+#define xpc_cpu_relax()          __asm__ __volatile__ ("yield" ::: "memory")
+#else
+#define xpc_cpu_relax()          __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+/******************************************************************************
+ * Atomic operations
+ *------------------------------------------------------------------------*//**
+ *
+ *    Each macro takes a pointer to the (properly-aligned) variable.
+ *
+ *    -  xpc_atomic_load(p), xpc_atomic_load_relaxed(p).
+ *    -  xpc_atomic_store(p, v), xpc_atomic_store_relaxed(p, v).
+ *    -  xpc_atomic_add(p, v).  Returns the value before the addition.
+ *    -  xpc_atomic_add_relaxed(p, v).  The same, but with no ordering.
+ *    -  xpc_atomic_exchange(p, v).  Returns the previous value.
+ *    -  xpc_atomic_or(p, v), xpc_atomic_and(p, v).  Bitwise operations for
+ *       setting and clearing flag bits.  Each returns the previous value.
+ *    -  xpc_atomic_cas(p, e, d).  If *p equals *e, stores d into *p and
+ *       returns true.  Otherwise, copies *p into *e and returns false.  It
+ *       may fail spuriously, and so is meant to be used in a loop.
+ *    -  xpc_atomic_fence().  A full memory barrier.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#if defined __clang__ || \
+   (defined __GNUC__ && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+
+#define xpc_atomic_load(p)             __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define xpc_atomic_load_relaxed(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define xpc_atomic_store(p, v)         __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define xpc_atomic_store_relaxed(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define xpc_atomic_add(p, v)           __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#define xpc_atomic_add_relaxed(p, v)   __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define xpc_atomic_exchange(p, v)      __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#define xpc_atomic_or(p, v)            __atomic_fetch_or((p), (v), __ATOMIC_ACQ_REL)
+#define xpc_atomic_and(p, v)           __atomic_fetch_and((p), (v), __ATOMIC_ACQ_REL)
+#define xpc_atomic_cas(p, e, d) \
+   __atomic_compare_exchange_n((p), (e), (d), 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define xpc_atomic_fence()             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#elif defined __GNUC__
+
+#define xpc_atomic_load(p)             __sync_fetch_and_add((p), 0)
+#define xpc_atomic_load_relaxed(p)     (*(volatile __typeof__(*(p)) *)(p))
+#define xpc_atomic_store(p, v)         \
+   do { __sync_synchronize(); *(volatile __typeof__(*(p)) *)(p) = (v); } while (0)
+#define xpc_atomic_store_relaxed(p, v) (*(volatile __typeof__(*(p)) *)(p) = (v))
+#define xpc_atomic_add(p, v)           __sync_fetch_and_add((p), (v))
+#define xpc_atomic_add_relaxed(p, v)   __sync_fetch_and_add((p), (v))
+#define xpc_atomic_exchange(p, v)      \
+   (__sync_synchronize(), __sync_lock_test_and_set((p), (v)))
+#define xpc_atomic_or(p, v)            __sync_fetch_and_or((p), (v))
+#define xpc_atomic_and(p, v)           __sync_fetch_and_and((p), (v))
+#define xpc_atomic_cas(p, e, d)        \
+   __extension__ ({                                                           \
+      __typeof__(*(p)) xpc_old_ = __sync_val_compare_and_swap((p), *(e), (d)); \
+      (xpc_old_ == *(e)) ? 1 : (*(e) = xpc_old_, 0);                          \
+   })
+#define xpc_atomic_fence()             __sync_synchronize()
+
+#elif defined _MSC_VER
+
+static __inline int
+xpc_msvc_cas32 (volatile long * p, long * e, long d)
+{
+   long old = _InterlockedCompareExchange(p, d, *e);
+   if (old == *e)
+      return 1;
+
+   *e = old;
+   return 0;
+}
+
+static __inline int
+xpc_msvc_cas64 (volatile __int64 * p, __int64 * e, __int64 d)
+{
+   __int64 old = _InterlockedCompareExchange64(p, d, *e);
+   if (old == *e)
+      return 1;
+
+   *e = old;
+   return 0;
+}
+
+#define xpc_atomic_load(p)             (_ReadWriteBarrier(), *(p))
+#define xpc_atomic_load_relaxed(p)     (*(p))
+#define xpc_atomic_store(p, v)         \
+   do { _ReadWriteBarrier(); *(p) = (v); } while (0)
+#define xpc_atomic_store_relaxed(p, v) (*(p) = (v))
+#define xpc_atomic_add(p, v)           \
+   ((sizeof(*(p)) == 8) ?                                                     \
+      _InterlockedExchangeAdd64((volatile __int64 *)(p), (__int64)(v)) :     \
+      _InterlockedExchangeAdd((volatile long *)(p), (long)(v)))
+#define xpc_atomic_add_relaxed(p, v)   xpc_atomic_add(p, v)
+#define xpc_atomic_exchange(p, v)      \
+   ((sizeof(*(p)) == 8) ?                                                     \
+      _InterlockedExchange64((volatile __int64 *)(p), (__int64)(v)) :        \
+      _InterlockedExchange((volatile long *)(p), (long)(v)))
+#define xpc_atomic_or(p, v)            \
+   ((sizeof(*(p)) == 8) ?                                                     \
+      _InterlockedOr64((volatile __int64 *)(p), (__int64)(v)) :              \
+      _InterlockedOr((volatile long *)(p), (long)(v)))
+#define xpc_atomic_and(p, v)           \
+   ((sizeof(*(p)) == 8) ?                                                     \
+      _InterlockedAnd64((volatile __int64 *)(p), (__int64)(v)) :             \
+      _InterlockedAnd((volatile long *)(p), (long)(v)))
+#define xpc_atomic_cas(p, e, d)        \
+   ((sizeof(*(p)) == 8) ?                                                     \
+      xpc_msvc_cas64((volatile __int64 *)(p), (__int64 *)(e), (__int64)(d)) : \
+      xpc_msvc_cas32((volatile long *)(p), (long *)(e), (long)(d)))
+#define xpc_atomic_fence()             MemoryBarrier()
+
+#else
+#error atomix.h requires GCC, clang, or Visual C
+#endif
+
+#endif                                 /* XPC_ATOMIX_H                        */
+
+/******************************************************************************
+ * atomix.h
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
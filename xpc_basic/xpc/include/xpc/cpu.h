@@ -256,6 +256,37 @@ XPC_REVISION_DECL(cpu)                 /* show_xpc_cpu_info()                 */
 #define __FLOAT_WORD_ORDER __BYTE_ORDER
 #endif
 
+/******************************************************************************
+ * XPC_CPU_MAX
+ *------------------------------------------------------------------------*//**
+ *
+ *    The largest number of CPUs the topology functions will list for one
+ *    NUMA node, or for the whole machine.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_CPU_MAX                 1024
+
+/******************************************************************************
+ * xpc_cpu_info_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Describes where a logical CPU sits in the machine, for choosing the
+ *    CPU or NUMA node to pin a thread to.  Logical CPUs with the same core
+ *    and package are hyperthreads of one physical core.  A value that
+ *    cannot be determined is -1.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   int m_Cpu;                          /**< The logical CPU number.           */
+   int m_Core;                         /**< The physical core ID.             */
+   int m_Package;                      /**< The socket (package) ID.          */
+   int m_Node;                         /**< The NUMA node number.             */
+
+} xpc_cpu_info_t;
+
 /******************************************************************************
  * External functions
  *-----------------------------------------------------------------------------
@@ -277,6 +308,12 @@ extern cbool_t xpc_is_64_bit (void);
 extern cbool_t xpc_is_lp64 (void);
 extern cbool_t xpc_is_ilp64 (void);
 extern cbool_t xpc_is_llp64 (void);
+extern int xpc_cpu_count (void);
+extern int xpc_cpu_online_cpus (int * cpus, int maxcpus);
+extern int xpc_cpu_node_count (void);
+extern cbool_t xpc_cpu_info (int cpu, xpc_cpu_info_t * info);
+extern int xpc_cpu_node_cpus (int node, int * cpus, int maxcpus);
+extern void xpc_cpu_topology_show (void);
 
 EXTERN_C_END
 
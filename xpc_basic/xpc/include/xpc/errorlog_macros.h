@@ -36,6 +36,11 @@
          _UNBUFFER         "unbuffer"
          _BUFFER           "buffer"
          _LOG              "log"
+         _LOG_MAX_BYTES    "log-max-bytes"
+         _LOG_MAX_AGE      "log-max-age"
+         _LOG_KEEP         "log-keep"
+         _LOG_RING         "log-ring"
+         _LOG_RATE_LIMIT   "log-rate-limit"
          _DAEMON           "daemon"
          _QUIET            "quiet"
          _SILENT           "silent"
@@ -56,7 +61,12 @@
          _TIME_STAMPS      "time-stamps"
          _NO_TIMESTAMPS    "no-timestamps"
          _NO_TIME_STAMPS   "no-time-stamps"
+         _TIMESTAMP_CLOCK  "timestamp-clock"
          _SYNCH            "synch"
+         _ASYNC_LOG        "async-log"
+         _NO_ASYNC_LOG     "no-async-log"
+         _LOG_BINARY       "log-binary"
+         _NO_LOG_BINARY    "no-log-binary"
          _VERSION          "version"
          _NOT_APPLICABLE   "N/A"
 \endverbatim
@@ -81,6 +91,11 @@
 #define _BUFFER                     "buffer"
 #define _LOG                        "log"
 #define _APPEND                     "append"
+#define _LOG_MAX_BYTES              "log-max-bytes"
+#define _LOG_MAX_AGE                "log-max-age"
+#define _LOG_KEEP                   "log-keep"
+#define _LOG_RING                   "log-ring"
+#define _LOG_RATE_LIMIT             "log-rate-limit"
 #define _SYSLOG                     "syslog"
 #define _NO_SYSLOG                  "no-syslog"
 #define _DAEMON                     "daemon"
@@ -104,8 +119,13 @@
 #define _TIME_STAMPS                "time-stamps"
 #define _NO_TIMESTAMPS              "no-timestamps"
 #define _NO_TIME_STAMPS             "no-time-stamps"
+#define _TIMESTAMP_CLOCK            "timestamp-clock"
 #define _SYNCH                      "synch"
 #define _NO_SYNCH                   "no-synch"
+#define _ASYNC_LOG                  "async-log"
+#define _NO_ASYNC_LOG               "no-async-log"
+#define _LOG_BINARY                 "log-binary"
+#define _NO_LOG_BINARY              "no-log-binary"
 #define _VERSION                    "version"
 #define _NOT_APPLICABLE             "N/A"
 #define CMD(x)                      "--" x
@@ -136,7 +156,24 @@
  *
  *//*-------------------------------------------------------------------------*/
 
-#define ERRL_FMT_TIMESTAMP_MESSAGE        "%s [%d.%06d] %s\n"
+#define ERRL_FMT_TIMESTAMP_MESSAGE        "%s [%d.%09d] %s\n"
+
+/******************************************************************************
+ * ERRL_FMT_TAG
+ *------------------------------------------------------------------------*//**
+ *
+ *    These strings start a line that is rendered in pieces, as done for the
+ *    printf()-style logging functions.  They match the start of
+ *    ERRL_FMT_BASIC_MESSAGE and ERRL_FMT_TIMESTAMP_MESSAGE.
+ *
+ * \private
+ *    These strings are private, and cannot be seen outside the
+ *    errorlogging.c module.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define ERRL_FMT_TAG                      "%s "
+#define ERRL_FMT_TIMESTAMP_TAG            "%s [%d.%09d] "
 
 /******************************************************************************
  * ERRL_FMT_EXT_MESSAGE
@@ -246,6 +283,68 @@
 
 #define XPC_STRERROR_BUFLEN      1024           /* VC won't handle const int  */
 
+/******************************************************************************
+ * XPC_ASYNC_LOG_SLOTS
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the sizes used by the asynchronous error-log ring.
+ *
+ * \hardwired
+ *    -  XPC_ASYNC_LOG_SLOTS is the number of lines the ring can hold before
+ *       the callers have to wait for the writer thread.  It must be a power
+ *       of two.
+ *    -  XPC_ASYNC_LOG_SLOT_SIZE is the longest line, including the tag, the
+ *       time-stamp, and the newline, that fits in a slot.  Longer lines
+ *       are written synchronously.
+ *    -  XPC_ASYNC_LOG_BATCH_SIZE is the size of the writer thread's buffer,
+ *       and thus the most data written by one fwrite() call.  It must be
+ *       at least XPC_ASYNC_LOG_SLOT_SIZE.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_ASYNC_LOG_SLOTS      1024           /* must be a power of two     */
+#define XPC_ASYNC_LOG_SLOT_SIZE  512
+#define XPC_ASYNC_LOG_BATCH_SIZE (32 * 1024)
+
+/******************************************************************************
+ * XPC_FORMAT_BUFFER_SIZE
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the starting size of the per-thread format buffer used by
+ *    the "ex" and "strerr" logging functions.
+ *
+ * \hardwired
+ *    The buffer doubles in size whenever a message does not fit, so this
+ *    value only needs to cover the typical message.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_FORMAT_BUFFER_SIZE   256
+
+/******************************************************************************
+ * XPC_ERRLOG_USE_COLOR
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the flag bits of the xpc_errlog_state word.  The low bits of
+ *    that word hold the error-level (see XPC_ERRLOG_LEVEL_MASK in
+ *    errorlogging.h).
+ *
+ *    -  XPC_ERRLOG_USE_COLOR is set by --color, cleared by --mono.
+ *    -  XPC_ERRLOG_TIMESTAMPS is set by --timestamps.
+ *    -  XPC_ERRLOG_SYNCH is set by --synch.
+ *    -  XPC_ERRLOG_SYSLOG is set by --syslog.
+ *    -  XPC_ERRLOG_BINARY is set by --log-binary.
+ *    -  XPC_ERRLOG_RATELIMIT, 0x200, is set by --log-rate-limit.  It is
+ *       defined in errorlogging.h, since the call-site macros test it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_ERRLOG_USE_COLOR     0x00000010u
+#define XPC_ERRLOG_TIMESTAMPS    0x00000020u
+#define XPC_ERRLOG_SYNCH         0x00000040u
+#define XPC_ERRLOG_SYSLOG        0x00000080u
+#define XPC_ERRLOG_BINARY        0x00000100u
+
 /******************************************************************************
  * errorlog_macros.h
  *-----------------------------------------------------------------------------
@@ -26,6 +26,7 @@
  *//*-------------------------------------------------------------------------*/
 
 #include <xpc/macros.h>             /* EXTERN_C_DEC and EXTERN_C_END          */
+#include <xpc/atomix.h>             /* xpc_atomic_load_relaxed()              */
 #include <stdio.h>                  /* FILE *                                 */
 XPC_REVISION_DECL(errorlogging)     /* extern void show_errorlogging_info()   */
 
@@ -34,6 +35,9 @@ XPC_REVISION_DECL(errorlogging)     /* extern void show_errorlogging_info()   */
  *------------------------------------------------------------------------*//**
  *
  *    These macros encapsulate what has turned out to be a common idiom.
+ *    The first three log through the call-site macros (see "Call-site
+ *    logging" below), and so do not evaluate the message if the level
+ *    filters it out.
  *
  *//*-------------------------------------------------------------------------*/
 
@@ -47,9 +51,9 @@ XPC_REVISION_DECL(errorlogging)     /* extern void show_errorlogging_info()   */
 
 #else
 
-#define xpc_errprint_func(x)            xpc_errprintex((x), __func__)
-#define xpc_warnprint_func(x)           xpc_warnprintex((x), __func__)
-#define xpc_infoprint_func(x)           xpc_infoprintex((x), __func__)
+#define xpc_errprint_func(x)            xpc_errprintex_here((x), __func__)
+#define xpc_warnprint_func(x)           xpc_warnprintex_here((x), __func__)
+#define xpc_infoprint_func(x)           xpc_infoprintex_here((x), __func__)
 #define xpc_strerrprint_func(x, err)    xpc_strerrprintex((x), __func__, err)
 #define xpc_strerrnoprint_func(x)       xpc_strerrnoprintex((x), __func__)
 
@@ -77,6 +81,16 @@ extern void xpc_print_debug (const char * msg);
 extern void xpc_dbginfoprintf (const char * fmt, ...);
 EXTERN_C_END
 
+/*
+ * The macro checks the level inline, so that a filtered-out call costs one
+ * load and one branch, and its arguments are never evaluated.  The name
+ * inside the expansion is not re-expanded, and so calls the function.  It
+ * is still an expression, as the function call was.
+ */
+
+#define xpc_dbginfoprintf(...) \
+   (xpc_showinfo_fast() ? xpc_dbginfoprintf(__VA_ARGS__) : (void) 0)
+
 #else                               /* not DEBUG                              */
 
 #define xpc_dbginfoprint(x)
@@ -85,6 +99,12 @@ EXTERN_C_DEC
 extern void xpc_dbginfoprintf (const char * fmt, ...);
 EXTERN_C_END
 
+/*
+ * The function remains in the library for binary compatibility, but callers
+ * compiled without DEBUG no longer even evaluate the arguments.
+ */
+
+#define xpc_dbginfoprintf(...)             ((void) 0)
 #define xpc_dbginfoprintex(x, y)
 #define xpc_dbginfoprint_func(x)
 #define xpc_print_debug(x)
@@ -142,6 +162,84 @@ typedef enum
 
 } xpc_errlevel_t;
 
+/******************************************************************************
+ * Fast error-level checks
+ *------------------------------------------------------------------------*//**
+ *
+ *    The error-level and the boolean logging options (color, time-stamps,
+ *    output synchronization, and system logging) are packed into the single
+ *    word xpc_errlog_state.  The level occupies the bits covered by
+ *    XPC_ERRLOG_LEVEL_MASK.  XPC_ERRLOG_RATELIMIT is set while
+ *    xpc_ratelimit_set() has a limit in force, for the call-site macros
+ *    below; the other flag bits are private to the errorlogging module
+ *    (see errorlog_macros.h).
+ *
+ *    The word is statically initialized, so no lazy initialization is
+ *    needed, and a relaxed atomic load is enough to read it.  A thread that
+ *    sees a new error-level a few messages late does no harm.
+ *
+ *    The xpc_errlevel_fast() and xpc_show..._fast() macros expand inline,
+ *    and are meant for inner loops, where even a function call is too much.
+ *    The xpc_errlevel() and xpc_show...() functions return the same
+ *    answers.  Never write xpc_errlog_state directly; use
+ *    xpc_errlevel_set() and the other setter functions.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_ERRLOG_LEVEL_MASK          0x0000000Fu
+#define XPC_ERRLOG_RATELIMIT           0x00000200u
+
+EXTERN_C_DEC
+extern unsigned xpc_errlog_state;
+EXTERN_C_END
+
+#define xpc_errlevel_fast() \
+   ((xpc_errlevel_t) \
+      (xpc_atomic_load_relaxed(&xpc_errlog_state) & XPC_ERRLOG_LEVEL_MASK))
+
+#define xpc_showerrors_fast()    (xpc_errlevel_fast() >= XPC_ERROR_LEVEL_ERRORS)
+#define xpc_showwarnings_fast()  (xpc_errlevel_fast() >= XPC_ERROR_LEVEL_WARNINGS)
+#define xpc_showinfo_fast()      (xpc_errlevel_fast() >= XPC_ERROR_LEVEL_INFO)
+
+#define xpc_ratelimit_fast() \
+   ((xpc_atomic_load_relaxed(&xpc_errlog_state) & XPC_ERRLOG_RATELIMIT) != 0)
+
+/******************************************************************************
+ * XPC_LOG_KEEP_DEFAULT
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the default and the largest number of old log files kept by
+ *    log rotation.  See xpc_logrotation_set().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_LOG_KEEP_DEFAULT     5
+#define XPC_LOG_KEEP_MAX         999
+
+/******************************************************************************
+ * xpc_timestamp_clock_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the clocks that can be read for the time-stamps of the log
+ *    lines.  See xpc_timestamp_clock_set().
+ *
+ *    -  XPC_TIMESTAMP_CLOCK_WALL reads the real-time clock for each line.
+ *       This is the default.
+ *    -  XPC_TIMESTAMP_CLOCK_COARSE reads the coarse monotonic clock, which
+ *       is cheap, but advances only once per kernel tick.
+ *    -  XPC_TIMESTAMP_CLOCK_TSC reads the time-stamp counter of the
+ *       processor, calibrated against the monotonic clock.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef enum
+{
+   XPC_TIMESTAMP_CLOCK_WALL,
+   XPC_TIMESTAMP_CLOCK_COARSE,
+   XPC_TIMESTAMP_CLOCK_TSC
+
+} xpc_timestamp_clock_t;
+
 /******************************************************************************
  * Normal logging
  *-----------------------------------------------------------------------------
@@ -160,6 +258,8 @@ EXTERN_C_DEC
 
 extern cbool_t xpc_timestamps_set (cbool_t flag, cbool_t setbase);
 extern cbool_t xpc_timestamps (void);
+extern cbool_t xpc_timestamp_clock_set (xpc_timestamp_clock_t clock);
+extern xpc_timestamp_clock_t xpc_timestamp_clock (void);
 extern cbool_t xpc_errlevel_set (int errlevel);
 extern cbool_t xpc_parse_errlevel (int argc, char * argv[]);
 extern cbool_t xpc_parse_errlevel_nohelp (int argc, char * argv[]);
@@ -174,6 +274,8 @@ extern FILE * xpc_logfile (void);
 extern cbool_t xpc_open_logfile (const char * logfilename);
 extern cbool_t xpc_append_logfile (const char * logfilename);
 extern cbool_t xpc_close_logfile (void);
+extern cbool_t xpc_logrotation_set (size_t maxbytes, long maxage, int keep);
+extern cbool_t xpc_logrotate (void);
 extern cbool_t xpc_shownothing (void);
 extern cbool_t xpc_showerrors (void);
 extern cbool_t xpc_showwarnings  (void);
@@ -210,6 +312,46 @@ extern void xpc_infoprint (const char * msg);
 extern void xpc_infoprintf (const char * fmt, ...);
 extern void xpc_infoprintml (const char * fmt, ...);
 extern void xpc_infoprintex (const char * msg, const char * label);
+extern void xpc_errprint_site
+(
+   const char * file, int line, const char * msg
+);
+extern void xpc_errprintf_site
+(
+   const char * file, int line, const char * fmt, ...
+);
+extern void xpc_errprintex_site
+(
+   const char * file, int line, const char * msg, const char * label
+);
+extern void xpc_warnprint_site
+(
+   const char * file, int line, const char * msg
+);
+extern void xpc_warnprintf_site
+(
+   const char * file, int line, const char * fmt, ...
+);
+extern void xpc_warnprintex_site
+(
+   const char * file, int line, const char * msg, const char * label
+);
+extern void xpc_infoprint_site
+(
+   const char * file, int line, const char * msg
+);
+extern void xpc_infoprintf_site
+(
+   const char * file, int line, const char * fmt, ...
+);
+extern void xpc_infoprintml_site
+(
+   const char * file, int line, const char * fmt, ...
+);
+extern void xpc_infoprintex_site
+(
+   const char * file, int line, const char * msg, const char * label
+);
 
 #endif
 
@@ -244,6 +386,88 @@ extern cbool_t xpc_not_nullptr (const void * pointer, const char * funcname);
 
 EXTERN_C_END
 
+/******************************************************************************
+ * Call-site logging
+ *------------------------------------------------------------------------*//**
+ *
+ *    The xpc_..._here() macros log through the xpc_..._site() functions,
+ *    passing the __FILE__ and __LINE__ of the call.  The call site is the
+ *    key of the rate limit (see xpc_ratelimit_set()), so two calls that
+ *    share a message are limited separately.  The plain functions, such as
+ *    xpc_errprintf(), are keyed on the address of their message instead.
+ *
+ *    Like xpc_dbginfoprintf(), the macros check the error-level inline, so
+ *    that a filtered-out call costs one load and one branch, and its
+ *    arguments are never evaluated.  If rate limiting is off, the plain
+ *    function is called, and the site is not passed at all.  The
+ *    xpc_..._func() macros use these macros.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifdef XPC_NO_ERRORLOG
+
+#define xpc_errprint_here(msg)            xpc_no_op()
+#define xpc_errprintf_here(...)           xpc_no_op()
+#define xpc_errprintex_here(msg, label)   xpc_no_op()
+#define xpc_warnprint_here(msg)           xpc_no_op()
+#define xpc_warnprintf_here(...)          xpc_no_op()
+#define xpc_warnprintex_here(msg, label)  xpc_no_op()
+#define xpc_infoprint_here(msg)           xpc_no_op()
+#define xpc_infoprintf_here(...)          xpc_no_op()
+#define xpc_infoprintml_here(...)         xpc_no_op()
+#define xpc_infoprintex_here(msg, label)  xpc_no_op()
+
+#else
+
+#define xpc_errprint_here(msg) \
+   (! xpc_showerrors_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_errprint_site(__FILE__, __LINE__, msg) : xpc_errprint(msg))
+
+#define xpc_errprintf_here(...) \
+   (! xpc_showerrors_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_errprintf_site(__FILE__, __LINE__, __VA_ARGS__) : \
+      xpc_errprintf(__VA_ARGS__))
+
+#define xpc_errprintex_here(msg, label) \
+   (! xpc_showerrors_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_errprintex_site(__FILE__, __LINE__, msg, label) : \
+      xpc_errprintex(msg, label))
+
+#define xpc_warnprint_here(msg) \
+   (! xpc_showwarnings_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_warnprint_site(__FILE__, __LINE__, msg) : xpc_warnprint(msg))
+
+#define xpc_warnprintf_here(...) \
+   (! xpc_showwarnings_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_warnprintf_site(__FILE__, __LINE__, __VA_ARGS__) : \
+      xpc_warnprintf(__VA_ARGS__))
+
+#define xpc_warnprintex_here(msg, label) \
+   (! xpc_showwarnings_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_warnprintex_site(__FILE__, __LINE__, msg, label) : \
+      xpc_warnprintex(msg, label))
+
+#define xpc_infoprint_here(msg) \
+   (! xpc_showinfo_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_infoprint_site(__FILE__, __LINE__, msg) : xpc_infoprint(msg))
+
+#define xpc_infoprintf_here(...) \
+   (! xpc_showinfo_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_infoprintf_site(__FILE__, __LINE__, __VA_ARGS__) : \
+      xpc_infoprintf(__VA_ARGS__))
+
+#define xpc_infoprintml_here(...) \
+   (! xpc_showinfo_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_infoprintml_site(__FILE__, __LINE__, __VA_ARGS__) : \
+      xpc_infoprintml(__VA_ARGS__))
+
+#define xpc_infoprintex_here(msg, label) \
+   (! xpc_showinfo_fast() ? (void) 0 : xpc_ratelimit_fast() ? \
+      xpc_infoprintex_site(__FILE__, __LINE__, msg, label) : \
+      xpc_infoprintex(msg, label))
+
+#endif   // XPC_NO_ERRORLOG
+
 /******************************************************************************
  * Buffering enumeration
  *------------------------------------------------------------------------*//**
@@ -277,8 +501,21 @@ extern int xpc_get_priority (xpc_errlevel_t errlev);
 extern cbool_t xpc_syslogging (void);
 extern cbool_t xpc_synchusage_set (cbool_t flag);
 extern cbool_t xpc_synchusage (void);
+extern cbool_t xpc_async_logging_set (cbool_t flag);
+extern cbool_t xpc_async_logging (void);
+extern cbool_t xpc_binary_logging_set (cbool_t flag);
+extern cbool_t xpc_binary_logging (void);
+extern cbool_t xpc_open_logring (const char * filename, size_t size);
+extern cbool_t xpc_close_logring (void);
+extern cbool_t xpc_ring_logging (void);
+extern cbool_t xpc_ratelimit_set (unsigned rate, unsigned burst);
+extern unsigned xpc_ratelimit (void);
+extern unsigned long xpc_ratelimit_suppressed (const char * site);
+extern unsigned long xpc_ratelimit_suppressed_total (void);
+extern void xpc_ratelimit_report (void);
 extern cbool_t xpc_buffering_set (int btype);
 extern void xpc_flush_error_log (void);
+extern size_t xpc_format_allocations (void);
 
 EXTERN_C_END
 
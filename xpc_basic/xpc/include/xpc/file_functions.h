@@ -70,6 +70,8 @@ extern cbool_t xpc_file_copy
 );
 extern int xpc_file_handle_open (const char * filename, int flags, int mode);
 extern int xpc_file_handle_close (int filehandle, const char * filename);
+extern cbool_t xpc_file_preallocate (FILE * filehandle, size_t size);
+extern cbool_t xpc_file_rotate (const char * filename, int keep);
 
 EXTERN_C_END
 
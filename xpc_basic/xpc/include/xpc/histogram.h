@@ -0,0 +1,104 @@
+#ifndef XPC_HISTOGRAM_H
+#define XPC_HISTOGRAM_H
+
+/******************************************************************************
+ * histogram.h
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          histogram.h
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-17
+ * \updates       2013-08-17
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a fixed-size latency histogram in the style of the HDR
+ *    ("high dynamic range") histogram.
+ *
+ *    Each power-of-2 range of values is split into the same number of
+ *    linear sub-buckets, so that every recorded value is kept to within a
+ *    fixed relative error (1/32, about 3%) from 1 to 2^40 (about 18
+ *    minutes, if the values are nanoseconds).  Recording a value is a few
+ *    shifts and an increment, with no allocation and no search, so it can
+ *    go on a hot path.  Histograms can be merged, and percentiles are
+ *    read back from the bucket counts.
+ *
+ *    A histogram is written by one thread.  xpc_histogram_merge() can read
+ *    it from another thread while it is being written; the result is then
+ *    a consistent-enough snapshot for statistics.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/macros.h>                /* cbool_t, EXTERN_C_DEC, etc.         */
+#include <xpc/integers.h>              /* uint64_t                            */
+
+/******************************************************************************
+ * Histogram layout
+ *------------------------------------------------------------------------*//**
+ *
+ *    XPC_HISTOGRAM_SUB_BITS sets the number of sub-buckets per power of 2
+ *    (2 to that power), and thus the precision.  Values from 0 to twice
+ *    that number get a bucket each.  XPC_HISTOGRAM_MAX_BITS sets the
+ *    largest value that can be told apart; larger values are counted in
+ *    the last bucket, though m_Max still records them exactly.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_HISTOGRAM_SUB_BITS      5
+#define XPC_HISTOGRAM_MAX_BITS      40
+#define XPC_HISTOGRAM_BUCKETS \
+   ((XPC_HISTOGRAM_MAX_BITS - XPC_HISTOGRAM_SUB_BITS + 1) << XPC_HISTOGRAM_SUB_BITS)
+
+/******************************************************************************
+ * xpc_histogram_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the counts of a histogram, and its exact summary values.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   uint64_t m_Count;                   /**< The number of values recorded.    */
+   uint64_t m_Sum;                     /**< Their sum, for the mean.          */
+   uint64_t m_Min;                     /**< The smallest value recorded.      */
+   uint64_t m_Max;                     /**< The largest value recorded.       */
+   uint64_t m_Buckets[XPC_HISTOGRAM_BUCKETS];   /**< The counts per bucket.   */
+
+} xpc_histogram_t;
+
+/******************************************************************************
+ * Global functions
+ *----------------------------------------------------------------------------*/
+
+EXTERN_C_DEC
+
+extern void xpc_histogram_init (xpc_histogram_t * h);
+extern void xpc_histogram_record (xpc_histogram_t * h, uint64_t value);
+extern void xpc_histogram_merge
+(
+   xpc_histogram_t * dest,
+   const xpc_histogram_t * source
+);
+extern uint64_t xpc_histogram_percentile
+(
+   const xpc_histogram_t * h,
+   double percent
+);
+extern double xpc_histogram_mean (const xpc_histogram_t * h);
+extern int xpc_histogram_index (uint64_t value);
+extern uint64_t xpc_histogram_highest_equivalent (int index);
+
+EXTERN_C_END
+
+#endif         // XPC_HISTOGRAM_H
+
+/******************************************************************************
+ * histogram.h
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
@@ -0,0 +1,95 @@
+#ifndef XPC_LOGRECORD_H
+#define XPC_LOGRECORD_H
+
+/******************************************************************************
+ * logrecord.h
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          logrecord.h
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-11
+ * \updates       2013-08-11
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides binary log records, for deferring the formatting of a log
+ *    line.
+ *
+ *    xpc_logrecord_encode() walks a printf()-style format, and copies the
+ *    raw arguments (integers, floating-point values, pointers, and copies
+ *    of the strings) into a compact record, along with the tag, the
+ *    optional time-stamp, and the format itself.  That costs much less
+ *    than vsnprintf().  xpc_logrecord_format() later turns the record into
+ *    the same line that the error-logging functions would have written.
+ *
+ *    The format is copied into the record, rather than just its address,
+ *    so that the caller can pass a format that is not a literal, and so
+ *    that records saved in a file (see logring.h) can be decoded by
+ *    another process.
+ *
+ *    The record layout is private to logrecord.c.  All values are stored
+ *    in the byte order of the machine that wrote them.
+ *
+ *    Not every format can be deferred.  Positional arguments ("%1$d"), the
+ *    %n conversion, and wide characters and strings ("%lc", "%ls") are
+ *    rejected, and the caller formats such a line directly.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/portable.h>              /* cbool_t and other macros            */
+#include <stdarg.h>                    /* va_list                             */
+
+/******************************************************************************
+ * XPC_LOGRECORD_MAX_SIZE
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the size limits of binary log records.
+ *
+ *    -  XPC_LOGRECORD_MAX_SIZE is the largest record the error-log builds.
+ *       It must not exceed XPC_ASYNC_LOG_SLOT_SIZE, so that a record fits
+ *       in a slot of the asynchronous log ring.
+ *    -  XPC_LOGRECORD_TEXT_SIZE is the size of the buffer into which a
+ *       record is formatted.  Longer lines are truncated, but keep their
+ *       newline.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_LOGRECORD_MAX_SIZE      512
+#define XPC_LOGRECORD_TEXT_SIZE     1024
+
+/******************************************************************************
+ * Global functions
+ *----------------------------------------------------------------------------*/
+
+EXTERN_C_DEC
+
+extern size_t xpc_logrecord_encode
+(
+   char * record,
+   size_t size,
+   const char * tag,
+   const int * timestamp,
+   const char * fmt,
+   va_list val
+);
+extern size_t xpc_logrecord_format
+(
+   const char * record,
+   size_t length,
+   char * text,
+   size_t size
+);
+
+EXTERN_C_END
+
+#endif         /* XPC_LOGRECORD_H */
+
+/******************************************************************************
+ * logrecord.h
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
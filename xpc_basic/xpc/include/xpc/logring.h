@@ -0,0 +1,266 @@
+#ifndef XPC_LOGRING_H
+#define XPC_LOGRING_H
+
+/******************************************************************************
+ * logring.h
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          logring.h
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-10
+ * \updates       2013-08-11
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a memory-mapped, fixed-size, circular log file.
+ *
+ *    Appending a line to the ring is a memcpy() plus an atomic update of
+ *    the ring's head; there is no system call, and no lock.  Because the
+ *    file is a shared mapping, the lines are in the kernel's page cache as
+ *    soon as they are copied, and so survive a crash of the process.  (They
+ *    do not survive a crash of the system, unless the pages had already
+ *    been written back.)
+ *
+ *    The file layout is:
+ *
+ *       -  An xpc_logring_header_t, padded to XPC_LOGRING_HEADER_SIZE.
+ *       -  The data area, which holds xpc_logring_record_t headers, each
+ *          followed by the text of its line.  Each record starts on an
+ *          XPC_LOGRING_ALIGN boundary, and a record never wraps around the
+ *          end of the data area; a padding record fills the gap instead.
+ *
+ *    All values are stored in the byte order of the machine that wrote
+ *    them.
+ *
+ *    The errorlogging.c module uses the ring as an optional log sink (see
+ *    xpc_open_logring()), and the logring_dump program in xpc/tests
+ *    decodes a ring file with xpc_logring_walk().  A ring can mix text
+ *    records with binary log records (see logrecord.h), which are
+ *    formatted only when the ring is walked.
+ *
+ * \win32
+ *    Not yet supported.  xpc_logring_open() returns 'false'.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/portable.h>              /* cbool_t and other macros            */
+#include <xpc/integers.h>              /* uint32_t and uint64_t               */
+
+/******************************************************************************
+ * XPC_LOGRING_MAGIC
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the constants of the ring-file format.
+ *
+ *    -  XPC_LOGRING_MAGIC marks a ring file ("XPCR").
+ *    -  XPC_LOGRING_RECORD_MAGIC marks a complete record.  It is stored
+ *       last, so that a record interrupted by a crash is not decoded.
+ *    -  XPC_LOGRING_BINARY_MAGIC marks a complete record that holds a
+ *       binary log record (see logrecord.h) instead of text.
+ *    -  XPC_LOGRING_PAD_MAGIC marks a padding record at the end of the data
+ *       area.
+ *    -  XPC_LOGRING_HEADER_SIZE is the space taken by the file header.
+ *    -  XPC_LOGRING_ALIGN is the alignment of the records.
+ *    -  XPC_LOGRING_DEFAULT_SIZE is the size of the data area used by the
+ *       --log-ring option.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_LOGRING_MAGIC           0x52435058u
+#define XPC_LOGRING_VERSION         1
+#define XPC_LOGRING_RECORD_MAGIC    0x4C47u
+#define XPC_LOGRING_BINARY_MAGIC    0x4C42u
+#define XPC_LOGRING_PAD_MAGIC       0x5044u
+#define XPC_LOGRING_HEADER_SIZE     64
+#define XPC_LOGRING_ALIGN           16
+#define XPC_LOGRING_DEFAULT_SIZE    (1024 * 1024)
+
+/******************************************************************************
+ * xpc_logring_header_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the header at the start of a ring file.
+ *
+ *    The head is the total number of bytes ever reserved in the data area,
+ *    so the offset of the next record is m_Head modulo m_Size.  Once
+ *    m_Head exceeds m_Size, the ring has wrapped, and the oldest lines are
+ *    being overwritten.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    Holds XPC_LOGRING_MAGIC.
+    */
+
+   uint32_t m_Magic;
+
+   /**
+    *    Holds XPC_LOGRING_VERSION.
+    */
+
+   uint32_t m_Version;
+
+   /**
+    *    The size of the data area, a multiple of XPC_LOGRING_ALIGN.
+    */
+
+   uint64_t m_Size;
+
+   /**
+    *    The total number of bytes reserved in the data area.  Updated
+    *    atomically by the writers.
+    */
+
+   uint64_t m_Head;
+
+   /**
+    *    The sequence number to give the next record.  Updated atomically
+    *    by the writers.
+    */
+
+   uint64_t m_Sequence;
+
+} xpc_logring_header_t;
+
+/******************************************************************************
+ * xpc_logring_record_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the header of each record in the data area.  The text of the
+ *    line (without a terminating null) follows it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    Holds XPC_LOGRING_RECORD_MAGIC, XPC_LOGRING_BINARY_MAGIC, or
+    *    XPC_LOGRING_PAD_MAGIC once the record is complete.  It is zero while
+    *    the record is being written.
+    */
+
+   uint16_t m_Magic;
+
+   /**
+    *    The length of the text (or of the binary log record).
+    */
+
+   uint16_t m_Text_Length;
+
+   /**
+    *    The length of the whole record, including this header and the
+    *    padding to the next XPC_LOGRING_ALIGN boundary.
+    */
+
+   uint32_t m_Length;
+
+   /**
+    *    The sequence number of the record.  The numbers of successive
+    *    records increase by one, so a gap shows how many records were lost
+    *    (overwritten, or interrupted by a crash).
+    */
+
+   uint64_t m_Sequence;
+
+} xpc_logring_record_t;
+
+/******************************************************************************
+ * xpc_logring_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the handle to an open ring file.  It is all zeroes when not
+ *    open.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    The mapped header at the start of the file.
+    */
+
+   xpc_logring_header_t * m_Header;
+
+   /**
+    *    The mapped data area, just after the header.
+    */
+
+   char * m_Data;
+
+   /**
+    *    The size of the whole mapping, header included.
+    */
+
+   size_t m_Map_Size;
+
+} xpc_logring_t;
+
+/******************************************************************************
+ * xpc_logring_visitor_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    The type of function called by xpc_logring_walk() for each record,
+ *    from the oldest to the newest.  The text is not null-terminated.  The
+ *    function returns 'false' to stop the walk.
+ *
+ *    Binary records are formatted before being passed to the visitor, so
+ *    the visitor sees only text.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef cbool_t (* xpc_logring_visitor_t)
+(
+   uint64_t sequence,
+   const char * text,
+   size_t length,
+   void * data
+);
+
+/******************************************************************************
+ * Global functions
+ *----------------------------------------------------------------------------*/
+
+EXTERN_C_DEC
+
+extern cbool_t xpc_logring_open
+(
+   xpc_logring_t * ring,
+   const char * filename,
+   size_t size
+);
+extern cbool_t xpc_logring_map (xpc_logring_t * ring, const char * filename);
+extern cbool_t xpc_logring_close (xpc_logring_t * ring);
+extern cbool_t xpc_logring_append
+(
+   xpc_logring_t * ring,
+   const char * text,
+   size_t length
+);
+extern cbool_t xpc_logring_append_binary
+(
+   xpc_logring_t * ring,
+   const char * record,
+   size_t length
+);
+extern size_t xpc_logring_walk
+(
+   const xpc_logring_t * ring,
+   xpc_logring_visitor_t visitor,
+   void * data
+);
+
+EXTERN_C_END
+
+#endif         /* XPC_LOGRING_H */
+
+/******************************************************************************
+ * logring.h
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
@@ -1587,6 +1587,23 @@ static const char XPC_VERSION_TAG(libname) [] =    \
 #define xpc_hidden
 #endif
 
+/******************************************************************************
+ * xpc_printf_format support macro
+ *------------------------------------------------------------------------*//**
+ *
+ *    Asks the compiler to check the arguments of a printf()-style function
+ *    against its format string.  The parameters are the 1-based index of
+ *    the format parameter and of the first variable argument.  Remember
+ *    that, in a non-static C++ member function, "this" is parameter 1.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifdef __GNUC__
+#define xpc_printf_format(f, a)  __attribute__((format(printf, f, a)))
+#else
+#define xpc_printf_format(f, a)
+#endif
+
 #endif                                                /* XPC_MACROS_H         */
 
 /******************************************************************************
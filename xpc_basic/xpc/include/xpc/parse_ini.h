@@ -33,6 +33,13 @@ extern char ** xpc_argv_from_INI
    int * argc_return,
    char ** buffer_return
 );
+extern char ** xpc_argv_from_INI_sections
+(
+   const char * filespec,
+   const char * const * sections,
+   int * argc_return,
+   char ** buffer_return
+);
 extern void xpc_delete_argv (char ** argv, char * buffer);
 extern FILE * xpc_write_INI_header (const char * filespec, const char * section);
 extern cbool_t xpc_append_INI_header (FILE * fhandle, const char * section);
@@ -108,6 +108,7 @@
  *//*-------------------------------------------------------------------------*/
 
 #include <xpc/macros.h>             /* support for special XPC features       */
+#include <xpc/integers.h>           /* uint64_t                               */
 
 #if XPC_HAVE_TIME_H
 #include <time.h>                   /* clock_t                                */
@@ -177,6 +178,27 @@ XPC_REVISION_DECL(portable)         /* extern void show_xpc_portable_info();  */
 #include <winsock2.h>               /* needed to declare struct timeval (!)   */
 #endif
 
+/******************************************************************************
+ * xpc_stopwatch_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a stopwatch for timing sections of code.
+ *
+ *    The times are read from a monotonic clock, in nanoseconds, so they are
+ *    not disturbed by changes to the time-of-day.  Each thread can own any
+ *    number of stopwatches; a stopwatch must not be shared by threads.  A
+ *    stopwatch that is zeroed (e.g. a static one) counts as not started.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   uint64_t m_Start_Ns;             /**< The monotonic time of the start.     */
+   uint64_t m_Lap_Ns;               /**< The monotonic time of the last lap.  */
+   cbool_t m_Started;               /**< Indicates the stopwatch was started. */
+
+} xpc_stopwatch_t;
+
 /******************************************************************************
  * Portable C functions
  *-----------------------------------------------------------------------------
@@ -216,6 +238,13 @@ extern double xpc_time_difference_ptr                          /* deprecated  */
    struct timeval * c1,
    struct timeval * c2
 );
+extern uint64_t xpc_monotonic_nanoseconds (void);
+extern void xpc_stopwatch_start_ex (xpc_stopwatch_t * sw);
+extern double xpc_stopwatch_duration_ex (const xpc_stopwatch_t * sw);
+extern double xpc_stopwatch_lap_ex (xpc_stopwatch_t * sw);
+extern uint64_t xpc_stopwatch_duration_ns (const xpc_stopwatch_t * sw);
+extern uint64_t xpc_stopwatch_lap_ns (xpc_stopwatch_t * sw);
+extern xpc_stopwatch_t * xpc_stopwatch_thread (void);
 extern void xpc_stopwatch_start (void);
 extern double xpc_stopwatch_duration (void);
 extern double xpc_stopwatch_lap (void);
@@ -0,0 +1,168 @@
+#ifndef XPC_PROFILER_H
+#define XPC_PROFILER_H
+
+/******************************************************************************
+ * profiler.h
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          profiler.h
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-17
+ * \updates       2013-08-17
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides named profiling zones, for seeing where the time goes inside
+ *    an application without an external profiler.
+ *
+ *    A zone is a static xpc_profile_zone_t, normally declared by one of
+ *    the macros below, which time the code between two points (or to the
+ *    end of the enclosing block) with xpc_monotonic_nanoseconds():
+ *
+\verbatim
+         XPC_PROFILE_BEGIN(parse);
+         ... code to time ...
+         XPC_PROFILE_END(parse);
+
+         {
+            XPC_PROFILE_SCOPE(lookup);       // GNU C only; C++ has
+            ... code to time ...             // XPC_SCOPE_TIMER()
+         }
+\endverbatim
+ *
+ *    Each thread records its times into its own histogram for each zone
+ *    (see histogram.h), so recording takes no lock and touches no shared
+ *    cache line.  xpc_profile_merge() and xpc_profile_dump() add up the
+ *    histograms of all threads on demand, including those of threads that
+ *    have exited.  Zones with the same name share their statistics.
+ *
+ *    Defining XPC_NO_PROFILING before including this header compiles the
+ *    macros away.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/portable.h>              /* xpc_monotonic_nanoseconds()         */
+#include <xpc/histogram.h>             /* xpc_histogram_t                     */
+
+#if XPC_HAVE_STDIO_H
+#include <stdio.h>                     /* FILE                                */
+#endif
+
+/******************************************************************************
+ * XPC_PROFILE_ZONE_MAX
+ *------------------------------------------------------------------------*//**
+ *
+ *    The most distinct zone names that can be registered.  Zones beyond
+ *    this number are not recorded, and a warning is logged once.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_PROFILE_ZONE_MAX        128
+
+/******************************************************************************
+ * xpc_profile_zone_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a named zone.  It must have static storage duration, and
+ *    start with an m_Id of 0; the zone is registered on its first use.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   const char * m_Name;                /**< The name shown in the reports.    */
+   int m_Id;                           /**< 0, then 1-based, or -1 if full.   */
+
+} xpc_profile_zone_t;
+
+/******************************************************************************
+ * xpc_profile_scope_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a zone being timed, for XPC_PROFILE_SCOPE().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   xpc_profile_zone_t * m_Zone;        /**< The zone being timed.             */
+   uint64_t m_Start;                   /**< The monotonic start time.         */
+
+} xpc_profile_scope_t;
+
+/******************************************************************************
+ * Profiling macros
+ *------------------------------------------------------------------------*//**
+ *
+ *    XPC_PROFILE_BEGIN(zone) declares the zone and notes the start time,
+ *    and XPC_PROFILE_END(zone) records the time since then.  Both must be
+ *    in the same block, and \a zone must be usable as part of a C
+ *    identifier; it is also the zone's name.
+ *
+ *    XPC_PROFILE_SCOPE(zone) records the time until the enclosing block
+ *    is left, by any path.  It needs the GNU C "cleanup" attribute.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#if defined XPC_NO_PROFILING
+
+#define XPC_PROFILE_BEGIN(zone)
+#define XPC_PROFILE_END(zone)
+#define XPC_PROFILE_SCOPE(zone)
+
+#else
+
+#define XPC_PROFILE_BEGIN(zone) \
+   static xpc_profile_zone_t xpc_zone_##zone = { #zone, 0 }; \
+   uint64_t xpc_zone_start_##zone = xpc_monotonic_nanoseconds()
+
+#define XPC_PROFILE_END(zone) \
+   xpc_profile_record \
+   ( \
+      &xpc_zone_##zone, xpc_monotonic_nanoseconds() - xpc_zone_start_##zone \
+   )
+
+#if defined __GNUC__ && ! defined __cplusplus
+
+#define XPC_PROFILE_SCOPE(zone) \
+   static xpc_profile_zone_t xpc_zone_##zone = { #zone, 0 }; \
+   xpc_profile_scope_t xpc_scope_##zone \
+      __attribute__((cleanup(xpc_profile_scope_end))) = \
+      { &xpc_zone_##zone, xpc_monotonic_nanoseconds() }
+
+#endif
+
+#endif            // XPC_NO_PROFILING
+
+/******************************************************************************
+ * Global functions
+ *----------------------------------------------------------------------------*/
+
+EXTERN_C_DEC
+
+extern void xpc_profile_record
+(
+   xpc_profile_zone_t * zone,
+   uint64_t nanoseconds
+);
+extern void xpc_profile_scope_end (xpc_profile_scope_t * scope);
+extern int xpc_profile_zone_count (void);
+extern const char * xpc_profile_zone_name (int id);
+extern cbool_t xpc_profile_merge (const char * name, xpc_histogram_t * out);
+extern void xpc_profile_dump (FILE * fp);
+extern cbool_t xpc_profile_dump_file (const char * filename);
+extern void xpc_profile_reset (void);
+
+EXTERN_C_END
+
+#endif         // XPC_PROFILER_H
+
+/******************************************************************************
+ * profiler.h
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
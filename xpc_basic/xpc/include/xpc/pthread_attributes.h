@@ -8,7 +8,7 @@
  * \file          pthread_attributes.h
  * \library       xpc
  * \author        Chris Ahlstrom
- * \updates       05/01/2008-05/04/2008
+ * \updates       05/01/2008-08/14/2013
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
@@ -32,6 +32,80 @@ EXTERN_C_DEC                           /* pthreads are /not/ C++              */
 #include <pthread.h>                   /* pthreads library functions          */
 EXTERN_C_END
 
+/******************************************************************************
+ * XPC_THREAD_NAME_MAX
+ *------------------------------------------------------------------------*//**
+ *
+ *    The size of a thread name, including the terminating null.  Linux
+ *    allows 15 characters.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_THREAD_NAME_MAX         16
+
+/******************************************************************************
+ * pthread_attributes_ex_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Extends pthread_attr_t with the placement settings a latency-sensitive
+ *    thread needs:  the CPU or NUMA node to run on, a real-time scheduling
+ *    policy and priority, and a name that shows up in top, ps, and perf.
+ *
+ *    The CPU, node, and real-time settings are stored in m_Attributes as
+ *    soon as they are set, so that m_Attributes can also be passed to the
+ *    plain pthreader_create().  The name can only be given to a running
+ *    thread, so it is applied by pthreader_create_ex() (or
+ *    pthread_attributes_apply()).
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    The underlying POSIX attributes.
+    */
+
+   pthread_attr_t m_Attributes;
+
+   /**
+    *    The CPU the thread is pinned to, or -1.
+    */
+
+   int m_Cpu;
+
+   /**
+    *    The NUMA node whose CPUs the thread is restricted to, or -1.
+    */
+
+   int m_Node;
+
+   /**
+    *    The real-time policy (SCHED_FIFO or SCHED_RR), or -1 to inherit
+    *    the normal policy.
+    */
+
+   int m_Policy;
+
+   /**
+    *    The real-time priority, used only if m_Policy is set.
+    */
+
+   int m_Priority;
+
+   /**
+    *    The name of the thread.  Empty if not set.
+    */
+
+   char m_Name[XPC_THREAD_NAME_MAX];
+
+   /**
+    *    Indicates that m_Attributes has been initialized.
+    */
+
+   cbool_t m_Ready;
+
+} pthread_attributes_ex_t;
+
 /******************************************************************************
  * Global functions (documented in pthread_attributes.c)
  *----------------------------------------------------------------------------*/
@@ -73,6 +147,35 @@ extern cbool_t pthread_attributes_set_detach_state
    pthread_attr_t * pattr,
    int s
 );
+extern cbool_t pthread_attributes_ex_init (pthread_attributes_ex_t * ax);
+extern cbool_t pthread_attributes_set_cpu
+(
+   pthread_attributes_ex_t * ax,
+   int cpu
+);
+extern cbool_t pthread_attributes_set_node
+(
+   pthread_attributes_ex_t * ax,
+   int node
+);
+extern cbool_t pthread_attributes_set_realtime
+(
+   pthread_attributes_ex_t * ax,
+   int policy,
+   int priority
+);
+extern cbool_t pthread_attributes_set_name
+(
+   pthread_attributes_ex_t * ax,
+   const char * name
+);
+extern cbool_t pthread_attributes_apply
+(
+   pthread_t th,
+   const pthread_attributes_ex_t * ax
+);
+extern void pthread_attributes_ex_show (pthread_attributes_ex_t * ax);
+extern cbool_t pthread_attributes_ex_destroy (pthread_attributes_ex_t * ax);
 
 EXTERN_C_END
 
@@ -8,7 +8,7 @@
  * \file          pthreader.h
  * \library       xpc
  * \author        Chris Ahlstrom
- * \updates       05/03/2008-05/17/2008
+ * \updates       05/03/2008-08/14/2013
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
@@ -32,6 +32,8 @@ EXTERN_C_DEC                           /* pthreads are /not/ C++              */
 #include <pthread.h>                   /* pthreads library functions          */
 EXTERN_C_END
 
+#include <xpc/pthread_attributes.h>    /* pthread_attributes_ex_t             */
+
 /******************************************************************************
  * pthreader_func_t
  *------------------------------------------------------------------------*//**
@@ -58,6 +60,12 @@ extern pthread_t pthreader_create
    pthreader_func_t thread_callback,
    void * thread_data
 );
+extern pthread_t pthreader_create_ex
+(
+   const pthread_attributes_ex_t * ax,
+   pthreader_func_t thread_callback,
+   void * thread_data
+);
 extern void pthreader_yield (void);
 extern void * pthreader_join (pthread_t th);
 extern cbool_t pthreader_cancel (pthread_t th);
@@ -0,0 +1,255 @@
+#ifndef XPC_PTHREADER_POOL_H
+#define XPC_PTHREADER_POOL_H
+
+/******************************************************************************
+ * pthreader_pool.h
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          pthreader_pool.h
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-13
+ * \updates       2013-08-13
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a fixed-size pool of worker threads, with work stealing.
+ *
+ *    The workers are created with pthreader_create(), using the attributes
+ *    set up by pthread_attributes_init().  Each worker has its own deque
+ *    of tasks:
+ *
+ *       -  A task submitted by a worker (for example, a task that splits
+ *          its work into smaller tasks) goes onto the bottom of that
+ *          worker's own deque, and the worker takes its next task from the
+ *          bottom too, so that recent (cache-warm) work is done first.
+ *       -  A task submitted from outside the pool goes onto the deques in
+ *          turn.
+ *       -  A worker whose deque is empty steals from the top (the oldest
+ *          end) of another worker's deque, and sleeps only when there is
+ *          nothing left anywhere.
+ *
+ *    A task is a pthreader_func_t, like a thread function.  Its result can
+ *    be collected through a future (pthreader_pool_async()), or handed to
+ *    a completion callback (pthreader_pool_submit()).
+ *
+ *    pthreader_pool_destroy() shuts the pool down gracefully: no new tasks
+ *    are accepted, the tasks already queued are run, and the workers are
+ *    joined.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/pthreader.h>             /* pthreader_func_t, pthread_t         */
+#include <xpc/syncher.h>               /* xpc_syncher_t                       */
+#include <xpc/integers.h>              /* uint64_t                            */
+
+/******************************************************************************
+ * pthreader_done_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    The type of a completion callback.  It is called by the worker that
+ *    ran the task, right after the task, with the task's result and data.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef void (* pthreader_done_t) (void * result, void * data);
+
+/******************************************************************************
+ * pthreader_task_t, pthreader_future_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    A queued task.  Its layout is private to pthreader_pool.c.  A future
+ *    is a task whose result is kept for pthreader_future_wait().  The
+ *    future is owned by the caller of pthreader_pool_async(), and is freed
+ *    only by pthreader_future_wait(), which must be called for every
+ *    future, once.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct pthreader_task_s pthreader_task_t;
+typedef struct pthreader_task_s pthreader_future_t;
+
+/******************************************************************************
+ * pthreader_worker_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides one worker of the pool, with its deque of tasks.
+ *
+ *    The deque is a ring of task pointers that grows as needed.  m_Top is
+ *    the index of the oldest task (where thieves take from), and m_Bottom
+ *    is one past the newest (where the owner pushes and pops).  Both only
+ *    grow; they are reduced modulo m_Capacity to index the ring.  The
+ *    deque is guarded by m_Lock, an adaptive syncher, which is nearly
+ *    always taken only by its owner.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    The pool that owns the worker.
+    */
+
+   struct pthreader_pool_s * m_Pool;
+
+   /**
+    *    Guards the deque.
+    */
+
+   xpc_syncher_t m_Lock;
+
+   /**
+    *    The ring of tasks, and its size, a power of 2.
+    */
+
+   pthreader_task_t ** m_Tasks;
+   size_t m_Capacity;
+
+   /**
+    *    The ends of the deque.
+    */
+
+   size_t m_Top;
+   size_t m_Bottom;
+
+   /**
+    *    The worker's thread.
+    */
+
+   pthread_t m_Thread;
+
+   /**
+    *    The state of the random choice of the worker to steal from.
+    */
+
+   unsigned m_Seed;
+
+   /**
+    *    The number of tasks the worker ran, and how many of them it stole.
+    *    Written only by the worker.
+    */
+
+   uint64_t m_Executed;
+   uint64_t m_Stolen;
+
+} pthreader_worker_t;
+
+/******************************************************************************
+ * pthreader_pool_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the pool of workers.  The members are managed by the
+ *    pthreader_pool functions, and are shown here only so that a pool can
+ *    be declared statically or on the stack.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct pthreader_pool_s
+{
+   /**
+    *    The workers.
+    */
+
+   pthreader_worker_t * m_Workers;
+   int m_Worker_Count;
+
+   /**
+    *    Guards the sleeping of the workers, and the waiting for futures
+    *    and for the pool to go idle.
+    */
+
+   pthread_mutex_t m_Sleep_Lock;
+
+   /**
+    *    Signalled when a task is queued, or the pool is stopping.
+    */
+
+   pthread_cond_t m_Wake;
+
+   /**
+    *    Broadcast when a future is completed, or the pool goes idle.
+    */
+
+   pthread_cond_t m_Done;
+
+   /**
+    *    The number of tasks queued but not yet taken by a worker.
+    */
+
+   long m_Pending;
+
+   /**
+    *    The number of tasks submitted but not yet completed.
+    */
+
+   long m_Outstanding;
+
+   /**
+    *    The number of workers sleeping on m_Wake.
+    */
+
+   int m_Sleepers;
+
+   /**
+    *    The next worker to give a task submitted from outside the pool.
+    */
+
+   unsigned m_Next;
+
+   /**
+    *    Set when the pool is being shut down.  It is stored and loaded
+    *    atomically, since submitters read it without taking m_Sleep_Lock.
+    */
+
+   cbool_t m_Stopping;
+
+   /**
+    *    Indicates that the pool is in a usable state.
+    */
+
+   cbool_t m_Ready;
+
+} pthreader_pool_t;
+
+/******************************************************************************
+ * Global functions
+ *----------------------------------------------------------------------------*/
+
+EXTERN_C_DEC
+
+extern cbool_t pthreader_pool_create (pthreader_pool_t * pool, int workers);
+extern cbool_t pthreader_pool_submit
+(
+   pthreader_pool_t * pool,
+   pthreader_func_t task,
+   void * data,
+   pthreader_done_t done
+);
+extern pthreader_future_t * pthreader_pool_async
+(
+   pthreader_pool_t * pool,
+   pthreader_func_t task,
+   void * data
+);
+extern cbool_t pthreader_future_ready (const pthreader_future_t * future);
+extern void * pthreader_future_wait
+(
+   pthreader_pool_t * pool,
+   pthreader_future_t * future
+);
+extern void pthreader_pool_wait (pthreader_pool_t * pool);
+extern int pthreader_pool_size (const pthreader_pool_t * pool);
+extern cbool_t pthreader_pool_destroy (pthreader_pool_t * pool);
+
+EXTERN_C_END
+
+#endif         // XPC_PTHREADER_POOL_H
+
+/******************************************************************************
+ * pthreader_pool.h
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
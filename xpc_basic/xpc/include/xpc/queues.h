@@ -0,0 +1,252 @@
+#ifndef XPC_QUEUES_H
+#define XPC_QUEUES_H
+
+/******************************************************************************
+ * queues.h
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          queues.h
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-15
+ * \updates       2013-08-15
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides bounded, lock-free queues of pointers for passing work
+ *    between threads:
+ *
+ *       -  xpc_spsc_queue_t.  One producer thread and one consumer thread.
+ *          Each side writes only its own index, so a push or pop is a
+ *          plain store plus a release store, with no read-modify-write.
+ *       -  xpc_mpmc_queue_t.  Any number of producers and consumers.  Each
+ *          slot carries a sequence number, and a push or pop claims its
+ *          slot with one compare-and-swap (Dmitry Vyukov's bounded queue).
+ *
+ *    The indices written by the producers and the consumers are kept on
+ *    separate cache lines.  The batch functions move many items for one
+ *    wakeup check.  The "_wait" functions block (using a futex on Linux)
+ *    until they succeed or the queue is closed.
+ *
+ *    The xpc_eventcount_t that does the blocking is also usable on its
+ *    own, and the C++ queues in xpc++ use it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/portable.h>              /* portability functions and macros    */
+#include <xpc/atomix.h>                /* xpc_cache_aligned                   */
+
+/******************************************************************************
+ * xpc_eventcount_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Lets threads sleep until some condition, checked without a lock, may
+ *    have changed.
+ *
+ *    A waiter calls xpc_eventcount_prepare(), checks its condition again,
+ *    and then calls either xpc_eventcount_cancel() (the condition came
+ *    true) or xpc_eventcount_wait().  A thread that makes the condition
+ *    true calls xpc_eventcount_notify() afterward.  The notifier does no
+ *    system call unless a thread is waiting.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    Bumped by every notify that finds a waiter.  This is the futex
+    *    word that waiters sleep on.
+    */
+
+   int m_Sequence;
+
+   /**
+    *    The number of threads between prepare and wait (or cancel).
+    */
+
+   int m_Waiters;
+
+} xpc_eventcount_t;
+
+/******************************************************************************
+ * xpc_spsc_queue_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a bounded single-producer/single-consumer ring of pointers.
+ *
+ *    m_Head and m_Tail only grow; they are reduced by m_Mask to index the
+ *    ring.  Each side keeps a cached copy of the other side's index, and
+ *    reads the real one only when the cached copy says the ring is full
+ *    (or empty), which keeps the other side's cache line from bouncing.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    The next slot to pop, and the consumer's copy of m_Tail.  Written
+    *    only by the consumer.
+    */
+
+   xpc_cache_aligned size_t m_Head;
+   size_t m_Tail_Cache;
+
+   /**
+    *    The next slot to push, and the producer's copy of m_Head.  Written
+    *    only by the producer.
+    */
+
+   xpc_cache_aligned size_t m_Tail;
+   size_t m_Head_Cache;
+
+   /**
+    *    The ring, and the ring size less 1 (the ring size is a power of 2).
+    */
+
+   xpc_cache_aligned void ** m_Slots;
+   size_t m_Mask;
+
+   /**
+    *    Set by xpc_spsc_queue_close().
+    */
+
+   int m_Closed;
+
+   /**
+    *    Wakes a consumer waiting for an item, and a producer waiting for
+    *    room.
+    */
+
+   xpc_eventcount_t m_Not_Empty;
+   xpc_eventcount_t m_Not_Full;
+
+} xpc_spsc_queue_t;
+
+/******************************************************************************
+ * xpc_mpmc_cell_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides one slot of an xpc_mpmc_queue_t.  The sequence number says
+ *    whether the slot is ready to be pushed (it equals the push position)
+ *    or popped (it equals the pop position plus 1).
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   size_t m_Sequence;
+   void * m_Data;
+
+} xpc_mpmc_cell_t;
+
+/******************************************************************************
+ * xpc_mpmc_queue_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a bounded multi-producer/multi-consumer queue of pointers.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    The next position to push.  Claimed by producers with a CAS.
+    */
+
+   xpc_cache_aligned size_t m_Enqueue;
+
+   /**
+    *    The next position to pop.  Claimed by consumers with a CAS.
+    */
+
+   xpc_cache_aligned size_t m_Dequeue;
+
+   /**
+    *    The cells, and the number of cells less 1 (a power of 2 less 1).
+    */
+
+   xpc_cache_aligned xpc_mpmc_cell_t * m_Cells;
+   size_t m_Mask;
+
+   /**
+    *    Set by xpc_mpmc_queue_close().
+    */
+
+   int m_Closed;
+
+   /**
+    *    Wakes consumers waiting for an item, and producers waiting for
+    *    room.
+    */
+
+   xpc_eventcount_t m_Not_Empty;
+   xpc_eventcount_t m_Not_Full;
+
+} xpc_mpmc_queue_t;
+
+/******************************************************************************
+ * Global functions
+ *----------------------------------------------------------------------------*/
+
+EXTERN_C_DEC
+
+extern void xpc_eventcount_init (xpc_eventcount_t * ec);
+extern int xpc_eventcount_prepare (xpc_eventcount_t * ec);
+extern void xpc_eventcount_cancel (xpc_eventcount_t * ec);
+extern void xpc_eventcount_wait (xpc_eventcount_t * ec, int key);
+extern void xpc_eventcount_notify (xpc_eventcount_t * ec);
+
+extern cbool_t xpc_spsc_queue_create (xpc_spsc_queue_t * q, size_t capacity);
+extern cbool_t xpc_spsc_queue_push (xpc_spsc_queue_t * q, void * item);
+extern cbool_t xpc_spsc_queue_pop (xpc_spsc_queue_t * q, void ** item);
+extern size_t xpc_spsc_queue_push_batch
+(
+   xpc_spsc_queue_t * q,
+   void * const * items,
+   size_t count
+);
+extern size_t xpc_spsc_queue_pop_batch
+(
+   xpc_spsc_queue_t * q,
+   void ** items,
+   size_t count
+);
+extern cbool_t xpc_spsc_queue_push_wait (xpc_spsc_queue_t * q, void * item);
+extern cbool_t xpc_spsc_queue_pop_wait (xpc_spsc_queue_t * q, void ** item);
+extern size_t xpc_spsc_queue_count (const xpc_spsc_queue_t * q);
+extern void xpc_spsc_queue_close (xpc_spsc_queue_t * q);
+extern cbool_t xpc_spsc_queue_destroy (xpc_spsc_queue_t * q);
+
+extern cbool_t xpc_mpmc_queue_create (xpc_mpmc_queue_t * q, size_t capacity);
+extern cbool_t xpc_mpmc_queue_push (xpc_mpmc_queue_t * q, void * item);
+extern cbool_t xpc_mpmc_queue_pop (xpc_mpmc_queue_t * q, void ** item);
+extern size_t xpc_mpmc_queue_push_batch
+(
+   xpc_mpmc_queue_t * q,
+   void * const * items,
+   size_t count
+);
+extern size_t xpc_mpmc_queue_pop_batch
+(
+   xpc_mpmc_queue_t * q,
+   void ** items,
+   size_t count
+);
+extern cbool_t xpc_mpmc_queue_push_wait (xpc_mpmc_queue_t * q, void * item);
+extern cbool_t xpc_mpmc_queue_pop_wait (xpc_mpmc_queue_t * q, void ** item);
+extern size_t xpc_mpmc_queue_count (const xpc_mpmc_queue_t * q);
+extern void xpc_mpmc_queue_close (xpc_mpmc_queue_t * q);
+extern cbool_t xpc_mpmc_queue_destroy (xpc_mpmc_queue_t * q);
+
+EXTERN_C_END
+
+#endif         // XPC_QUEUES_H
+
+/******************************************************************************
+ * queues.h
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
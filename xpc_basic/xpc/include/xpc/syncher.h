@@ -9,13 +9,31 @@
  * \library       xpc
  * \author        Chris Ahlstrom
  * \date          2008-04-29
- * \updates       2012-05-28
+ * \updates       2013-08-12
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
  *    This utility provides a basic locking mechanism that works under POSIX
  *    or Win32.
  *
+ *    A syncher can also be made adaptive (see xpc_syncher_create_adaptive()),
+ *    in which case a thread that finds it locked spins for a while before
+ *    blocking.  Every syncher keeps statistics on its contention.
+ *
+ *    When DEBUG_MUTEX_LOCKS is defined, the synchers use error-checking
+ *    mutexes, track their owner thread, and can check the order in which
+ *    each thread takes them (see xpc_syncher_lockorder_set()), reporting
+ *    an order that could deadlock before it does.
+ *
+ *    Two variants share the create/enter/tryenter/leave/destroy shape of
+ *    the syncher functions:
+ *
+ *       -  xpc_rwsyncher_t, a reader-writer lock, lets readers of
+ *          read-mostly data run in parallel.
+ *       -  xpc_syncher_stripes_t, an array of synchers selected by a key,
+ *          lets threads working on different parts of a table run in
+ *          parallel.
+ *
  * \win32
  *    It does not use the CRITICAL_SECTION for Windows.  Instead, we rely on
  *    a port of the POSIX pthreads API to Windows:
@@ -25,6 +43,7 @@
  *//*-------------------------------------------------------------------------*/
 
 #include <xpc/portable.h>                 /* portability functions and macros */
+#include <xpc/integers.h>                 /* uint64_t                         */
 
 EXTERN_C_DEC                              /* pthreads are /not/ C++           */
 #include <pthread.h>                      /* pthreads library functions       */
@@ -32,6 +51,45 @@ EXTERN_C_END
 
 #define XPC_SYNCHER     pthread_mutex_t   /* pthreads mutex data type         */
 
+/******************************************************************************
+ * XPC_SYNCHER_SPIN_DEFAULT
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the limits of the spinning done by an adaptive syncher.
+ *
+ *    -  XPC_SYNCHER_SPIN_DEFAULT is the number of times an adaptive syncher
+ *       retries the lock before blocking, if xpc_syncher_create_adaptive()
+ *       is given 0.
+ *    -  XPC_SYNCHER_BACKOFF_MAX is the largest number of pause instructions
+ *       between two retries.  The number starts at 1 and doubles on each
+ *       retry.
+ *
+ *    With the defaults, a thread spins for roughly 700 pauses, which is a
+ *    few microseconds, about the cost of going to sleep in the kernel and
+ *    being woken again.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_SYNCHER_SPIN_DEFAULT    16
+#define XPC_SYNCHER_BACKOFF_MAX     64
+
+/******************************************************************************
+ * XPC_LOCKORDER_DEPTH
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the limits of the lock-order detector, which is built only
+ *    when DEBUG_MUTEX_LOCKS is defined.
+ *
+ *    -  XPC_LOCKORDER_DEPTH is the number of synchers a thread can hold at
+ *       once and still have them checked.
+ *    -  XPC_LOCKORDER_EDGES is the number of distinct "A taken before B"
+ *       pairs remembered for the whole process.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_LOCKORDER_DEPTH         16
+#define XPC_LOCKORDER_EDGES         256
+
 /******************************************************************************
  * xpc_syncher_t
  *------------------------------------------------------------------------*//**
@@ -79,14 +137,27 @@ typedef struct
    XPC_SYNCHER m_Syncher;
 
    /**
-    *    Indicates if the syncher-object is currently owned by a thread.
-    *
-    *    Generally, a syncher-object object has to be un-owned before it
-    *    can be destroyed.  This flag helps detect such a situation.  Note
-    *    that it is effectively locked when being modified.
+    *    Identifies the thread that owns the syncher-object, or is 0 if no
+    *    thread owns it.  It is kept only when DEBUG_MUTEX_LOCKS is defined,
+    *    and is always 0 otherwise, so that entering and leaving touch
+    *    nothing but the mutex.  It is read and written atomically.
+    */
+
+   uintptr_t m_Owner;
+
+   /**
+    *    The number of times the owner has entered the syncher-object
+    *    (more than 1 only for a recursive object).  Kept only when
+    *    DEBUG_MUTEX_LOCKS is defined, and touched only by the owner.
+    */
+
+   int m_Depth;
+
+   /**
+    *    Indicates that the syncher-object was created recursive.
     */
 
-   cbool_t m_Syncher_Owned;
+   cbool_t m_Recursive;
 
    /**
     *    Indicates that the syncher-object is in a usable state.
@@ -97,8 +168,123 @@ typedef struct
 
    cbool_t m_Syncher_Ready;
 
+   /**
+    *    The number of times a thread that finds the syncher-object locked
+    *    retries it before blocking.  It is 0 for a normal syncher, which
+    *    blocks at once.
+    */
+
+   int m_Spin_Limit;
+
+   /**
+    *    The contention statistics.  They are updated only by the thread
+    *    that owns the syncher-object, with relaxed atomic stores, so another
+    *    thread may read each of them at any time with
+    *    xpc_atomic_load_relaxed().  Such a reading is a snapshot, and the
+    *    four values need not agree with one another.  They are exact when
+    *    read while owning the object, or once the other threads are done
+    *    with it.
+    *
+    *    -  m_Acquisitions counts every successful enter or try-enter.
+    *    -  m_Contended counts the enters that found the object locked.
+    *    -  m_Parked counts the contended enters that had to block, after
+    *       spinning (if adaptive) failed.
+    *    -  m_Wait_Nanoseconds is the total time spent by the contended
+    *       enters in getting the object.
+    */
+
+   uint64_t m_Acquisitions;
+   uint64_t m_Contended;
+   uint64_t m_Parked;
+   uint64_t m_Wait_Nanoseconds;
+
 } xpc_syncher_t;
 
+/******************************************************************************
+ * xpc_rwsyncher_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a reader-writer syncher-object.
+ *
+ *    Any number of readers can own the object at the same time, but a
+ *    writer owns it alone.  This suits read-mostly data, such as settings
+ *    that are loaded once and then only looked up.
+ *
+ *    By default, the platform decides who goes first when readers and
+ *    writers are waiting.  Under glibc, that favors the readers, so that a
+ *    steady stream of readers can starve a writer.  The object can instead
+ *    be created to prefer writers; see xpc_rwsyncher_create().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    The POSIX reader-writer lock.
+    */
+
+   pthread_rwlock_t m_Rwlock;
+
+   /**
+    *    Indicates that the object is in a usable state.
+    */
+
+   cbool_t m_Syncher_Ready;
+
+   /**
+    *    Indicates that waiting writers go ahead of new readers.
+    */
+
+   cbool_t m_Prefer_Writers;
+
+} xpc_rwsyncher_t;
+
+/******************************************************************************
+ * xpc_syncher_stripes_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides an array of syncher-objects, selected by a key.
+ *
+ *    Instead of one lock for a whole table, each key (for example, the
+ *    hash of an entry, or its address) is mapped to one of a fixed number
+ *    of stripes, so that threads working on different entries rarely
+ *    contend.  Each stripe sits in its own cache lines, so that a thread
+ *    taking one stripe does not slow down a thread taking its neighbor.
+ *
+ *    A thread must not own two stripes at once, unless it always takes
+ *    them in the same order, since two keys may map to the same stripe.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   /**
+    *    The first stripe, aligned to a cache line.  Each stripe is an
+    *    xpc_syncher_t, padded to m_Stride bytes.
+    */
+
+   char * m_Stripes;
+
+   /**
+    *    The distance between stripes, a multiple of the cache-line size.
+    */
+
+   size_t m_Stride;
+
+   /**
+    *    The number of stripes (a power of 2) minus one.
+    */
+
+   size_t m_Mask;
+
+   /**
+    *    The memory allocated for the stripes, which m_Stripes points into.
+    */
+
+   void * m_Memory;
+
+} xpc_syncher_stripes_t;
+
 /******************************************************************************
  * Global functions
  *----------------------------------------------------------------------------*/
@@ -109,6 +295,44 @@ extern cbool_t xpc_syncher_enter (xpc_syncher_t * xs);
 extern cbool_t xpc_syncher_tryenter (xpc_syncher_t * xs);
 extern cbool_t xpc_syncher_leave (xpc_syncher_t * xs);
 extern cbool_t xpc_syncher_create (xpc_syncher_t * xs, cbool_t recursive);
+extern cbool_t xpc_syncher_create_adaptive (xpc_syncher_t * xs, int spins);
+extern cbool_t xpc_syncher_lockorder_set (cbool_t flag);
+extern unsigned long xpc_syncher_lockorder_violations (void);
+
+extern cbool_t xpc_rwsyncher_create
+(
+   xpc_rwsyncher_t * xs,
+   cbool_t prefer_writers
+);
+extern cbool_t xpc_rwsyncher_enter_read (xpc_rwsyncher_t * xs);
+extern cbool_t xpc_rwsyncher_enter_write (xpc_rwsyncher_t * xs);
+extern cbool_t xpc_rwsyncher_tryenter_read (xpc_rwsyncher_t * xs);
+extern cbool_t xpc_rwsyncher_tryenter_write (xpc_rwsyncher_t * xs);
+extern cbool_t xpc_rwsyncher_leave (xpc_rwsyncher_t * xs);
+extern cbool_t xpc_rwsyncher_destroy (xpc_rwsyncher_t * xs);
+
+extern cbool_t xpc_syncher_stripes_create
+(
+   xpc_syncher_stripes_t * xs,
+   size_t count,
+   cbool_t adaptive
+);
+extern cbool_t xpc_syncher_stripes_enter
+(
+   xpc_syncher_stripes_t * xs,
+   size_t key
+);
+extern cbool_t xpc_syncher_stripes_tryenter
+(
+   xpc_syncher_stripes_t * xs,
+   size_t key
+);
+extern cbool_t xpc_syncher_stripes_leave
+(
+   xpc_syncher_stripes_t * xs,
+   size_t key
+);
+extern cbool_t xpc_syncher_stripes_destroy (xpc_syncher_stripes_t * xs);
 extern cbool_t xpc_syncher_destroy (xpc_syncher_t * xs);
 
 EXTERN_C_END
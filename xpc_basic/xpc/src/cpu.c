@@ -5,7 +5,7 @@
  * \file          cpu.c
  * \library       xpc_suite
  * \author        Chris Ahlstrom
- * \updates       2008-05-03 to 2010-04-02
+ * \updates       2008-05-03 to 2013-08-14
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
@@ -36,6 +36,10 @@
  *    -  xpc_is_ilp32() [UNIX 32]
  *    -  xpc_is_lp64()  [UNIX 64]
  *    -  xpc_is_llp64() [Win64 a.k.a. Win32 for 64-bit Windows]
+ *    -  xpc_cpu_count(), xpc_cpu_node_count(), xpc_cpu_info(), and
+ *       xpc_cpu_node_cpus().  These report the core, package, and NUMA
+ *       node of each logical CPU, from the Linux sysfs files, for choosing
+ *       where to pin threads (see pthread_attributes_set_cpu()).
  *
  *    Also see the contrib/config.guess script for more ideas.
  *
@@ -46,6 +50,26 @@
 #include <xpc/cpu.h>                   /* CPU-detection items                 */
 #include <xpc/integers.h>              /* int16_t, etc.                       */
 
+#if XPC_HAVE_STDIO_H
+#include <stdio.h>                     /* fopen(), fgets(), snprintf()        */
+#endif
+
+#if XPC_HAVE_STDLIB_H
+#include <stdlib.h>                    /* atoi(), strtol()                    */
+#endif
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* strchr()                            */
+#endif
+
+#if XPC_HAVE_CTYPE_H
+#include <ctype.h>                     /* isdigit()                           */
+#endif
+
+#if XPC_HAVE_UNISTD_H
+#include <unistd.h>                    /* sysconf()                           */
+#endif
+
 XPC_REVISION(cpu)
 
 /******************************************************************************
@@ -428,6 +452,365 @@ xpc_is_llp64 (void)
    );
 }
 
+/******************************************************************************
+ * cpu_sysfs_read() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads the first line of a small Linux sysfs file, such as
+ *    /sys/devices/system/cpu/cpu0/topology/core_id.
+ *
+ * \return
+ *    Returns 'true' if the file could be read.  The line is stored, without
+ *    its newline, in the destination buffer.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+cpu_sysfs_read
+(
+   const char * path,            /**< The sysfs file to read.                 */
+   char * destination,           /**< The buffer to receive the line.         */
+   size_t destsize               /**< The size of the buffer.                 */
+)
+{
+   cbool_t result = false;
+#if defined __linux__
+   FILE * f = fopen(path, "r");
+   if (not_NULL(f))
+   {
+      if (not_NULL(fgets(destination, (int) destsize, f)))
+      {
+         char * nl = strchr(destination, '\n');
+         if (not_NULL(nl))
+            *nl = 0;
+
+         result = true;
+      }
+      (void) fclose(f);
+   }
+#endif
+   return result;
+}
+
+/******************************************************************************
+ * cpu_sysfs_int() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads an integer from a small sysfs file of the given CPU.
+ *
+ * \return
+ *    Returns the integer, or -1 if the file could not be read.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static int
+cpu_sysfs_int
+(
+   int cpu,                      /**< The logical CPU number.                 */
+   const char * name             /**< The file under cpuN/topology.           */
+)
+{
+   int result = -1;
+   char path[128];
+   char line[32];
+   (void) snprintf
+   (
+      path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s",
+      cpu, name
+   );
+   if (cpu_sysfs_read(path, line, sizeof(line)))
+      result = atoi(line);
+
+   return result;
+}
+
+/******************************************************************************
+ * cpu_parse_list() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Expands a Linux CPU or node list, such as "0-3,8,10-11", into an array
+ *    of numbers.
+ *
+ * \return
+ *    Returns the number of entries in the list.  This can be more than
+ *    \a maxitems, in which case only the first \a maxitems are stored.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static int
+cpu_parse_list
+(
+   const char * list,            /**< The list to parse.                      */
+   int * items,                  /**< The array to fill, or a null pointer.   */
+   int maxitems                  /**< The size of the array.                  */
+)
+{
+   int result = 0;
+   while (isdigit((unsigned char) *list))
+   {
+      char * end;
+      int first = (int) strtol(list, &end, 10);
+      int last = first;
+      int i;
+      if (*end == '-')
+         last = (int) strtol(end + 1, &end, 10);
+
+      for (i = first; i <= last; ++i, ++result)
+      {
+         if (not_NULL(items) && result < maxitems)
+            items[result] = i;
+      }
+      list = (*end == ',') ? end + 1 : end;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_cpu_count()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the number of logical CPUs that are online.
+ *
+ * \return
+ *    Returns the number of CPUs, at least 1.
+ *
+ * \unittests
+ *    -  cpu_os_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_cpu_count (void)
+{
+   int result = 1;
+#if XPC_HAVE_UNISTD_H && defined _SC_NPROCESSORS_ONLN
+   long count = sysconf(_SC_NPROCESSORS_ONLN);
+   if (count > 1)
+      result = (int) count;
+#endif
+   return result;
+}
+
+/******************************************************************************
+ * xpc_cpu_online_cpus()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Lists the logical CPUs that are online, from
+ *    /sys/devices/system/cpu/online.  The numbers need not run from 0 to
+ *    xpc_cpu_count() - 1, since CPUs can be taken offline.
+ *
+ *    If the list cannot be read, CPUs 0 to xpc_cpu_count() - 1 are listed.
+ *
+ * \return
+ *    Returns the number of CPUs online, which can be more than \a maxcpus.
+ *    Only the first \a maxcpus are stored.
+ *
+ * \unittests
+ *    -  cpu_os_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_cpu_online_cpus
+(
+   int * cpus,                   /**< The array to receive the CPU numbers.   */
+   int maxcpus                   /**< The size of the array.                  */
+)
+{
+   int result = 0;
+   char line[512];
+   if (cpu_sysfs_read("/sys/devices/system/cpu/online", line, sizeof(line)))
+      result = cpu_parse_list(line, cpus, maxcpus);
+
+   if (result == 0)
+   {
+      int count = xpc_cpu_count();
+      for (result = 0; result < count; ++result)
+      {
+         if (not_NULL(cpus) && result < maxcpus)
+            cpus[result] = result;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_cpu_node_count()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the number of NUMA nodes, from /sys/devices/system/node/online.
+ *
+ * \return
+ *    Returns one more than the highest online node number.  If the node
+ *    list cannot be read (no NUMA support, or not Linux), 1 is returned.
+ *
+ * \unittests
+ *    -  cpu_os_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_cpu_node_count (void)
+{
+   int result = 1;
+   char line[256];
+   if (cpu_sysfs_read("/sys/devices/system/node/online", line, sizeof(line)))
+   {
+      int nodes[256];
+      int count = cpu_parse_list(line, nodes, 256);
+      if (count > 0 && count <= 256)
+         result = nodes[count - 1] + 1;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_cpu_node_cpus()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Lists the logical CPUs of a NUMA node.
+ *
+ *    If the node list cannot be read, node 0 is taken to hold every online
+ *    CPU, so that binding to node 0 works on machines without NUMA support.
+ *
+ * \return
+ *    Returns the number of CPUs in the node, which can be more than
+ *    \a maxcpus.  Only the first \a maxcpus are stored.  Returns 0 if the
+ *    node does not exist.
+ *
+ * \unittests
+ *    -  cpu_os_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_cpu_node_cpus
+(
+   int node,                     /**< The NUMA node number.                   */
+   int * cpus,                   /**< The array to receive the CPU numbers.   */
+   int maxcpus                   /**< The size of the array.                  */
+)
+{
+   int result = 0;
+   if (node >= 0)
+   {
+      char path[64];
+      char line[512];
+      (void) snprintf
+      (
+         path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node
+      );
+      if (cpu_sysfs_read(path, line, sizeof(line)))
+         result = cpu_parse_list(line, cpus, maxcpus);
+      else if (node == 0)
+         result = xpc_cpu_online_cpus(cpus, maxcpus);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_cpu_info()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the core, package, and NUMA node of a logical CPU, from the
+ *    Linux sysfs topology files.
+ *
+ *    A core or package that the topology files do not give is reported
+ *    as -1, as is the node of a CPU that no node lists.  Without NUMA
+ *    support, node 0 holds every online CPU (see xpc_cpu_node_cpus()).
+ *
+ * \return
+ *    Returns 'true' if the parameters are valid.
+ *
+ * \unittests
+ *    -  cpu_os_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_cpu_info
+(
+   int cpu,                      /**< The logical CPU number.                 */
+   xpc_cpu_info_t * info         /**< The structure to fill in.               */
+)
+{
+   cbool_t result = not_nullptr(info) && cpu >= 0;
+   if (result)
+   {
+      int nodes = xpc_cpu_node_count();
+      int node;
+      info->m_Cpu = cpu;
+      info->m_Core = cpu_sysfs_int(cpu, "core_id");
+      info->m_Package = cpu_sysfs_int(cpu, "physical_package_id");
+      info->m_Node = -1;
+      for (node = 0; node < nodes && info->m_Node < 0; ++node)
+      {
+         int cpus[XPC_CPU_MAX];
+         int count = xpc_cpu_node_cpus(node, cpus, XPC_CPU_MAX);
+         int c;
+         for (c = 0; c < count && c < XPC_CPU_MAX; ++c)
+         {
+            if (cpus[c] == cpu)
+            {
+               info->m_Node = node;
+               break;
+            }
+         }
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_cpu_topology_show()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Shows the core, package, and node of each online CPU.
+ *
+ *    This showing is done only if xpc_showinfo() is 'true'.
+ *
+ * \unittests
+ *    -  cpu_os_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_cpu_topology_show (void)
+{
+   if (xpc_showinfo())
+   {
+      int cpus[XPC_CPU_MAX];
+      int count = xpc_cpu_online_cpus(cpus, XPC_CPU_MAX);
+      int c;
+      xpc_infoprintf
+      (
+         "%s: %d, %s: %d", _("CPUs"), count,
+         _("NUMA nodes"), xpc_cpu_node_count()
+      );
+      for (c = 0; c < count && c < XPC_CPU_MAX; ++c)
+      {
+         xpc_cpu_info_t info;
+         if (xpc_cpu_info(cpus[c], &info))
+         {
+            xpc_infoprintf
+            (
+               "   cpu %3d:  core %3d  package %2d  node %2d",
+               info.m_Cpu, info.m_Core, info.m_Package, info.m_Node
+            );
+         }
+      }
+   }
+}
+
 /******************************************************************************
  * cpu.c
  *-----------------------------------------------------------------------------
@@ -30,10 +30,15 @@
 
 #include <xpc/errorlog_macros.h>       /* macros                              */
 #include <xpc/errorlogging.h>          /* external functions                  */
+#include <xpc/file_functions.h>        /* xpc_file_rotate(), etc.             */
+#include <xpc/logrecord.h>             /* xpc_logrecord_encode(), etc.        */
+#include <xpc/logring.h>               /* xpc_logring_append(), etc.          */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
 #include <xpc/portable.h>              /* xpc_get_microseconds()              */
 #include <xpc/xstrings.h>              /* xpc_string_n_cat()                  */
 #include <xpc/syncher.h>               /* xpc_syncher_t structure             */
+#include <xpc/pthreader.h>             /* pthreader_create(), pthreader_join()*/
+#include <xpc/atomix.h>                /* xpc_atomic_load() and other macros  */
 XPC_REVISION(errorlogging)
 
 #if XPC_HAVE_STDARG_H
@@ -74,6 +79,15 @@ XPC_REVISION(errorlogging)
 #include <unistd.h>                    /* here, it defines isatty()           */
 #endif
 
+#if XPC_HAVE_CLOCK_GETTIME
+#include <time.h>                      /* clock_gettime()                     */
+#endif
+
+#if defined __GNUC__ && (defined __i386__ || defined __x86_64__)
+#include <cpuid.h>                     /* __get_cpuid()                       */
+#include <x86intrin.h>                 /* __rdtsc()                           */
+#endif
+
 /******************************************************************************
  * DOXYGEN
  *------------------------------------------------------------------------*//**
@@ -95,6 +109,117 @@ XPC_REVISION(errorlogging)
 #define DOCUMENT_VA_MSGTAG
 #endif
 
+/******************************************************************************
+ * xpc_errlog_state
+ *------------------------------------------------------------------------*//**
+ *
+ *    This global variable packs the current error-level and the boolean
+ *    logging options into one word, so that checking whether a message is
+ *    to be shown costs a single relaxed load.  See the "Fast error-level
+ *    checks" section of errorlogging.h.
+ *
+ *    By default, the level is XPC_ERROR_LEVEL_ERRORS, and color is on for
+ *    POSIX.  Since the word is statically initialized, the level is correct
+ *    even before the first call to any function in this module.
+ *
+ * \private
+ *    Although this variable is global (so that the macros can read it),
+ *    only the functions in this module write it, using the setters below.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifdef XPC_NO_ERRORLOG
+#define ERRLOG_STATE_LEVEL       XPC_ERROR_LEVEL_NONE
+#else
+#define ERRLOG_STATE_LEVEL       XPC_ERROR_LEVEL_ERRORS
+#endif
+
+#ifdef POSIX
+#define ERRLOG_STATE_COLOR       XPC_ERRLOG_USE_COLOR
+#else
+#define ERRLOG_STATE_COLOR       0
+#endif
+
+unsigned xpc_errlog_state = ERRLOG_STATE_LEVEL | ERRLOG_STATE_COLOR;
+
+/******************************************************************************
+ * errlog_flag() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests one of the XPC_ERRLOG_xxx flag bits in xpc_errlog_state.
+ *
+ * \param flag
+ *    The flag bit to test.
+ *
+ * \return
+ *    Returns 'true' if the flag is set.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+errlog_flag (unsigned flag)
+{
+   return (xpc_atomic_load_relaxed(&xpc_errlog_state) & flag) != 0;
+}
+
+/******************************************************************************
+ * errlog_flag_set() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets or clears one of the XPC_ERRLOG_xxx flag bits in
+ *    xpc_errlog_state, without disturbing the other bits.
+ *
+ * \param flag
+ *    The flag bit to modify.
+ *
+ * \param value
+ *    If 'true', the bit is set, otherwise it is cleared.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+errlog_flag_set (unsigned flag, cbool_t value)
+{
+   if (value)
+      (void) xpc_atomic_or(&xpc_errlog_state, flag);
+   else
+      (void) xpc_atomic_and(&xpc_errlog_state, ~flag);
+}
+
+/******************************************************************************
+ * errlog_level_store() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Replaces the error-level bits of xpc_errlog_state, without disturbing
+ *    the flag bits.
+ *
+ * \param errlevel
+ *    The new error-level, already validated by the caller.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+errlog_level_store (int errlevel)
+{
+   unsigned expected = xpc_atomic_load_relaxed(&xpc_errlog_state);
+   unsigned desired;
+   do
+   {
+      desired = (expected & ~XPC_ERRLOG_LEVEL_MASK) |
+         ((unsigned) errlevel & XPC_ERRLOG_LEVEL_MASK);
+
+   } while (! xpc_atomic_cas(&xpc_errlog_state, &expected, desired));
+}
+
 /******************************************************************************
  * Critical section for synchronizing output [static]
  *------------------------------------------------------------------------*//**
@@ -127,27 +252,6 @@ static xpc_syncher_t gcritex;
 
 static cbool_t gcritex_inited = false;
 
-/******************************************************************************
- * gs_Critex_Usage
- *------------------------------------------------------------------------*//**
- *
- *    This flag indicates if the text-synchronization critex is to be used.
- *
- *    It is controlled by the --synch and --no-synch options from the
- *    command-line.
- *
- *    If set to 'true', the gcritex structrue is set up and used to help
- *    keep the text output from different threads from being intermingled.
- *    But please note that it can affect the detectability of threading
- *    problems.
- *
- *    This value is normally false, because it can affect the running of
- *    multi-threaded programs.
- *
- *//*-------------------------------------------------------------------------*/
-
-static cbool_t gs_Critex_Usage = false;
-
 /******************************************************************************
  * gcritex_atexit_set
  *------------------------------------------------------------------------*//**
@@ -252,7 +356,7 @@ static cbool_t
 synch_lock (void)
 {
    cbool_t result = true;
-   if (gs_Critex_Usage)
+   if (errlog_flag(XPC_ERRLOG_SYNCH))
       result = xpc_syncher_enter(synch_critex());
 
    return result;
@@ -277,7 +381,7 @@ synch_lock (void)
 static void
 synch_unlock (void)
 {
-   if (gs_Critex_Usage)
+   if (errlog_flag(XPC_ERRLOG_SYNCH))
    {
       fflush(xpc_logfile());
       (void) xpc_syncher_leave(synch_critex());
@@ -294,8 +398,8 @@ synch_unlock (void)
  *    effect is to make the output much less garbled when multithreading is
  *    in force.
  *
- *    The private variable controlling this usage is gs_Critex_Usage.  The
- *    critex value used is gcritex.
+ *    The private flag controlling this usage is the XPC_ERRLOG_SYNCH bit of
+ *    xpc_errlog_state.  The critex value used is gcritex.
  *
  *    This function also makes sure that synch_critex_destroy() is
  *    registered as a C atexit() handler.
@@ -324,7 +428,7 @@ cbool_t
 xpc_synchusage_set (cbool_t flag)
 {
    cbool_t result = true;
-   gs_Critex_Usage = flag;
+   errlog_flag_set(XPC_ERRLOG_SYNCH, flag);
    if (flag)
       xpc_warnprint(_("output synchronization enabled"));
    else
@@ -351,7 +455,7 @@ xpc_synchusage_set (cbool_t flag)
  * xpc_synchusage()
  *------------------------------------------------------------------------*//**
  *
- *    Obtains the current value of gs_Critex_Usage.
+ *    Obtains the current value of the XPC_ERRLOG_SYNCH flag.
  *
  *    This function is useful in unit-testing to save the current value for
  *    later restoration.
@@ -365,1040 +469,2420 @@ xpc_synchusage_set (cbool_t flag)
 cbool_t
 xpc_synchusage (void)
 {
-   return gs_Critex_Usage;
+   return errlog_flag(XPC_ERRLOG_SYNCH);
 }
 
 /******************************************************************************
- * gs_Use_Color
+ * Asynchronous logging [static]
  *------------------------------------------------------------------------*//**
  *
- *    The following section handles adding some color to the messages.
+ *    These items implement the optional asynchronous back-end of the
+ *    error-log, enabled by xpc_async_logging_set() or the "--async-log"
+ *    command-line option.
  *
- * \private
- *    This color flag is private to the error logging module.  The caller
- *    can access it through the xpc_usecolor_set() and xpc_usecolor()
- *    functions.
+ *    In this mode, the logging functions render each line into a slot of
+ *    a fixed-size ring, and return without touching the log file.  A single
+ *    writer thread drains the ring in batches, writing each batch with one
+ *    fwrite() call.  Thus the latency of the disk or terminal is kept out
+ *    of the threads that do the logging.
+ *
+ *    The ring is a bounded multi-producer, single-consumer queue.  Each
+ *    slot carries a sequence number that tells a producer when the slot is
+ *    free, and tells the writer when the slot has been filled.  Producers
+ *    claim a slot with one compare-and-swap on gs_Async_Head, and never
+ *    wait on each other while copying their text.
+ *
+ *    With --log-binary, a slot can instead hold a binary log record (see
+ *    logrecord.h), which the writer formats while filling its batch.  The
+ *    cost of the formatting is then moved out of the logging threads.
+ *
+ *    If the ring is full, the producer wakes the writer and yields until a
+ *    slot is freed; messages are never dropped.  A line too long for a slot
+ *    is written synchronously, after the lines already queued have been
+ *    drained, so that the order of the output is preserved.
+ *
+ *    Syslog output is not affected by this mode.
  *
  *//*-------------------------------------------------------------------------*/
 
-#undef USE_XPC_COLORS
+typedef struct
+{
+   size_t m_Sequence;                  /**< Slot state; see async_enqueue().  */
+   size_t m_Length;                    /**< Number of bytes in the slot text. */
+   cbool_t m_Binary;                   /**< The text is a binary log record.  */
+   char m_Text[XPC_ASYNC_LOG_SLOT_SIZE];  /**< The rendered line or record.   */
 
-#ifdef POSIX
-#define USE_XPC_COLORS
-static cbool_t gs_Use_Color = true;
-#endif
+} xpc_async_slot_t;
 
-#ifdef WIN32
-#undef USE_XPC_COLORS      /* cannot use, see comments for xpc_usecolor_set() */
-static cbool_t gs_Use_Color = false;
-#endif
+#define XPC_ASYNC_LOG_MASK       (XPC_ASYNC_LOG_SLOTS - 1)
 
 /******************************************************************************
- * xpc_usecolor_set() [POSIX]
+ * gs_Async_Ring and related items [static]
  *------------------------------------------------------------------------*//**
  *
- *    Turns the usage of console colors on or off.
- *
- *    The command-line option to turn colors on is "--color", but colors are
- *    on by default.   The command-line option to turn colors off is
- *    "--mono".  If the error-log is a file, then color is turned off no
- *    matter what, to avoid cluttering the file with ANSI escape sequences.
- *
- *    The colors are applied only to the characters that flag the type of
- *    message (warning, error, etc.) that is being logged.
+ *    The ring is allocated the first time asynchronous logging is enabled,
+ *    and freed at exit.  gs_Async_Head is written by all producers, and
+ *    gs_Async_Tail only by the writer thread, so they are kept on separate
+ *    cache lines.  gs_Async_Written counts the lines written, which
+ *    xpc_flush_error_log() waits on.
  *
- *    This function does nothing (except print an error message) under
- *    Win32, because the console output does not seem to support color, even
- *    with the ANSI.SYS file loaded (on Windows XP anyway).  Here, it looks
- *    like it cannot work in a Win32 console application, since the MS-DOS
- *    subsystem is required:
+ *    gs_Async_Logging is the flag checked by the producers.  gs_Async_Stop
+ *    tells the writer thread to exit once the ring is empty.
+ *    gs_Async_Sleeping tells producers that the writer needs a signal.
+ *    The writer sets it and then checks the ring again, and a producer
+ *    publishes its slot and then reads the flag, each with a full fence
+ *    in between, so that at least one of them sees the other, and no
+ *    wakeup is lost.
  *
- *       http://support.microsoft.com/kb/101875
+ *//*-------------------------------------------------------------------------*/
+
+static xpc_async_slot_t * gs_Async_Ring = nullptr;
+static xpc_cache_aligned size_t gs_Async_Head = 0;
+static xpc_cache_aligned size_t gs_Async_Tail = 0;
+static xpc_cache_aligned size_t gs_Async_Written = 0;
+static cbool_t gs_Async_Logging = false;
+static cbool_t gs_Async_Stop = false;
+static cbool_t gs_Async_Sleeping = false;
+static cbool_t gs_Async_Atexit_Set = false;
+static pthread_t gs_Async_Writer;
+static pthread_mutex_t gs_Async_Mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gs_Async_Wakeup = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t gs_Async_Drained = PTHREAD_COND_INITIALIZER;
+
+/******************************************************************************
+ * gs_Async_Is_Writer [static]
+ *------------------------------------------------------------------------*//**
  *
- *    We will not bother to try to get the XPC to build and operate under
- *    MS-DOS !
+ *    Set only in the writer thread.  If the writer itself has something to
+ *    log, the text is written synchronously, since the writer cannot wait
+ *    on a full ring that only it can empty.
  *
-\verbatim
-   Attribute codes       Text color codes      Background color codes
+ *//*-------------------------------------------------------------------------*/
 
-      00 = none             30 = black           40 = black
-      01 = bold             31 = red             41 = red
-      04 = underscore       32 = green           42 = green
-      05 = blink            33 = yellow          43 = yellow
-      07 = reverse          34 = blue            44 = blue
-      08 = concealed        35 = magenta         45 = magenta
-                            36 = cyan            46 = cyan
-                            37 = white           47 = white
-\endverbatim
+static xpc_thread_local cbool_t gs_Async_Is_Writer = false;
+
+/******************************************************************************
+ * async_logging_active() [static]
+ *------------------------------------------------------------------------*//**
  *
- * Escape-sequence formats:
+ *    Indicates if a line should go to the ring.
  *
-\verbatim
-         static const char * const gs_Color_Fmt = "\x1B[0%1d;%2dm";
-         static const char * const gs_Color_Off = "\x1B[00m";
-\endverbatim
+ * \return
+ *    Returns 'true' if asynchronous logging is on, and the caller is not
+ *    the writer thread.
  *
- * \win32
- *    Even with %systemroot%/system32/config.nt edited to contain the line
- *    "device=%systemroot%/system32/ansi.sys", neither cmd.exe nor
- *    command.com seem to support ANSI escape sequences on Windows XP.
- *    Yet, the Cygwin bash shell does color in a Windows "cmd.exe" window.
- *    The reason seems to be in the difference between color escape
- *    sequences.  Compare these:
+ * \unittests
+ *    No direct unit-test possible in a static C function.
  *
-\verbatim
-      DOS (cmd.exe)
-
-            ^[[0mfilename^[[0m               No color
-            ^[[01;34mdirectory^[[0m          Blue
+ *//*-------------------------------------------------------------------------*/
 
-      Linux (rxvt)
+static cbool_t
+async_logging_active (void)
+{
+   return xpc_atomic_load_relaxed(&gs_Async_Logging) && ! gs_Async_Is_Writer;
+}
 
-            ^[[00mfilename&[[00m             No color
-            ^[[01;34mdirectory^[[00m         Blue
-\endverbatim
+/******************************************************************************
+ * async_timed_wait() [static]
+ *------------------------------------------------------------------------*//**
  *
- * \param flag
- *    Determines the status of color usage.  True == colors on, false ==
- *    colors off.
+ *    Waits on one of the asynchronous-logging condition variables, for at
+ *    most the given number of milliseconds.  The caller must hold
+ *    gs_Async_Mutex.
  *
- * \return
- *    Returns 'true' if the compiler settings allow the setting of color to
- *    be performed.
+ *    The timeout is only a backstop.  The producers signal the writer
+ *    without taking the mutex when they can avoid it, but the handshake
+ *    on gs_Async_Sleeping keeps that from losing a wakeup.
+ *
+ * \param cond
+ *    The condition variable to wait on.
+ *
+ * \param ms
+ *    The longest time to wait.
  *
  * \unittests
- *    -  errorlogging_test_02_02()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_usecolor_set (cbool_t flag)
+static void
+async_timed_wait (pthread_cond_t * cond, int ms)
 {
-#ifdef USE_XPC_COLORS
-
-   gs_Use_Color = flag;
-   return true;
+   struct timeval now;
+   struct timespec deadline;
+   long nanoseconds;
+   (void) xpc_get_microseconds(&now);
+   nanoseconds = ((long) now.tv_usec + ms * 1000L) * 1000L;
+   deadline.tv_sec = now.tv_sec + nanoseconds / 1000000000L;
+   deadline.tv_nsec = nanoseconds % 1000000000L;
+   (void) pthread_cond_timedwait(cond, &gs_Async_Mutex, &deadline);
+}
 
-#else
+/******************************************************************************
+ * async_wake_writer() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Signals the writer thread, but only if it is waiting for work.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
 
-   if (flag)
-   {
-      xpc_errprint_func(_("console color support not supported"));
-      return false;
-   }
-   else
+static void
+async_wake_writer (void)
+{
+   xpc_atomic_fence();                          /* see gs_Async_Sleeping   */
+   if (xpc_atomic_load(&gs_Async_Sleeping))
    {
-      gs_Use_Color = false;
-      return true;
+      pthread_mutex_lock(&gs_Async_Mutex);
+      pthread_cond_signal(&gs_Async_Wakeup);
+      pthread_mutex_unlock(&gs_Async_Mutex);
    }
-
-#endif                                                   /* USE_XPC_COLOR     */
 }
 
 /******************************************************************************
- * xpc_usecolor()
+ * async_enqueue() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Returns the status of color usage in the output.
+ *    Copies one rendered line (or binary log record) into the ring.
  *
- *    This status is normally on by default for UNIXen, and off for Windows.
- *    It is also disabled if the log file is an actual file, rather than
- *    stdout or stderr.
+ *    A slot whose sequence number equals the producer position is free.
+ *    The producer claims it by advancing gs_Async_Head, copies the text,
+ *    and then publishes it by setting the sequence number to position + 1.
+ *    The writer, after consuming the slot, sets the sequence to position +
+ *    XPC_ASYNC_LOG_SLOTS, which frees it for the next lap of the ring.
  *
- * \posix
- *    If isatty() is false, then gs_Use_Color is turned off, since it's
- *    nice to not have escape sequences in output that is redirected to a
- *    file.
+ * \param line
+ *    The rendered line, including the newline.
  *
- *    Would someone ever want to capture the control characters?  Yes, but
- *    too bad for now.
+ * \param length
+ *    The length of the line, which must be less than
+ *    XPC_ASYNC_LOG_SLOT_SIZE.
+ *
+ * \param binary
+ *    If 'true', the line is a binary log record, to be formatted by the
+ *    writer thread.
  *
  * \return
- *    The private boolean value for the usage of color.
+ *    Returns 'true' if the line was queued.  Returns 'false' if
+ *    asynchronous logging was turned off while waiting for space, in which
+ *    case the caller writes the line itself.
  *
  * \unittests
- *    -  errorlogging_test_02_02()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_usecolor (void)
+static cbool_t
+async_enqueue (const char * line, size_t length, cbool_t binary)
 {
-
-#if XPC_HAVE_UNISTD_H
-
-   if (gs_Use_Color)
+   size_t position = xpc_atomic_load_relaxed(&gs_Async_Head);
+   for (;;)
    {
-      FILE * logfile = xpc_logfile();        /* get the current file pointer  */
-      if (! isatty(fileno(logfile)))         /* is it a descriptor for a TTY? */
-         gs_Use_Color = false;               /* no, so don't allow color      */
+      xpc_async_slot_t * slot = &gs_Async_Ring[position & XPC_ASYNC_LOG_MASK];
+      size_t sequence = xpc_atomic_load(&slot->m_Sequence);
+      if (sequence == position)
+      {
+         if (xpc_atomic_cas(&gs_Async_Head, &position, position + 1))
+         {
+            memcpy(slot->m_Text, line, length);
+            slot->m_Length = length;
+            slot->m_Binary = binary;
+            xpc_atomic_store(&slot->m_Sequence, position + 1);
+            async_wake_writer();
+            return true;
+         }
+      }
+      else if ((ptrdiff_t) (sequence - position) < 0)    /* ring is full    */
+      {
+         if (! xpc_atomic_load(&gs_Async_Logging))
+            return false;
+
+         pthread_mutex_lock(&gs_Async_Mutex);
+         pthread_cond_signal(&gs_Async_Wakeup);
+         pthread_mutex_unlock(&gs_Async_Mutex);
+         pthreader_yield();
+         position = xpc_atomic_load_relaxed(&gs_Async_Head);
+      }
+      else                                      /* another producer won    */
+         position = xpc_atomic_load_relaxed(&gs_Async_Head);
    }
+}
 
-#endif
+/******************************************************************************
+ * log_written() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    The writer thread counts the bytes it writes, for log rotation.  The
+ *    function is defined with the rest of the rotation code, further on.
+ *
+ *//*-------------------------------------------------------------------------*/
 
-   return gs_Use_Color;
-}
+static void log_written (size_t count);
 
 /******************************************************************************
- * xpc_dbgmark()
+ * async_write_batch() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Provides the proper marker for the 'debug' error-level.
+ *    Moves as many published lines as fit from the ring into the writer's
+ *    batch buffer, and writes them to the log file with one fwrite() call.
+ *    Binary log records are formatted into the batch here.
  *
- *    The marker is either uncolored, or it is colored.  In the latter case,
- *    it includes ANSI escape sequences that color the character in
- *    terminals or consoles that support ANSI escape sequences.
+ *    The slots are freed, and gs_Async_Tail advanced, only once the batch
+ *    has been written.  If the log lock cannot be had, the lines stay in
+ *    the ring for the next pass, so that none are lost.
  *
- *    This function is exposed as a convenience for callers.
+ *    This function is called only by the writer thread.
+ *
+ * \param batch
+ *    The writer's buffer, of size XPC_ASYNC_LOG_BATCH_SIZE.
  *
  * \return
- *    Either a colored or uncolored ">" character as a null-terminated string.
+ *    Returns the number of lines written and taken from the ring, which
+ *    are also counted in gs_Async_Written.
  *
  * \unittests
- *    -  errorlogging_test_02_04() [placeholder]
- *    -  No unit-test for this trivial function that exposes internal macros.
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-const char *
-xpc_dbgmark (void)
+static size_t
+async_write_batch (char * batch)
 {
-   return xpc_usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG ;
-}
+   size_t count = 0;
+   size_t used = 0;
+   size_t tail = gs_Async_Tail;
+   for (;;)
+   {
+      xpc_async_slot_t * slot =
+         &gs_Async_Ring[(tail + count) & XPC_ASYNC_LOG_MASK];
+
+      if (xpc_atomic_load(&slot->m_Sequence) != tail + count + 1)
+         break;                                 /* empty, or not published */
+
+      if (slot->m_Binary)
+      {
+         if (used + XPC_LOGRECORD_TEXT_SIZE > XPC_ASYNC_LOG_BATCH_SIZE)
+            break;                              /* leave it for next batch */
+
+         used += xpc_logrecord_format
+         (
+            slot->m_Text, slot->m_Length, &batch[used],
+            XPC_LOGRECORD_TEXT_SIZE
+         );
+      }
+      else
+      {
+         if (used + slot->m_Length > XPC_ASYNC_LOG_BATCH_SIZE)
+            break;                              /* leave it for next batch */
+
+         memcpy(&batch[used], slot->m_Text, slot->m_Length);
+         used += slot->m_Length;
+      }
+      ++count;
+   }
+   if (count > 0)
+   {
+      if (synch_lock())
+      {
+         size_t done;
+         FILE * fp = xpc_logfile();
+         (void) fwrite(batch, 1, used, fp);
+         if (! errlog_flag(XPC_ERRLOG_SYNCH))
+            fflush(fp);                         /* synch_unlock() flushes  */
+
+         synch_unlock();
+         for (done = 0; done < count; ++done, ++tail)
+         {
+            xpc_async_slot_t * slot =
+               &gs_Async_Ring[tail & XPC_ASYNC_LOG_MASK];
+
+            xpc_atomic_store(&slot->m_Sequence, tail + XPC_ASYNC_LOG_SLOTS);
+         }
+         xpc_atomic_store(&gs_Async_Tail, tail);
+         (void) xpc_atomic_add(&gs_Async_Written, count);
+         log_written(used);                     /* may rotate the log file */
+      }
+      else
+         count = 0;                             /* keep them for next pass */
+   }
+   return count;
+}
 
 /******************************************************************************
- * xpc_infomark()
+ * async_tail_published() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Provides the proper marker for the 'info' error-level.
- *
- *    The marker is either uncolored, or it is colored.  In the latter case,
- *    it includes ANSI escape sequences that color the character in
- *    terminals or consoles that support ANSI escape sequences.
- *
- *    This function is exposed as a convenience for callers, but the
- *    xpc_infoprintml() and xpc_infoprintf() functions remove much of the
- *    need for this class of functions.
+ *    Checks if the next slot the writer will take has been published.
+ *    This function is called only by the writer thread.
  *
  * \return
- *    Either a colored or uncolored "*" character as a null-terminated string.
+ *    Returns 'true' if there is a line ready to write.
  *
  * \unittests
- *    -  errorlogging_test_02_04()
- *    -  No unit-test for this trivial function that exposes internal macros.
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-const char *
-xpc_infomark (void)
+static cbool_t
+async_tail_published (void)
 {
-   return xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO ;
+   size_t tail = gs_Async_Tail;
+   xpc_async_slot_t * slot = &gs_Async_Ring[tail & XPC_ASYNC_LOG_MASK];
+   return xpc_atomic_load(&slot->m_Sequence) == tail + 1;
 }
 
 /******************************************************************************
- * xpc_warnmark()
+ * async_writer() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Provides the proper marker for the 'warn' error-level.
+ *    The writer thread.  It writes batches until the ring is empty, then
+ *    sleeps until a producer wakes it (or a short timeout expires).  It
+ *    exits when gs_Async_Stop is set and the ring has been emptied.
  *
- *    The marker is either uncolored, or it is colored.  In the latter case,
- *    it includes ANSI escape sequences that color the character in
- *    terminals or consoles that support ANSI escape sequences.
+ *    After each pass, the threads waiting in async_drain() are told that
+ *    more lines have been written.
  *
- *    This function is exposed as a convenience for callers.
+ * \param unused
+ *    Not used.
  *
  * \return
- *    Either a colored or uncolored "!" character as a null-terminated string.
+ *    Always returns a null pointer.
  *
  * \unittests
- *    -  errorlogging_test_02_04()
- *    -  No unit-test for this trivial function that exposes internal macros.
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-const char *
-xpc_warnmark (void)
+static void *
+async_writer (void * unused)
 {
-   return xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN ;
+   char * batch = malloc(XPC_ASYNC_LOG_BATCH_SIZE);
+   gs_Async_Is_Writer = true;
+   (void) unused;
+   if (is_nullptr(batch))
+   {
+      xpc_errprint_func(_("batch allocation failed"));
+      xpc_atomic_store(&gs_Async_Logging, false);
+      return nullptr;
+   }
+   for (;;)
+   {
+      size_t count = async_write_batch(batch);
+      pthread_mutex_lock(&gs_Async_Mutex);
+      pthread_cond_broadcast(&gs_Async_Drained);
+      if (count == 0)
+      {
+         cbool_t empty =
+            xpc_atomic_load(&gs_Async_Head) == xpc_atomic_load(&gs_Async_Tail);
+
+         if (empty && xpc_atomic_load(&gs_Async_Stop))
+         {
+            pthread_mutex_unlock(&gs_Async_Mutex);
+            break;
+         }
+         xpc_atomic_store(&gs_Async_Sleeping, true);
+         xpc_atomic_fence();                    /* see gs_Async_Sleeping   */
+         if (! async_tail_published())
+            async_timed_wait(&gs_Async_Wakeup, empty ? 100 : 1);
+
+         xpc_atomic_store(&gs_Async_Sleeping, false);
+      }
+      pthread_mutex_unlock(&gs_Async_Mutex);
+   }
+   free(batch);
+   return nullptr;
 }
 
 /******************************************************************************
- * xpc_errmark()
+ * async_drain() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Provides the proper marker for the 'error' error-level.
- *
- *    The marker is either uncolored, or it is colored.  In the latter case,
- *    it includes ANSI escape sequences that color the character in
- *    terminals or consoles that support ANSI escape sequences.
- *
- *    This function is exposed as a convenience for callers.
+ *    Waits until every line queued before the call has been written to the
+ *    log file.
  *
- * \return
- *    Either a colored or uncolored "?" character as a null-terminated string.
+ *    Does nothing if asynchronous logging is off, or if called from the
+ *    writer thread.
  *
  * \unittests
- *    -  errorlogging_test_02_04()
- *    -  No unit-test for this trivial function that exposes internal macros.
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-const char *
-xpc_errmark (void)
+static void
+async_drain (void)
 {
-   return xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR ;
+   if (xpc_atomic_load(&gs_Async_Logging) && ! gs_Async_Is_Writer)
+   {
+      size_t target = xpc_atomic_load(&gs_Async_Head);
+      pthread_mutex_lock(&gs_Async_Mutex);
+      while
+      (
+         xpc_atomic_load(&gs_Async_Written) < target &&
+         xpc_atomic_load(&gs_Async_Logging)
+      )
+      {
+         pthread_cond_signal(&gs_Async_Wakeup);
+         async_timed_wait(&gs_Async_Drained, 10);
+      }
+      pthread_mutex_unlock(&gs_Async_Mutex);
+   }
 }
 
 /******************************************************************************
- * xpc_usermark()
+ * async_stop() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Provides the proper marker for the 'user' error-level.
- *
- *    The marker is either uncolored, or it is colored.  In the latter case,
- *    it includes ANSI escape sequences that color the character in
- *    terminals or consoles that support ANSI escape sequences.
- *
- *    This function is exposed as a convenience for callers.
+ *    Drains the ring, then stops and joins the writer thread.  From this
+ *    point on, all lines are written synchronously.
  *
- * \return
- *    Either a colored or uncolored "-" character as a null-terminated string.
+ *    This function is also registered with atexit(), so that no queued
+ *    lines are lost when the application exits.
  *
  * \unittests
- *    -  errorlogging_test_02_04()
- *    -  No unit-test for this trivial function that exposes internal macros.
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-const char *
-xpc_usermark (void)
+static void
+async_stop (void)
 {
-   return xpc_usecolor() ? COLOR_STR_USER : ERRL_STR_USER ;
+   if (xpc_atomic_load(&gs_Async_Logging))
+   {
+      async_drain();
+      xpc_atomic_store(&gs_Async_Logging, false);
+      pthread_mutex_lock(&gs_Async_Mutex);
+      xpc_atomic_store(&gs_Async_Stop, true);
+      pthread_cond_signal(&gs_Async_Wakeup);
+      pthread_mutex_unlock(&gs_Async_Mutex);
+      (void) pthreader_join(gs_Async_Writer);
+      xpc_flush_error_log();
+   }
 }
 
 /******************************************************************************
- * gs_Error_Level
+ * async_destroy() [static]
  *------------------------------------------------------------------------*//**
  *
- *    This static variable maintains the current error level value.  By
- *    default, the value is XPC_ERROR_LEVEL_ERRORS.
+ *    The atexit() handler for asynchronous logging.  Stops the writer, and
+ *    frees the ring.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-#ifdef XPC_NO_ERRORLOG
-static int gs_Error_Level = XPC_ERROR_LEVEL_NONE;
-#else
-static int gs_Error_Level = XPC_ERROR_LEVEL_ERRORS;
-#endif
+static void
+async_destroy (void)
+{
+   async_stop();
+   if (not_NULL(gs_Async_Ring))
+   {
+      free(gs_Async_Ring);
+      gs_Async_Ring = nullptr;
+   }
+}
 
 /******************************************************************************
- * gs_Error_Inited
+ * async_start() [static]
  *------------------------------------------------------------------------*//**
  *
- *    This static variable maintains the status of the errorlogging module.
- *    It is provided to keep from needlessly initializing the subsystem, and
- *    yet make sure that it is initialized at least once before the first
- *    real usage of the subsystem.
+ *    Allocates and resets the ring, and starts the writer thread.
+ *
+ * \return
+ *    Returns 'true' if the writer thread was started.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-static cbool_t gs_Error_Inited = false;
+static cbool_t
+async_start (void)
+{
+   cbool_t result = false;
+   if (is_NULL(gs_Async_Ring))
+   {
+      gs_Async_Ring = malloc(XPC_ASYNC_LOG_SLOTS * sizeof(xpc_async_slot_t));
+      if (is_NULL(gs_Async_Ring))
+         xpc_errprint_func(_("ring allocation failed"));
+   }
+   if (not_NULL(gs_Async_Ring))
+   {
+      size_t s;
+      for (s = 0; s < XPC_ASYNC_LOG_SLOTS; ++s)
+         gs_Async_Ring[s].m_Sequence = s;
+
+      gs_Async_Head = gs_Async_Tail = gs_Async_Written = 0;
+      gs_Async_Stop = gs_Async_Sleeping = false;
+      if (! gs_Async_Atexit_Set)
+      {
+         int rcode = atexit(async_destroy);
+         if (is_posix_success(rcode))
+            gs_Async_Atexit_Set = true;
+         else
+            xpc_errprintex("atexit(async_destroy)", _("failed"));
+      }
+      if (gs_Async_Atexit_Set)
+      {
+         xpc_atomic_store(&gs_Async_Logging, true);
+         gs_Async_Writer = pthreader_create(nullptr, async_writer, nullptr);
+         result = ! pthreader_is_null_thread(gs_Async_Writer);
+         if (! result)
+            xpc_atomic_store(&gs_Async_Logging, false);
+      }
+   }
+   return result;
+}
 
 /******************************************************************************
- * gs_Log_File
+ * async_printf() [static]
  *------------------------------------------------------------------------*//**
  *
- *    This static variable maintains the pointer to the current log file.
+ *    Renders a line and queues it.
  *
- *    By default, this variable is set to stderr before its first usage.
- *    This is done by the s_init_logfile() function, which is called by the
- *    s_logfile_set(), xpc_logfile(), and xpc_buffering_set() functions.
+ *    The line is rendered on the stack.  If it does not fit in a slot, the
+ *    ring is drained, and 'false' is returned so that the caller writes the
+ *    line directly.
+ *
+ * \param fmt
+ *    The format of the whole line, including the newline.
+ *
+ * \param ...
+ *    The arguments for the format.
+ *
+ * \return
+ *    Returns 'true' if the line was queued.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-static FILE * gs_Log_File = NULLptr;
+static cbool_t
+async_printf (const char * fmt, ...)
+{
+   cbool_t result = false;
+   char line[XPC_ASYNC_LOG_SLOT_SIZE];
+   int length;
+   va_list val;
+   va_start(val, fmt);
+   length = vsnprintf(line, sizeof line, fmt, val);
+   va_end(val);
+   if ((length >= 0) && ((size_t) length < sizeof line))
+      result = async_enqueue(line, (size_t) length, false);
+   else
+      async_drain();
+
+   return result;
+}
 
 /******************************************************************************
- * init_option_errlevel() [static]
+ * xpc_async_logging_set()
  *------------------------------------------------------------------------*//**
  *
- *    A private one-shot function to initialize the error-level to the
- *    default.
+ *    Turns asynchronous logging on or off.
  *
- *    The default error-level is 'error', where any output using the
- *    xpc_errprint family of functions, or the print() function, is written to
- *    the error-log.
+ *    This function is activated by the "--async-log" command-line option.
+ *    When on, the logging functions queue each line in a lock-free ring,
+ *    and a background thread writes the lines in batches.  See the
+ *    "Asynchronous logging" section of this module.
  *
- *    We found that, in some applications, the debug level global variable was
- *    not getting set to XPC_ERROR_LEVEL_ERRORS.  So we need a way to force it
- *    to be initialized.
+ *    The first time it is turned on, a handler is registered with atexit()
+ *    to write out the remaining lines and stop the writer thread.
  *
- * \todo
- *    We have a problem where we would segfault in the command "./threadtest
- *    --clock --info".  This problem occurs only on the faster machines, in
- *    Linux.  A backtrace shows that it is occurring in the libc function
- *    cuserid(), which might not be re-entrant in the hidden vfprintf()
- *    call.  However, using the synch-lock doesn't prevent the error, so
- *    we're not sure what to do yet.
+ * \warning
+ *    Do not turn asynchronous logging off while other threads are still
+ *    logging.  Turning it off is meant for the end of an application, or
+ *    for unit tests.
  *
- *    There is a workaround:  add the "--log filename.txt" option.  This
- *    output is much faster than console output, and so is not nearly so
- *    susceptible to the segfault.
+ * \param flag
+ *    The desired setting.
  *
- *    The other workaround, of course, is to not use the "--info" option.
+ * \return
+ *    Returns 'true' if the setting succeeded.  Turning on the option fails
+ *    if the ring cannot be allocated or the writer thread cannot be
+ *    started.
  *
  * \unittests
- *    No direct unit-test possible in a static C function.
+ *    -  errorlogging_test_02_20()
  *
  *//*-------------------------------------------------------------------------*/
 
-static void
-init_option_errlevel (void)
+cbool_t
+xpc_async_logging_set (cbool_t flag)
 {
-   if (! gs_Error_Inited)
+   cbool_t result = true;
+   if (flag)
+   {
+      if (! xpc_atomic_load(&gs_Async_Logging))
+      {
+         result = async_start();
+         if (result)
+            xpc_infoprint(_("asynchronous logging enabled"));
+         else
+            xpc_errprint_func(_("asynchronous logging not started"));
+      }
+   }
+   else if (xpc_atomic_load(&gs_Async_Logging))
    {
-      gs_Error_Level = XPC_ERROR_LEVEL_ERRORS;
-      gs_Error_Inited = true;
+      async_stop();
+      xpc_infoprint(_("asynchronous logging disabled"));
    }
+   return result;
 }
 
 /******************************************************************************
- * s_init_logfile() [static]
+ * xpc_async_logging()
  *------------------------------------------------------------------------*//**
  *
- *    A private function to guarantee that the log-file pointer is
- *    initialized properly before being used.
+ *    Obtains the current setting of asynchronous logging.
  *
- *    The default error-log destination is stderr.
+ *    This function is useful in unit-testing to save the current value for
+ *    later restoration.
  *
  * \unittests
- *    No direct unit-test possible in a static C function.
+ *    -  errorlogging_test_02_20()
  *
  *//*-------------------------------------------------------------------------*/
 
-static void
-s_init_logfile (void)
+cbool_t
+xpc_async_logging (void)
 {
-   if (is_NULL(gs_Log_File))
-      gs_Log_File = stderr;
+   return xpc_atomic_load(&gs_Async_Logging);
 }
 
 /******************************************************************************
- * s_logfile_set()
+ * xpc_binary_logging_set()
  *------------------------------------------------------------------------*//**
  *
- *    This variable/function group supports the changing of the log file.
- *    The default log file is stderr.  A different log-file can be opened,
- *    which automatically closes the previous one (except for stderr and
- *    stdout [stdin is also protected, what the heck.])
+ *    Provides a setter for the XPC_ERRLOG_BINARY bit of xpc_errlog_state,
+ *    which defers the formatting of the printf()-style log lines.
  *
- *    When the log file is closed, it automatically reverts to the default,
- *    stderr.  Right now, we don't deal with a failure to close the previous
- *    file.
+ *    This function is activated by the "--log-binary" command-line option.
+ *    When on, xpc_errprintf() and the other functions that take a format
+ *    capture the format and its arguments in a binary log record (see the
+ *    logrecord.h module), instead of calling vsnprintf().  The record is
+ *    formatted later:
  *
- *    Note that enabling a log file will turn off the usage of color (to
- *    avoid ugly ESC-sequences in the file), but then the usage of color
- *    cannot be turned back on. [Note:  now we turn it back on.  Too
- *    confusing otherwise.]
+ *       -  By the writer thread, if the log file is written with
+ *          --async-log.
+ *       -  When the ring is walked (for example, by logring_dump), if the
+ *          log is a --log-ring file.
  *
- * \posix
- *    According to a comment in stdio.h, C89/99 considers stderr etc to be
- *    macros (GNU stdio say's their pointers to _IO_FILE structures), so we
- *    cannot make an assignment here.
+ *    For a log file written directly by the logging thread, and for the
+ *    system log, there is nothing to defer to, and this setting has no
+ *    effect.  Lines whose format cannot be deferred (see logrecord.h) are
+ *    formatted as usual.
  *
- * \param logfile
- *    The handle to be used as the error-log file.
+ * \param flag
+ *    The desired setting.
  *
  * \return
- *    Returns 'true' if the \e logfile parameter is valid (that is, not
- *    null).
+ *    This function always returns 'true'.  A result is returned in order to
+ *    maintain consistency with the other setter functions.
  *
  * \unittests
- *    No direct unit-test possible in a static C function.
+ *    -  errorlogging_test_02_26()
  *
  *//*-------------------------------------------------------------------------*/
 
-static cbool_t
-s_logfile_set (FILE * logfile)
+cbool_t
+xpc_binary_logging_set (cbool_t flag)
 {
-   cbool_t result = false;
-   s_init_logfile();
-   if (not_NULL(logfile))
-   {
-      if (gs_Use_Color && ((logfile != stdout) && (logfile != stderr)))
-         (void) xpc_usecolor_set(false);     /* (no need to log this action)  */
-
-      gs_Log_File = logfile;
-      result = true;
-   }
-   return result;
+   errlog_flag_set(XPC_ERRLOG_BINARY, flag);
+   return true;
 }
 
 /******************************************************************************
- * xpc_open_logfile_helper()
+ * xpc_binary_logging()
  *------------------------------------------------------------------------*//**
  *
- *    Opens a file for usage as the error-log, for either truncating it or
- *    appending to it.
- *
- *    This function is a private (C static) helper function for
- *    xpc_open_logfile() and xpc_append_logfile().
- *
- * \param logfilename
- *    Full path name to log file to be opened.
- *
- * \param truncateit
- *    If true, truncate it, else append to it.
+ *    Provides a getter for the XPC_ERRLOG_BINARY bit of xpc_errlog_state.
  *
  * \return
- *    If the parameters were appropriate, and the file was able to be opened
- *    for appending, 'true' is returned.  Otherwise, 'false' is returned.
+ *    Returns 'true' if --log-binary is in force.  The default is 'false'.
  *
  * \unittests
- *    No direct unit-test possible in a static C function; see
- *    xpc_open_logfile().
+ *    -  errorlogging_test_02_26()
  *
  *//*-------------------------------------------------------------------------*/
 
-static cbool_t
-xpc_open_logfile_helper (const char * logfilename, cbool_t truncateit)
+cbool_t
+xpc_binary_logging (void)
 {
-   cbool_t result = false;
-   if (not_nullptr(logfilename) && (strlen(logfilename) > 0))
-   {
-      FILE * lf;
-      (void) xpc_close_logfile();
-      lf = fopen(logfilename, truncateit ? "w+" : "a");
-      if (not_NULL(lf))
-      {
-         if (truncateit)
-            xpc_infoprint(_("log-file truncated"));
+   return errlog_flag(XPC_ERRLOG_BINARY);
+}
 
-         result = s_logfile_set(lf);
-      }
-      else
-      {
-         xpc_strerrnoprint_func(_("failed"));
-         (void) s_logfile_set(stderr);
-      }
-   }
-   else
-      xpc_errprint_func(_("invalid filename"));
+/******************************************************************************
+ * USE_XPC_COLORS
+ *------------------------------------------------------------------------*//**
+ *
+ *    The following section handles adding some color to the messages.
+ *
+ * \private
+ *    The color flag, the XPC_ERRLOG_USE_COLOR bit of xpc_errlog_state, is
+ *    private to the error logging module.  The caller can access it
+ *    through the xpc_usecolor_set() and xpc_usecolor() functions.
+ *
+ *//*-------------------------------------------------------------------------*/
 
-   return result;
-}
+#undef USE_XPC_COLORS
+
+#ifdef POSIX
+#define USE_XPC_COLORS
+#endif
+
+#ifdef WIN32
+#undef USE_XPC_COLORS      /* cannot use, see comments for xpc_usecolor_set() */
+#endif
 
 /******************************************************************************
- * xpc_open_logfile()
+ * xpc_usecolor_set() [POSIX]
  *------------------------------------------------------------------------*//**
  *
- *    Opens a file for usage as the error-log destination, truncating it if
- *    it exists.
+ *    Turns the usage of console colors on or off.
  *
- *    The default destination is stderr.  But, if the user specifies the
- *    "--log filename" option on the command line, then the specified file
- *    is used for logging the error and information strings.
+ *    The command-line option to turn colors on is "--color", but colors are
+ *    on by default.   The command-line option to turn colors off is
+ *    "--mono".  If the error-log is a file, then color is turned off no
+ *    matter what, to avoid cluttering the file with ANSI escape sequences.
  *
- *    If the file-name is 'stderr' or 'stdout', then that device is simply
- *    set as the current log-file.
+ *    The colors are applied only to the characters that flag the type of
+ *    message (warning, error, etc.) that is being logged.
  *
- * \param logfilename
- *    Full path name to log file to be opened.
+ *    This function does nothing (except print an error message) under
+ *    Win32, because the console output does not seem to support color, even
+ *    with the ANSI.SYS file loaded (on Windows XP anyway).  Here, it looks
+ *    like it cannot work in a Win32 console application, since the MS-DOS
+ *    subsystem is required:
+ *
+ *       http://support.microsoft.com/kb/101875
+ *
+ *    We will not bother to try to get the XPC to build and operate under
+ *    MS-DOS !
+ *
+\verbatim
+   Attribute codes       Text color codes      Background color codes
+
+      00 = none             30 = black           40 = black
+      01 = bold             31 = red             41 = red
+      04 = underscore       32 = green           42 = green
+      05 = blink            33 = yellow          43 = yellow
+      07 = reverse          34 = blue            44 = blue
+      08 = concealed        35 = magenta         45 = magenta
+                            36 = cyan            46 = cyan
+                            37 = white           47 = white
+\endverbatim
+ *
+ * Escape-sequence formats:
+ *
+\verbatim
+         static const char * const gs_Color_Fmt = "\x1B[0%1d;%2dm";
+         static const char * const gs_Color_Off = "\x1B[00m";
+\endverbatim
+ *
+ * \win32
+ *    Even with %systemroot%/system32/config.nt edited to contain the line
+ *    "device=%systemroot%/system32/ansi.sys", neither cmd.exe nor
+ *    command.com seem to support ANSI escape sequences on Windows XP.
+ *    Yet, the Cygwin bash shell does color in a Windows "cmd.exe" window.
+ *    The reason seems to be in the difference between color escape
+ *    sequences.  Compare these:
+ *
+\verbatim
+      DOS (cmd.exe)
+
+            ^[[0mfilename^[[0m               No color
+            ^[[01;34mdirectory^[[0m          Blue
+
+      Linux (rxvt)
+
+            ^[[00mfilename&[[00m             No color
+            ^[[01;34mdirectory^[[00m         Blue
+\endverbatim
+ *
+ * \param flag
+ *    Determines the status of color usage.  True == colors on, false ==
+ *    colors off.
  *
  * \return
- *    If the parameters were appropriate, and the file was able to be opened
- *    for appending, 'true' is returned.  Otherwise, 'false' is returned.
+ *    Returns 'true' if the compiler settings allow the setting of color to
+ *    be performed.
  *
  * \unittests
- *    -  errorlogging_test_02_03()
+ *    -  errorlogging_test_02_02()
  *
  *//*-------------------------------------------------------------------------*/
 
 cbool_t
-xpc_open_logfile (const char * logfilename)
+xpc_usecolor_set (cbool_t flag)
 {
-   cbool_t result = true;
-   FILE * stdio_file = NULLptr;
-   cbool_t match = (strcmp(logfilename, "stderr")) == 0 ||
-      (strcmp(logfilename, "STDERR") == 0);
+#ifdef USE_XPC_COLORS
 
-   if (match)
-      stdio_file = stderr;
-   else
-   {
-      match = (strcmp(logfilename, "stdout")) == 0 ||
-         (strcmp(logfilename, "STDOUT") == 0);
+   errlog_flag_set(XPC_ERRLOG_USE_COLOR, flag);
+   return true;
 
-      if (match)
-         stdio_file = stdout;
-      else
-      {
-         match = (strcmp(logfilename, "stdin")) == 0 ||
-            (strcmp(logfilename, "STDIN") == 0);
+#else
 
-         if (match)
-         {
-            result = false;
-            if (! xpc_shownothing())
-            {
-               fprintf
-               (
-                  stderr, "??? %s!!!\n", _("Cannot use stdin as a log file")
-               );
-            }
-         }
-      }
+   if (flag)
+   {
+      xpc_errprint_func(_("console color support not supported"));
+      return false;
    }
-   if (result)
+   else
    {
-      if (not_NULL(stdio_file))
-      {
-         (void) xpc_close_logfile();           /* todo:  use return? */
-         result = s_logfile_set(stdio_file);
-      }
-      else
-         result =  xpc_open_logfile_helper(logfilename, true);   /* truncate */
+      errlog_flag_set(XPC_ERRLOG_USE_COLOR, false);
+      return true;
    }
-   return result;
+
+#endif                                                   /* USE_XPC_COLOR     */
 }
 
 /******************************************************************************
- * xpc_append_logfile()
+ * xpc_usecolor()
  *------------------------------------------------------------------------*//**
  *
- *    Opens a file for usage as the error-log destination, for appending.
+ *    Returns the status of color usage in the output.
  *
- *    The default destination is stderr.  But, if the user specifies the
- *    "--log filename" option on the command line, then the specified file
- *    is used for logging the error and information strings.
+ *    This status is normally on by default for UNIXen, and off for Windows.
+ *    It is also disabled if the log file is an actual file, rather than
+ *    stdout or stderr.
  *
- * \param logfilename
- *    Full path name to log file to be opened.
+ * \posix
+ *    If isatty() is false, then the color flag is turned off, since it's
+ *    nice to not have escape sequences in output that is redirected to a
+ *    file.
+ *
+ *    Would someone ever want to capture the control characters?  Yes, but
+ *    too bad for now.
  *
  * \return
- *    If the parameters were appropriate, and the file was able to be opened
- *    for appending, 'true' is returned.  Otherwise, 'false' is returned.
+ *    The private boolean value for the usage of color.
  *
  * \unittests
- *    -  errorlogging_test_02_03()
+ *    -  errorlogging_test_02_02()
  *
  *//*-------------------------------------------------------------------------*/
 
 cbool_t
-xpc_append_logfile (const char * logfilename)
+xpc_usecolor (void)
 {
-   return xpc_open_logfile_helper(logfilename, false); /* append to log file */
+
+#if XPC_HAVE_UNISTD_H
+
+   if (errlog_flag(XPC_ERRLOG_USE_COLOR))
+   {
+      FILE * logfile = xpc_logfile();        /* get the current file pointer  */
+      if (! isatty(fileno(logfile)))         /* is it a descriptor for a TTY? */
+         errlog_flag_set(XPC_ERRLOG_USE_COLOR, false);   /* no color, then    */
+   }
+
+#endif
+
+   return errlog_flag(XPC_ERRLOG_USE_COLOR);
 }
 
 /******************************************************************************
- * xpc_close_logfile()
+ * xpc_dbgmark()
  *------------------------------------------------------------------------*//**
  *
- *    Closes the current log file for the error-log.
+ *    Provides the proper marker for the 'debug' error-level.
  *
- *    If the log file is not one of the standard ones (<i>stderr</i>,
- *    <i>stdout</i>, or <i>stdin</i>), it is closed.
+ *    The marker is either uncolored, or it is colored.  In the latter case,
+ *    it includes ANSI escape sequences that color the character in
+ *    terminals or consoles that support ANSI escape sequences.
  *
- * \sideeffect
- *    Whether or not the closing succeeds, the log-file is returned to the
- *    handle it had at the start of the application -- \e stderr.
+ *    This function is exposed as a convenience for callers.
  *
  * \return
- *    If the file was not one of the standard ones, and it was successfully
- *    closed, 'true' is returned.  Otherwise, 'false' is returned.
+ *    Either a colored or uncolored ">" character as a null-terminated string.
  *
  * \unittests
- *    -  errorlogging_test_02_03()
+ *    -  errorlogging_test_02_04() [placeholder]
+ *    -  No unit-test for this trivial function that exposes internal macros.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_close_logfile (void)
+const char *
+xpc_dbgmark (void)
 {
-   cbool_t result = false;
-   FILE * lf = xpc_logfile();
-   cbool_t ok = (lf != stderr) && (lf != stdout) && (lf != stdin);
-   if (ok && not_NULL(lf))
-   {
-      int rcode = fclose(lf);
-      result = (rcode == 0);
-      (void) xpc_usecolor_set(true);      /* do not use the return value here */
-   }
-   (void) s_logfile_set(stderr);
-   return result;
+   return xpc_usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG ;
 }
 
 /******************************************************************************
- * xpc_logfile()
+ * xpc_infomark()
  *------------------------------------------------------------------------*//**
  *
- *    Provides the handle to the error-log file.
+ *    Provides the proper marker for the 'info' error-level.
  *
- *    This function can be used in fprintf() and similar calls to direct
- *    output to the current log file (\e stderr by default).
+ *    The marker is either uncolored, or it is colored.  In the latter case,
+ *    it includes ANSI escape sequences that color the character in
+ *    terminals or consoles that support ANSI escape sequences.
  *
- *    This function always calls the private helper function s_init_logfile()
- *    in order to guarantee that the handle is properly initialized.  The
- *    s_init_logfile() function has a boolean the makes it do the setup just
- *    once during the lifetime of an application.  Otherwise, there is no
- *    way to guarantee that the handle is initialized by the time the caller
- *    uses the log-file handle.
+ *    This function is exposed as a convenience for callers, but the
+ *    xpc_infoprintml() and xpc_infoprintf() functions remove much of the
+ *    need for this class of functions.
  *
  * \return
- *    The private handle to the log file, gs_Log_File, is returned.
+ *    Either a colored or uncolored "*" character as a null-terminated string.
  *
  * \unittests
- *    -  errorlogging_test_02_03()
+ *    -  errorlogging_test_02_04()
+ *    -  No unit-test for this trivial function that exposes internal macros.
  *
  *//*-------------------------------------------------------------------------*/
 
-FILE *
-xpc_logfile (void)
+const char *
+xpc_infomark (void)
 {
-   s_init_logfile();                         /* *guarantee* it is not null    */
-   return gs_Log_File;
+   return xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO ;
 }
 
 /******************************************************************************
- * gs_Use_TimeStamps
+ * xpc_warnmark()
  *------------------------------------------------------------------------*//**
  *
- *    Provides a flag to enable the inclusion of microsecond-level time stamps
- *    in the errorlogging output.
+ *    Provides the proper marker for the 'warn' error-level.
+ *
+ *    The marker is either uncolored, or it is colored.  In the latter case,
+ *    it includes ANSI escape sequences that color the character in
+ *    terminals or consoles that support ANSI escape sequences.
+ *
+ *    This function is exposed as a convenience for callers.
+ *
+ * \return
+ *    Either a colored or uncolored "!" character as a null-terminated string.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_04()
+ *    -  No unit-test for this trivial function that exposes internal macros.
  *
  *//*-------------------------------------------------------------------------*/
 
-static cbool_t gs_Use_TimeStamps = false;
+const char *
+xpc_warnmark (void)
+{
+   return xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN ;
+}
 
 /******************************************************************************
- * gs_TimeStamps_Base
+ * xpc_errmark()
  *------------------------------------------------------------------------*//**
  *
- *    Given that time-stamps are being logged, a non-zero value for this
- *    items means that it is deducted from the current seconds value of the
- *    time-stamp.  This deduction is useful to make the time-stamps easier
- *    to read (shorter).
+ *    Provides the proper marker for the 'error' error-level.
+ *
+ *    The marker is either uncolored, or it is colored.  In the latter case,
+ *    it includes ANSI escape sequences that color the character in
+ *    terminals or consoles that support ANSI escape sequences.
+ *
+ *    This function is exposed as a convenience for callers.
+ *
+ * \return
+ *    Either a colored or uncolored "?" character as a null-terminated string.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_04()
+ *    -  No unit-test for this trivial function that exposes internal macros.
  *
  *//*-------------------------------------------------------------------------*/
 
-static time_t gs_TimeStamps_Base = 0;
+const char *
+xpc_errmark (void)
+{
+   return xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR ;
+}
 
 /******************************************************************************
- * xpc_timestamps_set()
+ * xpc_usermark()
  *------------------------------------------------------------------------*//**
  *
- *    Provides a setter for the internal gs_Use_TimeStamps flag.
+ *    Provides the proper marker for the 'user' error-level.
  *
- * \param flag
- *    The value to set the gs_Use_TimeStamps flag.
+ *    The marker is either uncolored, or it is colored.  In the latter case,
+ *    it includes ANSI escape sequences that color the character in
+ *    terminals or consoles that support ANSI escape sequences.
  *
- * \param setbase
- *    If true, the current time in seconds is logged, so that it can be
- *    deducted from subsequent time-stamp measurements.  Only used if \a
- *    flag is true.
+ *    This function is exposed as a convenience for callers.
  *
  * \return
- *    This function always returns 'true'.  A result is returned in order to
- *    maintain consistency with the other setter functions.
+ *    Either a colored or uncolored "-" character as a null-terminated string.
  *
  * \unittests
- *    -  errorlogging_test_02_05()
+ *    -  errorlogging_test_02_04()
+ *    -  No unit-test for this trivial function that exposes internal macros.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_timestamps_set (cbool_t flag, cbool_t setbase)
+const char *
+xpc_usermark (void)
 {
-   gs_Use_TimeStamps = flag;
-   if (flag && setbase)
-   {
-      struct timeval ts;
-      xpc_get_microseconds(&ts);
-      gs_TimeStamps_Base = ts.tv_sec;
-   }
-   return true;
+   return xpc_usecolor() ? COLOR_STR_USER : ERRL_STR_USER ;
 }
 
 /******************************************************************************
- * time_t xpc_timestamps()
+ * gs_Log_File
  *------------------------------------------------------------------------*//**
  *
- *    Provides a getter for the internal gs_Use_TimeStamps flag.
+ *    This static variable maintains the pointer to the current log file.
+ *
+ *    By default, this variable is set to stderr before its first usage.
+ *    This is done by the s_init_logfile() function, which is called by the
+ *    s_logfile_set(), xpc_logfile(), and xpc_buffering_set() functions.
  *
- * \return
- *    Returns the value of gs_Use_TimeStamps, which is either 'true' or
- *    'false'.  By default, at program start, this value is false.
+ *//*-------------------------------------------------------------------------*/
+
+static FILE * gs_Log_File = NULLptr;
+
+/******************************************************************************
+ * s_init_logfile() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    A private function to guarantee that the log-file pointer is
+ *    initialized properly before being used.
+ *
+ *    The default error-log destination is stderr.
  *
  * \unittests
- *    -  errorlogging_test_02_05()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_timestamps (void)
+static void
+s_init_logfile (void)
 {
-   return gs_Use_TimeStamps;
+   if (is_NULL(gs_Log_File))
+      gs_Log_File = stderr;
 }
 
 /******************************************************************************
- * xpc_errlevel_set()
+ * s_logfile_set()
  *------------------------------------------------------------------------*//**
  *
- *    Sets the current error-level for the application.
- *
- *    The error-level is selectable via the following command-line options.
- *
- *       -  --quiet or --silent (the latter matches a unit-test option)
- *       -  --errors [the default]
- *       -  --warnings
- *       -  --info
- *       -  --verbose
- *
- *    This function checks the parameter, and, if valid, it copies it into
- *    the global error-level variable.
+ *    This variable/function group supports the changing of the log file.
+ *    The default log file is stderr.  A different log-file can be opened,
+ *    which automatically closes the previous one (except for stderr and
+ *    stdout [stdin is also protected, what the heck.])
  *
- *    The values that are allowed are defined in the errorlogging.h header
+ *    When the log file is closed, it automatically reverts to the default,
+ *    stderr.  Right now, we don't deal with a failure to close the previous
  *    file.
  *
- *    If the code is configured with the --disable-errorlog option, then
- *    XPC_NO_ERRORLOG is true, and this function will merely show a warning
- *    and hardwire the error-level to XPC_ERROR_LEVEL_NONE.
+ *    Note that enabling a log file will turn off the usage of color (to
+ *    avoid ugly ESC-sequences in the file), but then the usage of color
+ *    cannot be turned back on. [Note:  now we turn it back on.  Too
+ *    confusing otherwise.]
  *
- * \param errlevel
- *    The desired error level for the whole application.
+ * \posix
+ *    According to a comment in stdio.h, C89/99 considers stderr etc to be
+ *    macros (GNU stdio say's their pointers to _IO_FILE structures), so we
+ *    cannot make an assignment here.
  *
- * \return
- *    'false' is returned for bad error-level values.  Otherwise, 'true' is
- *    returned.
+ * \param logfile
+ *    The handle to be used as the error-log file.
  *
- * \todo
- *    Change it to return the original error level, or, if the input is bad,
- *    do not change the level, but return a bad level code.
+ * \return
+ *    Returns 'true' if the \e logfile parameter is valid (that is, not
+ *    null).
  *
  * \unittests
- *    -  errorlogging_test_02_06()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_errlevel_set (int errlevel)
+static cbool_t
+s_logfile_set (FILE * logfile)
 {
+   cbool_t result = false;
+   s_init_logfile();
+   if (not_NULL(logfile))
+   {
+      if
+      (
+         errlog_flag(XPC_ERRLOG_USE_COLOR) &&
+         ((logfile != stdout) && (logfile != stderr))
+      )
+      {
+         (void) xpc_usecolor_set(false);     /* (no need to log this action)  */
+      }
 
-#ifdef XPC_NO_ERRORLOG
-
-   fprintf
-   (
-      xpc_logfile(), "%s %s",
-      xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN,
-      _("this application is configured to disable error-logging")
-   );
-   gs_Error_Level = XPC_ERROR_LEVEL_NONE;
-   return true;
-
-#else
-
-   cbool_t result = (errlevel < XPC_ERROR_LEVEL_NOT_APPLICABLE);
-   if (result)
-      result = (errlevel >= XPC_ERROR_LEVEL_NONE);
-
-   init_option_errlevel();                   /* must guarantee initialization */
-   if (result)
-      gs_Error_Level = errlevel;
-
+      gs_Log_File = logfile;
+      result = true;
+   }
    return result;
-
-#endif
-
 }
 
 /******************************************************************************
- * xpc_parse_leveltoken()
+ * Log rotation
  *------------------------------------------------------------------------*//**
  *
- *    Converts the string-name to an error-level and sets that error-level.
+ *    These static variables hold the log-rotation settings and the state
+ *    of the current log file.
+ *
+ *    -  gs_Rotate_Max_Bytes.  If not zero, the log file is rotated once
+ *       this many bytes have been written to it.
+ *    -  gs_Rotate_Max_Age.  If not zero, the log file is rotated once it
+ *       has been open for this many seconds.
+ *    -  gs_Rotate_Keep.  The number of old log files to keep, named
+ *       "name.1" (the newest) to "name.keep" (the oldest).
+ *    -  gs_Log_Name.  The name of the log file, if it was opened by
+ *       xpc_open_logfile() or xpc_append_logfile().  Only a named log file
+ *       can be rotated.
+ *    -  gs_Log_Bytes.  The number of bytes in the log file.
+ *    -  gs_Log_Opened.  The time at which the log file was opened.
+ *    -  gs_Log_Rotating.  Set while one thread rotates the log file, so that
+ *       the other threads do not also try to rotate it.
+ *
+ *    See xpc_logrotation_set() for the rest of the story.
  *
- *    This function converts a string value ("error", "warnings", etc.) into
- *    the proper error-level, and then sets the error-level appropriately.
+ *//*-------------------------------------------------------------------------*/
+
+static size_t gs_Rotate_Max_Bytes = 0;
+static long gs_Rotate_Max_Age = 0;
+static int gs_Rotate_Keep = XPC_LOG_KEEP_DEFAULT;
+static char * gs_Log_Name = NULLptr;
+static size_t gs_Log_Bytes = 0;
+static time_t gs_Log_Opened = 0;
+static cbool_t gs_Log_Rotating = false;
+
+/******************************************************************************
+ * log_opened() [static]
+ *------------------------------------------------------------------------*//**
  *
- * \param errlevelstring
- *    Provides the error-level string -- "error", "info", etc. -- to check
- *    for.
+ *    Records the name and the current size of a newly-opened log file,
+ *    and the time it was opened.  If rotation by size is enabled, disk
+ *    space for the whole file is reserved.
  *
- * \return
- *    It returns 'true' if the setting was valid.  A null error-level string
- *    is not valid.
+ * \param logfile
+ *    The newly-opened log file.  If null, the name is forgotten, and the
+ *    log will not be rotated.
+ *
+ * \param logfilename
+ *    The name of the log file.
  *
  * \unittests
- *    -  errorlogging_test_02_07()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_parse_leveltoken (const char * errlevelstring)
+static void
+log_opened (FILE * logfile, const char * logfilename)
 {
-   cbool_t result = false;
-   if (not_nullptr(errlevelstring))
+   if (not_NULL(gs_Log_Name))
    {
-      xpc_errlevel_t level;
-      char temp[64];
-      if (errlevelstring[0] != '-')
-      {
-         strcpy(temp, "--");
-         strncat(temp, errlevelstring, 64-strlen("--"));
-      }
-      else
-         strncpy(temp, errlevelstring, 64);
+      free(gs_Log_Name);
+      gs_Log_Name = NULLptr;
+   }
+   xpc_atomic_store_relaxed(&gs_Log_Bytes, 0);
+   gs_Log_Opened = time(NULL);
+   if (not_NULL(logfile))
+   {
+      size_t length = strlen(logfilename) + 1;
+      gs_Log_Name = malloc(length);
+      if (not_NULL(gs_Log_Name))
+         memcpy(gs_Log_Name, logfilename, length);
 
-      temp[63] = 0;
-      level = xpc_option_errlevel(temp);
-      if (level != XPC_ERROR_LEVEL_NOT_APPLICABLE)
+      if (fseek(logfile, 0, SEEK_END) == 0)
       {
-         result = xpc_errlevel_set(level);
-         if (! result)
-            xpc_errprintex("xpc_errlevel_set()", _("failed"));
+         long size = ftell(logfile);
+         if (size > 0)
+            xpc_atomic_store_relaxed(&gs_Log_Bytes, (size_t) size);
       }
-      else
-         xpc_errprintex(temp, _("failed"));
+      if (gs_Rotate_Max_Bytes > 0)
+         (void) xpc_file_preallocate(logfile, gs_Rotate_Max_Bytes);
    }
-   return result;
 }
 
 /******************************************************************************
- * xpc_filename_check()
+ * log_rotate() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Checks the viability of a file-name.
+ *    Rotates the log file.
  *
- *    A file-name is invalid if the pointer is null, the file-name is
- *    zero-length, is "." or ".." or other bogus combinations.  We also
- *    disallow filenames beginning with a hyphen.
+ *    The backups are renamed and the log file becomes "name.1" (see
+ *    xpc_file_rotate()) while it is still open, and a new file of the
+ *    same name is opened.  Only then is the --synch lock taken, just long
+ *    enough to swap the file handles.  The old file is closed after the
+ *    lock is released.  So, the other threads never wait on the renaming
+ *    or the opening of files.
  *
- *    Note that, at this time, permissions are not part of the check.
+ *    The disk space reserved by xpc_file_preallocate() beyond the end of
+ *    the old file is released, by truncating the file to its written
+ *    length, so that the backups take only the space of their lines.
  *
- * \param filename
- *    The filename pointer to be checked.
+ *    The rotation is done by the thread that calls this function.  Without
+ *    --async-log, that is the thread that logged the line that made the
+ *    file due; see log_written().
+ *
+ *    If the rotation fails, the counters are reset anyway, so that it is
+ *    not retried on every line.
  *
  * \return
- *    Returns 'true' if the filename is valid.  Otherwise, 'false' is
- *    returned.
+ *    Returns 'true' if the log file was rotated.  Returns 'false' if there
+ *    is no named log file, another thread is rotating it, or the rotation
+ *    failed.
  *
  * \unittests
- *    -  errorlogging_test_02_09().  Tested implicitly.
- *    -  unit_test_s_filename_check().  This static function should be a
- *       one-to-one match for xpc_filename_check(), and should be updated in
- *       synchrony with it..
+ *    No direct unit-test possible in a static C function; see
+ *    errorlogging_test_02_24().
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_filename_check (const char * filename)
+static cbool_t
+log_rotate (void)
 {
    cbool_t result = false;
-   if (not_nullptr(filename))
+   if (not_NULL(gs_Log_Name) && ! xpc_atomic_exchange(&gs_Log_Rotating, true))
    {
-      if (strlen(filename) > 0)
+      FILE * oldfile = xpc_logfile();
+      FILE * newfile = NULLptr;
+      fflush(oldfile);
+#if XPC_HAVE_FALLOCATE && XPC_HAVE_UNISTD_H
+      if (gs_Rotate_Max_Bytes > 0)              /* give back the reserve   */
       {
-         result = !
-         (
-            (strcmp(filename, ".") == 0)     ||
-            (strcmp(filename, "..") == 0)    ||
-            (strcmp(filename, "./") == 0)    ||
-            (strcmp(filename, "../") == 0)   ||
-            (strcmp(filename, ".\\") == 0)   ||
-            (strcmp(filename, "..\\") == 0)  ||
-            (strncmp(filename, "-", 1) == 0)
-         );
+         long length = ftell(oldfile);
+         if (length >= 0)
+            (void) ftruncate(fileno(oldfile), (off_t) length);
       }
+#endif
+      if (xpc_file_rotate(gs_Log_Name, gs_Rotate_Keep))
+         newfile = fopen(gs_Log_Name, "a");
 
-      /*
-       * No need to report any bad file-name in error-logging, because the
-       * problem may simply be that there is no file-name, just the next
-       * option.
-       *
-       *    if (! result)
-       *       xpc_errprint_func(_("the filename is not acceptable"));
-       */
+      if (not_NULL(newfile))
+      {
+         if (gs_Rotate_Max_Bytes > 0)
+            (void) xpc_file_preallocate(newfile, gs_Rotate_Max_Bytes);
+
+         result = synch_lock();
+         if (result)
+         {
+            gs_Log_File = newfile;
+            synch_unlock();
+            fclose(oldfile);
+         }
+         else
+            fclose(newfile);
+      }
+      xpc_atomic_store_relaxed(&gs_Log_Bytes, 0);
+      gs_Log_Opened = time(NULL);
+      xpc_atomic_store(&gs_Log_Rotating, false);
    }
    return result;
 }
 
 /******************************************************************************
- * xpc_parse_errlevel_nohelp()
+ * log_written() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Parses a command-line argument array for error-level arguments, but
- *    ignores "--help".
+ *    Counts the bytes written to the log file, and rotates the file if it
+ *    has become too big or too old.
  *
- *    This function is the same as xpc_parse_errlevel(), but it ignores
- *    "--help".  It should be used in lieu of xpc_parse_errlevel() by
- *    callers that want to create their own help.
+ *    This function is called after the line has been written, and after
+ *    the --synch lock has been released.  If rotation is not enabled, it
+ *    does nothing.
  *
- *    Note that this version does check for the --help switching, returning
- *    false if it is encountered.  This function also returns false upon an
- *    error.  But, otherwise, it has to scan every argument, in case
- *    multiple error-logging options were specified.
+ *    If --async-log is in force, only the writer thread rotates the file.
+ *    The other threads only count the bytes they write directly (lines too
+ *    long to queue, or xpc_lkprintf() output).
  *
- *    This function is called by xpc_parse_errlevel() to promote code reuse.
+ *    Otherwise, the rotation is done inline, by the thread that logged the
+ *    line, which thus pays for the renames, the opening and preallocation
+ *    of the new file, and the closing of the old one.  It cannot be handed
+ *    to a helper thread:  without --async-log, the lines are written
+ *    straight to the log file, without --synch nothing stops a thread from
+ *    writing to the old file while another thread closes it, and the only
+ *    thread known not to be writing to it is the one doing the rotation.
  *
- * \param argc
- *    The main()-style number of command-line arguments.
+ * \param count
+ *    The number of bytes just written.
  *
- * \param argv
- *    The main()-style array of command-line arguments.
+ * \unittests
+ *    No direct unit-test possible in a static C function.
  *
- * \return
- *    Returns 'true' if the argument array was valid, and the function
- *    succeeded in finding a proper error-logging command-line option.
- *    'false' is returned if the parameters were incorrect, or if the
- *    "--help" or "--version" tokens were encountered, if argc is bogus (0),
- *    or if some other error occurred.
+ *//*-------------------------------------------------------------------------*/
+
+static void
+log_written (size_t count)
+{
+   size_t maxbytes = xpc_atomic_load_relaxed(&gs_Rotate_Max_Bytes);
+   long maxage = xpc_atomic_load_relaxed(&gs_Rotate_Max_Age);
+   if ((maxbytes > 0) || (maxage > 0))
+   {
+      size_t total = xpc_atomic_add_relaxed(&gs_Log_Bytes, count) + count;
+      if (! async_logging_active())
+      {
+         cbool_t due = (maxbytes > 0) && (total >= maxbytes);
+         if (! due && (maxage > 0))
+            due = (time(NULL) - gs_Log_Opened) >= maxage;
+
+         if (due)
+            (void) log_rotate();
+      }
+   }
+}
+
+/******************************************************************************
+ * xpc_logrotation_set()
+ *------------------------------------------------------------------------*//**
  *
- *    Please note that an option (e.g. "--my-app-option") that is unknown to
- *    the error-logging is simply ignored, and 'true' is returned, so that
- *    the rest of the application processing can proceed.
+ *    Sets up the rotation of the log file.
+ *
+ *    The log file, if opened by xpc_open_logfile() or xpc_append_logfile()
+ *    (or the --log and --append options), is rotated when it reaches a
+ *    given size, or a given age, or both.  The current file is renamed to
+ *    "name.1", older files are renamed to "name.2", "name.3", and so on,
+ *    and the oldest is deleted.  Then a new file is opened.  There is no
+ *    need for an external logrotate program, and no lines are lost.
+ *
+ *    If rotation by size is enabled, disk space for the whole log file is
+ *    reserved when it is opened, so that writing to the file does not
+ *    allocate disk blocks.
+ *
+ *    These settings are also available as the --log-max-bytes,
+ *    --log-max-age, and --log-keep options.
+ *
+ * \warning
+ *    A multi-threaded application must also use --synch, so that no thread
+ *    is writing to the old file when it is closed.  Without --async-log,
+ *    the rotation is done inline by the thread whose line makes the file
+ *    due, which therefore stalls for the renames and the opening of the new
+ *    file.  With --async-log, the rotation is done by the background writer
+ *    thread, and so the logging threads never wait for it.
+ *
+ * \param maxbytes
+ *    The size, in bytes, at which to rotate the log.  Zero disables the
+ *    size check.
+ *
+ * \param maxage
+ *    The age, in seconds, at which to rotate the log.  Zero disables the
+ *    age check.
+ *
+ * \param keep
+ *    The number of old log files to keep.  If zero, the log file is simply
+ *    started over when it is rotated.
+ *
+ * \return
+ *    Returns 'true' if the parameters were valid.  Otherwise, the settings
+ *    are not changed, and 'false' is returned.
  *
  * \unittests
- *    errorlogging_test_02_09().  This test does not attempt to handle all
- *    of the command-line options, due to the large-number of side-effects
- *    that would have to be guarded against during the test.  Nonetheless, a
- *    lot of other internal properties do get tested.
+ *    -  errorlogging_test_02_24()
  *
- *    For tests of the functions called inside this function, see the
- *    unit-tests for:
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_logrotation_set (size_t maxbytes, long maxage, int keep)
+{
+   cbool_t result = (maxage >= 0) && (keep >= 0) && (keep <= XPC_LOG_KEEP_MAX);
+   if (result)
+   {
+      xpc_atomic_store_relaxed(&gs_Rotate_Max_Age, maxage);
+      xpc_atomic_store_relaxed(&gs_Rotate_Keep, keep);
+      xpc_atomic_store_relaxed(&gs_Rotate_Max_Bytes, maxbytes);
+      if (not_NULL(gs_Log_Name) && (maxbytes > 0))
+         (void) xpc_file_preallocate(xpc_logfile(), maxbytes);
+   }
+   else
+      xpc_errprint_func(_("invalid log-rotation setting"));
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_logrotate()
+ *------------------------------------------------------------------------*//**
  *
- *       -  xpc_errlevel_set()
- *       -  xpc_open_logfile()
- *       -  xpc_syslogging_set()
- *       -  xpc_usecolor_set()
- *       -  xpc_timestamps_set()
- *       -  xpc_buffering_set()
- *       -  xpc_synchusage_set()
- *       -  xpc_showerr_version()
+ *    Rotates the log file right now, whatever its size or age.
+ *
+ *    This function can be called, for example, in response to a SIGHUP.
+ *    It uses the "keep" setting made by xpc_logrotation_set().
+ *
+ * \return
+ *    Returns 'true' if the log file was rotated.  Returns 'false' if the
+ *    log is not a named file, or the rotation failed.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_24()
  *
  *//*-------------------------------------------------------------------------*/
 
 cbool_t
-xpc_parse_errlevel_nohelp (int argc, char * argv [])
+xpc_logrotate (void)
+{
+   async_drain();                            /* queued lines go to old file   */
+   return log_rotate();
+}
+
+/******************************************************************************
+ * log_rotation_option() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Handles the --log-max-bytes, --log-max-age, and --log-keep options.
+ *    The settings not named by the option are left as they are.
+ *
+ * \param option
+ *    The option, including the "--".
+ *
+ * \param value
+ *    The option's value, which must be a non-negative integer.
+ *
+ * \return
+ *    Returns 'true' if the value was valid.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+log_rotation_option (const char * option, const char * value)
+{
+   char * endptr;
+   long number = strtol(value, &endptr, 10);
+   cbool_t result = (endptr != value) && (*endptr == 0) && (number >= 0);
+   if (result)
+   {
+      size_t maxbytes = gs_Rotate_Max_Bytes;
+      long maxage = gs_Rotate_Max_Age;
+      int keep = gs_Rotate_Keep;
+      if (strcmp(option, CMD(_LOG_MAX_BYTES)) == 0)
+         maxbytes = (size_t) number;
+      else if (strcmp(option, CMD(_LOG_MAX_AGE)) == 0)
+         maxage = number;
+      else
+         keep = (number > XPC_LOG_KEEP_MAX) ? (-1) : (int) number;
+
+      result = xpc_logrotation_set(maxbytes, maxage, keep);
+   }
+   else
+      xpc_errprintf("%s: %s '%s'", option, _("invalid number"), value);
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_open_logfile_helper()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Opens a file for usage as the error-log, for either truncating it or
+ *    appending to it.
+ *
+ *    This function is a private (C static) helper function for
+ *    xpc_open_logfile() and xpc_append_logfile().
+ *
+ * \param logfilename
+ *    Full path name to log file to be opened.
+ *
+ *    The name of the file is saved, so that the file can be rotated (see
+ *    xpc_logrotation_set()).  If rotation by size is enabled, disk space
+ *    for the whole file is reserved up front.
+ *
+ * \param truncateit
+ *    If true, truncate it, else append to it.
+ *
+ * \return
+ *    If the parameters were appropriate, and the file was able to be opened
+ *    for appending, 'true' is returned.  Otherwise, 'false' is returned.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function; see
+ *    xpc_open_logfile().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+xpc_open_logfile_helper (const char * logfilename, cbool_t truncateit)
 {
    cbool_t result = false;
-   if (not_nullptr(argv))
+   if (not_nullptr(logfilename) && (strlen(logfilename) > 0))
    {
-      if (argc > 1)
+      FILE * lf;
+      (void) xpc_close_logfile();
+      lf = fopen(logfilename, truncateit ? "w+" : "a");
+      if (not_NULL(lf))
       {
-         int argi = 0;
-         while (++argi < argc)
+         log_opened(lf, logfilename);
+         if (truncateit)
+            xpc_infoprint(_("log-file truncated"));
+
+         result = s_logfile_set(lf);
+      }
+      else
+      {
+         xpc_strerrnoprint_func(_("failed"));
+         (void) s_logfile_set(stderr);
+      }
+   }
+   else
+      xpc_errprint_func(_("invalid filename"));
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_open_logfile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Opens a file for usage as the error-log destination, truncating it if
+ *    it exists.
+ *
+ *    The default destination is stderr.  But, if the user specifies the
+ *    "--log filename" option on the command line, then the specified file
+ *    is used for logging the error and information strings.
+ *
+ *    If the file-name is 'stderr' or 'stdout', then that device is simply
+ *    set as the current log-file.
+ *
+ * \param logfilename
+ *    Full path name to log file to be opened.
+ *
+ * \return
+ *    If the parameters were appropriate, and the file was able to be opened
+ *    for appending, 'true' is returned.  Otherwise, 'false' is returned.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_open_logfile (const char * logfilename)
+{
+   cbool_t result = true;
+   FILE * stdio_file = NULLptr;
+   cbool_t match = (strcmp(logfilename, "stderr")) == 0 ||
+      (strcmp(logfilename, "STDERR") == 0);
+
+   if (match)
+      stdio_file = stderr;
+   else
+   {
+      match = (strcmp(logfilename, "stdout")) == 0 ||
+         (strcmp(logfilename, "STDOUT") == 0);
+
+      if (match)
+         stdio_file = stdout;
+      else
+      {
+         match = (strcmp(logfilename, "stdin")) == 0 ||
+            (strcmp(logfilename, "STDIN") == 0);
+
+         if (match)
          {
-            xpc_errlevel_t level = xpc_option_errlevel(argv[argi]);
-            if (level != XPC_ERROR_LEVEL_NOT_APPLICABLE)
-            {
-               result = xpc_errlevel_set(level);
-            }
-            else if (strcmp(argv[argi], CMD(_STDOUT)) == 0)
+            result = false;
+            if (! xpc_shownothing())
             {
-               result = s_logfile_set(stdout);
+               fprintf
+               (
+                  stderr, "??? %s!!!\n", _("Cannot use stdin as a log file")
+               );
             }
-            else if (strcmp(argv[argi], CMD(_STDERR)) == 0)
-            {
+         }
+      }
+   }
+   if (result)
+   {
+      if (not_NULL(stdio_file))
+      {
+         (void) xpc_close_logfile();           /* todo:  use return? */
+         result = s_logfile_set(stdio_file);
+      }
+      else
+         result =  xpc_open_logfile_helper(logfilename, true);   /* truncate */
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_append_logfile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Opens a file for usage as the error-log destination, for appending.
+ *
+ *    The default destination is stderr.  But, if the user specifies the
+ *    "--log filename" option on the command line, then the specified file
+ *    is used for logging the error and information strings.
+ *
+ * \param logfilename
+ *    Full path name to log file to be opened.
+ *
+ * \return
+ *    If the parameters were appropriate, and the file was able to be opened
+ *    for appending, 'true' is returned.  Otherwise, 'false' is returned.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_append_logfile (const char * logfilename)
+{
+   return xpc_open_logfile_helper(logfilename, false); /* append to log file */
+}
+
+/******************************************************************************
+ * xpc_close_logfile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Closes the current log file for the error-log.
+ *
+ *    If the log file is not one of the standard ones (<i>stderr</i>,
+ *    <i>stdout</i>, or <i>stdin</i>), it is closed.
+ *
+ * \sideeffect
+ *    Whether or not the closing succeeds, the log-file is returned to the
+ *    handle it had at the start of the application -- \e stderr.
+ *
+ * \sideeffect
+ *    If asynchronous logging is on, the lines already queued are written
+ *    to the file before it is closed.
+ *
+ * \return
+ *    If the file was not one of the standard ones, and it was successfully
+ *    closed, 'true' is returned.  Otherwise, 'false' is returned.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_close_logfile (void)
+{
+   cbool_t result = false;
+   FILE * lf;
+   async_drain();                            /* queued lines go to old file   */
+   lf = xpc_logfile();
+   cbool_t ok = (lf != stderr) && (lf != stdout) && (lf != stdin);
+   if (ok && not_NULL(lf))
+   {
+      int rcode = fclose(lf);
+      result = (rcode == 0);
+      (void) xpc_usecolor_set(true);      /* do not use the return value here */
+   }
+   (void) s_logfile_set(stderr);
+   log_opened(nullptr, nullptr);             /* nothing left to rotate        */
+   return result;
+}
+
+/******************************************************************************
+ * xpc_logfile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the handle to the error-log file.
+ *
+ *    This function can be used in fprintf() and similar calls to direct
+ *    output to the current log file (\e stderr by default).
+ *
+ *    This function always calls the private helper function s_init_logfile()
+ *    in order to guarantee that the handle is properly initialized.  The
+ *    s_init_logfile() function has a boolean the makes it do the setup just
+ *    once during the lifetime of an application.  Otherwise, there is no
+ *    way to guarantee that the handle is initialized by the time the caller
+ *    uses the log-file handle.
+ *
+ * \return
+ *    The private handle to the log file, gs_Log_File, is returned.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+FILE *
+xpc_logfile (void)
+{
+   s_init_logfile();                         /* *guarantee* it is not null    */
+   return gs_Log_File;
+}
+
+/******************************************************************************
+ * gs_TimeStamps_Base
+ *------------------------------------------------------------------------*//**
+ *
+ *    Given that time-stamps are being logged, a non-zero value for this
+ *    items means that it is deducted from the current seconds value of the
+ *    time-stamp.  This deduction is useful to make the time-stamps easier
+ *    to read (shorter).
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static time_t gs_TimeStamps_Base = 0;
+
+/******************************************************************************
+ * xpc_timestamps_set()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a setter for the internal time-stamp flag, the
+ *    XPC_ERRLOG_TIMESTAMPS bit of xpc_errlog_state.  The time-stamps are
+ *    microsecond-level, and are included in the errorlogging output.
+ *
+ * \param flag
+ *    The value to set the time-stamp flag.
+ *
+ * \param setbase
+ *    If true, the current time in seconds is logged, so that it can be
+ *    deducted from subsequent time-stamp measurements.  Only used if \a
+ *    flag is true.
+ *
+ * \return
+ *    This function always returns 'true'.  A result is returned in order to
+ *    maintain consistency with the other setter functions.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_05()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_timestamps_set (cbool_t flag, cbool_t setbase)
+{
+   errlog_flag_set(XPC_ERRLOG_TIMESTAMPS, flag);
+   if (flag && setbase)
+   {
+      struct timeval ts;
+      xpc_get_microseconds(&ts);
+      gs_TimeStamps_Base = ts.tv_sec;
+   }
+   return true;
+}
+
+/******************************************************************************
+ * time_t xpc_timestamps()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a getter for the internal time-stamp flag.
+ *
+ * \return
+ *    Returns the value of the time-stamp flag, which is either 'true' or
+ *    'false'.  By default, at program start, this value is false.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_05()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_timestamps (void)
+{
+   return errlog_flag(XPC_ERRLOG_TIMESTAMPS);
+}
+
+/******************************************************************************
+ * Time-stamp clocks [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    These items provide the time of a log line, in nanoseconds since the
+ *    epoch, from the clock selected by xpc_timestamp_clock_set().
+ *
+ *    -  XPC_TIMESTAMP_CLOCK_WALL reads the real-time clock for each line.
+ *       It is exact, but it is the most expensive, and it jumps when the
+ *       system time is set.
+ *    -  XPC_TIMESTAMP_CLOCK_COARSE reads CLOCK_MONOTONIC_COARSE, which the
+ *       kernel updates once per tick (1 to 10 ms), and which costs little
+ *       more than a memory read.
+ *    -  XPC_TIMESTAMP_CLOCK_TSC reads the time-stamp counter of the
+ *       processor, and scales it by a factor calibrated against
+ *       CLOCK_MONOTONIC when the clock is selected.  Each thread keeps its
+ *       own anchor (a counter reading and the matching clock reading),
+ *       renewed about once a second, so that errors in the factor cannot
+ *       accumulate, and no shared data is written.
+ *
+ *    The monotonic clocks are converted to wall time by adding the offset
+ *    between CLOCK_REALTIME and CLOCK_MONOTONIC, measured when the clock
+ *    was selected.  Thus they do not follow later changes to the system
+ *    time.
+ *
+ * \gnu
+ *    The TSC clock requires an x86 processor with an invariant TSC.
+ *
+ * \win32
+ *    Only the wall clock is supported.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#if defined POSIX && XPC_HAVE_CLOCK_GETTIME
+#define XPC_TIMESTAMP_MONOTONIC
+#ifdef CLOCK_MONOTONIC_COARSE
+#define XPC_TIMESTAMP_COARSE_ID  CLOCK_MONOTONIC_COARSE
+#else
+#define XPC_TIMESTAMP_COARSE_ID  CLOCK_MONOTONIC
+#endif
+#if defined __GNUC__ && (defined __i386__ || defined __x86_64__)
+#define XPC_TIMESTAMP_TSC
+#endif
+#endif
+
+#define XPC_NS_PER_SECOND        1000000000LL
+
+typedef struct
+{
+   uint64_t m_Ticks;                   /**< The counter at the anchor.        */
+   uint64_t m_Nanoseconds;             /**< CLOCK_MONOTONIC at the anchor.    */
+   unsigned m_Generation;              /**< The calibration it belongs to.    */
+
+} xpc_tsc_anchor_t;
+
+static int gs_Timestamp_Clock = XPC_TIMESTAMP_CLOCK_WALL;
+static int64_t gs_Timestamp_Offset = 0;
+static uint64_t gs_Tsc_Scale = 0;
+static uint64_t gs_Tsc_Resync = 0;
+static unsigned gs_Tsc_Generation = 0;
+static xpc_thread_local xpc_tsc_anchor_t gs_Tsc_Anchor;
+
+/******************************************************************************
+ * wall_nanoseconds() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads the real-time clock.
+ *
+ * \return
+ *    Returns the nanoseconds since the epoch.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static uint64_t
+wall_nanoseconds (void)
+{
+#ifdef XPC_TIMESTAMP_MONOTONIC
+   struct timespec ts;
+   (void) clock_gettime(CLOCK_REALTIME, &ts);
+   return (uint64_t) ts.tv_sec * XPC_NS_PER_SECOND + (uint64_t) ts.tv_nsec;
+#else
+   struct timeval ts;
+   (void) xpc_get_microseconds(&ts);
+   return (uint64_t) ts.tv_sec * XPC_NS_PER_SECOND +
+      (uint64_t) ts.tv_usec * 1000;
+#endif
+}
+
+#ifdef XPC_TIMESTAMP_MONOTONIC
+
+/******************************************************************************
+ * monotonic_nanoseconds() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads a monotonic clock.
+ *
+ * \param id
+ *    CLOCK_MONOTONIC or XPC_TIMESTAMP_COARSE_ID.
+ *
+ * \return
+ *    Returns the nanoseconds since an arbitrary starting point.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static uint64_t
+monotonic_nanoseconds (clockid_t id)
+{
+   struct timespec ts;
+   (void) clock_gettime(id, &ts);
+   return (uint64_t) ts.tv_sec * XPC_NS_PER_SECOND + (uint64_t) ts.tv_nsec;
+}
+
+#endif   /* XPC_TIMESTAMP_MONOTONIC */
+
+#ifdef XPC_TIMESTAMP_TSC
+
+/******************************************************************************
+ * tsc_calibrate() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Checks that the time-stamp counter is invariant (it runs at a fixed
+ *    rate whatever the power state of the processor), and measures its
+ *    rate against CLOCK_MONOTONIC over 10 ms.
+ *
+ *    The scale is the number of nanoseconds per tick, as a 32.32 fixed
+ *    point number, so that scaling a reading is a multiply and a shift.
+ *
+ *    The scale and the resynchronization interval are stored before the
+ *    generation is incremented, which releases them to the threads that
+ *    load the new generation.
+ *
+ * \return
+ *    Returns 'true' if the counter can be used.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+tsc_calibrate (void)
+{
+   unsigned a, b, c, d;
+   cbool_t result = __get_cpuid(0x80000000, &a, &b, &c, &d) &&
+      (a >= 0x80000007);
+
+   if (result)
+   {
+      result = __get_cpuid(0x80000007, &a, &b, &c, &d) &&
+         ((d & (1u << 8)) != 0);                /* invariant TSC           */
+   }
+   if (result)
+   {
+      uint64_t ns0 = monotonic_nanoseconds(CLOCK_MONOTONIC);
+      uint64_t ticks0 = __rdtsc();
+      uint64_t ns1, ticks1;
+      xpc_ms_sleep(10);
+      ns1 = monotonic_nanoseconds(CLOCK_MONOTONIC);
+      ticks1 = __rdtsc();
+      result = ticks1 > ticks0;
+      if (result)
+      {
+         uint64_t scale = ((ns1 - ns0) << 32) / (ticks1 - ticks0);
+         uint64_t resync = (ticks1 - ticks0) * XPC_NS_PER_SECOND / (ns1 - ns0);
+         xpc_atomic_store_relaxed(&gs_Tsc_Scale, scale);
+         xpc_atomic_store_relaxed(&gs_Tsc_Resync, resync);
+         (void) xpc_atomic_add(&gs_Tsc_Generation, 1);   /* publishes them */
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * tsc_nanoseconds() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts the time-stamp counter to CLOCK_MONOTONIC nanoseconds, using
+ *    the calling thread's anchor.  The anchor is renewed if it is from an
+ *    earlier calibration, or more than about a second old.
+ *
+ *    The generation is loaded first, with acquire ordering, so that the
+ *    scale read after it is at least as new as the calibration that the
+ *    generation names.
+ *
+ * \return
+ *    Returns the nanoseconds since the starting point of CLOCK_MONOTONIC.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static uint64_t
+tsc_nanoseconds (void)
+{
+   xpc_tsc_anchor_t * anchor = &gs_Tsc_Anchor;
+   unsigned generation = xpc_atomic_load(&gs_Tsc_Generation);
+   uint64_t scale = xpc_atomic_load_relaxed(&gs_Tsc_Scale);
+   uint64_t resync = xpc_atomic_load_relaxed(&gs_Tsc_Resync);
+   uint64_t elapsed = __rdtsc() - anchor->m_Ticks;
+   if (anchor->m_Generation != generation || elapsed > resync)
+   {
+      anchor->m_Nanoseconds = monotonic_nanoseconds(CLOCK_MONOTONIC);
+      anchor->m_Ticks = __rdtsc();
+      anchor->m_Generation = generation;
+      elapsed = 0;
+   }
+   return anchor->m_Nanoseconds + ((elapsed * scale) >> 32);
+}
+
+#endif   /* XPC_TIMESTAMP_TSC */
+
+/******************************************************************************
+ * timestamp_now() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads the selected time-stamp clock.
+ *
+ *    The clock is loaded with acquire ordering, and the offset after it,
+ *    so that the offset is the one published with the clock by
+ *    xpc_timestamp_clock_set().
+ *
+ * \return
+ *    Returns the nanoseconds since the epoch.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static uint64_t
+timestamp_now (void)
+{
+   uint64_t result;
+   switch (xpc_atomic_load(&gs_Timestamp_Clock))
+   {
+#ifdef XPC_TIMESTAMP_MONOTONIC
+   case XPC_TIMESTAMP_CLOCK_COARSE:
+      result = monotonic_nanoseconds(XPC_TIMESTAMP_COARSE_ID) +
+         xpc_atomic_load_relaxed(&gs_Timestamp_Offset);
+      break;
+#endif
+
+#ifdef XPC_TIMESTAMP_TSC
+   case XPC_TIMESTAMP_CLOCK_TSC:
+      result = tsc_nanoseconds() +
+         xpc_atomic_load_relaxed(&gs_Timestamp_Offset);
+      break;
+#endif
+
+   default:
+      result = wall_nanoseconds();
+      break;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_timestamp_clock_set()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Selects the clock read for the time-stamps of the log lines.  See the
+ *    "Time-stamp clocks" section of this module.
+ *
+ *    This function is activated by the "--timestamp-clock name" option,
+ *    where the name is "wall", "coarse", or "tsc".  Selecting the TSC
+ *    clock takes about 10 ms, for the calibration.
+ *
+ * \warning
+ *    Select the clock before other threads start logging.  The offset and
+ *    calibration are published along with the clock, so a change made
+ *    while other threads log is safe, but the lines logged during the
+ *    change may be stamped by either clock.
+ *
+ * \param clock
+ *    The clock to use.
+ *
+ * \return
+ *    Returns 'true' if the clock is supported on this system.  Otherwise,
+ *    the clock is not changed.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_27()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_timestamp_clock_set (xpc_timestamp_clock_t clock)
+{
+   cbool_t result;
+   switch (clock)
+   {
+   case XPC_TIMESTAMP_CLOCK_WALL:
+      result = true;
+      break;
+
+#ifdef XPC_TIMESTAMP_MONOTONIC
+   case XPC_TIMESTAMP_CLOCK_COARSE:
+      result = true;
+      break;
+#endif
+
+#ifdef XPC_TIMESTAMP_TSC
+   case XPC_TIMESTAMP_CLOCK_TSC:
+      result = tsc_calibrate();
+      break;
+#endif
+
+   default:
+      result = false;
+      break;
+   }
+   if (result)
+   {
+#ifdef XPC_TIMESTAMP_MONOTONIC
+      int64_t offset = (int64_t) wall_nanoseconds() -
+         (int64_t) monotonic_nanoseconds(CLOCK_MONOTONIC);
+
+      xpc_atomic_store_relaxed(&gs_Timestamp_Offset, offset);
+#endif
+      xpc_atomic_store(&gs_Timestamp_Clock, (int) clock);   /* publishes */
+   }
+   else
+      xpc_errprint_func(_("time-stamp clock not supported"));
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_timestamp_clock()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a getter for the clock selected by xpc_timestamp_clock_set().
+ *
+ * \return
+ *    Returns the clock.  The default is XPC_TIMESTAMP_CLOCK_WALL.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_27()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+xpc_timestamp_clock_t
+xpc_timestamp_clock (void)
+{
+   return (xpc_timestamp_clock_t) xpc_atomic_load(&gs_Timestamp_Clock);
+}
+
+/******************************************************************************
+ * xpc_errlevel_set()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets the current error-level for the application.
+ *
+ *    The error-level is selectable via the following command-line options.
+ *
+ *       -  --quiet or --silent (the latter matches a unit-test option)
+ *       -  --errors [the default]
+ *       -  --warnings
+ *       -  --info
+ *       -  --verbose
+ *
+ *    This function checks the parameter, and, if valid, it copies it into
+ *    the global error-level variable.
+ *
+ *    The values that are allowed are defined in the errorlogging.h header
+ *    file.
+ *
+ *    If the code is configured with the --disable-errorlog option, then
+ *    XPC_NO_ERRORLOG is true, and this function will merely show a warning
+ *    and hardwire the error-level to XPC_ERROR_LEVEL_NONE.
+ *
+ * \param errlevel
+ *    The desired error level for the whole application.
+ *
+ * \return
+ *    'false' is returned for bad error-level values.  Otherwise, 'true' is
+ *    returned.
+ *
+ * \todo
+ *    Change it to return the original error level, or, if the input is bad,
+ *    do not change the level, but return a bad level code.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_06()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_errlevel_set (int errlevel)
+{
+
+#ifdef XPC_NO_ERRORLOG
+
+   fprintf
+   (
+      xpc_logfile(), "%s %s",
+      xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN,
+      _("this application is configured to disable error-logging")
+   );
+   errlog_level_store(XPC_ERROR_LEVEL_NONE);
+   return true;
+
+#else
+
+   cbool_t result = (errlevel < XPC_ERROR_LEVEL_NOT_APPLICABLE);
+   if (result)
+      result = (errlevel >= XPC_ERROR_LEVEL_NONE);
+
+   if (result)
+      errlog_level_store(errlevel);
+
+   return result;
+
+#endif
+
+}
+
+/******************************************************************************
+ * xpc_parse_leveltoken()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts the string-name to an error-level and sets that error-level.
+ *
+ *    This function converts a string value ("error", "warnings", etc.) into
+ *    the proper error-level, and then sets the error-level appropriately.
+ *
+ * \param errlevelstring
+ *    Provides the error-level string -- "error", "info", etc. -- to check
+ *    for.
+ *
+ * \return
+ *    It returns 'true' if the setting was valid.  A null error-level string
+ *    is not valid.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_07()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_parse_leveltoken (const char * errlevelstring)
+{
+   cbool_t result = false;
+   if (not_nullptr(errlevelstring))
+   {
+      xpc_errlevel_t level;
+      char temp[64];
+      if (errlevelstring[0] != '-')
+      {
+         strcpy(temp, "--");
+         strncat(temp, errlevelstring, 64-strlen("--"));
+      }
+      else
+         strncpy(temp, errlevelstring, 64);
+
+      temp[63] = 0;
+      level = xpc_option_errlevel(temp);
+      if (level != XPC_ERROR_LEVEL_NOT_APPLICABLE)
+      {
+         result = xpc_errlevel_set(level);
+         if (! result)
+            xpc_errprintex("xpc_errlevel_set()", _("failed"));
+      }
+      else
+         xpc_errprintex(temp, _("failed"));
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_filename_check()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Checks the viability of a file-name.
+ *
+ *    A file-name is invalid if the pointer is null, the file-name is
+ *    zero-length, is "." or ".." or other bogus combinations.  We also
+ *    disallow filenames beginning with a hyphen.
+ *
+ *    Note that, at this time, permissions are not part of the check.
+ *
+ * \param filename
+ *    The filename pointer to be checked.
+ *
+ * \return
+ *    Returns 'true' if the filename is valid.  Otherwise, 'false' is
+ *    returned.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_09().  Tested implicitly.
+ *    -  unit_test_s_filename_check().  This static function should be a
+ *       one-to-one match for xpc_filename_check(), and should be updated in
+ *       synchrony with it..
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_filename_check (const char * filename)
+{
+   cbool_t result = false;
+   if (not_nullptr(filename))
+   {
+      if (strlen(filename) > 0)
+      {
+         result = !
+         (
+            (strcmp(filename, ".") == 0)     ||
+            (strcmp(filename, "..") == 0)    ||
+            (strcmp(filename, "./") == 0)    ||
+            (strcmp(filename, "../") == 0)   ||
+            (strcmp(filename, ".\\") == 0)   ||
+            (strcmp(filename, "..\\") == 0)  ||
+            (strncmp(filename, "-", 1) == 0)
+         );
+      }
+
+      /*
+       * No need to report any bad file-name in error-logging, because the
+       * problem may simply be that there is no file-name, just the next
+       * option.
+       *
+       *    if (! result)
+       *       xpc_errprint_func(_("the filename is not acceptable"));
+       */
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_parse_errlevel_nohelp()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Parses a command-line argument array for error-level arguments, but
+ *    ignores "--help".
+ *
+ *    This function is the same as xpc_parse_errlevel(), but it ignores
+ *    "--help".  It should be used in lieu of xpc_parse_errlevel() by
+ *    callers that want to create their own help.
+ *
+ *    Note that this version does check for the --help switching, returning
+ *    false if it is encountered.  This function also returns false upon an
+ *    error.  But, otherwise, it has to scan every argument, in case
+ *    multiple error-logging options were specified.
+ *
+ *    This function is called by xpc_parse_errlevel() to promote code reuse.
+ *
+ * \param argc
+ *    The main()-style number of command-line arguments.
+ *
+ * \param argv
+ *    The main()-style array of command-line arguments.
+ *
+ * \return
+ *    Returns 'true' if the argument array was valid, and the function
+ *    succeeded in finding a proper error-logging command-line option.
+ *    'false' is returned if the parameters were incorrect, or if the
+ *    "--help" or "--version" tokens were encountered, if argc is bogus (0),
+ *    or if some other error occurred.
+ *
+ *    Please note that an option (e.g. "--my-app-option") that is unknown to
+ *    the error-logging is simply ignored, and 'true' is returned, so that
+ *    the rest of the application processing can proceed.
+ *
+ * \unittests
+ *    errorlogging_test_02_09().  This test does not attempt to handle all
+ *    of the command-line options, due to the large-number of side-effects
+ *    that would have to be guarded against during the test.  Nonetheless, a
+ *    lot of other internal properties do get tested.
+ *
+ *    For tests of the functions called inside this function, see the
+ *    unit-tests for:
+ *
+ *       -  xpc_errlevel_set()
+ *       -  xpc_open_logfile()
+ *       -  xpc_syslogging_set()
+ *       -  xpc_usecolor_set()
+ *       -  xpc_timestamps_set()
+ *       -  xpc_buffering_set()
+ *       -  xpc_synchusage_set()
+ *       -  xpc_async_logging_set()
+ *       -  xpc_showerr_version()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_parse_errlevel_nohelp (int argc, char * argv [])
+{
+   cbool_t result = false;
+   if (not_nullptr(argv))
+   {
+      if (argc > 1)
+      {
+         int argi = 0;
+         while (++argi < argc)
+         {
+            xpc_errlevel_t level = xpc_option_errlevel(argv[argi]);
+            if (level != XPC_ERROR_LEVEL_NOT_APPLICABLE)
+            {
+               result = xpc_errlevel_set(level);
+            }
+            else if (strcmp(argv[argi], CMD(_STDOUT)) == 0)
+            {
+               result = s_logfile_set(stdout);
+            }
+            else if (strcmp(argv[argi], CMD(_STDERR)) == 0)
+            {
                result = s_logfile_set(stderr);
             }
             else if (strcmp(argv[argi], CMD(_LOG)) == 0)
@@ -1435,6 +2919,84 @@ xpc_parse_errlevel_nohelp (int argc, char * argv [])
                   break;
                }
             }
+            else if
+            (
+               (strcmp(argv[argi], CMD(_LOG_MAX_BYTES)) == 0) ||
+               (strcmp(argv[argi], CMD(_LOG_MAX_AGE)) == 0) ||
+               (strcmp(argv[argi], CMD(_LOG_KEEP)) == 0)
+            )
+            {
+               if ((argi+1) < argc)
+                  result = log_rotation_option(argv[argi], argv[argi+1]);
+               else
+               {
+                  xpc_errprintf("%s %s", argv[argi], _("requires a number"));
+                  result = false;
+                  break;
+               }
+            }
+            else if (strcmp(argv[argi], CMD(_LOG_RING)) == 0)
+            {
+               if ((argi+1) < argc)
+               {
+                  result = xpc_filename_check(argv[argi+1]);
+                  if (result)
+                  {
+                     result = xpc_open_logring
+                     (
+                        argv[argi+1], XPC_LOGRING_DEFAULT_SIZE
+                     );
+                  }
+                  else
+                     break;            /* don't bother checking any further   */
+               }
+               else
+               {
+                  xpc_errprint_func(_("--log-ring requires a filename"));
+                  result = false;
+                  break;
+               }
+            }
+            else if (strcmp(argv[argi], CMD(_LOG_RATE_LIMIT)) == 0)
+            {
+               if ((argi+1) < argc)
+               {
+                  const char * value = argv[argi+1];
+                  char * endptr;
+                  unsigned long rate = strtoul(value, &endptr, 10);
+                  unsigned long burst = 0;
+                  result = endptr != value;
+                  if (result && *endptr == ',')             /* rate,burst   */
+                  {
+                     value = endptr + 1;
+                     burst = strtoul(value, &endptr, 10);
+                     result = endptr != value;
+                  }
+                  if (result && *endptr == 0)
+                  {
+                     result = xpc_ratelimit_set
+                     (
+                        (unsigned) rate, (unsigned) burst
+                     );
+                  }
+                  else
+                  {
+                     xpc_errprintf
+                     (
+                        "%s: %s '%s'", argv[argi], _("invalid number"),
+                        argv[argi+1]
+                     );
+                     result = false;
+                     break;
+                  }
+               }
+               else
+               {
+                  xpc_errprintf("%s %s", argv[argi], _("requires a number"));
+                  result = false;
+                  break;
+               }
+            }
             else if (strcmp(argv[argi], CMD(_SYSLOG)) == 0)
             {
                xpc_infoprint(_("setting system logging"));
@@ -1452,870 +3014,2107 @@ xpc_parse_errlevel_nohelp (int argc, char * argv [])
                 *
                 */
 
-               FILE * temp = xpc_logfile();
-               if ((temp == stderr) || (temp == stdout))
-               {
-                  result = xpc_usecolor_set(true);
-               }
-               else
-                  result = true;
-            }
-            else if (strcmp(argv[argi], CMD(_MONO)) == 0)
-            {
-               result = xpc_usecolor_set(false);
-            }
-            else if (strcmp(argv[argi], _NC) == 0)    /* a special case */
-            {
-               result = xpc_usecolor_set(false);
-            }
-            else if (strcmp(argv[argi], CMD(_NOCOLOR)) == 0)
-            {
-               result = xpc_usecolor_set(false);
-            }
-            else if (strcmp(argv[argi], CMD(_NO_COLOR)) == 0)
-            {
-               result = xpc_usecolor_set(false);
-            }
-            else if
-            (
-               (strcmp(argv[argi], CMD(_TIMESTAMPS)) == 0)
-                        ||
-               (strcmp(argv[argi], CMD(_TIME_STAMPS)) == 0)
-            )
-            {
-               cbool_t rebase = false;
-               cbool_t ok = xpc_filename_check(argv[argi+1]);
-               if (ok)
-               {
-                  if (strcmp(argv[argi+1], "rebase") == 0)
-                     rebase = true;
-               }
-               result = xpc_timestamps_set(true, rebase);
-            }
-            else if
-            (
-               (strcmp(argv[argi], CMD(_NO_TIMESTAMPS)) == 0)
-                        ||
-               (strcmp(argv[argi], CMD(_NO_TIME_STAMPS)) == 0)
-            )
-            {
-               result = xpc_timestamps_set(false, false);
-            }
-            else if (strcmp(argv[argi], CMD(_UNBUFFER)) == 0)
-            {
-               result = xpc_buffering_set(XPC_ERROR_NOT_BUFFERED);
-            }
-            else if (strcmp(argv[argi], CMD(_BUFFER)) == 0)
-            {
-               result = xpc_buffering_set(XPC_ERROR_LINE_BUFFERED);
-            }
-            else if (strcmp(argv[argi], CMD(_UNBUFFERED)) == 0)
-            {
-               result = xpc_buffering_set(XPC_ERROR_NOT_BUFFERED);
-            }
-            else if (strcmp(argv[argi], CMD(_BUFFERED)) == 0)
-            {
-               result = xpc_buffering_set(XPC_ERROR_LINE_BUFFERED);
-            }
-            else if (strcmp(argv[argi], CMD(_SYNCH)) == 0)
-            {
-               result = xpc_synchusage_set(true);
-            }
-            else if (strcmp(argv[argi], CMD(_NO_SYNCH)) == 0)
-            {
-               result = xpc_synchusage_set(false);
-            }
-            else if (strcmp(argv[argi], CMD(_VERSION)) == 0)
-            {
-               xpc_showerr_version();
-               result = false;
-            }
-            else if (strcmp(argv[argi], CMD(_HELP)) == 0)
-            {
-               result = false;
-               break;
-            }
-            else
-            {
-               /*
-                * Here, we found no match for the given option.
-                *
-                * This could be an error, or it could be an application
-                * option that is unknown to the error-logging module.  If it
-                * is the latter, then we do not want to ignore (skip) the
-                * functionality of the application.  So we have to return a
-                * value that lets the application proceed.
-                */
+               FILE * temp = xpc_logfile();
+               if ((temp == stderr) || (temp == stdout))
+               {
+                  result = xpc_usecolor_set(true);
+               }
+               else
+                  result = true;
+            }
+            else if (strcmp(argv[argi], CMD(_MONO)) == 0)
+            {
+               result = xpc_usecolor_set(false);
+            }
+            else if (strcmp(argv[argi], _NC) == 0)    /* a special case */
+            {
+               result = xpc_usecolor_set(false);
+            }
+            else if (strcmp(argv[argi], CMD(_NOCOLOR)) == 0)
+            {
+               result = xpc_usecolor_set(false);
+            }
+            else if (strcmp(argv[argi], CMD(_NO_COLOR)) == 0)
+            {
+               result = xpc_usecolor_set(false);
+            }
+            else if
+            (
+               (strcmp(argv[argi], CMD(_TIMESTAMPS)) == 0)
+                        ||
+               (strcmp(argv[argi], CMD(_TIME_STAMPS)) == 0)
+            )
+            {
+               cbool_t rebase = false;
+               cbool_t ok = xpc_filename_check(argv[argi+1]);
+               if (ok)
+               {
+                  if (strcmp(argv[argi+1], "rebase") == 0)
+                     rebase = true;
+               }
+               result = xpc_timestamps_set(true, rebase);
+            }
+            else if
+            (
+               (strcmp(argv[argi], CMD(_NO_TIMESTAMPS)) == 0)
+                        ||
+               (strcmp(argv[argi], CMD(_NO_TIME_STAMPS)) == 0)
+            )
+            {
+               result = xpc_timestamps_set(false, false);
+            }
+            else if (strcmp(argv[argi], CMD(_TIMESTAMP_CLOCK)) == 0)
+            {
+               result = xpc_filename_check(argv[argi+1]);
+               if (result)
+               {
+                  const char * name = argv[argi+1];
+                  xpc_timestamp_clock_t clock = XPC_TIMESTAMP_CLOCK_WALL;
+                  if (strcmp(name, "coarse") == 0)
+                     clock = XPC_TIMESTAMP_CLOCK_COARSE;
+                  else if (strcmp(name, "tsc") == 0)
+                     clock = XPC_TIMESTAMP_CLOCK_TSC;
+                  else if (strcmp(name, "wall") != 0)
+                  {
+                     xpc_errprint_func(_("unknown time-stamp clock"));
+                     result = false;
+                  }
+                  if (result)
+                     result = xpc_timestamp_clock_set(clock);
+               }
+               else
+                  xpc_errprint_func(_("time-stamp clock name required"));
+            }
+            else if (strcmp(argv[argi], CMD(_UNBUFFER)) == 0)
+            {
+               result = xpc_buffering_set(XPC_ERROR_NOT_BUFFERED);
+            }
+            else if (strcmp(argv[argi], CMD(_BUFFER)) == 0)
+            {
+               result = xpc_buffering_set(XPC_ERROR_LINE_BUFFERED);
+            }
+            else if (strcmp(argv[argi], CMD(_UNBUFFERED)) == 0)
+            {
+               result = xpc_buffering_set(XPC_ERROR_NOT_BUFFERED);
+            }
+            else if (strcmp(argv[argi], CMD(_BUFFERED)) == 0)
+            {
+               result = xpc_buffering_set(XPC_ERROR_LINE_BUFFERED);
+            }
+            else if (strcmp(argv[argi], CMD(_SYNCH)) == 0)
+            {
+               result = xpc_synchusage_set(true);
+            }
+            else if (strcmp(argv[argi], CMD(_NO_SYNCH)) == 0)
+            {
+               result = xpc_synchusage_set(false);
+            }
+            else if (strcmp(argv[argi], CMD(_ASYNC_LOG)) == 0)
+            {
+               result = xpc_async_logging_set(true);
+            }
+            else if (strcmp(argv[argi], CMD(_NO_ASYNC_LOG)) == 0)
+            {
+               result = xpc_async_logging_set(false);
+            }
+            else if (strcmp(argv[argi], CMD(_LOG_BINARY)) == 0)
+            {
+               result = xpc_binary_logging_set(true);
+            }
+            else if (strcmp(argv[argi], CMD(_NO_LOG_BINARY)) == 0)
+            {
+               result = xpc_binary_logging_set(false);
+            }
+            else if (strcmp(argv[argi], CMD(_VERSION)) == 0)
+            {
+               xpc_showerr_version();
+               result = false;
+            }
+            else if (strcmp(argv[argi], CMD(_HELP)) == 0)
+            {
+               result = false;
+               break;
+            }
+            else
+            {
+               /*
+                * Here, we found no match for the given option.
+                *
+                * This could be an error, or it could be an application
+                * option that is unknown to the error-logging module.  If it
+                * is the latter, then we do not want to ignore (skip) the
+                * functionality of the application.  So we have to return a
+                * value that lets the application proceed.
+                */
+
+               result = true;
+            }
+         }
+      }
+      else
+         result = argc > 0;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_parse_errlevel()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Parses a command-line argument array for error-level arguments.
+ *
+ *    This function scans through a list of standard C command-line
+ *    arguments.  It checks each option string, starting from the last
+ *    argument.  If it finds one that is in the legal list of error-level
+ *    options, it gets the corresponding error level and sets it.  It does
+ *    not exit immediately -- this results in the behavior that the first
+ *    error-level option in the list, not the last, is the one that takes
+ *    effect.
+ *
+ * \param argc
+ *    The main()-style number of command-line arguments.
+ *
+ * \param argv
+ *    The main()-style array of command-line arguments.
+ *
+ * \return
+ *    'true' is returned if xpc_parse_errlevel_nohelp() detected an
+ *    error-logging option.  'false' is returned if a bad parameter is
+ *    passed into the function, but not if a bad command-line option is
+ *    passed in.  The reason is that other subsystems may have their own
+ *    options on the command line.  Therefore, we really can't have any
+ *    command-line error detection.  'false' is also returned if the
+ *    "--help" option is encountered.  This allows the caller to abort.
+ *    However, if the caller does not want to abort just because help was
+ *    called, he'll have to check for that himself, ignoring the return
+ *    value.
+ *
+ * \todo
+ *    Should we also close the logfile here, just in case this function
+ *    is called later on in the application beyond startup?
+ *
+ * \todo
+ *    Is there any way to detect if stdout or stderr are being redirected
+ *    to a file?
+ *
+ * \unittests
+ *    -  errorlogging_test_01_01().  This test is a "smoke test".
+ *    -  errorlogging_test_02_10()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_parse_errlevel (int argc, char * argv [])
+{
+   cbool_t result = false;
+   if (not_nullptr(argv))
+   {
+      result = xpc_parse_errlevel_nohelp(argc, argv);
+      while (argc-- > 1)
+      {
+         if (strcmp(argv[argc], CMD(_HELP)) == 0)
+         {
+            xpc_error_help();
+            result = false;
+            break;
+         }
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_errlevel()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the current error-level code to the caller.
+ *
+ *    This function simply returns the level bits of xpc_errlog_state.
+ *    Inner loops can use the xpc_errlevel_fast() macro instead, to avoid
+ *    the function call.
+ *
+ *    xpc_errlevel() is useful in unit testing, where the test is meant to
+ *    generate an erroneous result, but the function shows the error
+ *    privately, potentially confusing the user who is viewing the output.
+ *    Call xpc_errlevel(), save its result, do the operations, then call
+ *    xpc_errlevel_set() with the saved value, to restore it.
+ *
+ * \return
+ *    The private error-level code is returned.  However, if the
+ *    XPC_NO_ERRORLOG is defined, then XPC_ERROR_LEVEL_NONE is always
+ *    returned, for extra speed.
+ *
+ * \unittests
+ *    -  errorlogging_test_01_01().  This test is a "smoke test".
+ *
+ *//*-------------------------------------------------------------------------*/
+
+xpc_errlevel_t
+xpc_errlevel (void)
+{
+   return xpc_errlevel_fast();
+}
+
+/******************************************************************************
+ * xpc_option_errlevel()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts the name of an error-logging option into an error-level
+ *    value.
+ *
+ *    This function converts a valid English option switch into the
+ *    appropriate error-level value.  It is assume that the hyphens are part
+ *    of the string, as in "--quiet".
+ *
+ * \param cmdswitch
+ *    Error-level option string with hyphens.
+ *
+ * \return
+ *    If the parameter is not null, and the string is a legal name for an
+ *    error-level option, the proper XPC_ERROR_LEVEL enumeration value is
+ *    returned.  Otherwise, XPC_ERROR_LEVEL_NOT_APPLICABLE is returned.
+ *
+ *    If the build was a debug build, and the option name is "--debug", the
+ *    effect is as if "--info" were the parameter.  If the build was not
+ *    debug-enabled, "--debug" maps to "--error".
+ *
+ * \unittests
+ *    -  errorlogging_test_02_08()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+xpc_errlevel_t
+xpc_option_errlevel (const char * cmdswitch)
+{
+   xpc_errlevel_t result = XPC_ERROR_LEVEL_NOT_APPLICABLE;
+   if (not_nullptr(cmdswitch))
+   {
+      if (strcmp(cmdswitch, CMD(_QUIET)) == 0)
+         result = XPC_ERROR_LEVEL_NONE;
+      if (strcmp(cmdswitch, CMD(_SILENT)) == 0)          /* XPC CUT option    */
+         result = XPC_ERROR_LEVEL_NONE;
+      else if (strcmp(cmdswitch, CMD(_DAEMON)) == 0)
+         result = XPC_ERROR_LEVEL_NONE;
+      else if (strcmp(cmdswitch, CMD(_ERROR)) == 0)
+         result = XPC_ERROR_LEVEL_ERRORS;
+      else if (strcmp(cmdswitch, CMD(_ERRORS)) == 0)
+         result = XPC_ERROR_LEVEL_ERRORS;
+      else if (strcmp(cmdswitch, CMD(_WARN)) == 0)
+         result = XPC_ERROR_LEVEL_WARNINGS;
+      else if (strcmp(cmdswitch, CMD(_WARNINGS)) == 0)
+         result = XPC_ERROR_LEVEL_WARNINGS;
+      else if (strcmp(cmdswitch, CMD(_INFO)) == 0)
+         result = XPC_ERROR_LEVEL_INFO;
+      else if (strcmp(cmdswitch, CMD(_INFORMATION)) == 0)
+         result = XPC_ERROR_LEVEL_INFO;
+      else if (strcmp(cmdswitch, CMD(_ALL)) == 0)
+         result = XPC_ERROR_LEVEL_ALL;
+      else if (strcmp(cmdswitch, CMD(_VERBOSE)) == 0)
+         result = XPC_ERROR_LEVEL_ALL;
+      else if (strcmp(cmdswitch, CMD(_SDEBUG)) == 0)
+#ifdef DEBUG
+         result = XPC_ERROR_LEVEL_INFO;
+#else
+         result = XPC_ERROR_LEVEL_ERRORS;
+#endif
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_errlevel_string()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts an error-level code into an error-level string, without
+ *    hyphens.
+ *
+ * \param errlev
+ *    The error-level code to convert to a string.
+ *
+ * \return
+ *    A string that is the option switch representing the current
+ *    error-level, minus the hyphens.
+ *
+ *    The "debug" string is impossible to return, since that string
+ *    represents an "info" error level for a debug-enabled build.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_11()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+const char *
+xpc_errlevel_string (xpc_errlevel_t errlev)
+{
+   const char * elstring = _("unknown");
+   switch (errlev)
+   {
+      case XPC_ERROR_LEVEL_ERRORS:
+
+         elstring = _(_ERRORS);
+         break;
+
+      case XPC_ERROR_LEVEL_WARNINGS:
+
+         elstring = _(_WARNINGS);
+         break;
+
+      case XPC_ERROR_LEVEL_INFO:
+
+         elstring = _(_INFO);
+         break;
+
+      case XPC_ERROR_LEVEL_ALL:
+
+         elstring = _(_VERBOSE);
+         break;
+
+      case XPC_ERROR_LEVEL_NONE:
+
+         elstring = _(_QUIET);
+         break;
+
+      case XPC_ERROR_LEVEL_NOT_APPLICABLE:
+
+         elstring = _(_NOT_APPLICABLE);
+         break;
+   }
+   return elstring;
+}
+
+/******************************************************************************
+ * xpc_showerrlevel()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Displays the current debug level as an option string, with hyphens.
+ *
+ *    The string is obtained by using xpc_errlevel() to get the current
+ *    error-level, and then converting this level to a string using
+ *    xpc_errlevel_string().
+ *
+ *    This function shows the level regardless of what it is, except for the
+ *    "none" level.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_12()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_showerrlevel (void)
+{
+   xpc_errlevel_t level = xpc_errlevel();
+   if (level != XPC_ERROR_LEVEL_NONE)
+   {
+      const char * dbgstring = xpc_errlevel_string(level);
+      fprintf
+      (
+         xpc_logfile(), ERRL_FMT_EXT_MESSAGE,
+         xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO,
+         _("error level"), dbgstring
+      );
+   }
+}
+
+/******************************************************************************
+ * xpc_shownothing()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Determines if the caller should not show any console messages of any
+ *    kind.
+ *
+ *    This error-level is set from the command line using the "--quiet"
+ *    option switch.  The XPCCUT (unit-test) library's --silent option also
+ *    causes this setting.
+ *
+ *    Only output done though the functions in the errorlogging module is
+ *    amenable to the application of the error-level code.  The caller is
+ *    perfectly free to print messages without regard to the error-level.
+ *
+ *    This function is the first of a family of error-level checking
+ *    functions.  This small family of functions allows the caller to see if
+ *    showing a message is permitted, based on the current error level.
+ *
+ * \return
+ *    Returns 'true' if the error level is XPC_ERROR_LEVEL_NONE.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_13()
+ *
+ *---------------------------------------------------------------------------*/
+
+cbool_t
+xpc_shownothing (void)
+{
+   return xpc_errlevel_fast() == XPC_ERROR_LEVEL_NONE;
+}
+
+/******************************************************************************
+ * xpc_showerrors()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Determines if the caller should show an error message.
+ *
+ *    An error message is one that causes some kind of inability to
+ *    function.  Error messages are tagged by a "?" (question mark)
+ *    character.
+ *
+ *    Error messages can be shown conditionally by using the
+ *    "xpc_errprint" family of functions [xpc_errprint(),
+ *    xpc_errprintex(), xpc_errprint_func(), which is a macro, and
+ *    xpc_errprintf()].
+ *
+ *    If these functions are not sufficient, or not desired, then
+ *    xpc_showerrors() can be tested to decide on some other kind of
+ *    error-display mechanism.
+ *
+ *    Error messages are allowed by default.  The user can also supply the
+ *    "--error" option switch on the command line.
+ *
+ * \return
+ *    'true' if errors are allowed to be shown.  If not, then the caller
+ *    means to show absolutely no output text (as in a daemon).
+ *
+ * \unittests
+ *    -  errorlogging_test_02_13()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_showerrors (void)
+{
+#ifdef XPC_NO_ERRORLOG
+   return false;
+#else
+   return xpc_showerrors_fast();
+#endif
+}
+
+/******************************************************************************
+ * xpc_showwarnings ()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Determines if the caller should show a warning message.
+ *
+ *    A warning message is one that indicates an unexpected condition that
+ *    is not erroneous.  Or it indicates a condition to which special
+ *    attention should be paid by the user.  Warning messages are tagged by
+ *    a "!" (exclamation point) character.
+ *
+ *    Warning messages can be shown conditionally by using the
+ *    "xpc_warnprint" family of functions [xpc_warnprint(),
+ *    xpc_warnprintex(), xpc_warnprint_func(), which is a macro, and
+ *    xpc_warnprintf()].
+ *
+ *    If these functions are not sufficient, or not desired, then
+ *    xpc_showwarnings () can be tested to decide on some other kind of
+ *    warning-display mechanism.
+ *
+ *    The user can supply the "--warn" option switch on the command line in
+ *    order to enable the display of warnings.  The display of warnings is
+ *    off by default.
+ *
+ * \return
+ *    'true' if warnings and errors are allowed to be shown.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_13()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_showwarnings  (void)
+{
+   return xpc_showwarnings_fast();
+}
+
+/******************************************************************************
+ * xpc_showinfo()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Determines if the caller should show an informational message.
+ *
+ *    An informational message is one that a user normally does not need to
+ *    see.  However, if the user wants to verify the progress of the
+ *    application more closely without debugging, the user can provide the
+ *    "--info" switch on the command-line, and more messages will be shown.
+ *    Informational messages are tagged with an "*" (asterisk).
+ *
+ *    Info messages can be shown conditionally by using the "xpc_infoprint"
+ *    family of functions [xpc_infoprint(), xpc_infoprintex(),
+ *    xpc_infoprint_func(), which is a macro, and xpc_infoprintf()].
+ *
+ *    If these functions are not sufficient, or not desired, then
+ *    xpc_showinfo() can be tested to decide on some other kind of
+ *    information-display mechanism.
+ *
+ *    The user can supply the "--info" option switch on the command line in
+ *    order to enable the display of info.  The display of info is
+ *    off by default.
+ *
+ * \return
+ *    'true' if information, warnings, and errors can be shown.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_13()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_showinfo (void)
+{
+   return xpc_showinfo_fast();
+}
+
+/******************************************************************************
+ * xpc_showall()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Determines if the caller can show all messages.
+ *
+ *    The only ways to show such messages are to use print() [no other forms
+ *    of this function are provided] or to wrap more conventional print
+ *    functions [e.g. fprintf()] in a test of xpc_showall().
+ *
+ *    The option switches "--verbose" or "--all" enable the showing of all
+ *    messages.
+ *
+ * \return
+ *    'true' if all messages and tested output can be shown.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_13()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_showall (void)
+{
+   return xpc_errlevel_fast() >= XPC_ERROR_LEVEL_ALL;
+}
+
+/******************************************************************************
+ * xpc_showdebug()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Determines if the caller can show debug messages.
+ *
+ *    The option switch "--debug" enables this test, if the application is
+ *    compiled for debugging.  Otherwise, the option is equivalent to
+ *    "--error".
+ *
+ * \return
+ *    If compiled for debugging, this function acts like xpc_showinfo().
+ *    Otherwise, it always returns false.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_13()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_showdebug (void)
+{
+#if defined DEBUG && ! defined XPC_NO_ERRORLOG
+   return xpc_showinfo();
+#else
+   return false;
+#endif
+}
+
+/******************************************************************************
+ * xpc_showerr_version()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Shows the approximate build time of this module.
+ *
+ *    In addition to showing the build time, this function will indicate
+ *    when the module is compiled for debugging (the DEBUG macro is
+ *    defined), or when the XPC_NO_ERRORLOG macro is defined.
+ *
+ *    This function is not all that useful, but leave it alone, it might
+ *    come in handy once in a while.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_14()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_showerr_version (void)
+{
+#ifdef DEBUG
+   xpc_infoprintf
+   (
+      "%s: %s %s \n%s.\n",
+      _("Approximate build time"), __DATE__,  __TIME__,
+      _("Compiled with debugging information")
+   );
+#else
+   xpc_infoprint(_("Release version"));
+#endif
+
+#ifdef XPC_NO_ERRORLOG
+   xpc_infoprint(_("Compiled with disabled error-logging functions."));
+#endif
+}
+
+/******************************************************************************
+ * xpc_error_help()
+ *------------------------------------------------------------------------*//**
+ *
+ *    This function emits a brief summary of the error options, as help
+ *    text.  It is not static, just in case the caller wants to handle the
+ *    --help option on its own.
+ *
+ *    Note that, although translation is allowed, the names of the options
+ *    must currently always be in the English form.
+ *
+ * \unittests
+ *    N/A.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_error_help (void)
+{
+   static cbool_t g_xpc_error_help_done = false;
+   const char * const helptext =
+   M_(
+"Error-logging options:\n"
+"\n"
+"--quiet             Show no messages, not even errors.\n"
+"--silent            The same as --quiet; this option matches the --silent.\n"
+"                    option in the XPC unit-test library (libxpccut).\n"
+"--errors            Show error messages.\n"
+"--warnings          Show errors and warnings.\n"
+"--warn              Same as --warnings.\n"
+"--info              Show errors, warnings, and information.\n"
+"--verbose           Show all messages.\n"
+"--all               Same as --verbose.\n"
+"--stdout            Change the log file from stderr to stdout.\n"
+"--stderr            Use stderr as the log file [this is the default].\n"
+"--log file          Change the log file to the given file.  The file\n"
+"                    is truncated if it exists, erasing the previous\n"
+"                    contents.\n"
+"--append file       Same as --log, except that any existing file is\n"
+"                    appended, not replaced.\n"
+"                    ('stdout' and 'stderr' are valid filenames here.)\n"
+"--log-max-bytes n   Rotate the --log or --append file when it reaches n\n"
+"                    bytes.  The file is renamed to 'file.1', and a new\n"
+"                    file is started.  [The default is 0, no rotation].\n"
+"--log-max-age s     Rotate the log file when it is s seconds old.\n"
+"--log-keep n        Keep n old log files, 'file.1' (the newest) to\n"
+"                    'file.n'.  [The default is 5].\n"
+"--log-ring file     Write the log lines into a 1 MB circular file that is\n"
+"                    mapped into memory.  The newest lines survive a crash\n"
+"                    of the process.  Read it with logring_dump.\n"
+"--syslog            Redirect output to the system log.  Normally, this\n"
+"                    is needed only by daemons, which set it themselves\n"
+"                    indirectly in the xpc_daemonize() function.  [The\n"
+"                    default is --no-syslog.\n"
+"--no-syslog         Output the log to the normal place, stderr.\n"
+"--buffered          Buffer the output log.  Normally, stdout and files\n"
+"                    are already buffered, while, stderr is not.  Use\n"
+"                    this option if the log-printing functions cause a\n"
+"                    segmentation fault.\n"
+"--unbuffered        Make the output log unbuffered.\n"
+"--color             Write the tag characters (?!*>) in color [default].\n"
+"                    [Not supported in Windows].\n"
+"--mono              Write tag characters without color.  This option\n"
+"                    will avoid ANSI escape sequences in log files.\n"
+"--no-color          Synonym for --mono.  Also --nocolor and -nc.\n"
+"--timestamps        Enable adding time-stamps to the errorlogging output.\n"
+"--time-stamps       The time stamp goes between the tag character and the\n"
+"                    message, and has the format '[seconds.nanoseconds]'.\n"
+"--timestamps rebase The same as without 'rebase', but subtract the initial\n"
+"--time-stamps rebase time in seconds, to get an easier-to-grok number.\n"
+"--timestamp-clock c Read the time-stamps from clock 'wall' [default],\n"
+"                    'coarse' (the cheap, tick-resolution monotonic\n"
+"                    clock), or 'tsc' (the calibrated CPU counter).\n"
+   );
+   const char * const helptext2 =            /* C99 caps literals at 4095   */
+   M_(
+"--synch             Lock the output (to avoid intermixing of messages\n"
+"                    from different threads.) [The default is --no-synch].\n"
+"--no-synch          Do not synchronize the stderr output stream used for\n"
+"                    logging.\n"
+"--async-log         Queue the log lines, and write them in batches from a\n"
+"                    background thread, to keep slow output from delaying\n"
+"                    the application.  [The default is --no-async-log].\n"
+"--no-async-log      Write each log line from the thread that logs it.\n"
+"--log-binary        Capture the format and arguments of each log line,\n"
+"                    and format the line later, in the --async-log writer\n"
+"                    thread, or when the --log-ring file is read.\n"
+"--no-log-binary     Format each log line in the thread that logs it.\n"
+"                    [This is the default].\n"
+"--log-rate-limit r[,b]\n"
+"                    Let each call site log at most r lines per second,\n"
+"                    in bursts of up to b lines [default b = r].  Dropped\n"
+"                    lines are summed up in a 'last message repeated N\n"
+"                    times' line.  [The default, 0, means no limit].\n"
+"--daemon            Same as quiet.  This option (if provided) is\n"
+"                    usually coded to cause operation as a daemon or\n"
+"                    a service.  Put other options before it to keep\n"
+"                    logging active, but be aware that stdout and stderr\n"
+"                    are closed in daemon mode.\n"
+"--help              Show this help banner.\n"
+"--version           Show basic version information.\n"
+"\n"
+   );
+   if (! g_xpc_error_help_done)
+   {
+      fprintf(stdout, "%s%s", helptext, helptext2);
+      g_xpc_error_help_done = true;
+   }
+}
+
+/******************************************************************************
+ * xpc_application_help()
+ *------------------------------------------------------------------------*//**
+ *
+ *    This function emits a brief summary of the error options, as help
+ *    text.  It is not static, just in case the caller wants to handle the
+ *    --help option on its own.
+ *
+ *    Note that, although translation is allowed, the names of the options
+ *    must currently always be in the English form.
+ *
+ * \param helptext
+ *    Provides the help text to be printed.
+ *
+ * \unittests
+ *    N/A.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_application_help (const char * helptext)
+{
+   fprintf(stdout, "%s", helptext);
+   fprintf(stdout, "\n");
+}
+
+/******************************************************************************
+ * xpc_syslogging_set()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Causes the error-log output to be directed to the system log.
+ *
+ *    In a daemon, the standard output files are closed.  Therefore, we have
+ *    to do one of the following:
+ *
+ *       -# Disable error-logging.  This option can be performed by calling
+ *          the xpc_errlevel_set() function.
+ *       -# Redirect error-logging to a text file.  This option can be
+ *          performed by calling the xpc_open_logfile() function.  The only
+ *          issue is what name to give the file.
+ *       -# Redirect error-logging to the syslog() facility.  This is
+ *          probably the best option.  The error-levels are mapped onto the
+ *          following system-log levels.
+ *
+\verbatim
+         Error-logging level           System-logging level
+         ===================           ====================
+
+         XPC_ERROR_LEVEL_NONE          not applicable
+         not applicable                LOG_EMERG
+         not applicable                LOG_ALERT
+         not applicable                LOG_CRIT
+         XPC_ERROR_LEVEL_ERRORS        LOG_ERR
+         XPC_ERROR_LEVEL_WARNINGS      LOG_WARNING
+         not applicable                LOG_NOTICE
+         XPC_ERROR_LEVEL_INFO          LOG_INFO
+         XPC_ERROR_LEVEL_ALL           LOG_INFO
+         not applicable                LOG_DEBUG
+         XPC_ERROR_LEVEL_NOT_APPL...   not applicable
+\endverbatim
+ *
+ *    This function is called by xpc_daemonize() in the xpc_daemonize.c module.
+ *
+ *    The "--syslog" option can also be used, if you should so desire.
+ *
+ * \param flag
+ *    The desired boolean setting for sys-logging.
+ *
+ * \return
+ *    Returns 'true' if the setting succeeded.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_15()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syslogging_set (cbool_t flag)
+{
+   errlog_flag_set(XPC_ERRLOG_SYSLOG, flag);    /* enable this option         */
+   return xpc_usecolor_set(false);        /* don't want colors in system log  */
+}
+
+/******************************************************************************
+ * xpc_syslogging()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Obtains the current value of the --syslog option.
+ *
+ *    This function is useful in unit-testing to save the current value for
+ *    later restoration.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_15()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syslogging (void)
+{
+   return errlog_flag(XPC_ERRLOG_SYSLOG);
+}
+
+/******************************************************************************
+ * xpc_get_priority()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Converts an error-level code into a UNIX syslog() priority value.
+ *
+\verbatim
+          XPC_ERROR_LEVEL_NONE:           LOG_EMERG
+          XPC_ERROR_LEVEL_ERRORS:         LOG_ERR
+          XPC_ERROR_LEVEL_WARNINGS:       LOG_WARNING
+          XPC_ERROR_LEVEL_INFO:           LOG_INFO
+          XPC_ERROR_LEVEL_ALL:            LOG_INFO
+          XPC_ERROR_LEVEL_NOT_APPLICABLE: LOG_EMERG
+\endverbatim
+ *
+ *    This function is a helper for the msgtag() and va_tag() functions, but
+ *    we've exposed it to support a C++ semi-wrapper class.
+ *
+ * \todo
+ *    Support for Windows error priorities.  At present, the error-level
+ *    value parameter is simply returned.
+ *
+ * \param errlev
+ *    Error-level code to convert to a string.
+ *
+ * \return
+ *    Returns the POSIX priority level the corresponds to the XPC
+ *    error-level provided.  If there is no match, then -1 (POSIX_ERROR) is
+ *    returned.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_get_priority (xpc_errlevel_t errlev)
+{
+
+#ifdef POSIX
+
+   int priority = POSIX_ERROR;
+   switch (errlev)
+   {
+   case XPC_ERROR_LEVEL_NONE:           priority = LOG_EMERG;   break;
+   case XPC_ERROR_LEVEL_ERRORS:         priority = LOG_ERR;     break;
+   case XPC_ERROR_LEVEL_WARNINGS:       priority = LOG_WARNING; break;
+   case XPC_ERROR_LEVEL_INFO:           priority = LOG_INFO;    break;
+   case XPC_ERROR_LEVEL_ALL:            priority = LOG_INFO;    break;
+   case XPC_ERROR_LEVEL_NOT_APPLICABLE: priority = LOG_EMERG;   break;
+   }
 
-               result = true;
-            }
-         }
+#else
+
+   int priority = (int) errlev;
+
+#endif
+
+   return priority;
+}
+
+/******************************************************************************
+ * Per-thread format buffers [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Several logging functions have to assemble a message before writing
+ *    it:  the "ex" functions [e.g. xpc_errprintex()] and the "strerr"
+ *    functions [e.g. xpc_strerrnoprintex()] join several strings, and
+ *    va_tag() renders the tag, the optional time-stamp, the formatted
+ *    message, and the newline as one line.  Rather than allocate a buffer
+ *    for every message, each thread has its own buffer, which is allocated
+ *    the first time it is needed and then grown (doubling its size) only
+ *    when a longer message comes along.  Thus, once the buffer has reached
+ *    the size of the longest message, logging allocates nothing.
+ *
+ *    The buffer of a thread is freed when the thread exits, by the
+ *    destructor of a pthread key.
+ *
+ *    The number of allocations done for these buffers is kept in
+ *    gs_Format_Allocations, and can be obtained via
+ *    xpc_format_allocations(), to verify the claim made above.
+ *
+ *    The m_Busy flag guards against the re-entrant use of the buffer.  If
+ *    it is already in use, format_buffer_acquire() fails, and the caller
+ *    logs the message some other way.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   char * m_Text;                      /**< The buffer, or a null pointer.    */
+   size_t m_Size;                      /**< The allocated size of m_Text.     */
+   cbool_t m_Busy;                     /**< The buffer holds a live message.  */
+
+} xpc_format_buffer_t;
+
+static xpc_thread_local xpc_format_buffer_t gs_Format_Buffer;
+static pthread_key_t gs_Format_Key;
+static pthread_once_t gs_Format_Key_Once = PTHREAD_ONCE_INIT;
+static size_t gs_Format_Allocations = 0;
+
+/******************************************************************************
+ * format_key_create() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates the pthread key whose destructor, the Standard C free()
+ *    function, releases a thread's format buffer when the thread exits.
+ *    Called once, via pthread_once().
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+format_key_create (void)
+{
+   (void) pthread_key_create(&gs_Format_Key, free);
+}
+
+/******************************************************************************
+ * format_buffer_reserve() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Makes sure the calling thread's format buffer can hold the given
+ *    number of bytes.  The current contents are kept.
+ *
+ * \param size
+ *    The number of bytes needed, including the terminating null.
+ *
+ * \return
+ *    Returns 'true' if the buffer is large enough.  'false' is returned
+ *    only if an allocation fails.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+format_buffer_reserve (size_t size)
+{
+   cbool_t result = true;
+   xpc_format_buffer_t * fb = &gs_Format_Buffer;
+   if (size > fb->m_Size)
+   {
+      char * text;
+      size_t newsize = fb->m_Size > 0 ? fb->m_Size : XPC_FORMAT_BUFFER_SIZE;
+      while (newsize < size)
+         newsize *= 2;
+
+      text = realloc(fb->m_Text, newsize);
+      (void) xpc_atomic_add_relaxed(&gs_Format_Allocations, 1);
+      if (not_NULL(text))
+      {
+         fb->m_Text = text;
+         fb->m_Size = newsize;
+         (void) pthread_once(&gs_Format_Key_Once, format_key_create);
+         (void) pthread_setspecific(gs_Format_Key, text);
       }
       else
-         result = argc > 0;
+      {
+         xpc_errprint(_("format buffer allocation failed")); /* not ..ex()! */
+         result = false;
+      }
    }
    return result;
 }
 
 /******************************************************************************
- * xpc_parse_errlevel()
+ * format_buffer_acquire() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Parses a command-line argument array for error-level arguments.
+ *    Claims the calling thread's format buffer.  The caller must give it
+ *    back via format_buffer_release().
  *
- *    This function scans through a list of standard C command-line
- *    arguments.  It checks each option string, starting from the last
- *    argument.  If it finds one that is in the legal list of error-level
- *    options, it gets the corresponding error level and sets it.  It does
- *    not exit immediately -- this results in the behavior that the first
- *    error-level option in the list, not the last, is the one that takes
- *    effect.
+ * \return
+ *    Returns 'true' if the buffer was not already in use.
  *
- * \param argc
- *    The main()-style number of command-line arguments.
+ * \unittests
+ *    No direct unit-test possible in a static C function.
  *
- * \param argv
- *    The main()-style array of command-line arguments.
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+format_buffer_acquire (void)
+{
+   cbool_t result = ! gs_Format_Buffer.m_Busy;
+   if (result)
+      gs_Format_Buffer.m_Busy = true;
+
+   return result;
+}
+
+/******************************************************************************
+ * format_buffer_release() [static]
+ *------------------------------------------------------------------------*//**
  *
- * \return
- *    'true' is returned if xpc_parse_errlevel_nohelp() detected an
- *    error-logging option.  'false' is returned if a bad parameter is
- *    passed into the function, but not if a bad command-line option is
- *    passed in.  The reason is that other subsystems may have their own
- *    options on the command line.  Therefore, we really can't have any
- *    command-line error detection.  'false' is also returned if the
- *    "--help" option is encountered.  This allows the caller to abort.
- *    However, if the caller does not want to abort just because help was
- *    called, he'll have to check for that himself, ignoring the return
- *    value.
+ *    Marks the calling thread's format buffer as free again.
  *
- * \todo
- *    Should we also close the logfile here, just in case this function
- *    is called later on in the application beyond startup?
+ * \unittests
+ *    No direct unit-test possible in a static C function.
  *
- * \todo
- *    Is there any way to detect if stdout or stderr are being redirected
- *    to a file?
+ *//*-------------------------------------------------------------------------*/
+
+static void
+format_buffer_release (void)
+{
+   gs_Format_Buffer.m_Busy = false;
+}
+
+/******************************************************************************
+ * format_buffer_vappend() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Formats text onto the end of the calling thread's format buffer, in
+ *    one pass.
+ *
+ *    If the text does not fit, the buffer is grown to the size reported by
+ *    vsnprintf(), and the text is formatted again.  This second pass
+ *    occurs only when the buffer has to grow.
+ *
+ *    The caller must have acquired the buffer.
+ *
+ * \param used
+ *    The number of bytes of the buffer already in use.  It is updated to
+ *    include the new text (not counting the terminating null).
+ *
+ * \param fmt
+ *    The printf()-style format of the text.
+ *
+ * \param val
+ *    The arguments for the format.  They are copied before use, so the
+ *    caller can still use them if this function fails.
+ *
+ * \return
+ *    Returns 'true' if the text was added.
  *
  * \unittests
- *    -  errorlogging_test_01_01().  This test is a "smoke test".
- *    -  errorlogging_test_02_10()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_parse_errlevel (int argc, char * argv [])
+static cbool_t
+format_buffer_vappend (size_t * used, const char * fmt, va_list val)
 {
    cbool_t result = false;
-   if (not_nullptr(argv))
+   xpc_format_buffer_t * fb = &gs_Format_Buffer;
+   size_t needed = *used + 1;
+   int pass;
+   for (pass = 0; pass < 2; ++pass)
    {
-      result = xpc_parse_errlevel_nohelp(argc, argv);
-      while (argc-- > 1)
+      int length;
+      va_list valcopy;
+      if (! format_buffer_reserve(needed))
+         break;
+
+      va_copy(valcopy, val);
+      length = vsnprintf(&fb->m_Text[*used], fb->m_Size - *used, fmt, valcopy);
+      va_end(valcopy);
+      if (length < 0)
+         break;
+
+      if (*used + (size_t) length < fb->m_Size)
       {
-         if (strcmp(argv[argc], CMD(_HELP)) == 0)
-         {
-            xpc_error_help();
-            result = false;
-            break;
-         }
+         *used += (size_t) length;
+         result = true;
+         break;
       }
+      needed = *used + (size_t) length + 1;
    }
    return result;
 }
 
 /******************************************************************************
- * xpc_errlevel()
+ * format_buffer_append() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Provides the current error-level code to the caller.
+ *    The variable-argument version of format_buffer_vappend().
  *
- *    This function makes sure that initialization has taken place, and then
- *    it returns the current error level.
+ * \param used
+ *    The number of bytes of the buffer already in use; it is updated.
  *
- *    xpc_errlevel() is useful in unit testing, where the test is meant to
- *    generate an erroneous result, but the function shows the error
- *    privately, potentially confusing the user who is viewing the output.
- *    Call xpc_errlevel(), save its result, do the operations, then call
- *    xpc_errlevel_set() with the saved value, to restore it.
+ * \param fmt
+ *    The printf()-style format of the text.
+ *
+ * \param ...
+ *    The arguments for the format.
  *
  * \return
- *    The private error-level code is returned.  However, if the
- *    XPC_NO_ERRORLOG is defined, then XPC_ERROR_LEVEL_NONE is always
- *    returned, for extra speed.
+ *    Returns 'true' if the text was added.
  *
  * \unittests
- *    -  errorlogging_test_01_01().  This test is a "smoke test".
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-xpc_errlevel_t
-xpc_errlevel (void)
+static cbool_t
+format_buffer_append (size_t * used, const char * fmt, ...)
 {
-   init_option_errlevel();             /* only has an effect once, at maximum */
-   return gs_Error_Level;
+   cbool_t result;
+   va_list val;
+   va_start(val, fmt);
+   result = format_buffer_vappend(used, fmt, val);
+   va_end(val);
+   return result;
 }
 
 /******************************************************************************
- * xpc_option_errlevel()
+ * format_buffer_printf() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Converts the name of an error-logging option into an error-level
- *    value.
+ *    Acquires the calling thread's format buffer, and formats a message
+ *    into it.
  *
- *    This function converts a valid English option switch into the
- *    appropriate error-level value.  It is assume that the hyphens are part
- *    of the string, as in "--quiet".
+ *    The caller must give the buffer back via format_buffer_release() if
+ *    the result is not null.
  *
- * \param cmdswitch
- *    Error-level option string with hyphens.
+ * \param fmt
+ *    The printf()-style format of the message.
  *
- * \return
- *    If the parameter is not null, and the string is a legal name for an
- *    error-level option, the proper XPC_ERROR_LEVEL enumeration value is
- *    returned.  Otherwise, XPC_ERROR_LEVEL_NOT_APPLICABLE is returned.
+ * \param ...
+ *    The arguments for the format.
  *
- *    If the build was a debug build, and the option name is "--debug", the
- *    effect is as if "--info" were the parameter.  If the build was not
- *    debug-enabled, "--debug" maps to "--error".
+ * \return
+ *    Returns the formatted message.  A null pointer is returned if the
+ *    buffer is already in use, or could not be grown.
  *
  * \unittests
- *    -  errorlogging_test_02_08()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-xpc_errlevel_t
-xpc_option_errlevel (const char * cmdswitch)
+static const char *
+format_buffer_printf (const char * fmt, ...)
 {
-   xpc_errlevel_t result = XPC_ERROR_LEVEL_NOT_APPLICABLE;
-   if (not_nullptr(cmdswitch))
+   const char * result = nullptr;
+   if (format_buffer_acquire())
    {
-      if (strcmp(cmdswitch, CMD(_QUIET)) == 0)
-         result = XPC_ERROR_LEVEL_NONE;
-      if (strcmp(cmdswitch, CMD(_SILENT)) == 0)          /* XPC CUT option    */
-         result = XPC_ERROR_LEVEL_NONE;
-      else if (strcmp(cmdswitch, CMD(_DAEMON)) == 0)
-         result = XPC_ERROR_LEVEL_NONE;
-      else if (strcmp(cmdswitch, CMD(_ERROR)) == 0)
-         result = XPC_ERROR_LEVEL_ERRORS;
-      else if (strcmp(cmdswitch, CMD(_ERRORS)) == 0)
-         result = XPC_ERROR_LEVEL_ERRORS;
-      else if (strcmp(cmdswitch, CMD(_WARN)) == 0)
-         result = XPC_ERROR_LEVEL_WARNINGS;
-      else if (strcmp(cmdswitch, CMD(_WARNINGS)) == 0)
-         result = XPC_ERROR_LEVEL_WARNINGS;
-      else if (strcmp(cmdswitch, CMD(_INFO)) == 0)
-         result = XPC_ERROR_LEVEL_INFO;
-      else if (strcmp(cmdswitch, CMD(_INFORMATION)) == 0)
-         result = XPC_ERROR_LEVEL_INFO;
-      else if (strcmp(cmdswitch, CMD(_ALL)) == 0)
-         result = XPC_ERROR_LEVEL_ALL;
-      else if (strcmp(cmdswitch, CMD(_VERBOSE)) == 0)
-         result = XPC_ERROR_LEVEL_ALL;
-      else if (strcmp(cmdswitch, CMD(_SDEBUG)) == 0)
-#ifdef DEBUG
-         result = XPC_ERROR_LEVEL_INFO;
-#else
-         result = XPC_ERROR_LEVEL_ERRORS;
-#endif
+      size_t used = 0;
+      cbool_t ok;
+      va_list val;
+      va_start(val, fmt);
+      ok = format_buffer_vappend(&used, fmt, val);
+      va_end(val);
+      if (ok)
+         result = gs_Format_Buffer.m_Text;
+      else
+         format_buffer_release();
    }
    return result;
 }
 
 /******************************************************************************
- * xpc_errlevel_string()
+ * xpc_format_allocations()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the number of allocations made for the per-thread format
+ *    buffers used by the "ex", "strerr", and printf()-style logging
+ *    functions.
+ *
+ *    Once each logging thread has logged its longest message, this number
+ *    stops changing.  It is meant for unit-tests and for verifying that
+ *    the logging in a time-critical loop does not touch the heap.
+ *
+ * \return
+ *    Returns the number of calls to realloc() made for all threads since
+ *    the application started.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_21()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_format_allocations (void)
+{
+   return xpc_atomic_load_relaxed(&gs_Format_Allocations);
+}
+
+/******************************************************************************
+ * get_timestamp() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the current time for the time-stamp of a log line, less the
+ *    base time, if one was set.  The time comes from the clock selected by
+ *    xpc_timestamp_clock_set().
+ *
+ * \param seconds
+ *    Receives the seconds part of the time-stamp.
+ *
+ * \param nanoseconds
+ *    Receives the nanoseconds part of the time-stamp.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+get_timestamp (int * seconds, int * nanoseconds)
+{
+   uint64_t now = timestamp_now();
+   time_t sec = (time_t) (now / XPC_NS_PER_SECOND);
+   if (gs_TimeStamps_Base > 0)
+      sec -= gs_TimeStamps_Base;
+
+   *seconds = (int) sec;
+   *nanoseconds = (int) (now % XPC_NS_PER_SECOND);
+}
+
+/******************************************************************************
+ * gs_Log_Ring
+ *------------------------------------------------------------------------*//**
+ *
+ *    The memory-mapped ring file used as the log sink by the --log-ring
+ *    option, and the flag that selects it.  See xpc_open_logring().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc_logring_t gs_Log_Ring;
+static cbool_t gs_Log_Ring_Active = false;
+
+/******************************************************************************
+ * ring_logging_active() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Indicates that log lines go to the ring file.
+ *
+ * \return
+ *    Returns 'true' if xpc_open_logring() has selected the ring file.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+ring_logging_active (void)
+{
+   return xpc_atomic_load_relaxed(&gs_Log_Ring_Active);
+}
+
+/******************************************************************************
+ * ring_vprintf() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Converts an error-level code into an error-level string, without
- *    hyphens.
+ *    Renders a line into the per-thread format buffer, and appends it to
+ *    the ring file.
  *
- * \param errlev
- *    The error-level code to convert to a string.
+ * \param fmt
+ *    The format of the whole line, including the newline.
  *
- * \return
- *    A string that is the option switch representing the current
- *    error-level, minus the hyphens.
+ * \param val
+ *    The arguments for the format.
  *
- *    The "debug" string is impossible to return, since that string
- *    represents an "info" error level for a debug-enabled build.
+ * \return
+ *    Returns 'true' if the line was appended.  If the format buffer is
+ *    already in use (a nested logging call), 'false' is returned, and the
+ *    caller writes the line to the log file instead.
  *
  * \unittests
- *    -  errorlogging_test_02_11()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-const char *
-xpc_errlevel_string (xpc_errlevel_t errlev)
+static cbool_t
+ring_vprintf (const char * fmt, va_list val)
 {
-   const char * elstring = _("unknown");
-   switch (errlev)
+   cbool_t result = format_buffer_acquire();
+   if (result)
    {
-      case XPC_ERROR_LEVEL_ERRORS:
-
-         elstring = _(_ERRORS);
-         break;
-
-      case XPC_ERROR_LEVEL_WARNINGS:
-
-         elstring = _(_WARNINGS);
-         break;
-
-      case XPC_ERROR_LEVEL_INFO:
-
-         elstring = _(_INFO);
-         break;
-
-      case XPC_ERROR_LEVEL_ALL:
-
-         elstring = _(_VERBOSE);
-         break;
-
-      case XPC_ERROR_LEVEL_NONE:
-
-         elstring = _(_QUIET);
-         break;
-
-      case XPC_ERROR_LEVEL_NOT_APPLICABLE:
+      size_t used = 0;
+      result = format_buffer_vappend(&used, fmt, val);
+      if (result)
+      {
+         result = xpc_logring_append
+         (
+            &gs_Log_Ring, gs_Format_Buffer.m_Text, used
+         );
+      }
 
-         elstring = _(_NOT_APPLICABLE);
-         break;
+      format_buffer_release();
    }
-   return elstring;
+   return result;
 }
 
 /******************************************************************************
- * xpc_showerrlevel()
+ * ring_printf() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Displays the current debug level as an option string, with hyphens.
+ *    The variable-argument version of ring_vprintf().
  *
- *    The string is obtained by using xpc_errlevel() to get the current
- *    error-level, and then converting this level to a string using
- *    xpc_errlevel_string().
+ * \param fmt
+ *    The format of the whole line, including the newline.
  *
- *    This function shows the level regardless of what it is, except for the
- *    "none" level.
+ * \param ...
+ *    The arguments for the format.
+ *
+ * \return
+ *    Returns 'true' if the line was appended.
  *
  * \unittests
- *    -  errorlogging_test_02_12()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-void
-xpc_showerrlevel (void)
+static cbool_t
+ring_printf (const char * fmt, ...)
 {
-   xpc_errlevel_t level = xpc_errlevel();
-   if (level != XPC_ERROR_LEVEL_NONE)
-   {
-      const char * dbgstring = xpc_errlevel_string(level);
-      fprintf
-      (
-         xpc_logfile(), ERRL_FMT_EXT_MESSAGE,
-         xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO,
-         _("error level"), dbgstring
-      );
-   }
+   cbool_t result;
+   va_list val;
+   va_start(val, fmt);
+   result = ring_vprintf(fmt, val);
+   va_end(val);
+   return result;
 }
 
 /******************************************************************************
- * xpc_shownothing()
+ * xpc_open_logring()
  *------------------------------------------------------------------------*//**
  *
- *    Determines if the caller should not show any console messages of any
- *    kind.
+ *    Makes a memory-mapped ring file the destination of the error-log.
  *
- *    This error-level is set from the command line using the "--quiet"
- *    option switch.  The XPCCUT (unit-test) library's --silent option also
- *    causes this setting.
+ *    Each log line is copied into the ring (see the logring.h module),
+ *    which takes no system call and no lock, and survives a crash of the
+ *    application.  The ring has a fixed size; once it is full, the oldest
+ *    lines are overwritten.  The lines can be read with the logring_dump
+ *    program.
  *
- *    Only output done though the functions in the errorlogging module is
- *    amenable to the application of the error-level code.  The caller is
- *    perfectly free to print messages without regard to the error-level.
+ *    The ring takes precedence over the log file, but not over --syslog.
+ *    While the ring is in use, the --synch and --async-log options have no
+ *    effect, since they are not needed.
  *
- *    This function is the first of a family of error-level checking
- *    functions.  This small family of functions allows the caller to see if
- *    showing a message is permitted, based on the current error level.
+ *    This function is also reached with the "--log-ring file" option,
+ *    which uses a ring of XPC_LOGRING_DEFAULT_SIZE bytes.
+ *
+ * \param filename
+ *    The name of the ring file.  If it is already a ring file of the same
+ *    size, the new lines are added to the lines already in it.
+ *
+ * \param size
+ *    The number of bytes of log data the ring can hold.
  *
  * \return
- *    Returns 'true' if the error level is XPC_ERROR_LEVEL_NONE.
+ *    Returns 'true' if the ring file was opened.
  *
  * \unittests
- *    -  errorlogging_test_02_13()
+ *    -  errorlogging_test_02_25()
  *
- *---------------------------------------------------------------------------*/
+ *//*-------------------------------------------------------------------------*/
 
 cbool_t
-xpc_shownothing (void)
+xpc_open_logring (const char * filename, size_t size)
 {
-   return xpc_errlevel() == XPC_ERROR_LEVEL_NONE;
+   cbool_t result;
+   (void) xpc_close_logring();
+   result = xpc_logring_open(&gs_Log_Ring, filename, size);
+   if (result)
+   {
+      async_drain();                         /* queued lines go to the file   */
+      xpc_atomic_store(&gs_Log_Ring_Active, true);
+   }
+   return result;
 }
 
 /******************************************************************************
- * xpc_showerrors()
+ * xpc_close_logring()
  *------------------------------------------------------------------------*//**
  *
- *    Determines if the caller should show an error message.
+ *    Stops using the ring file, and unmaps it.  The log lines go to the log
+ *    file again.
  *
- *    An error message is one that causes some kind of inability to
- *    function.  Error messages are tagged by a "?" (question mark)
- *    character.
+ * \warning
+ *    No other thread may be logging when this function is called.
  *
- *    Error messages can be shown conditionally by using the
- *    "xpc_errprint" family of functions [xpc_errprint(),
- *    xpc_errprintex(), xpc_errprint_func(), which is a macro, and
- *    xpc_errprintf()].
+ * \return
+ *    Returns 'true' if a ring file was in use.
  *
- *    If these functions are not sufficient, or not desired, then
- *    xpc_showerrors() can be tested to decide on some other kind of
- *    error-display mechanism.
+ * \unittests
+ *    -  errorlogging_test_02_25()
  *
- *    Error messages are allowed by default.  The user can also supply the
- *    "--error" option switch on the command line.
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_close_logring (void)
+{
+   cbool_t result = ring_logging_active();
+   if (result)
+   {
+      xpc_atomic_store(&gs_Log_Ring_Active, false);
+      result = xpc_logring_close(&gs_Log_Ring);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_ring_logging()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Indicates that the error-log is going to a ring file.
  *
  * \return
- *    'true' if errors are allowed to be shown.  If not, then the caller
- *    means to show absolutely no output text (as in a daemon).
+ *    Returns 'true' if xpc_open_logring() is in force.
  *
  * \unittests
- *    -  errorlogging_test_02_13()
+ *    -  errorlogging_test_02_25()
  *
  *//*-------------------------------------------------------------------------*/
 
 cbool_t
-xpc_showerrors (void)
+xpc_ring_logging (void)
 {
-#ifdef XPC_NO_ERRORLOG
-   return false;
-#else
-   return xpc_errlevel() >= XPC_ERROR_LEVEL_ERRORS;
-#endif
+   return ring_logging_active();
 }
 
 /******************************************************************************
- * xpc_showwarnings ()
+ * binary_vprintf() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Determines if the caller should show a warning message.
- *
- *    A warning message is one that indicates an unexpected condition that
- *    is not erroneous.  Or it indicates a condition to which special
- *    attention should be paid by the user.  Warning messages are tagged by
- *    a "!" (exclamation point) character.
+ *    Captures a log line as a binary log record, and hands it to the sink
+ *    that formats it later: the ring file, or the writer thread.
  *
- *    Warning messages can be shown conditionally by using the
- *    "xpc_warnprint" family of functions [xpc_warnprint(),
- *    xpc_warnprintex(), xpc_warnprint_func(), which is a macro, and
- *    xpc_warnprintf()].
+ * \param tag
+ *    The tag of the line.
  *
- *    If these functions are not sufficient, or not desired, then
- *    xpc_showwarnings () can be tested to decide on some other kind of
- *    warning-display mechanism.
+ * \param fmt
+ *    The format of the message.
  *
- *    The user can supply the "--warn" option switch on the command line in
- *    order to enable the display of warnings.  The display of warnings is
- *    off by default.
+ * \param val
+ *    The arguments for the format.  They are copied, so that the caller
+ *    can still use them if this function fails.
  *
  * \return
- *    'true' if warnings and errors are allowed to be shown.
+ *    Returns 'true' if the record was handed off.  If --log-binary is not
+ *    in force, or the current sink cannot defer the formatting, or the
+ *    format cannot be deferred, 'false' is returned, and the caller
+ *    formats the line itself.
  *
  * \unittests
- *    -  errorlogging_test_02_13()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_showwarnings  (void)
+static cbool_t
+binary_vprintf (const char * tag, const char * fmt, va_list val)
 {
-   return xpc_errlevel() >= XPC_ERROR_LEVEL_WARNINGS;
+   cbool_t result = false;
+   cbool_t ring = ring_logging_active();
+   if (errlog_flag(XPC_ERRLOG_BINARY) && (ring || async_logging_active()))
+   {
+      char record[XPC_LOGRECORD_MAX_SIZE];
+      int stamp[2];
+      const int * timestamp = nullptr;
+      size_t length;
+      va_list valcopy;
+      if (xpc_timestamps())
+      {
+         get_timestamp(&stamp[0], &stamp[1]);
+         timestamp = stamp;
+      }
+      va_copy(valcopy, val);
+      length = xpc_logrecord_encode
+      (
+         record, sizeof record, tag, timestamp, fmt, valcopy
+      );
+      va_end(valcopy);
+      if (length > 0)
+      {
+         if (ring)
+            result = xpc_logring_append_binary(&gs_Log_Ring, record, length);
+         else
+            result = async_enqueue(record, length, true);
+      }
+   }
+   return result;
 }
 
 /******************************************************************************
- * xpc_showinfo()
+ * emit_line() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Determines if the caller should show an informational message.
- *
- *    An informational message is one that a user normally does not need to
- *    see.  However, if the user wants to verify the progress of the
- *    application more closely without debugging, the user can provide the
- *    "--info" switch on the command-line, and more messages will be shown.
- *    Informational messages are tagged with an "*" (asterisk).
- *
- *    Info messages can be shown conditionally by using the "xpc_infoprint"
- *    family of functions [xpc_infoprint(), xpc_infoprintex(),
- *    xpc_infoprint_func(), which is a macro, and xpc_infoprintf()].
+ *    Writes one fully-rendered line to the error-log.
  *
- *    If these functions are not sufficient, or not desired, then
- *    xpc_showinfo() can be tested to decide on some other kind of
- *    information-display mechanism.
+ *    If the ring file is in use, the line is appended to it.  If
+ *    asynchronous logging is on, the line is queued for the writer
+ *    thread.  Otherwise it is written with a single fwrite() call, inside
+ *    the --synch lock, so that lines from different threads cannot be
+ *    interleaved.  No flush is done here (except by synch_unlock()); the
+ *    buffering mode set by xpc_buffering_set() decides when the data
+ *    reaches the file.
  *
- *    The user can supply the "--info" option switch on the command line in
- *    order to enable the display of info.  The display of info is
- *    off by default.
+ * \param line
+ *    The line, including the newline.
  *
- * \return
- *    'true' if information, warnings, and errors can be shown.
+ * \param length
+ *    The length of the line.
  *
  * \unittests
- *    -  errorlogging_test_02_13()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_showinfo (void)
+static void
+emit_line (const char * line, size_t length)
 {
-   return xpc_errlevel() >= XPC_ERROR_LEVEL_INFO;
+   cbool_t queued = false;
+   if (ring_logging_active())                         /* --log-ring           */
+      queued = xpc_logring_append(&gs_Log_Ring, line, length);
+   else if (async_logging_active())                   /* --async-log          */
+   {
+      if (length <= XPC_ASYNC_LOG_SLOT_SIZE)
+         queued = async_enqueue(line, length, false);
+      else
+         async_drain();                               /* keep the order       */
+   }
+   if (! queued && synch_lock())                      /* --synch              */
+   {
+      (void) fwrite(line, 1, length, xpc_logfile());
+      synch_unlock();
+      log_written(length);
+   }
 }
 
 /******************************************************************************
- * xpc_showall()
+ * Rate limiting [static]
  *------------------------------------------------------------------------*//**
  *
- *    Determines if the caller can show all messages.
+ *    These items limit the number of lines that each call site can log per
+ *    second, so that a failure that repeats the same message in a tight
+ *    loop cannot swamp the log, nor the lock that protects it.
+ *
+ *    The call site is identified by the __FILE__ and __LINE__ of the call,
+ *    which the xpc_..._here() macros of errorlogging.h pass to the
+ *    xpc_..._site() functions.  So two calls that share a message, such as
+ *    two xpc_errprint_func(_("null pointer")) calls, are limited
+ *    separately.  A call to a plain function, such as xpc_errprintf(), is
+ *    identified by the address of its message or format string instead.
+ *
+ *    Each site gets a slot in a small open-addressed table.  A slot is
+ *    claimed with a compare-and-swap of its state, from free to claiming;
+ *    the claiming thread then fills in the key, the level, the tag, and
+ *    the start of the message, and publishes them by setting the state to
+ *    ready.  These fields never change afterward, so other threads read
+ *    them without further synchronization.  If the table is full, a new
+ *    site is simply not limited.
+ *
+ *    Each slot holds a token bucket, in the form of the "generic cell rate
+ *    algorithm":  a single 64-bit word holds the time at which the bucket
+ *    will be full again, and a line is admitted if that time is no more
+ *    than the burst size beyond now.  Admitting a line is thus one
+ *    compare-and-swap, and no lock is taken.
+ *
+ *    The lines that are dropped are counted.  When the site is next
+ *    admitted, a "last message repeated N times" line is logged ahead of
+ *    it, and xpc_ratelimit_report() logs the counts that are still
+ *    pending.  The totals are available from xpc_ratelimit_suppressed()
+ *    and xpc_ratelimit_suppressed_total().
+ *
+ *    The limiting is off by default.  See xpc_ratelimit_set().
  *
- *    The only ways to show such messages are to use print() [no other forms
- *    of this function are provided] or to wrap more conventional print
- *    functions [e.g. fprintf()] in a test of xpc_showall().
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_RATELIMIT_SITES      256         /* a power of 2                  */
+#define XPC_RATELIMIT_PROBES     8
+#define XPC_RATELIMIT_TEXT       64          /* site text in the summary      */
+
+#define XPC_RATELIMIT_FREE       0           /* slot states                   */
+#define XPC_RATELIMIT_CLAIMING   1
+#define XPC_RATELIMIT_READY      2
+
+typedef struct
+{
+   const void * m_Key;                 /**< __FILE__, or else the message.   */
+   int m_Line;                         /**< __LINE__, or 0 for a message.    */
+   const char * m_Message;             /**< The message or format string.    */
+
+} xpc_log_site_t;
+
+typedef struct
+{
+   int m_State;                        /**< Free, claiming, or ready.        */
+   xpc_log_site_t m_Site;              /**< The call site of the slot.       */
+   const char * m_Tag;                 /**< The tag of the site's lines.     */
+   xpc_errlevel_t m_Level;             /**< The level of the site's lines.   */
+   char m_Text[XPC_RATELIMIT_TEXT + 1];   /**< The start of the message.     */
+   uint64_t m_Full_Time;               /**< When the bucket is full again.   */
+   unsigned long m_Pending;            /**< Dropped since the last summary.  */
+   unsigned long m_Suppressed;         /**< Dropped in all.                  */
+
+} xpc_ratelimit_slot_t;
+
+static xpc_ratelimit_slot_t gs_Rate_Sites[XPC_RATELIMIT_SITES];
+static uint64_t gs_Rate_Interval = 0;
+static uint64_t gs_Rate_Burst = 0;
+static unsigned gs_Rate_Limit = 0;
+static unsigned long gs_Rate_Suppressed = 0;
+
+static void msgtag
+(
+   xpc_errlevel_t errlev,
+   const char * tag,
+   const char * errmsg,
+   const xpc_log_site_t * site
+);
+
+/******************************************************************************
+ * log_site_init() [static]
+ *------------------------------------------------------------------------*//**
  *
- *    The option switches "--verbose" or "--all" enable the showing of all
- *    messages.
+ *    Fills in the call site of a logging call.
  *
- * \return
- *    'true' if all messages and tested output can be shown.
+ * \param [out] site
+ *    Receives the call site.  Without a file, the message is the key.
+ *
+ * \param file
+ *    The __FILE__ of the call, as passed to an xpc_..._site() function, or
+ *    null for the plain logging functions.
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param message
+ *    The caller's message or format string.
  *
  * \unittests
- *    -  errorlogging_test_02_13()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_showall (void)
+static void
+log_site_init
+(
+   xpc_log_site_t * site,
+   const char * file,
+   int line,
+   const char * message
+)
 {
-   return xpc_errlevel() >= XPC_ERROR_LEVEL_ALL;
+   if (not_NULL(file))
+   {
+      site->m_Key = file;
+      site->m_Line = line;
+   }
+   else
+   {
+      site->m_Key = message;
+      site->m_Line = 0;
+   }
+   site->m_Message = message;
 }
 
 /******************************************************************************
- * xpc_showdebug()
+ * ratelimit_now() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Determines if the caller can show debug messages.
- *
- *    The option switch "--debug" enables this test, if the application is
- *    compiled for debugging.  Otherwise, the option is equivalent to
- *    "--error".
+ *    Reads the clock used for rate limiting.  A coarse monotonic clock is
+ *    good enough, and the cheapest to read.
  *
  * \return
- *    If compiled for debugging, this function acts like xpc_showinfo().
- *    Otherwise, it always returns false.
+ *    Returns a time in nanoseconds.
  *
  * \unittests
- *    -  errorlogging_test_02_13()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_showdebug (void)
+static uint64_t
+ratelimit_now (void)
 {
-#if defined DEBUG && ! defined XPC_NO_ERRORLOG
-   return xpc_showinfo();
+#ifdef XPC_TIMESTAMP_MONOTONIC
+   return monotonic_nanoseconds(XPC_TIMESTAMP_COARSE_ID);
 #else
-   return false;
+   return wall_nanoseconds();
 #endif
 }
 
 /******************************************************************************
- * xpc_showerr_version()
+ * ratelimit_slot() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Shows the approximate build time of this module.
+ *    Looks up the slot of a call site, optionally claiming a free slot for
+ *    it.
  *
- *    In addition to showing the build time, this function will indicate
- *    when the module is compiled for debugging (the DEBUG macro is
- *    defined), or when the XPC_NO_ERRORLOG macro is defined.
+ *    A slot being claimed by another thread is waited for, since it may
+ *    turn out to be the slot of the same site.  The claiming thread is
+ *    only a few stores away from publishing it.
  *
- *    This function is not all that useful, but leave it alone, it might
- *    come in handy once in a while.
+ * \param site
+ *    The call site.
+ *
+ * \param claim
+ *    If 'true', a free slot is claimed for a site that has none, with the
+ *    given level and tag.
+ *
+ * \param errlev
+ *    The error level of the site's lines.
+ *
+ * \param tag
+ *    The tag of the site's lines.
+ *
+ * \return
+ *    Returns the slot, or a null pointer if the site has no slot.
  *
  * \unittests
- *    -  errorlogging_test_02_14()
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-void
-xpc_showerr_version (void)
+static xpc_ratelimit_slot_t *
+ratelimit_slot
+(
+   const xpc_log_site_t * site,
+   cbool_t claim,
+   xpc_errlevel_t errlev,
+   const char * tag
+)
 {
-#ifdef DEBUG
-   xpc_infoprintf
+   xpc_ratelimit_slot_t * result = nullptr;
+   size_t index = (size_t)
    (
-      "%s: %s %s \n%s.\n",
-      _("Approximate build time"), __DATE__,  __TIME__,
-      _("Compiled with debugging information")
+      (((uintptr_t) site->m_Key >> 3) + (unsigned) site->m_Line) * 2654435761u
    );
-#else
-   xpc_infoprint(_("Release version"));
-#endif
+   int probe = 0;
+   while (probe < XPC_RATELIMIT_PROBES)
+   {
+      xpc_ratelimit_slot_t * slot =
+         &gs_Rate_Sites[index & (XPC_RATELIMIT_SITES - 1)];
 
-#ifdef XPC_NO_ERRORLOG
-   xpc_infoprint(_("Compiled with disabled error-logging functions."));
-#endif
+      int state = xpc_atomic_load(&slot->m_State);
+      if (state == XPC_RATELIMIT_READY)
+      {
+         if
+         (
+            slot->m_Site.m_Key == site->m_Key &&
+            slot->m_Site.m_Line == site->m_Line
+         )
+         {
+            result = slot;
+            break;
+         }
+         ++probe;
+         ++index;
+      }
+      else if (state == XPC_RATELIMIT_FREE)
+      {
+         if (! claim)
+            break;
+
+         if (xpc_atomic_cas(&slot->m_State, &state, XPC_RATELIMIT_CLAIMING))
+         {
+            slot->m_Site = *site;
+            slot->m_Level = errlev;
+            slot->m_Tag = tag;
+            (void) snprintf
+            (
+               slot->m_Text, sizeof slot->m_Text, "%s",
+               not_NULL(site->m_Message) ? site->m_Message : ""
+            );
+            xpc_atomic_store(&slot->m_State, XPC_RATELIMIT_READY);
+            result = slot;
+            break;
+         }
+         /* else another thread claimed it; look at the slot again */
+      }
+      /* else being claimed; look at the slot again */
+   }
+   return result;
 }
 
 /******************************************************************************
- * xpc_error_help()
+ * ratelimit_summary() [static]
  *------------------------------------------------------------------------*//**
  *
- *    This function emits a brief summary of the error options, as help
- *    text.  It is not static, just in case the caller wants to handle the
- *    --help option on its own.
+ *    Logs the number of lines of a call site that were dropped since its
+ *    last summary, if any.
  *
- *    Note that, although translation is allowed, the names of the options
- *    must currently always be in the English form.
+ * \param slot
+ *    The slot of the call site, which is ready.
  *
  * \unittests
- *    N/A.
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-void
-xpc_error_help (void)
+static void
+ratelimit_summary (xpc_ratelimit_slot_t * slot)
 {
-   static cbool_t g_xpc_error_help_done = false;
-   const char * const helptext =
-   M_(
-"Error-logging options:\n"
-"\n"
-"--quiet             Show no messages, not even errors.\n"
-"--silent            The same as --quiet; this option matches the --silent.\n"
-"                    option in the XPC unit-test library (libxpccut).\n"
-"--errors            Show error messages.\n"
-"--warnings          Show errors and warnings.\n"
-"--warn              Same as --warnings.\n"
-"--info              Show errors, warnings, and information.\n"
-"--verbose           Show all messages.\n"
-"--all               Same as --verbose.\n"
-"--stdout            Change the log file from stderr to stdout.\n"
-"--stderr            Use stderr as the log file [this is the default].\n"
-"--log file          Change the log file to the given file.  The file\n"
-"                    is truncated if it exists, erasing the previous\n"
-"                    contents.\n"
-"--append file       Same as --log, except that any existing file is\n"
-"                    appended, not replaced.\n"
-"                    ('stdout' and 'stderr' are valid filenames here.)\n"
-"--syslog            Redirect output to the system log.  Normally, this\n"
-"                    is needed only by daemons, which set it themselves\n"
-"                    indirectly in the xpc_daemonize() function.  [The\n"
-"                    default is --no-syslog.\n"
-"--no-syslog         Output the log to the normal place, stderr.\n"
-"--buffered          Buffer the output log.  Normally, stdout and files\n"
-"                    are already buffered, while, stderr is not.  Use\n"
-"                    this option if the log-printing functions cause a\n"
-"                    segmentation fault.\n"
-"--unbuffered        Make the output log unbuffered.\n"
-"--color             Write the tag characters (?!*>) in color [default].\n"
-"                    [Not supported in Windows].\n"
-"--mono              Write tag characters without color.  This option\n"
-"                    will avoid ANSI escape sequences in log files.\n"
-"--no-color          Synonym for --mono.  Also --nocolor and -nc.\n"
-"--timestamps        Enable adding time-stamps to the errorlogging output.\n"
-"--time-stamps       The time stamp goes between the tag character and the\n"
-"                    message, and has the format '[seconds.microseconds]'.\n"
-"--timestamps rebase The same as without 'rebase', but subtract the initial\n"
-"--time-stamps rebase time in seconds, to get an easier-to-grok number.\n"
-"--synch             Lock the output (to avoid intermixing of messages\n"
-"                    from different threads.) [The default is --no-synch].\n"
-"--no-synch          Do not synchronize the stderr output stream used for\n"
-"                    logging.\n"
-"--daemon            Same as quiet.  This option (if provided) is\n"
-"                    usually coded to cause operation as a daemon or\n"
-"                    a service.  Put other options before it to keep\n"
-"                    logging active, but be aware that stdout and stderr\n"
-"                    are closed in daemon mode.\n"
-"--help              Show this help banner.\n"
-"--version           Show basic version information.\n"
-"\n"
-   );
-   if (! g_xpc_error_help_done)
+   unsigned long pending = xpc_atomic_exchange(&slot->m_Pending, 0UL);
+   if (pending > 0)
    {
-      fprintf(stdout, "%s", helptext);
-      g_xpc_error_help_done = true;
+      char line[XPC_RATELIMIT_TEXT + 64];
+      (void) snprintf
+      (
+         line, sizeof line, _("last message repeated %lu times: %s"),
+         pending, slot->m_Text
+      );
+      msgtag(slot->m_Level, slot->m_Tag, line, nullptr);
    }
 }
 
 /******************************************************************************
- * xpc_application_help()
+ * ratelimit_admit() [static]
  *------------------------------------------------------------------------*//**
  *
- *    This function emits a brief summary of the error options, as help
- *    text.  It is not static, just in case the caller wants to handle the
- *    --help option on its own.
+ *    Decides if a line from a call site may be logged.  If it may, and
+ *    lines from the site were dropped, the summary of those lines is
+ *    logged first.
  *
- *    Note that, although translation is allowed, the names of the options
- *    must currently always be in the English form.
+ * \param errlev
+ *    The error level of the line.
  *
- * \param helptext
- *    Provides the help text to be printed.
+ * \param tag
+ *    The tag of the line.
+ *
+ * \param site
+ *    The call site.  If null, the line is always admitted.
+ *
+ * \return
+ *    Returns 'true' if the line is to be logged.
  *
  * \unittests
- *    N/A.
+ *    No direct unit-test possible in a static C function.
  *
  *//*-------------------------------------------------------------------------*/
 
-void
-xpc_application_help (const char * helptext)
+static cbool_t
+ratelimit_admit
+(
+   xpc_errlevel_t errlev,
+   const char * tag,
+   const xpc_log_site_t * site
+)
 {
-   fprintf(stdout, "%s", helptext);
-   fprintf(stdout, "\n");
+   cbool_t result = true;
+   uint64_t interval = xpc_atomic_load_relaxed(&gs_Rate_Interval);
+   if (interval > 0 && not_NULL(site))
+   {
+      xpc_ratelimit_slot_t * slot = ratelimit_slot(site, true, errlev, tag);
+      if (not_NULL(slot))
+      {
+         uint64_t now = ratelimit_now();
+         uint64_t burst = xpc_atomic_load_relaxed(&gs_Rate_Burst);
+         uint64_t full = xpc_atomic_load(&slot->m_Full_Time);
+         for (;;)
+         {
+            uint64_t next = (full > now ? full : now) + interval;
+            if (next - now > burst)
+            {
+               result = false;
+               break;
+            }
+            if (xpc_atomic_cas(&slot->m_Full_Time, &full, next))
+               break;
+         }
+         if (result)
+            ratelimit_summary(slot);
+         else
+         {
+            (void) xpc_atomic_add_relaxed(&slot->m_Pending, 1UL);
+            (void) xpc_atomic_add_relaxed(&slot->m_Suppressed, 1UL);
+            (void) xpc_atomic_add_relaxed(&gs_Rate_Suppressed, 1UL);
+         }
+      }
+   }
+   return result;
 }
 
 /******************************************************************************
- * gs_Log_to_Syslog [static]
+ * xpc_ratelimit_set()
  *------------------------------------------------------------------------*//**
  *
- *    Holds the state of the --syslog option.
+ *    Sets the number of lines per second that each call site can log.  See
+ *    the "Rate limiting" section of this module.
  *
- * \private
- *    This item is accessed for private usage, although it can be set from
- *    the command line or by using the xpc_syslogging_set() function.
+ *    This function is activated by the "--log-rate-limit rate[,burst]"
+ *    command-line option.
+ *
+ *    The counts of dropped lines are cleared.  The XPC_ERRLOG_RATELIMIT
+ *    bit is set while a limit is in force, so that the xpc_..._here()
+ *    macros pass their call site only when it is needed.
+ *
+ * \warning
+ *    Set the limit before other threads start logging.
+ *
+ * \param rate
+ *    The number of lines per second each call site may log, on average.
+ *    Zero turns the limiting off.
+ *
+ * \param burst
+ *    The number of lines a call site may log back-to-back, after a quiet
+ *    period.  Zero means the same as the rate (one second's worth).
+ *
+ * \return
+ *    Returns 'true' if the rate is less than a billion lines per second.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
  *
  *//*-------------------------------------------------------------------------*/
 
-static cbool_t gs_Log_to_Syslog = false;
+cbool_t
+xpc_ratelimit_set (unsigned rate, unsigned burst)
+{
+   cbool_t result = rate < XPC_NS_PER_SECOND;
+   if (result)
+   {
+      size_t s;
+      uint64_t interval = rate > 0 ? XPC_NS_PER_SECOND / rate : 0 ;
+      if (burst == 0)
+         burst = rate;
+
+      errlog_flag_set(XPC_ERRLOG_RATELIMIT, false);
+      xpc_atomic_store(&gs_Rate_Interval, (uint64_t) 0);
+      for (s = 0; s < XPC_RATELIMIT_SITES; s++)
+      {
+         xpc_ratelimit_slot_t * slot = &gs_Rate_Sites[s];
+         slot->m_Full_Time = 0;
+         slot->m_Pending = 0;
+         slot->m_Suppressed = 0;
+         xpc_atomic_store(&slot->m_State, XPC_RATELIMIT_FREE);
+      }
+      xpc_atomic_store(&gs_Rate_Suppressed, 0UL);
+      xpc_atomic_store(&gs_Rate_Burst, interval * burst);
+      xpc_atomic_store(&gs_Rate_Limit, rate);
+      xpc_atomic_store(&gs_Rate_Interval, interval);
+      errlog_flag_set(XPC_ERRLOG_RATELIMIT, interval > 0);
+   }
+   else
+      xpc_errprint_func(_("log rate limit too large"));
+
+   return result;
+}
 
 /******************************************************************************
- * xpc_syslogging_set()
+ * xpc_ratelimit()
  *------------------------------------------------------------------------*//**
  *
- *    Causes the error-log output to be directed to the system log.
+ *    Provides a getter for the rate set by xpc_ratelimit_set().
  *
- *    In a daemon, the standard output files are closed.  Therefore, we have
- *    to do one of the following:
+ * \return
+ *    Returns the number of lines per second allowed for each call site.
+ *    The default, 0, means there is no limit.
  *
- *       -# Disable error-logging.  This option can be performed by calling
- *          the xpc_errlevel_set() function.
- *       -# Redirect error-logging to a text file.  This option can be
- *          performed by calling the xpc_open_logfile() function.  The only
- *          issue is what name to give the file.
- *       -# Redirect error-logging to the syslog() facility.  This is
- *          probably the best option.  The error-levels are mapped onto the
- *          following system-log levels.
+ * \unittests
+ *    -  errorlogging_test_02_28()
  *
-\verbatim
-         Error-logging level           System-logging level
-         ===================           ====================
+ *//*-------------------------------------------------------------------------*/
 
-         XPC_ERROR_LEVEL_NONE          not applicable
-         not applicable                LOG_EMERG
-         not applicable                LOG_ALERT
-         not applicable                LOG_CRIT
-         XPC_ERROR_LEVEL_ERRORS        LOG_ERR
-         XPC_ERROR_LEVEL_WARNINGS      LOG_WARNING
-         not applicable                LOG_NOTICE
-         XPC_ERROR_LEVEL_INFO          LOG_INFO
-         XPC_ERROR_LEVEL_ALL           LOG_INFO
-         not applicable                LOG_DEBUG
-         XPC_ERROR_LEVEL_NOT_APPL...   not applicable
-\endverbatim
- *
- *    This function is called by xpc_daemonize() in the xpc_daemonize.c module.
+unsigned
+xpc_ratelimit (void)
+{
+   return xpc_atomic_load(&gs_Rate_Limit);
+}
+
+/******************************************************************************
+ * xpc_ratelimit_suppressed()
+ *------------------------------------------------------------------------*//**
  *
- *    The "--syslog" option can also be used, if you should so desire.
+ *    Provides the number of lines of one call site that were dropped by
+ *    the rate limit.
  *
- * \param flag
- *    The desired boolean setting for sys-logging.
+ * \param site
+ *    The message or format string of the call site.  This must be the same
+ *    address, not just the same text, as was passed to the logging
+ *    function.  For xpc_errprintex() and the like, it is the message, not
+ *    the label.  If several call sites share the string, their counts are
+ *    added together.
  *
  * \return
- *    Returns 'true' if the setting succeeded.
+ *    Returns the number of dropped lines since the last call to
+ *    xpc_ratelimit_set().  Zero is returned for an unknown site.
  *
  * \unittests
- *    -  errorlogging_test_02_15()
+ *    -  errorlogging_test_02_28()
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_syslogging_set (cbool_t flag)
+unsigned long
+xpc_ratelimit_suppressed (const char * site)
 {
-   gs_Log_to_Syslog = flag;               /* enable this option               */
-   return xpc_usecolor_set(false);        /* don't want colors in system log  */
+   unsigned long result = 0;
+   size_t s;
+   for (s = 0; s < XPC_RATELIMIT_SITES; s++)
+   {
+      xpc_ratelimit_slot_t * slot = &gs_Rate_Sites[s];
+      if
+      (
+         xpc_atomic_load(&slot->m_State) == XPC_RATELIMIT_READY &&
+         slot->m_Site.m_Message == site
+      )
+      {
+         result += xpc_atomic_load(&slot->m_Suppressed);
+      }
+   }
+   return result;
 }
 
 /******************************************************************************
- * xpc_syslogging()
+ * xpc_ratelimit_suppressed_total()
  *------------------------------------------------------------------------*//**
  *
- *    Obtains the current value of gs_Log_to_Syslog.
+ *    Provides the number of lines of all call sites that were dropped by
+ *    the rate limit.
  *
- *    This function is useful in unit-testing to save the current value for
- *    later restoration.
+ * \return
+ *    Returns the number of dropped lines since the last call to
+ *    xpc_ratelimit_set().
  *
  * \unittests
- *    -  errorlogging_test_02_15()
+ *    -  errorlogging_test_02_28()
  *
  *//*-------------------------------------------------------------------------*/
 
-cbool_t
-xpc_syslogging (void)
+unsigned long
+xpc_ratelimit_suppressed_total (void)
 {
-   return gs_Log_to_Syslog;
+   return xpc_atomic_load(&gs_Rate_Suppressed);
 }
 
 /******************************************************************************
- * xpc_get_priority()
+ * xpc_ratelimit_report()
  *------------------------------------------------------------------------*//**
  *
- *    Converts an error-level code into a UNIX syslog() priority value.
- *
-\verbatim
-          XPC_ERROR_LEVEL_NONE:           LOG_EMERG
-          XPC_ERROR_LEVEL_ERRORS:         LOG_ERR
-          XPC_ERROR_LEVEL_WARNINGS:       LOG_WARNING
-          XPC_ERROR_LEVEL_INFO:           LOG_INFO
-          XPC_ERROR_LEVEL_ALL:            LOG_INFO
-          XPC_ERROR_LEVEL_NOT_APPLICABLE: LOG_EMERG
-\endverbatim
- *
- *    This function is a helper for the msgtag() and va_tag() functions, but
- *    we've exposed it to support a C++ semi-wrapper class.
- *
- * \todo
- *    Support for Windows error priorities.  At present, the error-level
- *    value parameter is simply returned.
- *
- * \param errlev
- *    Error-level code to convert to a string.
- *
- * \return
- *    Returns the POSIX priority level the corresponds to the XPC
- *    error-level provided.  If there is no match, then -1 (POSIX_ERROR) is
- *    returned.
+ *    Logs a "last message repeated N times" line for each call site that
+ *    has dropped lines not yet reported.  Call it before closing the log,
+ *    so that the counts of sites that went quiet are not lost.
  *
  * \unittests
- *    No direct unit-test possible in a static C function.
+ *    -  errorlogging_test_02_28()
  *
  *//*-------------------------------------------------------------------------*/
 
-int
-xpc_get_priority (xpc_errlevel_t errlev)
+void
+xpc_ratelimit_report (void)
 {
-
-#ifdef POSIX
-
-   int priority = POSIX_ERROR;
-   switch (errlev)
+   size_t s;
+   for (s = 0; s < XPC_RATELIMIT_SITES; s++)
    {
-   case XPC_ERROR_LEVEL_NONE:           priority = LOG_EMERG;   break;
-   case XPC_ERROR_LEVEL_ERRORS:         priority = LOG_ERR;     break;
-   case XPC_ERROR_LEVEL_WARNINGS:       priority = LOG_WARNING; break;
-   case XPC_ERROR_LEVEL_INFO:           priority = LOG_INFO;    break;
-   case XPC_ERROR_LEVEL_ALL:            priority = LOG_INFO;    break;
-   case XPC_ERROR_LEVEL_NOT_APPLICABLE: priority = LOG_EMERG;   break;
+      xpc_ratelimit_slot_t * slot = &gs_Rate_Sites[s];
+      if (xpc_atomic_load(&slot->m_State) == XPC_RATELIMIT_READY)
+         ratelimit_summary(slot);
    }
-
-#else
-
-   int priority = (int) errlev;
-
-#endif
-
-   return priority;
 }
 
 /******************************************************************************
@@ -2338,8 +5137,9 @@ xpc_get_priority (xpc_errlevel_t errlev)
  *    look much better in a stream of output than do the long tags, which
  *    are words.
  *
- *    The message isn't written if the error level is set to
- *    XPC_ERROR_LEVEL_NONE.
+ *    The callers have already checked the error level, so it is not checked
+ *    again here.  The flags are read with a single load of
+ *    xpc_errlog_state.
  *
  * \param errlev
  *    The error level of the message.
@@ -2350,6 +5150,12 @@ xpc_get_priority (xpc_errlevel_t errlev)
  * \param errmsg
  *    The error or info message to be logged.
  *
+ * \param site
+ *    The call site, for rate limiting, as filled in by log_site_init()
+ *    from the caller's message (which differs from \a errmsg in the
+ *    functions that add a label).  It is null if the line is not to be
+ *    limited.
+ *
  * \todo
  *    Support for Windows Event Log.  For now, only the normal error-log is
  *    used for Win32 code.
@@ -2364,60 +5170,86 @@ msgtag
 (
    xpc_errlevel_t errlev,
    const char * tag,
-   const char * errmsg
+   const char * errmsg,
+   const xpc_log_site_t * site
 )
 {
-   if (xpc_errlevel() > XPC_ERROR_LEVEL_NONE)
-   {
-      if (is_nullptr(tag))                            /* programmer goofed    */
-         tag = _("programmer");
+   unsigned state = xpc_atomic_load_relaxed(&xpc_errlog_state);
+   if (is_nullptr(tag))                               /* programmer goofed    */
+      tag = _("programmer");
 
-      if (is_nullptr(errmsg))                         /* programmer goofed    */
-         errmsg = _("missing error message");
+   if (is_nullptr(errmsg))                            /* programmer goofed    */
+      errmsg = _("missing error message");
 
-      if (gs_Log_to_Syslog)
-      {
-         int priority = xpc_get_priority(errlev);
+   if (! ratelimit_admit(errlev, tag, site))          /* --log-rate-limit     */
+   {
+      /* the line is counted, not logged */
+   }
+   else if (state & XPC_ERRLOG_SYSLOG)
+   {
+      int priority = xpc_get_priority(errlev);
 
 #ifdef POSIX
-         syslog(priority, _(ERRL_FMT_BASIC_MESSAGE), tag, errmsg);
+      syslog(priority, _(ERRL_FMT_BASIC_MESSAGE), tag, errmsg);
 #else
-         fprintf
-         (
-            xpc_logfile(),
-            "%s %s (%s %s)\n",                  /* ERRL_FMT_PRIORITY_MESSAGE  */
-            tag, errmsg, _("priority"),
-            xpc_errlevel_string((xpc_errlevel_t) priority)
-         );
+      fprintf
+      (
+         xpc_logfile(),
+         "%s %s (%s %s)\n",                     /* ERRL_FMT_PRIORITY_MESSAGE  */
+         tag, errmsg, _("priority"),
+         xpc_errlevel_string((xpc_errlevel_t) priority)
+      );
 #endif
 
+   }
+   else if (state & XPC_ERRLOG_TIMESTAMPS)
+   {
+      int seconds, nanoseconds;
+      cbool_t queued = false;
+      get_timestamp(&seconds, &nanoseconds);
+      if (ring_logging_active())                      /* --log-ring           */
+      {
+         queued = ring_printf
+         (
+            ERRL_FMT_TIMESTAMP_MESSAGE, tag, seconds, nanoseconds, errmsg
+         );
       }
-      else
+      else if (async_logging_active())                /* --async-log          */
       {
-         if (synch_lock())                            /* --synch              */
-         {
-            if (xpc_timestamps())
-            {
-               time_t seconds;
-               suseconds_t microseconds;
-               struct timeval ts;
-               xpc_get_microseconds(&ts);
-               seconds = ts.tv_sec;
-               microseconds = ts.tv_usec;
-               if (gs_TimeStamps_Base > 0)
-                  seconds -= gs_TimeStamps_Base;
-
-               fprintf
-               (
-                  xpc_logfile(), ERRL_FMT_TIMESTAMP_MESSAGE, tag,
-                  (int) seconds, (int) microseconds, errmsg
-               );
-            }
-            else
-               fprintf(xpc_logfile(), ERRL_FMT_BASIC_MESSAGE, tag, errmsg);
+         queued = async_printf
+         (
+            ERRL_FMT_TIMESTAMP_MESSAGE, tag, seconds, nanoseconds, errmsg
+         );
+      }
+      if (! queued && synch_lock())                   /* --synch              */
+      {
+         int count = fprintf
+         (
+            xpc_logfile(), ERRL_FMT_TIMESTAMP_MESSAGE, tag,
+            seconds, nanoseconds, errmsg
+         );
+         synch_unlock();
+         if (count > 0)
+            log_written((size_t) count);
+      }
+   }
+   else
+   {
+      cbool_t queued = false;
+      if (ring_logging_active())                      /* --log-ring           */
+         queued = ring_printf(ERRL_FMT_BASIC_MESSAGE, tag, errmsg);
+      else if (async_logging_active())                /* --async-log          */
+         queued = async_printf(ERRL_FMT_BASIC_MESSAGE, tag, errmsg);
 
-            synch_unlock();
-         }
+      if (! queued && synch_lock())                   /* --synch              */
+      {
+         int count = fprintf
+         (
+            xpc_logfile(), ERRL_FMT_BASIC_MESSAGE, tag, errmsg
+         );
+         synch_unlock();
+         if (count > 0)
+            log_written((size_t) count);
       }
    }
 }
@@ -2431,6 +5263,11 @@ msgtag
  *    This function is relatively new.  It is like msgtag(), but it supports
  *    passing a format and a variable number of arguments.
  *
+ *    The tag, the optional time-stamp, the formatted message, and the
+ *    newline are rendered into the per-thread format buffer, and then
+ *    written by emit_line() as a single line.  Only if that buffer is
+ *    already in use (a nested logging call) is the line written in pieces.
+ *
  * \param errlev
  *    Error level of message, not used in Win32.
  *
@@ -2443,6 +5280,11 @@ msgtag
  * \param val
  *    Variable argument-list construct.
  *
+ * \param site
+ *    The call site, for rate limiting, as filled in by log_site_init()
+ *    from the caller's format (which differs from \a fmt in
+ *    xpc_infoprintml()).
+ *
  * \todo
  *    Support for Windows Event Log.  For now, only the normal error-log is
  *    used for Win32 code.
@@ -2462,16 +5304,17 @@ va_tag
    xpc_errlevel_t errlev,
    const char * tag,
    const char * fmt,
-   va_list val
+   va_list val,
+   const xpc_log_site_t * site
 )
 {
    if (xpc_errlevel() > XPC_ERROR_LEVEL_NONE)
    {
       if (is_nullptr(tag) || is_nullptr(fmt))         /* programmer goofed    */
          xpc_errprint_func(_("null tag or format"));
-      else
+      else if (ratelimit_admit(errlev, tag, site))    /* --log-rate-limit     */
       {
-         if (gs_Log_to_Syslog)
+         if (errlog_flag(XPC_ERRLOG_SYSLOG))
          {
 #ifdef POSIX
             int priority = xpc_get_priority(errlev);
@@ -2480,13 +5323,45 @@ va_tag
             vfprintf(xpc_logfile(), fmt, val);
 #endif
          }
-         else
+         else if (! binary_vprintf(tag, fmt, val))  /* --log-binary     */
          {
-            FILE * fp = xpc_logfile();
-            fprintf(fp, "%s ", tag);
-            vfprintf(fp, fmt, val);
-            fprintf(fp, "\n");                  /* consistent w/other calls   */
-            fflush(fp);
+            cbool_t rendered = format_buffer_acquire();
+            if (rendered)
+            {
+               size_t used = 0;
+               if (xpc_timestamps())
+               {
+                  int seconds, nanoseconds;
+                  get_timestamp(&seconds, &nanoseconds);
+                  rendered = format_buffer_append
+                  (
+                     &used, ERRL_FMT_TIMESTAMP_TAG, tag, seconds, nanoseconds
+                  );
+               }
+               else
+                  rendered = format_buffer_append(&used, ERRL_FMT_TAG, tag);
+
+               if (rendered)
+                  rendered = format_buffer_vappend(&used, fmt, val);
+
+               if (rendered)
+                  rendered = format_buffer_append(&used, "\n");
+
+               if (rendered)
+                  emit_line(gs_Format_Buffer.m_Text, used);
+
+               format_buffer_release();
+            }
+            if (! rendered && synch_lock())           /* buffer unavailable   */
+            {
+               FILE * fp = xpc_logfile();
+               int count = fprintf(fp, ERRL_FMT_TAG, tag);
+               count += vfprintf(fp, fmt, val);
+               count += fprintf(fp, "\n");      /* consistent w/other calls   */
+               synch_unlock();
+               if (count > 0)
+                  log_written((size_t) count);
+            }
          }
       }
    }
@@ -2548,7 +5423,7 @@ va_msgtag
                n = vsnprintf(p, size, fmt, val);
                if ((n > -1) && (n < size))            /* it worked            */
                {
-                  msgtag(errlev, tag, p);
+                  msgtag(errlev, tag, p, nullptr);
                   free(p);
                   break;
                }
@@ -2634,12 +5509,53 @@ xpc_no_op ()
 void
 xpc_errprint (const char * errmsg)
 {
+   xpc_errprint_site(nullptr, 0, errmsg);
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_errprint_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs a basic error message string, keyed for rate limiting on the given
+ *    call site.  It does the work of xpc_errprint(), and is called by the
+ *    xpc_errprint_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_errprint().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param errmsg
+ *    The error message string.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_errprint_site
+(
+   const char * file,
+   int line,
+   const char * errmsg
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, errmsg);
    if (xpc_showerrors())
    {
       msgtag
       (
          XPC_ERROR_LEVEL_ERRORS,
-         xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR, errmsg
+         xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR,
+         errmsg, &site
       );
    }
 }
@@ -2673,6 +5589,66 @@ xpc_errprint (const char * errmsg)
 void
 xpc_errprintf (const char * fmt, ...)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, fmt);
+   if (xpc_showerrors())
+   {
+      if (not_nullptr(fmt))
+      {
+         va_list val;
+         va_start(val, fmt);
+         va_tag
+         (
+            XPC_ERROR_LEVEL_ERRORS,
+            xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR,
+            fmt, val, &site
+         );
+         va_end(val);
+      }
+   }
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_errprintf_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs a printf()-formatted error message string, keyed for rate limiting on
+ *    the given call site.  It does the work of xpc_errprintf(), and is called
+ *    by the xpc_errprintf_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_errprintf().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param fmt
+ *    Provides the printf()-style format string.
+ *
+ * \param ...
+ *    List of parameters that match the format.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_errprintf_site
+(
+   const char * file,
+   int line,
+   const char * fmt,
+   ...
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, fmt);
    if (xpc_showerrors())
    {
       if (not_nullptr(fmt))
@@ -2683,7 +5659,7 @@ xpc_errprintf (const char * fmt, ...)
          (
             XPC_ERROR_LEVEL_ERRORS,
             xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR,
-            fmt, val
+            fmt, val, &site
          );
          va_end(val);
       }
@@ -2696,7 +5672,7 @@ xpc_errprintf (const char * fmt, ...)
  * concat_buffer() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Allocates a buffer for storage and concatenates two strings into it.
+ *    Concatenates two strings into the per-thread format buffer.
  *
  *    The first string parameter is the "message".  This will usually be an
  *    error, warning, or informational message.
@@ -2716,7 +5692,7 @@ xpc_errprintf (const char * fmt, ...)
  *    places in which to correct it!
  *
  * \private
- *    This function allocates a buffer for xpc_errprintex(),
+ *    This function fills the buffer for xpc_errprintex(),
  *    xpc_warnprintex(), and xpc_infoprintex().
  *
  * \warning
@@ -2730,7 +5706,9 @@ xpc_errprintf (const char * fmt, ...)
  *    A qualifier, often a file or function name.
  *
  * \return
- *    The address of the heap-allocated buffer is returned.
+ *    The address of the calling thread's format buffer is returned.  It
+ *    must be given back via free_concat_buffer().  If the buffer is not
+ *    available, a null pointer is returned.
  *
  * \unittests
  *    No direct unit-test possible in a static C function.
@@ -2740,55 +5718,38 @@ xpc_errprintf (const char * fmt, ...)
 static const char *
 concat_buffer (const char * msg, const char * label)
 {
-   const char * result = nullptr;
-   size_t length;                                     /* weird                */
    if (is_nullptr(msg))
       msg = _("missing error message");               /* programmer goofed    */
 
    if (is_nullptr(label))
       label = _("missing label");                     /* programmer goofed    */
 
-   length = strlen(msg) + strlen(label) + strlen(ERRL_STR_EXTRA);
-   if (length > 0)
+   if (xpc_usecolor())
    {
-      char * msgbuffer = malloc(length+32);           /* add slop             */
-      if (not_nullptr(msgbuffer))
-      {
-         if (xpc_usecolor())
-         {
-            strcpy(msgbuffer, COLOR_STR_LABEL_START); /* turn on the color    */
-            strcat(msgbuffer, label);                 /* object portion       */
-            strcat(msgbuffer, ERRL_STR_EXTRA);        /* ': '                 */
-            strcat(msgbuffer, COLOR_STR_END);         /* turn off color       */
-         }
-         else
-         {
-            strcpy(msgbuffer, label);                 /* object portion       */
-            strcat(msgbuffer, ERRL_STR_EXTRA);        /* ': '                 */
-         }
-         strcat(msgbuffer, msg);                      /* message portion      */
-         result = msgbuffer;                          /* object:  message     */
-      }
-      else                                            /* malloc() goofed      */
-         xpc_errprintex("malloc()", _("failed"));     /* NOT ..._printex()!!! */
+      return format_buffer_printf
+      (
+         COLOR_STR_LABEL_START "%s" ERRL_STR_EXTRA COLOR_STR_END "%s",
+         label, msg
+      );
    }
-   return result;
+   else
+      return format_buffer_printf("%s" ERRL_STR_EXTRA "%s", label, msg);
 }
 
 /******************************************************************************
  * free_concat_buffer() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Frees the buffer allocated by concat_buffer().
+ *    Releases the buffer filled by concat_buffer().
  *
- *    This function merely checks the pointer, and then deletes the memory
- *    it points to, if not null.
+ *    Nothing is freed; the per-thread format buffer is simply marked as
+ *    available for the next message.
  *
  * \param buffer
- *    A buffer allocated by concat_buffer().
+ *    A buffer returned by concat_buffer().
  *
  * \private
- *    This function frees a buffer created by xpc_errprintex(),
+ *    This function releases a buffer used by xpc_errprintex(),
  *    xpc_warnprintex(), or xpc_infoprintex().
  *
  * \unittests
@@ -2799,8 +5760,8 @@ concat_buffer (const char * msg, const char * label)
 static void
 free_concat_buffer (const char * buffer)
 {
-   if (not_nullptr(buffer))
-      free((void *) (char *) buffer);
+   if (not_NULL(buffer))
+      format_buffer_release();
 }
 
 /******************************************************************************
@@ -2810,8 +5771,8 @@ free_concat_buffer (const char * buffer)
  *    Logs a message consisting of a main string and secondary string.
  *
  *    This function assembles a message composed of two parts.  It
- *    allocates a generous buffer for the text, assembles the parts, and
- *    passes it to xpc_errprint().  To make it easier on the caller, if
+ *    assembles the parts in the per-thread format buffer, and passes it to
+ *    xpc_errprint().  To make it easier on the caller, if
  *    the second parameter is null, then xpc_errprint() is called.
  *
  *    This function is used in reporting both an error and some parameter
@@ -2841,58 +5802,144 @@ free_concat_buffer (const char * buffer)
 void
 xpc_errprintex (const char * errmsg, const char * label)
 {
+   xpc_errprintex_site(nullptr, 0, errmsg, label);
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_errprintex_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs an error message consisting of a main string and a secondary string,
+ *    keyed for rate limiting on the given call site.  It does the work of
+ *    xpc_errprintex(), and is called by the xpc_errprintex_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_errprintex().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param errmsg
+ *    The error message string.
+ *
+ * \param label
+ *    A qualifier, often a file or function name.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_errprintex_site
+(
+   const char * file,
+   int line,
+   const char * errmsg,
+   const char * label
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, errmsg);
    if (xpc_showerrors())                     // ca 2010-09-12 !!!
    {
+      const char * tag = xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR;
       if (not_nullptr(label))
       {
          const char * msgbuffer = concat_buffer(errmsg, label);
-         if (not_nullptr(msgbuffer))
+         if (test_nullptr(msgbuffer))
          {
-            xpc_errprint(msgbuffer);
+            msgtag(XPC_ERROR_LEVEL_ERRORS, tag, msgbuffer, &site);
             free_concat_buffer(msgbuffer);
          }
          else
-            xpc_errprint(errmsg);
+            msgtag(XPC_ERROR_LEVEL_ERRORS, tag, errmsg, &site);
       }
       else
-         xpc_errprint(errmsg);
+         msgtag(XPC_ERROR_LEVEL_ERRORS, tag, errmsg, &site);
    }
 }
 
 #endif   /* XPC_NO_ERRORLOG   */
 
 /******************************************************************************
- * xpc_warnprint()
+ * xpc_warnprint()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs a warning message.
+ *
+ *    Similar to xpc_errprint(), but presents a warning message instead.
+ *
+ *    This function is used in reporting an unexpected event or parameter
+ *    value that does not affect the application in any dire manner.
+ *
+ * \param warnmsg
+ *    The null-terminated warning message string.
+ *
+ * \unittests
+ *    -  errorlogging_test_01_01().  This test is a "smoke test".
+ *    -  Tests that check output to a log file could be written, but have
+ *       not yet.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_warnprint (const char * warnmsg)
+{
+   xpc_warnprint_site(nullptr, 0, warnmsg);
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_warnprint_site()
  *------------------------------------------------------------------------*//**
  *
- *    Logs a warning message.
+ *    Logs a warning message, keyed for rate limiting on the given call site.
+ *    It does the work of xpc_warnprint(), and is called by the
+ *    xpc_warnprint_here() macro.
  *
- *    Similar to xpc_errprint(), but presents a warning message instead.
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_warnprint().
  *
- *    This function is used in reporting an unexpected event or parameter
- *    value that does not affect the application in any dire manner.
+ * \param line
+ *    The __LINE__ of the call.
  *
  * \param warnmsg
- *    The null-terminated warning message string.
+ *    The warning message string.
  *
  * \unittests
- *    -  errorlogging_test_01_01().  This test is a "smoke test".
- *    -  Tests that check output to a log file could be written, but have
- *       not yet.
+ *    -  errorlogging_test_02_28()
  *
  *//*-------------------------------------------------------------------------*/
 
 #ifndef XPC_NO_ERRORLOG
 
 void
-xpc_warnprint (const char * warnmsg)
+xpc_warnprint_site
+(
+   const char * file,
+   int line,
+   const char * warnmsg
+)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, warnmsg);
    if (xpc_showwarnings())
    {
       msgtag
       (
          XPC_ERROR_LEVEL_WARNINGS,
-         xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN, warnmsg
+         xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN,
+         warnmsg, &site
       );
    }
 }
@@ -2926,6 +5973,66 @@ xpc_warnprint (const char * warnmsg)
 void
 xpc_warnprintf (const char * fmt, ...)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, fmt);
+   if (xpc_showwarnings())
+   {
+      if (not_nullptr(fmt))
+      {
+         va_list val;
+         va_start(val, fmt);
+         va_tag
+         (
+            XPC_ERROR_LEVEL_WARNINGS,
+            xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN,
+            fmt, val, &site
+         );
+         va_end(val);
+      }
+   }
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_warnprintf_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs a printf()-formatted warning message, keyed for rate limiting on the
+ *    given call site.  It does the work of xpc_warnprintf(), and is called by
+ *    the xpc_warnprintf_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_warnprintf().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param fmt
+ *    Provides the printf()-style format string.
+ *
+ * \param ...
+ *    List of parameters that match the format.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_warnprintf_site
+(
+   const char * file,
+   int line,
+   const char * fmt,
+   ...
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, fmt);
    if (xpc_showwarnings())
    {
       if (not_nullptr(fmt))
@@ -2936,7 +6043,7 @@ xpc_warnprintf (const char * fmt, ...)
          (
             XPC_ERROR_LEVEL_WARNINGS,
             xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN,
-            fmt, val
+            fmt, val, &site
          );
          va_end(val);
       }
@@ -2974,16 +6081,61 @@ xpc_warnprintf (const char * fmt, ...)
 void
 xpc_warnprintex (const char * warnmsg, const char * label)
 {
+   xpc_warnprintex_site(nullptr, 0, warnmsg, label);
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_warnprintex_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs a warning message consisting of a main message and a secondary
+ *    string, keyed for rate limiting on the given call site.  It does the work
+ *    of xpc_warnprintex(), and is called by the xpc_warnprintex_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_warnprintex().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param warnmsg
+ *    The warning message string.
+ *
+ * \param label
+ *    A qualifier, often a file or function name.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_warnprintex_site
+(
+   const char * file,
+   int line,
+   const char * warnmsg,
+   const char * label
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, warnmsg);
    if (xpc_showwarnings ())
    {
+      const char * tag = xpc_usecolor() ? COLOR_STR_WARN : ERRL_STR_WARN;
       const char * msgbuffer = concat_buffer(warnmsg, label);
-      if (not_nullptr(msgbuffer))
+      if (test_nullptr(msgbuffer))
       {
-         (void) xpc_warnprint(msgbuffer);
+         msgtag(XPC_ERROR_LEVEL_WARNINGS, tag, msgbuffer, &site);
          free_concat_buffer(msgbuffer);
       }
       else
-         xpc_warnprint(warnmsg);
+         msgtag(XPC_ERROR_LEVEL_WARNINGS, tag, warnmsg, &site);
    }
    else
       xpc_warnprint(warnmsg);
@@ -3015,12 +6167,53 @@ xpc_warnprintex (const char * warnmsg, const char * label)
 void
 xpc_infoprint (const char * infomsg)
 {
+   xpc_infoprint_site(nullptr, 0, infomsg);
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_infoprint_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs an informational message, keyed for rate limiting on the given call
+ *    site.  It does the work of xpc_infoprint(), and is called by the
+ *    xpc_infoprint_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_infoprint().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param infomsg
+ *    The info message string.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_infoprint_site
+(
+   const char * file,
+   int line,
+   const char * infomsg
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, infomsg);
    if (xpc_showinfo())
    {
       msgtag
       (
          XPC_ERROR_LEVEL_INFO,
-         xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO, infomsg
+         xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO,
+         infomsg, &site
       );
    }
 }
@@ -3065,6 +6258,66 @@ xpc_infoprint (const char * infomsg)
 void
 xpc_infoprintf (const char * fmt, ...)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, fmt);
+   if (xpc_showinfo())
+   {
+      if (not_nullptr(fmt))
+      {
+         va_list val;
+         va_start(val, fmt);
+         va_tag
+         (
+            XPC_ERROR_LEVEL_INFO,
+            xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO,
+            fmt, val, &site
+         );
+         va_end(val);
+      }
+   }
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_infoprintf_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs a printf()-formatted informational message, keyed for rate limiting
+ *    on the given call site.  It does the work of xpc_infoprintf(), and is
+ *    called by the xpc_infoprintf_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_infoprintf().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param fmt
+ *    Provides the printf()-style format string.
+ *
+ * \param ...
+ *    List of parameters that match the format.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_infoprintf_site
+(
+   const char * file,
+   int line,
+   const char * fmt,
+   ...
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, fmt);
    if (xpc_showinfo())
    {
       if (not_nullptr(fmt))
@@ -3074,7 +6327,8 @@ xpc_infoprintf (const char * fmt, ...)
          va_tag
          (
             XPC_ERROR_LEVEL_INFO,
-            xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO, fmt, val
+            xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO,
+            fmt, val, &site
          );
          va_end(val);
       }
@@ -3111,16 +6365,61 @@ xpc_infoprintf (const char * fmt, ...)
 void
 xpc_infoprintex (const char * infomsg, const char * label)
 {
+   xpc_infoprintex_site(nullptr, 0, infomsg, label);
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_infoprintex_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs an informational message consisting of a main message and a secondary
+ *    string, keyed for rate limiting on the given call site.  It does the work
+ *    of xpc_infoprintex(), and is called by the xpc_infoprintex_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_infoprintex().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param infomsg
+ *    The info message string.
+ *
+ * \param label
+ *    A qualifier, often a file or function name.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_infoprintex_site
+(
+   const char * file,
+   int line,
+   const char * infomsg,
+   const char * label
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, infomsg);
    if (xpc_showinfo())
    {
+      const char * tag = xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO;
       const char * msgbuffer = concat_buffer(infomsg, label);
-      if (not_nullptr(msgbuffer))
+      if (test_nullptr(msgbuffer))
       {
-         xpc_infoprint(msgbuffer);
+         msgtag(XPC_ERROR_LEVEL_INFO, tag, msgbuffer, &site);
          free_concat_buffer(msgbuffer);
       }
       else
-         xpc_infoprint(infomsg);
+         msgtag(XPC_ERROR_LEVEL_INFO, tag, infomsg, &site);
    }
    else
       xpc_infoprint(infomsg);
@@ -3317,6 +6616,72 @@ xpc_infomark_format (const char * fmt)
 void
 xpc_infoprintml (const char * fmt, ...)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, fmt);
+   if (xpc_showinfo())
+   {
+      if (not_nullptr(fmt))
+      {
+         const char * newfmt = xpc_infomark_format(fmt); /* rip a new one     */
+         if (not_nullptr(newfmt))
+         {
+            va_list val;
+            fmt = newfmt;                                /* see Note above    */
+            va_start(val, fmt);
+            va_tag
+            (
+               XPC_ERROR_LEVEL_INFO,
+               xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO,
+               fmt, val, &site
+            );
+            va_end(val);
+            free((char *) fmt);                          /* free() new one    */
+         }
+      }
+   }
+}
+
+#endif   /* XPC_NO_ERRORLOG   */
+
+/******************************************************************************
+ * xpc_infoprintml_site()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Logs a printf()-formatted informational message that spans multiple lines,
+ *    keyed for rate limiting on the given call site.  It does the work of
+ *    xpc_infoprintml(), and is called by the xpc_infoprintml_here() macro.
+ *
+ * \param file
+ *    The __FILE__ of the call.  If null, the message is the key, as for
+ *    xpc_infoprintml().
+ *
+ * \param line
+ *    The __LINE__ of the call.
+ *
+ * \param fmt
+ *    Provides the printf()-style format string.
+ *
+ * \param ...
+ *    List of parameters that match the format.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_28()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifndef XPC_NO_ERRORLOG
+
+void
+xpc_infoprintml_site
+(
+   const char * file,
+   int line,
+   const char * fmt,
+   ...
+)
+{
+   xpc_log_site_t site;
+   log_site_init(&site, file, line, fmt);
    if (xpc_showinfo())
    {
       if (not_nullptr(fmt))
@@ -3331,7 +6696,7 @@ xpc_infoprintml (const char * fmt, ...)
             (
                XPC_ERROR_LEVEL_INFO,
                xpc_usecolor() ? COLOR_STR_INFO : ERRL_STR_INFO,
-               fmt, val
+               fmt, val, &site
             );
             va_end(val);
             free((char *) fmt);                          /* free() new one    */
@@ -3372,17 +6737,22 @@ xpc_infoprintml (const char * fmt, ...)
  *
  *//*-------------------------------------------------------------------------*/
 
+#undef xpc_dbginfoprintf          /* the header's macro hides the function */
+
 #ifdef DEBUG                                             /* DEBUG             */
 
 void
 xpc_dbginfoprint (const char * infomsg)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, infomsg);
    if (xpc_showinfo())
    {
       msgtag
       (
          XPC_ERROR_LEVEL_INFO,
-         xpc_usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG, infomsg
+         xpc_usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG,
+         infomsg, &site
       );
    }
 }
@@ -3413,6 +6783,8 @@ xpc_dbginfoprint (const char * infomsg)
 void
 xpc_dbginfoprintf (const char * fmt, ...)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, fmt);
    if (xpc_showinfo())
    {
       if (not_nullptr(fmt))
@@ -3422,7 +6794,8 @@ xpc_dbginfoprintf (const char * fmt, ...)
          va_tag
          (
             XPC_ERROR_LEVEL_INFO,
-            xpc_usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG, fmt, val
+            xpc_usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG,
+            fmt, val, &site
          );
          va_end(val);
       }
@@ -3480,16 +6853,19 @@ xpc_print_debug (const char * infomsg)
 void
 xpc_dbginfoprintex (const char * infomsg, const char * label)
 {
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, infomsg);
    if (xpc_showinfo())
    {
+      const char * tag = xpc_usecolor() ? COLOR_STR_DEBUG : ERRL_STR_DEBUG;
       const char * msgbuffer = concat_buffer(infomsg, label);
-      if (not_nullptr(msgbuffer))
+      if (test_nullptr(msgbuffer))
       {
-         xpc_dbginfoprint(msgbuffer);
+         msgtag(XPC_ERROR_LEVEL_INFO, tag, msgbuffer, &site);
          free_concat_buffer(msgbuffer);
       }
       else
-         xpc_dbginfoprint(infomsg);
+         msgtag(XPC_ERROR_LEVEL_INFO, tag, infomsg, &site);
    }
    else
       xpc_dbginfoprint(infomsg);
@@ -3532,11 +6908,17 @@ xpc_dbginfoprintf (const char * fmt, ...)
 void
 xpc_print (const char * infomsg)
 {
-   msgtag
-   (
-      XPC_ERROR_LEVEL_INFO,
-      xpc_usecolor() ? COLOR_STR_PRINT : ERRL_STR_PRINT, infomsg
-   );
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, infomsg);
+   if (! xpc_shownothing())
+   {
+      msgtag
+      (
+         XPC_ERROR_LEVEL_INFO,
+         xpc_usecolor() ? COLOR_STR_PRINT : ERRL_STR_PRINT,
+         infomsg, &site
+      );
+   }
 }
 
 /******************************************************************************
@@ -3569,13 +6951,24 @@ xpc_lkprintf (const char * fmt, ...)
    if (not_nullptr(fmt))
    {
       va_list val;
-      va_start(val, fmt);
-      if (synch_lock())
+      cbool_t written = false;
+      async_drain();                         /* keep --async-log lines first  */
+      if (ring_logging_active())             /* --log-ring                    */
+      {
+         va_start(val, fmt);
+         written = ring_vprintf(fmt, val);
+         va_end(val);
+      }
+      if (! written && synch_lock())
       {
-         vfprintf(xpc_logfile(), fmt, val);
+         int count;
+         va_start(val, fmt);
+         count = vfprintf(xpc_logfile(), fmt, val);
+         va_end(val);
          synch_unlock();
+         if (count > 0)
+            log_written((size_t) count);
       }
-      va_end(val);
    }
 }
 
@@ -3623,44 +7016,40 @@ xpc_format_error_string
    const char * syserr
 )
 {
-   size_t length;
-   size_t seplen = strlen(ERRL_STR_SEPARATOR) + strlen(ERRL_STR_EXTRA);
-   cbool_t havesyserr = not_nullptr(syserr);
+   const char * msgbuffer;
+   xpc_log_site_t site;
+   log_site_init(&site, nullptr, 0, errmsg);
    if (is_nullptr(errmsg))
       errmsg = _("missing error message");
 
    if (is_nullptr(label))
       label = " ";
 
-   if (! havesyserr)
-      syserr = " ";
-
-   length = strlen(errmsg) + seplen + strlen(label) + strlen(syserr) + 2;
-   if (length > 0)
+   if (test_nullptr(syserr))
    {
-      char * msgbuffer = malloc(length + 32);                  /* add slop    */
-      if (not_nullptr(msgbuffer))
-      {
-         strcpy(msgbuffer, label);
-         strcat(msgbuffer, ERRL_STR_EXTRA);
-         strcat(msgbuffer, errmsg);
-         if (havesyserr)
-         {
-            strcat(msgbuffer, ERRL_STR_SEPARATOR);
-            strcat(msgbuffer, "(");
-            strcat(msgbuffer, syserr);
-            strcat(msgbuffer, ")");
-         }
-#ifndef XPC_NO_ERRORLOG
-         xpc_errprint(msgbuffer);
-#endif
-         free(msgbuffer);
-      }
+      msgbuffer = format_buffer_printf
+      (
+         "%s" ERRL_STR_EXTRA "%s" ERRL_STR_SEPARATOR "(%s)",
+         label, errmsg, syserr
+      );
+   }
+   else
+      msgbuffer = format_buffer_printf("%s" ERRL_STR_EXTRA "%s", label, errmsg);
+
 #ifndef XPC_NO_ERRORLOG
-      else
-         xpc_errprintex("malloc()", _("failed"));
-#endif
+   if (xpc_showerrors())
+   {
+      msgtag
+      (
+         XPC_ERROR_LEVEL_ERRORS,
+         xpc_usecolor() ? COLOR_STR_ERROR : ERRL_STR_ERROR,
+         test_nullptr(msgbuffer) ? msgbuffer : errmsg, &site
+      );
    }
+#endif
+
+   if (test_nullptr(msgbuffer))
+      format_buffer_release();
 }
 
 /******************************************************************************
@@ -4281,6 +7670,9 @@ xpc_buffering_set (int btype)
  *    This function simply passes the result of xpc_logfile() to the
  *    system call fflush().
  *
+ *    If asynchronous logging is on, this function first waits until the
+ *    writer thread has written every line queued before the call.
+ *
  * \unittests
  *    Not sure right now how one could test this reliably.  The stderr
  *    stream seems to flush after a relatively small amount of output (on
@@ -4291,6 +7683,7 @@ xpc_buffering_set (int btype)
 void
 xpc_flush_error_log (void)
 {
+   async_drain();                            /* --async-log lines first       */
    fflush(xpc_logfile());
 }
 
@@ -23,7 +23,12 @@
  *
  *//*-------------------------------------------------------------------------*/
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE              1     /* fallocate() and FALLOC_FL_KEEP_SIZE */
+#endif
+
 #include <ctype.h>                     /* toupper()                           */
+#include <errno.h>                     /* errno, ENOENT                       */
 #include <xpc/file_macros.h>           /* file_functions support macros       */
 #include <xpc/file_functions.h>        /* file utility module                 */
 #include <xpc/errorlogging.h>          /* errprint family of functions        */
@@ -1520,6 +1525,122 @@ xpc_file_handle_close (int filehandle, const char * filename)
    return result;
 }
 
+/******************************************************************************
+ * xpc_file_preallocate()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reserves disk blocks for an open file, without changing its size.
+ *
+ *    This function is meant for files that are written by appending, such
+ *    as the error-log.  Reserving the blocks up front means that the
+ *    appends do not have to allocate blocks (and update the file-system
+ *    metadata) as the file grows.  Because the file size is not changed,
+ *    appending still starts at the current end of the data.
+ *
+ * \gnu
+ *    Uses fallocate() with FALLOC_FL_KEEP_SIZE, if the configure script
+ *    found fallocate().  Not all file-systems support this call; a failure
+ *    is harmless, and is not logged.
+ *
+ * \win32
+ *    Not supported; the function does nothing.
+ *
+ * \param filehandle
+ *    Provides the open file.
+ *
+ * \param size
+ *    Provides the number of bytes to reserve, starting from the beginning
+ *    of the file.
+ *
+ * \return
+ *    Returns 'true' if the blocks were reserved.  Returns 'false' if the
+ *    parameters were bad, the call failed, or preallocation is not
+ *    supported.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_24()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_file_preallocate (FILE * filehandle, size_t size)
+{
+   cbool_t result = false;
+   if (not_NULL(filehandle) && (size > 0))
+   {
+#if XPC_HAVE_FALLOCATE
+      int rcode = fallocate
+      (
+         fileno(filehandle), FALLOC_FL_KEEP_SIZE, 0, (off_t) size
+      );
+      result = rcode == 0;
+#endif
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_file_rotate()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Renames a file and its numbered backups, in the manner of the
+ *    logrotate program.
+ *
+ *    The oldest backup, "filename.keep", is deleted.  Then each
+ *    "filename.n" is renamed to "filename.n+1", working from the oldest
+ *    backup to the newest.  Finally, "filename" is renamed to "filename.1".
+ *    Backups that do not exist are skipped.
+ *
+ *    Only renames are done, so the caller can keep writing to an open
+ *    handle of the file until it is ready to open the new file.
+ *
+ * \param filename
+ *    Provides the name of the file to rotate.
+ *
+ * \param keep
+ *    Provides the number of backups to keep.  If zero (or less), the file
+ *    is simply deleted.
+ *
+ * \return
+ *    Returns 'true' if the file was renamed (or deleted) successfully.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_24()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_file_rotate (const char * filename, int keep)
+{
+   cbool_t result = is_file_name_good(filename);
+   if (result)
+   {
+      if (keep > 0)
+      {
+         char oldname[F_MAX_PATH];
+         char newname[F_MAX_PATH];
+         int backup = keep;
+         (void) snprintf(newname, sizeof newname, "%s.%d", filename, backup);
+         (void) remove(newname);                /* the oldest backup goes  */
+         while (--backup > 0)
+         {
+            (void) snprintf(oldname, sizeof oldname, "%s.%d", filename, backup);
+            if (rename(oldname, newname) != 0 && errno != ENOENT)
+               (void) xpc_impl_file_error(oldname, __func__, errno);
+
+            (void) xpc_string_copy(newname, sizeof newname, oldname);
+         }
+         result = rename(filename, newname) == 0;
+      }
+      else
+         result = remove(filename) == 0;
+
+      if (! result)
+         (void) xpc_impl_file_error(filename, __func__, errno);
+   }
+   return result;
+}
+
 /******************************************************************************
  * End of file_functions.c
  *----------------------------------------------------------------------------
@@ -0,0 +1,333 @@
+/******************************************************************************
+ * histogram.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          histogram.c
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \date          2013-08-17
+ * \updates       2013-08-17
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a fixed-size latency histogram in the style of the HDR
+ *    histogram.
+ *
+ *    With S = XPC_HISTOGRAM_SUB_BITS, a value v below 2^(S+1) goes into
+ *    bucket v.  A larger value, whose highest set bit is bit e, is shifted
+ *    right by e - S, which leaves its top S + 1 bits, a number from 2^S
+ *    to 2^(S+1) - 1.  Each shift count gets 2^S buckets, one for each of
+ *    those numbers.  So each power of 2 is cut into 2^S equal slices, and
+ *    a bucket is never wider than 1/2^S of the values in it.
+ *
+ *    The counters are only ever written by the recording thread, with
+ *    relaxed atomic stores (not read-modify-writes), and read with
+ *    relaxed atomic loads, so that a merge from another thread reads
+ *    whole values.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/histogram.h>             /* xpc_histogram_t                     */
+#include <xpc/errorlogging.h>          /* macros and external functions       */
+#include <xpc/atomix.h>                /* xpc_atomic_load_relaxed(), etc.     */
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* memset()                            */
+#endif
+
+XPC_REVISION(histogram)
+
+/******************************************************************************
+ * HISTOGRAM_SUB_COUNT, HISTOGRAM_LIMIT
+ *------------------------------------------------------------------------*//**
+ *
+ *    The number of sub-buckets per power of 2, and the value at which
+ *    values stop being told apart.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define HISTOGRAM_SUB_COUNT   (1 << XPC_HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_LIMIT       (((uint64_t) 1) << XPC_HISTOGRAM_MAX_BITS)
+
+/******************************************************************************
+ * histogram_add() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds to a counter that only the calling thread writes.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+histogram_add (uint64_t * counter, uint64_t amount)
+{
+   xpc_atomic_store_relaxed(counter, xpc_atomic_load_relaxed(counter) + amount);
+}
+
+/******************************************************************************
+ * xpc_histogram_init()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Empties a histogram.  It can also be used to reset one, but not while
+ *    another thread is recording into it.
+ *
+ * \unittests
+ *    -  profiler_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_histogram_init
+(
+   xpc_histogram_t * h           /**< The histogram to empty.                 */
+)
+{
+   if (not_nullptr(h))
+   {
+      (void) memset(h, 0, sizeof(*h));
+      h->m_Min = UINT64_MAX;
+   }
+}
+
+/******************************************************************************
+ * xpc_histogram_index()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Finds the bucket of a value.  See the top of this module.
+ *
+ * \return
+ *    Returns the bucket index, from 0 to XPC_HISTOGRAM_BUCKETS - 1.
+ *
+ * \unittests
+ *    -  profiler_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_histogram_index
+(
+   uint64_t value                /**< The value to find the bucket of.        */
+)
+{
+   int result;
+   if (value >= HISTOGRAM_LIMIT)
+      value = HISTOGRAM_LIMIT - 1;
+
+   if (value < 2 * HISTOGRAM_SUB_COUNT)
+      result = (int) value;
+   else
+   {
+      int shift;
+#if defined __GNUC__
+      int top = 63 - __builtin_clzll(value);
+#else
+      int top = 0;
+      uint64_t v = value;
+      while ((v >>= 1) != 0)
+         ++top;
+#endif
+      shift = top - XPC_HISTOGRAM_SUB_BITS;
+      result = ((shift + 1) << XPC_HISTOGRAM_SUB_BITS) +
+         (int) (value >> shift) - HISTOGRAM_SUB_COUNT;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_histogram_highest_equivalent()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Finds the largest value that falls into a bucket.  This is the value
+ *    reported for a percentile, so that a percentile is never understated.
+ *
+ * \return
+ *    Returns the highest value counted by the bucket.
+ *
+ * \unittests
+ *    -  profiler_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint64_t
+xpc_histogram_highest_equivalent
+(
+   int index                     /**< The bucket index.                       */
+)
+{
+   uint64_t result;
+   if (index < 2 * HISTOGRAM_SUB_COUNT)
+      result = (uint64_t) index;
+   else
+   {
+      int shift = (index >> XPC_HISTOGRAM_SUB_BITS) - 1;
+      uint64_t top = HISTOGRAM_SUB_COUNT + (index & (HISTOGRAM_SUB_COUNT - 1));
+      result = ((top + 1) << shift) - 1;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_histogram_record()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Counts a value.  Only one thread may record into a given histogram.
+ *
+ * \unittests
+ *    -  profiler_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_histogram_record
+(
+   xpc_histogram_t * h,          /**< The histogram to record into.           */
+   uint64_t value                /**< The value, e.g. a time in nanoseconds.  */
+)
+{
+   histogram_add(&h->m_Buckets[xpc_histogram_index(value)], 1);
+   histogram_add(&h->m_Sum, value);
+   if (value < h->m_Min)
+      xpc_atomic_store_relaxed(&h->m_Min, value);
+
+   if (value > h->m_Max)
+      xpc_atomic_store_relaxed(&h->m_Max, value);
+
+   histogram_add(&h->m_Count, 1);
+}
+
+/******************************************************************************
+ * xpc_histogram_merge()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds the counts of one histogram to another.  The source may be
+ *    being recorded into by another thread at the same time; the
+ *    destination may not.
+ *
+ * \unittests
+ *    -  profiler_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_histogram_merge
+(
+   xpc_histogram_t * dest,       /**< The histogram to add to.                */
+   const xpc_histogram_t * source   /**< The histogram to add.                */
+)
+{
+   if (not_nullptr(dest) && not_nullptr(source))
+   {
+      uint64_t count = 0;
+      uint64_t value;
+      int b;
+      for (b = 0; b < XPC_HISTOGRAM_BUCKETS; ++b)
+      {
+         value = xpc_atomic_load_relaxed(&source->m_Buckets[b]);
+         dest->m_Buckets[b] += value;
+         count += value;
+      }
+      dest->m_Count += count;        /* matches the buckets we actually read */
+      dest->m_Sum += xpc_atomic_load_relaxed(&source->m_Sum);
+      value = xpc_atomic_load_relaxed(&source->m_Min);
+      if (value < dest->m_Min)
+         dest->m_Min = value;
+
+      value = xpc_atomic_load_relaxed(&source->m_Max);
+      if (value > dest->m_Max)
+         dest->m_Max = value;
+   }
+}
+
+/******************************************************************************
+ * xpc_histogram_percentile()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Finds the value below which the given percentage of the recorded
+ *    values fall, to within the precision of the buckets.
+ *
+ * \return
+ *    Returns the highest equivalent value of the bucket holding the
+ *    percentile, limited to the exact minimum and maximum.  Returns 0 for
+ *    an empty histogram.
+ *
+ * \unittests
+ *    -  profiler_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint64_t
+xpc_histogram_percentile
+(
+   const xpc_histogram_t * h,    /**< The histogram to read.                  */
+   double percent                /**< The percentile, from 0.0 to 100.0.      */
+)
+{
+   uint64_t result = 0;
+   if (not_nullptr(h) && h->m_Count > 0)
+   {
+      uint64_t wanted;
+      uint64_t seen = 0;
+      int b;
+      if (percent < 0.0)
+         percent = 0.0;
+      else if (percent > 100.0)
+         percent = 100.0;
+
+      wanted = (uint64_t) (percent / 100.0 * (double) h->m_Count + 0.5);
+      if (wanted == 0)
+         wanted = 1;
+
+      for (b = 0; b < XPC_HISTOGRAM_BUCKETS; ++b)
+      {
+         seen += h->m_Buckets[b];
+         if (seen >= wanted)
+         {
+            result = xpc_histogram_highest_equivalent(b);
+            break;
+         }
+      }
+      if (result > h->m_Max)
+         result = h->m_Max;
+
+      if (result < h->m_Min)
+         result = h->m_Min;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_histogram_mean()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the exact mean of the recorded values, or 0.0 if there are
+ *    none.
+ *
+ * \unittests
+ *    -  profiler_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+double
+xpc_histogram_mean
+(
+   const xpc_histogram_t * h     /**< The histogram to read.                  */
+)
+{
+   double result = 0.0;
+   if (not_nullptr(h) && h->m_Count > 0)
+      result = (double) h->m_Sum / (double) h->m_Count;
+
+   return result;
+}
+
+/******************************************************************************
+ * histogram.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
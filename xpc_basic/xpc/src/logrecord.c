@@ -0,0 +1,1026 @@
+/******************************************************************************
+ * logrecord.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          logrecord.c
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-11
+ * \updates       2013-08-11
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides the encoding and formatting of binary log records.  See the
+ *    logrecord.h module for the overview.
+ *
+ *    A record is a byte string laid out as follows.  No field is aligned,
+ *    so each is copied in and out with memcpy().
+ *
+ *       -  The header: the length of the whole record (16 bits), the flags
+ *          (8 bits), the number of arguments (8 bits), and the time-stamp
+ *          seconds and nanoseconds (32 bits each).
+ *       -  The tag: its length (8 bits), then the tag and its null.
+ *       -  The format: its length (16 bits), then the format and its null.
+ *       -  The arguments, in the order the format consumes them, each a
+ *          type byte followed by the value.  Integers are widened to 64
+ *          bits.  A string is its length (16 bits), then the string and
+ *          its null.
+ *
+ *    The formatting side walks the format again, copying the literal text,
+ *    and formatting each conversion by itself with snprintf(), with the
+ *    length modifier replaced by the one that matches the stored value.
+ *    Since the records may come from a file, every length read from a
+ *    record is checked.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* xpc_errprint() and other functions  */
+#include <xpc/errorlog_macros.h>       /* ERRL_FMT_TAG and other formats      */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/integers.h>              /* uint16_t and other types            */
+#include <xpc/logrecord.h>             /* xpc_logrecord_encode(), etc.        */
+XPC_REVISION(logrecord)
+
+#include <stddef.h>                    /* ptrdiff_t                           */
+#include <stdio.h>                     /* snprintf()                          */
+#include <stdlib.h>                    /* strtol()                            */
+#include <string.h>                    /* memcpy(), strchr(), and strlen()    */
+
+/******************************************************************************
+ * LOGRECORD_HEADER_SIZE
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the layout constants of a record.
+ *
+ *    -  LOGRECORD_HEADER_SIZE is the size of the fixed header.
+ *    -  LOGRECORD_TIMESTAMP is the flag set if the header holds a
+ *       time-stamp.
+ *    -  LOGRECORD_TAG_MAX is the longest tag (colored tags included).
+ *    -  LOGRECORD_SPEC_MAX is the longest conversion specification that
+ *       can be rebuilt.
+ *    -  The LOGARG_ values are the type bytes of the arguments.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define LOGRECORD_HEADER_SIZE       12
+#define LOGRECORD_TIMESTAMP         0x01
+#define LOGRECORD_TAG_MAX           63
+#define LOGRECORD_SPEC_MAX          32
+
+#define LOGARG_INT                  'i'
+#define LOGARG_UNSIGNED             'u'
+#define LOGARG_DOUBLE               'd'
+#define LOGARG_LONG_DOUBLE          'D'
+#define LOGARG_POINTER              'p'
+#define LOGARG_STRING               's'
+
+/******************************************************************************
+ * logrecord_length_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the length modifiers of a conversion specification.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef enum
+{
+   LOGRECORD_LENGTH_NONE,              /**< No modifier.                      */
+   LOGRECORD_LENGTH_HH,                /**< "hh", a char.                     */
+   LOGRECORD_LENGTH_H,                 /**< "h", a short.                     */
+   LOGRECORD_LENGTH_L,                 /**< "l", a long.                      */
+   LOGRECORD_LENGTH_LL,                /**< "ll" or "q", a long long.         */
+   LOGRECORD_LENGTH_J,                 /**< "j", an intmax_t.                 */
+   LOGRECORD_LENGTH_Z,                 /**< "z", a size_t.                    */
+   LOGRECORD_LENGTH_T,                 /**< "t", a ptrdiff_t.                 */
+   LOGRECORD_LENGTH_LONG_DOUBLE        /**< "L", a long double.               */
+
+} logrecord_length_t;
+
+/******************************************************************************
+ * logrecord_spec_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Holds the parts of one conversion specification of a format.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   const char * m_Start;               /**< The '%' character.                */
+   const char * m_Modifier;            /**< Start of the length modifier.     */
+   const char * m_End;                 /**< Just past the conversion.         */
+   cbool_t m_Width_Star;               /**< The width is an argument.         */
+   cbool_t m_Precision_Star;           /**< The precision is an argument.     */
+   int m_Precision;                    /**< A literal precision, or -1.       */
+   logrecord_length_t m_Length;        /**< The length modifier.              */
+   char m_Conversion;                  /**< The conversion character.         */
+
+} logrecord_spec_t;
+
+/******************************************************************************
+ * logrecord_buffer_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tracks the reading or writing of a record, or the writing of the
+ *    formatted text.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   char * m_Data;                      /**< The bytes; const when reading.    */
+   size_t m_Size;                      /**< The number of bytes available.    */
+   size_t m_Used;                      /**< The number of bytes processed.    */
+
+} logrecord_buffer_t;
+
+/******************************************************************************
+ * logrecord_parse() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Splits one conversion specification into its parts.
+ *
+ * \param start
+ *    The '%' that starts the specification.
+ *
+ * \param spec
+ *    The structure to fill in.
+ *
+ * \return
+ *    Returns 'true' if the specification can be deferred.  Positional
+ *    arguments, %n, and wide characters and strings cannot.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logrecord_parse (const char * start, logrecord_spec_t * spec)
+{
+   cbool_t result;
+   const char * p = start + 1;
+   memset(spec, 0, sizeof *spec);
+   spec->m_Start = start;
+   spec->m_Precision = -1;
+   while (*p != 0 && strchr("-+ #0'", *p) != nullptr)
+      ++p;
+
+   if (*p == '*')
+   {
+      spec->m_Width_Star = true;
+      ++p;
+   }
+   else
+   {
+      while (*p >= '0' && *p <= '9')
+         ++p;
+   }
+   if (*p == '.')
+   {
+      ++p;
+      if (*p == '*')
+      {
+         spec->m_Precision_Star = true;
+         ++p;
+      }
+      else
+      {
+         spec->m_Precision = (int) strtol(p, nullptr, 10);
+         while (*p >= '0' && *p <= '9')
+            ++p;
+      }
+   }
+   spec->m_Modifier = p;
+   switch (*p)
+   {
+   case 'h':
+      spec->m_Length = LOGRECORD_LENGTH_H;
+      if (*++p == 'h')
+      {
+         spec->m_Length = LOGRECORD_LENGTH_HH;
+         ++p;
+      }
+      break;
+
+   case 'l':
+      spec->m_Length = LOGRECORD_LENGTH_L;
+      if (*++p == 'l')
+      {
+         spec->m_Length = LOGRECORD_LENGTH_LL;
+         ++p;
+      }
+      break;
+
+   case 'q':   spec->m_Length = LOGRECORD_LENGTH_LL;           ++p;  break;
+   case 'j':   spec->m_Length = LOGRECORD_LENGTH_J;            ++p;  break;
+   case 'z':   spec->m_Length = LOGRECORD_LENGTH_Z;            ++p;  break;
+   case 't':   spec->m_Length = LOGRECORD_LENGTH_T;            ++p;  break;
+   case 'L':   spec->m_Length = LOGRECORD_LENGTH_LONG_DOUBLE;  ++p;  break;
+   default:                                                          break;
+   }
+   spec->m_Conversion = *p;
+   result = *p != 0 && strchr("diouxXcsp%eEfFgGaA", *p) != nullptr;
+   if (result)
+   {
+      spec->m_End = p + 1;
+      if (*p == 'c' || *p == 's')
+         result = spec->m_Length == LOGRECORD_LENGTH_NONE;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logrecord_put() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Copies bytes to the end of the record being built.
+ *
+ * \param record
+ *    The record being built.
+ *
+ * \param data
+ *    The bytes to add.
+ *
+ * \param count
+ *    The number of bytes to add.
+ *
+ * \return
+ *    Returns 'true' if the bytes fit.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logrecord_put (logrecord_buffer_t * record, const void * data, size_t count)
+{
+   cbool_t result = record->m_Used + count <= record->m_Size;
+   if (result)
+   {
+      memcpy(&record->m_Data[record->m_Used], data, count);
+      record->m_Used += count;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logrecord_put_value() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds a type byte and a value to the record being built.
+ *
+ * \param record
+ *    The record being built.
+ *
+ * \param type
+ *    One of the LOGARG_ values.
+ *
+ * \param data
+ *    The value.
+ *
+ * \param count
+ *    The size of the value.
+ *
+ * \return
+ *    Returns 'true' if the argument fits.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logrecord_put_value
+(
+   logrecord_buffer_t * record,
+   char type,
+   const void * data,
+   size_t count
+)
+{
+   return logrecord_put(record, &type, 1) && logrecord_put(record, data, count);
+}
+
+/******************************************************************************
+ * logrecord_put_string() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds a 16-bit length, the string, and its null, to the record being
+ *    built.
+ *
+ * \param record
+ *    The record being built.
+ *
+ * \param s
+ *    The string.
+ *
+ * \param length
+ *    The number of characters of the string to copy.
+ *
+ * \return
+ *    Returns 'true' if the string fits.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logrecord_put_string
+(
+   logrecord_buffer_t * record,
+   const char * s,
+   size_t length
+)
+{
+   cbool_t result = length < 0xFFFF;
+   if (result)
+   {
+      uint16_t count = (uint16_t) length;
+      result = logrecord_put(record, &count, sizeof count) &&
+         logrecord_put(record, s, length) && logrecord_put(record, "", 1);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_logrecord_encode()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Captures a log line as a binary record, without formatting it.
+ *
+ * \param record
+ *    The buffer to hold the record.
+ *
+ * \param size
+ *    The size of the buffer.  A record cannot exceed 64 KB.
+ *
+ * \param tag
+ *    The tag of the line (e.g. "?"), possibly with color escapes.
+ *
+ * \param timestamp
+ *    If not null, the seconds and nanoseconds of the time-stamp to show
+ *    in the line.
+ *
+ * \param fmt
+ *    The printf()-style format of the message.
+ *
+ * \param val
+ *    The arguments of the format.  The caller must not use them again,
+ *    but can use a va_copy() of them if this function fails.
+ *
+ * \return
+ *    Returns the length of the record.  Zero is returned if the format
+ *    cannot be deferred, or the record does not fit.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_26()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_logrecord_encode
+(
+   char * record,
+   size_t size,
+   const char * tag,
+   const int * timestamp,
+   const char * fmt,
+   va_list val
+)
+{
+   size_t result = 0;
+   if (not_nullptr_2(record, tag) && not_nullptr(fmt))
+   {
+      logrecord_buffer_t buffer;
+      size_t taglength = strlen(tag);
+      unsigned count = 0;
+      const char * p = fmt;
+      cbool_t ok = taglength <= LOGRECORD_TAG_MAX;
+      buffer.m_Data = record;
+      buffer.m_Size = (size > 0xFFFF) ? 0xFFFF : size;
+      buffer.m_Used = LOGRECORD_HEADER_SIZE;
+      if (ok)
+      {
+         uint8_t length = (uint8_t) taglength;
+         ok = logrecord_put(&buffer, &length, 1) &&
+            logrecord_put(&buffer, tag, taglength + 1);
+      }
+      if (ok)
+         ok = logrecord_put_string(&buffer, fmt, strlen(fmt));
+
+      while (ok && (p = strchr(p, '%')) != nullptr)
+      {
+         logrecord_spec_t spec;
+         int precision;
+         ok = logrecord_parse(p, &spec);
+         if (! ok)
+            break;
+
+         p = spec.m_End;
+         if (spec.m_Conversion == '%')
+            continue;
+
+         precision = spec.m_Precision;
+         if (spec.m_Width_Star)
+         {
+            long long width = va_arg(val, int);
+            ok = logrecord_put_value(&buffer, LOGARG_INT, &width, sizeof width);
+            ++count;
+         }
+         if (ok && spec.m_Precision_Star)
+         {
+            long long value = va_arg(val, int);
+            precision = (int) value;
+            ok = logrecord_put_value(&buffer, LOGARG_INT, &value, sizeof value);
+            ++count;
+         }
+         if (! ok)
+            break;
+
+         switch (spec.m_Conversion)
+         {
+         case 'd':
+         case 'i':
+         {
+            long long value;
+            switch (spec.m_Length)
+            {
+            case LOGRECORD_LENGTH_HH:
+               value = (signed char) va_arg(val, int);
+               break;
+
+            case LOGRECORD_LENGTH_H:
+               value = (short) va_arg(val, int);
+               break;
+
+            case LOGRECORD_LENGTH_L:
+               value = va_arg(val, long);
+               break;
+
+            case LOGRECORD_LENGTH_LL:
+               value = va_arg(val, long long);
+               break;
+
+            case LOGRECORD_LENGTH_J:
+               value = (long long) va_arg(val, intmax_t);
+               break;
+
+            case LOGRECORD_LENGTH_Z:
+            case LOGRECORD_LENGTH_T:
+               value = (long long) va_arg(val, ptrdiff_t);
+               break;
+
+            default:
+               value = va_arg(val, int);
+               break;
+            }
+            ok = logrecord_put_value(&buffer, LOGARG_INT, &value, sizeof value);
+            break;
+         }
+
+         case 'o':
+         case 'u':
+         case 'x':
+         case 'X':
+         {
+            unsigned long long value;
+            switch (spec.m_Length)
+            {
+            case LOGRECORD_LENGTH_HH:
+               value = (unsigned char) va_arg(val, unsigned);
+               break;
+
+            case LOGRECORD_LENGTH_H:
+               value = (unsigned short) va_arg(val, unsigned);
+               break;
+
+            case LOGRECORD_LENGTH_L:
+               value = va_arg(val, unsigned long);
+               break;
+
+            case LOGRECORD_LENGTH_LL:
+               value = va_arg(val, unsigned long long);
+               break;
+
+            case LOGRECORD_LENGTH_J:
+               value = (unsigned long long) va_arg(val, uintmax_t);
+               break;
+
+            case LOGRECORD_LENGTH_Z:
+            case LOGRECORD_LENGTH_T:
+               value = (unsigned long long) va_arg(val, size_t);
+               break;
+
+            default:
+               value = va_arg(val, unsigned);
+               break;
+            }
+            ok = logrecord_put_value
+            (
+               &buffer, LOGARG_UNSIGNED, &value, sizeof value
+            );
+            break;
+         }
+
+         case 'c':
+         {
+            long long value = va_arg(val, int);
+            ok = logrecord_put_value(&buffer, LOGARG_INT, &value, sizeof value);
+            break;
+         }
+
+         case 's':
+         {
+            const char * s = va_arg(val, const char *);
+            char type = LOGARG_STRING;
+            size_t length;
+            if (is_NULL(s))
+               s = "(null)";
+
+            if (precision >= 0)                       /* need not be null-   */
+            {                                         /* terminated          */
+               const char * end = memchr(s, 0, (size_t) precision);
+               length = is_NULL(end) ? (size_t) precision : (size_t) (end - s);
+            }
+            else
+               length = strlen(s);
+
+            ok = logrecord_put(&buffer, &type, 1) &&
+               logrecord_put_string(&buffer, s, length);
+            break;
+         }
+
+         case 'p':
+         {
+            uint64_t value = (uint64_t) (uintptr_t) va_arg(val, void *);
+            ok = logrecord_put_value
+            (
+               &buffer, LOGARG_POINTER, &value, sizeof value
+            );
+            break;
+         }
+
+         default:                                     /* floating-point      */
+            if (spec.m_Length == LOGRECORD_LENGTH_LONG_DOUBLE)
+            {
+               long double value = va_arg(val, long double);
+               ok = logrecord_put_value
+               (
+                  &buffer, LOGARG_LONG_DOUBLE, &value, sizeof value
+               );
+            }
+            else
+            {
+               double value = va_arg(val, double);
+               ok = logrecord_put_value
+               (
+                  &buffer, LOGARG_DOUBLE, &value, sizeof value
+               );
+            }
+            break;
+         }
+         ++count;
+         if (count > 0xFF)
+            ok = false;
+      }
+      if (ok)
+      {
+         uint16_t length = (uint16_t) buffer.m_Used;
+         uint8_t flags = is_NULL(timestamp) ? 0 : LOGRECORD_TIMESTAMP;
+         uint8_t argc = (uint8_t) count;
+         int32_t stamp[2] = { 0, 0 };
+         if (not_NULL(timestamp))
+         {
+            stamp[0] = (int32_t) timestamp[0];
+            stamp[1] = (int32_t) timestamp[1];
+         }
+         memcpy(&record[0], &length, sizeof length);
+         memcpy(&record[2], &flags, 1);
+         memcpy(&record[3], &argc, 1);
+         memcpy(&record[4], stamp, sizeof stamp);
+         result = buffer.m_Used;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logrecord_get() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Copies bytes from the record being read.
+ *
+ * \param record
+ *    The record being read.
+ *
+ * \param data
+ *    The destination of the bytes.
+ *
+ * \param count
+ *    The number of bytes to copy.
+ *
+ * \return
+ *    Returns 'true' if the record holds that many more bytes.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logrecord_get (logrecord_buffer_t * record, void * data, size_t count)
+{
+   cbool_t result = record->m_Used + count <= record->m_Size;
+   if (result)
+   {
+      memcpy(data, &record->m_Data[record->m_Used], count);
+      record->m_Used += count;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logrecord_get_value() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads a type byte and a value from the record being read.
+ *
+ * \param record
+ *    The record being read.
+ *
+ * \param type
+ *    The LOGARG_ value expected.
+ *
+ * \param data
+ *    The destination of the value.
+ *
+ * \param count
+ *    The size of the value.
+ *
+ * \return
+ *    Returns 'true' if the next argument has the expected type.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logrecord_get_value
+(
+   logrecord_buffer_t * record,
+   char type,
+   void * data,
+   size_t count
+)
+{
+   char actual = 0;
+   return logrecord_get(record, &actual, 1) && (actual == type) &&
+      logrecord_get(record, data, count);
+}
+
+/******************************************************************************
+ * logrecord_get_string() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Reads a string stored by logrecord_put_string().  The string is not
+ *    copied; a pointer into the record is returned.
+ *
+ * \param record
+ *    The record being read.
+ *
+ * \param s
+ *    Receives the string.
+ *
+ * \return
+ *    Returns 'true' if the string and its null are within the record.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logrecord_get_string (logrecord_buffer_t * record, const char ** s)
+{
+   uint16_t length;
+   cbool_t result = logrecord_get(record, &length, sizeof length);
+   if (result)
+   {
+      size_t offset = record->m_Used;
+      result = offset + length + 1 <= record->m_Size &&
+         record->m_Data[offset + length] == 0;
+
+      if (result)
+      {
+         *s = &record->m_Data[offset];
+         record->m_Used += (size_t) length + 1;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logrecord_printf() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Appends formatted text to the output, truncating it if the output is
+ *    full.
+ *
+ * \param text
+ *    The output.  One byte is always kept for the newline.
+ *
+ * \param fmt
+ *    The format of the text.
+ *
+ * \param ...
+ *    The arguments of the format.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+logrecord_printf (logrecord_buffer_t * text, const char * fmt, ...)
+{
+   size_t room = text->m_Size - text->m_Used - 1;
+   if (room > 0)
+   {
+      int length;
+      va_list val;
+      va_start(val, fmt);
+      length = vsnprintf(&text->m_Data[text->m_Used], room, fmt, val);
+      va_end(val);
+      if (length > 0)
+         text->m_Used += ((size_t) length < room) ? (size_t) length : room - 1;
+   }
+}
+
+/******************************************************************************
+ * LOGRECORD_EMIT()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Formats one value with the rebuilt specification, passing along the
+ *    width and precision arguments the specification asks for.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define LOGRECORD_EMIT(value) \
+   do { \
+      if (stars == 2) \
+         logrecord_printf(&output, rebuilt, star[0], star[1], value); \
+      else if (stars == 1) \
+         logrecord_printf(&output, rebuilt, star[0], value); \
+      else \
+         logrecord_printf(&output, rebuilt, value); \
+   } while (0)
+
+/******************************************************************************
+ * xpc_logrecord_format()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Formats a record made by xpc_logrecord_encode() into the line that
+ *    the error-log would have written: the tag, the optional time-stamp,
+ *    the message, and a newline.
+ *
+ * \param record
+ *    The record.
+ *
+ * \param length
+ *    The number of bytes available in the record.
+ *
+ * \param text
+ *    The destination of the line, which is null-terminated.
+ *
+ * \param size
+ *    The size of the destination.  A longer line is truncated, but still
+ *    ends with a newline.
+ *
+ * \return
+ *    Returns the length of the line.  Zero is returned if the record is
+ *    malformed.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_26()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_logrecord_format
+(
+   const char * record,
+   size_t length,
+   char * text,
+   size_t size
+)
+{
+   size_t result = 0;
+   if (not_nullptr_2(record, text) && size > 1)
+   {
+      logrecord_buffer_t input;
+      logrecord_buffer_t output;
+      uint16_t recordlength = 0;
+      uint8_t flags = 0;
+      uint8_t argc = 0;
+      uint8_t taglength = 0;
+      int32_t stamp[2];
+      const char * tag = nullptr;
+      const char * fmt = nullptr;
+      const char * p;
+      cbool_t ok;
+      input.m_Data = (char *) record;
+      input.m_Size = length;
+      input.m_Used = 0;
+      output.m_Data = text;
+      output.m_Size = size;
+      output.m_Used = 0;
+      ok = logrecord_get(&input, &recordlength, sizeof recordlength) &&
+         logrecord_get(&input, &flags, 1) && logrecord_get(&input, &argc, 1) &&
+         logrecord_get(&input, stamp, sizeof stamp);
+
+      if (ok)
+      {
+         ok = recordlength <= length;
+         input.m_Size = recordlength;
+      }
+      if (ok)
+      {
+         ok = logrecord_get(&input, &taglength, 1) &&
+            input.m_Used + taglength + 1 <= input.m_Size &&
+            record[input.m_Used + taglength] == 0;
+
+         if (ok)
+         {
+            tag = &record[input.m_Used];
+            input.m_Used += (size_t) taglength + 1;
+         }
+      }
+      if (ok)
+         ok = logrecord_get_string(&input, &fmt);
+
+      if (ok)
+      {
+         if (flags & LOGRECORD_TIMESTAMP)
+         {
+            logrecord_printf
+            (
+               &output, ERRL_FMT_TIMESTAMP_TAG, tag, (int) stamp[0],
+               (int) stamp[1]
+            );
+         }
+         else
+            logrecord_printf(&output, ERRL_FMT_TAG, tag);
+      }
+      p = fmt;
+      while (ok && *p != 0)
+      {
+         const char * percent = strchr(p, '%');
+         logrecord_spec_t spec;
+         char rebuilt[LOGRECORD_SPEC_MAX];
+         long long starvalue;
+         int star[2];
+         int stars = 0;
+         size_t prefix;
+         if (is_NULL(percent))
+         {
+            logrecord_printf(&output, "%s", p);
+            break;
+         }
+         if (percent > p)
+            logrecord_printf(&output, "%.*s", (int) (percent - p), p);
+
+         ok = logrecord_parse(percent, &spec);
+         if (! ok)
+            break;
+
+         p = spec.m_End;
+         if (spec.m_Conversion == '%')
+         {
+            logrecord_printf(&output, "%%");
+            continue;
+         }
+         if (spec.m_Width_Star)
+         {
+            ok = logrecord_get_value(&input, LOGARG_INT, &starvalue, 8);
+            star[stars++] = (int) starvalue;
+         }
+         if (ok && spec.m_Precision_Star)
+         {
+            ok = logrecord_get_value(&input, LOGARG_INT, &starvalue, 8);
+            star[stars++] = (int) starvalue;
+         }
+
+         prefix = (size_t) (spec.m_Modifier - spec.m_Start);
+         if (ok)
+            ok = prefix + 3 < sizeof rebuilt;
+
+         if (! ok)
+            break;
+
+         memcpy(rebuilt, spec.m_Start, prefix);
+         rebuilt[prefix] = 0;
+         switch (spec.m_Conversion)
+         {
+         case 'd':
+         case 'i':
+         case 'c':
+         {
+            long long value;
+            ok = logrecord_get_value(&input, LOGARG_INT, &value, sizeof value);
+            if (ok)
+            {
+               if (spec.m_Conversion == 'c')
+               {
+                  strcat(rebuilt, "c");
+                  LOGRECORD_EMIT((int) value);
+               }
+               else
+               {
+                  strcat(rebuilt, "ll");
+                  strncat(rebuilt, &spec.m_Conversion, 1);
+                  LOGRECORD_EMIT(value);
+               }
+            }
+            break;
+         }
+
+         case 'o':
+         case 'u':
+         case 'x':
+         case 'X':
+         {
+            unsigned long long value;
+            ok = logrecord_get_value
+            (
+               &input, LOGARG_UNSIGNED, &value, sizeof value
+            );
+            if (ok)
+            {
+               strcat(rebuilt, "ll");
+               strncat(rebuilt, &spec.m_Conversion, 1);
+               LOGRECORD_EMIT(value);
+            }
+            break;
+         }
+
+         case 's':
+         {
+            const char * s = nullptr;
+            char type = 0;
+            ok = logrecord_get(&input, &type, 1) && (type == LOGARG_STRING) &&
+               logrecord_get_string(&input, &s);
+
+            if (ok)
+            {
+               strcat(rebuilt, "s");
+               LOGRECORD_EMIT(s);
+            }
+            break;
+         }
+
+         case 'p':
+         {
+            uint64_t value;
+            ok = logrecord_get_value
+            (
+               &input, LOGARG_POINTER, &value, sizeof value
+            );
+            if (ok)
+            {
+               strcat(rebuilt, "p");
+               LOGRECORD_EMIT((void *) (uintptr_t) value);
+            }
+            break;
+         }
+
+         default:                                     /* floating-point      */
+            if (spec.m_Length == LOGRECORD_LENGTH_LONG_DOUBLE)
+            {
+               long double value;
+               ok = logrecord_get_value
+               (
+                  &input, LOGARG_LONG_DOUBLE, &value, sizeof value
+               );
+               if (ok)
+               {
+                  strcat(rebuilt, "L");
+                  strncat(rebuilt, &spec.m_Conversion, 1);
+                  LOGRECORD_EMIT(value);
+               }
+            }
+            else
+            {
+               double value;
+               ok = logrecord_get_value
+               (
+                  &input, LOGARG_DOUBLE, &value, sizeof value
+               );
+               if (ok)
+               {
+                  strncat(rebuilt, &spec.m_Conversion, 1);
+                  LOGRECORD_EMIT(value);
+               }
+            }
+            break;
+         }
+      }
+      if (ok)
+      {
+         text[output.m_Used++] = '\n';          /* room is always kept     */
+         text[output.m_Used] = 0;
+         result = output.m_Used;
+      }
+      else
+         text[0] = 0;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logrecord.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
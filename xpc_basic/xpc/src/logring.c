@@ -0,0 +1,644 @@
+/******************************************************************************
+ * logring.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          logring.c
+ * \library       xpc
+ * \author        Chris Ahlstrom
+ * \date          2013-08-10
+ * \updates       2013-08-11
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a memory-mapped, fixed-size, circular log file.  See the
+ *    logring.h module for the layout of the file.
+ *
+ *    Writers reserve space for a record by a compare-and-swap of the head
+ *    of the ring, then copy in the record, and mark it complete by storing
+ *    its magic number last.  Any number of threads (or processes sharing
+ *    the file) can append at the same time.
+ *
+ *    The reader, xpc_logring_walk(), is meant for decoding the ring after
+ *    the writer has stopped (for example, after a crash).  Since the start
+ *    of the oldest surviving record is not recorded anywhere, it scans
+ *    forward from the head for the first complete record.
+ *
+ * \win32
+ *    Not yet supported; it would need CreateFileMapping() and
+ *    MapViewOfFile().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* xpc_errprint() and other functions  */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/atomix.h>                /* xpc_atomic_cas(), etc.              */
+#include <xpc/logring.h>               /* xpc_logring_t and its functions     */
+#include <xpc/logrecord.h>             /* xpc_logrecord_format()              */
+XPC_REVISION(logring)
+
+#include <string.h>                    /* memcpy() and memset()               */
+
+#if ! defined _MSC_VER
+#include <errno.h>                     /* errno                               */
+#include <fcntl.h>                     /* open() and O_RDWR                   */
+#include <sys/mman.h>                  /* mmap() and munmap()                 */
+#include <sys/stat.h>                  /* fstat()                             */
+#include <unistd.h>                    /* close() and ftruncate()             */
+#endif
+
+/******************************************************************************
+ * logring_round() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Rounds a size up to the next multiple of XPC_LOGRING_ALIGN.
+ *
+ * \param size
+ *    The size to round.
+ *
+ * \return
+ *    Returns the rounded size.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static uint64_t
+logring_round (uint64_t size)
+{
+   return (size + XPC_LOGRING_ALIGN - 1) & ~((uint64_t) XPC_LOGRING_ALIGN - 1);
+}
+
+/******************************************************************************
+ * logring_header_good() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Checks the header of a mapped ring file against the size of the file.
+ *
+ * \param header
+ *    The mapped header.
+ *
+ * \param filesize
+ *    The size of the file.
+ *
+ * \return
+ *    Returns 'true' if the header is that of a ring file of this size.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logring_header_good (const xpc_logring_header_t * header, uint64_t filesize)
+{
+   return
+   (
+      (header->m_Magic == XPC_LOGRING_MAGIC) &&
+      (header->m_Version == XPC_LOGRING_VERSION) &&
+      (header->m_Size == logring_round(header->m_Size)) &&
+      (header->m_Size + XPC_LOGRING_HEADER_SIZE == filesize)
+   );
+}
+
+/******************************************************************************
+ * xpc_logring_open()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Opens a ring file for appending, creating it if necessary.
+ *
+ *    If the file already exists, and is a ring file of the requested size,
+ *    its records are kept, and new records are appended after them.  (So
+ *    the records from before a crash are still there after the program is
+ *    restarted.)  Otherwise, the file is truncated and set up as an empty
+ *    ring.
+ *
+ *    The disk space for the whole file is allocated up front, so that
+ *    writing to the mapping cannot fail (with a SIGBUS) on a full disk.
+ *
+ * \param ring
+ *    The handle to fill in.
+ *
+ * \param filename
+ *    The name of the ring file.
+ *
+ * \param size
+ *    The size of the data area, in bytes.  It is rounded up to a multiple
+ *    of XPC_LOGRING_ALIGN, and must be at least 1024 bytes.
+ *
+ * \return
+ *    Returns 'true' if the ring was opened.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_25()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_logring_open (xpc_logring_t * ring, const char * filename, size_t size)
+{
+   cbool_t result = not_nullptr_2(ring, filename);
+   if (result)
+   {
+      memset(ring, 0, sizeof *ring);
+      size = (size_t) logring_round(size);
+      result = size >= 1024;
+      if (! result)
+         xpc_errprint_func(_("ring size too small"));
+   }
+   if (result)
+   {
+#if defined _MSC_VER
+      xpc_errprint_func(_("not supported"));
+      result = false;
+#else
+      size_t mapsize = size + XPC_LOGRING_HEADER_SIZE;
+      cbool_t reuse = false;
+      struct stat info;
+      void * map = MAP_FAILED;
+      int fd = open(filename, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP);
+      result = fd != (-1);
+      if (result)
+      {
+         result = fstat(fd, &info) == 0;
+         if (result)
+            reuse = (size_t) info.st_size == mapsize;
+
+         if (result && ! reuse)
+         {
+            result =
+               ftruncate(fd, 0) == 0 && ftruncate(fd, (off_t) mapsize) == 0;
+         }
+         if (result)
+            result = posix_fallocate(fd, 0, (off_t) mapsize) == 0;
+
+         if (result)
+         {
+            map = mmap
+            (
+               NULL, mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0
+            );
+            result = map != MAP_FAILED;
+         }
+         (void) close(fd);                      /* the mapping stays valid */
+      }
+      if (result)
+      {
+         xpc_logring_header_t * header = (xpc_logring_header_t *) map;
+         if (reuse)
+            reuse = logring_header_good(header, mapsize);
+
+         if (! reuse)
+         {
+            memset(map, 0, mapsize);
+            header->m_Magic = XPC_LOGRING_MAGIC;
+            header->m_Version = XPC_LOGRING_VERSION;
+            header->m_Size = size;
+         }
+         ring->m_Header = header;
+         ring->m_Data = (char *) map + XPC_LOGRING_HEADER_SIZE;
+         ring->m_Map_Size = mapsize;
+      }
+      else
+      {
+         xpc_strerrnoprintex(_("cannot open ring file"), filename);
+         if (map != MAP_FAILED)
+            (void) munmap(map, mapsize);
+      }
+#endif
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_logring_map()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Opens an existing ring file for reading.
+ *
+ *    The ring is mapped read-only; it can be decoded with
+ *    xpc_logring_walk(), but not appended to.
+ *
+ * \param ring
+ *    The handle to fill in.
+ *
+ * \param filename
+ *    The name of the ring file.
+ *
+ * \return
+ *    Returns 'true' if the file was mapped and has a valid header.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_25()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_logring_map (xpc_logring_t * ring, const char * filename)
+{
+   cbool_t result = not_nullptr_2(ring, filename);
+   if (result)
+   {
+      memset(ring, 0, sizeof *ring);
+
+#if defined _MSC_VER
+      xpc_errprint_func(_("not supported"));
+      result = false;
+#else
+      struct stat info;
+      size_t mapsize = 0;
+      void * map = MAP_FAILED;
+      int fd = open(filename, O_RDONLY);
+      result = fd != (-1);
+      if (result)
+      {
+         result = fstat(fd, &info) == 0 &&
+            (size_t) info.st_size > XPC_LOGRING_HEADER_SIZE;
+
+         if (result)
+         {
+            mapsize = (size_t) info.st_size;
+            map = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+            result = map != MAP_FAILED;
+         }
+         (void) close(fd);
+      }
+      if (result)
+      {
+         result = logring_header_good((xpc_logring_header_t *) map, mapsize);
+         if (result)
+         {
+            ring->m_Header = (xpc_logring_header_t *) map;
+            ring->m_Data = (char *) map + XPC_LOGRING_HEADER_SIZE;
+            ring->m_Map_Size = mapsize;
+         }
+         else
+         {
+            xpc_errprintex(_("not a ring file"), filename);
+            (void) munmap(map, mapsize);
+         }
+      }
+      else
+         xpc_strerrnoprintex(_("cannot map ring file"), filename);
+#endif
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_logring_close()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Unmaps a ring file opened by xpc_logring_open() or xpc_logring_map().
+ *
+ *    The records are left in the file.  No thread may be appending to the
+ *    ring when it is closed.
+ *
+ * \param ring
+ *    The handle of the ring.  It is cleared.
+ *
+ * \return
+ *    Returns 'true' if the ring was open, and was unmapped.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_25()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_logring_close (xpc_logring_t * ring)
+{
+   cbool_t result = not_nullptr(ring);
+   if (result)
+   {
+      result = not_NULL(ring->m_Header);
+      if (result)
+      {
+#if ! defined _MSC_VER
+         result = munmap(ring->m_Header, ring->m_Map_Size) == 0;
+#endif
+         memset(ring, 0, sizeof *ring);
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logring_append() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Appends a record to the ring.
+ *
+ *    Space for the record is reserved by moving the head of the ring with
+ *    a compare-and-swap.  If the record does not fit before the end of the
+ *    data area, the gap is reserved too, and filled with a padding record,
+ *    and the record goes at the start of the data area.  The record is
+ *    then copied in, and its magic number is stored last, to mark it
+ *    complete.
+ *
+ * \param ring
+ *    The ring, opened by xpc_logring_open().
+ *
+ * \param data
+ *    The text or binary log record to append.
+ *
+ * \param length
+ *    The length of the data.  Text longer than a quarter of the ring (or
+ *    64 KB) is truncated; a binary record that long is refused.
+ *
+ * \param magic
+ *    XPC_LOGRING_RECORD_MAGIC or XPC_LOGRING_BINARY_MAGIC.
+ *
+ * \return
+ *    Returns 'true' if the ring is open, and the data was appended.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logring_append
+(
+   xpc_logring_t * ring,
+   const char * data,
+   size_t length,
+   uint16_t magic
+)
+{
+   cbool_t result = not_NULL(ring) && not_NULL(data);
+   if (result)
+      result = not_NULL(ring->m_Header);
+
+   if (result)
+   {
+      uint64_t size = ring->m_Header->m_Size;
+      uint64_t limit = size / 4 - sizeof(xpc_logring_record_t);
+      if (limit > 0xFFFF)
+         limit = 0xFFFF;
+
+      if (length > limit)
+      {
+         length = (size_t) limit;
+         result = magic != XPC_LOGRING_BINARY_MAGIC;   /* can't be cut    */
+      }
+   }
+   if (result)
+   {
+      xpc_logring_header_t * header = ring->m_Header;
+      xpc_logring_record_t * record;
+      uint64_t size = header->m_Size;
+      uint64_t head, offset, gap, need;
+      need = logring_round(sizeof(xpc_logring_record_t) + length);
+      head = xpc_atomic_load_relaxed(&header->m_Head);
+      do
+      {
+         offset = head % size;
+         gap = (offset + need > size) ? size - offset : 0;
+      } while (! xpc_atomic_cas(&header->m_Head, &head, head + gap + need));
+
+      if (gap > 0)
+      {
+         record = (xpc_logring_record_t *) &ring->m_Data[offset];
+         xpc_atomic_store_relaxed(&record->m_Magic, 0);
+         record->m_Text_Length = 0;
+         record->m_Length = (uint32_t) gap;
+         record->m_Sequence = 0;
+         xpc_atomic_store(&record->m_Magic, XPC_LOGRING_PAD_MAGIC);
+         offset = 0;
+      }
+      record = (xpc_logring_record_t *) &ring->m_Data[offset];
+      xpc_atomic_store_relaxed(&record->m_Magic, 0);
+      record->m_Text_Length = (uint16_t) length;
+      record->m_Length = (uint32_t) need;
+      record->m_Sequence = xpc_atomic_add_relaxed(&header->m_Sequence, 1);
+      memcpy(record + 1, data, length);
+      xpc_atomic_store(&record->m_Magic, magic);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_logring_append()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Appends a line to the ring.  See logring_append().
+ *
+ * \param ring
+ *    The ring, opened by xpc_logring_open().
+ *
+ * \param text
+ *    The line to append.  It need not be null-terminated.
+ *
+ * \param length
+ *    The length of the line.  A line longer than a quarter of the ring (or
+ *    64 KB) is truncated.
+ *
+ * \return
+ *    Returns 'true' if the ring is open, and the line was appended.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_25()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_logring_append (xpc_logring_t * ring, const char * text, size_t length)
+{
+   return logring_append(ring, text, length, XPC_LOGRING_RECORD_MAGIC);
+}
+
+/******************************************************************************
+ * xpc_logring_append_binary()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Appends a binary log record, made by xpc_logrecord_encode(), to the
+ *    ring.  It is formatted only when the ring is walked.
+ *
+ * \param ring
+ *    The ring, opened by xpc_logring_open().
+ *
+ * \param record
+ *    The binary log record.
+ *
+ * \param length
+ *    The length of the record.
+ *
+ * \return
+ *    Returns 'true' if the ring is open, and the record was appended.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_26()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_logring_append_binary
+(
+   xpc_logring_t * ring,
+   const char * record,
+   size_t length
+)
+{
+   return logring_append(ring, record, length, XPC_LOGRING_BINARY_MAGIC);
+}
+
+/******************************************************************************
+ * logring_walk_range() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Visits the complete records in one range of the data area.
+ *
+ *    Where a record is not complete (it was being written, or it is the
+ *    remains of a record that was partly overwritten), the walk moves
+ *    ahead by XPC_LOGRING_ALIGN bytes until it finds the next complete
+ *    record.
+ *
+ * \param ring
+ *    The ring to decode.
+ *
+ * \param begin
+ *    The offset at which to start.
+ *
+ * \param end
+ *    The offset at which to stop.  No record may extend beyond it.
+ *
+ * \param visitor
+ *    The function to call for each record.
+ *
+ * \param data
+ *    The caller's data, passed to the visitor.
+ *
+ * \param count
+ *    The number of records visited is added to this value.
+ *
+ * \return
+ *    Returns 'false' if the visitor stopped the walk.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+logring_walk_range
+(
+   const xpc_logring_t * ring,
+   uint64_t begin,
+   uint64_t end,
+   xpc_logring_visitor_t visitor,
+   void * data,
+   size_t * count
+)
+{
+   cbool_t result = true;
+   uint64_t offset = begin;
+   while (result && (offset + sizeof(xpc_logring_record_t) <= end))
+   {
+      const xpc_logring_record_t * record =
+         (const xpc_logring_record_t *) &ring->m_Data[offset];
+
+      uint16_t magic = xpc_atomic_load(&record->m_Magic);
+      cbool_t complete =
+      (
+         ((magic == XPC_LOGRING_RECORD_MAGIC) ||
+            (magic == XPC_LOGRING_BINARY_MAGIC) ||
+            (magic == XPC_LOGRING_PAD_MAGIC)) &&
+         (record->m_Length >= sizeof(xpc_logring_record_t)) &&
+         (record->m_Length == logring_round(record->m_Length)) &&
+         (offset + record->m_Length <= end) &&
+         (record->m_Text_Length <=
+            record->m_Length - sizeof(xpc_logring_record_t))
+      );
+      if (complete)
+      {
+         if (magic == XPC_LOGRING_RECORD_MAGIC)
+         {
+            ++*count;
+            result = visitor
+            (
+               record->m_Sequence, (const char *) (record + 1),
+               record->m_Text_Length, data
+            );
+         }
+         else if (magic == XPC_LOGRING_BINARY_MAGIC)
+         {
+            char text[XPC_LOGRECORD_TEXT_SIZE];
+            size_t length = xpc_logrecord_format
+            (
+               (const char *) (record + 1), record->m_Text_Length,
+               text, sizeof text
+            );
+            if (length > 0)                  /* else a damaged record      */
+            {
+               ++*count;
+               result = visitor(record->m_Sequence, text, length, data);
+            }
+         }
+         offset += record->m_Length;
+      }
+      else
+         offset += XPC_LOGRING_ALIGN;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_logring_walk()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Visits the complete records of a ring, from the oldest to the newest.
+ *
+ *    If the ring has not yet wrapped, the records run from the start of the
+ *    data area to the head.  Otherwise, the oldest records start somewhere
+ *    after the head (the record at the head was partly overwritten), and
+ *    run to the end of the data area, and the newest records run from the
+ *    start of the data area to the head.
+ *
+ * \param ring
+ *    The ring, opened by xpc_logring_open() or xpc_logring_map().
+ *
+ * \param visitor
+ *    The function to call for each record.
+ *
+ * \param data
+ *    The caller's data, passed to the visitor.
+ *
+ * \return
+ *    Returns the number of records visited.
+ *
+ * \unittests
+ *    -  errorlogging_test_02_25()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_logring_walk
+(
+   const xpc_logring_t * ring,
+   xpc_logring_visitor_t visitor,
+   void * data
+)
+{
+   size_t result = 0;
+   if
+   (
+      not_nullptr(ring) && (visitor != nullptr) &&
+      not_nullptr(ring->m_Header)
+   )
+   {
+      uint64_t size = ring->m_Header->m_Size;
+      uint64_t head = xpc_atomic_load(&ring->m_Header->m_Head);
+      if (head <= size)
+         (void) logring_walk_range(ring, 0, head, visitor, data, &result);
+      else
+      {
+         uint64_t offset = head % size;
+         if (logring_walk_range(ring, offset, size, visitor, data, &result))
+         {
+            (void) logring_walk_range
+            (
+               ring, 0, offset, visitor, data, &result
+            );
+         }
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * logring.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
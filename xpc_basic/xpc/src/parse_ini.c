@@ -52,67 +52,173 @@
 #endif
 
 /******************************************************************************
- * extract_section_name() [static]
+ * xpc_ini_arena_t [static]
  *------------------------------------------------------------------------*//**
  *
- *    Extracts the section name from a "[ section ]" construct, using the
- *    '[' character as a flag.
+ *    Provides the write position in the single block that
+ *    xpc_argv_from_INI_sections() allocates.  The block is laid out as
+ *    follows:
  *
- *    Ignores padding space after the '[' or before the ']'.
+\verbatim
+      argv[0 .. maxargs-1] | section flags | tokens | file text + null
+\endverbatim
  *
- * \warning
- *    This function truncates the source at 80 characters.  We demand that
- *    section names be reasonably short!
+ *    The argv[] array comes first, so that the argv pointer is also the
+ *    pointer to be freed.  Each token is written right after the previous
+ *    one, with its null terminator, and its argv[] slot is filled in at the
+ *    same time, so the tokens are never scanned a second time.
+ *
+ *    The sizes of the areas are worst cases, worked out from the file
+ *    size in xpc_argv_from_INI_sections().  append_token() checks them
+ *    anyway.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   char ** m_Argv;                     /**< The start of the block.           */
+   int m_Argc;                         /**< The number of argv[] slots used.  */
+   int m_Max_Args;                     /**< The slots, including the null.    */
+   char * m_Next;                      /**< Where the next token goes.        */
+   char * m_End;                       /**< The end of the token area.        */
+
+} xpc_ini_arena_t;
+
+/******************************************************************************
+ * append_token() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Appends an option name or option value to the arena, and adds it to
+ *    argv[].
+ *
+ * \param arena
+ *    The arena being filled.
+ *
+ * \param source
+ *    Provides a pointer to the token.  It need not be null-terminated.
+ *
+ * \param length
+ *    The number of characters in the token.
+ *
+ * \param isoption
+ *    The caller sets this value to 'true' if this token is an option name
+ *    (as opposed to an option value).  An option name gets the standard
+ *    option marker '--' prepended to it, so that it will look like an
+ *    option the user provided on the command-line.
+ *
+ * \return
+ *    Returns 'true' if the token fit in the arena.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+append_token
+(
+   xpc_ini_arena_t * arena,
+   const char * source,
+   size_t length,
+   cbool_t isoption
+)
+{
+   size_t needed = length + (isoption ? 3 : 1);
+   cbool_t result =
+   (
+      (arena->m_Argc < arena->m_Max_Args - 1) &&
+      (needed <= (size_t) (arena->m_End - arena->m_Next))
+   );
+   if (result)
+   {
+      char * destination = arena->m_Next;
+      arena->m_Argv[arena->m_Argc++] = destination;
+      if (isoption)
+      {
+         *destination++ = '-';
+         *destination++ = '-';
+      }
+      (void) memcpy(destination, source, length);
+      destination[length] = 0;
+      arena->m_Next = destination + length + 1;
+   }
+   else
+      xpc_errprint_func(_("argv buffer overflow"));
+
+   return result;
+}
+
+/******************************************************************************
+ * skip_white() [static]
+ *------------------------------------------------------------------------*//**
  *
- * \threadunsafe
- *    For now, this function holds the results in an internal buffer, and is
- *    not threadsafe.  We'll fix this issue at some point.
+ *    Skips the leading white space of a line.
  *
  * \param source
- *    The line of text to check.
+ *    A null-terminated line of text.
  *
  * \return
- *    Returns a pointer to the section name, ready to check against and use.
- *    If there is no '[' and ']' marker, then section name is considered not
- *    to exist, and a null pointer is returned.
+ *    Returns a pointer to the first character that is not a space or a
+ *    control character, which is the null terminator if there is none.
  *
  *//*-------------------------------------------------------------------------*/
 
 static const char *
-extract_section_name (const char * source)
+skip_white (const char * source)
 {
-   static char buffer[80];
-   const char * result = nullptr;
-   char * resultptr = &buffer[0];
-   while (*source == ' ')
+   while ((*source != 0) && ((unsigned char) *source <= ' '))
       source++;
 
+   return source;
+}
+
+/******************************************************************************
+ * extract_section_name() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Finds the section name in a "[ section ]" line, ignoring padding space
+ *    after the '[' or before the ']'.
+ *
+ *    The name is not copied, so section names can be of any length.
+ *
+ * \param source
+ *    The null-terminated line of text to check.
+ *
+ * \param [out] name
+ *    Receives a pointer to the first character of the name.
+ *
+ * \param [out] length
+ *    Receives the length of the name.
+ *
+ * \return
+ *    Returns 'true' if the line is a section marker.  If there is no '['
+ *    and ']', or nothing between them, then the line is not one.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+extract_section_name
+(
+   const char * source,
+   const char ** name,
+   size_t * length
+)
+{
+   cbool_t result = false;
+   source = skip_white(source);
    if (*source == '[')
    {
-      (void) memset(buffer, 0, 80);             /* clear out old junk         */
-      *resultptr++ = *source++;                 /* copy the '[' flag          */
-      while (*source == ' ')
-         source++;
-
-      if (not_null_result(strchr(source, ']')))
+      const char * close;
+      source = skip_white(source + 1);
+      close = strchr(source, ']');
+      if (not_null_result(close))
       {
-         while ((*source >= ' ') && (*source != ']'))
-            *resultptr++ = *source++;
+         while ((close > source) && ((unsigned char) close[-1] <= ' '))
+            close--;
 
-         if (resultptr[-1] == ' ')
+         if (close > source)
          {
-            resultptr--;
-            while (*resultptr == ' ')
-               *resultptr-- = 0;
+            *name = source;
+            *length = (size_t) (close - source);
+            result = true;
          }
-         if (strlen(buffer) > 1)                /* more than just '['         */
-            result = &buffer[0];
-
-         /*
-          * For debugging only.
-          *
-          * fprintf(stdout, "extract_section_name() = %s\n", result);
-          */
       }
    }
    return result;
@@ -122,114 +228,57 @@ extract_section_name (const char * source)
  * get_ini_option() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Returns a pointer to the first token in the provided string,
- *    terminated by a null.
- *
- *    This function accepts a line of text read from an INI-style
- *    configuration file, parses it to find the first token in the text, and
- *    then null-terminates the string.  The result is the variable name that
- *    is provided on the INI line.
- *
- *    The standard shell script comment character ('#') terminates the
- *    string, if present.
- *
- *    The standard INI script comment character (';') also terminates the
- *    string, if present.
- *
- *    If the first non-white-space character is an open-bracket ("["), then
- *    the line is assumed to contain a section group name (e.g. "[Test]"),
- *    and the result that is returned is of the form:
+ *    Finds the option name, the first token on a line of an INI-style
+ *    configuration file.
  *
- *          [sectionname
+ *    The option-name can consist of any characters except the space (or
+ *    other non-printing characters), '=', ';', and '#'.  However, it is
+ *    best to stick with alphanumeric characters and the underscore, in most
+ *    scenarios.
  *
  * \private
  *    This routine is a static, internal C function and a helper function.
  *
- * \param sourcedest
- *    Must point to a string of the form
+ * \param source
+ *    Must point to a null-terminated line of the form
  *
  *          optionname [ = optionvalue ]
  *
- *    where 'optionname' is a short alphanumeric token, and 'optionvalue' is
- *    a short string.  There may or may not be spaces before or after the
- *    equals sign.  They are ignored.
+ *    There may or may not be spaces before or after the equals sign.  They
+ *    are ignored.
  *
- *    The option-name can consist of any characters except the space (or
- *    other non-printing characters, '=', ';', and '#'.  However, it is best
- *    to stick with alphanumeric characters and the underscore, in most
- *    scenarios.
+ * \param [out] option
+ *    Receives a pointer to the first character of the option name.
  *
  * \return
- *    Returns a pointer to the first token in the \a sourcedest string.  If
- *    no token is found before a '#', ';', '=', or end-of-line is found,
- *    then a null pointer is returned.  The pointer must be deleted by the
- *    caller after usage, if it is not null.
+ *    Returns the length of the option name.  If the first non-white-space
+ *    character is a '#', ';', '=', or '[', or there is none, then there is
+ *    no option name, and 0 is returned.
  *
  *//*-------------------------------------------------------------------------*/
 
-static char *
-get_ini_option (char * sourcedest)
+static size_t
+get_ini_option (const char * source, const char ** option)
 {
-   char * result = nullptr;
-   if (not_nullptr(sourcedest))
+   size_t result = 0;
+   const char * start = skip_white(source);
+   if
+   (
+      (*start != 0) && (*start != ';') && (*start != '#') &&
+      (*start != '=') && (*start != '[')
+   )
    {
-      char * start = sourcedest;       /* start at the beginning of string    */
-      cbool_t empty = false;           /* assume there is data                */
-      while (*start <= ' ')            /* skip "white space"                  */
-      {
-         if (*start == 0)              /* found the null terminator?          */
-         {
-            empty = true;              /* yes, there is no option name        */
-            break;
-         }
-         else
-            (void) *start++;
-      }
-
-      /*
-       * Check for either style of comment, or for a missing option-name
-       * before the '='.
-       */
-
-      if
+      const char * finish = start + 1;
+      while
       (
-         (*start == ';') || (*start == '#') ||
-         (*start == '=') || (*start == '[')
+         ((unsigned char) *finish > ' ') && (*finish != '=') &&
+         (*finish != ';') && (*finish != '#')
       )
       {
-         empty = true;                          /* there is no option name    */
-      }
-      if (! empty)                              /* option name exists         */
-      {
-         size_t count = 1;                      /* for counting characters    */
-         const char * beginning = start;        /* log option name's start    */
-         char * destination;                    /* to be calloc()'ed          */
-         start++;                               /* we're at second character  */
-         while
-         (
-            (*start > ' ') && (*start != '=') &&
-            (*start != ';') && (*start != '#')
-         )
-         {
-            count++;
-            start++;
-         }
-
-         /*
-          * Create a temporary buffer for the option name plus the null
-          * pointer.
-          */
-
-         destination = calloc(count + 1, 1);    /* allocate arg buffer        */
-         if (not_nullptr(destination))
-         {
-            (void) memcpy(destination, beginning, count);
-            destination[count] = 0;
-            result = destination;               /* hurray!                    */
-         }
-         else
-            xpc_errprint_func(_("couldn't allocate option buffer"));
+         finish++;
       }
+      *option = start;
+      result = (size_t) (finish - start);
    }
    return result;
 }
@@ -238,209 +287,255 @@ get_ini_option (char * sourcedest)
  * get_ini_value() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Returns a pointer to the value token in the string.
- *
- *    This function accepts a line of text read from a configuration file,
- *    parses it to find the value token in the text, and then
- *    null-terminates the string.
- *
- *    The standard shell script comment character, '#', terminates the
- *    string, if present.
+ *    Finds the value token that follows the '=' of an option.
  *
- *    The standard INI script comment character, ';', terminates the
- *    string, if present.
+ *    An unquoted value ends at the first white-space, or at a '#' or ';'
+ *    comment character.
  *
  *    If a value starts with a double-quote, then this function allows
  *    spaces and comment characters until the next double-quote, or the end
- *    of the line.
+ *    of the line.  The quotes are not part of the value.
  *
  * \private
  *    This routine is a static, internal C function and a helper function.
  *
- * \param sourcedest
- *    Must point to a string of the form
- *
- *          optionname = optionvalue
- *
- *    or
- *
- *          optionname = "optionvalue"
+ * \param source
+ *    Points just past the option name, in a null-terminated line.  The
+ *    '=' is searched for from there, but not past a comment character, so
+ *    that "flag ; x = y" is a flag, not an option with the value "y".
  *
- *    Note that there must be an equals sign and an option value.
+ * \param [out] value
+ *    Receives a pointer to the first character of the value.
  *
- * \param includequotes
- *    If true, then any double-quotes as used above are included in the
- *    value.  Otherwise, the quotes are dropped from both ends.
+ * \param [out] length
+ *    Receives the length of the value, which can be 0 for "".
  *
  * \return
- *    Returns a pointer to the value token in the \a sourcedest string.  If
- *    no token is found before a '#', ';', '=', or end-of-line is found,
- *    then a null pointer is returned.  The pointer must be deleted by the
- *    caller after usage, if it is not null.
+ *    Returns 'true' if there is a value.
  *
  *//*-------------------------------------------------------------------------*/
 
-static char *
-get_ini_value (char * sourcedest, cbool_t includequotes)
+static cbool_t
+get_ini_value
+(
+   const char * source,
+   const char ** value,
+   size_t * length
+)
 {
-   char * result = nullptr;
-   if (not_nullptr(sourcedest))
-      sourcedest = strchr(sourcedest, '=');     /* look for the '='           */
-
-   if (xpc_good_pointer(sourcedest))            /* was it found?              */
+   cbool_t result = false;
+   const char * start = source + strcspn(source, "=;#");
+   if (*start == '=')
    {
-      char * start = sourcedest + 1;            /* yes, move past it          */
-      cbool_t empty = false;                    /* optimistic assumption      */
-      while (isspace(*start))                   /* skip main space characters */
+      start = skip_white(start + 1);
+      if ((*start != 0) && (*start != ';') && (*start != '#'))
       {
-         start++;
-      }
-      if (*start == 0)                          /* null-terminator found?     */
-         empty = true;                          /* yes, no value given        */
-
-      if ((*start == ';') || (*start == '#'))   /* comment character found?   */
-         empty = true;                          /* yes, no value given        */
-
-      if (! empty)
-      {
-         size_t count = 0;                      /* for counting characters    */
-         const char * beginning = start;        /* log option name's start    */
-         char * destination;                    /* to be calloc()'ed          */
-         cbool_t gotquote = false;              /* flags first quote gotten   */
-         cbool_t inquotes = (*start == '"');    /* double-quote?              */
-         if (inquotes && ! includequotes)       /* yes, but don't want 'em    */
-         {
-            beginning++;                        /* skip the quote             */
-            start++;                            /* skip the quote             */
-         }
-
-         /*
-          * Scoot past all legal value characters.  Stop at the first
-          * white-space, control-characters, or INI or shell-script comment
-          * character.
-          */
-
-         while (inquotes || ! isspace(*start))  /* no ctrl chars or nulls     */
+         const char * finish;
+         if (*start == '"')
          {
-            if (inquotes)
-            {
-               if (*start == '"')
-               {
-                  if (gotquote)
-                     inquotes = false;          /* will terminate loop        */
-                  else
-                     gotquote = true;           /* we have the first quote    */
-
-                  if (includequotes)
-                  {
-                     count++;                   /* include the quote          */
-                     start++;
-                  }
-               }
-               else
-               {
-                  count++;
-                  start++;                      /* next char inside ""'s      */
-               }
-               if (! inquotes)
-                  break;                        /* don't get unquoted chars   */
-            }
-            else if ((*start == ';') || (*start == '#'))
-               break;
-            else
+            start++;
+            finish = strchr(start, '"');
+            if (is_null_result(finish))
             {
-               count++;
-               start++;
+               finish = strchr(start, 0);
+               xpc_warnprint_func(_("unmatched quotes found in option value"));
             }
          }
-         destination = calloc(count + 1, 1);    /* allocate arg buffer        */
-         if (not_nullptr(destination))
+         else
          {
-            (void) memcpy(destination, beginning, count);
-            destination[count] = 0;
-            result = destination;               /* hurray!                    */
+            finish = start;
+            while
+            (
+               ((unsigned char) *finish > ' ') &&
+               (*finish != ';') && (*finish != '#')
+            )
+            {
+               finish++;
+            }
          }
-         if (inquotes)
-            xpc_warnprint_func(_("unmatched quotes found in option value"));
+         *value = start;
+         *length = (size_t) (finish - start);
+         result = true;
       }
    }
    return result;
 }
 
 /******************************************************************************
- * append_token() [static]
+ * find_section() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Appends an option name or option value to an argv-style string buffer.
+ *    Looks up a section name found in the file in the caller's list of
+ *    wanted sections.
  *
- *    This function is called for each option name/value pair to build up a
- *    string of bytes of the form
+ * \param sections
+ *    The null-terminated list of section names wanted by the caller.
  *
- *       token<null>token<null>token<null>...token<null><null>
+ * \param name
+ *    The section name found in the file.  It is not null-terminated.
  *
- * \param destination
- *    Provides a pointer to the string buffer that is meant to contain the
- *    string date for each of the parameters in the argument list.
+ * \param length
+ *    The length of the name.
  *
- *    The caller should pass the value just \e past the previous null
- *    terminator, because we want to preserve them as terminators for each
- *    argv[] string.
+ * \return
+ *    Returns the index of the name in the list, or -1 if it is not wanted.
  *
- * \param source
- *    Provides a pointer to the source line.  This pointer points to the \a
- *    sourcedest parameter passed to the internal get_ini_option() and
- *    get_ini_value() functions.
+ *//*-------------------------------------------------------------------------*/
+
+static int
+find_section
+(
+   const char * const * sections,
+   const char * name,
+   size_t length
+)
+{
+   int result = -1;
+   int si;
+   for (si = 0; not_null_result(sections[si]); si++)
+   {
+      if
+      (
+         (strncmp(sections[si], name, length) == 0) &&
+         (sections[si][length] == 0)
+      )
+      {
+         result = si;
+         break;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * scan_INI_text() [static]
+ *------------------------------------------------------------------------*//**
  *
- * \param isoption
- *    The caller sets this value to 'true' if this token is an option name
- *    (as opposed to an option value).  An option name gets the standard
- *    option marker '--' prepended to it, so that it will look like an
- *    option the user provided on the command-line.
+ *    Converts the options of the wanted sections to argv[] tokens, in one
+ *    pass over the text of the file.
+ *
+ *    Each line is null-terminated in place, so lines can be of any length.
+ *    Lines without an alphabetic character are skipped (see
+ *    xpc_is_INI_line()).
+ *
+ *    Only the first section of each wanted name is read; a later section
+ *    of the same name is skipped.  Once every wanted section has been read,
+ *    the rest of the file is not scanned.
+ *
+ * \param arena
+ *    The arena to receive the tokens.
+ *
+ * \param text
+ *    The text of the file.  It is modified, and must be followed by a null.
+ *
+ * \param length
+ *    The length of the text.
+ *
+ * \param sections
+ *    The null-terminated list of section names to read.
+ *
+ * \param taken
+ *    One flag per section name, all false, to mark the ones read.
+ *
+ * \param sectioncount
+ *    The number of section names.
  *
  * \return
- *    Returns a pointer to just past the terminating null character if the
- *    parameters were value.  Otherwise, a null pointer is returned.
+ *    Returns 'true' if every token fit in the arena.
  *
  *//*-------------------------------------------------------------------------*/
 
-static char *
-append_token
+static cbool_t
+scan_INI_text
 (
-   char * destination,
-   const char * source,
-   cbool_t isoption
+   xpc_ini_arena_t * arena,
+   char * text,
+   size_t length,
+   const char * const * sections,
+   cbool_t * taken,
+   int sectioncount
 )
 {
-   char * result = nullptr;
-   if (not_nullptr_2(destination, source))
+   cbool_t result = true;
+   char * textend = text + length;
+   char * line = text;
+   int current = -1;                         /* the section being read        */
+   int remaining = sectioncount;             /* the sections not yet read     */
+   while (result && (line < textend))
    {
-      if (isoption)
+      char * next = memchr(line, '\n', (size_t) (textend - line));
+      const char * name;
+      size_t namelength;
+      cbool_t useful;
+      if (not_null_result(next))
+         *next++ = 0;                        /* replace newline w/null        */
+      else
+         next = textend;                     /* the last line has a null      */
+
+      useful = xpc_is_INI_line(line);        /* skip comment & blank lines    */
+      if (useful && extract_section_name(line, &name, &namelength))
       {
-         strcpy(destination, "--");
-         destination += 2;
+         /*
+          * A section marker ends the section in progress.  If it was the
+          * last one wanted, we are done; we don't care if the next section
+          * has the same name.
+          */
+
+         if (current >= 0)
+         {
+            current = -1;
+            if (remaining == 0)
+               break;
+         }
+         current = find_section(sections, name, namelength);
+         if (current >= 0)
+         {
+            if (taken[current])
+               current = -1;                 /* a repeat, so skip it          */
+            else
+            {
+               taken[current] = true;
+               remaining--;
+            }
+         }
+      }
+      else if (useful && (current >= 0))
+      {
+         /*
+          * Even if there is no '=', we include the first token in the list
+          * of command-line arguments, because it might be a boolean flag.
+          */
+
+         const char * option;
+         size_t optionlength = get_ini_option(line, &option);
+         if (optionlength > 0)
+         {
+            const char * value;
+            size_t valuelength;
+            result = append_token(arena, option, optionlength, true);
+            if (result)
+            {
+               if (get_ini_value(option + optionlength, &value, &valuelength))
+                  result = append_token(arena, value, valuelength, false);
+            }
+         }
       }
-      strcat(destination, source);
-      result = strchr(destination, 0) + 1;
+      line = next;
    }
    return result;
 }
 
 /******************************************************************************
- * SET_OPT_LINE_SIZE
+ * INI_FILE_SIZE_MAX
  *------------------------------------------------------------------------*//**
  *
- *    Provides a manifest constant for line size.  This size is used in a
- *    careful way -- the code handles excess size by truncation.
- *
- *    We do not try to implement a catch-all dynamically-allocated line
- *    buffer.  This work is more than is necessary for most files.
- *
- *    If a line of text is has more characters than this value, some will
- *    simply be lost.
+ *    Provides a sanity check on the size of a configuration file.  We pick
+ *    an arbitrary number, 256K.  Realistically, most configuration files
+ *    will be under 20K.  Lines can be of any length.
  *
  *//*-------------------------------------------------------------------------*/
 
-#define SET_OPT_LINE_SIZE     512
+#define INI_FILE_SIZE_MAX     262144
 
 /******************************************************************************
  * xpc_is_INI_line()
@@ -480,7 +575,8 @@ xpc_is_INI_line (const char * line)
  * xpc_argv_from_INI()
  *------------------------------------------------------------------------*//**
  *
- *    Creates an argc/argv ensemble from a simple configuration file.
+ *    Creates an argc/argv ensemble from one section of a simple
+ *    configuration file.
  *
  *    Each option in the file is of the following format, one and only one
  *    option per line:
@@ -493,11 +589,9 @@ xpc_is_INI_line (const char * line)
  *
  *    where the brackets indicate the optional presence of the item.
  *
- * \note
- *    Section group markers, such as the following, are ignored by this
- *    function.
- *
- *          [ Section ]
+ *    This function is xpc_argv_from_INI_sections() with a list of one
+ *    section.  To read several sections of the same file, call that
+ *    function once, instead of calling this one for each section.
  *
  * \usage
  *    This function require a bit of setup and teardown in order to use it
@@ -509,30 +603,16 @@ xpc_is_INI_line (const char * line)
 \verbatim
       int local_argc;
       char * buffer;
-      char ** local_argv = xpc_argv_from_INI("myapp.ini", &local_argc, &buffer);
+      char ** local_argv = xpc_argv_from_INI
+      (
+         "myapp.ini", "Options", &local_argc, &buffer
+      );
       if (not_nullptr(local_argv))           // (local_argv != NULL)
       {
          my_parse_argc_argv(local_argc, local_argv, false);
-         xpc_delete_argv(localargv, buffer);
+         xpc_delete_argv(local_argv, buffer);
       }
 \endverbatim
- *
- * \note
- *    -# How much space to allocate?  The worst case is for one-character
- *       options with no values.  Each option would be 2 or 3 characters (e.g.
- *       "d\n" or "d\r\n"), and would expand to four characters (e.g.
- *       "--d<null>").  So a buffer twice the size of the file
- *       should be sufficient.
- *    -# We sanity-check the file size, to avoid problems.  We pick an
- *       arbitrary number, 256K.  Realistically, most configuration files
- *       will be under 20K.
- *    -# The fgets() function reads a string from the input stream argument
- *       and stores it.  It reads characters from the current stream
- *       position to and including the first newline character, to the end
- *       of the stream, or until the number of characters read is equal to
- *       n-1, whichever comes first. The result stored in string is appended
- *       with a null character. The newline character, if read, is included
- *       in the string.
  *
  * \param filespec
  *    Provides the name of the file from which to read the configuration
@@ -548,8 +628,7 @@ xpc_is_INI_line (const char * line)
  *    that were found in the configuration file.
  *
  * \param buffer_return
- *    Points to an internally-allocated buffer holding all of the values to
- *    which the returned argv-style array will point.
+ *    Points to the pointer to be passed to xpc_delete_argv().
  *
  * \return
  *    Returns a pointer an internally-allocated array of character pointers
@@ -559,9 +638,6 @@ xpc_is_INI_line (const char * line)
  *    If there are any failures, then a null pointer is returned, and no
  *    values can be used, nor is there a need to call xpc_delete_argv().
  *
- * \todo
- *    DEAL WITH ARG 0
- *
  *//*-------------------------------------------------------------------------*/
 
 char **
@@ -572,11 +648,78 @@ xpc_argv_from_INI
    int * argc_return,
    char ** buffer_return
 )
+{
+   char ** result = nullptr;
+   if (not_nullptr(section))
+   {
+      const char * sections[2];
+      sections[0] = section;
+      sections[1] = nullptr;
+      result = xpc_argv_from_INI_sections
+      (
+         filespec, sections, argc_return, buffer_return
+      );
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_argv_from_INI_sections()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates an argc/argv ensemble from several sections of a simple
+ *    configuration file, reading the file once.
+ *
+ *    The options are converted as described for xpc_argv_from_INI(), and
+ *    appear in argv[] in the order they appear in the file.  argv[0] is
+ *    the file name, and argv[argc] is a null pointer.
+ *
+ *    The file is read into memory with one read, and converted in one pass
+ *    over its text.  The argv[] array, the tokens, and the text are all in
+ *    one allocation.
+ *
+ * \note
+ *    How much space to allocate?  The worst case is for one-character
+ *    options with no values.  Each option would be 2 characters (e.g.
+ *    "d\n"), and would expand to four characters (e.g. "--d<null>").  So
+ *    twice the size of the file is enough for the tokens, and there are at
+ *    most half as many tokens as there are characters in the file.
+ *
+ * \param filespec
+ *    Provides the name of the file from which to read the configuration
+ *    information.
+ *
+ * \param sections
+ *    Provides the null-terminated list of the section groups from which to
+ *    get the argv values.  The first section of each name is read.
+ *
+ * \param argc_return
+ *    Points to the integer value to be filled with the number of arguments
+ *    that were found in the configuration file.
+ *
+ * \param buffer_return
+ *    Points to the pointer to be passed to xpc_delete_argv().
+ *
+ * \return
+ *    Returns a pointer an internally-allocated array of character pointers,
+ *    as for xpc_argv_from_INI().  If there are any failures, then a null
+ *    pointer is returned.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+char **
+xpc_argv_from_INI_sections
+(
+   const char * filespec,
+   const char * const * sections,
+   int * argc_return,
+   char ** buffer_return
+)
 {
    char ** result = nullptr;
    cbool_t ok = not_nullptr(filespec) && (strlen(filespec) > 0);
    if (ok)
-      ok = not_nullptr_2(argc_return, buffer_return);
+      ok = not_nullptr_3(sections, argc_return, buffer_return);
 
    if (ok)
    {
@@ -588,131 +731,61 @@ xpc_argv_from_INI
       if (rcode == POSIX_SUCCESS)
          filesize = status.st_size;                /* now have good file size */
 
-      if ((filesize > 0) && (filesize <= 262144))  /* light sanity check      */
+      if ((filesize > 0) && (filesize <= INI_FILE_SIZE_MAX))
       {
          FILE * fhandle = fopen(filespec, "r");
          if (not_nullptr(fhandle))
          {
-            size_t fullsize = 2 * filesize;        /* see notes               */
-            char * buffer = calloc(fullsize, 1);   /* allocate arg buffer     */
-            if (not_nullptr(buffer))
+            int sectioncount = 0;
+            int maxargs = (int) (filesize / 2) + 3;   /* argv[0] and null     */
+            size_t argvsize;
+            size_t flagsize;
+            size_t tokensize = 2 * filesize + strlen(filespec) + 4;
+            char * block;
+            while (not_null_result(sections[sectioncount]))
+               sectioncount++;
+
+            argvsize = maxargs * sizeof(char *);
+            flagsize = sectioncount * sizeof(cbool_t);
+            block = malloc(argvsize + flagsize + tokensize + filesize + 1);
+            if (not_nullptr(block))
             {
-               char line[SET_OPT_LINE_SIZE];
-               int argc = 0;
-               char * bufferptr = buffer;
-               cbool_t section_in_progress = false;
-               *bufferptr = 0;                     /* terminate for strcat()  */
-               bufferptr = append_token(bufferptr, filespec, false);
-               argc++;
-               while (not_null_result(fgets(line, SET_OPT_LINE_SIZE-1, fhandle)))
+               xpc_ini_arena_t arena;
+               cbool_t * taken = (cbool_t *) (block + argvsize);
+               char * text = block + argvsize + flagsize + tokensize;
+               size_t length = fread(text, 1, filesize, fhandle);
+               text[length] = 0;
+               (void) memset(taken, 0, flagsize);
+               arena.m_Argv = (char **) block;
+               arena.m_Argc = 0;
+               arena.m_Max_Args = maxargs;
+               arena.m_Next = block + argvsize + flagsize;
+               arena.m_End = text;
+               ok = ! ferror(fhandle);
+               if (ok)
+                  ok = append_token(&arena, filespec, strlen(filespec), false);
+               else
+                  xpc_errprint_func(_("could not read file"));
+
+               if (ok)
                {
-                  char * nl = strchr(line, '\n');
-                  char * value = nullptr;
-                  char * option = nullptr;
-                  const char * sectname;
-                  if (not_null_result(nl))
-                     *nl = 0;                      /* replace newline w/null  */
-
-                  if (! xpc_is_INI_line(line))
-                     continue;                     /* skip comment lines      */
-
-                  sectname = extract_section_name(line);
-                  if (not_null_result(sectname) && (sectname[0] == '['))
-                  {
-                     /*
-                      * If there is no section in progress, one is becoming
-                      * in progress only if it matches the desired section.
-                      * In that case, we continue, to skip other parsing on
-                      * that line of the INI file.  If a section was already
-                      * in progress, we automatically terminate; we don't
-                      * care if the next section has the same name.  Note
-                      * that we have to skip the '['.
-                      */
-
-                     if (section_in_progress)
-                        break;
-                     else
-                     {
-                        section_in_progress = strcmp(sectname+1, section) == 0;
-                        continue;
-                     }
-                  }
-                  if (! section_in_progress)
-                     continue;
-
-                  nl = strchr(line, '=');          /* search for equal sign   */
-                  if (not_null_result(nl))         /* if found, then...       */
-                  {
-                     option = get_ini_option(line);         /* get 1st token  */
-                     if (xpc_good_pointer(option))
-                     {
-                        bufferptr = append_token(bufferptr, option, true);
-                        argc++;
-                        free(option);
-
-                        /*
-                         * 'false' is passed in order to not include the
-                         * quotes.  If you change this to true, also change
-                         * the unit test to pass with quotes in the result.
-                         */
-
-                        value = get_ini_value(line, false); /* get 2nd token  */
-                        if (not_null_result(value))
-                        {
-                           bufferptr = append_token(bufferptr, value, false);
-                           argc++;
-                           free(value);
-                        }
-                     }
-                  }
-                  else
-                  {
-                     /*
-                      * @change ca 2010-11-19
-                      * Even if no '=', we'd like to include the first token
-                      * in the list of command-line arguments, because it
-                      * might be a boolean flag.
-                      */
-
-                     option = get_ini_option(line);         /* get 1st token  */
-                     if (xpc_good_pointer(option))
-                     {
-                        bufferptr = append_token(bufferptr, option, true);
-                        argc++;
-                        free(option);
-                     }
-                  }
+                  ok = scan_INI_text
+                  (
+                     &arena, text, length, sections, taken, sectioncount
+                  );
                }
-               *argc_return = argc;
-               if (argc > 0)
+               if (ok)
                {
-                  char ** argv = calloc(argc * sizeof(char *), 1);
-                  if (not_nullptr(argv))
-                  {
-                     int ai;
-                     bufferptr = buffer;              /* start again          */
-                     for (ai = 0; ai < argc; ai++)
-                     {
-                        argv[ai] = bufferptr;
-                        bufferptr = strchr(bufferptr, 0);
-                        bufferptr++;
-                     }
-                     result = argv;
-                  }
-                  else
-                  {
-                     xpc_errprint_func(_("couldn't allocate argv[]"));
-                     free(buffer);
-                     set_nullptr(buffer);
-                  }
+                  arena.m_Argv[arena.m_Argc] = nullptr;
+                  *argc_return = arena.m_Argc;
+                  *buffer_return = block;
+                  result = arena.m_Argv;
                }
                else
-                  xpc_warnprint_func(_("no options and values found"));
-
-               *buffer_return = buffer;
+                  free(block);
             }
             else
-               xpc_errprint_func(_("calloc() failed"));
+               xpc_errprint_func(_("malloc() failed"));
 
             (void) fclose(fhandle);
          }
@@ -732,6 +805,10 @@ xpc_argv_from_INI
  * xpc_delete_argv()
  *------------------------------------------------------------------------*//**
  *
+ *    Frees what xpc_argv_from_INI() or xpc_argv_from_INI_sections()
+ *    allocated.  The argv[] array and the buffer are now one allocation,
+ *    so it is freed only once.
+ *
  * \param argv
  *    The pointer to the argv-style pointer buffer that was allocated by
  *    xpc_argv_from_INI().
@@ -747,7 +824,7 @@ xpc_delete_argv (char ** argv, char * buffer)
    if (xpc_good_pointer(argv))
       (void) free(argv);
 
-   if (xpc_good_pointer(buffer))
+   if (xpc_good_pointer(buffer) && (buffer != (char *) argv))
       (void) free(buffer);
 }
 
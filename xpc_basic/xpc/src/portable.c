@@ -44,6 +44,7 @@
 #include <xpc/portable.h>              /* functions, macros, and headers      */
 #include <xpc/errorlogging.h>          /* included only for xpc_errprint()    */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/atomix.h>                /* xpc_thread_local                    */
 XPC_REVISION(portable)
 
 #if XPC_HAVE_LIMITS_H
@@ -1299,78 +1300,271 @@ xpc_time_difference_ptr (struct timeval * c1, struct timeval * c2)
 }
 
 /******************************************************************************
- * xpc_stopwatch_start()
+ * xpc_monotonic_nanoseconds()
  *------------------------------------------------------------------------*//**
  *
- *    Starts a single-threaded stopwatch with microsecond resolution.
+ *    Reads a monotonic clock with nanosecond resolution.
  *
- *    This function first gets that start time using xpc_get_microseconds().
- *    Then it sets the lap time to this time.  Finally, a "stopwatch
- *    started" flag is set to true.
+ *    Unlike xpc_get_microseconds(), which reads the time-of-day, this
+ *    clock never jumps when the system time is set, so it is the one to
+ *    use for measuring intervals.  POSIX uses CLOCK_MONOTONIC, and Win32
+ *    uses the performance counter.  Where neither is available, it falls
+ *    back to gettimeofday().
  *
- *    The xpc_stopwatch_start(), xpc_stopwatch_duration(), and xpc_stopwatch_lap()
- *    functions provide a global timer so that the call doesn't even have
- *    to know about struct timeval.  The "duration" function gets the
- *    current time and returns the difference between it and the start
- *    time, in seconds.  The "lap" function returns the time between the
- *    previous lap time and now.
+ * \return
+ *    Returns the nanoseconds since an arbitrary starting point.
  *
- * \threadunsafe
- *    Please note that these functions are not thread-safe, since the start
- *    and lap times are stored in a static variable.  Access them only with
- *    a single thread.  They are meant mostly for testing and for the
- *    evaluation of algorithms.
+ * \unittests
+ *    -  portable_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint64_t
+xpc_monotonic_nanoseconds (void)
+{
+   uint64_t result;
+#if XPC_HAVE_CLOCK_GETTIME
+   struct timespec ts;
+   (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+   result = (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#elif defined WIN32
+   LARGE_INTEGER count;
+   LARGE_INTEGER frequency;
+   (void) QueryPerformanceCounter(&count);
+   (void) QueryPerformanceFrequency(&frequency);
+   result = (uint64_t) (count.QuadPart / frequency.QuadPart) * 1000000000ULL +
+      (uint64_t) (count.QuadPart % frequency.QuadPart) * 1000000000ULL /
+      (uint64_t) frequency.QuadPart;
+#else
+   struct timeval tv;
+   (void) xpc_get_microseconds(&tv);
+   result = (uint64_t) tv.tv_sec * 1000000000ULL +
+      (uint64_t) tv.tv_usec * 1000;
+#endif
+   return result;
+}
+
+/******************************************************************************
+ * xpc_stopwatch_start_ex()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Starts (or restarts) a stopwatch, and sets its lap time to the start
+ *    time.
  *
- *    We could provide an optional structure parameter to make this function
- *    thread-safe, if the need becomes evident.
+ *    The caller owns the stopwatch, so any number of threads can time
+ *    their own sections at the same time, without sharing anything.
  *
  * \unittests
- *    TBD.
+ *    -  portable_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_stopwatch_start_ex
+(
+   xpc_stopwatch_t * sw          /**< The stopwatch to start.                 */
+)
+{
+   if (not_nullptr(sw))
+   {
+      sw->m_Start_Ns = xpc_monotonic_nanoseconds();
+      sw->m_Lap_Ns = sw->m_Start_Ns;
+      sw->m_Started = true;
+   }
+}
+
+/******************************************************************************
+ * xpc_stopwatch_duration_ns()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the time elapsed since the stopwatch was started.
+ *
+ * \return
+ *    Returns the duration in nanoseconds, or 0 if the stopwatch was not
+ *    started.
+ *
+ * \unittests
+ *    -  portable_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint64_t
+xpc_stopwatch_duration_ns
+(
+   const xpc_stopwatch_t * sw    /**< The stopwatch to read.                  */
+)
+{
+   uint64_t result = 0;
+   if (not_nullptr(sw) && sw->m_Started)
+      result = xpc_monotonic_nanoseconds() - sw->m_Start_Ns;
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_stopwatch_lap_ns()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the time elapsed since the previous lap (or the start), and
+ *    begins a new lap.
+ *
+ *    The clock is read only once, and that reading ends this lap and
+ *    starts the next one, so consecutive laps add up to the duration.
+ *
+ * \return
+ *    Returns the lap time in nanoseconds, or 0 if the stopwatch was not
+ *    started.
+ *
+ * \unittests
+ *    -  portable_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+uint64_t
+xpc_stopwatch_lap_ns
+(
+   xpc_stopwatch_t * sw          /**< The stopwatch to read.                  */
+)
+{
+   uint64_t result = 0;
+   if (not_nullptr(sw) && sw->m_Started)
+   {
+      uint64_t now = xpc_monotonic_nanoseconds();
+      result = now - sw->m_Lap_Ns;
+      sw->m_Lap_Ns = now;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_stopwatch_duration_ex()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides xpc_stopwatch_duration_ns() in seconds.
+ *
+ * \return
+ *    Returns the duration in seconds, or 0.0 if the stopwatch was not
+ *    started.
+ *
+ * \unittests
+ *    -  portable_test_02_02()
  *
  *//*-------------------------------------------------------------------------*/
 
-static cbool_t g_xpc_stopwatch_started = false;
-static struct timeval g_xpc_stopwatch_start_time;
-static struct timeval g_xpc_stopwatch_lap_time;
+double
+xpc_stopwatch_duration_ex
+(
+   const xpc_stopwatch_t * sw    /**< The stopwatch to read.                  */
+)
+{
+   return (double) xpc_stopwatch_duration_ns(sw) * 1.0e-9;
+}
+
+/******************************************************************************
+ * xpc_stopwatch_lap_ex()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides xpc_stopwatch_lap_ns() in seconds.
+ *
+ * \return
+ *    Returns the lap time in seconds, or 0.0 if the stopwatch was not
+ *    started.
+ *
+ * \unittests
+ *    -  portable_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+double
+xpc_stopwatch_lap_ex
+(
+   xpc_stopwatch_t * sw          /**< The stopwatch to read.                  */
+)
+{
+   return (double) xpc_stopwatch_lap_ns(sw) * 1.0e-9;
+}
+
+/******************************************************************************
+ * gs_stopwatch
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides each thread's default stopwatch, used by xpc_stopwatch_start(),
+ *    xpc_stopwatch_duration(), and xpc_stopwatch_lap().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc_thread_local xpc_stopwatch_t gs_stopwatch;
+
+/******************************************************************************
+ * xpc_stopwatch_thread()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the calling thread's default stopwatch, for use with the
+ *    "_ex" and "_ns" functions.
+ *
+ * \return
+ *    Returns a pointer to the default stopwatch.  It is valid only while
+ *    the thread lives, and must not be handed to other threads.
+ *
+ * \unittests
+ *    -  portable_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+xpc_stopwatch_t *
+xpc_stopwatch_thread (void)
+{
+   return &gs_stopwatch;
+}
+
+/******************************************************************************
+ * xpc_stopwatch_start()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Starts the calling thread's default stopwatch.
+ *
+ *    The xpc_stopwatch_start(), xpc_stopwatch_duration(), and
+ *    xpc_stopwatch_lap() functions provide a timer so that the caller
+ *    doesn't even have to declare one.  The "duration" function returns
+ *    the time since the start, in seconds.  The "lap" function returns
+ *    the time between the previous lap time and now.
+ *
+ *    Each thread has its own default stopwatch, so threads timing
+ *    themselves do not disturb each other.  To time nested or overlapping
+ *    sections in one thread, declare an xpc_stopwatch_t for each, and use
+ *    the "_ex" functions.
+ *
+ * \unittests
+ *    -  portable_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
 
 void
 xpc_stopwatch_start (void)
 {
-   xpc_get_microseconds(&g_xpc_stopwatch_start_time);
-   g_xpc_stopwatch_lap_time = g_xpc_stopwatch_start_time;
-   g_xpc_stopwatch_started = true;
+   xpc_stopwatch_start_ex(&gs_stopwatch);
 }
 
 /******************************************************************************
  * xpc_stopwatch_duration()
  *------------------------------------------------------------------------*//**
  *
- *    Provides the total time elapsed since the start time.
- *
- *    This function gets the current time with xpc_get_microseconds(), and then
- *    it returns the difference between the end time (current time) and the
- *    start time using the xpc_time_difference() function.
+ *    Provides the total time elapsed since the calling thread last called
+ *    xpc_stopwatch_start().
  *
  * \return
  *    The duration since the start time of the stopwatch is returned, in
- *    units of microseconds.
+ *    units of seconds (with nanosecond resolution).
  *
  * \unittests
- *    TBD.
+ *    -  portable_test_02_02()
  *
  *//*-------------------------------------------------------------------------*/
 
 double
 xpc_stopwatch_duration (void)
 {
-   double result = 0.0;
-   if (g_xpc_stopwatch_started)
-   {
-      struct timeval end_time;
-      xpc_get_microseconds(&end_time);
-      result = xpc_time_difference(g_xpc_stopwatch_start_time, end_time);
-   }
-   return result;
+   return xpc_stopwatch_duration_ex(&gs_stopwatch);
 }
 
 /******************************************************************************
@@ -1378,42 +1572,23 @@ xpc_stopwatch_duration (void)
  *------------------------------------------------------------------------*//**
  *
  *    Returns the time difference between the current call to
- *    xpc_stopwatch_lap() and the previous call to it.
- *
- *    This function gets the current time with xpc_get_microseconds(), and
- *    then it returns the difference between the end time (current time) and
- *    the last lap time using the xpc_time_difference() function.
- *
- *    Then the old lap time is updated with the current time in anticipation
- *    of the next call to xpc_stopwatch_lap().  To increase the accuracy a
- *    little bit, the new lap time is obtained by another call to
- *    xpc_get_microseconds().
+ *    xpc_stopwatch_lap() and the previous call to it, on the calling
+ *    thread's default stopwatch.
  *
  * \return
- *    Returns the difference in microseconds between the current call to
+ *    Returns the difference in seconds between the current call to
  *    xpc_stopwatch_lap(), and the last call [or to xpc_stopwatch_start() if
- *    there was no previous call to xpc_stopwatch_lap().
+ *    there was no previous call to xpc_stopwatch_lap()].
  *
  * \unittests
- *    TBD.
+ *    -  portable_test_02_02()
  *
  *//*-------------------------------------------------------------------------*/
 
 double
 xpc_stopwatch_lap (void)
 {
-   double result = 0.0;
-   if (g_xpc_stopwatch_started)
-   {
-      struct timeval end_time;
-      xpc_get_microseconds(&end_time);
-      result = xpc_time_difference(g_xpc_stopwatch_lap_time, end_time);
-
-      /* This time is now out-of-date: g_xpc_stopwatch_lap_time = end_time    */
-
-      xpc_get_microseconds(&g_xpc_stopwatch_lap_time);
-   }
-   return result;
+   return xpc_stopwatch_lap_ex(&gs_stopwatch);
 }
 
 /******************************************************************************
@@ -0,0 +1,599 @@
+/******************************************************************************
+ * profiler.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          profiler.c
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \date          2013-08-17
+ * \updates       2013-08-17
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides named profiling zones with per-thread latency histograms.
+ *
+ *    See profiler.h for the overview.  Some notes on the implementation:
+ *
+ *       -  Each thread gets a block holding one histogram pointer per zone.
+ *          The histograms are allocated by the thread the first time it
+ *          records a zone.  Only the owning thread writes them, so a
+ *          record is lock-free once a zone has been seen on a thread.
+ *       -  The blocks are kept in a list guarded by gs_lock, which is
+ *          taken only to register a zone or a thread, to merge, and when a
+ *          thread exits.  At thread exit (a pthread key destructor), the
+ *          thread's histograms are folded into gs_retired, so that their
+ *          times still show up in the reports.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/profiler.h>              /* xpc_profile_zone_t, etc.            */
+#include <xpc/errorlogging.h>          /* macros and external functions       */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/atomix.h>                /* xpc_atomic_load(), xpc_thread_local */
+
+#if XPC_HAVE_PTHREAD_H
+#include <pthread.h>                   /* pthread_mutex_t, pthread_key_t      */
+#endif
+
+#if XPC_HAVE_STDLIB_H
+#include <stdlib.h>                    /* malloc(), calloc(), and free()      */
+#endif
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* strcmp()                            */
+#endif
+
+XPC_REVISION(profiler)
+
+/******************************************************************************
+ * profile_thread_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Holds one thread's histograms, indexed by zone ID less 1.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct profile_thread_s
+{
+   xpc_histogram_t * m_Zones[XPC_PROFILE_ZONE_MAX];
+   struct profile_thread_s * m_Next;
+
+} profile_thread_t;
+
+/******************************************************************************
+ * Module state
+ *------------------------------------------------------------------------*//**
+ *
+ *    gs_lock guards everything here except gs_thread, which belongs to
+ *    its thread.  gs_zone_count is also read without the lock, to bound
+ *    the loops over the zones.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static pthread_mutex_t gs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gs_once = PTHREAD_ONCE_INIT;
+static pthread_key_t gs_key;
+static xpc_thread_local profile_thread_t * gs_thread;
+static profile_thread_t * gs_threads;
+static xpc_histogram_t * gs_retired[XPC_PROFILE_ZONE_MAX];
+static const char * gs_names[XPC_PROFILE_ZONE_MAX];
+static int gs_zone_count;
+static cbool_t gs_full_warned;
+
+/******************************************************************************
+ * profile_thread_exit() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Folds an exiting thread's histograms into gs_retired, and frees its
+ *    block.  The first histogram of each zone is simply handed over.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+profile_thread_exit
+(
+   void * block                  /**< The thread's profile_thread_t.          */
+)
+{
+   profile_thread_t * pt = (profile_thread_t *) block;
+   profile_thread_t ** link;
+   int z;
+   (void) pthread_mutex_lock(&gs_lock);
+   for (link = &gs_threads; not_NULL(*link); link = &(*link)->m_Next)
+   {
+      if (*link == pt)
+      {
+         *link = pt->m_Next;
+         break;
+      }
+   }
+   for (z = 0; z < XPC_PROFILE_ZONE_MAX; ++z)
+   {
+      xpc_histogram_t * h = pt->m_Zones[z];
+      if (not_NULL(h))
+      {
+         if (is_NULL(gs_retired[z]))
+            gs_retired[z] = h;
+         else
+         {
+            xpc_histogram_merge(gs_retired[z], h);
+            free(h);
+         }
+      }
+   }
+   (void) pthread_mutex_unlock(&gs_lock);
+   free(pt);
+}
+
+/******************************************************************************
+ * profile_make_key() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates the thread key whose destructor is profile_thread_exit().
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+profile_make_key (void)
+{
+   int rcode = pthread_key_create(&gs_key, profile_thread_exit);
+   if (rcode != 0)
+      xpc_strerrprint_func(_("pthread_key_create() failed"), rcode);
+}
+
+/******************************************************************************
+ * profile_thread_attach() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gives the calling thread its block of histograms, on its first
+ *    record.
+ *
+ * \return
+ *    Returns the block, or a null pointer if it could not be allocated.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static profile_thread_t *
+profile_thread_attach (void)
+{
+   profile_thread_t * result = calloc(1, sizeof(profile_thread_t));
+   if (not_nullptr(result))
+   {
+      (void) pthread_once(&gs_once, profile_make_key);
+      (void) pthread_setspecific(gs_key, result);
+      (void) pthread_mutex_lock(&gs_lock);
+      result->m_Next = gs_threads;
+      gs_threads = result;
+      (void) pthread_mutex_unlock(&gs_lock);
+      gs_thread = result;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * profile_find() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Looks up a zone name.  The caller holds gs_lock.
+ *
+ * \return
+ *    Returns the 1-based zone ID, or 0 if the name is not registered.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static int
+profile_find (const char * name)
+{
+   int result = 0;
+   int z;
+   for (z = 0; z < gs_zone_count; ++z)
+   {
+      if (strcmp(gs_names[z], name) == 0)
+      {
+         result = z + 1;
+         break;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * profile_register() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gives a zone its ID, on its first use.  A zone with the name of one
+ *    already registered gets the same ID.
+ *
+ *    The warning that the table is full is logged after gs_lock is
+ *    released, so that the logging locks are never taken inside it.
+ *
+ * \return
+ *    Returns the zone's ID, or -1 if there is no room for another zone.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static int
+profile_register
+(
+   xpc_profile_zone_t * zone     /**< The zone to register.                   */
+)
+{
+   int result;
+   cbool_t warn = false;
+   (void) pthread_mutex_lock(&gs_lock);
+   result = zone->m_Id;
+   if (result == 0)
+   {
+      result = profile_find(zone->m_Name);
+      if (result == 0)
+      {
+         if (gs_zone_count < XPC_PROFILE_ZONE_MAX)
+         {
+            gs_names[gs_zone_count] = zone->m_Name;
+            result = xpc_atomic_add(&gs_zone_count, 1) + 1;
+         }
+         else
+         {
+            result = -1;
+            if (! gs_full_warned)
+            {
+               gs_full_warned = true;
+               warn = true;
+            }
+         }
+      }
+      xpc_atomic_store(&zone->m_Id, result);
+   }
+   (void) pthread_mutex_unlock(&gs_lock);
+   if (warn)                                 /* not under gs_lock          */
+      xpc_warnprint_func(_("too many profiling zones"));
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_profile_record()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Records one time for a zone, in the calling thread's histogram.
+ *
+ *    After the first record of a zone on a thread, this takes no lock and
+ *    allocates nothing.  It is normally called through the XPC_PROFILE
+ *    macros.
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_profile_record
+(
+   xpc_profile_zone_t * zone,    /**< The zone, a static object.              */
+   uint64_t nanoseconds          /**< The time spent in the zone.             */
+)
+{
+   int id = xpc_atomic_load(&zone->m_Id);
+   if (id == 0)
+      id = profile_register(zone);
+
+   if (id > 0)
+   {
+      profile_thread_t * pt = gs_thread;
+      if (is_NULL(pt))
+         pt = profile_thread_attach();
+
+      if (not_NULL(pt))
+      {
+         xpc_histogram_t * h = pt->m_Zones[id - 1];
+         if (is_NULL(h))
+         {
+            h = malloc(sizeof(xpc_histogram_t));
+            if (not_nullptr(h))
+            {
+               xpc_histogram_init(h);
+               xpc_atomic_store(&pt->m_Zones[id - 1], h);
+            }
+         }
+         if (not_NULL(h))
+            xpc_histogram_record(h, nanoseconds);
+      }
+   }
+}
+
+/******************************************************************************
+ * xpc_profile_scope_end()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Records the time since a scope's start.  This is the cleanup function
+ *    of XPC_PROFILE_SCOPE().
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_profile_scope_end
+(
+   xpc_profile_scope_t * scope   /**< The scope being left.                   */
+)
+{
+   xpc_profile_record
+   (
+      scope->m_Zone, xpc_monotonic_nanoseconds() - scope->m_Start
+   );
+}
+
+/******************************************************************************
+ * xpc_profile_zone_count()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the number of zone names registered so far.  Their IDs run
+ *    from 1 to this number.
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_profile_zone_count (void)
+{
+   return xpc_atomic_load(&gs_zone_count);
+}
+
+/******************************************************************************
+ * xpc_profile_zone_name()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the name of the zone with the given ID, or a null pointer if
+ *    the ID is not valid.
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+const char *
+xpc_profile_zone_name
+(
+   int id                        /**< The 1-based zone ID.                    */
+)
+{
+   const char * result = nullptr;
+   if (id > 0 && id <= xpc_profile_zone_count())
+      result = gs_names[id - 1];
+
+   return result;
+}
+
+/******************************************************************************
+ * profile_merge_id() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds up one zone's histograms from every thread, live or exited.  The
+ *    caller holds gs_lock, which keeps the blocks from being freed.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+profile_merge_id
+(
+   int id,                       /**< The 1-based zone ID.                    */
+   xpc_histogram_t * out         /**< Receives the sum.                       */
+)
+{
+   const profile_thread_t * pt;
+   xpc_histogram_init(out);
+   if (not_NULL(gs_retired[id - 1]))
+      xpc_histogram_merge(out, gs_retired[id - 1]);
+
+   for (pt = gs_threads; not_NULL(pt); pt = pt->m_Next)
+   {
+      const xpc_histogram_t * h = xpc_atomic_load(&pt->m_Zones[id - 1]);
+      if (not_NULL(h))
+         xpc_histogram_merge(out, h);
+   }
+}
+
+/******************************************************************************
+ * xpc_profile_merge()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds up the histograms of a zone from all threads.  Threads can keep
+ *    recording while this is done.
+ *
+ * \return
+ *    Returns 'true' if the zone name is registered.  Otherwise, \a out is
+ *    left unchanged.
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_profile_merge
+(
+   const char * name,            /**< The name of the zone.                   */
+   xpc_histogram_t * out         /**< Receives the merged histogram.          */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(name) && not_nullptr(out))
+   {
+      int id;
+      (void) pthread_mutex_lock(&gs_lock);
+      id = profile_find(name);
+      if (id > 0)
+      {
+         profile_merge_id(id, out);
+         result = true;
+      }
+      (void) pthread_mutex_unlock(&gs_lock);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_profile_dump()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Writes a table of the zones, with the count, the mean, the 50th,
+ *    99th, and 99.9th percentiles, and the maximum, in microseconds.
+ *
+ * \param fp
+ *    The file to write to.  If it is a null pointer, each line goes to
+ *    the error log through xpc_print() instead.
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_profile_dump (FILE * fp)
+{
+   xpc_histogram_t * h = calloc(1, sizeof(xpc_histogram_t));
+   if (not_nullptr(h))
+   {
+      char line[160];
+      int count = xpc_profile_zone_count();
+      int id;
+      snprintf
+      (
+         line, sizeof line, "%-24s %10s %10s %10s %10s %10s %10s",
+         _("zone (us)"), _("count"), _("mean"), "p50", "p99", "p999", _("max")
+      );
+      if (not_NULL(fp))
+         fprintf(fp, "%s\n", line);
+      else
+         xpc_print(line);
+
+      for (id = 1; id <= count; ++id)
+      {
+         (void) pthread_mutex_lock(&gs_lock);
+         profile_merge_id(id, h);
+         (void) pthread_mutex_unlock(&gs_lock);
+         snprintf
+         (
+            line, sizeof line,
+            "%-24s %10lu %10.3f %10.3f %10.3f %10.3f %10.3f",
+            gs_names[id - 1], (unsigned long) h->m_Count,
+            xpc_histogram_mean(h) * 1.0e-3,
+            xpc_histogram_percentile(h, 50.0) * 1.0e-3,
+            xpc_histogram_percentile(h, 99.0) * 1.0e-3,
+            xpc_histogram_percentile(h, 99.9) * 1.0e-3,
+            h->m_Max * 1.0e-3
+         );
+         if (not_NULL(fp))
+            fprintf(fp, "%s\n", line);
+         else
+            xpc_print(line);
+      }
+      free(h);
+   }
+}
+
+/******************************************************************************
+ * xpc_profile_dump_file()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Appends the table of xpc_profile_dump() to a file.
+ *
+ * \return
+ *    Returns 'true' if the file could be opened.
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_profile_dump_file
+(
+   const char * filename         /**< The name of the file to append to.      */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(filename))
+   {
+      FILE * fp = fopen(filename, "a");
+      if (not_NULL(fp))
+      {
+         xpc_profile_dump(fp);
+         result = fclose(fp) == 0;
+      }
+      else
+         xpc_strerrnoprint_func(filename);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_profile_reset()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Empties all the histograms, to start a new measurement period.  The
+ *    zones stay registered.
+ *
+ *    A thread recording at the same moment can leave a count behind, or
+ *    lose one; call this at a quiet time if that matters.
+ *
+ * \unittests
+ *    -  profiler_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_profile_reset (void)
+{
+   profile_thread_t * pt;
+   int z;
+   (void) pthread_mutex_lock(&gs_lock);
+   for (z = 0; z < XPC_PROFILE_ZONE_MAX; ++z)
+   {
+      if (not_NULL(gs_retired[z]))
+         xpc_histogram_init(gs_retired[z]);
+   }
+   for (pt = gs_threads; not_NULL(pt); pt = pt->m_Next)
+   {
+      for (z = 0; z < XPC_PROFILE_ZONE_MAX; ++z)
+      {
+         xpc_histogram_t * h = xpc_atomic_load(&pt->m_Zones[z]);
+         if (not_NULL(h))
+            xpc_histogram_init(h);
+      }
+   }
+   (void) pthread_mutex_unlock(&gs_lock);
+}
+
+/******************************************************************************
+ * profiler.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
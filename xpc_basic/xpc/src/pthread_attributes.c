@@ -5,7 +5,7 @@
  * \file          pthread_attributes.c
  * \library       xpc_suite
  * \author        Chris Ahlstrom
- * \updates       05/01/2008-08/24/2009
+ * \updates       05/01/2008-08/14/2013
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
@@ -17,13 +17,30 @@
  *    For the XPC library, we're going to employ the pthreads_w32 LGPL library
  *    to map the POSIX threads API onto Windows.
  *
+ *    The extended attributes (pthread_attributes_ex_t) add CPU and NUMA
+ *    node affinity, real-time priority, and thread naming.  These use the
+ *    GNU pthread_*_np() extensions, and are refused (with a warning)
+ *    elsewhere.
+ *
  *    Also see pthread_attributes.h for more documentation.
  *
  *//*-------------------------------------------------------------------------*/
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE              1     /* pthread_attr_setaffinity_np(), etc. */
+#endif
+
 #include <xpc/errorlogging.h>          /* macros and external functions       */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
 #include <xpc/pthread_attributes.h>    /* pthread attribute functions         */
+#include <xpc/cpu.h>                   /* xpc_cpu_online_cpus(), etc.         */
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* strlen(), strncpy()                 */
+#endif
+
+#include <sched.h>                     /* sched_get_priority_min(), etc.      */
+
 XPC_REVISION(pthread_attributes)
 
 /******************************************************************************
@@ -36,10 +53,6 @@ XPC_REVISION(pthread_attributes)
  *    defaults described in pthread_attr_init(3), though some are set
  *    explicitly.
  *
- * \todo
- *    The priority setting is not yet supported; we have more learning to
- *    do.
- *
  * \return
  *    Returns 'true' if the parameter was valid and the setting succeeded.
  *
@@ -104,8 +117,9 @@ pthread_attributes_init
  *       of items as described in sched_setparam(2) and
  *       sched_setscheduler(2).  The priority item must be 0 for SCHED_OTHER
  *       and SCHED_BATCH.  The priority range for the realtime scheduling
- *       items is 1 to 99.
- *       <b> For now, the scheduling parameter is not supported.</b>
+ *       items is 1 to 99.  It is set here if it is not -1; see also
+ *       pthread_attributes_set_realtime(), which sets the policy and the
+ *       priority together.
  *    -  Scheduling policy and parameters inheritance.
  *       -  PTHREAD_EXPLICIT_SCHED [default].
  *       -  PTHREAD_INHERIT_SCHED.
@@ -121,9 +135,9 @@ pthread_attributes_init
  *       addresses are system-dependent, and right now this setting is not
  *       supported.  The pthread_attr_setstackaddr() and
  *       pthread_attr_getstackaddr() functions are deprecated, anyway.
- *    -  Processor affinity.  Currently not supported, even in the parameter
- *       list.  It is a non-portable GNU extension.  The process should use
- *       sched_affinity() instead.
+ *    -  Processor affinity.  Not in the parameter list, since it is a
+ *       non-portable GNU extension.  See pthread_attributes_set_cpu() and
+ *       pthread_attributes_set_node().
  *
  * \return
  *    Returns 'true' if the setting succeeded.
@@ -176,10 +190,9 @@ pthread_attributes_initialize
       }
       if (result && (priority != -1))
       {
-         /**
-          * \todo
-          *    rc = pthread_attr_setschedparam(attributes, ...);
-          */
+         struct sched_param param;
+         param.sched_priority = priority;
+         rc = pthread_attr_setschedparam(attributes, &param);
          if (not_posix_success(rc))
          {
             result = false;
@@ -288,11 +301,11 @@ pthread_attributes_get
       }
       if (result && (not_nullptr(priority)))
       {
-         /**
-          * \todo
-          *    rc = pthread_attr_getschedparam(attributes, ...);
-          */
-         if (not_posix_success(rc))
+         struct sched_param param;
+         rc = pthread_attr_getschedparam(attributes, &param);
+         if (is_posix_success(rc))
+            *priority = param.sched_priority;
+         else
          {
             result = false;
             xpc_strerrnoprint_func(_("pthread_attr_getschedparam() failed"));
@@ -526,6 +539,433 @@ pthread_attributes_set_detach_state
    return result;
 }
 
+/******************************************************************************
+ * attributes_cpuset() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Stores a CPU affinity set in the underlying POSIX attributes.
+ *
+ * \return
+ *    Returns 'true' if the affinity could be set.  It always fails where
+ *    pthread_attr_setaffinity_np() is not available.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+attributes_cpuset
+(
+   pthread_attributes_ex_t * ax, /**< The extended attributes to change.      */
+   const int * cpus,             /**< The CPUs the thread may run on.         */
+   int count                     /**< The number of CPUs in the list.         */
+)
+{
+   cbool_t result = false;
+#if defined __GLIBC__
+   cpu_set_t cpuset;
+   int c;
+   CPU_ZERO(&cpuset);
+   for (c = 0; c < count; ++c)
+   {
+      if (cpus[c] >= 0 && cpus[c] < CPU_SETSIZE)
+         CPU_SET(cpus[c], &cpuset);
+   }
+   if (CPU_COUNT(&cpuset) > 0)
+   {
+      int rc = pthread_attr_setaffinity_np
+      (
+         &ax->m_Attributes, sizeof(cpuset), &cpuset
+      );
+      result = is_posix_success(rc);
+      if (! result)
+         xpc_strerrprint_func(_("pthread_attr_setaffinity_np() failed"), rc);
+   }
+   else
+      xpc_errprint_func(_("no usable CPU"));
+#else
+   xpc_warnprint_func(_("CPU affinity not supported"));
+#endif
+   return result;
+}
+
+/******************************************************************************
+ * pthread_attributes_ex_init()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up an extended attributes structure with the XPC defaults of
+ *    pthread_attributes_init(), no CPU or node binding, the normal
+ *    scheduling policy, and no name.
+ *
+ * \return
+ *    Returns 'true' if the parameter was valid and the setup succeeded.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthread_attributes_ex_init
+(
+   pthread_attributes_ex_t * ax  /**< The extended attributes to set up.      */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(ax))
+   {
+      ax->m_Cpu = -1;
+      ax->m_Node = -1;
+      ax->m_Policy = -1;
+      ax->m_Priority = 0;
+      ax->m_Name[0] = 0;
+      result = pthread_attributes_init(&ax->m_Attributes);
+      ax->m_Ready = result;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthread_attributes_set_cpu()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Pins the thread to a single CPU.  See xpc_cpu_info() for choosing
+ *    one; for example, two threads that share data run best on the two
+ *    hyperthreads of one core, and two busy threads run best on different
+ *    cores.  Any earlier node binding is replaced.
+ *
+ * \return
+ *    Returns 'true' if the CPU is online (see xpc_cpu_online_cpus()) and
+ *    the affinity was set.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthread_attributes_set_cpu
+(
+   pthread_attributes_ex_t * ax, /**< The extended attributes to change.      */
+   int cpu                       /**< The logical CPU number.                 */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(ax) && ax->m_Ready)
+   {
+      int online[XPC_CPU_MAX];
+      int count = xpc_cpu_online_cpus(online, XPC_CPU_MAX);
+      cbool_t exists = false;
+      int c;
+      for (c = 0; c < count && c < XPC_CPU_MAX && ! exists; ++c)
+         exists = online[c] == cpu;
+
+      if (exists)
+      {
+         result = attributes_cpuset(ax, &cpu, 1);
+         if (result)
+         {
+            ax->m_Cpu = cpu;
+            ax->m_Node = -1;
+         }
+      }
+      else
+         xpc_errprint_func(_("no such CPU"));
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthread_attributes_set_node()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Restricts the thread to the CPUs of one NUMA node.
+ *
+ *    Memory is not bound explicitly (that would need libnuma).  Linux
+ *    places a page on the node of the thread that first touches it, so a
+ *    thread kept on one node gets node-local memory for the data it
+ *    allocates and initializes itself.  Any earlier CPU pinning is
+ *    replaced.
+ *
+ * \return
+ *    Returns 'true' if the node exists and the affinity was set.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthread_attributes_set_node
+(
+   pthread_attributes_ex_t * ax, /**< The extended attributes to change.      */
+   int node                      /**< The NUMA node number.                   */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(ax) && ax->m_Ready)
+   {
+      int cpus[XPC_CPU_MAX];
+      int count = xpc_cpu_node_cpus(node, cpus, XPC_CPU_MAX);
+      if (count > XPC_CPU_MAX)
+         count = XPC_CPU_MAX;
+
+      if (count > 0)
+      {
+         result = attributes_cpuset(ax, cpus, count);
+         if (result)
+         {
+            ax->m_Node = node;
+            ax->m_Cpu = -1;
+         }
+      }
+      else
+         xpc_errprint_func(_("no such NUMA node"));
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthread_attributes_set_realtime()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gives the thread a real-time scheduling policy and priority, instead
+ *    of inheriting the policy of the creating thread.
+ *
+ *    Linux checks the privilege (CAP_SYS_NICE, or an RLIMIT_RTPRIO limit)
+ *    only when the thread is created, so pthreader_create_ex() is where an
+ *    unprivileged caller sees the failure.
+ *
+ * \return
+ *    Returns 'true' if the policy is SCHED_FIFO or SCHED_RR, the priority
+ *    is in range for it, and the attributes were set.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthread_attributes_set_realtime
+(
+   pthread_attributes_ex_t * ax, /**< The extended attributes to change.      */
+   int policy,                   /**< SCHED_FIFO or SCHED_RR.                 */
+   int priority                  /**< The real-time priority (1 to 99).       */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(ax) && ax->m_Ready)
+   {
+      if (policy == SCHED_FIFO || policy == SCHED_RR)
+      {
+         if
+         (
+            priority >= sched_get_priority_min(policy) &&
+            priority <= sched_get_priority_max(policy)
+         )
+         {
+            struct sched_param param;
+            int rc = pthread_attr_setinheritsched
+            (
+               &ax->m_Attributes, PTHREAD_EXPLICIT_SCHED
+            );
+            if (is_posix_success(rc))
+               rc = pthread_attr_setschedpolicy(&ax->m_Attributes, policy);
+
+            if (is_posix_success(rc))
+            {
+               param.sched_priority = priority;
+               rc = pthread_attr_setschedparam(&ax->m_Attributes, &param);
+            }
+            result = is_posix_success(rc);
+            if (result)
+            {
+               ax->m_Policy = policy;
+               ax->m_Priority = priority;
+            }
+            else
+               xpc_strerrprint_func(_("failed"), rc);
+         }
+         else
+            xpc_errprint_func(_("priority out of range"));
+      }
+      else
+         xpc_errprint_func(_("not a real-time policy"));
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthread_attributes_set_name()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets the name the thread will get.  A name longer than
+ *    XPC_THREAD_NAME_MAX - 1 characters is truncated, with a warning.
+ *
+ * \return
+ *    Returns 'true' if the parameters were valid.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthread_attributes_set_name
+(
+   pthread_attributes_ex_t * ax, /**< The extended attributes to change.      */
+   const char * name             /**< The name of the thread.                 */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(ax) && not_nullptr(name))
+   {
+      if (strlen(name) >= XPC_THREAD_NAME_MAX)
+         xpc_warnprint_func(_("thread name truncated"));
+
+      (void) strncpy(ax->m_Name, name, XPC_THREAD_NAME_MAX - 1);
+      ax->m_Name[XPC_THREAD_NAME_MAX - 1] = 0;
+      result = true;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthread_attributes_apply()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Applies the CPU or node binding, the real-time policy, and the name
+ *    to a thread that is already running.  This is the way to place the
+ *    main thread, or a thread not made by pthreader_create_ex().
+ *
+ * \return
+ *    Returns 'true' if every setting that was made could be applied.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthread_attributes_apply
+(
+   pthread_t th,                       /**< The thread to change.             */
+   const pthread_attributes_ex_t * ax  /**< The settings to apply.            */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(ax) && ax->m_Ready)
+   {
+      int rc = POSIX_SUCCESS;
+      result = true;
+#if defined __GLIBC__
+      if (ax->m_Cpu >= 0 || ax->m_Node >= 0)
+      {
+         cpu_set_t cpuset;
+         rc = pthread_attr_getaffinity_np
+         (
+            &ax->m_Attributes, sizeof(cpuset), &cpuset
+         );
+         if (is_posix_success(rc))
+            rc = pthread_setaffinity_np(th, sizeof(cpuset), &cpuset);
+
+         if (not_posix_success(rc))
+         {
+            result = false;
+            xpc_strerrprint_func(_("pthread_setaffinity_np() failed"), rc);
+         }
+      }
+      if (ax->m_Name[0] != 0)
+      {
+         rc = pthread_setname_np(th, ax->m_Name);
+         if (not_posix_success(rc))
+         {
+            result = false;
+            xpc_strerrprint_func(_("pthread_setname_np() failed"), rc);
+         }
+      }
+#endif
+      if (ax->m_Policy != -1)
+      {
+         struct sched_param param;
+         param.sched_priority = ax->m_Priority;
+         rc = pthread_setschedparam(th, ax->m_Policy, &param);
+         if (not_posix_success(rc))
+         {
+            result = false;
+            xpc_strerrprint_func(_("pthread_setschedparam() failed"), rc);
+         }
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthread_attributes_ex_show()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Shows the underlying attributes, then the extended settings.
+ *
+ *    This showing is done only if xpc_showinfo() is 'true'.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+pthread_attributes_ex_show
+(
+   pthread_attributes_ex_t * ax  /**< The extended attributes to show.        */
+)
+{
+   if (is_thisptr(ax) && ax->m_Ready && xpc_showinfo())
+   {
+      pthread_attributes_show(&ax->m_Attributes);
+      xpc_infoprintf
+      (
+         "pthread_attributes_ex_t:\n"
+         "   cpu:             %d\n"
+         "   node:            %d\n"
+         "   rt policy:       %d\n"
+         "   rt priority:     %d\n"
+         "   name:            '%s'\n"
+         ,
+         ax->m_Cpu, ax->m_Node, ax->m_Policy, ax->m_Priority, ax->m_Name
+      );
+   }
+}
+
+/******************************************************************************
+ * pthread_attributes_ex_destroy()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Releases the underlying POSIX attributes.
+ *
+ * \return
+ *    Returns 'true' if the structure was set up and is now released.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthread_attributes_ex_destroy
+(
+   pthread_attributes_ex_t * ax  /**< The extended attributes to release.     */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(ax) && ax->m_Ready)
+   {
+      ax->m_Ready = false;
+      result = is_posix_success(pthread_attr_destroy(&ax->m_Attributes));
+   }
+   return result;
+}
+
 /******************************************************************************
  * pthread_attributes.c
  *-----------------------------------------------------------------------------
@@ -5,7 +5,7 @@
  * \file          pthreader.c
  * \library       xpc_suite
  * \author        Chris Ahlstrom
- * \updates       04/29/2008-05/17/2008
+ * \updates       04/29/2008-08/14/2013
  * \version       $Revision$
  * \license       $XPC_SUITE_GPL_LICENSE$
  *
@@ -36,6 +36,10 @@
  *
  *//*-------------------------------------------------------------------------*/
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE              1     /* pthread_setname_np()                */
+#endif
+
 #include <xpc/errorlogging.h>          /* macros and external functions       */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
 #include <xpc/integers.h>
@@ -47,6 +51,14 @@ XPC_REVISION(pthreader)
 #include <stddef.h>                    /* for intptr_t in Win32               */
 #endif
 
+#if XPC_HAVE_STDLIB_H
+#include <stdlib.h>                    /* malloc() and free()                 */
+#endif
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* memcpy()                            */
+#endif
+
 /******************************************************************************
  * pthreader_null_thread()
  *------------------------------------------------------------------------*//**
@@ -266,6 +278,134 @@ pthreader_create
    return result;
 }
 
+#if defined __GLIBC__
+
+/******************************************************************************
+ * pthreader_start_t [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Carries the thread function, its data, and the thread name to
+ *    pthreader_start(), for a thread created by pthreader_create_ex().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   pthreader_func_t m_Callback;        /**< The caller's thread function.     */
+   void * m_Data;                      /**< The caller's thread data.         */
+   char m_Name[XPC_THREAD_NAME_MAX];   /**< The name to give the thread.      */
+
+} pthreader_start_t;
+
+/******************************************************************************
+ * pthreader_start() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Names the new thread from inside it, then runs the caller's thread
+ *    function.  So the name is in place before the first line of the
+ *    thread function runs, rather than some time after the thread starts.
+ *
+ * \param start
+ *    The pthreader_start_t made by pthreader_create_ex().  It is freed
+ *    here, before the thread function is called.
+ *
+ * \return
+ *    Returns the return value of the thread function.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+pthreader_start (void * start)
+{
+   pthreader_start_t * ps = (pthreader_start_t *) start;
+   pthreader_func_t callback = ps->m_Callback;
+   void * data = ps->m_Data;
+   int rc = pthread_setname_np(pthread_self(), ps->m_Name);
+   if (not_posix_success(rc))
+      xpc_strerrprint_func(_("pthread_setname_np() failed"), rc);
+
+   free(ps);
+   return callback(data);
+}
+
+#endif   /* __GLIBC__ */
+
+/******************************************************************************
+ * pthreader_create_ex()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates a thread with extended attributes:  CPU or NUMA node affinity,
+ *    real-time scheduling, and a name.
+ *
+ *    The affinity and scheduling are already part of the underlying
+ *    attributes, and take effect as the thread starts.  The name is given
+ *    by the new thread itself, in pthreader_start(), before the thread
+ *    function is called.
+ *
+ * \return
+ *    The thread ID is returned if the thread was successfully created.
+ *    Otherwise, a "null" thread ID is returned.  Creation fails with EPERM
+ *    if a real-time policy was set and the process is not privileged to
+ *    use it.
+ *
+ * \unittests
+ *    -  syncher_thread_test_03_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+pthread_t
+pthreader_create_ex
+(
+   const pthread_attributes_ex_t * ax, /**< Initialized extended attributes.  */
+   pthreader_func_t thread_callback,   /**< The thread callback function.     */
+   void * thread_data                  /**< Optional data for the thread.     */
+)
+{
+   pthread_t result = pthreader_null_thread();
+   if (not_nullptr(ax))
+   {
+      if (ax->m_Ready)
+      {
+#if defined __GLIBC__
+         pthreader_start_t * ps = nullptr;
+         if
+         (
+            ax->m_Name[0] != 0 &&
+            not_NULL((void *) (intptr_t) thread_callback)
+         )
+         {
+            ps = malloc(sizeof(pthreader_start_t));
+            if (not_nullptr(ps))
+            {
+               ps->m_Callback = thread_callback;
+               ps->m_Data = thread_data;
+               memcpy(ps->m_Name, ax->m_Name, sizeof ps->m_Name);
+            }
+         }
+         if (not_NULL(ps))
+         {
+            result = pthreader_create(&ax->m_Attributes, pthreader_start, ps);
+            if (! pthreader_is_valid_thread(result))
+               free(ps);
+         }
+         else
+#endif
+         result = pthreader_create
+         (
+            &ax->m_Attributes, thread_callback, thread_data
+         );
+         if (! pthreader_is_valid_thread(result) && ax->m_Policy != -1)
+            xpc_warnprint_func(_("real-time scheduling needs privilege"));
+      }
+      else
+         xpc_errprint_func(_("attributes not initialized"));
+   }
+   return result;
+}
+
 /******************************************************************************
  * pthreader_yield()
  *------------------------------------------------------------------------*//**
@@ -0,0 +1,951 @@
+/******************************************************************************
+ * pthreader_pool.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          pthreader_pool.c
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \date          2013-08-13
+ * \updates       2013-08-13
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides a fixed-size pool of worker threads, with work stealing.
+ *
+ *    See pthreader_pool.h for the overview.  Some notes on the
+ *    implementation:
+ *
+ *       -  Each deque is guarded by its own adaptive syncher, rather than
+ *          being a lock-free (Chase-Lev) deque.  The owner is nearly
+ *          always the only one taking the lock, so it is almost always
+ *          uncontended, and it keeps the deque simple and easy to grow.
+ *       -  m_Pending counts the tasks sitting in the deques.  A worker
+ *          sleeps on m_Wake only while it is zero.  A submitter signals
+ *          m_Wake only if some worker is sleeping (m_Sleepers).  Each side
+ *          changes its own counter and then reads the other's, with a full
+ *          fence between, so that at least one of them sees the other, and
+ *          no wakeup is lost.
+ *       -  A thread waiting for a future, or for the pool to go idle, runs
+ *          queued tasks itself while there are any.  This keeps a task
+ *          that waits on tasks it submitted from deadlocking the pool.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* macros and external functions       */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/pthreader_pool.h>        /* pthreader_pool_t and its functions  */
+#include <xpc/pthread_attributes.h>    /* pthread_attributes_init()           */
+#include <xpc/atomix.h>                /* xpc_atomic_add(), xpc_thread_local  */
+
+#if XPC_HAVE_STDLIB_H
+#include <stdlib.h>                    /* malloc(), calloc(), and free()      */
+#endif
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* memset()                            */
+#endif
+
+#if XPC_HAVE_UNISTD_H
+#include <unistd.h>                    /* sysconf()                           */
+#endif
+
+XPC_REVISION(pthreader_pool)
+
+/******************************************************************************
+ * PTHREADER_POOL_DEQUE_SIZE
+ *------------------------------------------------------------------------*//**
+ *
+ *    The initial number of slots in each worker's deque.  It must be a
+ *    power of 2.  The deque doubles in size whenever it fills up.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define PTHREADER_POOL_DEQUE_SIZE      64
+
+/******************************************************************************
+ * pthreader_task_s
+ *------------------------------------------------------------------------*//**
+ *
+ *    Holds one task.  A plain task is freed by the thread that runs it.  A
+ *    future is freed by pthreader_future_wait(), once the result is taken;
+ *    the pool never frees a future, even after running it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+struct pthreader_task_s
+{
+   pthreader_func_t m_Func;            /**< The function to run.              */
+   void * m_Data;                      /**< The parameter of the function.    */
+   pthreader_done_t m_Done;            /**< The optional completion callback. */
+   void * m_Result;                    /**< The return value of the function. */
+   cbool_t m_Is_Future;                /**< If true, the result is waited for.*/
+   int m_Completed;                    /**< Set (atomically) when finished.   */
+};
+
+/******************************************************************************
+ * gs_current_worker
+ *------------------------------------------------------------------------*//**
+ *
+ *    Points to the worker that is running in this thread, if any, so that
+ *    a task submitted from inside the pool goes to the submitter's own
+ *    deque.  It is null for threads outside of any pool.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc_thread_local pthreader_worker_t * gs_current_worker;
+
+/******************************************************************************
+ * pool_random() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Advances a per-worker xorshift generator, used to pick the first
+ *    worker to steal from, so that idle workers do not all descend on the
+ *    same victim.
+ *
+ * \return
+ *    Returns the next pseudo-random value.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unsigned
+pool_random
+(
+   unsigned * seed               /**< The state of the generator.             */
+)
+{
+   unsigned x = *seed;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   *seed = x;
+   return x;
+}
+
+/******************************************************************************
+ * deque_push() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds a task to the bottom of a worker's deque, doubling the ring if it
+ *    is full.  The caller must hold the worker's lock.
+ *
+ * \return
+ *    Returns 'true' if the task was added.  It fails only if memory could
+ *    not be allocated.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+deque_push
+(
+   pthreader_worker_t * worker,  /**< The worker to get the task.             */
+   pthreader_task_t * task       /**< The task to add.                        */
+)
+{
+   cbool_t result = true;
+   if ((worker->m_Bottom - worker->m_Top) == worker->m_Capacity)
+   {
+      size_t capacity = worker->m_Capacity * 2;
+      pthreader_task_t ** tasks = calloc(capacity, sizeof(pthreader_task_t *));
+      if (not_nullptr(tasks))
+      {
+         size_t i;
+         for (i = worker->m_Top; i != worker->m_Bottom; ++i)
+         {
+            tasks[i & (capacity - 1)] =
+               worker->m_Tasks[i & (worker->m_Capacity - 1)];
+         }
+         free(worker->m_Tasks);
+         worker->m_Tasks = tasks;
+         worker->m_Capacity = capacity;
+      }
+      else
+         result = false;
+   }
+   if (result)
+   {
+      worker->m_Tasks[worker->m_Bottom & (worker->m_Capacity - 1)] = task;
+      ++worker->m_Bottom;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * deque_pop() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Takes the newest task from the bottom of a worker's deque.  This is
+ *    done only by the owner of the deque.  The caller must hold the
+ *    worker's lock.
+ *
+ * \return
+ *    Returns the task, or a null pointer if the deque is empty.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static pthreader_task_t *
+deque_pop
+(
+   pthreader_worker_t * worker   /**< The worker owning the deque.            */
+)
+{
+   pthreader_task_t * result = nullptr;
+   if (worker->m_Bottom != worker->m_Top)
+   {
+      --worker->m_Bottom;
+      result = worker->m_Tasks[worker->m_Bottom & (worker->m_Capacity - 1)];
+   }
+   return result;
+}
+
+/******************************************************************************
+ * deque_steal() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Takes the oldest task from the top of a worker's deque.  This is done
+ *    by the other workers, and by threads waiting on the pool.  The caller
+ *    must hold the worker's lock.
+ *
+ * \return
+ *    Returns the task, or a null pointer if the deque is empty.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static pthreader_task_t *
+deque_steal
+(
+   pthreader_worker_t * worker   /**< The worker to steal from.               */
+)
+{
+   pthreader_task_t * result = nullptr;
+   if (worker->m_Bottom != worker->m_Top)
+   {
+      result = worker->m_Tasks[worker->m_Top & (worker->m_Capacity - 1)];
+      ++worker->m_Top;
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pool_find_task() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the next task to run.  A worker first looks in its own deque.
+ *    Failing that (or if the caller is not a worker of this pool), the
+ *    deques of the workers are tried in turn, starting at a random one.
+ *
+ * \return
+ *    Returns the task, or a null pointer if no task is queued anywhere.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static pthreader_task_t *
+pool_find_task
+(
+   pthreader_pool_t * pool,      /**< The pool to get a task from.            */
+   pthreader_worker_t * self     /**< The calling worker, or a null pointer.  */
+)
+{
+   pthreader_task_t * result = nullptr;
+   if (xpc_atomic_load(&pool->m_Pending) > 0)
+   {
+      int count = pool->m_Worker_Count;
+      unsigned start;
+      int i;
+      if (not_NULL(self))
+      {
+         if (xpc_syncher_enter(&self->m_Lock))
+         {
+            result = deque_pop(self);
+            if (not_NULL(result))
+               (void) xpc_atomic_add(&pool->m_Pending, -1);
+
+            (void) xpc_syncher_leave(&self->m_Lock);
+         }
+         start = pool_random(&self->m_Seed);
+      }
+      else
+         start = xpc_atomic_add_relaxed(&pool->m_Next, 1);
+
+      for (i = 0; is_NULL(result) && i < count; ++i)
+      {
+         pthreader_worker_t * victim = &pool->m_Workers[(start + i) % count];
+         if (victim != self && xpc_syncher_enter(&victim->m_Lock))
+         {
+            result = deque_steal(victim);
+            if (not_NULL(result))
+               (void) xpc_atomic_add(&pool->m_Pending, -1);
+
+            (void) xpc_syncher_leave(&victim->m_Lock);
+            if (not_NULL(result) && not_NULL(self))
+               ++self->m_Stolen;
+         }
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pool_run_task() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Runs a task, then hands its result to the completion callback or to
+ *    the future, and wakes the waiters if this was the last outstanding
+ *    task.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+pool_run_task
+(
+   pthreader_pool_t * pool,      /**< The pool the task was submitted to.     */
+   pthreader_task_t * task       /**< The task to run.                        */
+)
+{
+   void * rvalue = task->m_Func(task->m_Data);
+   if (not_NULL(task->m_Done))
+      task->m_Done(rvalue, task->m_Data);
+
+   if (task->m_Is_Future)
+   {
+      task->m_Result = rvalue;
+      (void) pthread_mutex_lock(&pool->m_Sleep_Lock);
+      xpc_atomic_store(&task->m_Completed, 1);
+      (void) pthread_cond_broadcast(&pool->m_Done);
+      (void) pthread_mutex_unlock(&pool->m_Sleep_Lock);
+   }
+   else
+      free(task);
+
+   if (xpc_atomic_add(&pool->m_Outstanding, -1) == 1)
+   {
+      (void) pthread_mutex_lock(&pool->m_Sleep_Lock);
+      (void) pthread_cond_broadcast(&pool->m_Done);
+      (void) pthread_mutex_unlock(&pool->m_Sleep_Lock);
+   }
+}
+
+/******************************************************************************
+ * pool_worker() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the thread function of each worker.  It runs tasks until the
+ *    pool is stopping and no task is left, sleeping whenever there is
+ *    nothing to do.
+ *
+ * \return
+ *    Returns the worker parameter, for pthreader_join().
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+pool_worker
+(
+   void * data                   /**< The pthreader_worker_t of the thread.   */
+)
+{
+   pthreader_worker_t * self = (pthreader_worker_t *) data;
+   pthreader_pool_t * pool = self->m_Pool;
+   cbool_t running = true;
+   gs_current_worker = self;
+   while (running)
+   {
+      pthreader_task_t * task = pool_find_task(pool, self);
+      if (not_NULL(task))
+      {
+         pool_run_task(pool, task);
+         ++self->m_Executed;
+      }
+      else
+      {
+         (void) pthread_mutex_lock(&pool->m_Sleep_Lock);
+         (void) xpc_atomic_add(&pool->m_Sleepers, 1);
+         xpc_atomic_fence();
+         while
+         (
+            xpc_atomic_load(&pool->m_Pending) == 0 && ! pool->m_Stopping
+         )
+         {
+            (void) pthread_cond_wait(&pool->m_Wake, &pool->m_Sleep_Lock);
+         }
+         (void) xpc_atomic_add(&pool->m_Sleepers, -1);
+         if (pool->m_Stopping && xpc_atomic_load(&pool->m_Pending) == 0)
+            running = false;
+
+         (void) pthread_mutex_unlock(&pool->m_Sleep_Lock);
+      }
+   }
+   gs_current_worker = nullptr;
+   return data;
+}
+
+/******************************************************************************
+ * pool_release() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Frees the workers and the pool's own objects.  The worker threads must
+ *    already have been joined.  Only the first m_Worker_Count workers are
+ *    freed, since pthreader_pool_create() counts a worker only once its
+ *    syncher exists, so a pool whose creation failed partway is released
+ *    correctly.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+pool_release
+(
+   pthreader_pool_t * pool       /**< The pool to release.                    */
+)
+{
+   int w;
+   for (w = 0; w < pool->m_Worker_Count; ++w)
+   {
+      pthreader_worker_t * worker = &pool->m_Workers[w];
+      (void) xpc_syncher_destroy(&worker->m_Lock);
+      free(worker->m_Tasks);
+   }
+   free(pool->m_Workers);
+   (void) pthread_cond_destroy(&pool->m_Done);
+   (void) pthread_cond_destroy(&pool->m_Wake);
+   (void) pthread_mutex_destroy(&pool->m_Sleep_Lock);
+   pool->m_Workers = nullptr;
+   pool->m_Worker_Count = 0;
+   pool->m_Ready = false;
+}
+
+/******************************************************************************
+ * pool_stop() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tells the workers that the pool is stopping, and joins the first \a
+ *    count of them.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+pool_stop
+(
+   pthreader_pool_t * pool,      /**< The pool to stop.                       */
+   int count                     /**< The number of threads to join.          */
+)
+{
+   int w;
+   (void) pthread_mutex_lock(&pool->m_Sleep_Lock);
+   xpc_atomic_store(&pool->m_Stopping, true);
+   (void) pthread_cond_broadcast(&pool->m_Wake);
+   (void) pthread_mutex_unlock(&pool->m_Sleep_Lock);
+   for (w = 0; w < count; ++w)
+      (void) pthreader_join(pool->m_Workers[w].m_Thread);
+}
+
+/******************************************************************************
+ * pthreader_pool_create()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up a pool and starts its workers.
+ *
+ *    Each worker gets an adaptive syncher for its deque, and a thread made
+ *    by pthreader_create() with the default XPC thread attributes.
+ *
+ * \return
+ *    Returns 'true' if all of the workers were started.  Otherwise, any
+ *    workers already started are stopped, and 'false' is returned.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthreader_pool_create
+(
+   pthreader_pool_t * pool,      /**< The pool to set up.                     */
+   int workers                   /**< The number of workers.  If 0 or less,
+                                      one per online CPU is started.          */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(pool))
+   {
+      if (workers <= 0)
+      {
+#if XPC_HAVE_UNISTD_H
+         workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+         if (workers <= 0)
+            workers = 1;
+      }
+      (void) memset(pool, 0, sizeof(*pool));
+      pool->m_Workers = calloc((size_t) workers, sizeof(pthreader_worker_t));
+      if (not_nullptr(pool->m_Workers))
+      {
+         pthread_attr_t attributes;
+         int w;
+         (void) pthread_mutex_init(&pool->m_Sleep_Lock, nullptr);
+         (void) pthread_cond_init(&pool->m_Wake, nullptr);
+         (void) pthread_cond_init(&pool->m_Done, nullptr);
+         result = true;
+         for (w = 0; w < workers && result; ++w)
+         {
+            pthreader_worker_t * worker = &pool->m_Workers[w];
+            worker->m_Pool = pool;
+            worker->m_Seed = (unsigned) w + 1;
+            worker->m_Capacity = PTHREADER_POOL_DEQUE_SIZE;
+            result = xpc_syncher_create_adaptive(&worker->m_Lock, -1);
+            if (result)
+            {
+               ++pool->m_Worker_Count;       /* pool_release() undoes it    */
+               worker->m_Tasks = malloc
+               (
+                  PTHREADER_POOL_DEQUE_SIZE * sizeof(pthreader_task_t *)
+               );
+               result = not_nullptr(worker->m_Tasks);
+            }
+         }
+         if (result)
+            result = pthread_attributes_init(&attributes);
+
+         if (result)
+         {
+            for (w = 0; w < workers; ++w)
+            {
+               pthreader_worker_t * worker = &pool->m_Workers[w];
+               worker->m_Thread = pthreader_create
+               (
+                  &attributes, pool_worker, worker
+               );
+               if (! pthreader_is_valid_thread(worker->m_Thread))
+               {
+                  pool_stop(pool, w);
+                  result = false;
+                  break;
+               }
+            }
+            (void) pthread_attr_destroy(&attributes);
+         }
+         if (result)
+            pool->m_Ready = true;
+         else
+         {
+            xpc_errprint_func(_("could not start the workers"));
+            pool_release(pool);
+         }
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pool_queue() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Queues a task.  A task submitted by a worker of the same pool goes to
+ *    that worker's deque; any other goes to the next worker in turn.  A
+ *    sleeping worker is woken if there is one.
+ *
+ *    Once the pool is stopping, only its own workers may still submit
+ *    tasks, so that a task can finish the work it has split up.
+ *
+ * \return
+ *    Returns 'true' if the task was queued.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+pool_queue
+(
+   pthreader_pool_t * pool,      /**< The pool to queue the task on.          */
+   pthreader_task_t * task       /**< The task to queue.                      */
+)
+{
+   cbool_t result = false;
+   pthreader_worker_t * worker = gs_current_worker;
+   if (is_NULL(worker) || worker->m_Pool != pool)
+   {
+      if (xpc_atomic_load(&pool->m_Stopping))
+         worker = nullptr;
+      else
+      {
+         unsigned next = xpc_atomic_add_relaxed(&pool->m_Next, 1);
+         worker = &pool->m_Workers[next % (unsigned) pool->m_Worker_Count];
+      }
+   }
+   if (not_NULL(worker))
+   {
+      (void) xpc_atomic_add(&pool->m_Outstanding, 1);
+      if (xpc_syncher_enter(&worker->m_Lock))
+      {
+         result = deque_push(worker, task);
+         if (result)
+            (void) xpc_atomic_add(&pool->m_Pending, 1);
+
+         (void) xpc_syncher_leave(&worker->m_Lock);
+      }
+      if (result)
+      {
+         xpc_atomic_fence();
+         if (xpc_atomic_load(&pool->m_Sleepers) > 0)
+         {
+            (void) pthread_mutex_lock(&pool->m_Sleep_Lock);
+            (void) pthread_cond_signal(&pool->m_Wake);
+            (void) pthread_mutex_unlock(&pool->m_Sleep_Lock);
+         }
+      }
+      else
+         (void) xpc_atomic_add(&pool->m_Outstanding, -1);
+   }
+   else
+      xpc_errprint_func(_("pool is stopping"));
+
+   return result;
+}
+
+/******************************************************************************
+ * pool_new_task() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Allocates and fills in a task.
+ *
+ * \return
+ *    Returns the task, or a null pointer if the parameters are bad or
+ *    memory could not be allocated.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static pthreader_task_t *
+pool_new_task
+(
+   pthreader_pool_t * pool,      /**< The pool the task is for.               */
+   pthreader_func_t func,        /**< The function to run.                    */
+   void * data,                  /**< The parameter of the function.          */
+   pthreader_done_t done,        /**< The optional completion callback.       */
+   cbool_t future                /**< If true, the result will be waited for. */
+)
+{
+   pthreader_task_t * result = nullptr;
+   if (not_nullptr(pool) && not_nullptr((void *) (intptr_t) func))
+   {
+      if (pool->m_Ready)
+      {
+         result = malloc(sizeof(pthreader_task_t));
+         if (not_nullptr(result))
+         {
+            result->m_Func = func;
+            result->m_Data = data;
+            result->m_Done = done;
+            result->m_Result = nullptr;
+            result->m_Is_Future = future;
+            result->m_Completed = 0;
+         }
+      }
+      else
+         xpc_errprint_func(_("pool not ready"));
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthreader_pool_submit()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Queues a task whose result is not waited for.
+ *
+ *    The optional \a done callback is called by the thread that ran the
+ *    task, right after it, with the task's return value and \a data.  It
+ *    can be used to free the data, or to pass the result on.
+ *
+ * \return
+ *    Returns 'true' if the task was queued.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthreader_pool_submit
+(
+   pthreader_pool_t * pool,      /**< The pool to run the task.               */
+   pthreader_func_t task,        /**< The function to run.                    */
+   void * data,                  /**< The parameter of the function.          */
+   pthreader_done_t done         /**< The completion callback, or null.       */
+)
+{
+   cbool_t result = false;
+   pthreader_task_t * t = pool_new_task(pool, task, data, done, false);
+   if (not_NULL(t))
+   {
+      result = pool_queue(pool, t);
+      if (! result)
+         free(t);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthreader_pool_async()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Queues a task whose result is collected later.
+ *
+ *    The returned future belongs to the caller, who must pass it to
+ *    pthreader_future_wait() exactly once, which frees it.  The pool does
+ *    not free a future when its task finishes, so a future that is never
+ *    waited for is leaked.  If the result is not needed, use
+ *    pthreader_pool_submit() instead.
+ *
+ * \return
+ *    Returns the future of the task, or a null pointer if the task could
+ *    not be queued.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+pthreader_future_t *
+pthreader_pool_async
+(
+   pthreader_pool_t * pool,      /**< The pool to run the task.               */
+   pthreader_func_t task,        /**< The function to run.                    */
+   void * data                   /**< The parameter of the function.          */
+)
+{
+   pthreader_future_t * result = pool_new_task(pool, task, data, nullptr, true);
+   if (not_NULL(result))
+   {
+      if (! pool_queue(pool, result))
+      {
+         free(result);
+         result = nullptr;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthreader_future_ready()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Checks, without waiting, whether the task of a future has finished.
+ *
+ * \return
+ *    Returns 'true' if the result is available.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthreader_future_ready
+(
+   const pthreader_future_t * future   /**< The future to check.              */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(future))
+      result = xpc_atomic_load(&future->m_Completed) != 0;
+
+   return result;
+}
+
+/******************************************************************************
+ * pthreader_future_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Waits for the task of a future to finish, and frees the future.
+ *
+ *    While waiting, the caller runs queued tasks of the pool itself.  So a
+ *    task may wait on futures of its own, as long as the pool is the same.
+ *
+ * \return
+ *    Returns the value the task returned.  A null pointer is also returned
+ *    if the parameters are bad.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void *
+pthreader_future_wait
+(
+   pthreader_pool_t * pool,            /**< The pool running the task.        */
+   pthreader_future_t * future         /**< The future to wait for.           */
+)
+{
+   void * result = nullptr;
+   if (not_nullptr(pool) && not_nullptr(future))
+   {
+      pthreader_worker_t * self = gs_current_worker;
+      if (not_NULL(self) && self->m_Pool != pool)
+         self = nullptr;
+
+      while (! pthreader_future_ready(future))
+      {
+         pthreader_task_t * task = pool_find_task(pool, self);
+         if (not_NULL(task))
+            pool_run_task(pool, task);
+         else
+         {
+            (void) pthread_mutex_lock(&pool->m_Sleep_Lock);
+            if (! pthreader_future_ready(future))
+               (void) pthread_cond_wait(&pool->m_Done, &pool->m_Sleep_Lock);
+
+            (void) pthread_mutex_unlock(&pool->m_Sleep_Lock);
+         }
+      }
+      result = future->m_Result;
+      free(future);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthreader_pool_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Waits until every task submitted so far (and every task those tasks
+ *    submitted) has finished.  The caller helps run them.
+ *
+ *    This function must not be called from a task of the same pool, since
+ *    that task itself is outstanding.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+pthreader_pool_wait
+(
+   pthreader_pool_t * pool       /**< The pool to wait for.                   */
+)
+{
+   if (not_nullptr(pool))
+   {
+      while (xpc_atomic_load(&pool->m_Outstanding) > 0)
+      {
+         pthreader_task_t * task = pool_find_task(pool, nullptr);
+         if (not_NULL(task))
+            pool_run_task(pool, task);
+         else
+         {
+            (void) pthread_mutex_lock(&pool->m_Sleep_Lock);
+            if (xpc_atomic_load(&pool->m_Outstanding) > 0)
+               (void) pthread_cond_wait(&pool->m_Done, &pool->m_Sleep_Lock);
+
+            (void) pthread_mutex_unlock(&pool->m_Sleep_Lock);
+         }
+      }
+   }
+}
+
+/******************************************************************************
+ * pthreader_pool_size()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the number of workers in the pool.
+ *
+ * \return
+ *    Returns the number of workers, or 0 if the pool is not running.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+pthreader_pool_size
+(
+   const pthreader_pool_t * pool /**< The pool to check.                      */
+)
+{
+   int result = 0;
+   if (not_nullptr(pool) && pool->m_Ready)
+      result = pool->m_Worker_Count;
+
+   return result;
+}
+
+/******************************************************************************
+ * pthreader_pool_destroy()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Shuts the pool down gracefully.
+ *
+ *    No more tasks are accepted from outside the pool.  The tasks already
+ *    queued are run, the workers are joined, and the pool is freed.
+ *    Futures not yet waited for stay valid, and must still be passed to
+ *    pthreader_future_wait() (which returns at once) to free them.
+ *
+ * \return
+ *    Returns 'true' if the pool was running.
+ *
+ * \unittests
+ *    -  syncher_thread_test_02_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+pthreader_pool_destroy
+(
+   pthreader_pool_t * pool       /**< The pool to shut down.                  */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(pool))
+   {
+      if (pool->m_Ready)
+      {
+         pool_stop(pool, pool->m_Worker_Count);
+         pool_release(pool);
+         result = true;
+      }
+      else
+         xpc_errprint_func(_("pool not ready"));
+   }
+   return result;
+}
+
+/******************************************************************************
+ * pthreader_pool.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
@@ -0,0 +1,1083 @@
+/******************************************************************************
+ * queues.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          queues.c
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \date          2013-08-15
+ * \updates       2013-08-15
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    Provides bounded lock-free SPSC and MPMC queues of pointers, and the
+ *    event-count used to block on them.
+ *
+ *    See queues.h for the overview.  Some notes on the implementation:
+ *
+ *       -  A successful push notifies m_Not_Empty, and a successful pop
+ *          notifies m_Not_Full.  The notify is a full fence plus a load of
+ *          the waiter count, and makes a system call only when a thread is
+ *          actually waiting.  The batch functions notify once per batch.
+ *       -  The fence is what makes the waiting safe:  the waiter bumps the
+ *          waiter count and then re-checks the queue, while the notifier
+ *          changes the queue and then checks the waiter count, so one of
+ *          them always sees the other.
+ *
+ * \win32
+ *    Without futexes, a waiting thread just yields the processor and
+ *    checks again.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* macros and external functions       */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/queues.h>                /* xpc_spsc_queue_t, xpc_mpmc_queue_t  */
+#include <xpc/pthreader.h>             /* pthreader_yield()                   */
+
+#if XPC_HAVE_STDLIB_H
+#include <stdlib.h>                    /* malloc() and free()                 */
+#endif
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* memset()                            */
+#endif
+
+#if defined __linux__
+#include <limits.h>                    /* INT_MAX                             */
+#include <linux/futex.h>               /* FUTEX_WAIT_PRIVATE, etc.            */
+#include <sys/syscall.h>               /* SYS_futex                           */
+#include <unistd.h>                    /* syscall()                           */
+#endif
+
+XPC_REVISION(queues)
+
+/******************************************************************************
+ * queue_round_up() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Rounds a queue capacity up to a power of 2, of at least 2.
+ *
+ * \return
+ *    Returns the rounded capacity, or 0 if it would overflow.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static size_t
+queue_round_up
+(
+   size_t capacity               /**< The capacity asked for.                 */
+)
+{
+   size_t result = 2;
+   while (result != 0 && result < capacity)
+      result <<= 1;
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_eventcount_init()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up an event-count with no waiters.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_eventcount_init
+(
+   xpc_eventcount_t * ec         /**< The event-count to set up.              */
+)
+{
+   if (not_nullptr(ec))
+   {
+      ec->m_Sequence = 0;
+      ec->m_Waiters = 0;
+   }
+}
+
+/******************************************************************************
+ * xpc_eventcount_prepare()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Announces that the caller is about to wait.  The caller must then
+ *    check its condition again, and call xpc_eventcount_cancel() or
+ *    xpc_eventcount_wait().
+ *
+ * \return
+ *    Returns the key to pass to xpc_eventcount_wait().
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+xpc_eventcount_prepare
+(
+   xpc_eventcount_t * ec         /**< The event-count to wait on.             */
+)
+{
+   (void) xpc_atomic_add(&ec->m_Waiters, 1);
+   xpc_atomic_fence();
+   return xpc_atomic_load(&ec->m_Sequence);
+}
+
+/******************************************************************************
+ * xpc_eventcount_cancel()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Withdraws an xpc_eventcount_prepare(), when the condition turned out
+ *    to be true after all.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_eventcount_cancel
+(
+   xpc_eventcount_t * ec         /**< The event-count not to wait on.         */
+)
+{
+   (void) xpc_atomic_add(&ec->m_Waiters, -1);
+}
+
+/******************************************************************************
+ * xpc_eventcount_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sleeps until a notify happens after the xpc_eventcount_prepare() that
+ *    returned the key.  If one already happened, it returns at once.  It
+ *    can also return spuriously, so the caller re-checks its condition in
+ *    a loop.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_eventcount_wait
+(
+   xpc_eventcount_t * ec,        /**< The event-count to wait on.             */
+   int key                       /**< The value xpc_eventcount_prepare() gave.*/
+)
+{
+#if defined __linux__
+   (void) syscall
+   (
+      SYS_futex, &ec->m_Sequence, FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0
+   );
+#else
+   if (xpc_atomic_load(&ec->m_Sequence) == key)
+      pthreader_yield();
+#endif
+   (void) xpc_atomic_add(&ec->m_Waiters, -1);
+}
+
+/******************************************************************************
+ * xpc_eventcount_notify()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Wakes every thread waiting on the event-count.  When nobody is
+ *    waiting, this is only a fence and a load.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_eventcount_notify
+(
+   xpc_eventcount_t * ec         /**< The event-count to signal.              */
+)
+{
+   xpc_atomic_fence();
+   if (xpc_atomic_load_relaxed(&ec->m_Waiters) > 0)
+   {
+      (void) xpc_atomic_add(&ec->m_Sequence, 1);
+#if defined __linux__
+      (void) syscall
+      (
+         SYS_futex, &ec->m_Sequence, FUTEX_WAKE_PRIVATE, INT_MAX,
+         nullptr, nullptr, 0
+      );
+#endif
+   }
+}
+
+/******************************************************************************
+ * queue_try_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    The type of the non-blocking push or pop that queue_wait() retries.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef cbool_t (* queue_try_t) (void * q, void * item);
+
+/******************************************************************************
+ * queue_wait() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Retries a push or pop until it succeeds or the queue is closed,
+ *    sleeping on the event-count in between.  The closed flag is checked
+ *    again after each wake-up, before the next try.  Once the queue is
+ *    closed, a pop gets one last try, so that a consumer still drains the
+ *    items left in a closed queue; a push fails at once, so that no push
+ *    that was blocked when xpc_..._queue_close() was called can succeed
+ *    after it returns.
+ *
+ * \return
+ *    Returns 'true' if the operation succeeded.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+queue_wait
+(
+   void * q,                     /**< The queue.                              */
+   queue_try_t attempt,          /**< The non-blocking operation.             */
+   void * item,                  /**< The item, or where to put it.           */
+   xpc_eventcount_t * ec,        /**< The event-count to sleep on.            */
+   const int * closed,           /**< The closed flag of the queue.           */
+   cbool_t drain                 /**< Try once more after closing (pops).     */
+)
+{
+   cbool_t result = attempt(q, item);
+   while (! result)
+   {
+      if (xpc_atomic_load(closed))
+      {
+         if (drain)
+            result = attempt(q, item);
+
+         break;
+      }
+      else
+      {
+         int key = xpc_eventcount_prepare(ec);
+         result = attempt(q, item);
+         if (result || xpc_atomic_load(closed))
+            xpc_eventcount_cancel(ec);
+         else
+            xpc_eventcount_wait(ec, key);
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_create()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up an empty single-producer/single-consumer queue.
+ *
+ * \return
+ *    Returns 'true' if the ring could be allocated.
+ *
+ * \unittests
+ *    -  queues_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_spsc_queue_create
+(
+   xpc_spsc_queue_t * q,         /**< The queue to set up.                    */
+   size_t capacity               /**< The number of items it can hold.  It is
+                                      rounded up to a power of 2.             */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(q))
+   {
+      size_t size = queue_round_up(capacity);
+      (void) memset(q, 0, sizeof(*q));
+      if (size > 0)
+         q->m_Slots = malloc(size * sizeof(void *));
+
+      if (not_nullptr(q->m_Slots))
+      {
+         q->m_Mask = size - 1;
+         xpc_eventcount_init(&q->m_Not_Empty);
+         xpc_eventcount_init(&q->m_Not_Full);
+         result = true;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_push()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds an item, without blocking.  Only the producer thread may call
+ *    this function.
+ *
+ * \return
+ *    Returns 'true' if the item was added, and 'false' if the queue was
+ *    full.
+ *
+ * \unittests
+ *    -  queues_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_spsc_queue_push
+(
+   xpc_spsc_queue_t * q,         /**< The queue to add to.                    */
+   void * item                   /**< The item to add.                        */
+)
+{
+   return xpc_spsc_queue_push_batch(q, &item, 1) == 1;
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_pop()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Removes the oldest item, without blocking.  Only the consumer thread
+ *    may call this function.
+ *
+ * \return
+ *    Returns 'true' if an item was removed, and 'false' if the queue was
+ *    empty.
+ *
+ * \unittests
+ *    -  queues_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_spsc_queue_pop
+(
+   xpc_spsc_queue_t * q,         /**< The queue to remove from.               */
+   void ** item                  /**< Receives the item.                      */
+)
+{
+   return xpc_spsc_queue_pop_batch(q, item, 1) == 1;
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_push_batch()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds as many of the items as there is room for, without blocking.
+ *    Only the producer thread may call this function.
+ *
+ * \return
+ *    Returns the number of items added, from the front of the array.
+ *
+ * \unittests
+ *    -  queues_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_spsc_queue_push_batch
+(
+   xpc_spsc_queue_t * q,         /**< The queue to add to.                    */
+   void * const * items,         /**< The items to add.                       */
+   size_t count                  /**< The number of items.                    */
+)
+{
+   size_t result = 0;
+   size_t tail = q->m_Tail;
+   size_t room = q->m_Mask + 1 - (tail - q->m_Head_Cache);
+   if (room < count)
+   {
+      q->m_Head_Cache = xpc_atomic_load(&q->m_Head);
+      room = q->m_Mask + 1 - (tail - q->m_Head_Cache);
+   }
+   if (count > room)
+      count = room;
+
+   for (result = 0; result < count; ++result)
+      q->m_Slots[(tail + result) & q->m_Mask] = items[result];
+
+   if (result > 0)
+   {
+      xpc_atomic_store(&q->m_Tail, tail + result);
+      xpc_eventcount_notify(&q->m_Not_Empty);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_pop_batch()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Removes up to \a count of the oldest items, without blocking.  Only
+ *    the consumer thread may call this function.
+ *
+ * \return
+ *    Returns the number of items removed.
+ *
+ * \unittests
+ *    -  queues_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_spsc_queue_pop_batch
+(
+   xpc_spsc_queue_t * q,         /**< The queue to remove from.               */
+   void ** items,                /**< Receives the items.                     */
+   size_t count                  /**< The most items to remove.               */
+)
+{
+   size_t result = 0;
+   size_t head = q->m_Head;
+   size_t available = q->m_Tail_Cache - head;
+   if (available < count)
+   {
+      q->m_Tail_Cache = xpc_atomic_load(&q->m_Tail);
+      available = q->m_Tail_Cache - head;
+   }
+   if (count > available)
+      count = available;
+
+   for (result = 0; result < count; ++result)
+      items[result] = q->m_Slots[(head + result) & q->m_Mask];
+
+   if (result > 0)
+   {
+      xpc_atomic_store(&q->m_Head, head + result);
+      xpc_eventcount_notify(&q->m_Not_Full);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * spsc_try_push() and spsc_try_pop() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adapt the SPSC push and pop to queue_wait().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+spsc_try_push (void * q, void * item)
+{
+   return xpc_spsc_queue_push((xpc_spsc_queue_t *) q, item);
+}
+
+static cbool_t
+spsc_try_pop (void * q, void * item)
+{
+   return xpc_spsc_queue_pop((xpc_spsc_queue_t *) q, (void **) item);
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_push_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds an item, waiting for room if the queue is full.
+ *
+ * \return
+ *    Returns 'true' if the item was added, and 'false' if the queue was
+ *    closed first.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_spsc_queue_push_wait
+(
+   xpc_spsc_queue_t * q,         /**< The queue to add to.                    */
+   void * item                   /**< The item to add.                        */
+)
+{
+   cbool_t result = false;
+   if (! xpc_atomic_load(&q->m_Closed))
+   {
+      result = queue_wait
+      (
+         q, spsc_try_push, item, &q->m_Not_Full, &q->m_Closed, false
+      );
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_pop_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Removes the oldest item, waiting for one if the queue is empty.
+ *
+ * \return
+ *    Returns 'true' if an item was removed, and 'false' if the queue is
+ *    closed and empty.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_spsc_queue_pop_wait
+(
+   xpc_spsc_queue_t * q,         /**< The queue to remove from.               */
+   void ** item                  /**< Receives the item.                      */
+)
+{
+   return queue_wait
+   (
+      q, spsc_try_pop, (void *) item, &q->m_Not_Empty, &q->m_Closed, true
+   );
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_count()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the number of items in the queue.  If the other side is busy,
+ *    the count may already be out of date.
+ *
+ * \return
+ *    Returns the number of items queued.
+ *
+ * \unittests
+ *    -  queues_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_spsc_queue_count
+(
+   const xpc_spsc_queue_t * q    /**< The queue to check.                     */
+)
+{
+   size_t head = xpc_atomic_load(&q->m_Head);
+   return xpc_atomic_load(&q->m_Tail) - head;
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_close()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Closes the queue, waking all waiters.  After this, the wait functions
+ *    no longer block:  pushes fail, and pops fail once the queue is empty.
+ *    The non-blocking functions still work.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_spsc_queue_close
+(
+   xpc_spsc_queue_t * q          /**< The queue to close.                     */
+)
+{
+   xpc_atomic_store(&q->m_Closed, 1);
+   xpc_eventcount_notify(&q->m_Not_Empty);
+   xpc_eventcount_notify(&q->m_Not_Full);
+}
+
+/******************************************************************************
+ * xpc_spsc_queue_destroy()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Frees the ring.  No thread may be using the queue.  Items still in it
+ *    are not freed.
+ *
+ * \return
+ *    Returns 'true' if the queue had been created.
+ *
+ * \unittests
+ *    -  queues_test_01_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_spsc_queue_destroy
+(
+   xpc_spsc_queue_t * q          /**< The queue to free.                      */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(q))
+   {
+      if (not_NULL(q->m_Slots))
+      {
+         free(q->m_Slots);
+         q->m_Slots = nullptr;
+         result = true;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_create()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Sets up an empty multi-producer/multi-consumer queue.  Each cell gets
+ *    its own position as its sequence number, marking it free to push.
+ *
+ * \return
+ *    Returns 'true' if the cells could be allocated.
+ *
+ * \unittests
+ *    -  queues_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_mpmc_queue_create
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to set up.                    */
+   size_t capacity               /**< The number of items it can hold.  It is
+                                      rounded up to a power of 2.             */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(q))
+   {
+      size_t size = queue_round_up(capacity);
+      (void) memset(q, 0, sizeof(*q));
+      if (size > 0)
+         q->m_Cells = malloc(size * sizeof(xpc_mpmc_cell_t));
+
+      if (not_nullptr(q->m_Cells))
+      {
+         size_t c;
+         for (c = 0; c < size; ++c)
+         {
+            q->m_Cells[c].m_Sequence = c;
+            q->m_Cells[c].m_Data = nullptr;
+         }
+         q->m_Mask = size - 1;
+         xpc_eventcount_init(&q->m_Not_Empty);
+         xpc_eventcount_init(&q->m_Not_Full);
+         result = true;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * mpmc_push() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Claims the next push position and fills its cell, without notifying.
+ *
+ *    A cell whose sequence equals the position is free; the position is
+ *    claimed by advancing m_Enqueue with a CAS.  A sequence behind the
+ *    position means the cell still holds an item from the previous lap,
+ *    so the queue is full.  A sequence ahead means another producer got
+ *    there first, so the position is reloaded.
+ *
+ * \return
+ *    Returns 'true' if the item was added.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+mpmc_push
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to add to.                    */
+   void * item                   /**< The item to add.                        */
+)
+{
+   cbool_t result = false;
+   xpc_mpmc_cell_t * cell = nullptr;
+   size_t pos = xpc_atomic_load_relaxed(&q->m_Enqueue);
+   for (;;)
+   {
+      intptr_t diff;
+      cell = &q->m_Cells[pos & q->m_Mask];
+      diff = (intptr_t) xpc_atomic_load(&cell->m_Sequence) - (intptr_t) pos;
+      if (diff == 0)
+      {
+         if (xpc_atomic_cas(&q->m_Enqueue, &pos, pos + 1))
+         {
+            result = true;
+            break;
+         }
+      }
+      else if (diff < 0)
+         break;
+      else
+         pos = xpc_atomic_load_relaxed(&q->m_Enqueue);
+   }
+   if (result)
+   {
+      cell->m_Data = item;
+      xpc_atomic_store(&cell->m_Sequence, pos + 1);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * mpmc_pop() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Claims the next pop position and empties its cell, without notifying.
+ *    The cell's sequence is then set one lap ahead, freeing it for the
+ *    producers.
+ *
+ * \return
+ *    Returns 'true' if an item was removed.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+mpmc_pop
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to remove from.               */
+   void ** item                  /**< Receives the item.                      */
+)
+{
+   cbool_t result = false;
+   xpc_mpmc_cell_t * cell = nullptr;
+   size_t pos = xpc_atomic_load_relaxed(&q->m_Dequeue);
+   for (;;)
+   {
+      intptr_t diff;
+      cell = &q->m_Cells[pos & q->m_Mask];
+      diff = (intptr_t) xpc_atomic_load(&cell->m_Sequence) -
+         (intptr_t) (pos + 1);
+
+      if (diff == 0)
+      {
+         if (xpc_atomic_cas(&q->m_Dequeue, &pos, pos + 1))
+         {
+            result = true;
+            break;
+         }
+      }
+      else if (diff < 0)
+         break;
+      else
+         pos = xpc_atomic_load_relaxed(&q->m_Dequeue);
+   }
+   if (result)
+   {
+      *item = cell->m_Data;
+      xpc_atomic_store(&cell->m_Sequence, pos + q->m_Mask + 1);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_push()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds an item, without blocking.  Any thread may call this function.
+ *
+ * \return
+ *    Returns 'true' if the item was added, and 'false' if the queue was
+ *    full.
+ *
+ * \unittests
+ *    -  queues_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_mpmc_queue_push
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to add to.                    */
+   void * item                   /**< The item to add.                        */
+)
+{
+   cbool_t result = mpmc_push(q, item);
+   if (result)
+      xpc_eventcount_notify(&q->m_Not_Empty);
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_pop()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Removes the oldest item, without blocking.  Any thread may call this
+ *    function.
+ *
+ * \return
+ *    Returns 'true' if an item was removed, and 'false' if the queue was
+ *    empty.
+ *
+ * \unittests
+ *    -  queues_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_mpmc_queue_pop
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to remove from.               */
+   void ** item                  /**< Receives the item.                      */
+)
+{
+   cbool_t result = mpmc_pop(q, item);
+   if (result)
+      xpc_eventcount_notify(&q->m_Not_Full);
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_push_batch()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds as many of the items as there is room for, without blocking.
+ *    Each item claims its own cell, so items from other producers may be
+ *    interleaved with the batch; only the wakeup check is shared.
+ *
+ * \return
+ *    Returns the number of items added, from the front of the array.
+ *
+ * \unittests
+ *    -  queues_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_mpmc_queue_push_batch
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to add to.                    */
+   void * const * items,         /**< The items to add.                       */
+   size_t count                  /**< The number of items.                    */
+)
+{
+   size_t result = 0;
+   while (result < count && mpmc_push(q, items[result]))
+      ++result;
+
+   if (result > 0)
+      xpc_eventcount_notify(&q->m_Not_Empty);
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_pop_batch()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Removes up to \a count of the oldest items, without blocking.
+ *
+ * \return
+ *    Returns the number of items removed.
+ *
+ * \unittests
+ *    -  queues_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_mpmc_queue_pop_batch
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to remove from.               */
+   void ** items,                /**< Receives the items.                     */
+   size_t count                  /**< The most items to remove.               */
+)
+{
+   size_t result = 0;
+   while (result < count && mpmc_pop(q, &items[result]))
+      ++result;
+
+   if (result > 0)
+      xpc_eventcount_notify(&q->m_Not_Full);
+
+   return result;
+}
+
+/******************************************************************************
+ * mpmc_try_push() and mpmc_try_pop() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adapt the MPMC push and pop to queue_wait().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+mpmc_try_push (void * q, void * item)
+{
+   return xpc_mpmc_queue_push((xpc_mpmc_queue_t *) q, item);
+}
+
+static cbool_t
+mpmc_try_pop (void * q, void * item)
+{
+   return xpc_mpmc_queue_pop((xpc_mpmc_queue_t *) q, (void **) item);
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_push_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds an item, waiting for room if the queue is full.
+ *
+ * \return
+ *    Returns 'true' if the item was added, and 'false' if the queue was
+ *    closed first.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_mpmc_queue_push_wait
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to add to.                    */
+   void * item                   /**< The item to add.                        */
+)
+{
+   cbool_t result = false;
+   if (! xpc_atomic_load(&q->m_Closed))
+   {
+      result = queue_wait
+      (
+         q, mpmc_try_push, item, &q->m_Not_Full, &q->m_Closed, false
+      );
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_pop_wait()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Removes the oldest item, waiting for one if the queue is empty.
+ *
+ * \return
+ *    Returns 'true' if an item was removed, and 'false' if the queue is
+ *    closed and empty.
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_mpmc_queue_pop_wait
+(
+   xpc_mpmc_queue_t * q,         /**< The queue to remove from.               */
+   void ** item                  /**< Receives the item.                      */
+)
+{
+   return queue_wait
+   (
+      q, mpmc_try_pop, (void *) item, &q->m_Not_Empty, &q->m_Closed, true
+   );
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_count()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Gets the number of items claimed for pushing but not yet for popping.
+ *    With other threads busy, it is only an estimate.
+ *
+ * \return
+ *    Returns the number of items queued.
+ *
+ * \unittests
+ *    -  queues_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+size_t
+xpc_mpmc_queue_count
+(
+   const xpc_mpmc_queue_t * q    /**< The queue to check.                     */
+)
+{
+   size_t dequeue = xpc_atomic_load(&q->m_Dequeue);
+   size_t enqueue = xpc_atomic_load(&q->m_Enqueue);
+   return enqueue > dequeue ? enqueue - dequeue : 0 ;
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_close()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Closes the queue, waking all waiters.  See xpc_spsc_queue_close().
+ *
+ * \unittests
+ *    -  queues_test_01_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void
+xpc_mpmc_queue_close
+(
+   xpc_mpmc_queue_t * q          /**< The queue to close.                     */
+)
+{
+   xpc_atomic_store(&q->m_Closed, 1);
+   xpc_eventcount_notify(&q->m_Not_Empty);
+   xpc_eventcount_notify(&q->m_Not_Full);
+}
+
+/******************************************************************************
+ * xpc_mpmc_queue_destroy()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Frees the cells.  No thread may be using the queue.  Items still in
+ *    it are not freed.
+ *
+ * \return
+ *    Returns 'true' if the queue had been created.
+ *
+ * \unittests
+ *    -  queues_test_01_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_mpmc_queue_destroy
+(
+   xpc_mpmc_queue_t * q          /**< The queue to free.                      */
+)
+{
+   cbool_t result = false;
+   if (not_nullptr(q))
+   {
+      if (not_NULL(q->m_Cells))
+      {
+         free(q->m_Cells);
+         q->m_Cells = nullptr;
+         result = true;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * queues.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
@@ -18,51 +18,470 @@
  *    used in the errorlogging.c module as an option to emit log messages
  *    without jumbling them together.
  *
+ *    Our critical sections are often only tens of nanoseconds long, so
+ *    going straight to sleep in the kernel when the lock is taken costs
+ *    far more than the wait itself.  An adaptive syncher first retries
+ *    the lock with pthread_mutex_trylock(), pausing a little longer
+ *    between each try, and blocks only when that fails.
+ *
+ *    The module also provides a reader-writer syncher, and an array of
+ *    synchers selected by a key (lock striping).
+ *
  * \win32
  *    Under Win32, the pthread_w32 port of the pthread API is used.
  *
  *//*-------------------------------------------------------------------------*/
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE              1     /* pthread_rwlockattr_setkind_np()     */
+#endif
+
 #include <xpc/errorlogging.h>          /* macros and external functions       */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
 #include <xpc/syncher.h>               /* xpc_syncher_t and its functions     */
+#include <xpc/atomix.h>                /* xpc_cpu_relax(), cache-line size    */
+
+#if XPC_HAVE_STDLIB_H
+#include <stdlib.h>                    /* malloc() and free()                 */
+#endif
+
+#if XPC_HAVE_ERRNO_H
+#include <errno.h>                     /* EBUSY                               */
+#endif
+
+#if XPC_HAVE_UNISTD_H
+#include <unistd.h>                    /* sysconf()                           */
+#endif
+
+#if XPC_HAVE_CLOCK_GETTIME
+#include <time.h>                      /* clock_gettime()                     */
+#endif
+
 XPC_REVISION(syncher)
 
-/*******************************************************************************
- * xpc_syncher_delete()
+/******************************************************************************
+ * syncher_nanoseconds() [static]
  *------------------------------------------------------------------------*//**
  *
- *    Destroys or uninitializes a syncher-object.
+ *    Reads a monotonic clock, for measuring the time spent waiting for a
+ *    syncher-object.  It is called only when the object is found locked,
+ *    so its cost is never added to an uncontended enter.
  *
- *    If the object is still owned (that is, entered or locked), there's
- *    really no choice but to spin and wait for it to become free.  This
- *    is handled differently in each operating system.
+ * \return
+ *    Returns the nanoseconds since an arbitrary starting point.
  *
- * \posix
- *    This function checks if the m_Syncher_Owned flag is set.  If so,
- *    then the syncher-object object is forcibly unlocked by a call to
- *    pthread_mutex_unlock().
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static uint64_t
+syncher_nanoseconds (void)
+{
+   uint64_t result;
+#if XPC_HAVE_CLOCK_GETTIME
+   struct timespec ts;
+   (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+   result = (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#else
+   struct timeval tv;
+   (void) xpc_get_microseconds(&tv);
+   result = (uint64_t) tv.tv_sec * 1000000000ULL +
+      (uint64_t) tv.tv_usec * 1000;
+#endif
+   return result;
+}
+
+/******************************************************************************
+ * syncher_count() [static]
+ *------------------------------------------------------------------------*//**
  *
- *    [This will only error out for an "error-checking" mutex, which is
- *    supported here only for debugging.]
+ *    Adds to one of the contention statistics of a syncher-object.
  *
- *    After the forced unlocking, then pthread_mutex_destroy() is called.
+ *    Only the thread that owns the object writes the statistics, so a
+ *    relaxed load and store suffice, and no locked read-modify-write is
+ *    added to the enter.  Being atomic, they let other threads read the
+ *    statistics at any time with xpc_atomic_load_relaxed().
  *
- *    This is \e different from what is done in Windows.
+ * \param counter
+ *    The statistic to update.
  *
- * \win32
- *    Under Win32, the pthread_w32 port of the pthread API is used.
+ * \param amount
+ *    The amount to add to it.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+syncher_count (uint64_t * counter, uint64_t amount)
+{
+   xpc_atomic_store_relaxed(counter, xpc_atomic_load_relaxed(counter) + amount);
+}
+
+#if defined DEBUG_MUTEX_LOCKS
+
+/******************************************************************************
+ * Lock-order detector
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the owner tracking and the lock-order detector used when
+ *    DEBUG_MUTEX_LOCKS is defined.
+ *
+ *    Each thread is identified by the address of its own instance of a
+ *    thread-local variable, which is never 0.
+ *
+ *    Each thread keeps a list of the synchers it holds.  When the detector
+ *    is on, a thread about to enter syncher B while holding syncher A
+ *    records that "A is taken before B".  If the records already show that
+ *    B is taken (directly or through other synchers) before A, the two
+ *    threads could deadlock, and an error is logged at once, whether or
+ *    not the deadlock actually happens this time.  Try-enters cannot
+ *    deadlock, so they are not checked, but the syncher still counts as
+ *    held.
+ *
+ *    The records are shared by all threads, and are guarded by a plain
+ *    POSIX mutex, so that the detector does not check itself.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   const xpc_syncher_t * m_First;      /**< The syncher taken first.          */
+   const xpc_syncher_t * m_Second;     /**< The syncher taken while holding it*/
+
+} lockorder_edge_t;
+
+static xpc_thread_local char gs_thread_tag;
+static xpc_thread_local const xpc_syncher_t * gs_held[XPC_LOCKORDER_DEPTH];
+static xpc_thread_local int gs_held_count;
+
+static pthread_mutex_t gs_lockorder_mutex = PTHREAD_MUTEX_INITIALIZER;
+static lockorder_edge_t gs_lockorder_edges[XPC_LOCKORDER_EDGES];
+static int gs_lockorder_edge_count;
+static cbool_t gs_lockorder_on;
+static unsigned long gs_lockorder_violations;
+
+#define SYNCHER_SELF()           ((uintptr_t) &gs_thread_tag)
+
+/******************************************************************************
+ * lockorder_reaches() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tells if the records show that one syncher is taken, directly or
+ *    through other synchers, before another.  It is a breadth-first search
+ *    over the records, which is slow, but runs only in debug builds, and
+ *    only when a thread enters a syncher while holding another, in an
+ *    order not seen before.
+ *
+ *    The caller holds gs_lockorder_mutex.
+ *
+ * \param from
+ *    The syncher at the start of the search.
+ *
+ * \param to
+ *    The syncher searched for.
  *
  * \return
- *    Returns 'true' if the parameter is valid and the function
- *    succeeded.  Otherwise, 'false' is returned.
+ *    Returns 'true' if "from" is taken before "to".
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+lockorder_reaches (const xpc_syncher_t * from, const xpc_syncher_t * to)
+{
+   const xpc_syncher_t * queue[XPC_LOCKORDER_EDGES + 1];
+   cbool_t result = false;
+   int head = 0;
+   int tail = 0;
+   queue[tail++] = from;
+   while (head < tail && ! result)
+   {
+      const xpc_syncher_t * node = queue[head++];
+      int e;
+      for (e = 0; e < gs_lockorder_edge_count && ! result; ++e)
+      {
+         if (gs_lockorder_edges[e].m_First == node)
+         {
+            const xpc_syncher_t * next = gs_lockorder_edges[e].m_Second;
+            if (next == to)
+               result = true;
+            else
+            {
+               int q;
+               for (q = 0; q < tail && queue[q] != next; ++q)
+                  ;
+
+               if (q == tail && tail <= XPC_LOCKORDER_EDGES)
+                  queue[tail++] = next;
+            }
+         }
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * lockorder_check() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Records that each syncher held by the calling thread is taken before
+ *    the syncher about to be entered, and reports any record that goes the
+ *    other way.
+ *
+ * \param xs
+ *    The syncher about to be entered.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+lockorder_check (const xpc_syncher_t * xs)
+{
+   if (gs_held_count > 0 && xpc_atomic_load_relaxed(&gs_lockorder_on))
+   {
+      const xpc_syncher_t * inverted = nullptr;
+      int h;
+      (void) pthread_mutex_lock(&gs_lockorder_mutex);
+      for (h = 0; h < gs_held_count && h < XPC_LOCKORDER_DEPTH; ++h)
+      {
+         const xpc_syncher_t * held = gs_held[h];
+         cbool_t known = held == xs;
+         int e;
+         for (e = 0; e < gs_lockorder_edge_count && ! known; ++e)
+         {
+            known = gs_lockorder_edges[e].m_First == held &&
+               gs_lockorder_edges[e].m_Second == xs;
+         }
+         if (! known)
+         {
+            if (lockorder_reaches(xs, held))
+            {
+               ++gs_lockorder_violations;
+               inverted = held;
+            }
+            else if (gs_lockorder_edge_count < XPC_LOCKORDER_EDGES)
+            {
+               gs_lockorder_edges[gs_lockorder_edge_count].m_First = held;
+               gs_lockorder_edges[gs_lockorder_edge_count].m_Second = xs;
+               ++gs_lockorder_edge_count;
+            }
+         }
+      }
+      (void) pthread_mutex_unlock(&gs_lockorder_mutex);
+
+      /*
+       * Logged only after the detector's mutex is released, since the
+       * error-log may itself enter a syncher.
+       */
+
+      if (not_NULL(inverted))
+      {
+         xpc_errprintf
+         (
+            _("lock-order inversion: syncher %p entered while holding %p, "
+              "but %p is taken before %p elsewhere; this can deadlock"),
+            (const void *) xs, (const void *) inverted,
+            (const void *) xs, (const void *) inverted
+         );
+      }
+   }
+}
+
+/******************************************************************************
+ * lockorder_forget() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Removes the records that mention a syncher being destroyed, since its
+ *    memory may later hold an unrelated syncher.
+ *
+ * \param xs
+ *    The syncher being destroyed.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+lockorder_forget (const xpc_syncher_t * xs)
+{
+   int e = 0;
+   (void) pthread_mutex_lock(&gs_lockorder_mutex);
+   while (e < gs_lockorder_edge_count)
+   {
+      if (gs_lockorder_edges[e].m_First == xs ||
+         gs_lockorder_edges[e].m_Second == xs)
+      {
+         --gs_lockorder_edge_count;
+         gs_lockorder_edges[e] = gs_lockorder_edges[gs_lockorder_edge_count];
+      }
+      else
+         ++e;
+   }
+   (void) pthread_mutex_unlock(&gs_lockorder_mutex);
+}
+
+/******************************************************************************
+ * syncher_acquired() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Records the calling thread as the owner of a syncher it just entered,
+ *    and adds the syncher to the thread's list of held synchers.
+ *
+ * \param xs
+ *    The syncher just entered.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+syncher_acquired (xpc_syncher_t * xs)
+{
+   if (xs->m_Depth++ == 0)
+      xpc_atomic_store(&xs->m_Owner, SYNCHER_SELF());
+
+   if (gs_held_count < XPC_LOCKORDER_DEPTH)
+      gs_held[gs_held_count] = xs;
+
+   ++gs_held_count;
+}
+
+/******************************************************************************
+ * syncher_releasing() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Checks that the calling thread owns a syncher it is about to leave,
+ *    and clears the owner once the last recursive enter is undone.
+ *
+ * \param xs
+ *    The syncher about to be left.
+ *
+ * \return
+ *    Returns 'true' if the calling thread owns the syncher.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+syncher_releasing (xpc_syncher_t * xs)
+{
+   cbool_t result = xpc_atomic_load(&xs->m_Owner) == SYNCHER_SELF();
+   if (result)
+   {
+      int h;
+      if (--xs->m_Depth == 0)
+         xpc_atomic_store(&xs->m_Owner, (uintptr_t) 0);
+
+      for (h = gs_held_count - 1; h >= 0; --h)      /* usually the last one */
+      {
+         if (h < XPC_LOCKORDER_DEPTH && gs_held[h] == xs)
+         {
+            for ( ; h + 1 < gs_held_count && h + 1 < XPC_LOCKORDER_DEPTH; ++h)
+               gs_held[h] = gs_held[h + 1];
+
+            break;
+         }
+      }
+      if (gs_held_count > 0)
+         --gs_held_count;
+   }
+   else
+      xpc_errprint_func(_("leaving a syncher-object this thread does not own"));
+
+   return result;
+}
+
+#endif   /* DEBUG_MUTEX_LOCKS */
+
+/******************************************************************************
+ * xpc_syncher_lockorder_set()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Turns the lock-order detector on or off.  It is off by default.
+ *
+ *    The detector exists only when the library is built with
+ *    DEBUG_MUTEX_LOCKS defined.  Otherwise this function does nothing.
+ *
+ * \param flag
+ *    If 'true', synchers entered from now on are checked.
+ *
+ * \return
+ *    Returns 'true' if the detector exists.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syncher_lockorder_set
+(
+   cbool_t flag            /**< Turns the detector on or off.                 */
+)
+{
+#if defined DEBUG_MUTEX_LOCKS
+   xpc_atomic_store(&gs_lockorder_on, flag);
+   return true;
+#else
+   (void) flag;
+   return false;
+#endif
+}
+
+/******************************************************************************
+ * xpc_syncher_lockorder_violations()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the number of lock-order inversions found so far.
+ *
+ * \return
+ *    Returns the count, which is always 0 if the detector does not exist.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_03()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+unsigned long
+xpc_syncher_lockorder_violations (void)
+{
+   unsigned long result = 0;
+#if defined DEBUG_MUTEX_LOCKS
+   (void) pthread_mutex_lock(&gs_lockorder_mutex);
+   result = gs_lockorder_violations;
+   (void) pthread_mutex_unlock(&gs_lockorder_mutex);
+#endif
+   return result;
+}
+
+/*******************************************************************************
+ * xpc_syncher_delete()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Destroys or uninitializes a syncher-object.
+ *
+ * \posix
+ *    This function calls pthread_mutex_destroy(), which fails with EBUSY
+ *    if the mutex is still locked.  The mutex is not forcibly unlocked
+ *    first, since unlocking a mutex owned by another thread is undefined.
+ *
+ * \win32
+ *    Under Win32, the pthread_w32 port of the pthread API is used.
  *
  * \note
- *    -  There may be potential issues with multiple threads acting on the
- *       "ok" and "owned" flags, but the code should work in the x86
- *       environment.
- *    -  Since this is an internal helper function, the parameter is not
- *       checked.
+ *    Since this is an internal helper function, the parameter is not
+ *    checked.
  *
  * \return
  *    Returns 'true' if the function succeeded.
@@ -79,16 +498,7 @@ xpc_syncher_delete
 )
 {
    cbool_t result;
-   int rc;
-   if (xs->m_Syncher_Owned)
-   {
-      rc = pthread_mutex_unlock(&xs->m_Syncher);
-      result = is_posix_success(rc);
-      if (! result)
-         xpc_strerrprint_func(_("can't unlock mutex"), rc);
-   }
-   rc = pthread_mutex_destroy(&xs->m_Syncher);
-   xs->m_Syncher_Owned = false;
+   int rc = pthread_mutex_destroy(&xs->m_Syncher);
    result = is_posix_success(rc);
    if (! result)
       xpc_strerrprint_func(_("failed"), rc);
@@ -186,8 +596,15 @@ xpc_syncher_create
       int rc;
       pthread_mutexattr_t attr;
       rc = pthread_mutexattr_init(&attr);                /* always "succeeds" */
-      xs->m_Syncher_Owned = false;
+      xs->m_Owner = 0;
+      xs->m_Depth = 0;
+      xs->m_Recursive = recursive;
       xs->m_Syncher_Ready = false;
+      xs->m_Spin_Limit = 0;
+      xs->m_Acquisitions = 0;
+      xs->m_Contended = 0;
+      xs->m_Parked = 0;
+      xs->m_Wait_Nanoseconds = 0;
       if (recursive)
       {
          pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE_NP);
@@ -218,6 +635,58 @@ xpc_syncher_create
    return result;
 }
 
+/******************************************************************************
+ * xpc_syncher_create_adaptive()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates a non-recursive syncher-object that spins before blocking.
+ *
+ *    When xpc_syncher_enter() finds the object locked, it retries the lock
+ *    up to the given number of times, with an exponentially growing number
+ *    of pause instructions (up to XPC_SYNCHER_BACKOFF_MAX) between tries,
+ *    before calling pthread_mutex_lock().  This suits locks that are held
+ *    only briefly, where the owner is likely to leave before a sleeping
+ *    thread could even be woken.
+ *
+ *    On a machine with a single processor, spinning cannot help (the owner
+ *    cannot run while we spin), and so the object blocks at once, like a
+ *    normal syncher.
+ *
+ * \param spins
+ *    The number of retries.  If 0, XPC_SYNCHER_SPIN_DEFAULT is used.
+ *
+ * \return
+ *    Returns 'true' if the initialization succeed.  Otherwise, 'false'
+ *    is returned.
+ *
+ * \unittests
+ *    -  syncher_thread_test_05_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syncher_create_adaptive
+(
+   xpc_syncher_t * xs,     /**< The "this-pointer" for this function.         */
+   int spins               /**< The number of retries before blocking.        */
+)
+{
+   cbool_t result = xpc_syncher_create(xs, false);
+   if (result)
+   {
+      if (spins <= 0)
+         spins = XPC_SYNCHER_SPIN_DEFAULT;
+
+#if XPC_HAVE_UNISTD_H && defined _SC_NPROCESSORS_ONLN
+      if (sysconf(_SC_NPROCESSORS_ONLN) <= 1)
+         spins = 0;
+#endif
+
+      xs->m_Spin_Limit = spins;
+   }
+   return result;
+}
+
 /******************************************************************************
  * xpc_syncher_destroy()
  *------------------------------------------------------------------------*//**
@@ -248,15 +717,21 @@ xpc_syncher_destroy
    if (is_thisptr(xs))
    {
       cbool_t ok;
-      if (xs->m_Syncher_Owned)
+      int rc = pthread_mutex_trylock(&xs->m_Syncher);    /* is it owned?      */
+      if (is_posix_success(rc))
+      {
+         (void) pthread_mutex_unlock(&xs->m_Syncher);
+         result = true;
+      }
+      else
       {
          xpc_errprint_func(_("deleting an owned syncher-object"));
          result = false;
       }
-      else
-         result = true;
-
       xs->m_Syncher_Ready = false;                 /* disable the item now    */
+#if defined DEBUG_MUTEX_LOCKS
+      lockorder_forget(xs);
+#endif
       ok = xpc_syncher_delete(xs);
       if (result)
          result = ok;
@@ -270,19 +745,17 @@ xpc_syncher_destroy
  *
  *    This function locks (enters) the critical-section.
  *
- *    The m_Syncher_Owned flag is used to prevent destruction of the
- *    critex while it is still owned.  Under Win32, this act has
- *    undefined effects.
+ *    Nothing but the mutex (and the statistics, which share its cache
+ *    line and are written only by the owner) is touched.  When
+ *    DEBUG_MUTEX_LOCKS is defined, the lock order is first checked (see
+ *    xpc_syncher_lockorder_set()), and the owner thread is recorded.
  *
- *    The m_Syncher_Owned flag is a potential issue.  However, once we
- *    acquire the lock, we've got exclusive access to that flag anyway,
- *    so we're safe.
- *
- *    Also, because of the ability to call EnterCriticalSection multiple
- *    times, as noted below for Win32, it is best to explicitly avoid
- *    doing so, and the m_Syncher_Owned flag prevents this.  There is no
- *    way for one thread to tell if it is the thread currently having
- *    ownership.
+ *    The lock is first tried with pthread_mutex_trylock(), which costs the
+ *    same as pthread_mutex_lock() when the object is free.  If the object
+ *    is locked, an adaptive syncher retries it for a while (see
+ *    xpc_syncher_create_adaptive()), and then the thread blocks.  Only in
+ *    that case is the waiting time measured.  The statistics are updated
+ *    once the lock is held.
  *
  * \posix
  *    The pthread_mutex_lock() function returns an error if the mutex has
@@ -324,7 +797,7 @@ xpc_syncher_destroy
  *    succeeds.  Otherwise 'false' is returned.
  *
  * \unittests
- *    TBD.
+ *    -  syncher_thread_test_05_02()
  *
  *//*-------------------------------------------------------------------------*/
 
@@ -337,10 +810,53 @@ xpc_syncher_enter
    cbool_t result = false;
    if (is_thisptr(xs))
    {
-      int rc = pthread_mutex_lock(&xs->m_Syncher);
+      int rc;
+#if defined DEBUG_MUTEX_LOCKS
+      lockorder_check(xs);
+#endif
+      rc = pthread_mutex_trylock(&xs->m_Syncher);
+      if (rc == EBUSY)
+      {
+         uint64_t start = syncher_nanoseconds();
+         cbool_t parked = false;
+         int backoff = 1;
+         int spin;
+         for (spin = 0; spin < xs->m_Spin_Limit && rc == EBUSY; ++spin)
+         {
+            int pause;
+            for (pause = 0; pause < backoff; ++pause)
+               xpc_cpu_relax();
+
+            if (backoff < XPC_SYNCHER_BACKOFF_MAX)
+               backoff *= 2;
+
+            rc = pthread_mutex_trylock(&xs->m_Syncher);
+         }
+         if (rc == EBUSY)
+         {
+            rc = pthread_mutex_lock(&xs->m_Syncher);
+            parked = true;
+         }
+         if (is_posix_success(rc))
+         {
+            syncher_count(&xs->m_Contended, 1);
+            if (parked)
+               syncher_count(&xs->m_Parked, 1);
+
+            syncher_count
+            (
+               &xs->m_Wait_Nanoseconds, syncher_nanoseconds() - start
+            );
+         }
+      }
       result = is_posix_success(rc);
       if (result)
-         xs->m_Syncher_Owned = true;
+      {
+         syncher_count(&xs->m_Acquisitions, 1);
+#if defined DEBUG_MUTEX_LOCKS
+         syncher_acquired(xs);
+#endif
+      }
       else
          xpc_strerrprint_func(_("failed"), rc);
    }
@@ -394,7 +910,12 @@ xpc_syncher_tryenter
       int rc = pthread_mutex_trylock(&xs->m_Syncher);
       result = is_posix_success(rc);
       if (result)
-         xs->m_Syncher_Owned = true;
+      {
+         syncher_count(&xs->m_Acquisitions, 1);
+#if defined DEBUG_MUTEX_LOCKS
+         syncher_acquired(xs);
+#endif
+      }
    }
    return result;
 }
@@ -405,12 +926,10 @@ xpc_syncher_tryenter
  *
  *    Unlocks a critical-section object.
  *
- *    Unlocking a critical-section means giving up ownership of it, so the
- *    m_Syncher_Owned flag gets set to false.  It gets set just before
- *    the call that unlocks the critical section.  It is erroneous to unlock
- *    it after the unlocking, because another thread may have gotten
- *    ownership and set it to true, only to have the current thread falsify
- *    it.
+ *    Normally this is nothing but the unlock.  When DEBUG_MUTEX_LOCKS is
+ *    defined, the owner is first checked and cleared (before the unlock,
+ *    since afterward another thread may already own the object), and a
+ *    thread that does not own the object is refused.
  *
  * \posix
  *    This function calls pthread_mutex_unlock().
@@ -438,9 +957,272 @@ xpc_syncher_leave
    cbool_t result = false;
    if (is_thisptr(xs))
    {
-      int rc;
-      xs->m_Syncher_Owned = false;
-      rc = pthread_mutex_unlock(&xs->m_Syncher);
+#if defined DEBUG_MUTEX_LOCKS
+      if (syncher_releasing(xs))
+#endif
+      {
+         int rc = pthread_mutex_unlock(&xs->m_Syncher);
+         result = is_posix_success(rc);
+         if (! result)
+            xpc_strerrprint_func(_("failed"), rc);
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_rwsyncher_create()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates and initializes a reader-writer syncher-object.
+ *
+ * \param prefer_writers
+ *    If 'true', a writer waiting for the object keeps new readers out, so
+ *    that it gets the object as soon as the current readers leave.  Then a
+ *    thread that already reads must not enter for reading again, since it
+ *    would wait for the writer, which waits for it.
+ *
+ * \posix
+ *    Writer preference uses pthread_rwlockattr_setkind_np(), which is a
+ *    glibc extension.  Elsewhere, the platform's own policy is used (many
+ *    other platforms prefer writers already).
+ *
+ * \return
+ *    Returns 'true' if the initialization succeed.  Otherwise, 'false'
+ *    is returned.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_rwsyncher_create
+(
+   xpc_rwsyncher_t * xs,   /**< The "this-pointer" for this function.         */
+   cbool_t prefer_writers  /**< Flag for letting writers go first.            */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      int rc;
+      pthread_rwlockattr_t attr;
+      rc = pthread_rwlockattr_init(&attr);
+      xs->m_Syncher_Ready = false;
+      xs->m_Prefer_Writers = prefer_writers;
+#if defined __GLIBC__
+      if (prefer_writers && is_posix_success(rc))
+      {
+         rc = pthread_rwlockattr_setkind_np
+         (
+            &attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP
+         );
+      }
+#endif
+      if (is_posix_success(rc))
+      {
+         rc = pthread_rwlock_init(&xs->m_Rwlock, &attr);
+         (void) pthread_rwlockattr_destroy(&attr);
+         result = is_posix_success(rc);
+      }
+      if (result)
+         xs->m_Syncher_Ready = true;
+      else
+         xpc_strerrprint_func(_("failed"), rc);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_rwsyncher_enter_read()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Enters the reader-writer syncher-object for reading, waiting while a
+ *    writer owns it.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the locking operation
+ *    succeeds.  Otherwise 'false' is returned.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_rwsyncher_enter_read
+(
+   xpc_rwsyncher_t * xs    /**< The "this-pointer" for this function.         */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      int rc = pthread_rwlock_rdlock(&xs->m_Rwlock);
+      result = is_posix_success(rc);
+      if (! result)
+         xpc_strerrprint_func(_("failed"), rc);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_rwsyncher_enter_write()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Enters the reader-writer syncher-object for writing, waiting while
+ *    any other thread owns it.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the locking operation
+ *    succeeds.  Otherwise 'false' is returned.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_rwsyncher_enter_write
+(
+   xpc_rwsyncher_t * xs    /**< The "this-pointer" for this function.         */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      int rc = pthread_rwlock_wrlock(&xs->m_Rwlock);
+      result = is_posix_success(rc);
+      if (! result)
+         xpc_strerrprint_func(_("failed"), rc);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_rwsyncher_tryenter_read()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tries to enter the reader-writer syncher-object for reading, without
+ *    waiting.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the object was entered.
+ *    As with xpc_syncher_tryenter(), failure and merely being unable to
+ *    enter are not distinguished.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_rwsyncher_tryenter_read
+(
+   xpc_rwsyncher_t * xs    /**< The "this-pointer" for this function.         */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      int rc = pthread_rwlock_tryrdlock(&xs->m_Rwlock);
+      result = is_posix_success(rc);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_rwsyncher_tryenter_write()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tries to enter the reader-writer syncher-object for writing, without
+ *    waiting.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the object was entered.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_rwsyncher_tryenter_write
+(
+   xpc_rwsyncher_t * xs    /**< The "this-pointer" for this function.         */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      int rc = pthread_rwlock_trywrlock(&xs->m_Rwlock);
+      result = is_posix_success(rc);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_rwsyncher_leave()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Leaves the reader-writer syncher-object, whether it was entered for
+ *    reading or for writing.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the function succeeded.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_rwsyncher_leave
+(
+   xpc_rwsyncher_t * xs    /**< The "this-pointer" for this function.         */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      int rc = pthread_rwlock_unlock(&xs->m_Rwlock);
+      result = is_posix_success(rc);
+      if (! result)
+         xpc_strerrprint_func(_("failed"), rc);
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_rwsyncher_destroy()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Uninitializes the reader-writer syncher-object.  It must not be owned
+ *    by any thread.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the function succeeded.
+ *    pthread_rwlock_destroy() may fail (with EBUSY) if the object is still
+ *    owned.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_01()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_rwsyncher_destroy
+(
+   xpc_rwsyncher_t * xs    /**< The "this-pointer" for this function.         */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      int rc;
+      xs->m_Syncher_Ready = false;                 /* disable the item now    */
+      rc = pthread_rwlock_destroy(&xs->m_Rwlock);
       result = is_posix_success(rc);
       if (! result)
          xpc_strerrprint_func(_("failed"), rc);
@@ -448,6 +1230,259 @@ xpc_syncher_leave
    return result;
 }
 
+/******************************************************************************
+ * stripe_of() [static]
+ *------------------------------------------------------------------------*//**
+ *
+ *    Finds the stripe that guards a key.
+ *
+ *    The key is multiplied by 2^64 divided by the golden ratio (Fibonacci
+ *    hashing), and the stripe is taken from the bits of the product that
+ *    start at bit 32.  Each of those bits depends on all of the low 32
+ *    bits of the key, so that keys differing only in their low bits, such
+ *    as the addresses of aligned structures, still spread over all the
+ *    stripes.  (There are never anywhere near 2^32 stripes.)
+ *
+ * \param xs
+ *    The stripes, assumed valid.
+ *
+ * \param key
+ *    The key, often a hash or an address.
+ *
+ * \return
+ *    Returns a pointer to the syncher-object of the stripe.
+ *
+ * \unittests
+ *    No direct unit-test possible in a static C function.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static xpc_syncher_t *
+stripe_of (const xpc_syncher_stripes_t * xs, size_t key)
+{
+   uint64_t mixed = (uint64_t) key * 0x9E3779B97F4A7C15ULL;
+   size_t index = (size_t) (mixed >> 32) & xs->m_Mask;
+   return (xpc_syncher_t *) (xs->m_Stripes + index * xs->m_Stride);
+}
+
+/******************************************************************************
+ * xpc_syncher_stripes_create()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Creates an array of syncher-objects, each in its own cache lines.
+ *
+ * \param count
+ *    The number of stripes.  It is rounded up to a power of 2.  A good
+ *    value is a small multiple of the number of threads that contend.
+ *
+ * \param adaptive
+ *    If 'true', each stripe is an adaptive syncher-object (see
+ *    xpc_syncher_create_adaptive()).
+ *
+ * \return
+ *    Returns 'true' if the memory was allocated and every stripe was
+ *    created.  Otherwise, 'false' is returned, and nothing is left
+ *    allocated.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syncher_stripes_create
+(
+   xpc_syncher_stripes_t * xs,   /**< The "this-pointer" for this function.   */
+   size_t count,                 /**< The number of stripes wanted.           */
+   cbool_t adaptive              /**< Flag for adaptive stripes.              */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+   {
+      size_t stripes = 1;
+      while (stripes < count)
+         stripes *= 2;
+
+      xs->m_Stride = (sizeof(xpc_syncher_t) + XPC_CACHE_LINE_SIZE - 1) /
+         XPC_CACHE_LINE_SIZE * XPC_CACHE_LINE_SIZE;
+
+      xs->m_Mask = stripes - 1;
+      xs->m_Memory = malloc(stripes * xs->m_Stride + XPC_CACHE_LINE_SIZE);
+      if (not_nullptr(xs->m_Memory))
+      {
+         uintptr_t base = (uintptr_t) xs->m_Memory + XPC_CACHE_LINE_SIZE - 1;
+         size_t created;
+         base -= base % XPC_CACHE_LINE_SIZE;
+         xs->m_Stripes = (char *) base;
+         result = true;
+         for (created = 0; created < stripes && result; ++created)
+         {
+            xpc_syncher_t * stripe =
+               (xpc_syncher_t *) (xs->m_Stripes + created * xs->m_Stride);
+
+            result = adaptive ?
+               xpc_syncher_create_adaptive(stripe, 0) :
+               xpc_syncher_create(stripe, false) ;
+         }
+         if (! result)                    /* undo the stripes that worked */
+         {
+            size_t index;
+            for (index = 0; index + 1 < created; ++index)
+            {
+               (void) xpc_syncher_destroy
+               (
+                  (xpc_syncher_t *) (xs->m_Stripes + index * xs->m_Stride)
+               );
+            }
+            free(xs->m_Memory);
+         }
+      }
+      if (! result)
+      {
+         xs->m_Memory = nullptr;
+         xs->m_Stripes = nullptr;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * xpc_syncher_stripes_enter()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Enters the stripe that guards a key.
+ *
+ * \param key
+ *    The key, often a hash or an address.  Equal keys always select the
+ *    same stripe.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the locking operation
+ *    succeeds.  Otherwise 'false' is returned.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syncher_stripes_enter
+(
+   xpc_syncher_stripes_t * xs,   /**< The "this-pointer" for this function.   */
+   size_t key                    /**< The key selecting the stripe.           */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+      result = xpc_syncher_enter(stripe_of(xs, key));
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_syncher_stripes_tryenter()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tries to enter the stripe that guards a key, without waiting.
+ *
+ * \param key
+ *    The key, often a hash or an address.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the stripe was entered.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syncher_stripes_tryenter
+(
+   xpc_syncher_stripes_t * xs,   /**< The "this-pointer" for this function.   */
+   size_t key                    /**< The key selecting the stripe.           */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+      result = xpc_syncher_tryenter(stripe_of(xs, key));
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_syncher_stripes_leave()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Leaves the stripe that guards a key.
+ *
+ * \param key
+ *    The key given to the matching enter.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and the function succeeded.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syncher_stripes_leave
+(
+   xpc_syncher_stripes_t * xs,   /**< The "this-pointer" for this function.   */
+   size_t key                    /**< The key selecting the stripe.           */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs))
+      result = xpc_syncher_leave(stripe_of(xs, key));
+
+   return result;
+}
+
+/******************************************************************************
+ * xpc_syncher_stripes_destroy()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Destroys every stripe, and frees their memory.
+ *
+ * \return
+ *    Returns 'true' if the parameter is valid and every stripe was
+ *    destroyed without complaint.
+ *
+ * \unittests
+ *    -  syncher_thread_test_04_02()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+cbool_t
+xpc_syncher_stripes_destroy
+(
+   xpc_syncher_stripes_t * xs    /**< The "this-pointer" for this function.   */
+)
+{
+   cbool_t result = false;
+   if (is_thisptr(xs) && not_nullptr(xs->m_Memory))
+   {
+      size_t index;
+      result = true;
+      for (index = 0; index <= xs->m_Mask; ++index)
+      {
+         xpc_syncher_t * stripe =
+            (xpc_syncher_t *) (xs->m_Stripes + index * xs->m_Stride);
+
+         if (! xpc_syncher_destroy(stripe))
+            result = false;
+      }
+      free(xs->m_Memory);
+      xs->m_Memory = nullptr;
+      xs->m_Stripes = nullptr;
+   }
+   return result;
+}
+
 /******************************************************************************
  * syncher.c
  *-----------------------------------------------------------------------------
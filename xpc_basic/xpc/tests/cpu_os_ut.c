@@ -326,6 +326,111 @@ cpu_os_test_01_01 (const unit_test_options_t * options)
    return status;
 }
 
+/******************************************************************************
+ * cpu_os_test_01_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Checks the CPU topology functions of the cpu.c module for
+ *    consistency.  The topology itself depends on the machine, so it is
+ *    only shown, not compared to fixed values.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_cpu_count()
+ *    -  xpc_cpu_online_cpus()
+ *    -  xpc_cpu_node_count()
+ *    -  xpc_cpu_node_cpus()
+ *    -  xpc_cpu_info()
+ *    -  xpc_cpu_topology_show()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+cpu_os_test_01_02 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 1, 2, _("cpu_os"), _("CPU Topology")
+   );
+   if (ok)
+   {
+      int cpus = 0;
+      int nodes = 0;
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "xpc_cpu_count()"))
+      {
+         cpus = xpc_cpu_count();
+         nodes = xpc_cpu_node_count();
+         ok = cpus >= 1 && nodes >= 1;
+         if (ok)
+            ok = xpc_cpu_online_cpus(nullptr, 0) == cpus;
+
+         if (! xpccut_is_silent())
+         {
+            fprintf(stdout, "  CPUs:                %d\n", cpus);
+            fprintf(stdout, "  NUMA nodes:          %d\n", nodes);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "xpc_cpu_node_cpus()"))
+      {
+         int total = 0;
+         int node;
+         for (node = 0; node < nodes; ++node)
+            total += xpc_cpu_node_cpus(node, nullptr, 0);
+
+         ok = total >= cpus;                 /* offline CPUs may be listed    */
+         if (ok)
+            ok = xpc_cpu_node_cpus(-1, nullptr, 0) == 0;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "xpc_cpu_info()"))
+      {
+         int online[XPC_CPU_MAX];
+         int count = xpc_cpu_online_cpus(online, XPC_CPU_MAX);
+         int c;
+         for (c = 0; ok && c < count && c < XPC_CPU_MAX; ++c)
+         {
+            xpc_cpu_info_t info;
+            int cpu = online[c];
+            ok = xpc_cpu_info(cpu, &info);
+            if (ok)                          /* -1 means "not known"          */
+            {
+               ok = info.m_Cpu == cpu && info.m_Core >= -1 &&
+                  info.m_Package >= -1 && info.m_Node >= -1 &&
+                  info.m_Node < nodes;
+            }
+            if (ok && ! xpccut_is_silent())
+            {
+               fprintf
+               (
+                  stdout, "  cpu %3d:  core %3d  package %2d  node %2d\n",
+                  info.m_Cpu, info.m_Core, info.m_Package, info.m_Node
+               );
+            }
+         }
+         if (ok)
+            ok = ! xpc_cpu_info(0, nullptr);
+
+         xpc_cpu_topology_show();
+         unit_test_status_pass(&status, ok);
+      }
+   }
+   return status;
+}
+
 /******************************************************************************
  * cpu_os_test_02_01()
  *------------------------------------------------------------------------*//**
@@ -473,6 +578,7 @@ main
             ok = unit_test_load(&testbattery, cpu_os_test_01_01);
             if (ok)
             {
+               (void) unit_test_load(&testbattery, cpu_os_test_01_02);
                (void) unit_test_load(&testbattery, cpu_os_test_02_01);
 
                // ok = unit_test_load(&testbattery, cpu_os_test_02_yy);
@@ -29,6 +29,8 @@
 #include <xpc/build_versions.h>        /* informative show-build functions    */
 #include <xpc/errorlogging.h>          /* macros and external functions       */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/logrecord.h>             /* xpc_logrecord_encode(), etc.        */
+#include <xpc/logring.h>               /* xpc_logring_map(), etc.             */
 #include <xpc/pthread_attributes.h>    /* pthread attributes functions        */
 #include <xpc/pthreader.h>             /* pthreader functions                 */
 #include <xpc/unit_test.h>             /* unit_test_t structure               */
@@ -37,6 +39,14 @@
 #include <sys/stat.h>                  /* stat() or _stat()                   */
 #endif
 
+#if XPC_HAVE_ERRNO_H
+#include <errno.h>                     /* EINVAL                              */
+#endif
+
+#include <stddef.h>                    /* ptrdiff_t                           */
+#include <stdlib.h>                    /* atof()                              */
+#include <time.h>                      /* time()                              */
+
 /******************************************************************************
  * g_do_leak_check
  *------------------------------------------------------------------------*//**
@@ -2481,7 +2491,7 @@ errorlogging_test_02_18 (const unit_test_options_t * options)
  *
  *//*-------------------------------------------------------------------------*/
 
-// TODO add 02_20 for testing the new function xpc_get_priority
+// TODO add a test for the new function xpc_get_priority
 
 static unit_test_status_t
 errorlogging_test_02_19 (const unit_test_options_t * options)
@@ -2530,6 +2540,1424 @@ errorlogging_test_02_19 (const unit_test_options_t * options)
    return status;
 }
 
+/******************************************************************************
+ * async_log_thread_function()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a thread that writes a fixed number of 12-byte lines to the
+ *    error-log, for testing asynchronous logging.
+ *
+ * \return
+ *    Returns a null pointer.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define ASYNC_LOG_THREADS        4
+#define ASYNC_LOG_LINES          1000
+
+static void *
+async_log_thread_function
+(
+   void * unused        /**< Not used.                                        */
+)
+{
+   int line;
+   (void) unused;
+   for (line = 0; line < ASYNC_LOG_LINES; line++)
+      xpc_print("123456789");                         /* "+ 123456789\n"      */
+
+   return nullptr;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_20()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the asynchronous (ring-buffer) logging back-end.
+ *
+ *    Lines are logged to a file from the main thread and from several
+ *    threads at once.  There are more lines than slots in the ring, so
+ *    that the producers also have to wait for the writer thread.  After
+ *    xpc_flush_error_log(), every line must be in the file, even before
+ *    the file is closed.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_async_logging_set()
+ *    -  xpc_async_logging()
+ *    -  xpc_flush_error_log()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+errorlogging_test_02_20 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 20, _("errorlogging"), _("Asynchronous logging")
+   );
+   if (ok)
+   {
+      cbool_t original_async = xpc_async_logging();
+      cbool_t original_timestamps = xpc_timestamps();
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+      (void) xpc_timestamps_set(false, false);        /* keep sizes fixed     */
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "xpc_async_logging_set()"))
+      {
+         ok = xpc_async_logging_set(true);
+         if (ok)
+            ok = xpc_async_logging();
+
+         if (ok)
+            ok = xpc_async_logging_set(true);         /* twice is harmless    */
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "one thread"))
+      {
+         (void) unlink(LOG_FILENAME);
+         ok = xpc_open_logfile(LOG_FILENAME);
+         if (ok)
+            ok = xpc_errlevel_set(XPC_ERROR_LEVEL_ERRORS);
+
+         if (ok)
+         {
+            STAT_T statusret;
+            int line;
+            for (line = 0; line < 100; line++)
+               xpc_print("123456789");
+
+            xpc_errprintf("%s", "abcdefghi");         /* va_tag() path        */
+            xpc_flush_error_log();
+            ok = STATFUNC(LOG_FILENAME, &statusret) == 0;
+            if (ok)
+            {
+#ifdef POSIX
+               ok = (size_t) statusret.st_size == 101 * 12;
+#else
+               ok = (size_t) statusret.st_size == 101 * 13;
+#endif
+            }
+            (void) xpc_close_logfile();
+            (void) xpc_errlevel_set(el);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "several threads"))
+      {
+         (void) unlink(LOG_FILENAME);
+         ok = xpc_open_logfile(LOG_FILENAME);
+         if (ok)
+            ok = xpc_errlevel_set(XPC_ERROR_LEVEL_ERRORS);
+
+         if (ok)
+         {
+            pthread_t threads[ASYNC_LOG_THREADS];
+            STAT_T statusret;
+            int t;
+            for (t = 0; t < ASYNC_LOG_THREADS; t++)
+            {
+               threads[t] = pthreader_create
+               (
+                  nullptr, async_log_thread_function, nullptr
+               );
+            }
+            for (t = 0; t < ASYNC_LOG_THREADS; t++)
+               (void) pthreader_join(threads[t]);
+
+            xpc_flush_error_log();
+            ok = STATFUNC(LOG_FILENAME, &statusret) == 0;
+            if (ok)
+            {
+#ifdef POSIX
+               size_t expected = ASYNC_LOG_THREADS * ASYNC_LOG_LINES * 12;
+#else
+               size_t expected = ASYNC_LOG_THREADS * ASYNC_LOG_LINES * 13;
+#endif
+               ok = (size_t) statusret.st_size == expected;
+            }
+            (void) xpc_close_logfile();
+            (void) xpc_errlevel_set(el);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "disable"))
+      {
+         ok = xpc_async_logging_set(false);
+         if (ok)
+            ok = ! xpc_async_logging();
+
+         unit_test_status_pass(&status, ok);
+      }
+      (void) xpc_async_logging_set(original_async);
+      (void) xpc_timestamps_set(original_timestamps, false);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_21()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests that the "ex" and "strerr" logging functions do not allocate
+ *    memory once their per-thread format buffer is large enough.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_format_allocations()
+ *    -  xpc_errprintex()
+ *    -  xpc_warnprintex()
+ *    -  xpc_infoprintex()
+ *    -  xpc_strerrprintex()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+errorlogging_test_02_21 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 21, _("errorlogging"), _("Format buffers")
+   );
+   if (ok)
+   {
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+      cbool_t original_timestamps = xpc_timestamps();
+      (void) xpc_timestamps_set(false, false);
+      (void) unlink(LOG_FILENAME);
+      ok = xpc_open_logfile(LOG_FILENAME);
+      if (ok)
+         ok = xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "label: message"))
+      {
+         if (ok)
+         {
+            char line[80];
+            FILE * fp;
+            xpc_errprintex("message", "label");
+            (void) xpc_close_logfile();
+            fp = fopen(LOG_FILENAME, "r");
+            ok = not_nullptr(fp);
+            if (ok)
+            {
+               ok = not_nullptr(fgets(line, (int) sizeof line, fp));
+               if (ok)
+                  ok = strcmp(line, "? label: message\n") == 0;
+
+               fclose(fp);
+            }
+            if (ok)
+               ok = xpc_append_logfile(LOG_FILENAME);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "steady state"))
+      {
+         if (ok)
+         {
+            size_t allocations = xpc_format_allocations();
+            int i;
+            for (i = 0; i < 100; i++)
+            {
+               xpc_errprintex("an error message", "a label");
+               xpc_warnprintex("a warning message", "a label");
+               xpc_infoprintex("an info message", "a label");
+               xpc_strerrprintex("a system error", "a label", EINVAL);
+            }
+            ok = xpc_format_allocations() == allocations;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "long message"))
+      {
+         if (ok)
+         {
+            char longmsg[1000];
+            size_t allocations = xpc_format_allocations();
+            memset(longmsg, 'x', sizeof longmsg - 1);
+            longmsg[sizeof longmsg - 1] = 0;
+            xpc_errprintex(longmsg, "a label");       /* grows the buffer     */
+            ok = xpc_format_allocations() > allocations;
+            if (ok)
+            {
+               allocations = xpc_format_allocations();
+               xpc_errprintex(longmsg, "a label");    /* reuses the buffer    */
+               ok = xpc_format_allocations() == allocations;
+            }
+         }
+         unit_test_status_pass(&status, ok);
+      }
+      (void) xpc_close_logfile();
+      (void) xpc_errlevel_set(el);
+      (void) xpc_timestamps_set(original_timestamps, false);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * printf_log_thread_function()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a thread that writes a fixed number of printf()-style lines
+ *    to the error-log, for testing that the lines are not interleaved.
+ *
+ * \return
+ *    Returns a null pointer.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+printf_log_thread_function
+(
+   void * unused        /**< Not used.                                        */
+)
+{
+   int line;
+   (void) unused;
+   for (line = 0; line < ASYNC_LOG_LINES; line++)
+      xpc_errprintf("%s%d", "12345678", 9);           /* "? 123456789\n"      */
+
+   return nullptr;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_22()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests that each printf()-style message is written as one whole line,
+ *    even when several threads log at once without the --synch option.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_errprintf()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+errorlogging_test_02_22 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 22, _("errorlogging"), _("Whole printf() lines")
+   );
+   if (ok)
+   {
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+      cbool_t original_timestamps = xpc_timestamps();
+      (void) xpc_timestamps_set(false, false);
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "several threads"))
+      {
+         (void) unlink(LOG_FILENAME);
+         ok = xpc_open_logfile(LOG_FILENAME);
+         if (ok)
+            ok = xpc_errlevel_set(XPC_ERROR_LEVEL_ERRORS);
+
+         if (ok)
+         {
+            pthread_t threads[ASYNC_LOG_THREADS];
+            int lines = 0;
+            int t;
+            FILE * fp;
+            for (t = 0; t < ASYNC_LOG_THREADS; t++)
+            {
+               threads[t] = pthreader_create
+               (
+                  nullptr, printf_log_thread_function, nullptr
+               );
+            }
+            for (t = 0; t < ASYNC_LOG_THREADS; t++)
+               (void) pthreader_join(threads[t]);
+
+            (void) xpc_close_logfile();
+            fp = fopen(LOG_FILENAME, "r");
+            ok = not_nullptr(fp);
+            if (ok)
+            {
+               char line[80];
+               while (ok && not_NULL(fgets(line, (int) sizeof line, fp)))
+               {
+                  ok = strcmp(line, "? 123456789\n") == 0;
+                  ++lines;
+               }
+               fclose(fp);
+            }
+            if (ok)
+               ok = lines == ASYNC_LOG_THREADS * ASYNC_LOG_LINES;
+         }
+         (void) xpc_errlevel_set(el);
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "time-stamp"))
+      {
+         (void) unlink(LOG_FILENAME);
+         ok = xpc_open_logfile(LOG_FILENAME);
+         if (ok)
+            ok = xpc_errlevel_set(XPC_ERROR_LEVEL_ERRORS);
+
+         if (ok)
+         {
+            FILE * fp;
+            (void) xpc_timestamps_set(true, false);
+            xpc_errprintf("%s", "stamped");
+            (void) xpc_timestamps_set(false, false);
+            (void) xpc_close_logfile();
+            fp = fopen(LOG_FILENAME, "r");
+            ok = not_nullptr(fp);
+            if (ok)
+            {
+               char line[80];
+               ok = not_NULL(fgets(line, (int) sizeof line, fp));
+               if (ok)
+                  ok = strncmp(line, "? [", 3) == 0;
+
+               if (ok)
+               {
+                  const char * bracket = strchr(line, ']');
+                  ok = not_NULL(bracket) && strcmp(bracket, "] stamped\n") == 0;
+               }
+
+               fclose(fp);
+            }
+         }
+         (void) xpc_errlevel_set(el);
+         unit_test_status_pass(&status, ok);
+      }
+      (void) xpc_timestamps_set(original_timestamps, false);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_23()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the inline error-level checks, and that a filtered-out
+ *    xpc_dbginfoprintf() call does not evaluate its arguments.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_errlevel_fast()
+ *    -  xpc_showerrors_fast()
+ *    -  xpc_showwarnings_fast()
+ *    -  xpc_showinfo_fast()
+ *    -  xpc_dbginfoprintf()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+errorlogging_test_02_23 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 23, _("errorlogging"), _("Fast level checks")
+   );
+   if (ok)
+   {
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+      cbool_t original_timestamps = xpc_timestamps();
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "macros match functions"))
+      {
+         int level;
+         for (level = XPC_ERROR_LEVEL_NONE; level <= XPC_ERROR_LEVEL_ALL; level++)
+         {
+            if (ok)
+               ok = xpc_errlevel_set(level);
+
+            if (ok)
+               ok = xpc_errlevel_fast() == xpc_errlevel();
+
+            if (ok)
+               ok = xpc_showerrors_fast() == xpc_showerrors();
+
+            if (ok)
+               ok = xpc_showwarnings_fast() == xpc_showwarnings();
+
+            if (ok)
+               ok = xpc_showinfo_fast() == xpc_showinfo();
+         }
+         (void) xpc_errlevel_set(el);
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "level keeps flags"))
+      {
+         (void) xpc_timestamps_set(true, false);
+         ok = xpc_errlevel_set(XPC_ERROR_LEVEL_WARNINGS);
+         if (ok)
+            ok = xpc_timestamps() && xpc_errlevel() == XPC_ERROR_LEVEL_WARNINGS;
+
+         if (ok)
+         {
+            (void) xpc_timestamps_set(false, false);
+            ok = ! xpc_timestamps() &&
+               xpc_errlevel() == XPC_ERROR_LEVEL_WARNINGS;
+         }
+         (void) xpc_errlevel_set(el);
+         (void) xpc_timestamps_set(original_timestamps, false);
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "filtered arguments"))
+      {
+         int evaluations = 0;
+         ok = xpc_errlevel_set(XPC_ERROR_LEVEL_ERRORS);
+         if (ok)
+         {
+            xpc_dbginfoprintf("%d", ++evaluations);
+            ok = evaluations == 0;
+         }
+         if (ok)                             /* still usable as expression */
+            ok = (xpc_dbginfoprintf("%d", ++evaluations), evaluations == 0);
+         (void) xpc_errlevel_set(el);
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "shown arguments"))
+      {
+         int evaluations = 0;
+         (void) unlink(LOG_FILENAME);
+         ok = xpc_open_logfile(LOG_FILENAME);
+         if (ok)
+            ok = xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+
+         if (ok)
+         {
+            xpc_dbginfoprintf("%d", ++evaluations);
+
+#ifdef DEBUG
+            ok = evaluations == 1;
+#else
+            ok = evaluations == 0;           /* compiled out entirely      */
+#endif
+
+         }
+         (void) xpc_close_logfile();
+         (void) xpc_errlevel_set(el);
+         unit_test_status_pass(&status, ok);
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_24()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the rotation of the log file by size, and on demand.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_logrotation_set()
+ *    -  xpc_logrotate()
+ *    -  xpc_file_rotate() [indirectly]
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define ROTATE_FILENAME    "rotlog.txt"
+
+static off_t
+rotated_file_size (const char * filename)
+{
+   STAT_T statusret;
+   off_t result = (off_t) (-1);
+   if (STATFUNC(filename, &statusret) == 0)
+      result = statusret.st_size;
+
+   return result;
+}
+
+static unit_test_status_t
+errorlogging_test_02_24 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 24, _("errorlogging"), _("Log rotation")
+   );
+   if (ok)
+   {
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "rotate by size"))
+      {
+         int line;
+         ok = xpc_logrotation_set(200, 0, 2);
+         if (ok)
+            ok = xpc_open_logfile(ROTATE_FILENAME);
+
+         if (ok)
+            ok = xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+
+         for (line = 0; ok && line < 40; line++)
+            xpc_infoprintf("rotation test line %d", line);
+
+         (void) xpc_close_logfile();
+         if (ok)
+         {
+            ok = rotated_file_size(ROTATE_FILENAME ".1") > 0 &&
+               rotated_file_size(ROTATE_FILENAME ".3") < 0;
+         }
+         if (ok && ! xpc_async_logging())     /* writer rotates per batch   */
+         {
+            ok = rotated_file_size(ROTATE_FILENAME ".2") > 0 &&
+               rotated_file_size(ROTATE_FILENAME) < 200;
+         }
+
+         (void) xpc_errlevel_set(el);
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "rotate on demand"))
+      {
+         (void) unlink(ROTATE_FILENAME);
+         ok = xpc_logrotation_set(0, 0, 1);
+         if (ok)
+            ok = xpc_append_logfile(ROTATE_FILENAME);
+
+         if (ok)
+            ok = xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);   /* --silent  */
+
+         if (ok)
+         {
+            xpc_print("before rotation");
+            ok = xpc_logrotate();
+         }
+         if (ok)
+         {
+            xpc_print("after rotation");
+            ok = xpc_close_logfile();
+         }
+         (void) xpc_errlevel_set(el);
+         if (ok)                             /* tag, space, and newline    */
+         {
+            ok = rotated_file_size(ROTATE_FILENAME ".1") ==
+               (off_t) strlen("before rotation") + 3;
+         }
+         if (ok)
+         {
+            ok = rotated_file_size(ROTATE_FILENAME) ==
+               (off_t) strlen("after rotation") + 3;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "bad settings"))
+      {
+         ok = ! xpc_logrotation_set(0, -1, 1);
+         if (ok)
+            ok = ! xpc_logrotation_set(0, 0, -1);
+
+         if (ok)
+            ok = ! xpc_logrotation_set(0, 0, XPC_LOG_KEEP_MAX + 1);
+
+         if (ok)
+            ok = ! xpc_logrotate();          /* stderr cannot be rotated   */
+
+         unit_test_status_pass(&status, ok);
+      }
+      (void) xpc_logrotation_set(0, 0, XPC_LOG_KEEP_DEFAULT);
+      (void) unlink(ROTATE_FILENAME);
+      (void) unlink(ROTATE_FILENAME ".1");
+      (void) unlink(ROTATE_FILENAME ".2");
+   }
+   return status;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_25()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the memory-mapped ring file as the destination of the log.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_open_logring()
+ *    -  xpc_close_logring()
+ *    -  xpc_ring_logging()
+ *    -  xpc_logring_map()
+ *    -  xpc_logring_walk()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define RING_FILENAME      "ringlog.bin"
+
+typedef struct
+{
+   size_t m_Count;                     /**< The number of records walked.     */
+   size_t m_Gaps;                      /**< Breaks in the sequence numbers.   */
+   uint64_t m_First;                   /**< Sequence of the oldest record.    */
+   uint64_t m_Last;                    /**< Sequence of the newest record.    */
+   char m_Text[80];                    /**< Text of the newest record.        */
+
+} ring_tally_t;
+
+static cbool_t
+ring_tally (uint64_t sequence, const char * text, size_t length, void * data)
+{
+   ring_tally_t * tally = (ring_tally_t *) data;
+   if (tally->m_Count == 0)
+      tally->m_First = sequence;
+   else if (sequence != tally->m_Last + 1)
+      tally->m_Gaps++;
+
+   if (length >= sizeof tally->m_Text)
+      length = sizeof tally->m_Text - 1;
+
+   memcpy(tally->m_Text, text, length);
+   tally->m_Text[length] = 0;
+   tally->m_Last = sequence;
+   tally->m_Count++;
+   return true;
+}
+
+static unit_test_status_t
+errorlogging_test_02_25 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 25, _("errorlogging"), _("Ring log sink")
+   );
+   if (ok)
+   {
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+      ring_tally_t tally;
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "append and walk"))
+      {
+         int line;
+         xpc_logring_t ring;
+         (void) unlink(RING_FILENAME);
+         ok = xpc_open_logring(RING_FILENAME, 4096);
+         if (ok)
+            ok = xpc_ring_logging() && xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+
+         for (line = 0; ok && line < 10; line++)
+            xpc_infoprintf("ring test line %d", line);
+
+         (void) xpc_errlevel_set(el);
+         if (ok)
+            ok = xpc_logring_map(&ring, RING_FILENAME);
+
+         if (ok)
+         {
+            memset(&tally, 0, sizeof tally);
+            ok = xpc_logring_walk(&ring, ring_tally, &tally) == 10;
+            (void) xpc_logring_close(&ring);
+         }
+         if (ok)
+            ok = tally.m_First == 0 && tally.m_Last == 9 && tally.m_Gaps == 0;
+
+         if (ok)
+            ok = strstr(tally.m_Text, "ring test line 9") != nullptr;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "wrap-around"))
+      {
+         int line;
+         xpc_logring_t ring;
+         ok = xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+         for (line = 10; ok && line < 500; line++)
+            xpc_infoprintf("ring test line %d", line);
+
+         (void) xpc_errlevel_set(el);
+         if (ok)
+            ok = xpc_logring_map(&ring, RING_FILENAME);
+
+         if (ok)
+         {
+            memset(&tally, 0, sizeof tally);
+            ok = xpc_logring_walk(&ring, ring_tally, &tally) > 0;
+            (void) xpc_logring_close(&ring);
+         }
+         if (ok)                             /* oldest lines overwritten   */
+         {
+            ok = tally.m_First > 0 && tally.m_Last == 499 &&
+               tally.m_Gaps == 0 && tally.m_Count < 500;
+         }
+         if (ok)
+            ok = strstr(tally.m_Text, "ring test line 499") != nullptr;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "close and reopen"))
+      {
+         ok = xpc_close_logring();
+         if (ok)
+            ok = ! xpc_ring_logging() && ! xpc_close_logring();
+
+         if (ok)                             /* the lines are kept         */
+            ok = xpc_open_logring(RING_FILENAME, 4096);
+
+         if (ok)
+         {
+            xpc_logring_t ring;
+            ok = xpc_close_logring();
+            if (ok)
+               ok = xpc_logring_map(&ring, RING_FILENAME);
+
+            if (ok)
+            {
+               memset(&tally, 0, sizeof tally);
+               ok = xpc_logring_walk(&ring, ring_tally, &tally) > 0;
+               (void) xpc_logring_close(&ring);
+            }
+            if (ok)
+               ok = tally.m_Last == 499;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "bad ring"))
+      {
+         (void) xpc_errlevel_set(XPC_ERROR_LEVEL_NONE);
+         ok = ! xpc_open_logring(RING_FILENAME, 16);
+         if (ok)
+            ok = ! xpc_ring_logging();
+
+         (void) xpc_errlevel_set(el);
+         unit_test_status_pass(&status, ok);
+      }
+      (void) unlink(RING_FILENAME);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_26()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the binary log records that defer the formatting of log lines.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_logrecord_encode()
+ *    -  xpc_logrecord_format()
+ *    -  xpc_binary_logging_set()
+ *    -  xpc_binary_logging()
+ *    -  xpc_logring_append_binary() [indirectly]
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define BINARY_FILENAME    "binlog.txt"
+
+static cbool_t
+record_matches (const char * fmt, ...)
+{
+   cbool_t result;
+   char record[XPC_LOGRECORD_MAX_SIZE];
+   char expected[XPC_LOGRECORD_TEXT_SIZE];
+   char actual[XPC_LOGRECORD_TEXT_SIZE];
+   int stamp[2] = { 12, 345 };
+   size_t length;
+   int prefix;
+   va_list val;
+   va_start(val, fmt);
+   length = xpc_logrecord_encode(record, sizeof record, "*", stamp, fmt, val);
+   va_end(val);
+   result = length > 0;
+   if (result)
+   {
+      result = xpc_logrecord_format(record, length, actual, sizeof actual) > 0;
+      prefix = snprintf(expected, sizeof expected, "* [12.000000345] ");
+      va_start(val, fmt);
+      (void) vsnprintf(&expected[prefix], sizeof expected - prefix, fmt, val);
+      va_end(val);
+      strcat(expected, "\n");
+   }
+   if (result)
+      result = strcmp(expected, actual) == 0;
+
+   return result;
+}
+
+static cbool_t
+record_refused (const char * fmt, ...)
+{
+   char record[XPC_LOGRECORD_MAX_SIZE];
+   size_t length;
+   va_list val;
+   va_start(val, fmt);
+   length = xpc_logrecord_encode(record, sizeof record, "*", nullptr, fmt, val);
+   va_end(val);
+   return length == 0;
+}
+
+typedef struct
+{
+   size_t m_Count;                     /**< The records visited so far.       */
+   uint64_t m_Sequence;                /**< The sequence of the last one.     */
+   cbool_t m_Ordered;                  /**< The sequences have increased.     */
+   char m_Last[80];                    /**< The text of the last one.         */
+
+} ring_visit_t;
+
+static cbool_t
+ring_binary_visit
+(
+   uint64_t sequence,
+   const char * text,
+   size_t length,
+   void * data
+)
+{
+   ring_visit_t * visit = (ring_visit_t *) data;
+   if (visit->m_Count > 0 && sequence <= visit->m_Sequence)
+      visit->m_Ordered = false;
+
+   visit->m_Count++;
+   visit->m_Sequence = sequence;
+   if (length >= sizeof visit->m_Last)
+      length = sizeof visit->m_Last - 1;
+
+   memcpy(visit->m_Last, text, length);
+   visit->m_Last[length] = 0;
+   return true;
+}
+
+static unit_test_status_t
+errorlogging_test_02_26 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 26, _("errorlogging"), _("Binary log records")
+   );
+   if (ok)
+   {
+      cbool_t original_async = xpc_async_logging();
+      cbool_t original_binary = xpc_binary_logging();
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "encode and format"))
+      {
+         const char * nonterminated = "abcdef";
+         int n = -7;
+         ok = record_matches("plain text, 100%% literal");
+         if (ok)
+            ok = record_matches("%d|%5i|%-5d|%+d|%05d", 1, 2, 3, 4, n);
+
+         if (ok)
+            ok = record_matches("%hhd %hd %hhu %hu", 300, 70000, 300, 70000);
+
+         if (ok)
+            ok = record_matches("%ld %lu %lld %llx", -5L, 6UL, -7LL, 255ULL);
+
+         if (ok)
+         {
+            ok = record_matches
+            (
+               "%zu %td %jd %#o %X", (size_t) 9, (ptrdiff_t) -9,
+               (intmax_t) 10, 8u, 0xBEEFu
+            );
+         }
+         if (ok)
+            ok = record_matches("%c%c %s %-8s| %8s|", 'o', 'k', "s", "l", "r");
+
+         if (ok)
+         {
+            ok = record_matches
+            (
+               "%.3s %*d %-*.*s|", nonterminated, 4, 5, 6, 2, "xyz"
+            );
+         }
+
+         if (ok)
+            ok = record_matches("%f %.2e %g %G", 1.5, 12345.678, 0.0001, 1e20);
+
+         if (ok)
+         {
+            ok = record_matches
+            (
+               "%Lf %p", (long double) 2.25, (void *) &n
+            );
+         }
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "cannot be deferred"))
+      {
+         int count;
+         char record[XPC_LOGRECORD_MAX_SIZE];
+         ok = record_refused("count%n", &count);
+         if (ok)
+            ok = record_refused("%1$d", 1);
+
+         if (ok)
+            ok = record_refused("%ls", L"wide");
+
+         if (ok)
+         {
+            memset(record, 'x', sizeof record - 1);
+            record[sizeof record - 1] = 0;
+            ok = record_refused("%s", record);            /* too long     */
+         }
+         if (ok)                                         /* damaged      */
+            ok = xpc_logrecord_format("\x20\x00", 2, record, sizeof record) == 0;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "ring file"))
+      {
+         xpc_logring_t ring;
+         ring_visit_t visit;
+         visit.m_Count = 0;
+         visit.m_Sequence = 0;
+         visit.m_Ordered = true;
+         visit.m_Last[0] = 0;
+         (void) unlink(RING_FILENAME);
+         ok = xpc_binary_logging_set(true) && xpc_binary_logging();
+         if (ok)
+            ok = xpc_open_logring(RING_FILENAME, 4096);
+
+         if (ok)
+         {
+            (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+            xpc_infoprintf("binary %d %s %.2f", 6, "six", 1.5);
+            xpc_infoprintf("binary %d %s %.2f", 7, "seven", 2.5);
+            (void) xpc_errlevel_set(el);
+            ok = xpc_close_logring();
+         }
+         if (ok)
+            ok = xpc_logring_map(&ring, RING_FILENAME);
+
+         if (ok)
+         {
+            ok = xpc_logring_walk(&ring, ring_binary_visit, &visit) == 2;
+            (void) xpc_logring_close(&ring);
+         }
+         if (ok)
+            ok = visit.m_Count == 2 && visit.m_Ordered;
+
+         if (ok)
+            ok = strstr(visit.m_Last, "binary 7 seven 2.50\n") != nullptr;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "writer thread"))
+      {
+         (void) unlink(BINARY_FILENAME);
+         ok = xpc_async_logging_set(true);
+         if (ok)
+            ok = xpc_open_logfile(BINARY_FILENAME);
+
+         if (ok)
+         {
+            int line;
+            (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+            for (line = 0; line < 100; line++)
+               xpc_infoprintf("binary %d %s %.2f", line, "seven", 2.5);
+
+            (void) xpc_errlevel_set(el);
+            xpc_flush_error_log();
+            ok = xpc_close_logfile();
+         }
+         if (ok)
+         {
+            char text[4096];
+            size_t count = 0;
+            FILE * fp = fopen(BINARY_FILENAME, "r");
+            ok = not_nullptr(fp);
+            if (ok)
+            {
+               count = fread(text, 1, sizeof text - 1, fp);
+               text[count] = 0;
+               fclose(fp);
+               ok = strstr(text, "binary 0 seven 2.50\n") != nullptr &&
+                  strstr(text, "binary 99 seven 2.50\n") != nullptr;
+            }
+         }
+         unit_test_status_pass(&status, ok);
+      }
+      (void) xpc_binary_logging_set(original_binary);
+      (void) xpc_async_logging_set(original_async);
+      (void) unlink(RING_FILENAME);
+      (void) unlink(BINARY_FILENAME);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_27()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the time-stamp clocks.  The coarse and TSC clocks are not
+ *    available on every system, so a failure to select them is not an
+ *    error, but a clock that can be selected must give nanosecond
+ *    time-stamps that do not go backward, and that agree with time().
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_timestamp_clock_set()
+ *    -  xpc_timestamp_clock()
+ *    -  xpc_timestamps_set()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define CLOCK_FILENAME     "clocklog.txt"
+
+static cbool_t
+clock_stamps_check (xpc_timestamp_clock_t clock)
+{
+   cbool_t result = xpc_open_logfile(CLOCK_FILENAME);
+   time_t start = time(NULL);
+   if (result)
+   {
+      int line;
+      for (line = 0; line < 20; line++)
+         xpc_infoprintf("clock %d line %d", (int) clock, line);
+
+      xpc_flush_error_log();
+      result = xpc_close_logfile();
+   }
+   if (result)
+   {
+      FILE * fp = fopen(CLOCK_FILENAME, "r");
+      result = not_nullptr(fp);
+      if (result)
+      {
+         char text[256];
+         double previous = 0.0;
+         int lines = 0;
+         while (result && not_nullptr(fgets(text, sizeof text, fp)))
+         {
+            const char * dot = strchr(text, '.');
+            const char * bracket = strchr(text, ']');
+            result = not_nullptr_2(dot, bracket) && (bracket - dot) == 10;
+            if (result)
+            {
+               double stamp = atof(strchr(text, '[') + 1);
+               result =
+               (
+                  stamp >= previous &&
+                  stamp >= (double) start - 1.0 &&
+                  stamp <= (double) time(NULL) + 1.0
+               );
+               previous = stamp;
+               lines++;
+            }
+         }
+         fclose(fp);
+         if (result)
+            result = lines >= 20;
+      }
+   }
+   return result;
+}
+
+static unit_test_status_t
+errorlogging_test_02_27 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 27, _("errorlogging"), _("Time-stamp clocks")
+   );
+   if (ok)
+   {
+      xpc_timestamp_clock_t original = xpc_timestamp_clock();
+      cbool_t original_stamps = xpc_timestamps();
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "clock selection"))
+      {
+         ok = xpc_timestamp_clock_set(XPC_TIMESTAMP_CLOCK_WALL);
+         if (ok)
+            ok = xpc_timestamp_clock() == XPC_TIMESTAMP_CLOCK_WALL;
+
+         if (ok)
+         {
+            if (xpc_timestamp_clock_set(XPC_TIMESTAMP_CLOCK_COARSE))
+               ok = xpc_timestamp_clock() == XPC_TIMESTAMP_CLOCK_COARSE;
+            else
+               ok = xpc_timestamp_clock() == XPC_TIMESTAMP_CLOCK_WALL;
+         }
+         if (ok)
+            ok = ! xpc_timestamp_clock_set((xpc_timestamp_clock_t) 99);
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "nanosecond time-stamps"))
+      {
+         xpc_timestamp_clock_t clock = XPC_TIMESTAMP_CLOCK_WALL;
+         (void) unlink(CLOCK_FILENAME);
+         (void) xpc_timestamps_set(true, false);
+         (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+         for ( ; ok && clock <= XPC_TIMESTAMP_CLOCK_TSC; clock++)
+         {
+            if (xpc_timestamp_clock_set(clock))
+               ok = clock_stamps_check(clock);
+         }
+         (void) xpc_errlevel_set(el);
+         (void) xpc_timestamps_set(original_stamps, false);
+         unit_test_status_pass(&status, ok);
+      }
+      (void) xpc_timestamp_clock_set(original);
+      (void) unlink(CLOCK_FILENAME);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * errorlogging_test_02_28()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the per-call-site rate limiting, and the "last message repeated"
+ *    lines that sum up the dropped lines.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_ratelimit_set()
+ *    -  xpc_ratelimit()
+ *    -  xpc_ratelimit_suppressed()
+ *    -  xpc_ratelimit_suppressed_total()
+ *    -  xpc_ratelimit_report()
+ *    -  xpc_infoprintf_site(), by way of xpc_infoprintf_here()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define RATE_FILENAME      "ratelog.txt"
+
+static const char * const gs_flood_format = "flood %d";
+static const char * const gs_flood_message = "flood message";
+
+static cbool_t
+rate_file_contains (const char * text)
+{
+   cbool_t result = false;
+   FILE * fp = fopen(RATE_FILENAME, "r");
+   if (not_nullptr(fp))
+   {
+      char line[256];
+      while (! result && not_nullptr(fgets(line, sizeof line, fp)))
+         result = strstr(line, text) != nullptr;
+
+      fclose(fp);
+   }
+   return result;
+}
+
+static void
+rate_flood_line (int line)                   /* one call site for all lines  */
+{
+   xpc_infoprintf(gs_flood_format, line);
+}
+
+static unit_test_status_t
+errorlogging_test_02_28 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 28, _("errorlogging"), _("Rate limiting")
+   );
+   if (ok)
+   {
+      xpc_errlevel_t el = xpc_errlevel();             /* get current value    */
+      (void) unlink(RATE_FILENAME);
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "token bucket"))
+      {
+         ok = xpc_ratelimit_set(10, 5) && xpc_ratelimit() == 10;
+         if (ok)
+            ok = xpc_open_logfile(RATE_FILENAME);
+
+         if (ok)
+         {
+            int line;
+            unsigned long dropped;
+            (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+            for (line = 0; line < 100; line++)
+               rate_flood_line(line);
+
+            (void) xpc_errlevel_set(el);
+            dropped = xpc_ratelimit_suppressed(gs_flood_format);
+            ok = dropped >= 90 && dropped <= 95;
+            if (ok)
+               ok = xpc_ratelimit_suppressed_total() == dropped;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "repeated line"))
+      {
+         (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+         xpc_ms_sleep(250);                           /* earn a token         */
+         rate_flood_line(100);
+         (void) xpc_errlevel_set(el);
+         xpc_flush_error_log();
+         ok = rate_file_contains("last message repeated ");
+         if (ok)
+            ok = rate_file_contains("flood 100");
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "labelled call site"))
+      {
+         int line;
+         (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+         for (line = 0; line < 20; line++)
+            xpc_errprintex(gs_flood_message, "label");
+
+         xpc_ratelimit_report();
+         (void) xpc_errlevel_set(el);
+         ok = xpc_ratelimit_suppressed(gs_flood_message) >= 10;
+         if (ok)
+         {
+            xpc_flush_error_log();
+            ok = rate_file_contains("times: flood message");
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "separate call sites"))
+      {
+         ok = xpc_ratelimit_set(10, 5);
+         if (ok)
+         {
+            int line;
+            int evaluations = 0;
+            (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+            for (line = 0; line < 5; line++)
+            {
+               xpc_infoprintf_here(gs_flood_format, line);  /* one site...    */
+               xpc_infoprintf_here(gs_flood_format, line);  /* ...another     */
+            }
+            (void) xpc_errlevel_set(XPC_ERROR_LEVEL_ERRORS);
+            xpc_infoprintf_here(gs_flood_format, ++evaluations);  /* filtered */
+            (void) xpc_errlevel_set(el);
+            ok = xpc_ratelimit_suppressed_total() == 0 && evaluations == 0;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  5 */
+
+      if (unit_test_status_next_subtest(&status, "no limit"))
+      {
+         ok = xpc_ratelimit_set(0, 0) && xpc_ratelimit() == 0;
+         if (ok)
+            ok = xpc_ratelimit_suppressed_total() == 0;
+
+         if (ok)
+         {
+            int line;
+            (void) xpc_errlevel_set(XPC_ERROR_LEVEL_INFO);
+            for (line = 0; line < 20; line++)
+               xpc_infoprintf(gs_flood_format, line);
+
+            (void) xpc_errlevel_set(el);
+            ok = xpc_ratelimit_suppressed(gs_flood_format) == 0;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+      (void) xpc_ratelimit_set(0, 0);
+      (void) xpc_close_logfile();
+      (void) unlink(RATE_FILENAME);
+   }
+   return status;
+}
+
 /******************************************************************************
  * plain_string_thread_function()
  *------------------------------------------------------------------------*//**
@@ -2881,7 +4309,16 @@ XPC_TEST_NAME "-specific options:\n"
                (void) unit_test_load(&testbattery, errorlogging_test_02_16);
                (void) unit_test_load(&testbattery, errorlogging_test_02_17);
                (void) unit_test_load(&testbattery, errorlogging_test_02_18);
-               ok = unit_test_load(&testbattery, errorlogging_test_02_19);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_19);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_20);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_21);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_22);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_23);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_24);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_25);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_26);
+               (void) unit_test_load(&testbattery, errorlogging_test_02_27);
+               ok = unit_test_load(&testbattery, errorlogging_test_02_28);
             }
             if (ok)
             {
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * logring_dump.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          logring_dump.c
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \updates       2013-08-10 to 2013-08-10
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    This application prints the lines held in a ring file written by the
+ *    "--log-ring file" option of the XPC error-logging module.
+ *
+ *    Usage:
+ *
+\verbatim
+         logring_dump file
+\endverbatim
+ *
+ *    Each line is preceded by its sequence number.  Lines lost to the
+ *    wrap-around of the ring, or to a crash in the middle of writing a
+ *    line, are noted by a "lost" line.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/errorlogging.h>          /* macros and external functions       */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/logring.h>               /* xpc_logring_map(), etc.             */
+
+/******************************************************************************
+ * dump_state_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tracks the sequence numbers seen by dump_line().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   cbool_t m_Started;                  /**< A record has been seen.           */
+   uint64_t m_Next;                    /**< The expected sequence number.     */
+
+} dump_state_t;
+
+/******************************************************************************
+ * dump_line()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Prints one record of the ring, and notes any gap before it.  The text
+ *    already ends with a newline.
+ *
+ * \return
+ *    Always returns 'true', to walk the whole ring.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+dump_line (uint64_t sequence, const char * text, size_t length, void * data)
+{
+   dump_state_t * state = (dump_state_t *) data;
+   if (state->m_Started && sequence != state->m_Next)
+   {
+      fprintf
+      (
+         stdout, "--- %llu %s\n",
+         (unsigned long long) (sequence - state->m_Next), _("lines lost")
+      );
+   }
+   fprintf(stdout, "%llu ", (unsigned long long) sequence);
+   (void) fwrite(text, 1, length, stdout);
+   state->m_Started = true;
+   state->m_Next = sequence + 1;
+   return true;
+}
+
+/******************************************************************************
+ * main()
+ *------------------------------------------------------------------------*//**
+ *
+ *    This is the main routine for the logring_dump application.
+ *
+ * \return
+ *    Returns EXIT_SUCCESS if the file could be read.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+main
+(
+   int argc,               /**< Number of command-line arguments.             */
+   char * argv []          /**< The actual array of command-line arguments.   */
+)
+{
+   cbool_t ok = argc == 2;
+   if (ok)
+   {
+      xpc_logring_t ring;
+      ok = xpc_logring_map(&ring, argv[1]);
+      if (ok)
+      {
+         dump_state_t state;
+         size_t count;
+         state.m_Started = false;
+         state.m_Next = 0;
+         count = xpc_logring_walk(&ring, dump_line, &state);
+         fprintf(stdout, "--- %lu %s\n", (unsigned long) count, _("lines"));
+         (void) xpc_logring_close(&ring);
+      }
+   }
+   else
+      fprintf(stderr, "%s: logring_dump file\n", _("usage"));
+
+   return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/******************************************************************************
+ * logring_dump.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
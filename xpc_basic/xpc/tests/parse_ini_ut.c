@@ -354,6 +354,8 @@ parse_ini_01_01 (const unit_test_options_t * options)
          unit_test_status_pass(&status, ok);
       }
 
+      xpc_delete_argv(argv, buffer);   // delete sub-test 3 and 4 leftovers
+
       /*
        * Now verify that sections can be found.
        */
@@ -404,7 +406,7 @@ parse_ini_01_01 (const unit_test_options_t * options)
          show_arguments("Smoke Test C", argc, argv);
          unit_test_status_pass(&status, ok);
       }
-      xpc_delete_argv(argv, buffer);   // delete sub-test 3 and 4 leftovers
+      xpc_delete_argv(argv, buffer);   // delete sub-test 5 leftovers
    }
    else
       unit_test_status_pass(&status, false);
@@ -416,33 +418,141 @@ parse_ini_01_01 (const unit_test_options_t * options)
  * parse_ini_02_01()
  *------------------------------------------------------------------------*//**
  *
- *    A stub unit-test.
+ *    Checks that lines longer than the old 512-character line buffer are
+ *    read whole, and that several sections are read in one call.
+ *
+ *    The INI file is written by the test, and deleted at the end.
  *
  * \param options
  *    Provides the options given to the application on the command-line.
  *
  * \test
- *    -  portable()
+ *    -  xpc_argv_from_INI_sections()
+ *    -  xpc_argv_from_INI()
+ *    -  xpc_delete_argv()
  *
  *//*-------------------------------------------------------------------------*/
 
+#define LONG_INI_FILE      "parse_ini_long.ini"
+#define LONG_VALUE_SIZE    2000
+#define LONG_NAME_SIZE     600
+
 static unit_test_status_t
 parse_ini_02_01 (const unit_test_options_t * options)
 {
    unit_test_status_t status;
+   char longvalue[LONG_VALUE_SIZE + 1];
+   char longname[LONG_NAME_SIZE + 1];
    cbool_t ok = unit_test_status_initialize
    (
-      &status, options, 1, 1, _("xxxx"), _("xx")
+      &status, options, 2, 1, _("Parse INI"), _("Long Lines and Sections")
    );
    if (ok)
+   {
+      FILE * fhandle = fopen(LONG_INI_FILE, "w");
+      (void) memset(longvalue, 'v', LONG_VALUE_SIZE);
+      longvalue[LONG_VALUE_SIZE] = 0;
+      (void) memset(longname, 'n', LONG_NAME_SIZE);
+      longname[LONG_NAME_SIZE] = 0;
+      ok = not_nullptr(fhandle);
+      if (ok)
+      {
+         fprintf(fhandle, "[ First ]\n\nONE = 1\nLONG = %s\n\n", longvalue);
+         fprintf(fhandle, "[ Skipped ]\n\nNOPE = nope\n\n");
+         fprintf(fhandle, "[Second]\n\nTWO = \"two words\"\n");
+         fprintf(fhandle, "FLAG ; x = y\n\n");
+         fprintf(fhandle, "[ First ]\n\nAGAIN = again\n\n");
+         fprintf(fhandle, "[ %s ]\n\nTHREE = 3", longname);
+         ok = fclose(fhandle) == 0;
+      }
+   }
+   if (ok)
    {
       /*  1 */
 
-      if (unit_test_status_next_subtest(&status, "xxxx()"))
+      if (unit_test_status_next_subtest(&status, "Two sections in one pass"))
+      {
+         const char * sections[3];
+         int argc;
+         char * buffer;
+         char ** argv;
+         sections[0] = "Second";
+         sections[1] = "First";
+         sections[2] = nullptr;
+         argv = xpc_argv_from_INI_sections
+         (
+            LONG_INI_FILE, sections, &argc, &buffer
+         );
+         ok = not_nullptr(argv);
+         if (ok)
+            ok = not_nullptr(buffer);
+
+         if (ok)
+            ok = argc == 8;
+
+         if (ok)
+         {
+            /*
+             * The options come in file order, and the second "[ First ]"
+             * section is not read.
+             */
+
+            ok = strcmp(argv[0], LONG_INI_FILE) == 0;
+            if (ok)
+               ok = strcmp(argv[1], "--ONE") == 0 ;
+            if (ok)
+               ok = strcmp(argv[2], "1") == 0 ;
+            if (ok)
+               ok = strcmp(argv[3], "--LONG") == 0 ;
+            if (ok)
+               ok = strcmp(argv[4], longvalue) == 0 ;
+            if (ok)
+               ok = strcmp(argv[5], "--TWO") == 0 ;
+            if (ok)
+               ok = strcmp(argv[6], "two words") == 0 ;
+            if (ok)
+               ok = strcmp(argv[7], "--FLAG") == 0 ;
+            if (ok)
+               ok = is_null_result(argv[8]);
+         }
+         if (not_null_result(argv))
+         {
+            show_arguments("Second, First", argc, argv);
+            xpc_delete_argv(argv, buffer);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "Long section name"))
       {
+         int argc;
+         char * buffer;
+         char ** argv = xpc_argv_from_INI
+         (
+            LONG_INI_FILE, longname, &argc, &buffer
+         );
+         ok = not_nullptr(argv);
+         if (ok)
+            ok = argc == 3;
+
+         if (ok)
+         {
+            ok = strcmp(argv[1], "--THREE") == 0;
+            if (ok)
+               ok = strcmp(argv[2], "3") == 0 ;
+         }
+         if (not_null_result(argv))
+            xpc_delete_argv(argv, buffer);
+
          unit_test_status_pass(&status, ok);
       }
+      (void) remove(LONG_INI_FILE);
    }
+   else
+      unit_test_status_pass(&status, false);
+
    return status;
 }
 
@@ -16,7 +16,8 @@
  *
  *       -  Group 1. Basic unit-tests of the portable-related functions.  Also
  *          referred to as the "smoke tests".
- *       -  Group 2. Basic unit-tests of the portable_support.c functions.
+ *       -  Group 2. Basic unit-tests of the portable_support.c functions,
+ *          including the stopwatches.
  *
  *    Some other odds-and-ends are included in this application.
  *
@@ -27,6 +28,8 @@
 #include <xpc/errorlogging.h>          /* macros and external functions       */
 #include <xpc/gettext_support.h>       /* _() internationalization macro      */
 #include <xpc/unit_test.h>             /* unit_test_t structure               */
+#include <xpc/pthread_attributes.h>    /* pthread_attributes_init()           */
+#include <xpc/pthreader.h>             /* pthreader_create(), etc.            */
 
 /******************************************************************************
  * portable_test_01_01()
@@ -113,6 +116,168 @@ portable_test_02_01 (const unit_test_options_t * options)
    return status;
 }
 
+/******************************************************************************
+ * stopwatch_thread()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Times a sleep of the given number of milliseconds on the thread's
+ *    default stopwatch, sleeping in two halves so that the laps can be
+ *    checked too.  Threads running this at the same time must each get
+ *    their own times.
+ *
+ * \return
+ *    Returns the parameter if the times are plausible, and nullptr
+ *    otherwise.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+stopwatch_thread
+(
+   void * data             /**< The number of milliseconds to sleep.          */
+)
+{
+   unsigned long ms = (unsigned long) (intptr_t) data;
+   double seconds = ms * 1.0e-3;
+   double lap1, lap2, total;
+   xpc_stopwatch_start();
+   xpc_ms_sleep(ms / 2);
+   lap1 = xpc_stopwatch_lap();
+   xpc_ms_sleep(ms - ms / 2);
+   lap2 = xpc_stopwatch_lap();
+   total = xpc_stopwatch_duration();
+   return total >= seconds * 0.9 && total < seconds + 0.5 &&
+      lap1 + lap2 <= total && lap1 > 0.0 && lap2 > 0.0 ? data : nullptr ;
+}
+
+/******************************************************************************
+ * portable_test_02_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the monotonic clock and the stopwatches.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_monotonic_nanoseconds()
+ *    -  xpc_stopwatch_start_ex()
+ *    -  xpc_stopwatch_duration_ex()
+ *    -  xpc_stopwatch_duration_ns()
+ *    -  xpc_stopwatch_lap_ex()
+ *    -  xpc_stopwatch_lap_ns()
+ *    -  xpc_stopwatch_thread()
+ *    -  xpc_stopwatch_start()
+ *    -  xpc_stopwatch_duration()
+ *    -  xpc_stopwatch_lap()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+portable_test_02_02 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 2, _("portable"), _("Stopwatches")
+   );
+   if (ok)
+   {
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "Monotonic clock"))
+      {
+         uint64_t t0 = xpc_monotonic_nanoseconds();
+         uint64_t t1 = xpc_monotonic_nanoseconds();
+         ok = t0 > 0 && t1 >= t0;
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "Unstarted stopwatch"))
+      {
+         xpc_stopwatch_t sw = { 0, 0, false };
+         ok = xpc_stopwatch_duration_ns(&sw) == 0 &&
+            xpc_stopwatch_lap_ns(&sw) == 0 &&
+            xpc_stopwatch_duration_ex(&sw) == 0.0;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "Nested stopwatches"))
+      {
+         xpc_stopwatch_t outer;
+         xpc_stopwatch_t inner;
+         uint64_t inner_ns, lap1, lap2, outer_ns;
+         xpc_stopwatch_start_ex(&outer);
+         xpc_ms_sleep(5);
+         xpc_stopwatch_start_ex(&inner);
+         xpc_ms_sleep(10);
+         inner_ns = xpc_stopwatch_duration_ns(&inner);
+         lap1 = xpc_stopwatch_lap_ns(&outer);
+         xpc_ms_sleep(5);
+         lap2 = xpc_stopwatch_lap_ns(&outer);
+         outer_ns = xpc_stopwatch_duration_ns(&outer);
+         ok = inner_ns >= 9000000 && lap1 >= inner_ns + 4000000 &&
+            lap2 >= 4000000 && lap1 + lap2 <= outer_ns;
+
+         if (unit_test_options_show_values(options))
+         {
+            fprintf
+            (
+               stdout, "  inner %lu ns, laps %lu + %lu ns, outer %lu ns\n",
+               (unsigned long) inner_ns, (unsigned long) lap1,
+               (unsigned long) lap2, (unsigned long) outer_ns
+            );
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "Thread default stopwatch"))
+      {
+         xpc_stopwatch_start();
+         ok = xpc_stopwatch_thread()->m_Started &&
+            xpc_stopwatch_duration_ex(xpc_stopwatch_thread()) >= 0.0;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  5 */
+
+      if (unit_test_status_next_subtest(&status, "Concurrent stopwatches"))
+      {
+         pthread_attr_t x_attributes;
+         pthread_t fast, slow;
+         xpc_stopwatch_start();
+         ok = pthread_attributes_init(&x_attributes);
+         fast = pthreader_create
+         (
+            &x_attributes, stopwatch_thread, (void *) (intptr_t) 20
+         );
+         slow = pthreader_create
+         (
+            &x_attributes, stopwatch_thread, (void *) (intptr_t) 60
+         );
+         if (is_NULL(pthreader_join(fast)))
+            ok = false;
+
+         if (is_NULL(pthreader_join(slow)))
+            ok = false;
+
+         if (ok)                          /* the main watch kept running   */
+            ok = xpc_stopwatch_duration() >= 0.054;
+
+         unit_test_status_pass(&status, ok);
+      }
+   }
+   return status;
+}
+
 /******************************************************************************
  * Macro
  *------------------------------------------------------------------------*//**
@@ -229,6 +394,7 @@ main
             if (ok)
             {
                (void) unit_test_load(&testbattery, portable_test_02_01);
+               (void) unit_test_load(&testbattery, portable_test_02_02);
 
                // ok = unit_test_load(&testbattery, portable_test_02_yy);
             }
@@ -0,0 +1,538 @@
+/******************************************************************************
+ * profiler_ut.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          profiler_ut.c
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \updates       2013-08-17
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    This application provides unit tests of the XPC library histogram.c
+ *    and profiler.c modules.
+ *
+ *    The unit-test groups planned are:
+ *
+ *       -  Group 1. Basic unit-tests of the histograms and of the
+ *          profiling zones.
+ *       -  Group 2. The cost of recording a zone.  Use --show-values to
+ *          see it.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/portable.h>              /* xpc_ms_sleep(), stopwatches         */
+#include <xpc/errorlogging.h>          /* macros and external functions       */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/unit_test.h>             /* unit_test_t structure               */
+#include <xpc/pthread_attributes.h>    /* pthread_attributes_init()           */
+#include <xpc/pthreader.h>             /* pthreader_create(), etc.            */
+#include <xpc/profiler.h>              /* XPC_PROFILE_BEGIN(), etc.           */
+#include <xpc/atomix.h>                /* xpc_cpu_relax()                     */
+
+#if XPC_HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+#if XPC_HAVE_STDLIB_H
+#include <stdlib.h>                    /* malloc() and free()                 */
+#endif
+
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* strcmp(), strstr()                  */
+#endif
+
+/******************************************************************************
+ * Profiler test constants
+ *------------------------------------------------------------------------*//**
+ *
+ *    The number of threads and records for the threaded zone test, the
+ *    number of records in the overhead test, and the file the zone table
+ *    is dumped to.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define PROFILE_THREADS             3
+#define PROFILE_RECORDS             1000
+#define PROFILE_BENCH_RECORDS       1000000
+#define PROFILE_DUMP_FILE           "profiler_ut.txt"
+
+/******************************************************************************
+ * profile_zone_thread()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Records PROFILE_RECORDS times in the "worker" zone, from a thread of
+ *    its own, and then exits, so that its histograms are retired.
+ *
+ * \return
+ *    Returns the parameter, as the non-null result pthreader_join() wants.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+profile_zone_thread (void * data)
+{
+   int r;
+   for (r = 0; r < PROFILE_RECORDS; ++r)
+   {
+      XPC_PROFILE_BEGIN(worker);
+      xpc_cpu_relax();
+      XPC_PROFILE_END(worker);
+   }
+   return data;
+}
+
+/******************************************************************************
+ * profile_scoped()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Times its body with XPC_PROFILE_SCOPE(), leaving early on odd
+ *    values, to check that every exit path is recorded.
+ *
+ * \return
+ *    Returns the parameter.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static int
+profile_scoped (int value)
+{
+#if defined XPC_PROFILE_SCOPE
+   XPC_PROFILE_SCOPE(scoped);
+#endif
+   if ((value % 2) != 0)
+      return value;
+
+   xpc_cpu_relax();
+   return value;
+}
+
+/******************************************************************************
+ * profiler_test_01_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the HDR-style histograms.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_histogram_init()
+ *    -  xpc_histogram_index()
+ *    -  xpc_histogram_highest_equivalent()
+ *    -  xpc_histogram_record()
+ *    -  xpc_histogram_merge()
+ *    -  xpc_histogram_percentile()
+ *    -  xpc_histogram_mean()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+profiler_test_01_01 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 1, 1, _("xpc_histogram"), _("Histograms")
+   );
+   if (ok)
+   {
+      xpc_histogram_t * h1 = malloc(sizeof(xpc_histogram_t));
+      xpc_histogram_t * h2 = malloc(sizeof(xpc_histogram_t));
+      ok = not_NULL(h1) && not_NULL(h2);
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "Bucket layout"))
+      {
+         if (ok)
+         {
+            uint64_t v;
+            int last = 0;
+            ok = xpc_histogram_index(0) == 0 && xpc_histogram_index(63) == 63;
+            for (v = 1; ok && v < ((uint64_t) 1 << 41); v += v / 7 + 1)
+            {
+               int b = xpc_histogram_index(v);
+               uint64_t high = xpc_histogram_highest_equivalent(b);
+               ok = b >= last && b < XPC_HISTOGRAM_BUCKETS;
+               if (ok && v < ((uint64_t) 1 << XPC_HISTOGRAM_MAX_BITS))
+               {
+                  ok = high >= v && (double) (high - v) <= v / 32.0 + 1.0 &&
+                     xpc_histogram_index(high) == b;
+
+                  if (ok && b < XPC_HISTOGRAM_BUCKETS - 1)
+                     ok = xpc_histogram_index(high + 1) == b + 1;
+               }
+               last = b;
+            }
+            if (ok)
+               ok = last == XPC_HISTOGRAM_BUCKETS - 1;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "Percentiles"))
+      {
+         if (ok)
+         {
+            uint64_t v;
+            xpc_histogram_init(h1);
+            ok = xpc_histogram_percentile(h1, 50.0) == 0 &&
+               xpc_histogram_mean(h1) == 0.0;
+
+            for (v = 1; v <= 10000; ++v)
+               xpc_histogram_record(h1, v * 1000);
+
+            if (ok)
+            {
+               uint64_t p50 = xpc_histogram_percentile(h1, 50.0);
+               uint64_t p99 = xpc_histogram_percentile(h1, 99.0);
+               uint64_t p100 = xpc_histogram_percentile(h1, 100.0);
+               ok = h1->m_Count == 10000 && h1->m_Min == 1000 &&
+                  h1->m_Max == 10000000 &&
+                  p50 >= 5000000 && p50 <= 5000000 * 1.04 &&
+                  p99 >= 9900000 && p99 <= 9900000 * 1.04 &&
+                  p100 == 10000000 &&
+                  xpc_histogram_mean(h1) == 5000500.0;
+
+               if (unit_test_options_show_values(options))
+               {
+                  fprintf
+                  (
+                     stdout, "  p50 %lu, p99 %lu, p100 %lu\n",
+                     (unsigned long) p50, (unsigned long) p99,
+                     (unsigned long) p100
+                  );
+               }
+            }
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "Merge"))
+      {
+         if (ok)
+         {
+            xpc_histogram_init(h2);
+            xpc_histogram_record(h2, 5);
+            xpc_histogram_record(h2, 20000000);
+            xpc_histogram_merge(h2, h1);
+            ok = h2->m_Count == 10002 && h2->m_Min == 5 &&
+               h2->m_Max == 20000000 &&
+               xpc_histogram_percentile(h2, 0.0) == 5;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+      free(h2);
+      free(h1);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * profiler_test_01_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the profiling zones, from several threads, and the reports.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  XPC_PROFILE_BEGIN(), XPC_PROFILE_END(), and XPC_PROFILE_SCOPE()
+ *    -  xpc_profile_record()
+ *    -  xpc_profile_scope_end()
+ *    -  xpc_profile_zone_count()
+ *    -  xpc_profile_zone_name()
+ *    -  xpc_profile_merge()
+ *    -  xpc_profile_dump()
+ *    -  xpc_profile_dump_file()
+ *    -  xpc_profile_reset()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+profiler_test_01_02 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 1, 2, _("xpc_profile"), _("Profiling Zones")
+   );
+   if (ok)
+   {
+      xpc_histogram_t * h = malloc(sizeof(xpc_histogram_t));
+      ok = not_NULL(h);
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "Begin and end"))
+      {
+         if (ok)
+         {
+            int r;
+            for (r = 0; r < 3; ++r)
+            {
+               XPC_PROFILE_BEGIN(sleeper);
+               xpc_ms_sleep(2);
+               XPC_PROFILE_END(sleeper);
+            }
+            ok = xpc_profile_merge("sleeper", h) && h->m_Count == 3 &&
+               h->m_Min >= 1900000;
+
+            if (ok)
+               ok = ! xpc_profile_merge("no such zone", h);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "Scoped zone"))
+      {
+#if defined XPC_PROFILE_SCOPE
+         if (ok)
+         {
+            int v;
+            for (v = 0; v < 10; ++v)
+               (void) profile_scoped(v);
+
+            ok = xpc_profile_merge("scoped", h) && h->m_Count == 10;
+         }
+#else
+         (void) profile_scoped(0);
+#endif
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "Threads"))
+      {
+         if (ok)
+         {
+            pthread_attr_t x_attributes;
+            pthread_t threads[PROFILE_THREADS];
+            int t;
+            ok = pthread_attributes_init(&x_attributes);
+            for (t = 0; t < PROFILE_THREADS; ++t)
+            {
+               threads[t] = pthreader_create
+               (
+                  &x_attributes, profile_zone_thread, &threads[t]
+               );
+            }
+            for (t = 0; t < PROFILE_THREADS; ++t)
+            {
+               if (is_NULL(pthreader_join(threads[t])))
+                  ok = false;
+            }
+            (void) profile_zone_thread(h);      /* and the main thread too */
+            if (ok)
+            {
+               ok = xpc_profile_merge("worker", h) &&
+                  h->m_Count == (PROFILE_THREADS + 1) * PROFILE_RECORDS;
+            }
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "Zone names"))
+      {
+         if (ok)
+         {
+            int count = xpc_profile_zone_count();
+            int id;
+            cbool_t found = false;
+            for (id = 1; id <= count; ++id)
+            {
+               if (strcmp(xpc_profile_zone_name(id), "worker") == 0)
+                  found = true;
+            }
+            ok = found && count >= 2 && is_NULL(xpc_profile_zone_name(0)) &&
+               is_NULL(xpc_profile_zone_name(count + 1));
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  5 */
+
+      if (unit_test_status_next_subtest(&status, "Dump"))
+      {
+         if (ok)
+         {
+            (void) remove(PROFILE_DUMP_FILE);
+            ok = xpc_profile_dump_file(PROFILE_DUMP_FILE);
+            if (ok)
+            {
+               FILE * fp = fopen(PROFILE_DUMP_FILE, "r");
+               int lines = 0;
+               ok = not_NULL(fp);
+               if (ok)
+               {
+                  char text[256];
+                  while (not_NULL(fgets(text, sizeof text, fp)))
+                  {
+                     if (strncmp(text, "worker ", 7) == 0)
+                        ok = strstr(text, " 4000 ") != nullptr;
+
+                     ++lines;
+                  }
+                  fclose(fp);
+               }
+               if (ok)
+                  ok = lines == 1 + xpc_profile_zone_count();
+
+               (void) remove(PROFILE_DUMP_FILE);
+            }
+            if (unit_test_options_show_values(options))
+               xpc_profile_dump(stdout);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  6 */
+
+      if (unit_test_status_next_subtest(&status, "Reset"))
+      {
+         if (ok)
+         {
+            xpc_profile_reset();
+            ok = xpc_profile_merge("worker", h) && h->m_Count == 0;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+      free(h);
+   }
+   return status;
+}
+
+/******************************************************************************
+ * profiler_test_02_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Measures the cost of timing an empty zone:  two clock reads and a
+ *    histogram record.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  XPC_PROFILE_BEGIN() and XPC_PROFILE_END()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+profiler_test_02_01 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 1, _("xpc_profile"), _("Zone Overhead")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         /*  1 */
+
+         if (unit_test_status_next_subtest(&status, "Empty zone"))
+         {
+            xpc_stopwatch_t sw;
+            uint64_t ns;
+            int r;
+            xpc_stopwatch_start_ex(&sw);
+            for (r = 0; r < PROFILE_BENCH_RECORDS; ++r)
+            {
+               XPC_PROFILE_BEGIN(empty);
+               XPC_PROFILE_END(empty);
+            }
+            ns = xpc_stopwatch_duration_ns(&sw);
+            if (unit_test_options_show_values(options))
+            {
+               fprintf
+               (
+                  stdout, "  %.1f ns per zone\n",
+                  (double) ns / PROFILE_BENCH_RECORDS
+               );
+            }
+            unit_test_status_pass(&status, ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * Macro
+ *------------------------------------------------------------------------*//**
+ *
+ *    The executable name of the application.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_TEST_NAME         "profiler_ut"
+
+/******************************************************************************
+ * main()
+ *------------------------------------------------------------------------*//**
+ *
+ *    This is the main routine for the profiler_ut application.
+ *
+ * \return
+ *    Returns POSIX_SUCCESS (0) if the function succeeds.  Other values,
+ *    including possible error-codes, are returned otherwise.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+main
+(
+   int argc,               /**< Number of command-line arguments.             */
+   char * argv []          /**< The actual array of command-line arguments.   */
+)
+{
+   unit_test_t testbattery;                           /* uses default values  */
+   cbool_t ok = xpc_parse_errlevel(argc, argv);       /* cool feature         */
+   ok = unit_test_initialize
+   (
+      &testbattery, argc, argv,
+      XPC_TEST_NAME,
+      "Profiler Test 0.1",
+      nullptr                                         /* no added help        */
+   );
+   if (ok)                                /* \note fails if --help specified  */
+   {
+      ok = unit_test_load(&testbattery, profiler_test_01_01);
+      if (ok)
+      {
+         (void) unit_test_load(&testbattery, profiler_test_01_02);
+         (void) unit_test_load(&testbattery, profiler_test_02_01);
+      }
+      if (ok)
+         ok = unit_test_run(&testbattery);
+      else
+         xpccut_errprint(_("test function load failed"));
+   }
+   unit_test_destroy(&testbattery);
+   return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/******************************************************************************
+ * profiler_ut.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
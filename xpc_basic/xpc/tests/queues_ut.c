@@ -0,0 +1,975 @@
+/******************************************************************************
+ * queues_ut.c
+ *------------------------------------------------------------------------*//**
+ *
+ * \file          queues_ut.c
+ * \library       xpc_suite
+ * \author        Chris Ahlstrom
+ * \updates       2013-08-15
+ * \version       $Revision$
+ * \license       $XPC_SUITE_GPL_LICENSE$
+ *
+ *    This application provides unit tests of the XPC library queues.c/h
+ *    module, and a throughput benchmark of its queues.
+ *
+ *    The unit-test groups planned are:
+ *
+ *       -  Group 1. Basic unit-tests of the SPSC and MPMC queues, and of
+ *          their blocking functions.
+ *       -  Group 2. Throughput tests, with producer and consumer threads.
+ *          Use --show-values to see the items per second.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#include <xpc/build_versions.h>        /* informative show-build functions    */
+#include <xpc/portable.h>              /* xpc_stopwatch_start(), etc.         */
+#include <xpc/errorlogging.h>          /* macros and external functions       */
+#include <xpc/gettext_support.h>       /* _() internationalization macro      */
+#include <xpc/unit_test.h>             /* unit_test_t structure               */
+#include <xpc/pthread_attributes.h>    /* pthread_attributes_init()           */
+#include <xpc/pthreader.h>             /* pthreader_create(), etc.            */
+#include <xpc/queues.h>                /* xpc_spsc_queue_t, xpc_mpmc_queue_t  */
+
+#if XPC_HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+/******************************************************************************
+ * Queue test constants
+ *------------------------------------------------------------------------*//**
+ *
+ *    QUEUE_SMALL is the capacity of the queues in the group 1 tests; it is
+ *    not a power of 2, to check the rounding.  The threaded tests pass the
+ *    integers 1 to QUEUE_ITEMS, so that the sums can be checked, and the
+ *    throughput tests use QUEUE_BENCH_ITEMS items and a batch size of
+ *    QUEUE_BATCH.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define QUEUE_SMALL                 5
+#define QUEUE_ROUNDED               8
+#define QUEUE_ITEMS                 20000
+#define QUEUE_BENCH_ITEMS           1000000
+#define QUEUE_BENCH_CAPACITY        1024
+#define QUEUE_BATCH                 32
+#define QUEUE_THREADS               2
+
+/******************************************************************************
+ * queue_job_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    The parameters and results of one producer or consumer thread.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   void * queue;                 /**< An xpc_spsc_queue_t or xpc_mpmc_queue_t.*/
+   intptr_t first;               /**< The first item a producer pushes.       */
+   intptr_t count;               /**< The number of items to push.            */
+   int batch;                    /**< The batch size; 1 for single items.     */
+   intptr_t sum;                 /**< The sum of the items a consumer popped. */
+   intptr_t popped;              /**< The number of items a consumer popped.  */
+
+} queue_job_t;
+
+/******************************************************************************
+ * spsc_producer() and spsc_consumer()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Push the job's items into an SPSC queue, or pop them until the queue
+ *    is closed, singly with the blocking functions, or in batches with
+ *    the non-blocking ones.
+ *
+ * \return
+ *    Return the job pointer, as the non-null result pthreader_join() wants.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+spsc_producer (void * data)
+{
+   queue_job_t * job = (queue_job_t *) data;
+   xpc_spsc_queue_t * q = (xpc_spsc_queue_t *) job->queue;
+   intptr_t item = job->first;
+   intptr_t last = job->first + job->count;
+   if (job->batch > 1)
+   {
+      void * items[QUEUE_BATCH];
+      while (item < last)
+      {
+         size_t n = 0;
+         size_t pushed = 0;
+         while (n < (size_t) job->batch && item + (intptr_t) n < last)
+         {
+            items[n] = (void *) (item + (intptr_t) n);
+            ++n;
+         }
+         while (pushed < n)
+         {
+            size_t k = xpc_spsc_queue_push_batch(q, &items[pushed], n - pushed);
+            if (k == 0)
+               pthreader_yield();
+
+            pushed += k;
+         }
+         item += (intptr_t) n;
+      }
+   }
+   else
+   {
+      for ( ; item < last; ++item)
+         (void) xpc_spsc_queue_push_wait(q, (void *) item);
+   }
+   return job;
+}
+
+static void *
+spsc_consumer (void * data)
+{
+   queue_job_t * job = (queue_job_t *) data;
+   xpc_spsc_queue_t * q = (xpc_spsc_queue_t *) job->queue;
+   if (job->batch > 1)
+   {
+      void * items[QUEUE_BATCH];
+      for (;;)
+      {
+         size_t n = xpc_spsc_queue_pop_batch(q, items, (size_t) job->batch);
+         if (n > 0)
+         {
+            size_t i;
+            for (i = 0; i < n; ++i)
+               job->sum += (intptr_t) items[i];
+
+            job->popped += (intptr_t) n;
+         }
+         else if (job->popped == job->count)
+            break;
+         else
+            pthreader_yield();
+      }
+   }
+   else
+   {
+      void * item;
+      while (xpc_spsc_queue_pop_wait(q, &item))
+      {
+         job->sum += (intptr_t) item;
+         ++job->popped;
+      }
+   }
+   return job;
+}
+
+/******************************************************************************
+ * mpmc_producer() and mpmc_consumer()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Push the job's items into an MPMC queue, or pop items until the queue
+ *    is closed and empty, using the blocking functions.
+ *
+ * \return
+ *    Return the job pointer, as the non-null result pthreader_join() wants.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+mpmc_producer (void * data)
+{
+   queue_job_t * job = (queue_job_t *) data;
+   xpc_mpmc_queue_t * q = (xpc_mpmc_queue_t *) job->queue;
+   intptr_t item;
+   for (item = job->first; item < job->first + job->count; ++item)
+      (void) xpc_mpmc_queue_push_wait(q, (void *) item);
+
+   return job;
+}
+
+static void *
+mpmc_consumer (void * data)
+{
+   queue_job_t * job = (queue_job_t *) data;
+   xpc_mpmc_queue_t * q = (xpc_mpmc_queue_t *) job->queue;
+   void * item;
+   while (xpc_mpmc_queue_pop_wait(q, &item))
+   {
+      job->sum += (intptr_t) item;
+      ++job->popped;
+   }
+   return job;
+}
+
+/******************************************************************************
+ * mpmc_blocked_pusher()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Pushes one item into a full MPMC queue, so that it blocks until the
+ *    queue is closed.
+ *
+ * \return
+ *    Returns the queue if the push failed, as it should, and a null
+ *    pointer if it succeeded.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+mpmc_blocked_pusher (void * data)
+{
+   xpc_mpmc_queue_t * q = (xpc_mpmc_queue_t *) data;
+   return xpc_mpmc_queue_push_wait(q, (void *) 99) ? nullptr : data ;
+}
+
+/******************************************************************************
+ * queue_run_threads()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Starts the producer and consumer threads, joins the producers, closes
+ *    the queue, and joins the consumers.
+ *
+ * \return
+ *    Returns the elapsed time in seconds, or a negative value if a thread
+ *    could not be run.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static double
+queue_run_threads
+(
+   queue_job_t * producers,      /**< The producer jobs.                      */
+   int producer_count,           /**< The number of producer jobs.            */
+   pthreader_func_t producer,    /**< The producer thread function.           */
+   queue_job_t * consumers,      /**< The consumer jobs.                      */
+   int consumer_count,           /**< The number of consumer jobs.            */
+   pthreader_func_t consumer,    /**< The consumer thread function.           */
+   void (* closer) (void *)      /**< Closes the queue.                       */
+)
+{
+   double result = -1.0;
+   pthread_attr_t x_attributes;
+   pthread_t threads[2 * QUEUE_THREADS];
+   cbool_t ok = pthread_attributes_init(&x_attributes);
+   int t;
+   xpc_stopwatch_start();
+   for (t = 0; t < consumer_count; ++t)
+      threads[t] = pthreader_create(&x_attributes, consumer, &consumers[t]);
+
+   for (t = 0; t < producer_count; ++t)
+   {
+      threads[consumer_count + t] = pthreader_create
+      (
+         &x_attributes, producer, &producers[t]
+      );
+   }
+   for (t = 0; t < producer_count; ++t)
+   {
+      if (is_NULL(pthreader_join(threads[consumer_count + t])))
+         ok = false;
+   }
+   closer(consumers[0].queue);
+   for (t = 0; t < consumer_count; ++t)
+   {
+      if (is_NULL(pthreader_join(threads[t])))
+         ok = false;
+   }
+   if (ok)
+      result = xpc_stopwatch_duration();
+
+   return result;
+}
+
+/******************************************************************************
+ * spsc_closer() and mpmc_closer()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adapt the close functions to queue_run_threads().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+spsc_closer (void * q)
+{
+   xpc_spsc_queue_close((xpc_spsc_queue_t *) q);
+}
+
+static void
+mpmc_closer (void * q)
+{
+   xpc_mpmc_queue_close((xpc_mpmc_queue_t *) q);
+}
+
+/******************************************************************************
+ * queue_expected_sum()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the sum of the integers 1 to n.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static intptr_t
+queue_expected_sum (intptr_t n)
+{
+   return n * (n + 1) / 2;
+}
+
+/******************************************************************************
+ * queues_test_01_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the non-blocking functions of the SPSC queue, from one thread.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_spsc_queue_create()
+ *    -  xpc_spsc_queue_push()
+ *    -  xpc_spsc_queue_pop()
+ *    -  xpc_spsc_queue_push_batch()
+ *    -  xpc_spsc_queue_pop_batch()
+ *    -  xpc_spsc_queue_count()
+ *    -  xpc_spsc_queue_destroy()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+queues_test_01_01 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 1, 1, _("xpc_spsc_queue"), _("SPSC Queue")
+   );
+   if (ok)
+   {
+      xpc_spsc_queue_t q;
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "Create"))
+      {
+         ok = xpc_spsc_queue_create(&q, QUEUE_SMALL);
+         if (ok)
+            ok = q.m_Mask + 1 == QUEUE_ROUNDED && xpc_spsc_queue_count(&q) == 0;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "Push until full"))
+      {
+         if (ok)
+         {
+            intptr_t i;
+            for (i = 1; ok && i <= QUEUE_ROUNDED; ++i)
+               ok = xpc_spsc_queue_push(&q, (void *) i);
+
+            if (ok)
+               ok = ! xpc_spsc_queue_push(&q, (void *) i);
+
+            if (ok)
+               ok = xpc_spsc_queue_count(&q) == QUEUE_ROUNDED;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "Pop in order"))
+      {
+         if (ok)
+         {
+            intptr_t i;
+            void * item;
+            for (i = 1; ok && i <= QUEUE_ROUNDED; ++i)
+               ok = xpc_spsc_queue_pop(&q, &item) && (intptr_t) item == i;
+
+            if (ok)
+               ok = ! xpc_spsc_queue_pop(&q, &item);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "Batches"))
+      {
+         if (ok)
+         {
+            void * items[2 * QUEUE_ROUNDED];
+            void * out[2 * QUEUE_ROUNDED];
+            intptr_t i;
+            for (i = 0; i < 2 * QUEUE_ROUNDED; ++i)
+               items[i] = (void *) (i + 100);
+
+            ok = xpc_spsc_queue_push_batch(&q, items, 3) == 3;
+            if (ok)                       /* only 5 more fit, wrapping around */
+            {
+               ok = xpc_spsc_queue_push_batch
+               (
+                  &q, &items[3], 2 * QUEUE_ROUNDED - 3
+               ) == QUEUE_ROUNDED - 3;
+            }
+            if (ok)
+            {
+               ok = xpc_spsc_queue_pop_batch(&q, out, 2 * QUEUE_ROUNDED) ==
+                  QUEUE_ROUNDED;
+            }
+            for (i = 0; ok && i < QUEUE_ROUNDED; ++i)
+               ok = out[i] == items[i];
+
+            if (ok)
+               ok = xpc_spsc_queue_pop_batch(&q, out, 1) == 0;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  5 */
+
+      if (unit_test_status_next_subtest(&status, "Destroy"))
+      {
+         if (ok)
+            ok = xpc_spsc_queue_destroy(&q) && ! xpc_spsc_queue_destroy(&q);
+
+         unit_test_status_pass(&status, ok);
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * queues_test_01_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the non-blocking functions of the MPMC queue, from one thread.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_mpmc_queue_create()
+ *    -  xpc_mpmc_queue_push()
+ *    -  xpc_mpmc_queue_pop()
+ *    -  xpc_mpmc_queue_push_batch()
+ *    -  xpc_mpmc_queue_pop_batch()
+ *    -  xpc_mpmc_queue_count()
+ *    -  xpc_mpmc_queue_destroy()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+queues_test_01_02 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 1, 2, _("xpc_mpmc_queue"), _("MPMC Queue")
+   );
+   if (ok)
+   {
+      xpc_mpmc_queue_t q;
+
+      /*  1 */
+
+      if (unit_test_status_next_subtest(&status, "Create"))
+      {
+         ok = xpc_mpmc_queue_create(&q, QUEUE_SMALL);
+         if (ok)
+            ok = q.m_Mask + 1 == QUEUE_ROUNDED && xpc_mpmc_queue_count(&q) == 0;
+
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  2 */
+
+      if (unit_test_status_next_subtest(&status, "Push until full"))
+      {
+         if (ok)
+         {
+            intptr_t i;
+            for (i = 1; ok && i <= QUEUE_ROUNDED; ++i)
+               ok = xpc_mpmc_queue_push(&q, (void *) i);
+
+            if (ok)
+               ok = ! xpc_mpmc_queue_push(&q, (void *) i);
+
+            if (ok)
+               ok = xpc_mpmc_queue_count(&q) == QUEUE_ROUNDED;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  3 */
+
+      if (unit_test_status_next_subtest(&status, "Pop in order"))
+      {
+         if (ok)
+         {
+            intptr_t i;
+            void * item;
+            for (i = 1; ok && i <= QUEUE_ROUNDED; ++i)
+               ok = xpc_mpmc_queue_pop(&q, &item) && (intptr_t) item == i;
+
+            if (ok)
+               ok = ! xpc_mpmc_queue_pop(&q, &item);
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  4 */
+
+      if (unit_test_status_next_subtest(&status, "Batches"))
+      {
+         if (ok)
+         {
+            void * items[2 * QUEUE_ROUNDED];
+            void * out[2 * QUEUE_ROUNDED];
+            intptr_t i;
+            for (i = 0; i < 2 * QUEUE_ROUNDED; ++i)
+               items[i] = (void *) (i + 100);
+
+            ok = xpc_mpmc_queue_push_batch(&q, items, 3) == 3;
+            if (ok)
+            {
+               ok = xpc_mpmc_queue_push_batch
+               (
+                  &q, &items[3], 2 * QUEUE_ROUNDED - 3
+               ) == QUEUE_ROUNDED - 3;
+            }
+            if (ok)
+            {
+               ok = xpc_mpmc_queue_pop_batch(&q, out, 2 * QUEUE_ROUNDED) ==
+                  QUEUE_ROUNDED;
+            }
+            for (i = 0; ok && i < QUEUE_ROUNDED; ++i)
+               ok = out[i] == items[i];
+
+            if (ok)
+               ok = xpc_mpmc_queue_pop_batch(&q, out, 1) == 0;
+         }
+         unit_test_status_pass(&status, ok);
+      }
+
+      /*  5 */
+
+      if (unit_test_status_next_subtest(&status, "Destroy"))
+      {
+         if (ok)
+            ok = xpc_mpmc_queue_destroy(&q) && ! xpc_mpmc_queue_destroy(&q);
+
+         unit_test_status_pass(&status, ok);
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * queues_test_01_03()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Tests the blocking functions, passing many items through small
+ *    queues, so that both sides have to wait, and then tests closing.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_eventcount_prepare()
+ *    -  xpc_eventcount_cancel()
+ *    -  xpc_eventcount_wait()
+ *    -  xpc_eventcount_notify()
+ *    -  xpc_spsc_queue_push_wait()
+ *    -  xpc_spsc_queue_pop_wait()
+ *    -  xpc_spsc_queue_close()
+ *    -  xpc_mpmc_queue_push_wait()
+ *    -  xpc_mpmc_queue_pop_wait()
+ *    -  xpc_mpmc_queue_close()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+queues_test_01_03 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 1, 3, _("xpc_eventcount"), _("Blocking Queues")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         /*  1 */
+
+         if (unit_test_status_next_subtest(&status, "Event-count"))
+         {
+            xpc_eventcount_t ec;
+            int key;
+            xpc_eventcount_init(&ec);
+            key = xpc_eventcount_prepare(&ec);
+            xpc_eventcount_notify(&ec);         /* bumps it; wait won't block */
+            xpc_eventcount_wait(&ec, key);
+            ok = ec.m_Sequence == key + 1 && ec.m_Waiters == 0;
+            if (ok)
+            {
+               (void) xpc_eventcount_prepare(&ec);
+               xpc_eventcount_cancel(&ec);
+               xpc_eventcount_notify(&ec);      /* no waiter, so no bump      */
+               ok = ec.m_Sequence == key + 1 && ec.m_Waiters == 0;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  2 */
+
+         if (unit_test_status_next_subtest(&status, "SPSC wait"))
+         {
+            xpc_spsc_queue_t q;
+            ok = xpc_spsc_queue_create(&q, QUEUE_SMALL);
+            if (ok)
+            {
+               queue_job_t producer = { nullptr, 1, QUEUE_ITEMS, 1, 0, 0 };
+               queue_job_t consumer = { nullptr, 0, QUEUE_ITEMS, 1, 0, 0 };
+               producer.queue = consumer.queue = &q;
+               ok = queue_run_threads
+               (
+                  &producer, 1, spsc_producer,
+                  &consumer, 1, spsc_consumer, spsc_closer
+               ) >= 0.0;
+               if (ok)
+               {
+                  ok = consumer.popped == QUEUE_ITEMS &&
+                     consumer.sum == queue_expected_sum(QUEUE_ITEMS);
+               }
+               if (ok)
+                  ok = ! xpc_spsc_queue_push_wait(&q, (void *) 1);
+
+               (void) xpc_spsc_queue_destroy(&q);
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  3 */
+
+         if (unit_test_status_next_subtest(&status, "MPMC wait"))
+         {
+            xpc_mpmc_queue_t q;
+            ok = xpc_mpmc_queue_create(&q, QUEUE_SMALL);
+            if (ok)
+            {
+               queue_job_t producers[QUEUE_THREADS];
+               queue_job_t consumers[QUEUE_THREADS];
+               intptr_t share = QUEUE_ITEMS / QUEUE_THREADS;
+               intptr_t sum = 0;
+               intptr_t popped = 0;
+               int t;
+               for (t = 0; t < QUEUE_THREADS; ++t)
+               {
+                  queue_job_t job = { nullptr, 0, 0, 1, 0, 0 };
+                  job.queue = &q;
+                  consumers[t] = job;
+                  job.first = 1 + t * share;
+                  job.count = share;
+                  producers[t] = job;
+               }
+               ok = queue_run_threads
+               (
+                  producers, QUEUE_THREADS, mpmc_producer,
+                  consumers, QUEUE_THREADS, mpmc_consumer, mpmc_closer
+               ) >= 0.0;
+               for (t = 0; t < QUEUE_THREADS; ++t)
+               {
+                  sum += consumers[t].sum;
+                  popped += consumers[t].popped;
+               }
+               if (ok)
+               {
+                  ok = popped == QUEUE_THREADS * share &&
+                     sum == queue_expected_sum(QUEUE_THREADS * share);
+               }
+               if (ok)
+                  ok = ! xpc_mpmc_queue_push_wait(&q, (void *) 1);
+
+               (void) xpc_mpmc_queue_destroy(&q);
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  4 */
+
+         if (unit_test_status_next_subtest(&status, "Drain after close"))
+         {
+            xpc_mpmc_queue_t q;
+            ok = xpc_mpmc_queue_create(&q, QUEUE_SMALL);
+            if (ok)
+            {
+               void * item = nullptr;
+               ok = xpc_mpmc_queue_push(&q, (void *) 7);
+               xpc_mpmc_queue_close(&q);
+               if (ok)
+                  ok = xpc_mpmc_queue_pop_wait(&q, &item) && item == (void *) 7;
+
+               if (ok)
+                  ok = ! xpc_mpmc_queue_pop_wait(&q, &item);
+
+               (void) xpc_mpmc_queue_destroy(&q);
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  5 */
+
+         if (unit_test_status_next_subtest(&status, "Blocked push and close"))
+         {
+            xpc_mpmc_queue_t q;
+            ok = xpc_mpmc_queue_create(&q, QUEUE_SMALL);
+            if (ok)
+            {
+               pthread_attr_t x_attributes;
+               pthread_t pusher;
+               intptr_t i;
+               void * item;
+               for (i = 1; ok && i <= QUEUE_ROUNDED; ++i)
+                  ok = xpc_mpmc_queue_push(&q, (void *) i);
+
+               if (ok)
+                  ok = pthread_attributes_init(&x_attributes);
+
+               if (ok)
+               {
+                  pusher = pthreader_create
+                  (
+                     &x_attributes, mpmc_blocked_pusher, &q
+                  );
+                  xpc_ms_sleep(50);             /* let the push block      */
+                  xpc_mpmc_queue_close(&q);
+                  ok = xpc_mpmc_queue_pop(&q, &item);    /* make room      */
+                  if (ok)
+                     ok = pthreader_join(pusher) == &q;
+
+                  if (ok)
+                     ok = xpc_mpmc_queue_count(&q) == QUEUE_ROUNDED - 1;
+               }
+               (void) xpc_mpmc_queue_destroy(&q);
+            }
+            unit_test_status_pass(&status, ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * queue_show_rate()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Shows the throughput of a benchmark run, if --show-values was given.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+queue_show_rate
+(
+   const unit_test_options_t * options,
+   const char * name,
+   double seconds
+)
+{
+   if (unit_test_options_show_values(options) && seconds > 0.0)
+   {
+      fprintf
+      (
+         stdout, "  %-24s %10.0f items/s, %6.1f ns/item\n", name,
+         QUEUE_BENCH_ITEMS / seconds, seconds * 1.0e9 / QUEUE_BENCH_ITEMS
+      );
+   }
+}
+
+/******************************************************************************
+ * queues_test_02_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Measures the throughput of the queues:  SPSC with single items and
+ *    with batches, and MPMC with several producers and consumers.  The
+ *    test fails only if items are lost; run it with --show-values to see
+ *    the rates.  With only one CPU, the numbers mostly measure the
+ *    scheduler.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \test
+ *    -  xpc_spsc_queue_push_wait()
+ *    -  xpc_spsc_queue_pop_wait()
+ *    -  xpc_spsc_queue_push_batch()
+ *    -  xpc_spsc_queue_pop_batch()
+ *    -  xpc_mpmc_queue_push_wait()
+ *    -  xpc_mpmc_queue_pop_wait()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+queues_test_02_01 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 1, _("queues"), _("Queue Throughput")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         static const int batches[2] = { 1, QUEUE_BATCH };
+         int b;
+
+         /*  1, 2 */
+
+         for (b = 0; b < 2; ++b)
+         {
+            int batch = batches[b];
+            const char * name = batch == 1 ? "SPSC single" : "SPSC batch" ;
+            if (unit_test_status_next_subtest(&status, name))
+            {
+               xpc_spsc_queue_t q;
+               ok = xpc_spsc_queue_create(&q, QUEUE_BENCH_CAPACITY);
+               if (ok)
+               {
+                  double seconds;
+                  queue_job_t producer = { nullptr, 1, 0, 0, 0, 0 };
+                  queue_job_t consumer = { nullptr, 0, 0, 0, 0, 0 };
+                  producer.queue = consumer.queue = &q;
+                  producer.count = consumer.count = QUEUE_BENCH_ITEMS;
+                  producer.batch = consumer.batch = batch;
+                  seconds = queue_run_threads
+                  (
+                     &producer, 1, spsc_producer,
+                     &consumer, 1, spsc_consumer, spsc_closer
+                  );
+                  ok = seconds >= 0.0 &&
+                     consumer.sum == queue_expected_sum(QUEUE_BENCH_ITEMS);
+
+                  queue_show_rate(options, name, seconds);
+                  (void) xpc_spsc_queue_destroy(&q);
+               }
+               unit_test_status_pass(&status, ok);
+            }
+         }
+
+         /*  3 */
+
+         if (unit_test_status_next_subtest(&status, "MPMC"))
+         {
+            xpc_mpmc_queue_t q;
+            ok = xpc_mpmc_queue_create(&q, QUEUE_BENCH_CAPACITY);
+            if (ok)
+            {
+               queue_job_t producers[QUEUE_THREADS];
+               queue_job_t consumers[QUEUE_THREADS];
+               intptr_t share = QUEUE_BENCH_ITEMS / QUEUE_THREADS;
+               intptr_t sum = 0;
+               double seconds;
+               int t;
+               for (t = 0; t < QUEUE_THREADS; ++t)
+               {
+                  queue_job_t job = { nullptr, 0, 0, 1, 0, 0 };
+                  job.queue = &q;
+                  consumers[t] = job;
+                  job.first = 1 + t * share;
+                  job.count = share;
+                  producers[t] = job;
+               }
+               seconds = queue_run_threads
+               (
+                  producers, QUEUE_THREADS, mpmc_producer,
+                  consumers, QUEUE_THREADS, mpmc_consumer, mpmc_closer
+               );
+               for (t = 0; t < QUEUE_THREADS; ++t)
+                  sum += consumers[t].sum;
+
+               ok = seconds >= 0.0 &&
+                  sum == queue_expected_sum(QUEUE_THREADS * share);
+
+               queue_show_rate(options, "MPMC 2 x 2", seconds);
+               (void) xpc_mpmc_queue_destroy(&q);
+            }
+            unit_test_status_pass(&status, ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * Macro
+ *------------------------------------------------------------------------*//**
+ *
+ *    The executable name of the application.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define XPC_TEST_NAME         "queues_ut"
+
+/******************************************************************************
+ * main()
+ *------------------------------------------------------------------------*//**
+ *
+ *    This is the main routine for the queues_ut application.
+ *
+ * \return
+ *    Returns POSIX_SUCCESS (0) if the function succeeds.  Other values,
+ *    including possible error-codes, are returned otherwise.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+int
+main
+(
+   int argc,               /**< Number of command-line arguments.             */
+   char * argv []          /**< The actual array of command-line arguments.   */
+)
+{
+   unit_test_t testbattery;                           /* uses default values  */
+   cbool_t ok = xpc_parse_errlevel(argc, argv);       /* cool feature         */
+   ok = unit_test_initialize
+   (
+      &testbattery, argc, argv,
+      XPC_TEST_NAME,
+      "Queues Test 0.1",
+      nullptr                                         /* no added help        */
+   );
+   if (ok)                                /* \note fails if --help specified  */
+   {
+      ok = unit_test_load(&testbattery, queues_test_01_01);
+      if (ok)
+      {
+         (void) unit_test_load(&testbattery, queues_test_01_02);
+         (void) unit_test_load(&testbattery, queues_test_01_03);
+         (void) unit_test_load(&testbattery, queues_test_02_01);
+      }
+      if (ok)
+         ok = unit_test_run(&testbattery);
+      else
+         xpccut_errprint(_("test function load failed"));
+   }
+   unit_test_destroy(&testbattery);
+   return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/******************************************************************************
+ * queues_ut.c
+ *-----------------------------------------------------------------------------
+ * Local Variables:
+ * End:
+ *-----------------------------------------------------------------------------
+ * vim: ts=3 sw=3 et ft=c
+ *----------------------------------------------------------------------------*/
@@ -29,12 +29,19 @@
 #include <xpc/unit_test.h>             /* unit_test_t structure               */
 #include <xpc/pthread_attributes.h>    /* pthread attributes functions        */
 #include <xpc/pthreader.h>             /* pthreader functions                 */
+#include <xpc/pthreader_pool.h>        /* pthreader_pool_t functions          */
 #include <xpc/syncher.h>               /* xpc_syncher_t synchronizer          */
+#include <xpc/atomix.h>                /* XPC_CACHE_LINE_SIZE                 */
+#include <xpc/cpu.h>                   /* xpc_cpu_count(), etc.               */
 
 #if XPC_HAVE_STDIO_H
 #include <stdio.h>
 #endif
 
+#if XPC_HAVE_STRING_H
+#include <string.h>                    /* strcmp(), strlen()                  */
+#endif
+
 /******************************************************************************
  * g_do_leak_check
  *------------------------------------------------------------------------*//**
@@ -150,6 +157,283 @@ syncher_thread_test_02_01 (const unit_test_options_t * options)
    return status;
 }
 
+/******************************************************************************
+ * Thread-pool test support
+ *------------------------------------------------------------------------*//**
+ *
+ *    The pool, counters, and task functions used by
+ *    syncher_thread_test_02_02().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define POOL_WORKERS_02_02          4
+#define POOL_TASKS_02_02            1000
+#define POOL_FUTURES_02_02          100
+#define POOL_FIBONACCI_02_02        15
+
+static pthreader_pool_t gs_pool;
+static long gs_pool_counter;
+static long gs_pool_done_count;
+
+/******************************************************************************
+ * pool_count_task()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Bumps the counter it is given.
+ *
+ * \return
+ *    Returns 1, for the completion callback to add up.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+pool_count_task
+(
+   void * counter          /**< The long integer to increment.                */
+)
+{
+   (void) xpc_atomic_add((long *) counter, 1);
+   return (void *) (intptr_t) 1;
+}
+
+/******************************************************************************
+ * pool_done_callback()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Adds the result of pool_count_task() to gs_pool_done_count.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void
+pool_done_callback
+(
+   void * result,          /**< The value returned by the task.               */
+   void * data             /**< The parameter of the task (unused).           */
+)
+{
+   (void) xpc_atomic_add(&gs_pool_done_count, (long) (intptr_t) result);
+}
+
+/******************************************************************************
+ * pool_square_task()
+ *------------------------------------------------------------------------*//**
+ *
+ * \return
+ *    Returns the square of the integer parameter.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+pool_square_task
+(
+   void * n                /**< An integer value.                             */
+)
+{
+   intptr_t value = (intptr_t) n;
+   return (void *) (value * value);
+}
+
+/******************************************************************************
+ * pool_fibonacci_task()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Calculates a Fibonacci number the slow way, handing one half of each
+ *    step to the pool and waiting on it.  This exercises submission from
+ *    the workers, stealing, and waiting on a future inside a task.
+ *
+ * \return
+ *    Returns the Fibonacci number of the integer parameter.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+pool_fibonacci_task
+(
+   void * n                /**< An integer value.                             */
+)
+{
+   intptr_t value = (intptr_t) n;
+   intptr_t result = value;
+   if (value >= 2)
+   {
+      pthreader_future_t * f = pthreader_pool_async
+      (
+         &gs_pool, pool_fibonacci_task, (void *) (value - 1)
+      );
+      result = (intptr_t) pool_fibonacci_task((void *) (value - 2));
+      if (not_NULL(f))
+         result += (intptr_t) pthreader_future_wait(&gs_pool, f);
+      else
+         result = -1;
+   }
+   return (void *) result;
+}
+
+/******************************************************************************
+ * syncher_thread_test_02_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides unit-tests of the work-stealing thread pool.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \tests
+ *    -  pthreader_pool_create()
+ *    -  pthreader_pool_size()
+ *    -  pthreader_pool_submit()
+ *    -  pthreader_pool_async()
+ *    -  pthreader_future_ready()
+ *    -  pthreader_future_wait()
+ *    -  pthreader_pool_wait()
+ *    -  pthreader_pool_destroy()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+syncher_thread_test_02_02 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 2, 2, _("pthreader_pool"), _("Thread Pool")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         /*  1 */
+
+         if (unit_test_status_next_subtest(&status, "Create"))
+         {
+            ok = pthreader_pool_create(&gs_pool, POOL_WORKERS_02_02);
+            if (ok)
+               ok = pthreader_pool_size(&gs_pool) == POOL_WORKERS_02_02;
+
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  2 */
+
+         if (unit_test_status_next_subtest(&status, "Submit with callback"))
+         {
+            if (ok)
+            {
+               int t;
+               for (t = 0; ok && t < POOL_TASKS_02_02; ++t)
+               {
+                  ok = pthreader_pool_submit
+                  (
+                     &gs_pool, pool_count_task, &gs_pool_counter,
+                     pool_done_callback
+                  );
+               }
+               pthreader_pool_wait(&gs_pool);
+               if (ok)
+               {
+                  ok = gs_pool_counter == POOL_TASKS_02_02 &&
+                     gs_pool_done_count == POOL_TASKS_02_02;
+               }
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  3 */
+
+         if (unit_test_status_next_subtest(&status, "Futures"))
+         {
+            if (ok)
+            {
+               pthreader_future_t * futures[POOL_FUTURES_02_02];
+               intptr_t sum = 0;
+               intptr_t expected = 0;
+               int f;
+               for (f = 0; ok && f < POOL_FUTURES_02_02; ++f)
+               {
+                  futures[f] = pthreader_pool_async
+                  (
+                     &gs_pool, pool_square_task, (void *) (intptr_t) f
+                  );
+                  ok = not_NULL(futures[f]);
+                  expected += (intptr_t) f * f;
+               }
+               for (f = 0; ok && f < POOL_FUTURES_02_02; ++f)
+                  sum += (intptr_t) pthreader_future_wait(&gs_pool, futures[f]);
+
+               if (ok)
+                  ok = sum == expected;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  4 */
+
+         if (unit_test_status_next_subtest(&status, "Nested tasks"))
+         {
+            if (ok)
+            {
+               pthreader_future_t * f = pthreader_pool_async
+               (
+                  &gs_pool, pool_fibonacci_task,
+                  (void *) (intptr_t) POOL_FIBONACCI_02_02
+               );
+               ok = not_NULL(f);
+               if (ok)
+               {
+                  ok = (intptr_t) pthreader_future_wait(&gs_pool, f) == 610;
+                  ok = ok && pthreader_future_ready(nullptr) == false;
+               }
+               if (unit_test_options_show_values(options))
+               {
+                  int w;
+                  for (w = 0; w < POOL_WORKERS_02_02; ++w)
+                  {
+                     fprintf
+                     (
+                        stdout, "  worker %d: %lu tasks, %lu stolen\n", w,
+                        (unsigned long) gs_pool.m_Workers[w].m_Executed,
+                        (unsigned long) gs_pool.m_Workers[w].m_Stolen
+                     );
+                  }
+               }
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  5 */
+
+         if (unit_test_status_next_subtest(&status, "Graceful shutdown"))
+         {
+            if (ok)
+            {
+               int t;
+               for (t = 0; ok && t < POOL_TASKS_02_02; ++t)
+               {
+                  ok = pthreader_pool_submit
+                  (
+                     &gs_pool, pool_count_task, &gs_pool_counter, nullptr
+                  );
+               }
+               if (ok)
+                  ok = pthreader_pool_destroy(&gs_pool);
+
+               if (ok)
+                  ok = gs_pool_counter == 2 * POOL_TASKS_02_02;
+
+               if (ok)
+                  ok = pthreader_pool_size(&gs_pool) == 0;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+      }
+   }
+   return status;
+}
+
 /******************************************************************************
  * simple_thread_function()
  *------------------------------------------------------------------------*//**
@@ -570,165 +854,838 @@ syncher_thread_test_03_01 (const unit_test_options_t * options)
 }
 
 /******************************************************************************
- * simple_syncher_t
+ * placed_thread_t
  *------------------------------------------------------------------------*//**
  *
- *    Provides some parameters to control the simple_syncher_thread_function().
+ *    Receives what a thread created with extended attributes finds out
+ *    about itself.
  *
  *//*-------------------------------------------------------------------------*/
 
 typedef struct
 {
-   int thread_identifier;     /**< An ordinal number to identify the thread.  */
-   int loop_count;            /**< Number of times the main loop runs.        */
-   int loop_sleep;            /**< Time the thread is suspended each pass.    */
-   char emitted_character;    /**< The character to emit as thread runs.      */
-   xpc_syncher_t * critex;    /**< To synchronize output with other thread.   */
+   int cpu_count;                      /**< CPUs in the thread's affinity.    */
+   int first_cpu;                      /**< The lowest CPU in the affinity.   */
+   char name[XPC_THREAD_NAME_MAX];     /**< The thread's name.                */
 
-} simple_syncher_t;
+} placed_thread_t;
 
 /******************************************************************************
- * simple_syncher_thread_function()
+ * placed_thread_function()
  *------------------------------------------------------------------------*//**
  *
- *    Provides a thread function to test the functionality of the
- *    xpc_syncher_t object.
- *
- * \note
- *    -  The xpc_ms_sleep() function does not sleep if 0 is passed as a
- *       parameter.
- *    -  The critex pointer is not checked, to save time.
+ *    Reads the affinity and name of the calling thread.
  *
  * \return
- *    Returns ...
+ *    Returns the parameter.
  *
  *//*-------------------------------------------------------------------------*/
 
-void *
-simple_syncher_thread_function
+static void *
+placed_thread_function
 (
-   void * thread_syncher   /**< Structure controlling action of the thread.   */
+   void * placed           /**< The placed_thread_t to fill in.               */
 )
 {
-   void * result = nullptr;
-   if (not_nullptr(thread_syncher))
+   placed_thread_t * p = (placed_thread_t *) placed;
+   p->cpu_count = -1;
+   p->first_cpu = -1;
+   p->name[0] = 0;
+#if defined __GLIBC__
    {
-      int tid;
-      int index;
-      simple_syncher_t * stp = (simple_syncher_t *) thread_syncher;
-      simple_syncher_t ctrller = *stp;
-      tid = ctrller.thread_identifier;
-      xpc_infoprintf("Syncher thread #%d.\n", tid);
-
-      for (index = 0; index < ctrller.loop_count; index++)
+      cpu_set_t cpuset;
+      if (pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0)
       {
-         cbool_t ok = xpc_syncher_enter(ctrller.critex);
-         if (ok)
+         int c;
+         p->cpu_count = CPU_COUNT(&cpuset);
+         for (c = 0; c < CPU_SETSIZE && p->first_cpu < 0; ++c)
          {
-            if (! xpccut_is_silent())
-               putc(ctrller.emitted_character, stdout);
-
-            (void) xpc_syncher_leave(ctrller.critex);
+            if (CPU_ISSET(c, &cpuset))
+               p->first_cpu = c;
          }
-         xpc_ms_sleep(ctrller.loop_sleep);
       }
-      result = thread_syncher;
-   }
-   else
-   {
-      if (! xpccut_is_silent())
-         xpc_errprint_func(_("null pointer"));
+      (void) pthread_getname_np(pthread_self(), p->name, sizeof(p->name));
    }
-   return result;                   /* alternative:  pthread_exit(result);    */
-}
-
-/******************************************************************************
- * LOOP_SLEEP_05_01
- *------------------------------------------------------------------------*//**
- *
- *    LOOP_SLEEP_05_01 provides a way to probe the effects of delays in the
- *    thread processing.
- *
- * \posix
- *    On our dual-core x86 laptop, running Linux, setting this loop-sleep
- *    define to anything greater than 0 causes the expected output:
- *
- *       12121212121212121212
- *
- *    However, setting it to 0 yields:
- *
- *       11111111112222222222
- *
- *    It looks like the first thread finishes before the second one gets to
- *    start.
- *
- *//*-------------------------------------------------------------------------*/
-
-#ifdef POSIX
-#define LOOP_SLEEP_05_01      1
-#else
-#define LOOP_SLEEP_05_01      1
-#endif
-
-/******************************************************************************
- * POST_SLEEP_05_01
- *------------------------------------------------------------------------*//**
- *
- *    POST_SLEEP_05_01 provides another way to probe the effects of delays
- *    in the thread processing.
- *
- *    Instead of coming inside the thread-function's loop, this delay occurs
- *    after the creation of the first thread.
- *
- *    If LOOP_SLEEP_05_01 is 1, and POST_SLEEP_05_01 > 0, then the output
- *    has extra 1's at the beginning.
- *
- *//*-------------------------------------------------------------------------*/
-
-#ifdef POSIX
-#define POST_SLEEP_05_01      0  /* or 1 or 5 */
-#else
-#define POST_SLEEP_05_01      0
 #endif
+   return placed;
+}
 
 /******************************************************************************
- * syncher_thread_test_05_01()
+ * syncher_thread_test_03_02()
  *------------------------------------------------------------------------*//**
  *
- *    This test group provides threaded smoke-test unit-tests of the
- *    pthreader.c module.
+ *    Tests the extended thread attributes:  CPU and node affinity,
+ *    real-time priority, and naming.
  *
  * \param options
  *    Provides the options given to the application on the command-line.
  *
  * \tests
- *    This unit-test function perforce tests more than one unit from the
- *    unit-test library (libxpccut):
- *
- *    -  pthreader_xxx()
- *    -  pthread_attributes_xxx()
+ *    -  pthread_attributes_ex_init()
+ *    -  pthread_attributes_set_cpu()
+ *    -  pthread_attributes_set_node()
+ *    -  pthread_attributes_set_realtime()
+ *    -  pthread_attributes_set_name()
+ *    -  pthread_attributes_apply()
+ *    -  pthread_attributes_ex_destroy()
+ *    -  pthreader_create_ex()
  *
  *//*-------------------------------------------------------------------------*/
 
 static unit_test_status_t
-syncher_thread_test_05_01 (const unit_test_options_t * options)
+syncher_thread_test_03_02 (const unit_test_options_t * options)
 {
    unit_test_status_t status;
    cbool_t ok = unit_test_status_initialize
    (
-      &status, options, 5, 1, _("syncher"), _("Smoke Test")
+      &status, options, 3, 2, _("pthread_attributes_ex"),
+      _("Extended Attributes")
    );
    if (ok)
    {
-      /*
-       * \steps
-       *    -# Provide the "XPC default" thread attributes.
-       *    -# Create a non-recursive (in POSIX, anyway) syncher object,
-       *       called a "critex" (our own term for it).
-       *    -# Create two data structures that share the same "critex".
-       *    -# Wire the critex into the data structure for the first thread.
-       *    -# Wire the critex into the data structure for the second thread.
-       */
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         pthread_attributes_ex_t ax;
+         placed_thread_t placed;
+         int online[XPC_CPU_MAX];
+         int count = xpc_cpu_online_cpus(online, XPC_CPU_MAX);
+         int lastcpu = online[(count < XPC_CPU_MAX ? count : XPC_CPU_MAX) - 1];
+
+         /*  1 */
+
+         if (unit_test_status_next_subtest(&status, "Initialize"))
+         {
+            ok = pthread_attributes_ex_init(&ax);
+            if (ok)
+               ok = ax.m_Cpu == -1 && ax.m_Node == -1 && ax.m_Policy == -1;
+
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  2 */
+
+         if (unit_test_status_next_subtest(&status, "Pinned and named"))
+         {
+            if (ok)
+               ok = pthread_attributes_set_cpu(&ax, lastcpu);
+
+            if (ok)
+               ok = pthread_attributes_set_name(&ax, "xpc-placed");
+
+            if (ok)
+            {
+               pthread_t th = pthreader_create_ex
+               (
+                  &ax, placed_thread_function, &placed
+               );
+               ok = pthreader_join(th) == &placed;
+            }
+#if defined __GLIBC__
+            if (ok)
+            {
+               ok = placed.cpu_count == 1 && placed.first_cpu == lastcpu &&
+                  strcmp(placed.name, "xpc-placed") == 0;
+            }
+#endif
+            if (unit_test_options_show_values(options))
+            {
+               fprintf
+               (
+                  stdout, "  %d CPU(s) from %d, name '%s'\n",
+                  placed.cpu_count, placed.first_cpu, placed.name
+               );
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  3 */
+
+         if (unit_test_status_next_subtest(&status, "Node binding"))
+         {
+            if (ok)
+               ok = pthread_attributes_set_node(&ax, 0);
+
+            if (ok)
+               ok = ax.m_Node == 0 && ax.m_Cpu == -1;
+
+            if (ok)
+            {
+               pthread_t th = pthreader_create_ex
+               (
+                  &ax, placed_thread_function, &placed
+               );
+               ok = pthreader_join(th) == &placed;
+            }
+#if defined __GLIBC__
+            if (ok)
+               ok = placed.cpu_count == xpc_cpu_node_cpus(0, nullptr, 0);
+#endif
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  4 */
+
+         if (unit_test_status_next_subtest(&status, "Bad settings refused"))
+         {
+            if (ok)
+               ok = ! pthread_attributes_set_cpu(&ax, lastcpu + 1);
+
+            if (ok)
+               ok = ! pthread_attributes_set_node(&ax, xpc_cpu_node_count());
+
+            if (ok)
+               ok = ! pthread_attributes_set_realtime(&ax, SCHED_OTHER, 1);
+
+            if (ok)
+               ok = ! pthread_attributes_set_realtime(&ax, SCHED_FIFO, 1000);
+
+            if (ok)
+            {
+               ok = pthread_attributes_set_name
+               (
+                  &ax, "a-name-too-long-for-linux"
+               );
+               ok = ok && strlen(ax.m_Name) == XPC_THREAD_NAME_MAX - 1;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  5 */
+
+         if (unit_test_status_next_subtest(&status, "Real-time settings"))
+         {
+            if (ok)
+               ok = pthread_attributes_set_realtime(&ax, SCHED_FIFO, 10);
+
+            if (ok)
+            {
+               int policy = -1;
+               int priority = -1;
+               ok = pthread_attributes_get
+               (
+                  &ax.m_Attributes, nullptr, &policy, &priority,
+                  nullptr, nullptr, nullptr, nullptr
+               );
+               ok = ok && policy == SCHED_FIFO && priority == 10;
+            }
+
+            /*
+             * Whether the thread can really be created depends on the
+             * privileges of the test, so it is not attempted here.
+             */
+
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  6 */
+
+         if (unit_test_status_next_subtest(&status, "Apply and destroy"))
+         {
+            pthread_attributes_ex_t self;
+            if (ok)
+               ok = pthread_attributes_ex_init(&self);
+
+            if (ok)
+               ok = pthread_attributes_apply(pthread_self(), &self);
+
+            if (ok)
+               ok = pthread_attributes_ex_destroy(&self);
+
+            if (ok)
+               ok = pthread_attributes_ex_destroy(&ax);
+
+            if (ok)
+               ok = ! pthread_attributes_ex_destroy(&ax);
+
+            unit_test_status_pass(&status, ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * syncher_thread_test_04_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides basic unit-tests of the reader-writer syncher-object.
+ *
+ *    The try-enter functions are used, so that a wrong answer shows up as
+ *    a failure instead of a hang.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \tests
+ *    -  xpc_rwsyncher_create()
+ *    -  xpc_rwsyncher_enter_read()
+ *    -  xpc_rwsyncher_enter_write()
+ *    -  xpc_rwsyncher_tryenter_read()
+ *    -  xpc_rwsyncher_tryenter_write()
+ *    -  xpc_rwsyncher_leave()
+ *    -  xpc_rwsyncher_destroy()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+syncher_thread_test_04_01 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 4, 1, _("rwsyncher"), _("Reader-Writer Syncher")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         xpc_rwsyncher_t rwcritex;
+         int pass;
+         if (unit_test_options_show_values(options))
+            fprintf(stdout, "  %s\n", _("No values to show in this test"));
+
+         for (pass = 0; pass < 2; pass++)
+         {
+            cbool_t prefer_writers = pass == 1;
+
+            /*  1 and 4 */
+
+            if (unit_test_status_next_subtest(&status, "Two readers"))
+            {
+               ok = xpc_rwsyncher_create(&rwcritex, prefer_writers);
+               if (ok)
+                  ok = rwcritex.m_Prefer_Writers == prefer_writers;
+
+               if (ok)
+                  ok = xpc_rwsyncher_enter_read(&rwcritex);
+
+               if (ok)
+                  ok = xpc_rwsyncher_tryenter_read(&rwcritex);
+
+               if (ok)
+                  ok = ! xpc_rwsyncher_tryenter_write(&rwcritex);
+
+               if (ok)
+                  ok = xpc_rwsyncher_leave(&rwcritex) &&
+                     xpc_rwsyncher_leave(&rwcritex);
+
+               unit_test_status_pass(&status, ok);
+            }
+
+            /*  2 and 5 */
+
+            if (unit_test_status_next_subtest(&status, "One writer"))
+            {
+               if (ok)
+                  ok = xpc_rwsyncher_enter_write(&rwcritex);
+
+               if (ok)
+                  ok = ! xpc_rwsyncher_tryenter_read(&rwcritex);
+
+               if (ok)
+                  ok = ! xpc_rwsyncher_tryenter_write(&rwcritex);
+
+               if (ok)
+                  ok = xpc_rwsyncher_leave(&rwcritex);
+
+               if (ok)
+                  ok = xpc_rwsyncher_tryenter_write(&rwcritex);
+
+               if (ok)
+                  ok = xpc_rwsyncher_leave(&rwcritex);
+
+               unit_test_status_pass(&status, ok);
+            }
+
+            /*  3 and 6 */
+
+            if (unit_test_status_next_subtest(&status, "Destroy"))
+            {
+               if (ok)
+                  ok = xpc_rwsyncher_destroy(&rwcritex);
+
+               if (ok)
+                  ok = ! rwcritex.m_Syncher_Ready;
+
+               unit_test_status_pass(&status, ok);
+            }
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * striped_syncher_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the state shared by the threads of the striped-syncher test.
+ *    Each thread increments every counter, each under the stripe selected
+ *    by the address of the counter.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define STRIPED_COUNTERS_04_02      32
+#define STRIPED_THREADS_04_02       4
+#define STRIPED_LOOPS_04_02         2000
+
+typedef struct
+{
+   xpc_syncher_stripes_t stripes;            /**< The locks being tested.     */
+   long counters[STRIPED_COUNTERS_04_02];    /**< Each guarded by a stripe.   */
+
+} striped_syncher_t;
+
+/******************************************************************************
+ * striped_syncher_thread_function()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Increments each counter of the shared structure STRIPED_LOOPS_04_02
+ *    times, entering the stripe for the counter each time.
+ *
+ * \return
+ *    Returns the parameter if every enter succeeded, and null otherwise.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+striped_syncher_thread_function
+(
+   void * striped_syncher  /**< The shared striped_syncher_t structure.       */
+)
+{
+   void * result = striped_syncher;
+   striped_syncher_t * ssp = (striped_syncher_t *) striped_syncher;
+   int loop;
+   for (loop = 0; loop < STRIPED_LOOPS_04_02; loop++)
+   {
+      int c;
+      for (c = 0; c < STRIPED_COUNTERS_04_02; c++)
+      {
+         size_t key = (size_t) &ssp->counters[c];
+         if (xpc_syncher_stripes_enter(&ssp->stripes, key))
+         {
+            ++ssp->counters[c];
+            (void) xpc_syncher_stripes_leave(&ssp->stripes, key);
+         }
+         else
+            result = nullptr;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * syncher_thread_test_04_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides basic unit-tests of the striped syncher-objects.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \tests
+ *    -  xpc_syncher_stripes_create()
+ *    -  xpc_syncher_stripes_enter()
+ *    -  xpc_syncher_stripes_tryenter()
+ *    -  xpc_syncher_stripes_leave()
+ *    -  xpc_syncher_stripes_destroy()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+syncher_thread_test_04_02 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 4, 2, _("syncher_stripes"), _("Striped Syncher")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         static striped_syncher_t s_striped;
+         xpc_syncher_stripes_t * xs = &s_striped.stripes;
+         if (unit_test_options_show_values(options))
+            fprintf(stdout, "  %s\n", _("No values to show in this test"));
+
+         /*  1 */
+
+         if (unit_test_status_next_subtest(&status, "Create"))
+         {
+            ok = xpc_syncher_stripes_create(xs, 12, true);
+            if (ok)
+            {
+               ok = xs->m_Mask == 15 &&
+                  xs->m_Stride % XPC_CACHE_LINE_SIZE == 0 &&
+                  (uintptr_t) xs->m_Stripes % XPC_CACHE_LINE_SIZE == 0;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  2 */
+
+         if (unit_test_status_next_subtest(&status, "Same key, same stripe"))
+         {
+            if (ok)
+               ok = xpc_syncher_stripes_tryenter(xs, 1234);
+
+            if (ok)
+            {
+               ok = ! xpc_syncher_stripes_tryenter(xs, 1234);
+               (void) xpc_syncher_stripes_leave(xs, 1234);
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  3 */
+
+         if (unit_test_status_next_subtest(&status, "Keys spread"))
+         {
+            if (ok)
+            {
+               int busy = 0;
+               size_t key;
+               ok = xpc_syncher_stripes_enter(xs, 0);
+               for (key = 1; ok && key < 64; ++key)
+               {
+                  if (xpc_syncher_stripes_tryenter(xs, key * 64))
+                     (void) xpc_syncher_stripes_leave(xs, key * 64);
+                  else
+                     ++busy;
+               }
+               (void) xpc_syncher_stripes_leave(xs, 0);
+               ok = busy < 16;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  4 */
+
+         if (unit_test_status_next_subtest(&status, "Threads"))
+         {
+            if (ok)
+            {
+               pthread_attr_t x_attributes;
+               pthread_t threads[STRIPED_THREADS_04_02];
+               int t;
+               ok = pthread_attributes_init(&x_attributes);
+               for (t = 0; ok && t < STRIPED_THREADS_04_02; t++)
+               {
+                  threads[t] = pthreader_create
+                  (
+                     &x_attributes, striped_syncher_thread_function,
+                     (void *) &s_striped
+                  );
+               }
+               for (t = 0; ok && t < STRIPED_THREADS_04_02; t++)
+               {
+                  if (is_nullptr(pthreader_join(threads[t])))
+                     ok = false;
+               }
+               for (t = 0; ok && t < STRIPED_COUNTERS_04_02; t++)
+               {
+                  ok = s_striped.counters[t] ==
+                     STRIPED_THREADS_04_02 * STRIPED_LOOPS_04_02;
+               }
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  5 */
+
+         if (unit_test_status_next_subtest(&status, "Destroy"))
+         {
+            if (ok)
+               ok = xpc_syncher_stripes_destroy(xs);
+
+            if (ok)
+               ok = is_nullptr(xs->m_Memory);
+
+            unit_test_status_pass(&status, ok);
+         }
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * syncher_thread_test_04_03()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides basic unit-tests of the lock-order detector.  Two synchers
+ *    are entered in one order, then in the other.  The second order must
+ *    be reported, even though no second thread is there to deadlock.
+ *
+ *    The detector exists only when the library is built with
+ *    DEBUG_MUTEX_LOCKS defined; otherwise, only the normal operation of
+ *    the synchers is checked.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \tests
+ *    -  xpc_syncher_lockorder_set()
+ *    -  xpc_syncher_lockorder_violations()
+ *    -  xpc_syncher_enter()
+ *    -  xpc_syncher_leave()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+syncher_thread_test_04_03 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 4, 3, _("syncher"), _("Lock-Order Detector")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         xpc_syncher_t first;
+         xpc_syncher_t second;
+         cbool_t detector = xpc_syncher_lockorder_set(true);
+         unsigned long violations = xpc_syncher_lockorder_violations();
+         if (unit_test_options_show_values(options))
+         {
+            fprintf
+            (
+               stdout, "  %s: %s\n", _("Lock-order detector"),
+               detector ? _("built in") : _("not built in")
+            );
+         }
+         ok = xpc_syncher_create(&first, false) &&
+            xpc_syncher_create(&second, false);
+
+         /*  1 */
+
+         if (unit_test_status_next_subtest(&status, "Consistent order"))
+         {
+            int pass;
+            for (pass = 0; ok && pass < 2; pass++)
+            {
+               ok = xpc_syncher_enter(&first) && xpc_syncher_enter(&second);
+               if (ok)
+                  ok = xpc_syncher_leave(&second) && xpc_syncher_leave(&first);
+            }
+            if (ok)
+               ok = xpc_syncher_lockorder_violations() == violations;
+
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  2 */
+
+         if (unit_test_status_next_subtest(&status, "Inverted order"))
+         {
+            if (ok)
+            {
+               ok = xpc_syncher_enter(&second) && xpc_syncher_enter(&first);
+               if (ok)
+                  ok = xpc_syncher_leave(&first) && xpc_syncher_leave(&second);
+            }
+            if (ok && detector)
+               ok = xpc_syncher_lockorder_violations() == violations + 1;
+
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  3 */
+
+         if (unit_test_status_next_subtest(&status, "Owner cleared"))
+         {
+            if (ok)
+               ok = first.m_Owner == 0 && second.m_Owner == 0;
+
+            unit_test_status_pass(&status, ok);
+         }
+         (void) xpc_syncher_destroy(&first);
+         (void) xpc_syncher_destroy(&second);
+         (void) xpc_syncher_lockorder_set(false);
+      }
+   }
+   return status;
+}
+
+/******************************************************************************
+ * simple_syncher_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides some parameters to control the simple_syncher_thread_function().
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   int thread_identifier;     /**< An ordinal number to identify the thread.  */
+   int loop_count;            /**< Number of times the main loop runs.        */
+   int loop_sleep;            /**< Time the thread is suspended each pass.    */
+   char emitted_character;    /**< The character to emit as thread runs.      */
+   xpc_syncher_t * critex;    /**< To synchronize output with other thread.   */
+
+} simple_syncher_t;
+
+/******************************************************************************
+ * simple_syncher_thread_function()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides a thread function to test the functionality of the
+ *    xpc_syncher_t object.
+ *
+ * \note
+ *    -  The xpc_ms_sleep() function does not sleep if 0 is passed as a
+ *       parameter.
+ *    -  The critex pointer is not checked, to save time.
+ *
+ * \return
+ *    Returns ...
+ *
+ *//*-------------------------------------------------------------------------*/
+
+void *
+simple_syncher_thread_function
+(
+   void * thread_syncher   /**< Structure controlling action of the thread.   */
+)
+{
+   void * result = nullptr;
+   if (not_nullptr(thread_syncher))
+   {
+      int tid;
+      int index;
+      simple_syncher_t * stp = (simple_syncher_t *) thread_syncher;
+      simple_syncher_t ctrller = *stp;
+      tid = ctrller.thread_identifier;
+      xpc_infoprintf("Syncher thread #%d.\n", tid);
+
+      for (index = 0; index < ctrller.loop_count; index++)
+      {
+         cbool_t ok = xpc_syncher_enter(ctrller.critex);
+         if (ok)
+         {
+            if (! xpccut_is_silent())
+               putc(ctrller.emitted_character, stdout);
+
+            (void) xpc_syncher_leave(ctrller.critex);
+         }
+         xpc_ms_sleep(ctrller.loop_sleep);
+      }
+      result = thread_syncher;
+   }
+   else
+   {
+      if (! xpccut_is_silent())
+         xpc_errprint_func(_("null pointer"));
+   }
+   return result;                   /* alternative:  pthread_exit(result);    */
+}
+
+/******************************************************************************
+ * LOOP_SLEEP_05_01
+ *------------------------------------------------------------------------*//**
+ *
+ *    LOOP_SLEEP_05_01 provides a way to probe the effects of delays in the
+ *    thread processing.
+ *
+ * \posix
+ *    On our dual-core x86 laptop, running Linux, setting this loop-sleep
+ *    define to anything greater than 0 causes the expected output:
+ *
+ *       12121212121212121212
+ *
+ *    However, setting it to 0 yields:
+ *
+ *       11111111112222222222
+ *
+ *    It looks like the first thread finishes before the second one gets to
+ *    start.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifdef POSIX
+#define LOOP_SLEEP_05_01      1
+#else
+#define LOOP_SLEEP_05_01      1
+#endif
+
+/******************************************************************************
+ * POST_SLEEP_05_01
+ *------------------------------------------------------------------------*//**
+ *
+ *    POST_SLEEP_05_01 provides another way to probe the effects of delays
+ *    in the thread processing.
+ *
+ *    Instead of coming inside the thread-function's loop, this delay occurs
+ *    after the creation of the first thread.
+ *
+ *    If LOOP_SLEEP_05_01 is 1, and POST_SLEEP_05_01 > 0, then the output
+ *    has extra 1's at the beginning.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#ifdef POSIX
+#define POST_SLEEP_05_01      0  /* or 1 or 5 */
+#else
+#define POST_SLEEP_05_01      0
+#endif
+
+/******************************************************************************
+ * syncher_thread_test_05_01()
+ *------------------------------------------------------------------------*//**
+ *
+ *    This test group provides threaded smoke-test unit-tests of the
+ *    pthreader.c module.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \tests
+ *    This unit-test function perforce tests more than one unit from the
+ *    unit-test library (libxpccut):
+ *
+ *    -  pthreader_xxx()
+ *    -  pthread_attributes_xxx()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+syncher_thread_test_05_01 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 5, 1, _("syncher"), _("Smoke Test")
+   );
+   if (ok)
+   {
+      /*
+       * \steps
+       *    -# Provide the "XPC default" thread attributes.
+       *    -# Create a non-recursive (in POSIX, anyway) syncher object,
+       *       called a "critex" (our own term for it).
+       *    -# Create two data structures that share the same "critex".
+       *    -# Wire the critex into the data structure for the first thread.
+       *    -# Wire the critex into the data structure for the second thread.
+       */
 
       pthread_attr_t x_attributes;                    /* Step 1   */
       xpc_syncher_t dual_thread_critex;               /* Step 2   */
@@ -894,6 +1851,247 @@ syncher_thread_test_05_01 (const unit_test_options_t * options)
    return status;
 }
 
+/******************************************************************************
+ * bench_syncher_t
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the state shared by the threads of the syncher benchmark.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+typedef struct
+{
+   xpc_syncher_t critex;      /**< The syncher-object being measured.         */
+   long counter;              /**< Incremented under the lock.                */
+   int loop_count;            /**< Number of enters done by each thread.      */
+
+} bench_syncher_t;
+
+/******************************************************************************
+ * BENCH_THREADS_05_02
+ *------------------------------------------------------------------------*//**
+ *
+ *    Provides the number of threads and the number of enters per thread
+ *    for the syncher benchmark.  The critical section is a single
+ *    increment, the case the adaptive syncher is meant for.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+#define BENCH_THREADS_05_02   4
+#define BENCH_LOOPS_05_02     200000
+
+/******************************************************************************
+ * bench_syncher_thread_function()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Enters and leaves the shared syncher-object repeatedly, incrementing
+ *    the shared counter each time.
+ *
+ * \return
+ *    Returns the parameter if every enter succeeded, and null otherwise.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static void *
+bench_syncher_thread_function
+(
+   void * bench_syncher    /**< The shared bench_syncher_t structure.         */
+)
+{
+   void * result = bench_syncher;
+   bench_syncher_t * bsp = (bench_syncher_t *) bench_syncher;
+   int index;
+   for (index = 0; index < bsp->loop_count; index++)
+   {
+      if (xpc_syncher_enter(&bsp->critex))
+      {
+         ++bsp->counter;
+         (void) xpc_syncher_leave(&bsp->critex);
+      }
+      else
+      {
+         result = nullptr;
+         break;
+      }
+   }
+   return result;
+}
+
+/******************************************************************************
+ * bench_syncher_run()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Runs the benchmark threads on an already-created syncher-object, and
+ *    checks the count and the contention statistics.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line,
+ *    to decide if the timing is shown.
+ *
+ * \param bsp
+ *    The shared benchmark state, with the syncher-object created.
+ *
+ * \param name
+ *    The name of the kind of syncher-object, for the output.
+ *
+ * \return
+ *    Returns 'true' if all threads ran, the counter is right, and the
+ *    statistics are consistent.
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static cbool_t
+bench_syncher_run
+(
+   const unit_test_options_t * options,
+   bench_syncher_t * bsp,
+   const char * name
+)
+{
+   cbool_t result;
+   pthread_attr_t x_attributes;
+   pthread_t threads[BENCH_THREADS_05_02];
+   long expected = (long) BENCH_THREADS_05_02 * BENCH_LOOPS_05_02;
+   double seconds;
+   int t;
+   bsp->counter = 0;
+   bsp->loop_count = BENCH_LOOPS_05_02;
+   result = pthread_attributes_init(&x_attributes);
+   xpc_stopwatch_start();
+   for (t = 0; t < BENCH_THREADS_05_02; t++)
+   {
+      threads[t] = pthreader_create
+      (
+         &x_attributes, bench_syncher_thread_function, (void *) bsp
+      );
+   }
+   for (t = 0; t < BENCH_THREADS_05_02; t++)
+   {
+      if (is_nullptr(pthreader_join(threads[t])))
+         result = false;
+   }
+   seconds = xpc_stopwatch_duration();
+   if (result)
+   {
+      const xpc_syncher_t * xs = &bsp->critex;
+      result = bsp->counter == expected &&
+         xs->m_Acquisitions == (uint64_t) expected &&
+         xs->m_Contended <= xs->m_Acquisitions &&
+         xs->m_Parked <= xs->m_Contended;
+   }
+   if (unit_test_options_show_values(options))
+   {
+      const xpc_syncher_t * xs = &bsp->critex;
+      fprintf
+      (
+         stdout,
+         "  %-9s %7.1f ns/enter, %lu contended, %lu parked, %lu ns waiting\n",
+         name, seconds * 1.0e9 / expected,
+         (unsigned long) xs->m_Contended, (unsigned long) xs->m_Parked,
+         (unsigned long) xs->m_Wait_Nanoseconds
+      );
+   }
+   return result;
+}
+
+/******************************************************************************
+ * syncher_thread_test_05_02()
+ *------------------------------------------------------------------------*//**
+ *
+ *    Benchmarks the normal and adaptive syncher-objects against each other,
+ *    with a few threads contending for a very short critical section, and
+ *    checks the contention statistics.  Use --show-values to see the
+ *    timings.
+ *
+ * \param options
+ *    Provides the options given to the application on the command-line.
+ *
+ * \tests
+ *    -  xpc_syncher_create()
+ *    -  xpc_syncher_create_adaptive()
+ *    -  xpc_syncher_enter()
+ *    -  xpc_syncher_tryenter()
+ *    -  xpc_syncher_leave()
+ *
+ *//*-------------------------------------------------------------------------*/
+
+static unit_test_status_t
+syncher_thread_test_05_02 (const unit_test_options_t * options)
+{
+   unit_test_status_t status;
+   cbool_t ok = unit_test_status_initialize
+   (
+      &status, options, 5, 2, _("syncher"), _("Adaptive Syncher Benchmark")
+   );
+   if (ok)
+   {
+      if (! unit_test_status_can_proceed(&status)) /* is test allowed to run? */
+      {
+         unit_test_status_pass(&status, true);     /* no, force it to pass    */
+      }
+      else
+      {
+         static bench_syncher_t s_bench;
+
+         /*  1 */
+
+         if (unit_test_status_next_subtest(&status, "Uncontended statistics"))
+         {
+            xpc_syncher_t * xs = &s_bench.critex;
+            ok = xpc_syncher_create_adaptive(xs, 0);
+            if (ok)
+               ok = xpc_syncher_enter(xs) && xpc_syncher_leave(xs);
+
+            if (ok)
+               ok = xpc_syncher_tryenter(xs) && xpc_syncher_leave(xs);
+
+            if (ok)
+            {
+               ok = xs->m_Acquisitions == 2 && xs->m_Contended == 0 &&
+                  xs->m_Parked == 0 && xs->m_Wait_Nanoseconds == 0;
+            }
+            if (xpc_syncher_destroy(xs) == false)
+               ok = false;
+
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  2 */
+
+         if (unit_test_status_next_subtest(&status, "Normal syncher"))
+         {
+            if (ok)
+               ok = xpc_syncher_create(&s_bench.critex, false);
+
+            if (ok)
+            {
+               ok = bench_syncher_run(options, &s_bench, "normal");
+               if (xpc_syncher_destroy(&s_bench.critex) == false)
+                  ok = false;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+
+         /*  3 */
+
+         if (unit_test_status_next_subtest(&status, "Adaptive syncher"))
+         {
+            if (ok)
+               ok = xpc_syncher_create_adaptive(&s_bench.critex, 0);
+
+            if (ok)
+            {
+               ok = bench_syncher_run(options, &s_bench, "adaptive");
+               if (xpc_syncher_destroy(&s_bench.critex) == false)
+                  ok = false;
+            }
+            unit_test_status_pass(&status, ok);
+         }
+      }
+   }
+   return status;
+}
+
 /******************************************************************************
  * Macro
  *------------------------------------------------------------------------*//**
@@ -1027,14 +2225,23 @@ XPC_TEST_NAME "-specific options:\n"
             if (ok)
             {
                (void) unit_test_load(&testbattery, syncher_thread_test_02_01);
+               (void) unit_test_load(&testbattery, syncher_thread_test_02_02);
             }
             if (ok)
             {
                (void) unit_test_load(&testbattery, syncher_thread_test_03_01);
+               (void) unit_test_load(&testbattery, syncher_thread_test_03_02);
+            }
+            if (ok)
+            {
+               (void) unit_test_load(&testbattery, syncher_thread_test_04_01);
+               (void) unit_test_load(&testbattery, syncher_thread_test_04_02);
+               (void) unit_test_load(&testbattery, syncher_thread_test_04_03);
             }
             if (ok)
             {
                (void) unit_test_load(&testbattery, syncher_thread_test_05_01);
+               (void) unit_test_load(&testbattery, syncher_thread_test_05_02);
             }
             if (ok)
             {